@@ -0,0 +1,278 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+/*
+ * This example measures the latency of world model updates between two
+ * processes on the same host. A setTransform update is serialized once and
+ * sent back and forth (ping-pong) between a parent and a forked child process:
+ *
+ *  +----------+   ping   +----------+
+ *  |  parent  |  ----->  |  child   |
+ *  |          |  <-----  |  (echo)  |
+ *  +----------+   pong   +----------+
+ *
+ * The same is done with the shared memory transport (SharedMemoryOutputPort and
+ * SharedMemoryInputBridge) and with UDP sockets on the loopback interface.
+ * The reported one way latency is half of the round trip time.
+ *
+ * Usage: wm_shared_memory_benchmark [iterations]
+ */
+
+/* BRICS_3D includes */
+#include <brics_3d/core/Logger.h>
+#include <brics_3d/core/HomogeneousMatrix44.h>
+#include <brics_3d/worldModel/WorldModel.h>
+#include <brics_3d/worldModel/sceneGraph/BinaryUpdateSerializer.h>
+#include <brics_3d/worldModel/sceneGraph/SharedMemoryOutputPort.h>
+#include <brics_3d/worldModel/sceneGraph/SharedMemoryInputBridge.h>
+
+/* UDP and process includes*/
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+using namespace brics_3d;
+using namespace brics_3d::rsg;
+using std::cout;
+using std::endl;
+
+const char* pingName = "/brics_3d_benchmark_ping";
+const char* pongName = "/brics_3d_benchmark_pong";
+const unsigned short pingUdpPort = 11511;
+const unsigned short pongUdpPort = 11512;
+const char stopMessage = 's';
+
+inline double nowInMicroSeconds() {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return time.tv_sec * 1e6 + time.tv_nsec * 1e-3;
+}
+
+/// Keeps the last serialized update.
+class MessageRecorder : public IOutputPort {
+public:
+	int write(const char *dataBuffer, int dataLength, int &transferredBytes) {
+		message.assign(dataBuffer, dataBuffer + dataLength);
+		transferredBytes = dataLength;
+		return 1;
+	}
+	std::vector<char> message;
+};
+
+/// Sends every received message back, until the stop message arrives.
+class EchoPort : public IInputPort {
+public:
+	EchoPort(IOutputPort* outputPort) : outputPort(outputPort), stopped(false) {};
+	int write(const char *dataBuffer, int dataLength, int &transferredBytes) {
+		if (dataLength == 1 && dataBuffer[0] == stopMessage) {
+			stopped = true;
+			return 1;
+		}
+		return outputPort->write(dataBuffer, dataLength, transferredBytes);
+	}
+	IOutputPort* outputPort;
+	bool stopped;
+};
+
+/// Counts received messages.
+class CountingPort : public IInputPort {
+public:
+	CountingPort() : count(0) {};
+	int write(const char *dataBuffer, int dataLength, int &transferredBytes) {
+		transferredBytes = dataLength;
+		count++;
+		return 1;
+	}
+	unsigned long count;
+};
+
+void printStatistics(std::string transport, std::vector<double>& roundTripTimes) {
+	if (roundTripTimes.empty()) {
+		cout << transport << ": no results" << endl;
+		return;
+	}
+	std::sort(roundTripTimes.begin(), roundTripTimes.end());
+	double sum = 0;
+	for (size_t i = 0; i < roundTripTimes.size(); ++i) {
+		sum += roundTripTimes[i];
+	}
+	cout << transport << " one way latency [us]:"
+			<< " min = " << roundTripTimes.front() / 2.0
+			<< ", median = " << roundTripTimes[roundTripTimes.size() / 2] / 2.0
+			<< ", mean = " << sum / roundTripTimes.size() / 2.0
+			<< ", 99% = " << roundTripTimes[roundTripTimes.size() * 99 / 100] / 2.0
+			<< ", max = " << roundTripTimes.back() / 2.0 << endl;
+}
+
+std::vector<double> benchmarkSharedMemory(const std::vector<char>& message, unsigned int iterations) {
+	std::vector<double> roundTripTimes;
+	SharedMemoryOutputPort* pingPort = new SharedMemoryOutputPort(pingName);
+
+	pid_t child = fork();
+	if (child == 0) {
+		{
+			SharedMemoryOutputPort pongPort(pongName);
+			EchoPort echo(&pongPort);
+			SharedMemoryInputBridge pingBridge(&echo, pingName);
+			while (!echo.stopped) {
+				pingBridge.waitForMessages(1000000);
+			}
+		} // removes the segment
+		exit(0);
+	}
+
+	CountingPort pongCounter;
+	SharedMemoryInputBridge pongBridge(&pongCounter, pongName);
+	int transferredBytes;
+
+	/* Wait until the child is connected */
+	while (pongCounter.count == 0) {
+		pingPort->write(&message[0], static_cast<int>(message.size()), transferredBytes);
+		pongBridge.waitForMessages(1000);
+	}
+	pongBridge.waitForMessages(10000);
+
+	for (unsigned int i = 0; i < iterations; ++i) {
+		double start = nowInMicroSeconds();
+		pingPort->write(&message[0], static_cast<int>(message.size()), transferredBytes);
+		if (pongBridge.waitForMessages(1000000, 1) == 0) {
+			LOG(ERROR) << "Shared memory: Pong timed out.";
+			break;
+		}
+		roundTripTimes.push_back(nowInMicroSeconds() - start);
+	}
+
+	pingPort->write(&stopMessage, 1, transferredBytes);
+	waitpid(child, 0, 0);
+	delete pingPort;
+	return roundTripTimes;
+}
+
+int openUdpSocket(unsigned short port) {
+	int udpSocket = socket(AF_INET, SOCK_DGRAM, 0);
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = inet_addr("127.0.0.1");
+	if (udpSocket < 0 || bind(udpSocket, (struct sockaddr*)&address, sizeof(address)) < 0) {
+		LOG(ERROR) << "UDP: Cannot bind to port " << port;
+		return -1;
+	}
+	struct timeval timeout;
+	timeout.tv_sec = 1;
+	timeout.tv_usec = 0;
+	setsockopt(udpSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	return udpSocket;
+}
+
+void sendUdp(int udpSocket, unsigned short port, const char* data, size_t length) {
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = inet_addr("127.0.0.1");
+	sendto(udpSocket, data, length, 0, (struct sockaddr*)&address, sizeof(address));
+}
+
+std::vector<double> benchmarkUdp(const std::vector<char>& message, unsigned int iterations) {
+	std::vector<double> roundTripTimes;
+	std::vector<char> receiveBuffer(64*1024);
+	int pongSocket = openUdpSocket(pongUdpPort);
+	if (pongSocket < 0) {
+		return roundTripTimes;
+	}
+
+	pid_t child = fork();
+	if (child == 0) {
+		int pingSocket = openUdpSocket(pingUdpPort);
+		while (pingSocket >= 0) {
+			ssize_t length = recv(pingSocket, &receiveBuffer[0], receiveBuffer.size(), 0);
+			if (length == 1 && receiveBuffer[0] == stopMessage) {
+				break;
+			}
+			if (length > 0) {
+				sendUdp(pingSocket, pongUdpPort, &receiveBuffer[0], length);
+			}
+		}
+		exit(0);
+	}
+
+	/* Wait until the child is connected */
+	while (true) {
+		sendUdp(pongSocket, pingUdpPort, &message[0], message.size());
+		if (recv(pongSocket, &receiveBuffer[0], receiveBuffer.size(), 0) > 0) {
+			break;
+		}
+	}
+
+	for (unsigned int i = 0; i < iterations; ++i) {
+		double start = nowInMicroSeconds();
+		sendUdp(pongSocket, pingUdpPort, &message[0], message.size());
+		if (recv(pongSocket, &receiveBuffer[0], receiveBuffer.size(), 0) <= 0) {
+			LOG(ERROR) << "UDP: Pong timed out.";
+			break;
+		}
+		roundTripTimes.push_back(nowInMicroSeconds() - start);
+	}
+
+	sendUdp(pongSocket, pingUdpPort, &stopMessage, 1);
+	waitpid(child, 0, 0);
+	close(pongSocket);
+	return roundTripTimes;
+}
+
+int main(int argc, char **argv) {
+	unsigned int iterations = 100000;
+	if (argc > 1) {
+		iterations = atoi(argv[1]);
+	}
+
+	/* A typical update message */
+	WorldModel* wm = new WorldModel();
+	MessageRecorder recorder;
+	BinaryUpdateSerializer serializer(&recorder);
+	wm->scene.attachUpdateObserver(&serializer);
+	std::vector<Attribute> attributes;
+	Id tfId;
+	HomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 1,2,3));
+	wm->scene.addTransformNode(wm->getRootNodeId(), tfId, attributes, transform, wm->now());
+	wm->scene.setTransform(tfId, transform, wm->now());
+	Logger::setMinLoglevel(Logger::WARNING);
+	cout << "Message size: " << recorder.message.size() << " bytes, iterations: " << iterations << endl;
+
+	std::vector<double> sharedMemoryResults = benchmarkSharedMemory(recorder.message, iterations);
+	printStatistics("Shared memory", sharedMemoryResults);
+	std::vector<double> udpResults = benchmarkUdp(recorder.message, iterations);
+	printStatistics("UDP loopback ", udpResults);
+
+	delete wm;
+	return 0;
+}
+
+/* EOF */
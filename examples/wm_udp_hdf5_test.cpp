@@ -47,6 +47,8 @@
 
 #include <brics_3d/util/HDF5Typecaster.h>
 #include <brics_3d/worldModel/sceneGraph/RemoteRootNodeAutoMounter.h>
+#include <brics_3d/worldModel/sceneGraph/FragmentingOutputPort.h>
+#include <brics_3d/worldModel/sceneGraph/ReassemblingInputPort.h>
 #include <hdf5.h>
 
 /* UDP includes*/
@@ -159,8 +161,8 @@ private:
  */
 class HSDF5UDPInputBridge {
 public:
-	HSDF5UDPInputBridge(brics_3d::rsg::IInputPort* inputPort, std::string host, int port) :
-		inputPort(inputPort), host(host), port(port), debugTag("HSDF5UDPInputBridge") {
+	HSDF5UDPInputBridge(brics_3d::rsg::IInputPort* inputPort, std::string host, int port, unsigned int maxDatagramSize) :
+		inputPort(inputPort), host(host), port(port), maxDatagramSize(maxDatagramSize), debugTag("HSDF5UDPInputBridge") {
 
 		LOG(DEBUG) << debugTag << " created.";
 		initialize();
@@ -195,9 +197,7 @@ public:
 	}
 
 	void* recieverThread() {
-	    const unsigned int BUFLEN = 20000; // For HDF5 messages longer than this we need some other transport mechanism.
-	    									 // In this demo all upatates are around 10k. Thus, this buffer is sufficient.
-	    char buf[BUFLEN];
+	    std::vector<char> buf(maxDatagramSize); // the FragmentingOutputPort of the sender splits larger messages
 	    socklen_t slen=sizeof(clientAddress);
 	    ssize_t readBytes;
 	    int deseraializetBytes;
@@ -205,7 +205,7 @@ public:
 	    /* Receiver loop */
 	    while(true) {
 
-	    	readBytes = recvfrom(socketDescriptor, buf, BUFLEN, 0, (struct sockaddr*)&clientAddress, &slen);
+	    	readBytes = recvfrom(socketDescriptor, &buf[0], buf.size(), 0, (struct sockaddr*)&clientAddress, &slen);
 
 	    	if (readBytes < 0) {
 	    		LOG(ERROR) << "recvfrom()";
@@ -216,7 +216,7 @@ public:
 	    			<< inet_ntoa(clientAddress.sin_addr) << "::"
 	    			<< ntohs(clientAddress.sin_port);
 
-	    	inputPort->write(buf, readBytes, deseraializetBytes); // feed forward to the HDF5 deserialization
+	    	inputPort->write(&buf[0], readBytes, deseraializetBytes); // feed forward to the HDF5 deserialization
 	    }
 
 	    /* Clean up */
@@ -244,6 +244,9 @@ private:
 	/// Port that belongst to host
 	int port;
 
+	/// Size of the receive buffer. Has to match the datagram size of the sender.
+	unsigned int maxDatagramSize;
+
 	/// Tag that will appear in the log output
 	std::string debugTag;
 
@@ -302,14 +305,17 @@ int main(int argc, char **argv) {
 	 *
 	 * NOTE: 224.0.0.1 is a multicast address so we don't have to bother who is server and who is client.
 	 */
+	const unsigned int udpDatagramSize = 8192;
 	HSDF5UDPOutputBridge* udpOutBridge = new HSDF5UDPOutputBridge(hostIP, 11411);
-	brics_3d::rsg::HDF5UpdateSerializer* wmUpdatesToHdf5Serializer = new brics_3d::rsg::HDF5UpdateSerializer(udpOutBridge);
+	brics_3d::rsg::FragmentingOutputPort* fragmenter = new brics_3d::rsg::FragmentingOutputPort(udpOutBridge, udpDatagramSize); // large updates like point clouds need multiple datagrams
+	brics_3d::rsg::HDF5UpdateSerializer* wmUpdatesToHdf5Serializer = new brics_3d::rsg::HDF5UpdateSerializer(fragmenter);
 	wm->scene.attachUpdateObserver(wmUpdatesToHdf5Serializer);
 	wmUpdatesToHdf5Serializer->setStoreMessageBackupsOnFileSystem(true); /* set to true to store all updates as .h5 files */
 
 	/* Setup of IN bridge (via UDP) */
 	brics_3d::rsg::HDF5UpdateDeserializer* wmUpdatesToHdf5deserializer = new brics_3d::rsg::HDF5UpdateDeserializer(wm);
-	HSDF5UDPInputBridge* udpInBridge = new HSDF5UDPInputBridge(wmUpdatesToHdf5deserializer, "224.0.0.1", 11411);
+	brics_3d::rsg::ReassemblingInputPort* reassembler = new brics_3d::rsg::ReassemblingInputPort(wmUpdatesToHdf5deserializer);
+	HSDF5UDPInputBridge* udpInBridge = new HSDF5UDPInputBridge(reassembler, "224.0.0.1", 11411, udpDatagramSize);
 
 	/* Setup auto mount policy for incoming data */
 	brics_3d::rsg::RemoteRootNodeAutoMounter autoMounter(&wm->scene, wm->getRootNodeId()); //mount everything relative to root node
@@ -368,8 +374,10 @@ int main(int argc, char **argv) {
 #endif
 	delete wmUpdatesToHdf5Serializer;
 	delete wmUpdatesToHdf5deserializer;
+	delete fragmenter;
 	delete udpOutBridge;
 	delete udpInBridge;
+	delete reassembler;
 	delete wmStructureVisualizer;
 	delete wm;
 }
@@ -45,6 +45,8 @@
 	#include <brics_3d/worldModel/sceneGraph/OSGVisualizer.h>
 #endif
 #include <brics_3d/worldModel/sceneGraph/RemoteRootNodeAutoMounter.h>
+#include <brics_3d/worldModel/sceneGraph/FragmentingOutputPort.h>
+#include <brics_3d/worldModel/sceneGraph/ReassemblingInputPort.h>
 
 /* UDP includes*/
 #include <sys/types.h>
@@ -156,8 +158,8 @@ private:
  */
 class JSONUDPInputBridge {
 public:
-	JSONUDPInputBridge(brics_3d::rsg::IInputPort* inputPort, std::string host, int port) :
-		inputPort(inputPort), host(host), port(port), debugTag("JSONUDPInputBridge") {
+	JSONUDPInputBridge(brics_3d::rsg::IInputPort* inputPort, std::string host, int port, unsigned int maxDatagramSize) :
+		inputPort(inputPort), host(host), port(port), maxDatagramSize(maxDatagramSize), debugTag("JSONUDPInputBridge") {
 
 		LOG(DEBUG) << debugTag << " created.";
 		initialize();
@@ -192,9 +194,7 @@ public:
 	}
 
 	void* recieverThread() {
-	    const unsigned int BUFLEN = 20000; // For HDF5 messages longer than this we need some other transport mechanism.
-	    									 // In this demo all upatates are around 10k. Thus, this buffer is sufficient.
-	    char buf[BUFLEN];
+	    std::vector<char> buf(maxDatagramSize); // the FragmentingOutputPort of the sender splits larger messages
 	    socklen_t slen=sizeof(clientAddress);
 	    ssize_t readBytes;
 	    int deseraializetBytes;
@@ -202,7 +202,7 @@ public:
 	    /* Receiver loop */
 	    while(true) {
 
-	    	readBytes = recvfrom(socketDescriptor, buf, BUFLEN, 0, (struct sockaddr*)&clientAddress, &slen);
+	    	readBytes = recvfrom(socketDescriptor, &buf[0], buf.size(), 0, (struct sockaddr*)&clientAddress, &slen);
 
 	    	if (readBytes < 0) {
 	    		LOG(ERROR) << "recvfrom()";
@@ -213,7 +213,7 @@ public:
 	    			<< inet_ntoa(clientAddress.sin_addr) << "::"
 	    			<< ntohs(clientAddress.sin_port);
 
-	    	inputPort->write(buf, readBytes, deseraializetBytes); // feed forward to the HDF5 deserialization
+	    	inputPort->write(&buf[0], readBytes, deseraializetBytes); // feed forward to the reassembly and JSON deserialization
 	    }
 
 	    /* Clean up */
@@ -241,6 +241,9 @@ private:
 	/// Port that belongst to host
 	int port;
 
+	/// Size of the receive buffer. Has to match the datagram size of the sender.
+	unsigned int maxDatagramSize;
+
 	/// Tag that will appear in the log output
 	std::string debugTag;
 
@@ -299,14 +302,17 @@ int main(int argc, char **argv) {
 	 *
 	 * NOTE: 224.0.0.1 is a multicast address so we don't have to bother who is server and who is client.
 	 */
+	const unsigned int udpDatagramSize = 8192;
 	JOSNUDPOutputBridge* udpOutBridge = new JOSNUDPOutputBridge(hostIP, 11411);
-	brics_3d::rsg::JSONSerializer* wmUpdatesToJSON5Serializer = new brics_3d::rsg::JSONSerializer(wm, udpOutBridge);
+	brics_3d::rsg::FragmentingOutputPort* fragmenter = new brics_3d::rsg::FragmentingOutputPort(udpOutBridge, udpDatagramSize); // large updates like point clouds need multiple datagrams
+	brics_3d::rsg::JSONSerializer* wmUpdatesToJSON5Serializer = new brics_3d::rsg::JSONSerializer(wm, fragmenter);
 	wm->scene.attachUpdateObserver(wmUpdatesToJSON5Serializer);
 	wmUpdatesToJSON5Serializer->setStoreMessageBackupsOnFileSystem(true); /* set to true to store all updates as .h5 files */
 
 	/* Setup of IN bridge (via UDP) */
 	brics_3d::rsg::JSONDeserializer* wmUpdatesToJSONdeserializer = new brics_3d::rsg::JSONDeserializer(wm);
-	JSONUDPInputBridge* udpInBridge = new JSONUDPInputBridge(wmUpdatesToJSONdeserializer, "224.0.0.1", 11411);
+	brics_3d::rsg::ReassemblingInputPort* reassembler = new brics_3d::rsg::ReassemblingInputPort(wmUpdatesToJSONdeserializer);
+	JSONUDPInputBridge* udpInBridge = new JSONUDPInputBridge(reassembler, "224.0.0.1", 11411, udpDatagramSize);
 
 	/* Setup auto mount policy for incoming data */
 	brics_3d::rsg::Id applicationRootId;
@@ -385,8 +391,10 @@ int main(int argc, char **argv) {
 #endif
 	delete wmUpdatesToJSON5Serializer;
 	delete wmUpdatesToJSONdeserializer;
+	delete fragmenter;
 	delete udpOutBridge;
 	delete udpInBridge;
+	delete reassembler;
 	delete wmStructureVisualizer;
 	delete wm;
 }
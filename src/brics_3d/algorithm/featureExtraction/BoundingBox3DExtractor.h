@@ -20,7 +20,6 @@
 #ifndef BRICS_3D_BOUNDINGBOX3DEXTRACTOR_H_
 #define BRICS_3D_BOUNDINGBOX3DEXTRACTOR_H_
 
-#include "brics_3d/algorithm/featureExtraction/PCA.h"
 #include "brics_3d/core/PointCloud3D.h"
 #include "brics_3d/core/Vector3D.h"
 #include "brics_3d/core/IHomogeneousMatrix44.h"
@@ -51,6 +50,7 @@ public:
 	 * @param[in] inputPointCloud The point cloud whose bounding box shall be computed.
 	 * @param[out] resultBoxCenter Point that represents the center of the bounding box.
 	 * @param[out] resultBoxDimensions 3D vector the represents the dimensions centered around the resultBoxCenter.
+	 * For a point cloud without valid points both are set to zero.
 	 */
 	void computeBoundingBox(PointCloud3D* inputPointCloud, Point3D& resultBoxCenter, Vector3D& resultBoxDimensions);
 
@@ -75,9 +75,6 @@ protected:
 	///Upper bundariy used to find max values for x, y and z.
 	Point3D upperBound;
 
-	///PCA used for computing an oriented bounding box.
-	PCA pcaExtractor;
-
 };
 
 }
@@ -80,17 +80,21 @@ Eigen::Vector3d Centroid3D::computeCentroid(IPoint3DIterator::IPoint3DIteratorPt
 	centroid[1] = 0;
 	centroid[2] = 0;
 
-	for (inCloud->begin(); !inCloud->end(); inCloud->next()) {
-		tempX = inCloud->getX();
-		tempY = inCloud->getY();
-		tempZ = inCloud->getZ();
-
-		if(!std::isnan(tempX) && !std::isinf(tempX) && !std::isnan(tempY) && !std::isinf(tempY) &&
-				!std::isnan(tempZ) && !std::isinf(tempZ) ) {
-			centroid[0] = centroid[0] + tempX;
-			centroid[1] = centroid[1] + tempY;
-			centroid[2] = centroid[2] + tempZ;
-			count++;
+	Coordinate block[3 * IPoint3DIterator::defaultBlockSize];
+	unsigned int blockSize;
+	for (inCloud->begin(); (blockSize = inCloud->nextBlock(block, IPoint3DIterator::defaultBlockSize)) > 0; ) {
+		for (unsigned int i = 0; i < blockSize; ++i) {
+			tempX = block[3*i];
+			tempY = block[3*i + 1];
+			tempZ = block[3*i + 2];
+
+			if(!std::isnan(tempX) && !std::isinf(tempX) && !std::isnan(tempY) && !std::isinf(tempY) &&
+					!std::isnan(tempZ) && !std::isinf(tempZ) ) {
+				centroid[0] = centroid[0] + tempX;
+				centroid[1] = centroid[1] + tempY;
+				centroid[2] = centroid[2] + tempZ;
+				count++;
+			}
 		}
 	}
 
@@ -18,7 +18,7 @@
  ******************************************************************************/
 
 #include "DensityExtractor.h"
-#include "BoundingBox3DExtractor.h"
+#include "PointCloudStatistics.h"
 #include "brics_3d/core/HomogeneousMatrix44.h"
 #include "brics_3d/core/Logger.h"
 
@@ -54,16 +54,14 @@ Density DensityExtractor::computeDensity(IPoint3DIterator::IPoint3DIteratorPtr i
 		result.volume = 0.0;
 		result.density = 0.0;
 
-		/* Number of points */
-		for (inputPointCloud->begin(); !inputPointCloud->end(); inputPointCloud->next()) {
-			result.numberOfPoints++;
-		}
+		/* Number of points and volume. The statistics pass yields the number of points as well as the PCA for the bounding box. */
+		PointCloudStatistics statistics;
+		statistics.addPoints(inputPointCloud);
+		result.numberOfPoints = statistics.getNumberOfPoints() + statistics.getNumberOfSkippedPoints();
 
-		/* Volume */
-		BoundingBox3DExtractor boundingBoxEstimator;
-		HomogeneousMatrix44 dummyPose; // = new HomogeneousMatrix44(); // we do not need this, but it comes with the PCA...
+		HomogeneousMatrix44 dummyPose; // we do not need this, but it comes with the PCA...
 		Vector3D boxDimensions;
-		boundingBoxEstimator.computeOrientedBoundingBox(inputPointCloud, &dummyPose, boxDimensions);
+		statistics.computeOrientedBoundingBox(inputPointCloud, &dummyPose, boxDimensions);
 		result.volume = boxDimensions.getX() * boxDimensions.getY() * boxDimensions.getZ();
 
 		/* Calculate density */
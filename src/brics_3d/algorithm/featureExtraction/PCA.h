@@ -24,7 +24,6 @@
 #include "brics_3d/core/PointCloud3D.h"
 #include "brics_3d/core/IHomogeneousMatrix44.h"
 #include "brics_3d/core/IPoint3DIterator.h"
-#include "brics_3d/algorithm/featureExtraction/Centroid3D.h"
 
 namespace brics_3d {
 
@@ -65,10 +64,6 @@ public:
 	 */
 	void computeRotationMatrix(Eigen::MatrixXd eigenvectors, Eigen::VectorXd eigenvalues, IHomogeneousMatrix44* resultRotation);
 
-private:
-
-	///Centroid extraction that is needed for PCA.
-	Centroid3D centroidExtractor;
 };
 
 }
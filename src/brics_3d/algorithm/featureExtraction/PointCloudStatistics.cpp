@@ -0,0 +1,350 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#include "PointCloudStatistics.h"
+#include "PCA.h"
+#include "brics_3d/core/HomogeneousMatrix44.h"
+#include "brics_3d/core/Logger.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace brics_3d {
+
+static inline bool isValidPoint(Coordinate x, Coordinate y, Coordinate z) {
+	return !std::isnan(x) && !std::isinf(x) && !std::isnan(y) && !std::isinf(y) && !std::isnan(z) && !std::isinf(z);
+}
+
+PointCloudStatistics::PointCloudStatistics() {
+	reset();
+}
+
+PointCloudStatistics::~PointCloudStatistics() {
+
+}
+
+void PointCloudStatistics::reset() {
+	count = 0;
+	skippedCount = 0;
+	for (int i = 0; i < 3; ++i) {
+		mean[i] = 0.0;
+		lowerBound[i] = std::numeric_limits<double>::max();
+		upperBound[i] = -std::numeric_limits<double>::max();
+	}
+	for (int i = 0; i < 6; ++i) {
+		comoment[i] = 0.0;
+	}
+}
+
+void PointCloudStatistics::addPoint(Coordinate x, Coordinate y, Coordinate z) {
+	if (!isValidPoint(x, y, z)) {
+		skippedCount++;
+		return;
+	}
+
+	lowerBound[0] = std::min(lowerBound[0], x);
+	lowerBound[1] = std::min(lowerBound[1], y);
+	lowerBound[2] = std::min(lowerBound[2], z);
+	upperBound[0] = std::max(upperBound[0], x);
+	upperBound[1] = std::max(upperBound[1], y);
+	upperBound[2] = std::max(upperBound[2], z);
+
+	/* Welford update */
+	count++;
+	const double dx = x - mean[0];
+	const double dy = y - mean[1];
+	const double dz = z - mean[2];
+	mean[0] += dx / count;
+	mean[1] += dy / count;
+	mean[2] += dz / count;
+	const double ex = x - mean[0];
+	const double ey = y - mean[1];
+	const double ez = z - mean[2];
+	comoment[0] += dx * ex;
+	comoment[1] += dx * ey;
+	comoment[2] += dx * ez;
+	comoment[3] += dy * ey;
+	comoment[4] += dy * ez;
+	comoment[5] += dz * ez;
+}
+
+void PointCloudStatistics::addPoints(const Coordinate* points, unsigned int numberOfPoints) {
+	const unsigned int blockSize = IPoint3DIterator::defaultBlockSize;
+
+	for (unsigned int start = 0; start < numberOfPoints; start += blockSize) {
+		const Coordinate* block = &points[start * 3];
+		const unsigned int end = std::min(blockSize, numberOfPoints - start);
+
+		/* two-pass reduction of a block that is still in the cache */
+		PointCloudStatistics blockStatistics;
+		double sum[3] = {0.0, 0.0, 0.0};
+		for (unsigned int i = 0; i < end; ++i) {
+			const Coordinate* p = &block[i * 3];
+			if (!isValidPoint(p[0], p[1], p[2])) {
+				blockStatistics.skippedCount++;
+				continue;
+			}
+			sum[0] += p[0];
+			sum[1] += p[1];
+			sum[2] += p[2];
+			for (int j = 0; j < 3; ++j) {
+				blockStatistics.lowerBound[j] = std::min(blockStatistics.lowerBound[j], p[j]);
+				blockStatistics.upperBound[j] = std::max(blockStatistics.upperBound[j], p[j]);
+			}
+			blockStatistics.count++;
+		}
+
+		if (blockStatistics.count > 0) {
+			for (int j = 0; j < 3; ++j) {
+				blockStatistics.mean[j] = sum[j] / blockStatistics.count;
+			}
+			for (unsigned int i = 0; i < end; ++i) {
+				const Coordinate* p = &block[i * 3];
+				if (!isValidPoint(p[0], p[1], p[2])) {
+					continue;
+				}
+				const double dx = p[0] - blockStatistics.mean[0];
+				const double dy = p[1] - blockStatistics.mean[1];
+				const double dz = p[2] - blockStatistics.mean[2];
+				blockStatistics.comoment[0] += dx * dx;
+				blockStatistics.comoment[1] += dx * dy;
+				blockStatistics.comoment[2] += dx * dz;
+				blockStatistics.comoment[3] += dy * dy;
+				blockStatistics.comoment[4] += dy * dz;
+				blockStatistics.comoment[5] += dz * dz;
+			}
+		}
+
+		merge(blockStatistics);
+	}
+}
+
+void PointCloudStatistics::addPoints(IPoint3DIterator::IPoint3DIteratorPtr inputPointCloud) {
+	Coordinate block[3 * IPoint3DIterator::defaultBlockSize];
+	unsigned int blockSize;
+	for (inputPointCloud->begin(); (blockSize = inputPointCloud->nextBlock(block, IPoint3DIterator::defaultBlockSize)) > 0; ) {
+		addPoints(block, blockSize);
+	}
+}
+
+void PointCloudStatistics::addPoints(PointCloud3D* inputPointCloud) {
+	assert(inputPointCloud != 0);
+	Coordinate block[3 * IPoint3DIterator::defaultBlockSize];
+	const unsigned int size = inputPointCloud->getSize();
+	for (unsigned int start = 0; start < size; start += IPoint3DIterator::defaultBlockSize) {
+		unsigned int blockSize = std::min(static_cast<unsigned int>(IPoint3DIterator::defaultBlockSize), size - start);
+		inputPointCloud->getTransformedPoints(start, blockSize, 0, block);
+		addPoints(block, blockSize);
+	}
+}
+
+void PointCloudStatistics::merge(const PointCloudStatistics& other) {
+	skippedCount += other.skippedCount;
+	if (other.count == 0) {
+		return;
+	}
+	if (count == 0) {
+		unsigned int skipped = skippedCount;
+		*this = other;
+		skippedCount = skipped;
+		return;
+	}
+
+	/* parallel variant of the online update (Chan et al.) */
+	const double n = static_cast<double>(count) + other.count;
+	const double weight = static_cast<double>(count) * other.count / n;
+	const double dx = other.mean[0] - mean[0];
+	const double dy = other.mean[1] - mean[1];
+	const double dz = other.mean[2] - mean[2];
+
+	comoment[0] += other.comoment[0] + dx * dx * weight;
+	comoment[1] += other.comoment[1] + dx * dy * weight;
+	comoment[2] += other.comoment[2] + dx * dz * weight;
+	comoment[3] += other.comoment[3] + dy * dy * weight;
+	comoment[4] += other.comoment[4] + dy * dz * weight;
+	comoment[5] += other.comoment[5] + dz * dz * weight;
+
+	mean[0] += dx * other.count / n;
+	mean[1] += dy * other.count / n;
+	mean[2] += dz * other.count / n;
+
+	for (int i = 0; i < 3; ++i) {
+		lowerBound[i] = std::min(lowerBound[i], other.lowerBound[i]);
+		upperBound[i] = std::max(upperBound[i], other.upperBound[i]);
+	}
+	count += other.count;
+}
+
+Eigen::Vector3d PointCloudStatistics::getCentroid() const {
+	Eigen::Vector3d centroid;
+	centroid[0] = mean[0];
+	centroid[1] = mean[1];
+	centroid[2] = mean[2];
+	return centroid;
+}
+
+Eigen::Matrix3d PointCloudStatistics::getCovariance() const {
+	Eigen::Matrix3d covariance;
+	covariance.setZero();
+	if (count == 0) {
+		return covariance;
+	}
+	covariance(0, 0) = comoment[0];
+	covariance(0, 1) = covariance(1, 0) = comoment[1];
+	covariance(0, 2) = covariance(2, 0) = comoment[2];
+	covariance(1, 1) = comoment[3];
+	covariance(1, 2) = covariance(2, 1) = comoment[4];
+	covariance(2, 2) = comoment[5];
+	covariance /= count;
+	return covariance;
+}
+
+bool PointCloudStatistics::getAxisAlignedBoundingBox(Point3D& lowerBound, Point3D& upperBound) const {
+	if (count == 0) {
+		return false;
+	}
+	lowerBound = Point3D(this->lowerBound[0], this->lowerBound[1], this->lowerBound[2]);
+	upperBound = Point3D(this->upperBound[0], this->upperBound[1], this->upperBound[2]);
+	return true;
+}
+
+bool PointCloudStatistics::getAxisAlignedBoundingBox(Point3D& resultBoxCenter, Vector3D& resultBoxDimensions) const {
+	if (count == 0) {
+		return false;
+	}
+	resultBoxDimensions.setX(upperBound[0] - lowerBound[0]);
+	resultBoxDimensions.setY(upperBound[1] - lowerBound[1]);
+	resultBoxDimensions.setZ(upperBound[2] - lowerBound[2]);
+	resultBoxCenter.setX(lowerBound[0] + resultBoxDimensions.getX() / 2.0);
+	resultBoxCenter.setY(lowerBound[1] + resultBoxDimensions.getY() / 2.0);
+	resultBoxCenter.setZ(lowerBound[2] + resultBoxDimensions.getZ() / 2.0);
+	return true;
+}
+
+void PointCloudStatistics::computePrincipleComponents(Eigen::MatrixXd& eigenvectors, Eigen::VectorXd& eigenvalues) const {
+	Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> evd(getCovariance());
+	Eigen::VectorXd eigenvaluesTmp = evd.eigenvalues().real(); //NOTE eigen values are sorted in increasing order
+	Eigen::MatrixXd eigenvectorsTmp = evd.eigenvectors().real();
+
+	// sort to descending -> main component is first
+	eigenvalues = eigenvaluesTmp;
+	eigenvectors = eigenvectorsTmp;
+	for (int i = 0; i < 3; ++i) {
+		eigenvalues[i] = eigenvaluesTmp[2-i];
+		eigenvectors.col(i) = eigenvectorsTmp.col(2-i);
+	}
+}
+
+void PointCloudStatistics::computeOrientedBoundingBox(IPoint3DIterator::IPoint3DIteratorPtr inputPointCloud, IHomogeneousMatrix44* resultTransform, Vector3D& resultBoxDimensions) const {
+	double inverseRotation[16];
+	double lower[3];
+	double upper[3];
+	prepareOrientedBoundingBox(resultTransform, inverseRotation, lower, upper);
+
+	Coordinate block[3 * IPoint3DIterator::defaultBlockSize];
+	unsigned int blockSize;
+	for (inputPointCloud->begin(); (blockSize = inputPointCloud->nextBlock(block, IPoint3DIterator::defaultBlockSize)) > 0; ) {
+		extendOrientedBoundingBox(block, blockSize, inverseRotation, lower, upper);
+	}
+
+	finishOrientedBoundingBox(resultTransform, resultBoxDimensions, lower, upper);
+}
+
+void PointCloudStatistics::computeOrientedBoundingBox(PointCloud3D* inputPointCloud, IHomogeneousMatrix44* resultTransform, Vector3D& resultBoxDimensions) const {
+	assert(inputPointCloud != 0);
+	double inverseRotation[16];
+	double lower[3];
+	double upper[3];
+	prepareOrientedBoundingBox(resultTransform, inverseRotation, lower, upper);
+
+	Coordinate block[3 * IPoint3DIterator::defaultBlockSize];
+	const unsigned int size = inputPointCloud->getSize();
+	for (unsigned int start = 0; start < size; start += IPoint3DIterator::defaultBlockSize) {
+		unsigned int blockSize = std::min(static_cast<unsigned int>(IPoint3DIterator::defaultBlockSize), size - start);
+		inputPointCloud->getTransformedPoints(start, blockSize, 0, block);
+		extendOrientedBoundingBox(block, blockSize, inverseRotation, lower, upper);
+	}
+
+	finishOrientedBoundingBox(resultTransform, resultBoxDimensions, lower, upper);
+}
+
+void PointCloudStatistics::prepareOrientedBoundingBox(IHomogeneousMatrix44* resultTransform, double* inverseRotation, double* lower, double* upper) const {
+	assert(resultTransform != 0);
+
+	Eigen::MatrixXd eigenvectors;
+	Eigen::VectorXd eigenvalues;
+	computePrincipleComponents(eigenvectors, eigenvalues);
+	PCA pcaExtractor;
+	pcaExtractor.computeRotationMatrix(eigenvectors, eigenvalues, resultTransform);
+
+	HomogeneousMatrix44 inverse;
+	inverse = *resultTransform;
+	inverse.inverse();
+	std::copy(inverse.getRawData(), inverse.getRawData() + 16, inverseRotation);
+
+	for (int i = 0; i < 3; ++i) {
+		lower[i] = std::numeric_limits<double>::max();
+		upper[i] = -std::numeric_limits<double>::max();
+	}
+}
+
+void PointCloudStatistics::extendOrientedBoundingBox(const Coordinate* points, unsigned int numberOfPoints, const double* inverseRotation, double* lower, double* upper) {
+	/* column-major layout, cf. Point3D::homogeneousTransformation */
+	const double* m = inverseRotation;
+	for (unsigned int i = 0; i < numberOfPoints; ++i, points += 3) {
+		if (!isValidPoint(points[0], points[1], points[2])) {
+			continue;
+		}
+		const double x = points[0] * m[0] + points[1] * m[4] + points[2] * m[8] + m[12];
+		const double y = points[0] * m[1] + points[1] * m[5] + points[2] * m[9] + m[13];
+		const double z = points[0] * m[2] + points[1] * m[6] + points[2] * m[10] + m[14];
+		lower[0] = std::min(lower[0], x);
+		lower[1] = std::min(lower[1], y);
+		lower[2] = std::min(lower[2], z);
+		upper[0] = std::max(upper[0], x);
+		upper[1] = std::max(upper[1], y);
+		upper[2] = std::max(upper[2], z);
+	}
+}
+
+void PointCloudStatistics::finishOrientedBoundingBox(IHomogeneousMatrix44* resultTransform, Vector3D& resultBoxDimensions, const double* lower, const double* upper) const {
+	/* centroid as translation */
+	double* matrixData = resultTransform->setRawData();
+	matrixData[12] = mean[0];
+	matrixData[13] = mean[1];
+	matrixData[14] = mean[2];
+
+	LOG(DEBUG) << "Estimated transform for oriented bounding box: "<< std::endl << *resultTransform;
+
+	if (count == 0) {
+		resultBoxDimensions.setX(0.0);
+		resultBoxDimensions.setY(0.0);
+		resultBoxDimensions.setZ(0.0);
+		return;
+	}
+	resultBoxDimensions.setX(fabs(upper[0] - lower[0]));
+	resultBoxDimensions.setY(fabs(upper[1] - lower[1]));
+	resultBoxDimensions.setZ(fabs(upper[2] - lower[2]));
+}
+
+}
+
+/* EOF */
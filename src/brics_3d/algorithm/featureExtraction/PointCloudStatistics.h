@@ -0,0 +1,174 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#ifndef BRICS_3D_POINTCLOUDSTATISTICS_H_
+#define BRICS_3D_POINTCLOUDSTATISTICS_H_
+
+#include "brics_3d/core/PointCloud3D.h"
+#include "brics_3d/core/IPoint3DIterator.h"
+#include "brics_3d/core/IHomogeneousMatrix44.h"
+#include "brics_3d/core/Vector3D.h"
+
+#include <Eigen/Dense>
+
+namespace brics_3d {
+
+/**
+ * @brief Streaming accumulator for the basic statistics of a point cloud.
+ * @ingroup featureExtraction
+ *
+ * A single pass over the points yields the number of points, the axis aligned bounding box,
+ * the centroid and the covariance. The principle components are derived from the covariance
+ * without touching the points again. Only the extents of an oriented bounding box require a
+ * second pass, as they depend on the principle components (see computeOrientedBoundingBox()).
+ *
+ * Mean and covariance are updated with numerically stable online updates. Blocks of points are
+ * first reduced with a two-pass scheme while they are in the cache and then merged. The same
+ * merge is available via merge(), so partial statistics of e.g. multiple threads or multiple
+ * segments can be combined.
+ *
+ * Points with NaN or infinite coordinates are skipped and counted separately.
+ *
+ * @code
+ * PointCloudStatistics statistics;
+ * statistics.addPoints(iterator);
+ * statistics.getNumberOfPoints();
+ * statistics.getCentroid();
+ * statistics.computePrincipleComponents(eigenvectors, eigenvalues);
+ * @endcode
+ */
+class PointCloudStatistics {
+public:
+
+	/**
+	 * Standard constructor. Creates empty statistics.
+	 */
+	PointCloudStatistics();
+
+	/**
+	 * Standard destructor.
+	 */
+	virtual ~PointCloudStatistics();
+
+	/// Remove all accumulated points.
+	void reset();
+
+	/// Accumulate a single point.
+	void addPoint(Coordinate x, Coordinate y, Coordinate z);
+
+	/**
+	 * @brief Accumulate a block of points.
+	 * @param points Consecutive x,y,z values.
+	 * @param count Number of points.
+	 */
+	void addPoints(const Coordinate* points, unsigned int count);
+
+	/// Accumulate all points of an iterator. The iterator is traversed block wise from its beginning.
+	void addPoints(IPoint3DIterator::IPoint3DIteratorPtr inputPointCloud);
+
+	/// Accumulate all points of a point cloud.
+	void addPoints(PointCloud3D* inputPointCloud);
+
+	/**
+	 * @brief Combine with statistics of another set of points.
+	 * The result is the same as if all points had been accumulated by this object.
+	 */
+	void merge(const PointCloudStatistics& other);
+
+	/// Number of accumulated (valid) points.
+	unsigned int getNumberOfPoints() const {
+		return count;
+	}
+
+	/// Number of points that have been skipped because of NaN or infinite coordinates.
+	unsigned int getNumberOfSkippedPoints() const {
+		return skippedCount;
+	}
+
+	/// Arithmetic mean of all points. (0,0,0) for empty statistics.
+	Eigen::Vector3d getCentroid() const;
+
+	/// Covariance matrix normalized by the number of points. Zero for empty statistics.
+	Eigen::Matrix3d getCovariance() const;
+
+	/**
+	 * @brief Axis aligned bounding box.
+	 * @param[out] lowerBound Minimal x,y and z values.
+	 * @param[out] upperBound Maximal x,y and z values.
+	 * @return False for empty statistics.
+	 */
+	bool getAxisAlignedBoundingBox(Point3D& lowerBound, Point3D& upperBound) const;
+
+	/**
+	 * @brief Axis aligned bounding box in the same format as BoundingBox3DExtractor::computeBoundingBox().
+	 * @return False for empty statistics.
+	 */
+	bool getAxisAlignedBoundingBox(Point3D& resultBoxCenter, Vector3D& resultBoxDimensions) const;
+
+	/**
+	 * @brief Principle components derived from the covariance.
+	 * @param[out] eigenvectors Eigen vectors as columns. Sorted in descending order of eigen values.
+	 * @param[out] eigenvalues Corresponding eingen values. Sorted in descending order.
+	 */
+	void computePrincipleComponents(Eigen::MatrixXd& eigenvectors, Eigen::VectorXd& eigenvalues) const;
+
+	/**
+	 * @brief Oriented bounding box based on the principle components.
+	 *
+	 * Requires one further pass over the points to find the extents along the principle axes.
+	 * The points have to be the ones that have been accumulated.
+	 *
+	 * @param[in] inputPointCloud The accumulated points.
+	 * @param[out] resultTransform Orientation as given by PCA::computeRotationMatrix() and the centroid as translation.
+	 * @param[out] resultBoxDimensions The dimensions along the principle axes.
+	 */
+	void computeOrientedBoundingBox(IPoint3DIterator::IPoint3DIteratorPtr inputPointCloud, IHomogeneousMatrix44* resultTransform, Vector3D& resultBoxDimensions) const;
+
+	/// Same as above but for a point cloud.
+	void computeOrientedBoundingBox(PointCloud3D* inputPointCloud, IHomogeneousMatrix44* resultTransform, Vector3D& resultBoxDimensions) const;
+
+private:
+
+	/// Rotation into the frame of the principle components and reset of the extents.
+	void prepareOrientedBoundingBox(IHomogeneousMatrix44* resultTransform, double* inverseRotation, double* lower, double* upper) const;
+
+	/// Extend the oriented bounding box by a block of points.
+	static void extendOrientedBoundingBox(const Coordinate* points, unsigned int count, const double* inverseRotation, double* lower, double* upper);
+
+	void finishOrientedBoundingBox(IHomogeneousMatrix44* resultTransform, Vector3D& resultBoxDimensions, const double* lower, const double* upper) const;
+
+	unsigned int count;
+	unsigned int skippedCount;
+
+	/// Running mean.
+	double mean[3];
+
+	/// Sum of squared deviations from the mean (co-moments): xx, xy, xz, yy, yz, zz.
+	double comoment[6];
+
+	double lowerBound[3];
+	double upperBound[3];
+};
+
+}
+
+#endif /* BRICS_3D_POINTCLOUDSTATISTICS_H_ */
+
+/* EOF */
@@ -326,11 +326,33 @@ void HomogeneousMatrix44::matrixToQuaternion(IHomogeneousMatrix44::IHomogeneousM
 	z = matrixData[matrixEntry::z];
 
 	/* Rotation */
-	qw = 1/2.0 * (sqrt(1 + matrixData[matrixEntry::r11] + matrixData[matrixEntry::r22] + matrixData[matrixEntry::r33]));
-	assert (qw != 0.0);
-	qx = (matrixData[matrixEntry::r32] - matrixData[matrixEntry::r23]) / 4 * qw;
-	qy = (matrixData[matrixEntry::r13] - matrixData[matrixEntry::r31]) / 4 * qw;
-	qz = (matrixData[matrixEntry::r21] - matrixData[matrixEntry::r12]) / 4 * qw;
+	// Shepperd's method: start with the largest of the four components to stay numerically stable
+	double trace = matrixData[matrixEntry::r11] + matrixData[matrixEntry::r22] + matrixData[matrixEntry::r33];
+	if (trace > 0) {
+		double s = 2.0 * sqrt(1.0 + trace); // s = 4 * qw
+		qw = 0.25 * s;
+		qx = (matrixData[matrixEntry::r32] - matrixData[matrixEntry::r23]) / s;
+		qy = (matrixData[matrixEntry::r13] - matrixData[matrixEntry::r31]) / s;
+		qz = (matrixData[matrixEntry::r21] - matrixData[matrixEntry::r12]) / s;
+	} else if (matrixData[matrixEntry::r11] > matrixData[matrixEntry::r22] && matrixData[matrixEntry::r11] > matrixData[matrixEntry::r33]) {
+		double s = 2.0 * sqrt(1.0 + matrixData[matrixEntry::r11] - matrixData[matrixEntry::r22] - matrixData[matrixEntry::r33]); // s = 4 * qx
+		qw = (matrixData[matrixEntry::r32] - matrixData[matrixEntry::r23]) / s;
+		qx = 0.25 * s;
+		qy = (matrixData[matrixEntry::r12] + matrixData[matrixEntry::r21]) / s;
+		qz = (matrixData[matrixEntry::r13] + matrixData[matrixEntry::r31]) / s;
+	} else if (matrixData[matrixEntry::r22] > matrixData[matrixEntry::r33]) {
+		double s = 2.0 * sqrt(1.0 + matrixData[matrixEntry::r22] - matrixData[matrixEntry::r11] - matrixData[matrixEntry::r33]); // s = 4 * qy
+		qw = (matrixData[matrixEntry::r13] - matrixData[matrixEntry::r31]) / s;
+		qx = (matrixData[matrixEntry::r12] + matrixData[matrixEntry::r21]) / s;
+		qy = 0.25 * s;
+		qz = (matrixData[matrixEntry::r23] + matrixData[matrixEntry::r32]) / s;
+	} else {
+		double s = 2.0 * sqrt(1.0 + matrixData[matrixEntry::r33] - matrixData[matrixEntry::r11] - matrixData[matrixEntry::r22]); // s = 4 * qz
+		qw = (matrixData[matrixEntry::r21] - matrixData[matrixEntry::r12]) / s;
+		qx = (matrixData[matrixEntry::r13] + matrixData[matrixEntry::r31]) / s;
+		qy = (matrixData[matrixEntry::r23] + matrixData[matrixEntry::r32]) / s;
+		qz = 0.25 * s;
+	}
 
 }
 
@@ -44,6 +44,20 @@ namespace brics_3d {
  *	}
  *	delete it;
  * @endcode
+ *
+ * Consumers that process many points should rather fetch blocks of transformed points with nextBlock():
+ *
+ *  @code
+ *	Coordinate block[3 * IPoint3DIterator::defaultBlockSize];
+ *	unsigned int count;
+ *	for (it->begin(); (count = it->nextBlock(block, IPoint3DIterator::defaultBlockSize)) > 0; ) {
+ *		for (unsigned int i = 0; i < count; ++i) {
+ *			block[3*i]; // x
+ *			block[3*i + 1]; // y
+ *			block[3*i + 2]; // z
+ *		}
+ *	}
+ * @endcode
  */
 class IPoint3DIterator {
 public:
@@ -109,6 +123,33 @@ public:
 	 */
 	virtual Point3D* getRawData() = 0; //not transformed, but might have additional data like color, etc.
 
+	/// Suggested number of points per block for nextBlock().
+	static const unsigned int defaultBlockSize = 256;
+
+	/**
+	 * @brief Copy up to maxPoints (possibly) transformed points into a buffer and advance past them.
+	 *
+	 * The block starts with the current point, i.e. the one that getX(), getY() and getZ() would return.
+	 * Afterwards the iterator points to the first point that has not been copied, so block wise and
+	 * point wise access can be mixed.
+	 *
+	 * This default implementation serves as adapter for iterators that do not provide
+	 * an optimized version. It simply calls getX(), getY(), getZ() and next() for every point.
+	 *
+	 * @param[out] points Consecutive x,y,z values. Has to provide space for 3*maxPoints coordinates.
+	 * @param maxPoints Maximum number of points to copy.
+	 * @return Number of copied points. 0 means the end has been reached.
+	 */
+	virtual unsigned int nextBlock(Coordinate* points, unsigned int maxPoints) {
+		unsigned int count = 0;
+		for (; (count < maxPoints) && !end(); next(), ++count, points += 3) {
+			points[0] = getX();
+			points[1] = getY();
+			points[2] = getZ();
+		}
+		return count;
+	}
+
 };
 
 }
@@ -23,6 +23,7 @@
 #include <string>
 #include <sstream>
 #include <stdexcept>
+#include <cassert>
 
 using namespace std;
 
@@ -201,6 +202,43 @@ void PointCloud3D::homogeneousTransformation(IHomogeneousMatrix44 *transformatio
 	}
 }
 
+void PointCloud3D::getTransformedPoints(unsigned int startIndex, unsigned int count, const IHomogeneousMatrix44* transformation, Coordinate* result) {
+	assert(startIndex + count <= pointCloud->size());
+	const unsigned int endIndex = startIndex + count;
+
+	if (transformation == 0) {
+		for (unsigned int i = startIndex; i < endIndex; ++i, result += 3) {
+			const Point3D& point = (*pointCloud)[i];
+			result[0] = point.getX();
+			result[1] = point.getY();
+			result[2] = point.getZ();
+		}
+		return;
+	}
+
+	/*
+	 * layout:
+	 * 0 4 8  12
+	 * 1 5 9  13
+	 * 2 6 10 14
+	 * 3 7 11 15
+	 */
+	const double* matrix = transformation->getRawData();
+	const double m0 = matrix[0], m4 = matrix[4], m8 = matrix[8], m12 = matrix[12];
+	const double m1 = matrix[1], m5 = matrix[5], m9 = matrix[9], m13 = matrix[13];
+	const double m2 = matrix[2], m6 = matrix[6], m10 = matrix[10], m14 = matrix[14];
+
+	for (unsigned int i = startIndex; i < endIndex; ++i, result += 3) {
+		const Point3D& point = (*pointCloud)[i];
+		const Coordinate x = point.getX();
+		const Coordinate y = point.getY();
+		const Coordinate z = point.getZ();
+		result[0] = x * m0 + y * m4 + z * m8 + m12;
+		result[1] = x * m1 + y * m5 + z * m9 + m13;
+		result[2] = x * m2 + y * m6 + z * m10 + m14;
+	}
+}
+
 }
 
 /* EOF */
@@ -133,6 +133,19 @@ public:
 	 */
 	void homogeneousTransformation(IHomogeneousMatrix44* transformation);
 
+	/**
+	 * @brief Copy a range of transformed points into a flat buffer. The point cloud itself remains unmodified.
+	 *
+	 * The coefficients of the transformation are loaded once for the whole range, so this is
+	 * considerably faster than transforming point by point.
+	 *
+	 * @param[in] startIndex Index of the first point.
+	 * @param[in] count Number of points. startIndex + count must not exceed getSize().
+	 * @param[in] transformation The homogeneous transformation matrix that will be applied. Null means identity.
+	 * @param[out] result Consecutive x,y,z values. Has to provide space for 3*count coordinates.
+	 */
+	void getTransformedPoints(unsigned int startIndex, unsigned int count, const IHomogeneousMatrix44* transformation, Coordinate* result);
+
 protected:
 
 #ifdef USE_POINTER_VECTOR
@@ -22,6 +22,8 @@
 #include "HomogeneousMatrix44.h"
 #include "Logger.h"
 
+#include <algorithm>
+
 namespace brics_3d {
 
 PointCloud3DIterator::PointCloud3DIterator() {
@@ -118,11 +120,28 @@ Point3D* PointCloud3DIterator::getRawData() {
 	return &(*pointCloudsIterator->first->getPointCloud())[index];
 }
 
+unsigned int PointCloud3DIterator::nextBlock(Coordinate* points, unsigned int maxPoints) {
+	unsigned int count = 0;
+	while ((count < maxPoints) && !end()) {
+		PointCloud3D* pointCloud = pointCloudsIterator->first.get();
+		unsigned int blockSize = std::min(pointCloud->getSize() - index, maxPoints - count);
+		const IHomogeneousMatrix44* transform = (*associatedTransformIsIdentityIterator) ? 0 : pointCloudsIterator->second.get();
+		pointCloud->getTransformedPoints(index, blockSize, transform, &points[count * 3]);
+		count += blockSize;
+		index += blockSize - 1;
+		next(); // handles the wrap over to the next point cloud
+	}
+	return count;
+}
+
 void PointCloud3DIterator::insert(PointCloud3D::PointCloud3DPtr pointCloud, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr associatedTransform) {
 	assert(pointCloud != 0);
 	assert(associatedTransform != 0);
-	pointCloudsWithTransforms.insert(std::make_pair(pointCloud, associatedTransform));
-	associatedTransformIsIdentity.push_back(associatedTransform->isIdentity());
+	std::pair<std::map<PointCloud3D::PointCloud3DPtr, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr>::iterator, bool> result;
+	result = pointCloudsWithTransforms.insert(std::make_pair(pointCloud, associatedTransform));
+	if (result.second) { // keep the flags in the same order as the map
+		associatedTransformIsIdentity.insert(associatedTransformIsIdentity.begin() + std::distance(pointCloudsWithTransforms.begin(), result.first), associatedTransform->isIdentity());
+	}
 }
 
 void PointCloud3DIterator::insert(PointCloud3D::PointCloud3DPtr pointCloud) {
@@ -85,6 +85,12 @@ public:
 	virtual Coordinate getZ(); // (possibly) transformed
 	virtual Point3D* getRawData(); //not transformed, but might have additional data like color, etc.
 
+	/**
+	 * @brief Block wise access that transforms all points of a block with a single pass over the point cloud.
+	 * @see IPoint3DIterator::nextBlock()
+	 */
+	virtual unsigned int nextBlock(Coordinate* points, unsigned int maxPoints);
+
 	/**
 	 * @brief Add a point cloud with its associated transform.
 	 * @param pointCloud The point cloud to be added.
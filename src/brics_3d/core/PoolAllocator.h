@@ -0,0 +1,219 @@
+/******************************************************************************
+* BRICS_3D - 3D Perception and Modeling Library
+* Copyright (c) 2017, KU Leuven
+*
+* Author: Sebastian Blumenthal
+*
+*
+* This software is published under a dual-license: GNU Lesser General Public
+* License LGPL 2.1 and Modified BSD license. The dual-license implies that
+* users of this code may choose which terms they prefer.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL and the BSD license for
+* more details.
+*
+******************************************************************************/
+
+#ifndef BRICS_3D_POOLALLOCATOR_H_
+#define BRICS_3D_POOLALLOCATOR_H_
+
+#include <cstddef>
+#include <new>
+#include <boost/pool/pool_alloc.hpp>
+#include <boost/atomic.hpp>
+
+namespace brics_3d {
+
+/**
+ * @brief Occupancy statistics of a memory pool.
+ *
+ * Objects are counted, not the chunks that the pools have reserved from
+ * the system. Note that the pools do not give memory back to the system,
+ * so the peak values are a good indicator for the actual memory consumption.
+ */
+struct PoolStatistics {
+
+	PoolStatistics() :
+		allocations(0),
+		deallocations(0),
+		objectsInUse(0),
+		peakObjectsInUse(0),
+		bytesInUse(0),
+		peakBytesInUse(0) {
+	}
+
+	/// Total number of allocations since program start.
+	unsigned long allocations;
+
+	/// Total number of deallocations since program start.
+	unsigned long deallocations;
+
+	/// Number of currently allocated objects.
+	unsigned long objectsInUse;
+
+	/// Maximum of objectsInUse.
+	unsigned long peakObjectsInUse;
+
+	/// Currently allocated bytes, including the shared_ptr control blocks if allocate_shared is used.
+	std::size_t bytesInUse;
+
+	/// Maximum of bytesInUse.
+	std::size_t peakBytesInUse;
+};
+
+/**
+ * @brief Bookkeeping of PoolStatistics for all PoolAllocators that share the same Tag.
+ *
+ * The counters are atomic, so allocations from several threads do not serialize on a lock.
+ * The fields of a PoolStatistics snapshot are read one after the other; while other threads
+ * allocate they might be slightly out of sync with each other.
+ */
+template<typename Tag>
+class PoolStatisticsRegistry {
+public:
+
+	static void notifyAllocation(std::size_t numberOfObjects, std::size_t bytes) {
+		Counters& counters = getCounters();
+		counters.allocations.fetch_add(numberOfObjects, boost::memory_order_relaxed);
+		unsigned long objectsInUse = counters.objectsInUse.fetch_add(numberOfObjects, boost::memory_order_relaxed) + numberOfObjects;
+		std::size_t bytesInUse = counters.bytesInUse.fetch_add(bytes, boost::memory_order_relaxed) + bytes;
+		updatePeak(counters.peakObjectsInUse, objectsInUse);
+		updatePeak(counters.peakBytesInUse, bytesInUse);
+	}
+
+	static void notifyDeallocation(std::size_t numberOfObjects, std::size_t bytes) {
+		Counters& counters = getCounters();
+		counters.deallocations.fetch_add(numberOfObjects, boost::memory_order_relaxed);
+		counters.objectsInUse.fetch_sub(numberOfObjects, boost::memory_order_relaxed);
+		counters.bytesInUse.fetch_sub(bytes, boost::memory_order_relaxed);
+	}
+
+	/// Get a copy of the current statistics.
+	static PoolStatistics getStatistics() {
+		Counters& counters = getCounters();
+		PoolStatistics stats;
+		stats.allocations = counters.allocations.load(boost::memory_order_relaxed);
+		stats.deallocations = counters.deallocations.load(boost::memory_order_relaxed);
+		stats.objectsInUse = counters.objectsInUse.load(boost::memory_order_relaxed);
+		stats.peakObjectsInUse = counters.peakObjectsInUse.load(boost::memory_order_relaxed);
+		stats.bytesInUse = counters.bytesInUse.load(boost::memory_order_relaxed);
+		stats.peakBytesInUse = counters.peakBytesInUse.load(boost::memory_order_relaxed);
+		return stats;
+	}
+
+private:
+
+	struct Counters {
+		Counters() : allocations(0), deallocations(0), objectsInUse(0), peakObjectsInUse(0), bytesInUse(0), peakBytesInUse(0) {}
+
+		boost::atomic<unsigned long> allocations;
+		boost::atomic<unsigned long> deallocations;
+		boost::atomic<unsigned long> objectsInUse;
+		boost::atomic<unsigned long> peakObjectsInUse;
+		boost::atomic<std::size_t> bytesInUse;
+		boost::atomic<std::size_t> peakBytesInUse;
+	};
+
+	static Counters& getCounters() {
+		static Counters counters;
+		return counters;
+	}
+
+	template<typename Value>
+	static void updatePeak(boost::atomic<Value>& peak, Value value) {
+		Value currentPeak = peak.load(boost::memory_order_relaxed);
+		while ((value > currentPeak) && !peak.compare_exchange_weak(currentPeak, value, boost::memory_order_relaxed)) {
+			// currentPeak has been reloaded
+		}
+	}
+};
+
+/// Tag for allocations that do not specify a dedicated pool.
+struct DefaultPoolTag {};
+
+/**
+ * @brief Standard conforming allocator that serves objects from a boost::fast_pool_allocator.
+ *
+ * The Tag groups the allocations for the PoolStatistics. It is preserved on rebind, so
+ * it can be used with boost::allocate_shared to place both the object and the
+ * shared_ptr control block into the pool:
+ *
+ * @code
+ * struct MyTag {};
+ * boost::shared_ptr<HomogeneousMatrix44> matrix = boost::allocate_shared<HomogeneousMatrix44>(PoolAllocator<HomogeneousMatrix44, MyTag>());
+ * PoolStatistics stats = PoolStatisticsRegistry<MyTag>::getStatistics();
+ * @endcode
+ *
+ * Pools are shared between all objects of the same size and they are thread safe.
+ */
+template<typename T, typename Tag = DefaultPoolTag>
+class PoolAllocator {
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+
+	template<typename U>
+	struct rebind {
+		typedef PoolAllocator<U, Tag> other;
+	};
+
+	PoolAllocator() {}
+
+	template<typename U>
+	PoolAllocator(const PoolAllocator<U, Tag>&) {}
+
+	pointer address(reference r) const {
+		return &r;
+	}
+
+	const_pointer address(const_reference r) const {
+		return &r;
+	}
+
+	pointer allocate(size_type n, const void* = 0) {
+		pointer result = boost::fast_pool_allocator<T>::allocate(n);
+		PoolStatisticsRegistry<Tag>::notifyAllocation(n, n * sizeof(T));
+		return result;
+	}
+
+	void deallocate(pointer p, size_type n) {
+		boost::fast_pool_allocator<T>::deallocate(p, n);
+		PoolStatisticsRegistry<Tag>::notifyDeallocation(n, n * sizeof(T));
+	}
+
+	size_type max_size() const {
+		return static_cast<size_type>(-1) / sizeof(T);
+	}
+
+	void construct(pointer p, const T& value) {
+		new (static_cast<void*>(p)) T(value);
+	}
+
+	void destroy(pointer p) {
+		p->~T();
+	}
+};
+
+template<typename T, typename U, typename Tag>
+inline bool operator==(const PoolAllocator<T, Tag>&, const PoolAllocator<U, Tag>&) {
+	return true;
+}
+
+template<typename T, typename U, typename Tag>
+inline bool operator!=(const PoolAllocator<T, Tag>&, const PoolAllocator<U, Tag>&) {
+	return false;
+}
+
+} // namespace brics_3d
+
+#endif /* BRICS_3D_POOLALLOCATOR_H_ */
+
+/* EOF */
@@ -0,0 +1,523 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#ifndef RSG_BINARYTYPECASTER_H_
+#define RSG_BINARYTYPECASTER_H_
+
+#include "brics_3d/core/Logger.h"
+#include "brics_3d/core/HomogeneousMatrix44.h"
+#include "brics_3d/core/CovarianceMatrix66.h"
+#include "brics_3d/core/ColoredPoint3D.h"
+#include "brics_3d/worldModel/sceneGraph/Id.h"
+#include "brics_3d/worldModel/sceneGraph/Attribute.h"
+#include "brics_3d/worldModel/sceneGraph/TimeStamp.h"
+#include "brics_3d/worldModel/sceneGraph/Shape.h"
+#include "brics_3d/worldModel/sceneGraph/Sphere.h"
+#include "brics_3d/worldModel/sceneGraph/Box.h"
+#include "brics_3d/worldModel/sceneGraph/Cylinder.h"
+#include "brics_3d/worldModel/sceneGraph/PointCloud.h"
+#include "brics_3d/worldModel/sceneGraph/SceneGraphAllocator.h"
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <boost/cstdint.hpp>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Helper class to convert from and to the compact binary update format.
+ *
+ * Every message is length prefixed and has a fixed layout. All numbers are
+ * encoded in little endian byte order, independent of the host.
+ *
+ * @code
+ * Message:    [uint32 total length incl. header][uint8 version][uint8 command][uint16 reserved] payload
+ * Id:         16 bytes as in Uuid (RFC 4122 byte order)
+ * TimeStamp:  float64 seconds
+ * Transform:  12 x float64 (the upper 3x4 part of the column-major matrix: rotation columns, then translation)
+ * Attributes: [uint32 count] count x ([uint32 length] key bytes [uint32 length] value bytes)
+ * Ids:        [uint32 count] count x Id
+ * Shape:      [uint8 Shape::ShapeType] parameters (float64) or for point clouds
+ *             [uint32 name length] name [uint32 count] count x (3 x float64, 3 x uint8 rgb)
+ * @endcode
+ *
+ * For instance a setTransform message needs 8 + 16 + 8 + 96 = 128 bytes.
+ *
+ * The decoding functions read directly from the received buffer. They advance the
+ * cursor and return false if the buffer is too short or contains invalid data.
+ *
+ * This class is designed as "header only".
+ *
+ * @ingroup sceneGraph
+ */
+class BinaryTypecaster {
+public:
+
+	/// Command types for the binary format.
+	enum CommandType {
+		UNKNOWN_COMMAND = 0,
+		ADD_NODE = 1,
+		ADD_GROUP = 2,
+		ADD_TRANSFORM_NODE = 3,
+		ADD_UNCERTAIN_TRANSFORM_NODE = 4,
+		ADD_GEOMETRIC_NODE = 5,
+		ADD_REMOTE_ROOT_NODE = 6,
+		ADD_CONNECTION = 7,
+		SET_NODE_ATTRIBUTES = 8,
+		SET_TRANSFORM = 9,
+		SET_UNCERTAIN_TRANSFORM = 10,
+		DELETE_NODE = 11,
+		ADD_PARENT = 12,
+		REMOVE_PARENT = 13,
+		UPDATE_BATCH = 14
+	};
+
+	static const boost::uint8_t formatVersion = 1;
+	static const unsigned int headerSize = 8;
+	static const unsigned int idSize = 16;
+	static const unsigned int transformSize = 12;
+
+	/* Encoding */
+
+	/**
+	 * @brief Start a new message in the buffer.
+	 * @return Offset of the message within the buffer, to be passed to endMessage().
+	 */
+	inline static size_t beginMessage(CommandType command, std::vector<char>& buffer) {
+		size_t start = buffer.size();
+		addUInt32ToBinary(0, buffer); // length will be patched by endMessage()
+		addUInt8ToBinary(formatVersion, buffer);
+		addUInt8ToBinary(static_cast<boost::uint8_t>(command), buffer);
+		addUInt8ToBinary(0, buffer);
+		addUInt8ToBinary(0, buffer);
+		return start;
+	}
+
+	/// Finalize a message by writing its length into the header.
+	inline static void endMessage(size_t start, std::vector<char>& buffer) {
+		writeUInt32(static_cast<boost::uint32_t>(buffer.size() - start), &buffer[start]);
+	}
+
+	inline static void addUInt8ToBinary(boost::uint8_t value, std::vector<char>& buffer) {
+		buffer.push_back(static_cast<char>(value));
+	}
+
+	inline static void addUInt32ToBinary(boost::uint32_t value, std::vector<char>& buffer) {
+		size_t offset = buffer.size();
+		buffer.resize(offset + 4);
+		writeUInt32(value, &buffer[offset]);
+	}
+
+	inline static void addDoubleToBinary(double value, std::vector<char>& buffer) {
+		size_t offset = buffer.size();
+		buffer.resize(offset + 8);
+		writeDouble(value, &buffer[offset]);
+	}
+
+	inline static void addStringToBinary(const std::string& value, std::vector<char>& buffer) {
+		addUInt32ToBinary(static_cast<boost::uint32_t>(value.size()), buffer);
+		buffer.insert(buffer.end(), value.begin(), value.end());
+	}
+
+	inline static void addIdToBinary(const Id& id, std::vector<char>& buffer) {
+		buffer.insert(buffer.end(), id.begin(), id.end());
+	}
+
+	inline static void addIdsToBinary(const vector<Id>& ids, std::vector<char>& buffer) {
+		addUInt32ToBinary(static_cast<boost::uint32_t>(ids.size()), buffer);
+		for (size_t i = 0; i < ids.size(); ++i) {
+			addIdToBinary(ids[i], buffer);
+		}
+	}
+
+	inline static void addAttributesToBinary(const vector<Attribute>& attributes, std::vector<char>& buffer) {
+		addUInt32ToBinary(static_cast<boost::uint32_t>(attributes.size()), buffer);
+		for (size_t i = 0; i < attributes.size(); ++i) {
+			addStringToBinary(attributes[i].key, buffer);
+			addStringToBinary(attributes[i].value, buffer);
+		}
+	}
+
+	inline static void addTimeStampToBinary(TimeStamp timeStamp, std::vector<char>& buffer) {
+		addDoubleToBinary(timeStamp.getSeconds(), buffer);
+	}
+
+	inline static bool addTransformToBinary(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, std::vector<char>& buffer) {
+		if (transform == 0) {
+			LOG(ERROR) << "BinaryTypecaster: Cannot encode an empty transform.";
+			return false;
+		}
+
+		const double* matrix = transform->getRawData();
+		size_t offset = buffer.size();
+		buffer.resize(offset + transformSize * 8);
+		char* data = &buffer[offset];
+		for (unsigned int i = 0; i < transformSize; ++i) {
+			writeDouble(matrix[transformIndices()[i]], data + i * 8);
+		}
+		return true;
+	}
+
+	inline static bool addUncertaintyToBinary(ITransformUncertainty::ITransformUncertaintyPtr uncertainty, std::vector<char>& buffer) {
+		if (uncertainty == 0) {
+			LOG(ERROR) << "BinaryTypecaster: Cannot encode an empty uncertainty.";
+			return false;
+		}
+
+		boost::uint32_t dimension = static_cast<boost::uint32_t>(uncertainty->getRowDimension() * uncertainty->getColumnDimension());
+		addUInt32ToBinary(dimension, buffer);
+		const double* matrix = uncertainty->getRawData();
+		for (boost::uint32_t i = 0; i < dimension; ++i) {
+			addDoubleToBinary(matrix[i], buffer);
+		}
+		return true;
+	}
+
+	inline static bool addShapeToBinary(Shape::ShapePtr shape, std::vector<char>& buffer) {
+		if (shape == 0) {
+			LOG(ERROR) << "BinaryTypecaster: Cannot encode an empty shape.";
+			return false;
+		}
+
+		rsg::Sphere::SpherePtr sphere = boost::dynamic_pointer_cast<rsg::Sphere>(shape);
+		rsg::Cylinder::CylinderPtr cylinder = boost::dynamic_pointer_cast<rsg::Cylinder>(shape);
+		rsg::Box::BoxPtr box = boost::dynamic_pointer_cast<rsg::Box>(shape);
+
+		if (sphere != 0) {
+			addUInt8ToBinary(Shape::Sphere, buffer);
+			addDoubleToBinary(sphere->getRadius(), buffer);
+		} else if (cylinder != 0) {
+			addUInt8ToBinary(Shape::Cylinder, buffer);
+			addDoubleToBinary(cylinder->getRadius(), buffer);
+			addDoubleToBinary(cylinder->getHeight(), buffer);
+		} else if (box != 0) {
+			addUInt8ToBinary(Shape::Box, buffer);
+			addDoubleToBinary(box->getSizeX(), buffer);
+			addDoubleToBinary(box->getSizeY(), buffer);
+			addDoubleToBinary(box->getSizeZ(), buffer);
+		} else if (shape->getPointCloudIterator() != 0) {
+			IPoint3DIterator::IPoint3DIteratorPtr it = shape->getPointCloudIterator();
+			addUInt8ToBinary(Shape::PointCloud, buffer);
+			addStringToBinary(it->getPointCloudTypeName(), buffer);
+
+			size_t countOffset = buffer.size();
+			addUInt32ToBinary(0, buffer); // patched below, as the iterator has no size
+			boost::uint32_t numberOfPoints = 0;
+			for (it->begin(); !it->end(); it->next()) {
+				size_t offset = buffer.size();
+				buffer.resize(offset + 27);
+				char* data = &buffer[offset];
+				writeDouble(it->getX(), data);
+				writeDouble(it->getY(), data + 8);
+				writeDouble(it->getZ(), data + 16);
+				ColoredPoint3D* coloredPoint = it->getRawData()->asColoredPoint3D();
+				if (coloredPoint != 0) {
+					data[24] = static_cast<char>(coloredPoint->getR());
+					data[25] = static_cast<char>(coloredPoint->getG());
+					data[26] = static_cast<char>(coloredPoint->getB());
+				} else {
+					data[24] = data[25] = data[26] = 0;
+				}
+				numberOfPoints++;
+			}
+			writeUInt32(numberOfPoints, &buffer[countOffset]);
+		} else {
+			LOG(ERROR) << "BinaryTypecaster: Shape type not yet supported.";
+			return false;
+		}
+		return true;
+	}
+
+	/* Decoding */
+
+	/// Check quietly if a buffer starts with a plausible message header. Used to find the next message after corrupted data.
+	inline static bool isMessageHeader(const char* data, size_t dataLength) {
+		return (dataLength >= headerSize) &&
+				(static_cast<boost::uint8_t>(data[4]) == formatVersion) &&
+				(static_cast<boost::uint8_t>(data[5]) > UNKNOWN_COMMAND) && (static_cast<boost::uint8_t>(data[5]) <= UPDATE_BATCH) &&
+				(data[6] == 0) && (data[7] == 0) && // reserved
+				(readUInt32(data) >= headerSize);
+	}
+
+	/**
+	 * @brief Inspect the header of the next message in a buffer.
+	 * @param[out] messageLength Length of the complete message including the header.
+	 * @param[out] command The command type.
+	 * @return False if the buffer does not (yet) contain a complete header or the format version does not match.
+	 */
+	inline static bool getMessageHeaderFromBinary(boost::uint32_t& messageLength, CommandType& command, const char* data, size_t dataLength) {
+		if (dataLength < headerSize) {
+			return false;
+		}
+		messageLength = readUInt32(data);
+		if (static_cast<boost::uint8_t>(data[4]) != formatVersion) {
+			LOG(ERROR) << "BinaryTypecaster: Unsupported format version " << static_cast<int>(static_cast<boost::uint8_t>(data[4]));
+			return false;
+		}
+		if (messageLength < headerSize) {
+			LOG(ERROR) << "BinaryTypecaster: Invalid message length " << messageLength;
+			return false;
+		}
+		command = static_cast<CommandType>(static_cast<boost::uint8_t>(data[5]));
+		return true;
+	}
+
+	inline static bool getUInt8FromBinary(boost::uint8_t& value, const char*& cursor, const char* end) {
+		if (end - cursor < 1) {
+			return false;
+		}
+		value = static_cast<boost::uint8_t>(*cursor);
+		cursor += 1;
+		return true;
+	}
+
+	inline static bool getUInt32FromBinary(boost::uint32_t& value, const char*& cursor, const char* end) {
+		if (end - cursor < 4) {
+			return false;
+		}
+		value = readUInt32(cursor);
+		cursor += 4;
+		return true;
+	}
+
+	inline static bool getDoubleFromBinary(double& value, const char*& cursor, const char* end) {
+		if (end - cursor < 8) {
+			return false;
+		}
+		value = readDouble(cursor);
+		cursor += 8;
+		return true;
+	}
+
+	inline static bool getStringFromBinary(std::string& value, const char*& cursor, const char* end) {
+		boost::uint32_t length;
+		if (!getUInt32FromBinary(length, cursor, end) || (static_cast<size_t>(end - cursor) < length)) {
+			return false;
+		}
+		value.assign(cursor, length);
+		cursor += length;
+		return true;
+	}
+
+	inline static bool getIdFromBinary(Id& id, const char*& cursor, const char* end) {
+		if (end - cursor < static_cast<int>(idSize)) {
+			return false;
+		}
+		memcpy(id.begin(), cursor, idSize);
+		cursor += idSize;
+		return true;
+	}
+
+	inline static bool getIdsFromBinary(vector<Id>& ids, const char*& cursor, const char* end) {
+		boost::uint32_t count;
+		if (!getUInt32FromBinary(count, cursor, end) || (static_cast<size_t>(end - cursor) / idSize < count)) {
+			return false;
+		}
+		ids.resize(count);
+		for (boost::uint32_t i = 0; i < count; ++i) {
+			getIdFromBinary(ids[i], cursor, end);
+		}
+		return true;
+	}
+
+	inline static bool getAttributesFromBinary(vector<Attribute>& attributes, const char*& cursor, const char* end) {
+		boost::uint32_t count;
+		if (!getUInt32FromBinary(count, cursor, end) || (static_cast<size_t>(end - cursor) / 8 < count)) { // at least two length fields per attribute
+			return false;
+		}
+		attributes.resize(count);
+		for (boost::uint32_t i = 0; i < count; ++i) {
+			if (!getStringFromBinary(attributes[i].key, cursor, end) || !getStringFromBinary(attributes[i].value, cursor, end)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	inline static bool getTimeStampFromBinary(TimeStamp& timeStamp, const char*& cursor, const char* end) {
+		double seconds;
+		if (!getDoubleFromBinary(seconds, cursor, end)) {
+			return false;
+		}
+		timeStamp = TimeStamp(seconds, Units::Second);
+		return true;
+	}
+
+	inline static bool getTransformFromBinary(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr& transform, const char*& cursor, const char* end) {
+		if (end - cursor < static_cast<int>(transformSize * 8)) {
+			return false;
+		}
+		transform = SceneGraphAllocator::createTransformMatrix(); // identity, so the last row is already set
+		double* matrix = transform->setRawData();
+		for (unsigned int i = 0; i < transformSize; ++i) {
+			matrix[transformIndices()[i]] = readDouble(cursor + i * 8);
+		}
+		cursor += transformSize * 8;
+		return true;
+	}
+
+	inline static bool getUncertaintyFromBinary(ITransformUncertainty::ITransformUncertaintyPtr& uncertainty, const char*& cursor, const char* end) {
+		boost::uint32_t dimension;
+		if (!getUInt32FromBinary(dimension, cursor, end)) {
+			return false;
+		}
+		CovarianceMatrix66::CovarianceMatrix66Ptr covariance(new CovarianceMatrix66());
+		if ((dimension != static_cast<boost::uint32_t>(covariance->getRowDimension() * covariance->getColumnDimension())) || (static_cast<size_t>(end - cursor) / 8 < dimension)) {
+			LOG(ERROR) << "BinaryTypecaster: Unsupported uncertainty dimension " << dimension;
+			return false;
+		}
+		double* matrix = covariance->setRawData();
+		for (boost::uint32_t i = 0; i < dimension; ++i) {
+			matrix[i] = readDouble(cursor + i * 8);
+		}
+		cursor += dimension * 8;
+		uncertainty = covariance;
+		return true;
+	}
+
+	inline static bool getShapeFromBinary(Shape::ShapePtr& shape, const char*& cursor, const char* end) {
+		boost::uint8_t type;
+		if (!getUInt8FromBinary(type, cursor, end)) {
+			return false;
+		}
+
+		double values[3];
+		switch (type) {
+		case Shape::Sphere:
+			if (!getDoubleFromBinary(values[0], cursor, end)) {
+				return false;
+			}
+			shape.reset(new rsg::Sphere(values[0]));
+			return true;
+
+		case Shape::Cylinder:
+			if (!getDoubleFromBinary(values[0], cursor, end) || !getDoubleFromBinary(values[1], cursor, end)) {
+				return false;
+			}
+			shape.reset(new rsg::Cylinder(values[0], values[1]));
+			return true;
+
+		case Shape::Box:
+			if (!getDoubleFromBinary(values[0], cursor, end) || !getDoubleFromBinary(values[1], cursor, end) || !getDoubleFromBinary(values[2], cursor, end)) {
+				return false;
+			}
+			shape.reset(new rsg::Box(values[0], values[1], values[2]));
+			return true;
+
+		case Shape::PointCloud: {
+			std::string pointCloudName;
+			boost::uint32_t numberOfPoints;
+			if (!getStringFromBinary(pointCloudName, cursor, end) || !getUInt32FromBinary(numberOfPoints, cursor, end)) {
+				return false;
+			}
+			if (pointCloudName.compare("brics_3d::PointCloud3D") != 0) {
+				LOG(WARNING) << "BinaryTypecaster: " << pointCloudName << " - this point cloud type cannot be deserialized.";
+				return false;
+			}
+			if (static_cast<size_t>(end - cursor) / 27 < numberOfPoints) {
+				return false;
+			}
+
+			brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr newPointCloudContainer(new brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>());
+			newPointCloudContainer->data = brics_3d::PointCloud3D::PointCloud3DPtr(new brics_3d::PointCloud3D());
+			for (boost::uint32_t i = 0; i < numberOfPoints; ++i) {
+				Point3D* tmpPoint = new Point3D(readDouble(cursor), readDouble(cursor + 8), readDouble(cursor + 16));
+				ColoredPoint3D* tmpColoredPoint = new ColoredPoint3D(tmpPoint, //optional decoration layer
+						static_cast<unsigned char>(cursor[24]),
+						static_cast<unsigned char>(cursor[25]),
+						static_cast<unsigned char>(cursor[26]));
+				newPointCloudContainer->data->addPointPtr(tmpColoredPoint);
+				cursor += 27;
+			}
+			shape = newPointCloudContainer;
+			return true;
+		}
+
+		default:
+			LOG(WARNING) << "BinaryTypecaster: Unknown or unsupported shape type " << static_cast<int>(type);
+			return false;
+		}
+	}
+
+	/* Little endian conversion of single values. These are also used by other typecasters. */
+
+	inline static void writeUInt32(boost::uint32_t value, char* data) {
+		data[0] = static_cast<char>(value);
+		data[1] = static_cast<char>(value >> 8);
+		data[2] = static_cast<char>(value >> 16);
+		data[3] = static_cast<char>(value >> 24);
+	}
+
+	inline static boost::uint32_t readUInt32(const char* data) {
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+		return static_cast<boost::uint32_t>(bytes[0]) |
+			   (static_cast<boost::uint32_t>(bytes[1]) << 8) |
+			   (static_cast<boost::uint32_t>(bytes[2]) << 16) |
+			   (static_cast<boost::uint32_t>(bytes[3]) << 24);
+	}
+
+	inline static void writeDouble(double value, char* data) {
+		boost::uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		for (int i = 0; i < 8; ++i) {
+			data[i] = static_cast<char>(bits >> (8 * i));
+		}
+	}
+
+	inline static double readDouble(const char* data) {
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+		boost::uint64_t bits = 0;
+		for (int i = 7; i >= 0; --i) {
+			bits = (bits << 8) | bytes[i];
+		}
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	inline static void writeFloat(float value, char* data) {
+		boost::uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		writeUInt32(bits, data);
+	}
+
+	inline static float readFloat(const char* data) {
+		boost::uint32_t bits = readUInt32(data);
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+private:
+
+	/// Indices of the transmitted elements of the column-major 4x4 matrix.
+	inline static const unsigned int* transformIndices() {
+		static const unsigned int indices[transformSize] = {0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14};
+		return indices;
+	}
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_BINARYTYPECASTER_H_ */
+
+/* EOF */
@@ -34,7 +34,10 @@
 #include "brics_3d/worldModel/sceneGraph/Cylinder.h"
 #include "brics_3d/worldModel/sceneGraph/PointCloud.h"
 #include "brics_3d/worldModel/sceneGraph/Mesh.h"
+#include "brics_3d/worldModel/sceneGraph/TransformStreamCodec.h"
 #include "brics_3d/core/ColoredPoint3D.h"
+#include <vector>
+#include <algorithm>
 
 /* Constants to serve as common agreement in the HDF5 encoding to
  * form kind of a "protocol".
@@ -48,6 +51,8 @@
 #define rsgPointCloudTypeInfoName "PointCloudTypeInfo"
 #define rsgTransformName "Transform"
 #define rsgTimeStampName "TimeStamp"
+#define rsgTransformStreamKeyframeName "TransformStreamKeyframe"
+#define rsgTransformStreamDeltaName "TransformStreamDelta"
 
 //#define HDF_1_8_12_OR_HIGHER
 
@@ -151,6 +156,18 @@ public:
 		double matrixData[matrixElements];
 	} transform_data_t;
 
+	/* Compound data types for the samples of a TransformStreamEncoder */
+	typedef struct transform_stream_keyframe_t {
+		unsigned int sequence;
+		double timeStamp;
+		double matrixData[matrixElements];
+	} transform_stream_keyframe_t;
+
+	typedef struct transform_stream_delta_t {
+		unsigned int sequence;
+		float delta[TransformStreamSample::deltaElements];
+	} transform_stream_delta_t;
+
 	/* Compound data type for XYZ point cloud */
 	typedef struct point_cloud_xyz_data_t {
 		double x;
@@ -168,6 +185,65 @@ public:
 		unsigned char b;
 	} point_cloud_xyzrgb_data_t;
 
+	/**
+	 * @brief Options for storing point clouds.
+	 *
+	 * Point clouds are written in chunks through a buffer of chunkSize points, so
+	 * the memory consumption does not depend on the size of the point cloud.
+	 */
+	struct PointCloudStorageOptions {
+		PointCloudStorageOptions() :
+			chunkSize(4096),
+			compressionLevel(0),
+			useShuffle(false),
+			useSinglePrecision(false) {
+		}
+
+		/// Number of points per HDF5 chunk. This is also the size of the intermediate buffer.
+		hsize_t chunkSize;
+
+		/// Deflate (gzip) level from 1 to 9. 0 disables compression.
+		int compressionLevel;
+
+		/// Apply the shuffle filter before compression. This improves the compression ratio for floating point values.
+		bool useShuffle;
+
+		/// Store the coordinates as float instead of double values.
+		bool useSinglePrecision;
+	};
+
+	/*
+	 * Tables of the update table log format (see HDF5AppendOnlyLogger::UPDATE_TABLES).
+	 */
+	enum RsgLogTable {
+		LOG_MESSAGES_TABLE,	// byte stream of BinaryTypecaster messages
+		LOG_TRANSFORMS_TABLE	// rows of log_transform_entry_t
+	};
+
+	/* Compound data type for a row in the index of an update table log. */
+	typedef struct log_index_entry_t {
+		double logStamp;				// time when the update was logged
+		int command;					// BinaryTypecaster::CommandType
+		int table;						// RsgLogTable
+		unsigned long long offset;		// byte offset in the messages table or row in the transforms table
+		unsigned int length;			// message length in bytes, 1 for transforms
+	} log_index_entry_t;
+
+	/* Compound data type for a row in the keyframes table of an update table log. */
+	typedef struct log_keyframe_entry_t {
+		double logStamp;				// time when the keyframe was taken
+		unsigned long long indexRow;	// number of updates in the index that are contained in the keyframe
+		unsigned long long offset;		// byte offset of the UPDATE_BATCH message in the messages table
+		unsigned int length;			// message length in bytes
+	} log_keyframe_entry_t;
+
+	/* Compound data type for a row in the transforms table of an update table log. */
+	typedef struct log_transform_entry_t {
+		unsigned char id[16];
+		double timeStamp;
+		double matrixData[matrixElements];
+	} log_transform_entry_t;
+
 	HDF5Typecaster(){};
 	virtual ~HDF5Typecaster(){};
 
@@ -327,7 +403,7 @@ public:
 		return true;
 	}
 
-	inline static bool addShapeToHDF5Group(brics_3d::rsg::Shape::ShapePtr shape, H5::Group& group) {
+	inline static bool addShapeToHDF5Group(brics_3d::rsg::Shape::ShapePtr shape, H5::Group& group, const PointCloudStorageOptions& options = PointCloudStorageOptions()) {
 		LOG(DEBUG) << "convertShapeToHDF5DataSet: ";
 		RsgShapeTypeInfo type;
 		H5::DataSet rsgShapeDataset;
@@ -395,62 +471,8 @@ public:
 			LOG(DEBUG) << "                 -> Found a point cloud.";
 			type = POINT_CLOUD;
 
-			/* HDF5 meta data: we treate a single row as a compund data type */
-			const H5std_string MEMBER1( "x" );
-			const H5std_string MEMBER2( "y" );
-			const H5std_string MEMBER3( "z" );
-			const H5std_string MEMBER4( "r" );
-			const H5std_string MEMBER5( "g" );
-			const H5std_string MEMBER6( "b" );
-
-			/* as there is no zize method in the iterator we have to loop ofer it a priori */
-			int numberOfPoints = 0;
 			IPoint3DIterator::IPoint3DIteratorPtr it = shape->getPointCloudIterator();
-			for (it->begin(); !it->end(); it->next()) {
-				numberOfPoints++;
-			}
-			LOG(DEBUG) << "numberOfPoints = " << numberOfPoints;
-
-			hsize_t rsgPointCloutDimensions[pointCloudDataRank]; // on dim (array)
-			rsgPointCloutDimensions[0] = numberOfPoints; // number of nD point in point cloud gies here
-			H5::DataSpace rsgPointDataSpace(pointCloudDataRank, rsgPointCloutDimensions);
-			H5::CompType rsgPointCloudDataType(sizeof(point_cloud_xyzrgb_data_t));
-			rsgPointCloudDataType.insertMember(MEMBER1, HOFFSET(point_cloud_xyzrgb_data_t, x), H5::PredType::NATIVE_DOUBLE);
-			rsgPointCloudDataType.insertMember(MEMBER2, HOFFSET(point_cloud_xyzrgb_data_t, y), H5::PredType::NATIVE_DOUBLE);
-			rsgPointCloudDataType.insertMember(MEMBER3, HOFFSET(point_cloud_xyzrgb_data_t, z), H5::PredType::NATIVE_DOUBLE);
-			rsgPointCloudDataType.insertMember(MEMBER4, HOFFSET(point_cloud_xyzrgb_data_t, r), H5::PredType::NATIVE_UCHAR);
-			rsgPointCloudDataType.insertMember(MEMBER5, HOFFSET(point_cloud_xyzrgb_data_t, g), H5::PredType::NATIVE_UCHAR);
-			rsgPointCloudDataType.insertMember(MEMBER6, HOFFSET(point_cloud_xyzrgb_data_t, b), H5::PredType::NATIVE_UCHAR);
-
-
-			/* Prepare actual data */
-			point_cloud_xyzrgb_data_t points[numberOfPoints]; // raw version of point cloud
-			int i = 0;
-			for (it->begin(); !it->end(); it->next()) {
-				points[i].x = it->getX();
-				points[i].y = it->getY();
-				points[i].z = it->getZ();
-
-
-				if(it->getRawData()->asColoredPoint3D() != 0) {
-					points[i].r = it->getRawData()->asColoredPoint3D()->getR();
-					points[i].g = it->getRawData()->asColoredPoint3D()->getG();
-					points[i].b = it->getRawData()->asColoredPoint3D()->getB();
-				} else {
-					points[i].r = 0x00;
-					points[i].g = 0x00;
-					points[i].b = 0x00;
-				}
-
-				i++;
-				if (i >= numberOfPoints) { // early termination (just in case)
-					break;
-				}
-			}
-
-			/* Write out data */
-			rsgShapeDataset = group.createDataSet(rsgShapeName, rsgPointCloudDataType, rsgPointDataSpace);
-			rsgShapeDataset.write(&points, rsgPointCloudDataType);
+			rsgShapeDataset = addPointCloudToHDF5Group(it, group, options);
 
 			/* Attach an additional attribute indicating the underlying type of the point cloud (e.g. brics_3d::PointCloud3D) */
 			H5::StrType stringType(0, H5T_VARIABLE);
@@ -572,48 +594,35 @@ public:
 					/* Assign concrete type to container */
 					newPointCloudContainer->data=newPointCloud;
 
-					/* HDF5 meta data: we treate a single row as a compund data type */
-					const H5std_string MEMBER1( "x" );
-					const H5std_string MEMBER2( "y" );
-					const H5std_string MEMBER3( "z" );
-					const H5std_string MEMBER4( "r" );
-					const H5std_string MEMBER5( "g" );
-					const H5std_string MEMBER6( "b" );
-
-
-					/* Go through HDF5 meta-data */
-					int numberOfPoints = 0;
+					/* Read in blocks, the file type might be a single precision one */
 					H5::DataSpace rsgInferredPointDataSpace = rsgShapeDataset.getSpace();
-					numberOfPoints = rsgInferredPointDataSpace.getSimpleExtentNpoints();
-
-					H5::CompType rsgPointCloudDataType(sizeof(point_cloud_xyzrgb_data_t));
-					rsgPointCloudDataType.insertMember(MEMBER1, HOFFSET(point_cloud_xyzrgb_data_t, x), H5::PredType::NATIVE_DOUBLE);
-					rsgPointCloudDataType.insertMember(MEMBER2, HOFFSET(point_cloud_xyzrgb_data_t, y), H5::PredType::NATIVE_DOUBLE);
-					rsgPointCloudDataType.insertMember(MEMBER3, HOFFSET(point_cloud_xyzrgb_data_t, z), H5::PredType::NATIVE_DOUBLE);
-					rsgPointCloudDataType.insertMember(MEMBER4, HOFFSET(point_cloud_xyzrgb_data_t, r), H5::PredType::NATIVE_UCHAR);
-					rsgPointCloudDataType.insertMember(MEMBER5, HOFFSET(point_cloud_xyzrgb_data_t, g), H5::PredType::NATIVE_UCHAR);
-					rsgPointCloudDataType.insertMember(MEMBER6, HOFFSET(point_cloud_xyzrgb_data_t, b), H5::PredType::NATIVE_UCHAR);
-
-					/* Intermediate buffer for point cloud (TODO: remove this step) */
-					point_cloud_xyzrgb_data_t points[numberOfPoints]; // raw version of point cloud
-
-					/* Fill point cloud  with data */
+					hsize_t numberOfPoints = rsgInferredPointDataSpace.getSimpleExtentNpoints();
+					H5::CompType rsgPointCloudDataType = createPointCloudMemoryType();
 					LOG(DEBUG) << "                 Update contains " << numberOfPoints << " points.";
-					rsgShapeDataset.read(&points, rsgPointCloudDataType);
-
-					for (int i = 0; i < numberOfPoints; ++i) {
-
-						Point3D* tmpPoint =  new Point3D(
-								points[i].x,
-								points[i].y,
-								points[i].z);
 
-						ColoredPoint3D* tmpColoredPoint = new ColoredPoint3D(tmpPoint, //optional decoration layer
-								points[i].r,
-								points[i].g,
-								points[i].b);
-
-						newPointCloudContainer->data->addPointPtr(tmpColoredPoint);
+					const hsize_t blockSize = PointCloudStorageOptions().chunkSize;
+					std::vector<point_cloud_xyzrgb_data_t> points(static_cast<size_t>(std::min(blockSize, numberOfPoints)));
+					for (hsize_t offset = 0; offset < numberOfPoints; offset += blockSize) {
+						hsize_t count = std::min(blockSize, numberOfPoints - offset);
+						H5::DataSpace fileSpace = rsgShapeDataset.getSpace();
+						fileSpace.selectHyperslab(H5S_SELECT_SET, &count, &offset);
+						H5::DataSpace memorySpace(pointCloudDataRank, &count);
+						rsgShapeDataset.read(&points[0], rsgPointCloudDataType, memorySpace, fileSpace);
+
+						for (hsize_t i = 0; i < count; ++i) {
+
+							Point3D* tmpPoint =  new Point3D(
+									points[i].x,
+									points[i].y,
+									points[i].z);
+
+							ColoredPoint3D* tmpColoredPoint = new ColoredPoint3D(tmpPoint, //optional decoration layer
+									points[i].r,
+									points[i].g,
+									points[i].b);
+
+							newPointCloudContainer->data->addPointPtr(tmpColoredPoint);
+						}
 					}
 
 					shape = newPointCloudContainer;
@@ -633,6 +642,200 @@ public:
 		return true;
 	}
 
+	/// In-memory layout of a point: point_cloud_xyzrgb_data_t
+	inline static H5::CompType createPointCloudMemoryType() {
+		/* HDF5 meta data: we treate a single row as a compund data type */
+		H5::CompType rsgPointCloudDataType(sizeof(point_cloud_xyzrgb_data_t));
+		rsgPointCloudDataType.insertMember("x", HOFFSET(point_cloud_xyzrgb_data_t, x), H5::PredType::NATIVE_DOUBLE);
+		rsgPointCloudDataType.insertMember("y", HOFFSET(point_cloud_xyzrgb_data_t, y), H5::PredType::NATIVE_DOUBLE);
+		rsgPointCloudDataType.insertMember("z", HOFFSET(point_cloud_xyzrgb_data_t, z), H5::PredType::NATIVE_DOUBLE);
+		rsgPointCloudDataType.insertMember("r", HOFFSET(point_cloud_xyzrgb_data_t, r), H5::PredType::NATIVE_UCHAR);
+		rsgPointCloudDataType.insertMember("g", HOFFSET(point_cloud_xyzrgb_data_t, g), H5::PredType::NATIVE_UCHAR);
+		rsgPointCloudDataType.insertMember("b", HOFFSET(point_cloud_xyzrgb_data_t, b), H5::PredType::NATIVE_UCHAR);
+		return rsgPointCloudDataType;
+	}
+
+	/// Packed single precision layout of a point within a file. HDF5 converts from and to the memory type by member names.
+	inline static H5::CompType createPointCloudSinglePrecisionFileType() {
+		H5::CompType rsgPointCloudDataType(3 * sizeof(float) + 3);
+		rsgPointCloudDataType.insertMember("x", 0, H5::PredType::IEEE_F32LE);
+		rsgPointCloudDataType.insertMember("y", 4, H5::PredType::IEEE_F32LE);
+		rsgPointCloudDataType.insertMember("z", 8, H5::PredType::IEEE_F32LE);
+		rsgPointCloudDataType.insertMember("r", 12, H5::PredType::STD_U8LE);
+		rsgPointCloudDataType.insertMember("g", 13, H5::PredType::STD_U8LE);
+		rsgPointCloudDataType.insertMember("b", 14, H5::PredType::STD_U8LE);
+		return rsgPointCloudDataType;
+	}
+
+	/**
+	 * @brief Creation properties for a chunked, one dimensional data set that can be extended with appendToHDF5DataSet.
+	 * @param chunkSize Number of elements per chunk.
+	 * @param compressionLevel Deflate level from 1 to 9. 0 disables compression.
+	 * @param useShuffle Apply the shuffle filter before compression.
+	 */
+	inline static H5::DSetCreatPropList createChunkedDataSetProperties(hsize_t chunkSize, int compressionLevel = 0, bool useShuffle = false) {
+		H5::DSetCreatPropList properties;
+		properties.setChunk(1, &chunkSize);
+		if (compressionLevel > 0) {
+			if (H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0) {
+				if (useShuffle) {
+					properties.setShuffle();
+				}
+				properties.setDeflate(std::min(compressionLevel, 9));
+			} else {
+				LOG(WARNING) << "HDF5Typecaster: deflate filter is not available. Storing data uncompressed.";
+			}
+		}
+		return properties;
+	}
+
+	/// Create an empty, extendible and chunked one dimensional data set.
+	inline static H5::DataSet createExtendibleHDF5DataSet(std::string name, const H5::DataType& fileType, const H5::DSetCreatPropList& properties, H5::Group& group) {
+		hsize_t initialDimensions[1] = {0};
+		hsize_t maxDimensions[1] = {H5S_UNLIMITED};
+		H5::DataSpace dataSpace(1, initialDimensions, maxDimensions);
+		return group.createDataSet(name, fileType, dataSpace, properties);
+	}
+
+	/**
+	 * @brief Append elements to a one dimensional, extendible data set.
+	 * @param data Elements to be written in memory layout memoryType.
+	 * @param count Number of elements.
+	 * @param memoryType HDF5 type of a single element.
+	 * @param currentSize Number of elements already stored in the data set.
+	 * @param dataSet The data set to be extended.
+	 * @return The new number of elements.
+	 */
+	inline static hsize_t appendToHDF5DataSet(const void* data, hsize_t count, const H5::DataType& memoryType, hsize_t currentSize, H5::DataSet& dataSet) {
+		if (count == 0) {
+			return currentSize;
+		}
+		hsize_t newSize = currentSize + count;
+		dataSet.extend(&newSize);
+		H5::DataSpace fileSpace = dataSet.getSpace();
+		fileSpace.selectHyperslab(H5S_SELECT_SET, &count, &currentSize);
+		H5::DataSpace memorySpace(1, &count);
+		dataSet.write(data, memoryType, memorySpace, fileSpace);
+		return newSize;
+	}
+
+	/**
+	 * @brief Read a range of elements of a one dimensional data set.
+	 * @param data Preallocated memory for count elements in memory layout memoryType.
+	 */
+	inline static void readFromHDF5DataSet(void* data, hsize_t count, const H5::DataType& memoryType, hsize_t offset, const H5::DataSet& dataSet) {
+		if (count == 0) {
+			return;
+		}
+		H5::DataSpace fileSpace = dataSet.getSpace();
+		fileSpace.selectHyperslab(H5S_SELECT_SET, &count, &offset);
+		H5::DataSpace memorySpace(1, &count);
+		dataSet.read(data, memoryType, memorySpace, fileSpace);
+	}
+
+	/// HDF5 type for a log_index_entry_t.
+	inline static H5::CompType createLogIndexType() {
+		H5::CompType logIndexType(sizeof(log_index_entry_t));
+		logIndexType.insertMember("logStamp", HOFFSET(log_index_entry_t, logStamp), H5::PredType::NATIVE_DOUBLE);
+		logIndexType.insertMember("command", HOFFSET(log_index_entry_t, command), H5::PredType::NATIVE_INT);
+		logIndexType.insertMember("table", HOFFSET(log_index_entry_t, table), H5::PredType::NATIVE_INT);
+		logIndexType.insertMember("offset", HOFFSET(log_index_entry_t, offset), H5::PredType::NATIVE_ULLONG);
+		logIndexType.insertMember("length", HOFFSET(log_index_entry_t, length), H5::PredType::NATIVE_UINT);
+		return logIndexType;
+	}
+
+	/// HDF5 type for a log_keyframe_entry_t.
+	inline static H5::CompType createLogKeyframeType() {
+		H5::CompType logKeyframeType(sizeof(log_keyframe_entry_t));
+		logKeyframeType.insertMember("logStamp", HOFFSET(log_keyframe_entry_t, logStamp), H5::PredType::NATIVE_DOUBLE);
+		logKeyframeType.insertMember("indexRow", HOFFSET(log_keyframe_entry_t, indexRow), H5::PredType::NATIVE_ULLONG);
+		logKeyframeType.insertMember("offset", HOFFSET(log_keyframe_entry_t, offset), H5::PredType::NATIVE_ULLONG);
+		logKeyframeType.insertMember("length", HOFFSET(log_keyframe_entry_t, length), H5::PredType::NATIVE_UINT);
+		return logKeyframeType;
+	}
+
+	/// HDF5 type for a log_transform_entry_t.
+	inline static H5::CompType createLogTransformType() {
+		hsize_t idDimensions[1] = {16};
+		H5::ArrayType idType(H5::PredType::NATIVE_UCHAR, 1, idDimensions);
+		hsize_t matrixDimensions[1] = {matrixElements};
+		H5::ArrayType matrixType(H5::PredType::NATIVE_DOUBLE, 1, matrixDimensions);
+
+		H5::CompType logTransformType(sizeof(log_transform_entry_t));
+		logTransformType.insertMember("id", HOFFSET(log_transform_entry_t, id), idType);
+		logTransformType.insertMember("timeStamp", HOFFSET(log_transform_entry_t, timeStamp), H5::PredType::NATIVE_DOUBLE);
+		logTransformType.insertMember("matrixData", HOFFSET(log_transform_entry_t, matrixData), matrixType);
+		return logTransformType;
+	}
+
+
+	/**
+	 * @brief Stream a point cloud into a chunked, extensible "Shape" data set.
+	 *
+	 * The iterator is traversed only once. Full buffers of options.chunkSize points
+	 * are appended to the data set, so arbitrary large point clouds can be stored.
+	 * Point clouds with less than options.chunkSize points are stored in a single chunk of their size.
+	 *
+	 * @return The created data set.
+	 */
+	inline static H5::DataSet addPointCloudToHDF5Group(IPoint3DIterator::IPoint3DIteratorPtr it, H5::Group& group, const PointCloudStorageOptions& options = PointCloudStorageOptions()) {
+		hsize_t chunkSize = (options.chunkSize > 0) ? options.chunkSize : PointCloudStorageOptions().chunkSize;
+		H5::CompType memoryType = createPointCloudMemoryType();
+		H5::DataSet rsgShapeDataset;
+		bool isCreated = false;
+
+		std::vector<point_cloud_xyzrgb_data_t> buffer(static_cast<size_t>(chunkSize));
+		hsize_t numberOfPoints = 0;
+		hsize_t bufferedPoints = 0;
+		for (it->begin(); ; it->next()) {
+			bool isDone = it->end();
+			if (!isDone) {
+				point_cloud_xyzrgb_data_t& point = buffer[static_cast<size_t>(bufferedPoints)];
+				point.x = it->getX();
+				point.y = it->getY();
+				point.z = it->getZ();
+				ColoredPoint3D* coloredPoint = it->getRawData()->asColoredPoint3D();
+				if(coloredPoint != 0) {
+					point.r = coloredPoint->getR();
+					point.g = coloredPoint->getG();
+					point.b = coloredPoint->getB();
+				} else {
+					point.r = 0x00;
+					point.g = 0x00;
+					point.b = 0x00;
+				}
+				bufferedPoints++;
+			}
+
+			/*
+			 * The data set is created on the first flush. A point cloud that is smaller than one
+			 * buffer then gets a chunk of its own size rather than a mostly empty full chunk.
+			 */
+			if (!isCreated && ((bufferedPoints == chunkSize) || isDone)) {
+				hsize_t dataSetChunkSize = std::max(bufferedPoints, static_cast<hsize_t>(1));
+				H5::DSetCreatPropList properties = createChunkedDataSetProperties(dataSetChunkSize, options.compressionLevel, options.useShuffle);
+				if (options.useSinglePrecision) {
+					rsgShapeDataset = createExtendibleHDF5DataSet(rsgShapeName, createPointCloudSinglePrecisionFileType(), properties, group);
+				} else {
+					rsgShapeDataset = createExtendibleHDF5DataSet(rsgShapeName, memoryType, properties, group);
+				}
+				isCreated = true;
+			}
+
+			if ((bufferedPoints == chunkSize) || (isDone && bufferedPoints > 0)) { // flush
+				numberOfPoints = appendToHDF5DataSet(&buffer[0], bufferedPoints, memoryType, numberOfPoints, rsgShapeDataset);
+				bufferedPoints = 0;
+			}
+
+			if (isDone) {
+				break;
+			}
+		}
+		LOG(DEBUG) << "HDF5Typecaster: numberOfPoints = " << numberOfPoints;
+
+		return rsgShapeDataset;
+	}
+
 	inline static bool addTransformToHDF5Group(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp, H5::Group& group) {
 		int numberOfTransforms = 1;
 
@@ -707,6 +910,87 @@ public:
 		return true;
 	}
 
+	/**
+	 * Add a sample of a TransformStreamEncoder. It is stored as a single data set instead of the
+	 * transform data set: a keyframe holds sequence, time stamp and matrix, a delta holds sequence and delta.
+	 */
+	inline static bool addTransformStreamSampleToHDF5Group(const TransformStreamSample& sample, H5::Group& group) {
+		H5::DataSpace rsgSampleSpace(H5S_SCALAR);
+		try {
+			if (sample.isKeyframe) {
+				transform_stream_keyframe_t keyframe;
+				keyframe.sequence = sample.sequence;
+				keyframe.timeStamp = sample.timeStamp;
+				memcpy(keyframe.matrixData, sample.matrixData, sizeof(double)*matrixElements);
+				H5::CompType rsgKeyframeType = createTransformStreamKeyframeType();
+				H5::DataSet rsgKeyframeDataset = group.createDataSet(rsgTransformStreamKeyframeName, rsgKeyframeType, rsgSampleSpace);
+				rsgKeyframeDataset.write(&keyframe, rsgKeyframeType);
+			} else {
+				transform_stream_delta_t delta;
+				delta.sequence = sample.sequence;
+				memcpy(delta.delta, sample.delta, sizeof(delta.delta));
+				H5::CompType rsgDeltaType = createTransformStreamDeltaType();
+				H5::DataSet rsgDeltaDataset = group.createDataSet(rsgTransformStreamDeltaName, rsgDeltaType, rsgSampleSpace);
+				rsgDeltaDataset.write(&delta, rsgDeltaType);
+			}
+		} catch (H5::Exception e) {
+			LOG(ERROR) << "Cannot add transform stream data set to HDF5 group.";
+			return false;
+		}
+
+		return true;
+	}
+
+	/// Get a sample of a TransformStreamEncoder. Returns false if the group does not contain one.
+	inline static bool getTransformStreamSampleFromHDF5Group(TransformStreamSample& sample, H5::Group& group) {
+		try {
+			if (H5Lexists(group.getId(), rsgTransformStreamKeyframeName, H5P_DEFAULT) > 0) {
+				transform_stream_keyframe_t keyframe;
+				group.openDataSet(rsgTransformStreamKeyframeName).read(&keyframe, createTransformStreamKeyframeType());
+				sample.isKeyframe = true;
+				sample.sequence = keyframe.sequence;
+				sample.timeStamp = keyframe.timeStamp;
+				memcpy(sample.matrixData, keyframe.matrixData, sizeof(double)*matrixElements);
+			} else if (H5Lexists(group.getId(), rsgTransformStreamDeltaName, H5P_DEFAULT) > 0) {
+				transform_stream_delta_t delta;
+				group.openDataSet(rsgTransformStreamDeltaName).read(&delta, createTransformStreamDeltaType());
+				sample.isKeyframe = false;
+				sample.sequence = delta.sequence;
+				memcpy(sample.delta, delta.delta, sizeof(delta.delta));
+			} else {
+				return false;
+			}
+		} catch (H5::Exception e) {
+			LOG(ERROR) << "Cannot retrieve transform stream data from HDF5 group.";
+			return false;
+		}
+
+		return true;
+	}
+
+	inline static H5::CompType createTransformStreamKeyframeType() {
+		hsize_t rsgMatrixDataDimensions[1];
+		rsgMatrixDataDimensions[0] = matrixElements;
+		H5::ArrayType rsgMatrixDataType(H5::PredType::NATIVE_DOUBLE, 1, rsgMatrixDataDimensions);
+
+		H5::CompType type(sizeof(transform_stream_keyframe_t));
+		type.insertMember("sequence", HOFFSET(transform_stream_keyframe_t, sequence), H5::PredType::NATIVE_UINT);
+		type.insertMember("timeStamp", HOFFSET(transform_stream_keyframe_t, timeStamp), H5::PredType::NATIVE_DOUBLE);
+		type.insertMember("matrixData", HOFFSET(transform_stream_keyframe_t, matrixData), rsgMatrixDataType);
+		return type;
+	}
+
+	inline static H5::CompType createTransformStreamDeltaType() {
+		hsize_t rsgDeltaDimensions[1];
+		rsgDeltaDimensions[0] = TransformStreamSample::deltaElements;
+		H5::ArrayType rsgDeltaDataType(H5::PredType::NATIVE_FLOAT, 1, rsgDeltaDimensions);
+
+		H5::CompType type(sizeof(transform_stream_delta_t));
+		type.insertMember("sequence", HOFFSET(transform_stream_delta_t, sequence), H5::PredType::NATIVE_UINT);
+		type.insertMember("delta", HOFFSET(transform_stream_delta_t, delta), rsgDeltaDataType);
+		return type;
+	}
+
 	inline static bool addTimeStampToHDF5Group(brics_3d::rsg::TimeStamp timeStamp, H5::Group& group, std::string timeStampName = rsgTimeStampName) {
 		H5::IntType rsgTimeStampType( H5::PredType::NATIVE_DOUBLE);
 		H5::DataSpace rsgTimeStampSpace(H5S_SCALAR);
@@ -25,6 +25,10 @@
 #include "brics_3d/core/ColoredPoint3D.h"
 #include "brics_3d/core/TriangleMeshImplicit.h"
 #include "brics_3d/worldModel/WorldModel.h"
+#include "brics_3d/worldModel/sceneGraph/SceneGraphAllocator.h"
+#include "brics_3d/worldModel/sceneGraph/TransformStreamCodec.h"
+#include "brics_3d/worldModel/sceneGraph/MerkleSynchronizer.h"
+#include "brics_3d/util/BinaryTypecaster.h"
 #include <Variant/Variant.h>
 #include <Variant/SchemaLoader.h>
 
@@ -46,6 +50,9 @@ namespace rsg {
 class JSONTypecaster {
 public:
 
+	/// Point clouds with at least this number of points are encoded as binary blob by default.
+	static const unsigned int defaultPointCloudBinaryBlobThreshold = 1000;
+
 	inline static bool stringToJSON(string modelAsString, libvariant::Variant& model) {
 		try {
 			model = libvariant:: Deserialize(modelAsString, libvariant::SERIALIZE_GUESS); // GUESS seems to be more permissive with parsing than JSON
@@ -301,7 +308,8 @@ public:
 							      * r3 r4 r5
 							      * r6 r7 r8
 							      */
-								HomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44(
+								HomogeneousMatrix44::IHomogeneousMatrix44Ptr transform = rsg::SceneGraphAllocator::createTransformMatrix(); // pooled as it goes to a history
+								*transform = HomogeneousMatrix44(
 										// rotation
 										transformModel.Get("matrix").At(0).At(0).AsDouble(),
 										transformModel.Get("matrix").At(0).At(1).AsDouble(),
@@ -318,7 +326,7 @@ public:
 										transformModel.Get("matrix").At(0).At(3).AsDouble(),
 										transformModel.Get("matrix").At(1).At(3).AsDouble(),
 										transformModel.Get("matrix").At(2).At(3).AsDouble()
-								));
+								);
 
 								LOG(DEBUG) << "transform data = " << *transform;
 								history.insertData(transform, stamp);
@@ -396,6 +404,21 @@ public:
 		return true;
 	}
 
+	/// Get a point that is stored as {"x": ..., "y": ..., "z": ...}. False if it is missing or incomplete.
+	inline static bool getPointFromJSON(libvariant::Variant& node, string pointTag, Point3D& point) {
+		if(!node.Contains(pointTag)) {
+			LOG(WARNING) << "JSONTypecaster: No point " << pointTag << " specified.";
+			return false;
+		}
+		libvariant::Variant pointModel = node.Get(pointTag);
+		if(!pointModel.Contains("x") || !pointModel.Contains("y") || !pointModel.Contains("z")) {
+			LOG(ERROR) << "JSONTypecaster: Coordinates of point " << pointTag << " are missing.";
+			return false;
+		}
+		point = Point3D(pointModel.Get("x").AsDouble(), pointModel.Get("y").AsDouble(), pointModel.Get("z").AsDouble());
+		return true;
+	}
+
 	inline static bool addTransformToJSON(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr& transform, libvariant::Variant& node, std::string transformTag) {
 
 		/* transform data */
@@ -444,12 +467,210 @@ public:
 		return true;
 	}
 
+	/**
+	 * Add a sample of a TransformStreamEncoder to a node. The values are packed little endian and base64 encoded,
+	 * so keyframes are reconstructed exactly:
+	 * @code
+	 * "transformStream": {
+	 *   "sequence": 42,
+	 *   "keyframe": "AAAAAAAA8D8AAAAA..." // 16 matrix values (column-major) and the time stamp in seconds as float64
+	 * }
+	 * @endcode
+	 * A delta sample has a "delta" entry instead, that holds qx, qy, qz, qw, x, y, z and the time stamp difference as float32.
+	 */
+	inline static bool addTransformStreamSampleToJSON(const TransformStreamSample& sample, libvariant::Variant& node, std::string streamTag = "transformStream") {
+		libvariant::Variant streamModel;
+		streamModel.Set("sequence", libvariant::Variant(static_cast<unsigned int>(sample.sequence)));
+
+		std::vector<char> blob;
+		std::string encodedBlob;
+		if (sample.isKeyframe) {
+			blob.resize(17 * sizeof(double));
+			for (int i = 0; i < 16; ++i) {
+				BinaryTypecaster::writeDouble(sample.matrixData[i], &blob[i * sizeof(double)]);
+			}
+			BinaryTypecaster::writeDouble(sample.timeStamp, &blob[16 * sizeof(double)]);
+			encodeBase64(blob, encodedBlob);
+			streamModel.Set("keyframe", libvariant::Variant(encodedBlob));
+		} else {
+			blob.resize(TransformStreamSample::deltaElements * sizeof(float));
+			for (unsigned int i = 0; i < TransformStreamSample::deltaElements; ++i) {
+				BinaryTypecaster::writeFloat(sample.delta[i], &blob[i * sizeof(float)]);
+			}
+			encodeBase64(blob, encodedBlob);
+			streamModel.Set("delta", libvariant::Variant(encodedBlob));
+		}
+
+		node.Set(streamTag, streamModel);
+		return true;
+	}
+
+	/// Get a sample of a TransformStreamEncoder. Returns false if the node has no (valid) stream sample.
+	inline static bool getTransformStreamSampleFromJSON(TransformStreamSample& sample, libvariant::Variant& node, std::string streamTag = "transformStream") {
+		if (!node.Contains(streamTag)) {
+			return false;
+		}
+		libvariant::Variant streamModel = node.Get(streamTag);
+		if (!streamModel.Contains("sequence")) { LOG(ERROR) << "JSONTypecaster: Transform stream sample has no sequence tag."; return false;};
+		sample.sequence = static_cast<boost::uint32_t>(streamModel.Get("sequence").AsUnsigned());
+
+		if (streamModel.Contains("keyframe")) {
+			if (!decodeTransformStreamSample(streamModel.Get("keyframe").AsString(), true, sample)) {
+				LOG(ERROR) << "JSONTypecaster: Transform stream keyframe is not valid.";
+				return false;
+			}
+		} else if (streamModel.Contains("delta")) {
+			if (!decodeTransformStreamSample(streamModel.Get("delta").AsString(), false, sample)) {
+				LOG(ERROR) << "JSONTypecaster: Transform stream delta is not valid.";
+				return false;
+			}
+		} else {
+			LOG(ERROR) << "JSONTypecaster: Transform stream sample has neither a keyframe nor a delta.";
+			return false;
+		}
+
+		return true;
+	}
+
+	/// Decode the base64 "keyframe" or "delta" entry of a transform stream sample (cf. addTransformStreamSampleToJSON).
+	inline static bool decodeTransformStreamSample(const std::string& encodedBlob, bool isKeyframe, TransformStreamSample& sample) {
+		std::vector<char> blob;
+		if (!decodeBase64(encodedBlob, blob)) {
+			return false;
+		}
+
+		if (isKeyframe) {
+			if (blob.size() != 17 * sizeof(double)) {
+				return false;
+			}
+			for (int i = 0; i < 16; ++i) {
+				sample.matrixData[i] = BinaryTypecaster::readDouble(&blob[i * sizeof(double)]);
+			}
+			sample.timeStamp = BinaryTypecaster::readDouble(&blob[16 * sizeof(double)]);
+		} else {
+			if (blob.size() != TransformStreamSample::deltaElements * sizeof(float)) {
+				return false;
+			}
+			for (unsigned int i = 0; i < TransformStreamSample::deltaElements; ++i) {
+				sample.delta[i] = BinaryTypecaster::readFloat(&blob[i * sizeof(float)]);
+			}
+		}
+		sample.isKeyframe = isKeyframe;
+
+		return true;
+	}
+
+	/**
+	 * @brief Add a request of a MerkleSynchronizer replica.
+	 *
+	 * @code
+	 * "expandIds": ["<id>", ...], "refreshIds": ["<id>", ...], "subtrees": [{"id": "<id>", "parentId": "<id>"}, ...]
+	 * @endcode
+	 */
+	inline static bool addSyncRequestToJSON(const rsg::MerkleSynchronizer::SyncRequest& request, libvariant::Variant& node) {
+		vector<rsg::Id> ids = request.expandIds;
+		addIdsToJSON(ids, node, "expandIds");
+		ids = request.refreshIds;
+		addIdsToJSON(ids, node, "refreshIds");
+
+		libvariant::Variant subtrees(libvariant::VariantDefines::ListType);
+		for (unsigned int i = 0; i < request.subtreeIds.size() && i < request.subtreeParentIds.size(); ++i) {
+			libvariant::Variant subtree;
+			addIdToJSON(request.subtreeIds[i], subtree, "id");
+			addIdToJSON(request.subtreeParentIds[i], subtree, "parentId");
+			subtrees.Append(subtree);
+		}
+		node.Set("subtrees", subtrees);
+
+		return true;
+	}
+
+	inline static bool getSyncRequestFromJSON(rsg::MerkleSynchronizer::SyncRequest& request, libvariant::Variant& node) {
+		request.clear();
+		if (node.Contains("expandIds")) {
+			request.expandIds = getIdsFromJSON(node, "expandIds");
+		}
+		if (node.Contains("refreshIds")) {
+			request.refreshIds = getIdsFromJSON(node, "refreshIds");
+		}
+		if (node.Contains("subtrees")) {
+			libvariant::Variant subtrees = node.Get("subtrees");
+			if (!subtrees.IsList()) {
+				LOG(ERROR) << "JSONTypecaster: subtrees of a synchronization request is not a list.";
+				return false;
+			}
+			for (libvariant::Variant::ListIterator i(subtrees.ListBegin()), e(subtrees.ListEnd()); i!=e; ++i) {
+				rsg::Id id = getIdFromJSON(*i, "id");
+				rsg::Id parentId = getIdFromJSON(*i, "parentId");
+				if (id.isNil() || parentId.isNil()) {
+					return false;
+				}
+				request.subtreeIds.push_back(id);
+				request.subtreeParentIds.push_back(parentId);
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Add the digests of a MerkleSynchronizer source.
+	 *
+	 * @code
+	 * "digests": [{"id": "<id>", "nodeHash": "<hash>", "subtreeHash": "<hash>", "childs": [{"id": "<id>", "hash": "<hash>"}, ...]}, ...]
+	 * @endcode
+	 */
+	inline static bool addSubtreeDigestsToJSON(const std::vector<rsg::MerkleSynchronizer::SubtreeDigest>& digests, libvariant::Variant& node, string digestsTag = "digests") {
+		libvariant::Variant digestsModel(libvariant::VariantDefines::ListType);
+		for (std::vector<rsg::MerkleSynchronizer::SubtreeDigest>::const_iterator it = digests.begin(); it != digests.end(); ++it) {
+			libvariant::Variant digestModel;
+			addIdToJSON(it->id, digestModel, "id");
+			digestModel.Set("nodeHash", libvariant::Variant(it->nodeHash));
+			digestModel.Set("subtreeHash", libvariant::Variant(it->subtreeHash));
+			libvariant::Variant childs(libvariant::VariantDefines::ListType);
+			for (unsigned int i = 0; i < it->childIds.size() && i < it->childHashes.size(); ++i) {
+				libvariant::Variant child;
+				addIdToJSON(it->childIds[i], child, "id");
+				child.Set("hash", libvariant::Variant(it->childHashes[i]));
+				childs.Append(child);
+			}
+			digestModel.Set("childs", childs);
+			digestsModel.Append(digestModel);
+		}
+		node.Set(digestsTag, digestsModel);
+		return true;
+	}
+
+	inline static bool getSubtreeDigestsFromJSON(std::vector<rsg::MerkleSynchronizer::SubtreeDigest>& digests, libvariant::Variant& node, string digestsTag = "digests") {
+		if (!node.Contains(digestsTag) || !node.Get(digestsTag).IsList()) {
+			LOG(ERROR) << "JSONTypecaster: No list of digests with tag " << digestsTag << " specified.";
+			return false;
+		}
+		libvariant::Variant digestsModel = node.Get(digestsTag);
+		for (libvariant::Variant::ListIterator i(digestsModel.ListBegin()), e(digestsModel.ListEnd()); i!=e; ++i) {
+			if (!i->Contains("nodeHash") || !i->Contains("subtreeHash") || !i->Contains("childs")) {
+				LOG(ERROR) << "JSONTypecaster: Digest is incomplete.";
+				return false;
+			}
+			rsg::MerkleSynchronizer::SubtreeDigest digest;
+			digest.id = getIdFromJSON(*i, "id");
+			digest.nodeHash = i->Get("nodeHash").AsString();
+			digest.subtreeHash = i->Get("subtreeHash").AsString();
+			libvariant::Variant childs = i->Get("childs");
+			for (libvariant::Variant::ListIterator c(childs.ListBegin()), ce(childs.ListEnd()); c!=ce; ++c) {
+				digest.childIds.push_back(getIdFromJSON(*c, "id"));
+				digest.childHashes.push_back(c->Get("hash").AsString());
+			}
+			digests.push_back(digest);
+		}
+		return true;
+	}
+
 	inline static bool getShapeFromJSON(brics_3d::rsg::Shape::ShapePtr& shape, libvariant::Variant& node, string shapeTag = "geometry") {
 
 		brics_3d::rsg::Sphere::SpherePtr newSphere;
 		brics_3d::rsg::Cylinder::CylinderPtr newCylinder;
 		brics_3d::rsg::Box::BoxPtr newBox;
-		brics_3d::Units::DistanceUnit unit;
+		brics_3d::Units::DistanceUnit unit = brics_3d::Units::Meter;
 
 		if(node.Contains("unit")) {
 			LOG(DEBUG) << "JSONTypecaster: GeometricNode has the following unit: " << node.Get("unit").AsString();
@@ -498,8 +719,12 @@ public:
 
 				} else if (geometrytype.compare("PointCloud3D") == 0) {
 					LOG(DEBUG) << "\t\t found a PointCloud3D.";
+					if(!getPointCloudFromJSON(shape, geometry, Units::distanceToMeters(1.0, unit))) { return false;};
+
 				} else if (geometrytype.compare("PointCloud3DBinaryBlob") == 0) {
 					LOG(DEBUG) << "\t\t found a PointCloud3DBinaryBlob.";
+					if(!getPointCloudFromJSONBinaryBlob(shape, geometry, Units::distanceToMeters(1.0, unit))) { return false;};
+
 				} else if (geometrytype.compare("TriangleMesh3D") == 0) {
 					LOG(DEBUG) << "\t\t found a TriangleMesh3D.";
 
@@ -564,7 +789,17 @@ public:
 		return true;
 	}
 
-	inline static bool addShapeToJSON(brics_3d::rsg::Shape::ShapePtr& shape, libvariant::Variant& node, string shapeTag) {
+	/**
+	 * @brief Add a shape to a JSON model.
+	 * @param shape The shape.
+	 * @param node The JSON model where the shape will be added to.
+	 * @param shapeTag Name of the shape within the JSON model.
+	 * @param pointCloudBinaryBlobThreshold Point clouds with at least this number of points are encoded as "PointCloud3DBinaryBlob".
+	 *        Smaller ones are encoded as a list of points.
+	 * @param useSinglePrecision Store the coordinates of "PointCloud3DBinaryBlob" geometries as float instead of double values.
+	 */
+	inline static bool addShapeToJSON(brics_3d::rsg::Shape::ShapePtr& shape, libvariant::Variant& node, string shapeTag,
+			unsigned int pointCloudBinaryBlobThreshold = defaultPointCloudBinaryBlobThreshold, bool useSinglePrecision = false) {
 		LOG(DEBUG) << "JSONTypecaster: addShapeToJSON: ";
 
 		rsg::Sphere::SpherePtr sphere(new rsg::Sphere());
@@ -605,31 +840,7 @@ public:
 		} else if (shape->getPointCloudIterator() != 0) {
 			LOG(DEBUG) << "                 -> Found a point cloud.";
 
-			geometry.Set("@geometrytype", libvariant::Variant("PointCloud3D"));
-
-			libvariant::Variant points;
-
-			IPoint3DIterator::IPoint3DIteratorPtr it = shape->getPointCloudIterator();
-			for (it->begin(); !it->end(); it->next()) {
-				libvariant::Variant point;
-
-				point.Set("x", libvariant::Variant(it->getX()));
-				point.Set("y", libvariant::Variant(it->getY()));
-				point.Set("z", libvariant::Variant(it->getZ()));
-
-				if(it->getRawData()->asColoredPoint3D() != 0) {
-					geometry.Set("@pointtype", libvariant::Variant("ColoredPoint3D"));
-					point.Set("r", libvariant::Variant(it->getRawData()->asColoredPoint3D()->getR()));
-					point.Set("g", libvariant::Variant(it->getRawData()->asColoredPoint3D()->getG()));
-					point.Set("b", libvariant::Variant(it->getRawData()->asColoredPoint3D()->getB()));
-				} else {
-					geometry.Set("@pointtype", libvariant::Variant("Point3D"));
-				}
-
-				points.Append(point);
-			}
-
-			geometry.Set("points", points);
+			addPointCloudToJSON(shape->getPointCloudIterator(), geometry, pointCloudBinaryBlobThreshold, useSinglePrecision);
 			node.Set(shapeTag, geometry);
 
 		} else if (mesh != 0) {
@@ -724,6 +935,235 @@ public:
 		return true;
 	}
 
+	/**
+	 * @brief Encode the points of a point cloud.
+	 *
+	 * Small point clouds are stored as "PointCloud3D" with a list of points. Larger ones as
+	 * "PointCloud3DBinaryBlob":
+	 * @code
+	 * {
+	 *   "@geometrytype": "PointCloud3DBinaryBlob",
+	 *   "@pointtype": "ColoredPoint3D",  // or "Point3D"
+	 *   "numberOfPoints": 2,
+	 *   "precision": "float64",          // or "float32"
+	 *   "data": "AAAAAAAA8D8AAAAAAAAAQAAAAAAAAAhA/wAA..." // base64
+	 * }
+	 * @endcode
+	 * The data consists of numberOfPoints packed little endian x,y,z values, each followed by
+	 * r,g,b bytes for colored point clouds.
+	 */
+	inline static bool addPointCloudToJSON(IPoint3DIterator::IPoint3DIteratorPtr it, libvariant::Variant& geometry,
+			unsigned int binaryBlobThreshold = defaultPointCloudBinaryBlobThreshold, bool useSinglePrecision = false) {
+
+		/* Collect the points first, as the iterator does not know the size */
+		std::vector<double> coordinates;
+		std::vector<unsigned char> colors;
+		bool isColored = false;
+		for (it->begin(); !it->end(); it->next()) {
+			coordinates.push_back(it->getX());
+			coordinates.push_back(it->getY());
+			coordinates.push_back(it->getZ());
+			ColoredPoint3D* coloredPoint = it->getRawData()->asColoredPoint3D();
+			if (coloredPoint != 0) {
+				isColored = true;
+				colors.push_back(coloredPoint->getR());
+				colors.push_back(coloredPoint->getG());
+				colors.push_back(coloredPoint->getB());
+			} else {
+				colors.insert(colors.end(), 3, 0);
+			}
+		}
+		size_t numberOfPoints = coordinates.size() / 3;
+		geometry.Set("@pointtype", libvariant::Variant(isColored ? "ColoredPoint3D" : "Point3D"));
+
+		if (numberOfPoints < binaryBlobThreshold) {
+			geometry.Set("@geometrytype", libvariant::Variant("PointCloud3D"));
+			libvariant::Variant points(libvariant::VariantDefines::ListType);
+			for (size_t i = 0; i < numberOfPoints; ++i) {
+				libvariant::Variant point;
+				point.Set("x", libvariant::Variant(coordinates[3*i]));
+				point.Set("y", libvariant::Variant(coordinates[3*i + 1]));
+				point.Set("z", libvariant::Variant(coordinates[3*i + 2]));
+				if(isColored) {
+					point.Set("r", libvariant::Variant(colors[3*i]));
+					point.Set("g", libvariant::Variant(colors[3*i + 1]));
+					point.Set("b", libvariant::Variant(colors[3*i + 2]));
+				}
+				points.Append(point);
+			}
+			geometry.Set("points", points);
+			return true;
+		}
+
+		const size_t valueSize = useSinglePrecision ? 4 : 8;
+		const size_t stride = 3 * valueSize + (isColored ? 3 : 0);
+		std::vector<char> blob(numberOfPoints * stride);
+		char* data = blob.empty() ? 0 : &blob[0];
+		for (size_t i = 0; i < numberOfPoints; ++i, data += stride) {
+			for (size_t j = 0; j < 3; ++j) {
+				if (useSinglePrecision) {
+					BinaryTypecaster::writeFloat(static_cast<float>(coordinates[3*i + j]), data + j * valueSize);
+				} else {
+					BinaryTypecaster::writeDouble(coordinates[3*i + j], data + j * valueSize);
+				}
+			}
+			if (isColored) {
+				data[3 * valueSize] = static_cast<char>(colors[3*i]);
+				data[3 * valueSize + 1] = static_cast<char>(colors[3*i + 1]);
+				data[3 * valueSize + 2] = static_cast<char>(colors[3*i + 2]);
+			}
+		}
+
+		std::string encodedBlob;
+		encodeBase64(blob, encodedBlob);
+		geometry.Set("@geometrytype", libvariant::Variant("PointCloud3DBinaryBlob"));
+		geometry.Set("numberOfPoints", libvariant::Variant(static_cast<unsigned int>(numberOfPoints)));
+		geometry.Set("precision", libvariant::Variant(useSinglePrecision ? "float32" : "float64"));
+		geometry.Set("data", libvariant::Variant(encodedBlob));
+		return true;
+	}
+
+	/// Decode a "PointCloud3D" geometry. All coordinates are multiplied by scale.
+	inline static bool getPointCloudFromJSON(brics_3d::rsg::Shape::ShapePtr& shape, libvariant::Variant& geometry, double scale = 1.0) {
+		if(!geometry.Contains("points")) { LOG(ERROR) << "\t\t points list is missing"; return false;};
+		libvariant::Variant pointList = geometry.Get("points");
+		if (!pointList.IsList()) { LOG(ERROR) << "\t\t points is not a list"; return false;};
+
+		brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr newPointCloudContainer(new brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>());
+		newPointCloudContainer->data = brics_3d::PointCloud3D::PointCloud3DPtr(new brics_3d::PointCloud3D());
+		for (libvariant::Variant::ListIterator i(pointList.ListBegin()), e(pointList.ListEnd()); i!=e; ++i) {
+			if(!i->Contains("x") || !i->Contains("y") || !i->Contains("z")) { LOG(ERROR) << "\t\t point coordinates are missing"; return false;};
+			Point3D* point = new Point3D(i->Get("x").AsDouble() * scale, i->Get("y").AsDouble() * scale, i->Get("z").AsDouble() * scale);
+			if(i->Contains("r") && i->Contains("g") && i->Contains("b")) {
+				newPointCloudContainer->data->addPointPtr(new ColoredPoint3D(point,
+						static_cast<unsigned char>(i->Get("r").AsUnsigned()),
+						static_cast<unsigned char>(i->Get("g").AsUnsigned()),
+						static_cast<unsigned char>(i->Get("b").AsUnsigned())));
+			} else {
+				newPointCloudContainer->data->addPointPtr(point);
+			}
+		}
+		shape = newPointCloudContainer;
+		return true;
+	}
+
+	/// Decode a "PointCloud3DBinaryBlob" geometry. All coordinates are multiplied by scale.
+	inline static bool getPointCloudFromJSONBinaryBlob(brics_3d::rsg::Shape::ShapePtr& shape, libvariant::Variant& geometry, double scale = 1.0) {
+		if(!geometry.Contains("numberOfPoints")) { LOG(ERROR) << "\t\t numberOfPoints is missing"; return false;};
+		if(!geometry.Contains("data")) { LOG(ERROR) << "\t\t data is missing"; return false;};
+
+		bool isColored = geometry.Contains("@pointtype") && (geometry.Get("@pointtype").AsString().compare("ColoredPoint3D") == 0);
+		bool isSinglePrecision = geometry.Contains("precision") && (geometry.Get("precision").AsString().compare("float32") == 0);
+		size_t numberOfPoints = geometry.Get("numberOfPoints").AsUnsigned();
+		const size_t valueSize = isSinglePrecision ? 4 : 8;
+		const size_t stride = 3 * valueSize + (isColored ? 3 : 0);
+
+		std::vector<char> blob;
+		if(!decodeBase64(geometry.Get("data").AsString(), blob)) { LOG(ERROR) << "\t\t data is not base64 encoded"; return false;};
+		if(blob.size() != numberOfPoints * stride) {
+			LOG(ERROR) << "\t\t data has " << blob.size() << " bytes but " << numberOfPoints * stride << " are expected";
+			return false;
+		}
+
+		brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr newPointCloudContainer(new brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>());
+		newPointCloudContainer->data = brics_3d::PointCloud3D::PointCloud3DPtr(new brics_3d::PointCloud3D());
+		const char* data = blob.empty() ? 0 : &blob[0];
+		for (size_t i = 0; i < numberOfPoints; ++i, data += stride) {
+			Point3D* point;
+			if (isSinglePrecision) {
+				point = new Point3D(BinaryTypecaster::readFloat(data) * scale, BinaryTypecaster::readFloat(data + 4) * scale, BinaryTypecaster::readFloat(data + 8) * scale);
+			} else {
+				point = new Point3D(BinaryTypecaster::readDouble(data) * scale, BinaryTypecaster::readDouble(data + 8) * scale, BinaryTypecaster::readDouble(data + 16) * scale);
+			}
+			if (isColored) {
+				newPointCloudContainer->data->addPointPtr(new ColoredPoint3D(point,
+						static_cast<unsigned char>(data[3 * valueSize]),
+						static_cast<unsigned char>(data[3 * valueSize + 1]),
+						static_cast<unsigned char>(data[3 * valueSize + 2])));
+			} else {
+				newPointCloudContainer->data->addPointPtr(point);
+			}
+		}
+		shape = newPointCloudContainer;
+		return true;
+	}
+
+	/// Encode binary data as base64 (RFC 4648, with padding).
+	inline static void encodeBase64(const std::vector<char>& data, std::string& encoded) {
+		static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		encoded.resize(((data.size() + 2) / 3) * 4);
+		const unsigned char* bytes = data.empty() ? 0 : reinterpret_cast<const unsigned char*>(&data[0]);
+		size_t fullBlocks = data.size() / 3;
+		size_t out = 0;
+		for (size_t i = 0; i < fullBlocks; ++i, bytes += 3) {
+			unsigned int block = (bytes[0] << 16) | (bytes[1] << 8) | bytes[2];
+			encoded[out++] = alphabet[(block >> 18) & 0x3f];
+			encoded[out++] = alphabet[(block >> 12) & 0x3f];
+			encoded[out++] = alphabet[(block >> 6) & 0x3f];
+			encoded[out++] = alphabet[block & 0x3f];
+		}
+		size_t remainder = data.size() - fullBlocks * 3;
+		if (remainder > 0) {
+			unsigned int block = (bytes[0] << 16) | ((remainder == 2) ? (bytes[1] << 8) : 0);
+			encoded[out++] = alphabet[(block >> 18) & 0x3f];
+			encoded[out++] = alphabet[(block >> 12) & 0x3f];
+			encoded[out++] = (remainder == 2) ? alphabet[(block >> 6) & 0x3f] : '=';
+			encoded[out++] = '=';
+		}
+	}
+
+	/// Decode base64 data. Returns false for invalid characters, lengths or misplaced padding.
+	inline static bool decodeBase64(const std::string& encoded, std::vector<char>& data) {
+		/* Value of every base64 character, -1 for invalid ones. Initialized at compile time, so it is safe to use from several threads. */
+		static const signed char table[256] = {
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+			52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+			-1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+			15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+			-1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+			41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+		};
+
+		if (encoded.size() % 4 != 0) {
+			return false;
+		}
+		/* Only the last one or two characters of the final quartet may be padding; any other '=' is invalid below. */
+		size_t padding = 0;
+		while (padding < 2 && padding < encoded.size() && encoded[encoded.size() - 1 - padding] == '=') {
+			padding++;
+		}
+		data.resize(encoded.size() / 4 * 3 - padding);
+
+		const unsigned char* in = reinterpret_cast<const unsigned char*>(encoded.data());
+		size_t out = 0;
+		for (size_t i = 0; i < encoded.size(); i += 4) {
+			bool isLastBlock = (i + 4 == encoded.size());
+			int values[4];
+			for (int j = 0; j < 4; ++j) {
+				if (isLastBlock && in[i + j] == '=' && j >= 4 - static_cast<int>(padding)) {
+					values[j] = 0;
+				} else if ((values[j] = table[in[i + j]]) < 0) {
+					return false;
+				}
+			}
+			unsigned int block = (values[0] << 18) | (values[1] << 12) | (values[2] << 6) | values[3];
+			data[out++] = static_cast<char>(block >> 16);
+			if (out < data.size()) data[out++] = static_cast<char>(block >> 8);
+			if (out < data.size()) data[out++] = static_cast<char>(block);
+		}
+		return true;
+	}
+
 };
 
 } /* namespace rsg */
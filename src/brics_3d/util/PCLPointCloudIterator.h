@@ -27,6 +27,8 @@
 #include "brics_3d/core/Logger.h"
 #include "pcl/point_cloud.h"
 
+#include <algorithm>
+
 using brics_3d::Logger;
 
 namespace brics_3d {
@@ -141,6 +143,45 @@ public:
 		return currentRawPoint;
 	}
 
+	/**
+	 * @brief Block wise access that transforms all points of a block with a single pass over the point cloud.
+	 * @see IPoint3DIterator::nextBlock()
+	 */
+	unsigned int nextBlock(Coordinate* points, unsigned int maxPoints) {
+		unsigned int count = 0;
+		while ((count < maxPoints) && !end()) {
+			const pcl::PointCloud<PointT>& pointCloud = *(pointCloudsIterator->first);
+			unsigned int blockSize = std::min(static_cast<unsigned int>(pointCloud.points.size()) - index, maxPoints - count);
+			Coordinate* result = &points[count * 3];
+
+			if (*associatedTransformIsIdentityIterator) {
+				for (unsigned int i = index; i < index + blockSize; ++i, result += 3) {
+					result[0] = pointCloud.points[i].x;
+					result[1] = pointCloud.points[i].y;
+					result[2] = pointCloud.points[i].z;
+				}
+			} else {
+				const double* homogenousMatrix = pointCloudsIterator->second->getRawData();
+				const double m0 = homogenousMatrix[0], m4 = homogenousMatrix[4], m8 = homogenousMatrix[8], m12 = homogenousMatrix[12];
+				const double m1 = homogenousMatrix[1], m5 = homogenousMatrix[5], m9 = homogenousMatrix[9], m13 = homogenousMatrix[13];
+				const double m2 = homogenousMatrix[2], m6 = homogenousMatrix[6], m10 = homogenousMatrix[10], m14 = homogenousMatrix[14];
+				for (unsigned int i = index; i < index + blockSize; ++i, result += 3) {
+					const double x = pointCloud.points[i].x;
+					const double y = pointCloud.points[i].y;
+					const double z = pointCloud.points[i].z;
+					result[0] = x * m0 + y * m4 + z * m8 + m12;
+					result[1] = x * m1 + y * m5 + z * m9 + m13;
+					result[2] = x * m2 + y * m6 + z * m10 + m14;
+				}
+			}
+
+			count += blockSize;
+			index += blockSize - 1;
+			next(); // handles the wrap over to the next point cloud
+		}
+		return count;
+	}
+
 	/**
 	 * @brief Insert a new point cloud that will be acessable via the iterator
 	 * @param pointCloud The point cloud.
@@ -149,8 +190,11 @@ public:
 	void insert(const typename pcl::PointCloud<PointT>::ConstPtr pointCloud, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr associatedTransform) {
 		assert(pointCloud != 0);
 		assert(associatedTransform != 0);
-		pointCloudsWithTransforms.insert(std::make_pair(pointCloud, associatedTransform));
-		associatedTransformIsIdentity.push_back(associatedTransform->isIdentity());
+		std::pair<typename std::map<const typename pcl::PointCloud<PointT>::ConstPtr, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr>::iterator, bool> result;
+		result = pointCloudsWithTransforms.insert(std::make_pair(pointCloud, associatedTransform));
+		if (result.second) { // keep the flags in the same order as the map
+			associatedTransformIsIdentity.insert(associatedTransformIsIdentity.begin() + std::distance(pointCloudsWithTransforms.begin(), result.first), associatedTransform->isIdentity());
+		}
 	}
 
 	/**
@@ -18,7 +18,7 @@
 ******************************************************************************/
 
 #include "Attribute.h"
-#include <boost/regex.hpp>
+#include "AttributeQuery.h"
 #include <iostream>
 #include "brics_3d/core/Logger.h";
 
@@ -61,34 +61,14 @@ ostream& operator<<(ostream &outStream, const Attribute &attribute) {
 	return outStream;
 }
 
-extern bool attributeListContainsAttribute(vector<Attribute> attributeList, Attribute queryAttribute) {
-
-	/* Convenience substitution */
-	if (queryAttribute.key.compare("*") == 0) {
-		queryAttribute.key = "^.*";
-	}
-	if (queryAttribute.value.compare("*") == 0) {
-		queryAttribute.value = "^.*";
-	}
-
-	try {
-		for (unsigned int i = 0; i < static_cast<unsigned int>(attributeList.size()); ++i) {
-			//		if (attributeList[i] == queryAttribute) {
-			boost::regex keyExpression(queryAttribute.key);
-			boost::regex valueExpression(queryAttribute.value);
-			if (regex_match(attributeList[i].key, keyExpression) && regex_match(attributeList[i].value , valueExpression)) {
-				return true;
-			}
-		}
-	} catch (std::exception e) {
-		return false;
-	}
-	return false;
+extern bool attributeListContainsAttribute(const vector<Attribute>& attributeList, const Attribute& queryAttribute) {
+	AttributeQuery query(vector<Attribute>(1, queryAttribute)); // regular expressions are only compiled if the patterns need them
+	return query.matches(attributeList);
 }
 
-extern bool getValuesFromAttributeList(vector<Attribute> attributeList, std::string key, vector<std::string>& resultValues) {
+extern bool getValuesFromAttributeList(const vector<Attribute>& attributeList, const std::string& key, vector<std::string>& resultValues) {
 	resultValues.clear();
-	for(std::vector<Attribute>::iterator it = attributeList.begin(); it != attributeList.end() ;++it) {
+	for(std::vector<Attribute>::const_iterator it = attributeList.begin(); it != attributeList.end() ;++it) {
 		if(it->key.compare(key) == 0) {
 			resultValues.push_back(it->value);
 		}
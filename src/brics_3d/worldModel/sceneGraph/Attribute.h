@@ -74,11 +74,13 @@ class Attribute {
 
 /**
  * Helper tool to check if a certain attribute is included in an attribute list.
+ * Key and value of the query are regular expressions; "*" matches everything.
+ * Use an AttributeQuery to check multiple lists against the same query.
  * @param attributeList The list to be checked.
  * @param queryAttribute The attribute of interest.
  * @return True if list contains the attribute otherwise false.
  */
-extern bool attributeListContainsAttribute(vector<Attribute> attributeList, Attribute queryAttribute);
+extern bool attributeListContainsAttribute(const vector<Attribute>& attributeList, const Attribute& queryAttribute);
 
 /**
  * Helper tool to retrieve all values from an attribute list specified by a key tag
@@ -87,7 +89,7 @@ extern bool attributeListContainsAttribute(vector<Attribute> attributeList, Attr
  * @param[out] resultValues List with zero or more corresponding values.
  * @return True if list contains at least one value otherwise false.
  */
-extern bool getValuesFromAttributeList(vector<Attribute> attributeList, std::string key, vector<std::string>& resultValues);
+extern bool getValuesFromAttributeList(const vector<Attribute>& attributeList, const std::string& key, vector<std::string>& resultValues);
 
 /**
  * Helper tool to ckeck two lists for equality.
@@ -37,21 +37,12 @@ void AttributeFinder::visit(Node* node) {
 	LOG(DEBUG) << "Visiting node with ID: " << node->getId();
 
 	/* check for duplicates (possibly causesd by _graph_ traversal) */
-	for (unsigned int i = 0; i < static_cast<unsigned int>(matchingNodes.size()); ++i) {
-		if (matchingNodes[i] == node) {
-			return; //just stop
-		}
+	if (!visitedNodes.insert(node).second) {
+		return; //just stop
 	}
 
 	/* check if attributes match */
-	bool attributesMatch = false;
-	for (unsigned int i = 0; i < static_cast<unsigned int>(queryAttributes.size()); ++i) {
-		attributesMatch = false;
-		if (attributeListContainsAttribute(node->getAttributes(), queryAttributes[i]) == false) {
-			break;
-		}
-		attributesMatch = true; // returns true only when all loops are sucesfully/completely traversed
-	}
+	bool attributesMatch = query.matches(node->getAttributes());
 
 	if (attributesMatch == true) {
 		LOG(DEBUG) << "	Adding node as it has: ";
@@ -80,6 +71,7 @@ void AttributeFinder::visit(GeometricNode* node){
 
 void AttributeFinder::reset() {
 	matchingNodes.clear();
+	visitedNodes.clear();
 }
 
 }
@@ -27,6 +27,8 @@
 #include "GeometricNode.h"
 #include "Connection.h"
 #include "Attribute.h"
+#include "AttributeQuery.h"
+#include <set>
 
 using std::vector;
 
@@ -69,11 +71,31 @@ public:
     void setQueryAttributes(vector<Attribute> queryAttributes)
     {
         this->queryAttributes = queryAttributes;
+        query.compile(queryAttributes);
+    }
+
+    const AttributeQuery& getQuery() const
+    {
+        return query;
+    }
+
+    /**
+     * Use a precompiled query. This also allows a disjunctive (OR) concatenation of the attributes.
+     * @param query
+     */
+    void setQuery(const AttributeQuery& query)
+    {
+        this->query = query;
+        this->queryAttributes = query.getQueryAttributes();
     }
 
 protected:
 	vector<Attribute> queryAttributes;
+	AttributeQuery query;
 	vector<Node*> matchingNodes;
+
+	/// Already visited nodes, as a node with multiple parents is reached multiple times.
+	std::set<Node*> visitedNodes;
 };
 
 }
@@ -0,0 +1,217 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#include "AttributeQuery.h"
+#include "brics_3d/core/Logger.h"
+#include <cassert>
+
+namespace brics_3d {
+namespace rsg {
+
+namespace {
+
+inline bool isLiteral(const string& pattern) {
+	return pattern.find_first_of(".[]{}()\\*+?|^$") == string::npos;
+}
+
+/// Split a pattern at every ".*". Returns false if one of the parts is not a literal.
+bool splitAtWildcards(const string& pattern, vector<string>& literals) {
+	literals.clear();
+	size_t start = 0;
+	while (true) {
+		size_t wildcard = pattern.find(".*", start);
+		string literal = pattern.substr(start, (wildcard == string::npos) ? string::npos : wildcard - start);
+		if (!isLiteral(literal)) {
+			return false;
+		}
+		literals.push_back(literal);
+		if (wildcard == string::npos) {
+			return true;
+		}
+		start = wildcard + 2;
+	}
+}
+
+} // anonymous namespace
+
+bool AttributeQuery::Pattern::compile(const string& pattern) {
+	literals.clear();
+	expression.reset();
+
+	if (pattern.compare("*") == 0) { // convenience shortcut
+		type = ANY;
+		return true;
+	}
+
+	/* Anchors are redundant as the complete string has to match */
+	string body = pattern;
+	if (!body.empty() && body[0] == '^') {
+		body.erase(0, 1);
+	}
+	if (!body.empty() && body[body.size() - 1] == '$') {
+		body.erase(body.size() - 1); // an escaped "\$" leaves a backslash, which is handled as REGEX
+	}
+
+	if (splitAtWildcards(body, literals)) {
+		if (literals.size() == 1) {
+			type = EXACT;
+		} else if (body.find_first_not_of(".*") == string::npos) {
+			type = ANY;
+			literals.clear();
+		} else if (literals.size() == 2 && literals[1].empty()) {
+			type = PREFIX;
+			literals.pop_back();
+		} else {
+			type = WILDCARD;
+		}
+		return true;
+	}
+
+	literals.clear();
+	try {
+		expression = boost::shared_ptr<boost::regex>(new boost::regex(pattern));
+	} catch (std::exception& e) {
+		LOG(DEBUG) << "AttributeQuery: Pattern " << pattern << " is not a valid regular expression: " << e.what();
+		type = INVALID;
+		return false;
+	}
+	type = REGEX;
+	return true;
+}
+
+bool AttributeQuery::Pattern::matches(const string& text) const {
+	switch (type) {
+	case ANY:
+		return true;
+
+	case EXACT:
+		return text.compare(literals[0]) == 0;
+
+	case PREFIX:
+		return text.compare(0, literals[0].size(), literals[0]) == 0;
+
+	case WILDCARD: {
+		const string& first = literals.front();
+		const string& last = literals.back();
+		if (text.size() < first.size() + last.size() ||
+				text.compare(0, first.size(), first) != 0 ||
+				text.compare(text.size() - last.size(), last.size(), last) != 0) {
+			return false;
+		}
+		size_t position = first.size();
+		size_t end = text.size() - last.size();
+		for (unsigned int i = 1; i + 1 < static_cast<unsigned int>(literals.size()); ++i) {
+			size_t found = text.find(literals[i], position);
+			if (found == string::npos || found + literals[i].size() > end) {
+				return false;
+			}
+			position = found + literals[i].size();
+		}
+		return true;
+	}
+
+	case REGEX:
+		try {
+			return boost::regex_match(text, *expression);
+		} catch (std::exception& e) {
+			return false;
+		}
+
+	default:
+		return false;
+	}
+}
+
+AttributeQuery::AttributeQuery() : logicalOperator(AND) {
+
+}
+
+AttributeQuery::AttributeQuery(const vector<Attribute>& queryAttributes, Operator logicalOperator) {
+	compile(queryAttributes, logicalOperator);
+}
+
+AttributeQuery::~AttributeQuery() {
+
+}
+
+bool AttributeQuery::compile(const vector<Attribute>& queryAttributes, Operator logicalOperator) {
+	this->queryAttributes = queryAttributes;
+	this->logicalOperator = logicalOperator;
+	predicates.resize(queryAttributes.size());
+
+	bool success = true;
+	for (unsigned int i = 0; i < static_cast<unsigned int>(queryAttributes.size()); ++i) {
+		/* Evaluate both, so a query with an invalid key is consistently INVALID */
+		bool keyIsValid = predicates[i].key.compile(queryAttributes[i].key);
+		bool valueIsValid = predicates[i].value.compile(queryAttributes[i].value);
+		success = success && keyIsValid && valueIsValid;
+	}
+	return success;
+}
+
+bool AttributeQuery::matches(const Attribute& attribute, unsigned int predicateIndex) const {
+	assert(predicateIndex < predicates.size());
+	const Predicate& predicate = predicates[predicateIndex];
+	return predicate.key.matches(attribute.key) && predicate.value.matches(attribute.value);
+}
+
+bool AttributeQuery::matches(const vector<Attribute>& attributes) const {
+	if (predicates.empty()) {
+		return false;
+	}
+
+	for (unsigned int i = 0; i < static_cast<unsigned int>(predicates.size()); ++i) {
+		bool predicateMatches = false;
+		for (unsigned int j = 0; j < static_cast<unsigned int>(attributes.size()); ++j) {
+			if (matches(attributes[j], i)) {
+				predicateMatches = true;
+				break;
+			}
+		}
+
+		if (predicateMatches && logicalOperator == OR) {
+			return true;
+		}
+		if (!predicateMatches && logicalOperator == AND) {
+			return false;
+		}
+	}
+	return (logicalOperator == AND);
+}
+
+AttributeQuery::PatternType AttributeQuery::getKeyPatternType(unsigned int predicateIndex) const {
+	assert(predicateIndex < predicates.size());
+	return predicates[predicateIndex].key.type;
+}
+
+AttributeQuery::PatternType AttributeQuery::getValuePatternType(unsigned int predicateIndex) const {
+	assert(predicateIndex < predicates.size());
+	return predicates[predicateIndex].value.type;
+}
+
+AttributeQuery::PatternType AttributeQuery::classifyPattern(const string& pattern) {
+	Pattern compiledPattern;
+	compiledPattern.compile(pattern);
+	return compiledPattern.type;
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
@@ -0,0 +1,147 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#ifndef RSG_ATTRIBUTEQUERY_H_
+#define RSG_ATTRIBUTEQUERY_H_
+
+#include "Attribute.h"
+#include <boost/shared_ptr.hpp>
+#include <boost/regex.hpp>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief A precompiled query for attribute lists.
+ * @ingroup sceneGraph
+ *
+ * The keys and values of the query attributes are regular expressions that have to match
+ * the complete key or value, as for attributeListContainsAttribute(); "*" is a shortcut
+ * for any string. Constructing a boost::regex is expensive, so every pattern is classified
+ * once when the query is compiled:
+ *  - ANY: "*", ".*" or "^.*"
+ *  - EXACT: no regex meta characters, e.g. "name"
+ *  - PREFIX: a literal followed by ".*", e.g. "osm:.*"
+ *  - WILDCARD: literals separated by ".*", e.g. ".*:building.*"
+ *  - REGEX: everything else. Only these patterns are compiled as boost::regex.
+ *
+ * An attribute list matches a predicate (query attribute) if at least one of its attributes
+ * matches both key and value. The predicates are combined either conjunctively (AND, the
+ * semantics of SceneGraphFacade::getNodes) or disjunctively (OR). A query without predicates
+ * matches nothing.
+ *
+ * A query can be reused for any number of attribute lists:
+ * @code
+ * vector<Attribute> queryAttributes;
+ * queryAttributes.push_back(Attribute("name", "box_.*"));
+ * queryAttributes.push_back(Attribute("shapeType", "Box"));
+ * AttributeQuery query(queryAttributes, AttributeQuery::OR);
+ * vector<Id> ids;
+ * wm->scene.getNodes(query, ids);
+ * @endcode
+ */
+class AttributeQuery {
+public:
+
+	/// Logical combination of the predicates.
+	enum Operator {
+		AND,
+		OR
+	};
+
+	/// Classification of a single key or value pattern.
+	enum PatternType {
+		ANY,
+		EXACT,
+		PREFIX,
+		WILDCARD,
+		REGEX,
+		INVALID  ///< Not a valid regular expression. Never matches.
+	};
+
+	AttributeQuery();
+
+	/// Compile a query. Same as compile().
+	explicit AttributeQuery(const vector<Attribute>& queryAttributes, Operator logicalOperator = AND);
+
+	virtual ~AttributeQuery();
+
+	/**
+	 * @brief Compile the patterns of the query attributes.
+	 * @return False if one of the patterns is not a valid regular expression. It will never match.
+	 */
+	bool compile(const vector<Attribute>& queryAttributes, Operator logicalOperator = AND);
+
+	/// Check if an attribute list fulfills the query.
+	bool matches(const vector<Attribute>& attributes) const;
+
+	/// Check if a single attribute matches the predicate with the given index.
+	bool matches(const Attribute& attribute, unsigned int predicateIndex) const;
+
+	const vector<Attribute>& getQueryAttributes() const {
+		return queryAttributes;
+	}
+
+	Operator getOperator() const {
+		return logicalOperator;
+	}
+
+	unsigned int getPredicateCount() const {
+		return static_cast<unsigned int>(predicates.size());
+	}
+
+	PatternType getKeyPatternType(unsigned int predicateIndex) const;
+	PatternType getValuePatternType(unsigned int predicateIndex) const;
+
+	/// Classify a key or value pattern.
+	static PatternType classifyPattern(const string& pattern);
+
+private:
+
+	/// A compiled key or value pattern.
+	struct Pattern {
+		PatternType type;
+
+		/// The literal for EXACT and PREFIX or the literals between the ".*" for WILDCARD.
+		vector<string> literals;
+
+		/// Only set for REGEX.
+		boost::shared_ptr<boost::regex> expression;
+
+		bool compile(const string& pattern);
+		bool matches(const string& text) const;
+	};
+
+	/// A query attribute.
+	struct Predicate {
+		Pattern key;
+		Pattern value;
+	};
+
+	vector<Attribute> queryAttributes;
+	vector<Predicate> predicates;
+	Operator logicalOperator;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_ATTRIBUTEQUERY_H_ */
+
+/* EOF */
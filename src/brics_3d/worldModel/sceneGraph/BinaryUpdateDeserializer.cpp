@@ -0,0 +1,338 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#include "BinaryUpdateDeserializer.h"
+
+namespace brics_3d {
+namespace rsg {
+
+BinaryUpdateDeserializer::BinaryUpdateDeserializer(WorldModel* wm) :
+		wm(wm) {
+	sceneUpdater = &wm->scene;
+}
+
+BinaryUpdateDeserializer::BinaryUpdateDeserializer(WorldModel* wm, ISceneGraphUpdate* sceneUpdater) :
+		wm(wm),
+		sceneUpdater(sceneUpdater) {
+
+}
+
+BinaryUpdateDeserializer::~BinaryUpdateDeserializer() {
+
+}
+
+int BinaryUpdateDeserializer::write(const char* dataBuffer, int dataLength,
+		int& transferredBytes) {
+
+	transferredBytes = 0;
+	if (dataBuffer == 0 || dataLength <= 0) {
+		LOG(ERROR) << "BinaryUpdateDeserializer: Empty data buffer.";
+		return -1;
+	}
+
+	bool success = true;
+	const char* cursor = dataBuffer;
+	const char* end = dataBuffer + dataLength;
+	while (cursor < end) {
+		boost::uint32_t messageLength = 0;
+		BinaryTypecaster::CommandType command;
+		if (!BinaryTypecaster::getMessageHeaderFromBinary(messageLength, command, cursor, end - cursor)) {
+			if (end - cursor < static_cast<int>(BinaryTypecaster::headerSize)) {
+				LOG(DEBUG) << "BinaryUpdateDeserializer: Incomplete message header.";
+				break;
+			}
+			/* Skip to the next plausible header. A trailing part that is too short to tell is not consumed. */
+			const char* skipped = cursor;
+			do {
+				++cursor;
+			} while ((end - cursor >= static_cast<int>(BinaryTypecaster::headerSize)) && !BinaryTypecaster::isMessageHeader(cursor, end - cursor));
+			LOG(ERROR) << "BinaryUpdateDeserializer: Malformed message header. Skipping " << (cursor - skipped) << " bytes.";
+			success = false;
+			continue;
+		}
+		if (static_cast<size_t>(end - cursor) < messageLength) {
+			LOG(DEBUG) << "BinaryUpdateDeserializer: Incomplete message of " << messageLength << " bytes.";
+			break;
+		}
+
+		const char* messageEnd = cursor + messageLength;
+		const char* payload = cursor + BinaryTypecaster::headerSize;
+		if (!handleMessage(command, payload, messageEnd)) {
+			success = false; // the length is known, so we can continue with the next message
+		}
+		cursor = messageEnd;
+	}
+
+	transferredBytes = static_cast<int>(cursor - dataBuffer);
+	return success ? 1 : -1;
+}
+
+bool BinaryUpdateDeserializer::handleMessage(BinaryTypecaster::CommandType command, const char*& cursor, const char* end) {
+	switch (command) {
+		case BinaryTypecaster::ADD_NODE:
+			return doAddNode(cursor, end);
+		case BinaryTypecaster::ADD_GROUP:
+			return doAddGroup(cursor, end);
+		case BinaryTypecaster::ADD_TRANSFORM_NODE:
+			return doAddTransformNode(cursor, end);
+		case BinaryTypecaster::ADD_UNCERTAIN_TRANSFORM_NODE:
+			return doAddUncertainTransformNode(cursor, end);
+		case BinaryTypecaster::ADD_GEOMETRIC_NODE:
+			return doAddGeometricNode(cursor, end);
+		case BinaryTypecaster::ADD_REMOTE_ROOT_NODE:
+			return doAddRemoteRootNode(cursor, end);
+		case BinaryTypecaster::ADD_CONNECTION:
+			return doAddConnection(cursor, end);
+		case BinaryTypecaster::SET_NODE_ATTRIBUTES:
+			return doSetNodeAttributes(cursor, end);
+		case BinaryTypecaster::SET_TRANSFORM:
+			return doSetTransform(cursor, end);
+		case BinaryTypecaster::SET_UNCERTAIN_TRANSFORM:
+			return doSetUncertainTransform(cursor, end);
+		case BinaryTypecaster::DELETE_NODE:
+			return doDeleteNode(cursor, end);
+		case BinaryTypecaster::ADD_PARENT:
+			return doAddParent(cursor, end);
+		case BinaryTypecaster::REMOVE_PARENT:
+			return doRemoveParent(cursor, end);
+		case BinaryTypecaster::UPDATE_BATCH:
+			return handleBatch(cursor, end);
+		default:
+			LOG(WARNING) << "BinaryUpdateDeserializer: Unhandled command: " << command;
+			return false;
+	}
+}
+
+bool BinaryUpdateDeserializer::handleBatch(const char*& cursor, const char* end) {
+
+	/* Record all updates first and then apply them as a whole */
+	SceneGraphUpdateBatch batch;
+	ISceneGraphUpdate* originalSceneUpdater = sceneUpdater;
+	sceneUpdater = &batch;
+	bool success = true;
+	while (success && cursor < end) {
+		boost::uint32_t messageLength = 0;
+		BinaryTypecaster::CommandType command;
+		if (!BinaryTypecaster::getMessageHeaderFromBinary(messageLength, command, cursor, end - cursor)
+				|| static_cast<size_t>(end - cursor) < messageLength) {
+			success = false;
+			break;
+		}
+		const char* messageEnd = cursor + messageLength;
+		const char* payload = cursor + BinaryTypecaster::headerSize;
+		success = handleMessage(command, payload, messageEnd);
+		cursor = messageEnd;
+	}
+	sceneUpdater = originalSceneUpdater;
+
+	if(!success) {
+		LOG(ERROR) << "BinaryUpdateDeserializer: Batch contains malformed updates. Discarding it.";
+		return false;
+	}
+	LOG(DEBUG) << "BinaryUpdateDeserializer: Batch contains " << batch.getNumberOfUpdates() << " updates.";
+	return sceneUpdater->applyUpdateBatch(batch);
+}
+
+bool BinaryUpdateDeserializer::doAddNode(const char*& cursor, const char* end) {
+	Id parentId;
+	Id id;
+	vector<Attribute> attributes;
+	if (!BinaryTypecaster::getIdFromBinary(parentId, cursor, end) ||
+		!BinaryTypecaster::getIdFromBinary(id, cursor, end) ||
+		!BinaryTypecaster::getAttributesFromBinary(attributes, cursor, end)) {
+		LOG(ERROR) << "BinaryUpdateDeserializer: Malformed ADD_NODE message.";
+		return false;
+	}
+	return sceneUpdater->addNode(parentId, id, attributes, true);
+}
+
+bool BinaryUpdateDeserializer::doAddGroup(const char*& cursor, const char* end) {
+	Id parentId;
+	Id id;
+	vector<Attribute> attributes;
+	if (!BinaryTypecaster::getIdFromBinary(parentId, cursor, end) ||
+		!BinaryTypecaster::getIdFromBinary(id, cursor, end) ||
+		!BinaryTypecaster::getAttributesFromBinary(attributes, cursor, end)) {
+		LOG(ERROR) << "BinaryUpdateDeserializer: Malformed ADD_GROUP message.";
+		return false;
+	}
+	return sceneUpdater->addGroup(parentId, id, attributes, true);
+}
+
+bool BinaryUpdateDeserializer::doAddTransformNode(const char*& cursor, const char* end) {
+	Id parentId;
+	Id id;
+	TimeStamp timeStamp;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform;
+	vector<Attribute> attributes;
+	if (!BinaryTypecaster::getIdFromBinary(parentId, cursor, end) ||
+		!BinaryTypecaster::getIdFromBinary(id, cursor, end) ||
+		!BinaryTypecaster::getTimeStampFromBinary(timeStamp, cursor, end) ||
+		!BinaryTypecaster::getTransformFromBinary(transform, cursor, end) ||
+		!BinaryTypecaster::getAttributesFromBinary(attributes, cursor, end)) {
+		LOG(ERROR) << "BinaryUpdateDeserializer: Malformed ADD_TRANSFORM_NODE message.";
+		return false;
+	}
+	return sceneUpdater->addTransformNode(parentId, id, attributes, transform, timeStamp, true);
+}
+
+bool BinaryUpdateDeserializer::doAddUncertainTransformNode(const char*& cursor, const char* end) {
+	Id parentId;
+	Id id;
+	TimeStamp timeStamp;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform;
+	ITransformUncertainty::ITransformUncertaintyPtr uncertainty;
+	vector<Attribute> attributes;
+	if (!BinaryTypecaster::getIdFromBinary(parentId, cursor, end) ||
+		!BinaryTypecaster::getIdFromBinary(id, cursor, end) ||
+		!BinaryTypecaster::getTimeStampFromBinary(timeStamp, cursor, end) ||
+		!BinaryTypecaster::getTransformFromBinary(transform, cursor, end) ||
+		!BinaryTypecaster::getUncertaintyFromBinary(uncertainty, cursor, end) ||
+		!BinaryTypecaster::getAttributesFromBinary(attributes, cursor, end)) {
+		LOG(ERROR) << "BinaryUpdateDeserializer: Malformed ADD_UNCERTAIN_TRANSFORM_NODE message.";
+		return false;
+	}
+	return sceneUpdater->addUncertainTransformNode(parentId, id, attributes, transform, uncertainty, timeStamp, true);
+}
+
+bool BinaryUpdateDeserializer::doAddGeometricNode(const char*& cursor, const char* end) {
+	Id parentId;
+	Id id;
+	TimeStamp timeStamp;
+	vector<Attribute> attributes;
+	Shape::ShapePtr shape;
+	if (!BinaryTypecaster::getIdFromBinary(parentId, cursor, end) ||
+		!BinaryTypecaster::getIdFromBinary(id, cursor, end) ||
+		!BinaryTypecaster::getTimeStampFromBinary(timeStamp, cursor, end) ||
+		!BinaryTypecaster::getAttributesFromBinary(attributes, cursor, end) ||
+		!BinaryTypecaster::getShapeFromBinary(shape, cursor, end)) {
+		LOG(ERROR) << "BinaryUpdateDeserializer: Malformed ADD_GEOMETRIC_NODE message.";
+		return false;
+	}
+	return sceneUpdater->addGeometricNode(parentId, id, attributes, shape, timeStamp, true);
+}
+
+bool BinaryUpdateDeserializer::doAddRemoteRootNode(const char*& cursor, const char* end) {
+	Id rootId;
+	vector<Attribute> attributes;
+	if (!BinaryTypecaster::getIdFromBinary(rootId, cursor, end) ||
+		!BinaryTypecaster::getAttributesFromBinary(attributes, cursor, end)) {
+		LOG(ERROR) << "BinaryUpdateDeserializer: Malformed ADD_REMOTE_ROOT_NODE message.";
+		return false;
+	}
+	return sceneUpdater->addRemoteRootNode(rootId, attributes);
+}
+
+bool BinaryUpdateDeserializer::doAddConnection(const char*& cursor, const char* end) {
+	Id parentId;
+	Id id;
+	TimeStamp start;
+	TimeStamp stop;
+	vector<Id> sourceIds;
+	vector<Id> targetIds;
+	vector<Attribute> attributes;
+	if (!BinaryTypecaster::getIdFromBinary(parentId, cursor, end) ||
+		!BinaryTypecaster::getIdFromBinary(id, cursor, end) ||
+		!BinaryTypecaster::getTimeStampFromBinary(start, cursor, end) ||
+		!BinaryTypecaster::getTimeStampFromBinary(stop, cursor, end) ||
+		!BinaryTypecaster::getIdsFromBinary(sourceIds, cursor, end) ||
+		!BinaryTypecaster::getIdsFromBinary(targetIds, cursor, end) ||
+		!BinaryTypecaster::getAttributesFromBinary(attributes, cursor, end)) {
+		LOG(ERROR) << "BinaryUpdateDeserializer: Malformed ADD_CONNECTION message.";
+		return false;
+	}
+	return sceneUpdater->addConnection(parentId, id, attributes, sourceIds, targetIds, start, stop, true);
+}
+
+bool BinaryUpdateDeserializer::doSetNodeAttributes(const char*& cursor, const char* end) {
+	Id id;
+	TimeStamp timeStamp;
+	vector<Attribute> attributes;
+	if (!BinaryTypecaster::getIdFromBinary(id, cursor, end) ||
+		!BinaryTypecaster::getTimeStampFromBinary(timeStamp, cursor, end) ||
+		!BinaryTypecaster::getAttributesFromBinary(attributes, cursor, end)) {
+		LOG(ERROR) << "BinaryUpdateDeserializer: Malformed SET_NODE_ATTRIBUTES message.";
+		return false;
+	}
+	return sceneUpdater->setNodeAttributes(id, attributes, timeStamp);
+}
+
+bool BinaryUpdateDeserializer::doSetTransform(const char*& cursor, const char* end) {
+	Id id;
+	TimeStamp timeStamp;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform;
+	if (!BinaryTypecaster::getIdFromBinary(id, cursor, end) ||
+		!BinaryTypecaster::getTimeStampFromBinary(timeStamp, cursor, end) ||
+		!BinaryTypecaster::getTransformFromBinary(transform, cursor, end)) {
+		LOG(ERROR) << "BinaryUpdateDeserializer: Malformed SET_TRANSFORM message.";
+		return false;
+	}
+	return sceneUpdater->setTransform(id, transform, timeStamp);
+}
+
+bool BinaryUpdateDeserializer::doSetUncertainTransform(const char*& cursor, const char* end) {
+	Id id;
+	TimeStamp timeStamp;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform;
+	ITransformUncertainty::ITransformUncertaintyPtr uncertainty;
+	if (!BinaryTypecaster::getIdFromBinary(id, cursor, end) ||
+		!BinaryTypecaster::getTimeStampFromBinary(timeStamp, cursor, end) ||
+		!BinaryTypecaster::getTransformFromBinary(transform, cursor, end) ||
+		!BinaryTypecaster::getUncertaintyFromBinary(uncertainty, cursor, end)) {
+		LOG(ERROR) << "BinaryUpdateDeserializer: Malformed SET_UNCERTAIN_TRANSFORM message.";
+		return false;
+	}
+	return sceneUpdater->setUncertainTransform(id, transform, uncertainty, timeStamp);
+}
+
+bool BinaryUpdateDeserializer::doDeleteNode(const char*& cursor, const char* end) {
+	Id id;
+	if (!BinaryTypecaster::getIdFromBinary(id, cursor, end)) {
+		LOG(ERROR) << "BinaryUpdateDeserializer: Malformed DELETE_NODE message.";
+		return false;
+	}
+	return sceneUpdater->deleteNode(id);
+}
+
+bool BinaryUpdateDeserializer::doAddParent(const char*& cursor, const char* end) {
+	Id id;
+	Id parentId;
+	if (!BinaryTypecaster::getIdFromBinary(id, cursor, end) ||
+		!BinaryTypecaster::getIdFromBinary(parentId, cursor, end)) {
+		LOG(ERROR) << "BinaryUpdateDeserializer: Malformed ADD_PARENT message.";
+		return false;
+	}
+	return sceneUpdater->addParent(id, parentId);
+}
+
+bool BinaryUpdateDeserializer::doRemoveParent(const char*& cursor, const char* end) {
+	Id id;
+	Id parentId;
+	if (!BinaryTypecaster::getIdFromBinary(id, cursor, end) ||
+		!BinaryTypecaster::getIdFromBinary(parentId, cursor, end)) {
+		LOG(ERROR) << "BinaryUpdateDeserializer: Malformed REMOVE_PARENT message.";
+		return false;
+	}
+	return sceneUpdater->removeParent(id, parentId);
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
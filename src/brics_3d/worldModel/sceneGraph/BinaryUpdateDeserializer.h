@@ -0,0 +1,94 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#ifndef RSG_BINARYUPDATEDESERIALIZER_H_
+#define RSG_BINARYUPDATEDESERIALIZER_H_
+
+#include "brics_3d/core/Logger.h"
+#include "brics_3d/worldModel/WorldModel.h"
+#include "brics_3d/util/BinaryTypecaster.h"
+#include "brics_3d/worldModel/sceneGraph/IPort.h"
+#include "brics_3d/worldModel/sceneGraph/SceneGraphUpdateBatch.h"
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Decodes messages of the BinaryUpdateSerializer and applies them to a world model.
+ * @ingroup sceneGraph
+ *
+ * Decoding works directly on the received buffer. A single write() may contain multiple
+ * concatenated messages. transferredBytes is set to the number of bytes of all
+ * complete messages, so a trailing incomplete message is not consumed. Bytes with
+ * a malformed header are skipped up to the next plausible header and count as transferred.
+ */
+class BinaryUpdateDeserializer : public IInputPort {
+public:
+	BinaryUpdateDeserializer(WorldModel* wm);
+
+	/**
+	 * @brief Constructor with a custom receiver of the decoded updates.
+	 * @param wm World model. Not used for updates.
+	 * @param sceneUpdater Receiver of the updates, e.g. a filter chain in front of wm->scene.
+	 */
+	BinaryUpdateDeserializer(WorldModel* wm, ISceneGraphUpdate* sceneUpdater);
+	virtual ~BinaryUpdateDeserializer();
+
+	/**
+	 * @brief Decode and apply all messages in the buffer.
+	 * @return 1 on success, -1 if at least one message is malformed or could not be applied.
+	 */
+	int write(const char *dataBuffer, int dataLength, int &transferredBytes);
+
+protected:
+
+	/// Process a single message. The cursor is placed behind the header.
+	bool handleMessage(BinaryTypecaster::CommandType command, const char*& cursor, const char* end);
+
+	/// Process all messages of an UPDATE_BATCH payload and apply them as one SceneGraphUpdateBatch.
+	bool handleBatch(const char*& cursor, const char* end);
+
+	//Functions that do the actual work (template method)
+	virtual bool doAddNode(const char*& cursor, const char* end);
+	virtual bool doAddGroup(const char*& cursor, const char* end);
+	virtual bool doAddTransformNode(const char*& cursor, const char* end);
+	virtual bool doAddUncertainTransformNode(const char*& cursor, const char* end);
+	virtual bool doAddGeometricNode(const char*& cursor, const char* end);
+	virtual bool doAddRemoteRootNode(const char*& cursor, const char* end);
+	virtual bool doAddConnection(const char*& cursor, const char* end);
+	virtual bool doSetNodeAttributes(const char*& cursor, const char* end);
+	virtual bool doSetTransform(const char*& cursor, const char* end);
+	virtual bool doSetUncertainTransform(const char*& cursor, const char* end);
+	virtual bool doDeleteNode(const char*& cursor, const char* end);
+	virtual bool doAddParent(const char*& cursor, const char* end);
+	virtual bool doRemoveParent(const char*& cursor, const char* end);
+
+private:
+	WorldModel* wm;
+
+	/// Receiver of the decoded updates. Defaults to the scene of the world model, but is temporarily a batch while decoding batches.
+	ISceneGraphUpdate* sceneUpdater;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_BINARYUPDATEDESERIALIZER_H_ */
+
+/* EOF */
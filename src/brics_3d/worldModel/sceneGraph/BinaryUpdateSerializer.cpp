@@ -0,0 +1,222 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#include "BinaryUpdateSerializer.h"
+
+namespace brics_3d {
+namespace rsg {
+
+BinaryUpdateSerializer::BinaryUpdateSerializer(IOutputPort* port) :
+		port(port) {
+	batchMode = false;
+	buffer.reserve(256);
+}
+
+BinaryUpdateSerializer::~BinaryUpdateSerializer() {
+
+}
+
+size_t BinaryUpdateSerializer::beginMessage(BinaryTypecaster::CommandType command) {
+	if (!batchMode) {
+		buffer.clear(); // keeps the capacity
+	}
+	return BinaryTypecaster::beginMessage(command, buffer);
+}
+
+bool BinaryUpdateSerializer::endMessage(size_t start) {
+	BinaryTypecaster::endMessage(start, buffer);
+	if (batchMode) {
+		return true;
+	}
+
+	if (port == 0) {
+		LOG(ERROR) << "BinaryUpdateSerializer: No output port specified.";
+		return false;
+	}
+	int transferredBytes = 0;
+	if (port->write(&buffer[0], static_cast<int>(buffer.size()), transferredBytes) < 0) {
+		LOG(ERROR) << "BinaryUpdateSerializer: Cannot write a message of " << buffer.size() << " bytes to the output port.";
+		return false;
+	}
+	return true;
+}
+
+bool BinaryUpdateSerializer::addNode(Id parentId, Id& assignedId,
+		vector<Attribute> attributes, bool forcedId) {
+	size_t start = beginMessage(BinaryTypecaster::ADD_NODE);
+	BinaryTypecaster::addIdToBinary(parentId, buffer);
+	BinaryTypecaster::addIdToBinary(assignedId, buffer);
+	BinaryTypecaster::addAttributesToBinary(attributes, buffer);
+	return endMessage(start);
+}
+
+bool BinaryUpdateSerializer::addGroup(Id parentId, Id& assignedId,
+		vector<Attribute> attributes, bool forcedId) {
+	size_t start = beginMessage(BinaryTypecaster::ADD_GROUP);
+	BinaryTypecaster::addIdToBinary(parentId, buffer);
+	BinaryTypecaster::addIdToBinary(assignedId, buffer);
+	BinaryTypecaster::addAttributesToBinary(attributes, buffer);
+	return endMessage(start);
+}
+
+bool BinaryUpdateSerializer::addTransformNode(Id parentId, Id& assignedId,
+		vector<Attribute> attributes,
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform,
+		TimeStamp timeStamp, bool forcedId) {
+	size_t start = beginMessage(BinaryTypecaster::ADD_TRANSFORM_NODE);
+	BinaryTypecaster::addIdToBinary(parentId, buffer);
+	BinaryTypecaster::addIdToBinary(assignedId, buffer);
+	BinaryTypecaster::addTimeStampToBinary(timeStamp, buffer);
+	if (!BinaryTypecaster::addTransformToBinary(transform, buffer)) {
+		buffer.resize(start); // discard the incomplete message
+		return false;
+	}
+	BinaryTypecaster::addAttributesToBinary(attributes, buffer);
+	return endMessage(start);
+}
+
+bool BinaryUpdateSerializer::addUncertainTransformNode(Id parentId,
+		Id& assignedId, vector<Attribute> attributes,
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform,
+		ITransformUncertainty::ITransformUncertaintyPtr uncertainty,
+		TimeStamp timeStamp, bool forcedId) {
+	size_t start = beginMessage(BinaryTypecaster::ADD_UNCERTAIN_TRANSFORM_NODE);
+	BinaryTypecaster::addIdToBinary(parentId, buffer);
+	BinaryTypecaster::addIdToBinary(assignedId, buffer);
+	BinaryTypecaster::addTimeStampToBinary(timeStamp, buffer);
+	if (!BinaryTypecaster::addTransformToBinary(transform, buffer) || !BinaryTypecaster::addUncertaintyToBinary(uncertainty, buffer)) {
+		buffer.resize(start); // discard the incomplete message
+		return false;
+	}
+	BinaryTypecaster::addAttributesToBinary(attributes, buffer);
+	return endMessage(start);
+}
+
+bool BinaryUpdateSerializer::addGeometricNode(Id parentId, Id& assignedId,
+		vector<Attribute> attributes, Shape::ShapePtr shape,
+		TimeStamp timeStamp, bool forcedId) {
+	size_t start = beginMessage(BinaryTypecaster::ADD_GEOMETRIC_NODE);
+	BinaryTypecaster::addIdToBinary(parentId, buffer);
+	BinaryTypecaster::addIdToBinary(assignedId, buffer);
+	BinaryTypecaster::addTimeStampToBinary(timeStamp, buffer);
+	BinaryTypecaster::addAttributesToBinary(attributes, buffer);
+	if (!BinaryTypecaster::addShapeToBinary(shape, buffer)) {
+		buffer.resize(start); // discard the incomplete message
+		return false;
+	}
+	return endMessage(start);
+}
+
+bool BinaryUpdateSerializer::addRemoteRootNode(Id rootId, vector<Attribute> attributes) {
+	size_t start = beginMessage(BinaryTypecaster::ADD_REMOTE_ROOT_NODE);
+	BinaryTypecaster::addIdToBinary(rootId, buffer);
+	BinaryTypecaster::addAttributesToBinary(attributes, buffer);
+	return endMessage(start);
+}
+
+bool BinaryUpdateSerializer::addConnection(Id parentId, Id& assignedId,
+		vector<Attribute> attributes, vector<Id> sourceIds,
+		vector<Id> targetIds, TimeStamp start, TimeStamp end, bool forcedId) {
+	size_t messageStart = beginMessage(BinaryTypecaster::ADD_CONNECTION);
+	BinaryTypecaster::addIdToBinary(parentId, buffer);
+	BinaryTypecaster::addIdToBinary(assignedId, buffer);
+	BinaryTypecaster::addTimeStampToBinary(start, buffer);
+	BinaryTypecaster::addTimeStampToBinary(end, buffer);
+	BinaryTypecaster::addIdsToBinary(sourceIds, buffer);
+	BinaryTypecaster::addIdsToBinary(targetIds, buffer);
+	BinaryTypecaster::addAttributesToBinary(attributes, buffer);
+	return endMessage(messageStart);
+}
+
+bool BinaryUpdateSerializer::setNodeAttributes(Id id,
+		vector<Attribute> newAttributes, TimeStamp timeStamp) {
+	size_t start = beginMessage(BinaryTypecaster::SET_NODE_ATTRIBUTES);
+	BinaryTypecaster::addIdToBinary(id, buffer);
+	BinaryTypecaster::addTimeStampToBinary(timeStamp, buffer);
+	BinaryTypecaster::addAttributesToBinary(newAttributes, buffer);
+	return endMessage(start);
+}
+
+bool BinaryUpdateSerializer::setTransform(Id id,
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform,
+		TimeStamp timeStamp) {
+	size_t start = beginMessage(BinaryTypecaster::SET_TRANSFORM);
+	BinaryTypecaster::addIdToBinary(id, buffer);
+	BinaryTypecaster::addTimeStampToBinary(timeStamp, buffer);
+	if (!BinaryTypecaster::addTransformToBinary(transform, buffer)) {
+		buffer.resize(start); // discard the incomplete message
+		return false;
+	}
+	return endMessage(start);
+}
+
+bool BinaryUpdateSerializer::setUncertainTransform(Id id,
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform,
+		ITransformUncertainty::ITransformUncertaintyPtr uncertainty,
+		TimeStamp timeStamp) {
+	size_t start = beginMessage(BinaryTypecaster::SET_UNCERTAIN_TRANSFORM);
+	BinaryTypecaster::addIdToBinary(id, buffer);
+	BinaryTypecaster::addTimeStampToBinary(timeStamp, buffer);
+	if (!BinaryTypecaster::addTransformToBinary(transform, buffer) || !BinaryTypecaster::addUncertaintyToBinary(uncertainty, buffer)) {
+		buffer.resize(start); // discard the incomplete message
+		return false;
+	}
+	return endMessage(start);
+}
+
+bool BinaryUpdateSerializer::deleteNode(Id id) {
+	size_t start = beginMessage(BinaryTypecaster::DELETE_NODE);
+	BinaryTypecaster::addIdToBinary(id, buffer);
+	return endMessage(start);
+}
+
+bool BinaryUpdateSerializer::addParent(Id id, Id parentId) {
+	size_t start = beginMessage(BinaryTypecaster::ADD_PARENT);
+	BinaryTypecaster::addIdToBinary(id, buffer);
+	BinaryTypecaster::addIdToBinary(parentId, buffer);
+	return endMessage(start);
+}
+
+bool BinaryUpdateSerializer::removeParent(Id id, Id parentId) {
+	size_t start = beginMessage(BinaryTypecaster::REMOVE_PARENT);
+	BinaryTypecaster::addIdToBinary(id, buffer);
+	BinaryTypecaster::addIdToBinary(parentId, buffer);
+	return endMessage(start);
+}
+
+bool BinaryUpdateSerializer::applyUpdateBatch(const SceneGraphUpdateBatch& batch) {
+	if (batchMode) { // nested batches are just flattened into the current one
+		return batch.replay(this);
+	}
+
+	size_t start = beginMessage(BinaryTypecaster::UPDATE_BATCH);
+	batchMode = true;
+	bool success = batch.replay(this);
+	batchMode = false;
+	if (!success) {
+		LOG(ERROR) << "BinaryUpdateSerializer: Cannot serialize all updates of the batch.";
+		return false;
+	}
+	return endMessage(start);
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
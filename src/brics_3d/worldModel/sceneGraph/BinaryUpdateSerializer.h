@@ -0,0 +1,90 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#ifndef RSG_BINARYUPDATESERIALIZER_H_
+#define RSG_BINARYUPDATESERIALIZER_H_
+
+#include "brics_3d/core/Logger.h"
+#include "brics_3d/worldModel/sceneGraph/ISceneGraphUpdateObserver.h"
+#include "brics_3d/worldModel/sceneGraph/IPort.h"
+#include "brics_3d/worldModel/sceneGraph/SceneGraphUpdateBatch.h"
+#include "brics_3d/util/BinaryTypecaster.h"
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Serializes scene graph updates into the compact binary format of the BinaryTypecaster.
+ * @ingroup sceneGraph
+ *
+ * In contrast to the HDF5UpdateSerializer and the JSONSerializer a message only contains the raw
+ * values, e.g. 128 bytes for a setTransform (8 bytes header, 16 bytes ID, 8 bytes time stamp and
+ * 12 doubles for rotation and translation). Encoding does not allocate memory once the internal
+ * buffer has grown to the size of the largest message.
+ * Use the BinaryUpdateDeserializer on the receiving side.
+ */
+class BinaryUpdateSerializer : public ISceneGraphUpdateObserver {
+public:
+	BinaryUpdateSerializer(IOutputPort* port);
+	virtual ~BinaryUpdateSerializer();
+
+	bool addNode(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId = false);
+	bool addGroup(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId = false);
+	bool addTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp, bool forcedId = false);
+	bool addUncertainTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp, bool forcedId = false);
+	bool addGeometricNode(Id parentId, Id& assignedId, vector<Attribute> attributes, Shape::ShapePtr shape, TimeStamp timeStamp, bool forcedId = false);
+	bool addRemoteRootNode(Id rootId, vector<Attribute> attributes);
+	bool addConnection(Id parentId, Id& assignedId, vector<Attribute> attributes, vector<Id> sourceIds, vector<Id> targetIds, TimeStamp start, TimeStamp end, bool forcedId = false);
+	bool setNodeAttributes(Id id, vector<Attribute> newAttributes, TimeStamp timeStamp);
+	bool setTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp);
+	bool setUncertainTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp);
+	bool deleteNode(Id id);
+	bool addParent(Id id, Id parentId);
+	bool removeParent(Id id, Id parentId);
+
+	/**
+	 * @brief Serializes all updates of the batch into a single UPDATE_BATCH message.
+	 *
+	 * The payload of that message is the sequence of the regular messages for each update.
+	 */
+	bool applyUpdateBatch(const SceneGraphUpdateBatch& batch);
+
+protected:
+
+	/// Start a new message. Appends to the current batch message if one is being encoded.
+	size_t beginMessage(BinaryTypecaster::CommandType command);
+
+	/// Finalize the message and send it, unless it is part of a batch.
+	bool endMessage(size_t start);
+
+	IOutputPort* port;
+
+	/// Reused encoding buffer.
+	std::vector<char> buffer;
+
+	/// True while the updates of a batch are encoded.
+	bool batchMode;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_BINARYUPDATESERIALIZER_H_ */
+
+/* EOF */
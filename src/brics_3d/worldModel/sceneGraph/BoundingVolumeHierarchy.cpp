@@ -0,0 +1,858 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#include "BoundingVolumeHierarchy.h"
+#include "Transform.h"
+#include "Sphere.h"
+#include "Cylinder.h"
+#include "Box.h"
+#include "Mesh.h"
+#include "brics_3d/core/Logger.h"
+#include "brics_3d/core/HomogeneousMatrix44.h"
+#include "brics_3d/core/ITriangleMesh.h"
+
+#include <math.h>
+#include <limits>
+#include <queue>
+#include <set>
+#include <algorithm>
+
+namespace brics_3d {
+namespace rsg {
+
+const double BoundingVolumeHierarchy::defaultMargin = 0.1;
+
+BoundingVolumeHierarchy::BoundingBox::BoundingBox() {
+	for (int i = 0; i < 3; ++i) {
+		min[i] = std::numeric_limits<double>::max();
+		max[i] = -std::numeric_limits<double>::max();
+	}
+}
+
+void BoundingVolumeHierarchy::BoundingBox::extend(double x, double y, double z) {
+	min[0] = std::min(min[0], x);
+	min[1] = std::min(min[1], y);
+	min[2] = std::min(min[2], z);
+	max[0] = std::max(max[0], x);
+	max[1] = std::max(max[1], y);
+	max[2] = std::max(max[2], z);
+}
+
+void BoundingVolumeHierarchy::BoundingBox::extend(const BoundingBox& box) {
+	for (int i = 0; i < 3; ++i) {
+		min[i] = std::min(min[i], box.min[i]);
+		max[i] = std::max(max[i], box.max[i]);
+	}
+}
+
+void BoundingVolumeHierarchy::BoundingBox::enlarge(double margin) {
+	if (isEmpty()) {
+		return;
+	}
+	for (int i = 0; i < 3; ++i) {
+		min[i] -= margin;
+		max[i] += margin;
+	}
+}
+
+bool BoundingVolumeHierarchy::BoundingBox::isEmpty() const {
+	return (min[0] > max[0]) || (min[1] > max[1]) || (min[2] > max[2]);
+}
+
+bool BoundingVolumeHierarchy::BoundingBox::contains(const BoundingBox& box) const {
+	for (int i = 0; i < 3; ++i) {
+		if ((box.min[i] < min[i]) || (box.max[i] > max[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool BoundingVolumeHierarchy::BoundingBox::overlaps(const BoundingBox& box) const {
+	for (int i = 0; i < 3; ++i) {
+		if ((box.max[i] < min[i]) || (box.min[i] > max[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+double BoundingVolumeHierarchy::BoundingBox::getSquaredDistance(const double point[3]) const {
+	double squaredDistance = 0.0;
+	for (int i = 0; i < 3; ++i) {
+		double delta = 0.0;
+		if (point[i] < min[i]) {
+			delta = min[i] - point[i];
+		} else if (point[i] > max[i]) {
+			delta = point[i] - max[i];
+		}
+		squaredDistance += delta * delta;
+	}
+	return squaredDistance;
+}
+
+double BoundingVolumeHierarchy::BoundingBox::getHalfSurfaceArea() const {
+	if (isEmpty()) {
+		return 0.0;
+	}
+	double dx = max[0] - min[0];
+	double dy = max[1] - min[1];
+	double dz = max[2] - min[2];
+	return dx * dy + dy * dz + dz * dx;
+}
+
+bool BoundingVolumeHierarchy::BoundingBox::intersectRay(const double origin[3], const double inverseDirection[3], double maxDistance, double& distance) const {
+	double entry = 0.0;
+	double exit = maxDistance;
+	for (int i = 0; i < 3; ++i) {
+		if (fabs(inverseDirection[i]) > std::numeric_limits<double>::max()) { // parallel to the slab
+			if ((origin[i] < min[i]) || (origin[i] > max[i])) {
+				return false;
+			}
+			continue;
+		}
+		double t1 = (min[i] - origin[i]) * inverseDirection[i];
+		double t2 = (max[i] - origin[i]) * inverseDirection[i];
+		if (t1 > t2) {
+			std::swap(t1, t2);
+		}
+		entry = std::max(entry, t1);
+		exit = std::min(exit, t2);
+		if (entry > exit) {
+			return false;
+		}
+	}
+	distance = entry;
+	return true;
+}
+
+BoundingVolumeHierarchy::BoundingBox BoundingVolumeHierarchy::BoundingBox::transform(const double* matrix) const {
+	BoundingBox result;
+	if (isEmpty()) {
+		return result;
+	}
+
+	/* Transform the center and project the extents onto the new axes (Arvo) */
+	for (int i = 0; i < 3; ++i) {
+		double center = matrix[matrixEntry::x + i];
+		double extent = 0.0;
+		for (int j = 0; j < 3; ++j) {
+			double rotation = matrix[i + 4 * j];
+			center += rotation * 0.5 * (min[j] + max[j]);
+			extent += fabs(rotation) * 0.5 * (max[j] - min[j]);
+		}
+		result.min[i] = center - extent;
+		result.max[i] = center + extent;
+	}
+	return result;
+}
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy() : root(nullNode), freeList(nullNode),
+		margin(defaultMargin), boundingBoxComputations(0) {
+
+}
+
+BoundingVolumeHierarchy::~BoundingVolumeHierarchy() {
+
+}
+
+void BoundingVolumeHierarchy::addGeometricNode(GeometricNode::GeometricNodePtr node) {
+	if (node == 0) {
+		return;
+	}
+	Id id = node->getId();
+	std::map<Id, Entry>::iterator existing = entries.find(id);
+	if (existing != entries.end()) {
+		removeEntry(existing);
+	}
+
+	/* Everything else, including the box of the shape, is computed on the next query */
+	Entry& entry = entries[id];
+	entry.node = node;
+	entry.isStructureDirty = true;
+	dirtyNodes.push_back(id);
+}
+
+void BoundingVolumeHierarchy::transformChanged(Id id) {
+	std::map<Id, std::set<Id> >::iterator dependents = dependentNodes.find(id);
+	if (dependents == dependentNodes.end()) {
+		return;
+	}
+	for (std::set<Id>::iterator it = dependents->second.begin(); it != dependents->second.end(); ++it) {
+		std::map<Id, Entry>::iterator entry = entries.find(*it);
+		if (entry != entries.end()) {
+			markDirty(entry->first, entry->second, false);
+		}
+	}
+}
+
+void BoundingVolumeHierarchy::structureChanged(Id id) {
+	std::map<Id, Entry>::iterator entry = entries.find(id);
+	if (entry != entries.end()) {
+		markDirty(entry->first, entry->second, true);
+	}
+
+	std::map<Id, std::set<Id> >::iterator dependents = dependentNodes.find(id);
+	if (dependents == dependentNodes.end()) {
+		return;
+	}
+	for (std::set<Id>::iterator it = dependents->second.begin(); it != dependents->second.end(); ++it) {
+		entry = entries.find(*it);
+		if (entry != entries.end()) {
+			markDirty(entry->first, entry->second, true);
+		}
+	}
+}
+
+void BoundingVolumeHierarchy::clear() {
+	nodes.clear();
+	root = nullNode;
+	freeList = nullNode;
+	entries.clear();
+	dependentNodes.clear();
+	dirtyNodes.clear();
+}
+
+void BoundingVolumeHierarchy::update() {
+	for (vector<Id>::iterator it = dirtyNodes.begin(); it != dirtyNodes.end(); ++it) {
+		std::map<Id, Entry>::iterator entry = entries.find(*it);
+		if ((entry == entries.end()) || !entry->second.isDirty) {
+			continue;
+		}
+		if (entry->second.isStructureDirty) {
+			releaseAncestors(entry->first, entry->second);
+			collectAncestors(entry->first, entry->second);
+			entry->second.isStructureDirty = false;
+		}
+		if (!updateEntry(entry->first, entry->second)) {
+			if (entry->second.node.expired()) { // deleted
+				removeEntry(entry);
+			} else { // detached from the graph, but it might get a parent again
+				detachEntry(entry->first, entry->second);
+			}
+		}
+	}
+	dirtyNodes.clear();
+}
+
+void BoundingVolumeHierarchy::getNodesInRadius(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr referenceTransform, const Point3D& center, double radius, vector<Id>& ids) {
+	ids.clear();
+	update();
+	if (root == nullNode || radius < 0.0) {
+		return;
+	}
+
+	double matrix[16];
+	getRawData(referenceTransform, matrix);
+	BoundingBox query;
+	query.extend(center.getX(), center.getY(), center.getZ());
+	query = query.transform(matrix);
+	const double* point = query.min;
+	double squaredRadius = radius * radius;
+
+	vector<int> open;
+	open.push_back(root);
+	while (!open.empty()) {
+		const TreeNode& node = nodes[open.back()];
+		open.pop_back();
+		if (node.box.getSquaredDistance(point) > squaredRadius) {
+			continue;
+		}
+		if (node.isLeaf()) {
+			if (node.tightBox.getSquaredDistance(point) <= squaredRadius) {
+				ids.push_back(node.id);
+			}
+		} else {
+			open.push_back(node.child1);
+			open.push_back(node.child2);
+		}
+	}
+}
+
+void BoundingVolumeHierarchy::getNodesInBox(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr referenceTransform, const Point3D& minPoint, const Point3D& maxPoint, vector<Id>& ids) {
+	ids.clear();
+	update();
+	BoundingBox query;
+	query.extend(minPoint.getX(), minPoint.getY(), minPoint.getZ());
+	query.extend(maxPoint.getX(), maxPoint.getY(), maxPoint.getZ());
+	if (root == nullNode) {
+		return;
+	}
+
+	/* Search in the root frame with the enclosing box, then check the candidates in the reference frame */
+	double matrix[16];
+	double inverseMatrix[16];
+	getRawData(referenceTransform, matrix);
+	HomogeneousMatrix44 inverseTransform;
+	if (referenceTransform != 0) {
+		inverseTransform = *referenceTransform;
+		inverseTransform.inverse();
+	}
+	for (int i = 0; i < 16; ++i) {
+		inverseMatrix[i] = inverseTransform.getRawData()[i];
+	}
+	BoundingBox worldQuery = query.transform(matrix);
+
+	vector<int> open;
+	open.push_back(root);
+	while (!open.empty()) {
+		const TreeNode& node = nodes[open.back()];
+		open.pop_back();
+		if (!node.box.overlaps(worldQuery)) {
+			continue;
+		}
+		if (node.isLeaf()) {
+			if (node.tightBox.overlaps(worldQuery) && node.tightBox.transform(inverseMatrix).overlaps(query)) {
+				ids.push_back(node.id);
+			}
+		} else {
+			open.push_back(node.child1);
+			open.push_back(node.child2);
+		}
+	}
+}
+
+void BoundingVolumeHierarchy::getNearestNodes(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr referenceTransform, const Point3D& point, unsigned int k, vector<Id>& ids, vector<double>& distances) {
+	ids.clear();
+	distances.clear();
+	update();
+	if (root == nullNode || k == 0) {
+		return;
+	}
+
+	double matrix[16];
+	getRawData(referenceTransform, matrix);
+	BoundingBox query;
+	query.extend(point.getX(), point.getY(), point.getZ());
+	query = query.transform(matrix);
+	const double* worldPoint = query.min;
+
+	/*
+	 * Best first search: the box of an inner node is never further away than the boxes below it.
+	 * Leaves are queued with their tight box, so a leaf on top of the queue is the next nearest node.
+	 */
+	typedef std::pair<double, int> QueueEntry;
+	std::priority_queue<QueueEntry, vector<QueueEntry>, std::greater<QueueEntry> > open;
+	open.push(QueueEntry(nodes[root].isLeaf() ? nodes[root].tightBox.getSquaredDistance(worldPoint) : nodes[root].box.getSquaredDistance(worldPoint), root));
+	while (!open.empty() && ids.size() < k) {
+		QueueEntry current = open.top();
+		open.pop();
+		const TreeNode& node = nodes[current.second];
+		if (node.isLeaf()) {
+			ids.push_back(node.id);
+			distances.push_back(sqrt(current.first));
+			continue;
+		}
+		int children[2] = {node.child1, node.child2};
+		for (int i = 0; i < 2; ++i) {
+			const TreeNode& child = nodes[children[i]];
+			open.push(QueueEntry(child.isLeaf() ? child.tightBox.getSquaredDistance(worldPoint) : child.box.getSquaredDistance(worldPoint), children[i]));
+		}
+	}
+}
+
+void BoundingVolumeHierarchy::getNodesAlongRay(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr referenceTransform, const Point3D& origin, const Point3D& direction, double maxDistance, vector<Id>& ids, vector<double>& distances) {
+	ids.clear();
+	distances.clear();
+	update();
+	if (root == nullNode || maxDistance < 0.0) {
+		return;
+	}
+
+	double matrix[16];
+	getRawData(referenceTransform, matrix);
+	double localOrigin[3] = {origin.getX(), origin.getY(), origin.getZ()};
+	double localDirection[3] = {direction.getX(), direction.getY(), direction.getZ()};
+	double worldOrigin[3];
+	double worldDirection[3];
+	double length = 0.0;
+	for (int i = 0; i < 3; ++i) {
+		worldOrigin[i] = matrix[matrixEntry::x + i];
+		worldDirection[i] = 0.0;
+		for (int j = 0; j < 3; ++j) {
+			worldOrigin[i] += matrix[i + 4 * j] * localOrigin[j];
+			worldDirection[i] += matrix[i + 4 * j] * localDirection[j];
+		}
+		length += worldDirection[i] * worldDirection[i];
+	}
+	length = sqrt(length);
+	if (length <= 0.0) {
+		LOG(WARNING) << "BoundingVolumeHierarchy: The direction of the ray is zero.";
+		return;
+	}
+	double inverseDirection[3];
+	for (int i = 0; i < 3; ++i) {
+		inverseDirection[i] = (worldDirection[i] == 0.0) ? std::numeric_limits<double>::infinity() : length / worldDirection[i];
+	}
+
+	vector<std::pair<double, Id> > hits;
+	vector<int> open;
+	open.push_back(root);
+	double distance;
+	while (!open.empty()) {
+		const TreeNode& node = nodes[open.back()];
+		open.pop_back();
+		if (!node.box.intersectRay(worldOrigin, inverseDirection, maxDistance, distance)) {
+			continue;
+		}
+		if (node.isLeaf()) {
+			if (node.tightBox.intersectRay(worldOrigin, inverseDirection, maxDistance, distance)) {
+				hits.push_back(std::make_pair(distance, node.id));
+			}
+		} else {
+			open.push_back(node.child1);
+			open.push_back(node.child2);
+		}
+	}
+
+	std::sort(hits.begin(), hits.end());
+	for (vector<std::pair<double, Id> >::iterator it = hits.begin(); it != hits.end(); ++it) {
+		distances.push_back(it->first);
+		ids.push_back(it->second);
+	}
+}
+
+bool BoundingVolumeHierarchy::getBoundingBox(Id id, BoundingBox& box) {
+	update();
+	std::map<Id, Entry>::iterator entry = entries.find(id);
+	if ((entry == entries.end()) || (entry->second.leaf == nullNode)) {
+		return false;
+	}
+	box = nodes[entry->second.leaf].tightBox;
+	return true;
+}
+
+BoundingVolumeHierarchy::BoundingBox BoundingVolumeHierarchy::computeLocalBoundingBox(Shape::ShapePtr shape) {
+	BoundingBox box;
+	if (shape == 0) {
+		box.extend(0, 0, 0);
+		return box;
+	}
+
+	switch (shape->getShapeType()) {
+		case Shape::Sphere: {
+			double r = static_cast<rsg::Sphere*>(shape.get())->getRadius();
+			box.extend(-r, -r, -r);
+			box.extend(r, r, r);
+			break;
+		}
+		case Shape::Cylinder: { // centered, along the z axis
+			rsg::Cylinder* cylinder = static_cast<rsg::Cylinder*>(shape.get());
+			double r = cylinder->getRadius();
+			double h = 0.5 * cylinder->getHeight();
+			box.extend(-r, -r, -h);
+			box.extend(r, r, h);
+			break;
+		}
+		case Shape::Box: { // centered
+			rsg::Box* boxShape = static_cast<rsg::Box*>(shape.get());
+			box.extend(-0.5 * boxShape->getSizeX(), -0.5 * boxShape->getSizeY(), -0.5 * boxShape->getSizeZ());
+			box.extend(0.5 * boxShape->getSizeX(), 0.5 * boxShape->getSizeY(), 0.5 * boxShape->getSizeZ());
+			break;
+		}
+		case Shape::PointCloud: {
+			IPoint3DIterator::IPoint3DIteratorPtr it = shape->getPointCloudIterator();
+			if (it == 0) {
+				break;
+			}
+			Coordinate block[3 * IPoint3DIterator::defaultBlockSize];
+			unsigned int count;
+			for (it->begin(); (count = it->nextBlock(block, IPoint3DIterator::defaultBlockSize)) > 0; ) {
+				for (unsigned int i = 0; i < count; ++i) {
+					box.extend(block[3*i], block[3*i + 1], block[3*i + 2]);
+				}
+			}
+			break;
+		}
+		case Shape::Mesh: {
+			rsg::Mesh<brics_3d::ITriangleMesh>* mesh = dynamic_cast<rsg::Mesh<brics_3d::ITriangleMesh>*>(shape.get());
+			if (mesh == 0 || mesh->data == 0) {
+				break;
+			}
+			for (int i = 0; i < mesh->data->getSize(); ++i) {
+				for (int j = 0; j < 3; ++j) {
+					Point3D* vertex = mesh->data->getTriangleVertex(i, j);
+					box.extend(vertex->getX(), vertex->getY(), vertex->getZ());
+				}
+			}
+			break;
+		}
+		default:
+			LOG(DEBUG) << "BoundingVolumeHierarchy: Shape type not supported. Using the origin of the node instead.";
+			break;
+	}
+
+	if (box.isEmpty()) { // e.g. an empty point cloud
+		box.extend(0, 0, 0);
+	}
+	return box;
+}
+
+int BoundingVolumeHierarchy::getHeight() const {
+	if (root == nullNode) {
+		return 0;
+	}
+	return nodes[root].height;
+}
+
+void BoundingVolumeHierarchy::collectAncestors(Id id, Entry& entry) {
+	entry.ancestors.clear();
+	Node::NodePtr node = entry.node.lock();
+	if (node == 0) {
+		return;
+	}
+
+	std::set<Node*> visited;
+	vector<Node*> open;
+	open.push_back(node.get());
+	while (!open.empty()) {
+		Node* current = open.back();
+		open.pop_back();
+		for (unsigned int i = 0; i < current->getNumberOfParents(); ++i) {
+			Node* parent = current->getParent(i);
+			if (!visited.insert(parent).second) {
+				continue;
+			}
+			entry.ancestors.push_back(parent->getId());
+			dependentNodes[parent->getId()].insert(id);
+			open.push_back(parent);
+		}
+	}
+}
+
+void BoundingVolumeHierarchy::releaseAncestors(Id id, Entry& entry) {
+	for (vector<Id>::iterator it = entry.ancestors.begin(); it != entry.ancestors.end(); ++it) {
+		std::map<Id, std::set<Id> >::iterator dependents = dependentNodes.find(*it);
+		if (dependents == dependentNodes.end()) {
+			continue;
+		}
+		dependents->second.erase(id);
+		if (dependents->second.empty()) {
+			dependentNodes.erase(dependents);
+		}
+	}
+	entry.ancestors.clear();
+}
+
+void BoundingVolumeHierarchy::markDirty(Id id, Entry& entry, bool structureChanged) {
+	if (structureChanged) {
+		entry.isStructureDirty = true;
+	}
+	if (!entry.isDirty) {
+		entry.isDirty = true;
+		dirtyNodes.push_back(id);
+	}
+}
+
+bool BoundingVolumeHierarchy::updateEntry(Id id, Entry& entry) {
+	Node::NodePtr node = entry.node.lock();
+	if ((node == 0) || (node->getNumberOfParents() == 0)) {
+		return false;
+	}
+
+	if (!entry.hasLocalBox) {
+		GeometricNode::GeometricNodePtr geometricNode = boost::dynamic_pointer_cast<GeometricNode>(node);
+		entry.localBox = computeLocalBoundingBox((geometricNode != 0) ? geometricNode->getShape() : Shape::ShapePtr());
+		entry.hasLocalBox = true;
+	}
+
+	TimeStamp actualTimeStamp;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr globalTransform = getGlobalTransform(node, TimeStamp(std::numeric_limits<double>::max()), actualTimeStamp);
+	BoundingBox box = entry.localBox.transform(globalTransform->getRawData());
+	boundingBoxComputations++;
+	entry.isDirty = false;
+
+	if (entry.leaf == nullNode) {
+		entry.leaf = allocateNode();
+		nodes[entry.leaf].id = id;
+		nodes[entry.leaf].tightBox = box;
+		nodes[entry.leaf].box = box;
+		nodes[entry.leaf].box.enlarge(margin);
+		insertLeaf(entry.leaf);
+	} else {
+		TreeNode& leaf = nodes[entry.leaf];
+		leaf.tightBox = box;
+		if (!leaf.box.contains(box)) { // moved beyond the margin
+			removeLeaf(entry.leaf);
+			nodes[entry.leaf].box = box;
+			nodes[entry.leaf].box.enlarge(margin);
+			insertLeaf(entry.leaf);
+		}
+	}
+	return true;
+}
+
+void BoundingVolumeHierarchy::detachEntry(Id id, Entry& entry) {
+	releaseAncestors(id, entry);
+	if (entry.leaf != nullNode) {
+		removeLeaf(entry.leaf);
+		freeNode(entry.leaf);
+		entry.leaf = nullNode;
+	}
+	entry.isDirty = false;
+	entry.isStructureDirty = true; // structureChanged() is called as soon as a parent is added
+}
+
+void BoundingVolumeHierarchy::removeEntry(std::map<Id, Entry>::iterator entry) {
+	releaseAncestors(entry->first, entry->second);
+	if (entry->second.leaf != nullNode) {
+		removeLeaf(entry->second.leaf);
+		freeNode(entry->second.leaf);
+	}
+	entries.erase(entry);
+}
+
+int BoundingVolumeHierarchy::allocateNode() {
+	int index;
+	if (freeList != nullNode) {
+		index = freeList;
+		freeList = nodes[index].parent;
+		nodes[index] = TreeNode();
+	} else {
+		index = static_cast<int>(nodes.size());
+		nodes.push_back(TreeNode());
+	}
+	return index;
+}
+
+void BoundingVolumeHierarchy::freeNode(int index) {
+	nodes[index] = TreeNode();
+	nodes[index].height = -1;
+	nodes[index].parent = freeList;
+	freeList = index;
+}
+
+void BoundingVolumeHierarchy::insertLeaf(int leaf) {
+	if (root == nullNode) {
+		root = leaf;
+		nodes[root].parent = nullNode;
+		return;
+	}
+
+	/* Descend to the sibling with the least increase of the surface */
+	BoundingBox leafBox = nodes[leaf].box;
+	int index = root;
+	while (!nodes[index].isLeaf()) {
+		const TreeNode& node = nodes[index];
+		BoundingBox combined = node.box;
+		combined.extend(leafBox);
+		double combinedArea = combined.getHalfSurfaceArea();
+
+		double cost = 2.0 * combinedArea; // make leaf and node siblings
+		double inheritanceCost = 2.0 * (combinedArea - node.box.getHalfSurfaceArea()); // pushing the leaf further down
+
+		double childCosts[2];
+		int children[2] = {node.child1, node.child2};
+		for (int i = 0; i < 2; ++i) {
+			const TreeNode& child = nodes[children[i]];
+			BoundingBox extendedChild = child.box;
+			extendedChild.extend(leafBox);
+			childCosts[i] = extendedChild.getHalfSurfaceArea() + inheritanceCost;
+			if (!child.isLeaf()) {
+				childCosts[i] -= child.box.getHalfSurfaceArea();
+			}
+		}
+
+		if ((cost < childCosts[0]) && (cost < childCosts[1])) {
+			break;
+		}
+		index = (childCosts[0] < childCosts[1]) ? children[0] : children[1];
+	}
+	int sibling = index;
+
+	/* New parent for the leaf and its sibling */
+	int oldParent = nodes[sibling].parent;
+	int newParent = allocateNode();
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].box = leafBox;
+	nodes[newParent].box.extend(nodes[sibling].box);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+	if (oldParent != nullNode) {
+		if (nodes[oldParent].child1 == sibling) {
+			nodes[oldParent].child1 = newParent;
+		} else {
+			nodes[oldParent].child2 = newParent;
+		}
+	} else {
+		root = newParent;
+	}
+
+	refitAncestors(nodes[leaf].parent);
+}
+
+void BoundingVolumeHierarchy::removeLeaf(int leaf) {
+	if (leaf == root) {
+		root = nullNode;
+		return;
+	}
+
+	int parent = nodes[leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = (nodes[parent].child1 == leaf) ? nodes[parent].child2 : nodes[parent].child1;
+
+	if (grandParent != nullNode) {
+		if (nodes[grandParent].child1 == parent) {
+			nodes[grandParent].child1 = sibling;
+		} else {
+			nodes[grandParent].child2 = sibling;
+		}
+		nodes[sibling].parent = grandParent;
+		freeNode(parent);
+		refitAncestors(grandParent);
+	} else {
+		root = sibling;
+		nodes[sibling].parent = nullNode;
+		freeNode(parent);
+	}
+	nodes[leaf].parent = nullNode;
+}
+
+void BoundingVolumeHierarchy::refitAncestors(int index) {
+	while (index != nullNode) {
+		index = balance(index);
+		TreeNode& node = nodes[index];
+		node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+		node.box = nodes[node.child1].box;
+		node.box.extend(nodes[node.child2].box);
+		index = node.parent;
+	}
+}
+
+int BoundingVolumeHierarchy::balance(int indexA) {
+	TreeNode& a = nodes[indexA];
+	if (a.isLeaf() || a.height < 2) {
+		return indexA;
+	}
+
+	int indexB = a.child1;
+	int indexC = a.child2;
+	TreeNode& b = nodes[indexB];
+	TreeNode& c = nodes[indexC];
+	int heightDifference = c.height - b.height;
+
+	if (heightDifference > 1) { // rotate C up
+		int indexF = c.child1;
+		int indexG = c.child2;
+		TreeNode& f = nodes[indexF];
+		TreeNode& g = nodes[indexG];
+
+		c.child1 = indexA;
+		c.parent = a.parent;
+		a.parent = indexC;
+		if (c.parent != nullNode) {
+			if (nodes[c.parent].child1 == indexA) {
+				nodes[c.parent].child1 = indexC;
+			} else {
+				nodes[c.parent].child2 = indexC;
+			}
+		} else {
+			root = indexC;
+		}
+
+		if (f.height > g.height) {
+			c.child2 = indexF;
+			a.child2 = indexG;
+			g.parent = indexA;
+			a.box = b.box;
+			a.box.extend(g.box);
+			c.box = a.box;
+			c.box.extend(f.box);
+			a.height = 1 + std::max(b.height, g.height);
+			c.height = 1 + std::max(a.height, f.height);
+		} else {
+			c.child2 = indexG;
+			a.child2 = indexF;
+			f.parent = indexA;
+			a.box = b.box;
+			a.box.extend(f.box);
+			c.box = a.box;
+			c.box.extend(g.box);
+			a.height = 1 + std::max(b.height, f.height);
+			c.height = 1 + std::max(a.height, g.height);
+		}
+		return indexC;
+	}
+
+	if (heightDifference < -1) { // rotate B up
+		int indexD = b.child1;
+		int indexE = b.child2;
+		TreeNode& d = nodes[indexD];
+		TreeNode& e = nodes[indexE];
+
+		b.child1 = indexA;
+		b.parent = a.parent;
+		a.parent = indexB;
+		if (b.parent != nullNode) {
+			if (nodes[b.parent].child1 == indexA) {
+				nodes[b.parent].child1 = indexB;
+			} else {
+				nodes[b.parent].child2 = indexB;
+			}
+		} else {
+			root = indexB;
+		}
+
+		if (d.height > e.height) {
+			b.child2 = indexD;
+			a.child1 = indexE;
+			e.parent = indexA;
+			a.box = c.box;
+			a.box.extend(e.box);
+			b.box = a.box;
+			b.box.extend(d.box);
+			a.height = 1 + std::max(c.height, e.height);
+			b.height = 1 + std::max(a.height, d.height);
+		} else {
+			b.child2 = indexE;
+			a.child1 = indexD;
+			d.parent = indexA;
+			a.box = c.box;
+			a.box.extend(d.box);
+			b.box = a.box;
+			b.box.extend(e.box);
+			a.height = 1 + std::max(c.height, d.height);
+			b.height = 1 + std::max(a.height, e.height);
+		}
+		return indexB;
+	}
+
+	return indexA;
+}
+
+void BoundingVolumeHierarchy::getRawData(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, double* matrix) {
+	for (int i = 0; i < 16; ++i) {
+		matrix[i] = (i % 5 == 0) ? 1.0 : 0.0; // identity
+	}
+	if (transform != 0) {
+		const double* data = transform->getRawData();
+		for (int i = 0; i < 16; ++i) {
+			matrix[i] = data[i];
+		}
+	}
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
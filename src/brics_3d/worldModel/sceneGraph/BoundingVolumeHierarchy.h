@@ -0,0 +1,281 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#ifndef RSG_BOUNDINGVOLUMEHIERARCHY_H_
+#define RSG_BOUNDINGVOLUMEHIERARCHY_H_
+
+#include "GeometricNode.h"
+#include "brics_3d/core/IHomogeneousMatrix44.h"
+#include "brics_3d/core/Point3D.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Spatial index over the bounding volumes of all GeometricNodes of a scene graph.
+ * @ingroup sceneGraph
+ *
+ * Every GeometricNode is represented by the axis aligned bounding box of its shape in the frame of
+ * the root node. The boxes are organized in a dynamic AABB tree: leaves are inserted at the sibling
+ * with the least increase of the surface and the tree is kept balanced by rotations, so insertions,
+ * removals and queries are logarithmic in the number of nodes.
+ *
+ * The hierarchy is kept up to date incrementally by the SceneGraphFacade:
+ *  - addGeometricNode() registers a new node. Its leaf, and the box of its shape, is computed on the next query,
+ *    so adding e.g. large point clouds does not pay for an extra pass over the data if the index is never queried.
+ *  - transformChanged() marks all GeometricNodes below a Transform as dirty. This is a look up only,
+ *    the boxes are recomputed lazily on the next query.
+ *  - structureChanged() marks a node and all GeometricNodes below it. Only their ancestors are collected
+ *    again on the next query. Nodes that have been deleted are removed then. Nodes that have been detached
+ *    from the graph are kept, but not found by the queries, until a parent is added to them again.
+ *
+ * Leaves are enlarged by a margin. A box that moves within the margin of its leaf does not change the tree.
+ *
+ * The queries are expressed in the frame of a reference node and always use the latest transforms.
+ * Their results are conservative with respect to the shapes: they refer to the bounding boxes.
+ */
+class BoundingVolumeHierarchy {
+public:
+
+	/// Axis aligned bounding box.
+	struct BoundingBox {
+		BoundingBox();
+
+		/// Extend the box such that it contains the point.
+		void extend(double x, double y, double z);
+
+		/// Extend the box such that it contains the other box.
+		void extend(const BoundingBox& box);
+
+		/// Enlarge all sides by a margin.
+		void enlarge(double margin);
+
+		bool isEmpty() const;
+		bool contains(const BoundingBox& box) const;
+		bool overlaps(const BoundingBox& box) const;
+
+		/// Squared distance between the point and the box. Zero for points within the box.
+		double getSquaredDistance(const double point[3]) const;
+
+		/// Half of the surface area. Cost measure for the tree construction.
+		double getHalfSurfaceArea() const;
+
+		/**
+		 * @brief Check if a ray hits the box.
+		 * @param[in] origin Start of the ray.
+		 * @param[in] inverseDirection Component wise inverse of the normalized direction.
+		 * @param[in] maxDistance Maximum length of the ray.
+		 * @param[out] distance Distance from the origin to the entry point. Zero if the origin is within the box.
+		 * @return True if the box is hit.
+		 */
+		bool intersectRay(const double origin[3], const double inverseDirection[3], double maxDistance, double& distance) const;
+
+		/// The box that contains the transformed box.
+		BoundingBox transform(const double* matrix) const;
+
+		double min[3];
+		double max[3];
+	};
+
+	/// Default margin of the leaves in [m].
+	static const double defaultMargin;
+
+	BoundingVolumeHierarchy();
+	virtual ~BoundingVolumeHierarchy();
+
+	/* Updates */
+
+	/// Insert a new GeometricNode. It is added to the tree on the next query.
+	void addGeometricNode(GeometricNode::GeometricNodePtr node);
+
+	/// Notify that a Transform has been updated.
+	void transformChanged(Id id);
+
+	/// Notify that a node has been deleted or that a parent has been added to or removed from it.
+	void structureChanged(Id id);
+
+	/// Remove all nodes.
+	void clear();
+
+	/// Recompute all dirty bounding boxes and update the tree accordingly. Called by all queries.
+	void update();
+
+	/* Queries */
+
+	/**
+	 * @brief Find all GeometricNodes whose bounding box is within a radius around a point.
+	 * @param[in] referenceTransform Transform from the reference frame to the root frame.
+	 * @param[in] center Center expressed in the reference frame.
+	 * @param[in] radius Radius in [m].
+	 * @param[out] ids The found nodes.
+	 */
+	void getNodesInRadius(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr referenceTransform, const Point3D& center, double radius, vector<Id>& ids);
+
+	/**
+	 * @brief Find all GeometricNodes whose bounding box overlaps with an axis aligned box of the reference frame.
+	 * @param[in] referenceTransform Transform from the reference frame to the root frame.
+	 * @param[in] minPoint Minimum corner of the box expressed in the reference frame.
+	 * @param[in] maxPoint Maximum corner of the box expressed in the reference frame.
+	 * @param[out] ids The found nodes.
+	 */
+	void getNodesInBox(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr referenceTransform, const Point3D& minPoint, const Point3D& maxPoint, vector<Id>& ids);
+
+	/**
+	 * @brief Find the k GeometricNodes with the closest bounding boxes.
+	 * @param[in] referenceTransform Transform from the reference frame to the root frame.
+	 * @param[in] point Query point expressed in the reference frame.
+	 * @param[in] k Maximum number of nodes.
+	 * @param[out] ids The found nodes, ordered by ascending distance.
+	 * @param[out] distances Distance in [m] to the bounding box for each of the ids.
+	 */
+	void getNearestNodes(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr referenceTransform, const Point3D& point, unsigned int k, vector<Id>& ids, vector<double>& distances);
+
+	/**
+	 * @brief Find all GeometricNodes whose bounding box is hit by a ray.
+	 * @param[in] referenceTransform Transform from the reference frame to the root frame.
+	 * @param[in] origin Start of the ray expressed in the reference frame.
+	 * @param[in] direction Direction of the ray expressed in the reference frame. Does not need to be normalized.
+	 * @param[in] maxDistance Maximum length of the ray in [m].
+	 * @param[out] ids The hit nodes, ordered by ascending distance.
+	 * @param[out] distances Distance in [m] from the origin to the entry point into the bounding box for each of the ids.
+	 */
+	void getNodesAlongRay(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr referenceTransform, const Point3D& origin, const Point3D& direction, double maxDistance, vector<Id>& ids, vector<double>& distances);
+
+	/// Bounding box of a GeometricNode in the root frame.
+	bool getBoundingBox(Id id, BoundingBox& box);
+
+	/// Bounding box of a shape in its own frame. Empty for unknown shapes.
+	static BoundingBox computeLocalBoundingBox(Shape::ShapePtr shape);
+
+	/// Number of GeometricNodes, including the ones that are currently detached from the graph.
+	unsigned int getNumberOfNodes() const {
+		return static_cast<unsigned int>(entries.size());
+	}
+
+	/// Height of the tree. A tree with a single leaf has height 0.
+	int getHeight() const;
+
+	/// Number of computed bounding boxes in the root frame. Useful for debugging and tests.
+	unsigned int getBoundingBoxComputations() const {
+		return boundingBoxComputations;
+	}
+
+	double getMargin() const {
+		return margin;
+	}
+
+	/// Margin of the leaves in [m]. Applies to leaves that are inserted afterwards.
+	void setMargin(double margin) {
+		this->margin = margin;
+	}
+
+private:
+
+	static const int nullNode = -1;
+
+	struct TreeNode {
+		TreeNode() : parent(nullNode), child1(nullNode), child2(nullNode), height(0) {};
+
+		bool isLeaf() const {
+			return child1 == nullNode;
+		}
+
+		/// Enlarged box for leaves, union of the children for inner nodes. Unused nodes link the free list via parent.
+		BoundingBox box;
+		int parent;
+		int child1;
+		int child2;
+		int height;
+
+		/* Leaves only */
+		Id id;
+		BoundingBox tightBox;
+	};
+
+	struct Entry {
+		Entry() : hasLocalBox(false), leaf(nullNode), isDirty(true), isStructureDirty(false) {};
+
+		Node::NodeWeakPtr node;
+
+		/// Box of the shape in the frame of the GeometricNode. Computed on the first update.
+		BoundingBox localBox;
+		bool hasLocalBox;
+
+		/// All nodes above the node.
+		vector<Id> ancestors;
+		int leaf;
+		bool isDirty;
+
+		/// The ancestors have to be collected again.
+		bool isStructureDirty;
+	};
+
+	/// Memorize the nodes above a node.
+	void collectAncestors(Id id, Entry& entry);
+
+	/// Forget the memorized ancestors of a node.
+	void releaseAncestors(Id id, Entry& entry);
+
+	/// Mark a node as dirty, optionally including its ancestors.
+	void markDirty(Id id, Entry& entry, bool structureChanged);
+
+	/// Recompute the box of a node in the root frame and move its leaf if necessary.
+	bool updateEntry(Id id, Entry& entry);
+
+	/// Remove the leaf of a node that has no parents anymore, but keep the node.
+	void detachEntry(Id id, Entry& entry);
+
+	void removeEntry(std::map<Id, Entry>::iterator entry);
+
+	/* Dynamic tree */
+	int allocateNode();
+	void freeNode(int index);
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	int balance(int index);
+	void refitAncestors(int index);
+
+	/// Transform from the reference frame to the root frame as raw data. Identity if no transform is given.
+	static void getRawData(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, double* matrix);
+
+	std::vector<TreeNode> nodes;
+	int root;
+	int freeList;
+
+	std::map<Id, Entry> entries;
+
+	/// Maps a node to the GeometricNodes below it.
+	std::map<Id, std::set<Id> > dependentNodes;
+	vector<Id> dirtyNodes;
+
+	double margin;
+	unsigned int boundingBoxComputations;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_BOUNDINGVOLUMEHIERARCHY_H_ */
+
+/* EOF */
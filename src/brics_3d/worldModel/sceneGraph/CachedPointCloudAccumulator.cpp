@@ -0,0 +1,376 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#include "CachedPointCloudAccumulator.h"
+#include "INodeVisitor.h"
+#include "GeometricNode.h"
+#include "Connection.h"
+#include "PointCloud.h"
+#include "brics_3d/core/HomogeneousMatrix44.h"
+#include "brics_3d/core/Logger.h"
+#include <algorithm>
+
+namespace brics_3d {
+namespace rsg {
+
+/// Collects the IDs of all geometric nodes that hold a PointCloud3D.
+class PointCloudNodeCollector : public INodeVisitor {
+public:
+	PointCloudNodeCollector() : INodeVisitor(downwards) {
+		this->visitEachNodeOnce = true;
+	}
+	virtual ~PointCloudNodeCollector(){};
+
+	void visit(GeometricNode* node) {
+		if (boost::dynamic_pointer_cast<PointCloud<PointCloud3D> >(node->getShape()) != 0) {
+			ids.insert(node->getId());
+		}
+	}
+	void visit(Connection* connection) {};
+
+	std::set<Id> ids;
+};
+
+static bool isEqual(IHomogeneousMatrix44* a, IHomogeneousMatrix44* b) {
+	const double* aData = a->getRawData();
+	const double* bData = b->getRawData();
+	for (int i = 0; i < 16; ++i) {
+		if (aData[i] != bData[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+CachedPointCloudAccumulator::CachedPointCloudAccumulator(SceneGraphFacade* facadeHandle, Id referenceNodeId) {
+	assert(facadeHandle != 0);
+	initialize(facadeHandle, referenceNodeId, facadeHandle->getRootId());
+}
+
+CachedPointCloudAccumulator::CachedPointCloudAccumulator(SceneGraphFacade* facadeHandle, Id referenceNodeId, Id subgraphId) {
+	initialize(facadeHandle, referenceNodeId, subgraphId);
+}
+
+CachedPointCloudAccumulator::~CachedPointCloudAccumulator() {
+	facadeHandle = 0; //we do not delete, as we are not the owner
+}
+
+void CachedPointCloudAccumulator::initialize(SceneGraphFacade* facadeHandle, Id referenceNodeId, Id subgraphId) {
+	assert(facadeHandle != 0);
+	this->facadeHandle = facadeHandle;
+	this->referenceNodeId = referenceNodeId;
+	this->subgraphId = subgraphId;
+	transformQueryCount = 0;
+	transformedPointCount = 0;
+	reset();
+}
+
+void CachedPointCloudAccumulator::reset() {
+	clouds.clear();
+	cloudOrder.clear();
+	dependentClouds.clear();
+	referenceAncestors.clear();
+	points.clear();
+	pendingAdditions.clear();
+	pendingRemovals.clear();
+	allTransformsAreDirty = true;
+	rescanRequired = true; // picks up everything that existed before this observer has been attached
+}
+
+bool CachedPointCloudAccumulator::update(TimeStamp timeStamp) {
+
+	/* structural changes */
+	if (rescanRequired) {
+		rescan();
+	}
+
+	if (!pendingRemovals.empty()) {
+		removePointClouds(pendingRemovals);
+		pendingRemovals.clear();
+	}
+
+	for (std::vector<Id>::iterator it = pendingAdditions.begin(); it != pendingAdditions.end(); ++it) {
+		addPointCloud(*it);
+	}
+	pendingAdditions.clear();
+
+	/* transforms and points */
+	bool allTransformsFound = true;
+	for (std::vector<Id>::iterator it = cloudOrder.begin(); it != cloudOrder.end(); ++it) {
+		CachedPointCloud& entry = clouds[*it];
+		if (entry.isMaterialized && !entry.transformIsDirty && !allTransformsAreDirty && (entry.transformTimeStamp == timeStamp)) {
+			continue; // memoized
+		}
+
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform;
+		transformQueryCount++;
+		if (!facadeHandle->getTransformForNode(*it, referenceNodeId, timeStamp, transform)) {
+			LOG(ERROR) << "CachedPointCloudAccumulator: Cannot find appropriate transform for point cloud " << *it << ". Using identity.";
+			transform.reset(new HomogeneousMatrix44());
+			allTransformsFound = false;
+		}
+
+		if (!entry.isMaterialized || !isEqual(transform.get(), entry.transform.get())) {
+			if (entry.size > 0) {
+				transformPoints(entry.pointCloud.get(), transform.get(), &points[entry.offset * 3]);
+			}
+			transformedPointCount += entry.size;
+			entry.isMaterialized = true;
+		}
+		entry.transform = transform;
+		entry.transformTimeStamp = timeStamp;
+		entry.transformIsDirty = false;
+	}
+	allTransformsAreDirty = false;
+
+	return allTransformsFound;
+}
+
+void CachedPointCloudAccumulator::getAccumulatedPointCloud(PointCloud3D& result) const {
+	for (size_t i = 0; i + 2 < points.size(); i += 3) {
+		result.addPoint(Point3D(points[i], points[i+1], points[i+2]));
+	}
+}
+
+void CachedPointCloudAccumulator::transformPoints(PointCloud3D* pointCloud, IHomogeneousMatrix44* transform, Coordinate* result) {
+	assert(pointCloud != 0);
+	assert(transform != 0);
+	pointCloud->getTransformedPoints(0, pointCloud->getSize(), transform->isIdentity(0.0) ? 0 : transform, result);
+}
+
+void CachedPointCloudAccumulator::getAncestors(Id id, std::vector<Id>& ancestors) {
+	ancestors.clear();
+	std::set<Id> visited;
+	std::vector<Id> open;
+	open.push_back(id);
+	while (!open.empty()) {
+		Id current = open.back();
+		open.pop_back();
+		std::vector<Id> parentIds;
+		facadeHandle->getNodeParents(current, parentIds);
+		for (std::vector<Id>::iterator it = parentIds.begin(); it != parentIds.end(); ++it) {
+			if (visited.insert(*it).second) {
+				ancestors.push_back(*it);
+				open.push_back(*it);
+			}
+		}
+	}
+}
+
+bool CachedPointCloudAccumulator::addPointCloud(Id id) {
+	if (clouds.find(id) != clouds.end()) {
+		return true; // already known, e.g. found by a rescan
+	}
+
+	Shape::ShapePtr shape;
+	TimeStamp creationTime;
+	if (!facadeHandle->getGeometry(id, shape, creationTime)) {
+		return false; // has been deleted in the meantime
+	}
+	PointCloud<PointCloud3D>::PointCloudPtr pointCloudContainer = boost::dynamic_pointer_cast<PointCloud<PointCloud3D> >(shape);
+	if (pointCloudContainer == 0 || pointCloudContainer->data == 0) {
+		return false;
+	}
+
+	std::vector<Id> ancestors;
+	getAncestors(id, ancestors);
+	if ((id != subgraphId) && (std::find(ancestors.begin(), ancestors.end(), subgraphId) == ancestors.end())) {
+		return false; // not part of the subgraph
+	}
+
+	CachedPointCloud& entry = clouds[id];
+	entry.pointCloud = pointCloudContainer->data;
+	entry.ancestors = ancestors;
+	entry.transformIsDirty = true;
+	entry.offset = points.size() / 3;
+	entry.size = entry.pointCloud->getSize();
+	entry.isMaterialized = false;
+	points.resize(points.size() + entry.size * 3);
+	cloudOrder.push_back(id);
+	indexDependencies(id, ancestors, true);
+
+	LOG(DEBUG) << "CachedPointCloudAccumulator: Added point cloud " << id << " with " << entry.size << " points.";
+	return true;
+}
+
+void CachedPointCloudAccumulator::indexDependencies(Id id, const std::vector<Id>& ancestors, bool insert) {
+	for (std::vector<Id>::const_iterator it = ancestors.begin(); it != ancestors.end(); ++it) {
+		if (insert) {
+			dependentClouds[*it].insert(id);
+		} else {
+			std::map<Id, std::set<Id> >::iterator dependencies = dependentClouds.find(*it);
+			if (dependencies != dependentClouds.end()) {
+				dependencies->second.erase(id);
+				if (dependencies->second.empty()) {
+					dependentClouds.erase(dependencies);
+				}
+			}
+		}
+	}
+}
+
+void CachedPointCloudAccumulator::removePointClouds(const std::set<Id>& ids) {
+	size_t writeOffset = 0;
+	std::vector<Id> remainingOrder;
+	remainingOrder.reserve(cloudOrder.size());
+
+	for (std::vector<Id>::iterator it = cloudOrder.begin(); it != cloudOrder.end(); ++it) {
+		std::map<Id, CachedPointCloud>::iterator entry = clouds.find(*it);
+		assert(entry != clouds.end());
+		if (ids.find(*it) != ids.end()) {
+			indexDependencies(*it, entry->second.ancestors, false);
+			clouds.erase(entry);
+			continue;
+		}
+
+		if (entry->second.offset != writeOffset) { // shift down, the points keep their values
+			std::copy(points.begin() + entry->second.offset * 3,
+					points.begin() + (entry->second.offset + entry->second.size) * 3,
+					points.begin() + writeOffset * 3);
+			entry->second.offset = writeOffset;
+		}
+		writeOffset += entry->second.size;
+		remainingOrder.push_back(*it);
+	}
+
+	points.resize(writeOffset * 3);
+	cloudOrder.swap(remainingOrder);
+}
+
+void CachedPointCloudAccumulator::rescan() {
+	LOG(DEBUG) << "CachedPointCloudAccumulator: Rescanning subgraph " << subgraphId;
+	PointCloudNodeCollector collector;
+	facadeHandle->executeGraphTraverser(&collector, subgraphId);
+
+	/* drop point clouds that are no longer part of the subgraph */
+	std::set<Id> removals;
+	for (std::map<Id, CachedPointCloud>::iterator it = clouds.begin(); it != clouds.end(); ++it) {
+		if (collector.ids.find(it->first) == collector.ids.end()) {
+			removals.insert(it->first);
+		}
+	}
+	if (!removals.empty()) {
+		removePointClouds(removals);
+	}
+
+	/* the paths of the remaining ones might have changed, the memoized transforms will be verified */
+	for (std::map<Id, CachedPointCloud>::iterator it = clouds.begin(); it != clouds.end(); ++it) {
+		indexDependencies(it->first, it->second.ancestors, false);
+		getAncestors(it->first, it->second.ancestors);
+		indexDependencies(it->first, it->second.ancestors, true);
+	}
+	for (std::set<Id>::iterator it = collector.ids.begin(); it != collector.ids.end(); ++it) {
+		if (clouds.find(*it) == clouds.end()) {
+			pendingAdditions.push_back(*it);
+		}
+	}
+
+	std::vector<Id> ancestors;
+	getAncestors(referenceNodeId, ancestors);
+	referenceAncestors.clear();
+	referenceAncestors.insert(ancestors.begin(), ancestors.end());
+	referenceAncestors.insert(referenceNodeId);
+
+	allTransformsAreDirty = true;
+	rescanRequired = false;
+}
+
+void CachedPointCloudAccumulator::invalidateTransforms(Id id) {
+	if (referenceAncestors.find(id) != referenceAncestors.end()) {
+		allTransformsAreDirty = true;
+		return;
+	}
+	std::map<Id, std::set<Id> >::iterator dependencies = dependentClouds.find(id);
+	if (dependencies == dependentClouds.end()) {
+		return;
+	}
+	for (std::set<Id>::iterator it = dependencies->second.begin(); it != dependencies->second.end(); ++it) {
+		clouds[*it].transformIsDirty = true;
+	}
+}
+
+bool CachedPointCloudAccumulator::addNode(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId) {
+	return true;
+}
+
+bool CachedPointCloudAccumulator::addGroup(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId) {
+	return true;
+}
+
+bool CachedPointCloudAccumulator::addTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp, bool forcedId) {
+	return true;
+}
+
+bool CachedPointCloudAccumulator::addUncertainTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp, bool forcedId) {
+	return true;
+}
+
+bool CachedPointCloudAccumulator::addGeometricNode(Id parentId, Id& assignedId, vector<Attribute> attributes, Shape::ShapePtr shape, TimeStamp timeStamp, bool forcedId) {
+	if (boost::dynamic_pointer_cast<PointCloud<PointCloud3D> >(shape) != 0) {
+		pendingAdditions.push_back(assignedId); // the actual work is deferred to update()
+	}
+	return true;
+}
+
+bool CachedPointCloudAccumulator::addRemoteRootNode(Id rootId, vector<Attribute> attributes) {
+	return true;
+}
+
+bool CachedPointCloudAccumulator::addConnection(Id parentId, Id& assignedId, vector<Attribute> attributes, vector<Id> sourceIds, vector<Id> targetIds, TimeStamp start, TimeStamp end, bool forcedId) {
+	return true;
+}
+
+bool CachedPointCloudAccumulator::setNodeAttributes(Id id, vector<Attribute> newAttributes, TimeStamp timeStamp) {
+	return true;
+}
+
+bool CachedPointCloudAccumulator::setTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp) {
+	invalidateTransforms(id);
+	return true;
+}
+
+bool CachedPointCloudAccumulator::setUncertainTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp) {
+	invalidateTransforms(id);
+	return true;
+}
+
+bool CachedPointCloudAccumulator::deleteNode(Id id) {
+	if (clouds.find(id) != clouds.end()) {
+		pendingRemovals.insert(id);
+	} else if ((dependentClouds.find(id) != dependentClouds.end()) || (referenceAncestors.find(id) != referenceAncestors.end())) {
+		rescanRequired = true; // the paths of other nodes change
+	}
+	return true;
+}
+
+bool CachedPointCloudAccumulator::addParent(Id id, Id parentId) {
+	rescanRequired = true; // might make further point clouds part of the subgraph
+	return true;
+}
+
+bool CachedPointCloudAccumulator::removeParent(Id id, Id parentId) {
+	rescanRequired = true;
+	return true;
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
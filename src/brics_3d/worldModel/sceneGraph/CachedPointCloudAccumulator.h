@@ -0,0 +1,211 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#ifndef RSG_CACHEDPOINTCLOUDACCUMULATOR_H_
+#define RSG_CACHEDPOINTCLOUDACCUMULATOR_H_
+
+#include "ISceneGraphUpdateObserver.h"
+#include "SceneGraphFacade.h"
+#include "brics_3d/core/PointCloud3D.h"
+#include <vector>
+#include <map>
+#include <set>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Accumulates all point clouds of a (sub) graph into one flat, pre-transformed buffer.
+ * @ingroup sceneGraph
+ *
+ * The PointCloudAccumulatorIdAware traverses the graph and queries the transform from the reference
+ * node to every point cloud each time it is used. The resulting PointCloud3DIterator transforms
+ * every point again whenever it is accessed. This class is an observer of a SceneGraphFacade that
+ * instead keeps the accumulated points as consecutive x,y,z triples expressed in the reference frame.
+ * The buffer is updated incrementally by update():
+ *  - Added point clouds are transformed once and appended.
+ *  - Deleted point clouds are cut out of the buffer without touching the other points.
+ *  - The transform for every point cloud is memoized for the (reference, node, time stamp) triple.
+ *    It is only queried again if a Transform on the path to the point cloud or to the reference
+ *    node has been updated, and the points are only transformed again if the result differs.
+ * Changes of the graph structure by addParent, removeParent or deleting an intermediate node trigger
+ * a rescan of the subgraph, that still reuses the memoized transforms and points.
+ *
+ * The point data of a GeometricNode is immutable, thus the cached points stay valid as long as the node exists.
+ * Every point cloud contributes exactly once, even if it can be reached via multiple paths.
+ *
+ * Usage:
+ * @code
+ * CachedPointCloudAccumulator accumulator(&wm->scene, referenceId);
+ * wm->scene.attachUpdateObserver(&accumulator);
+ * ...
+ * accumulator.update(wm->now()); // e.g. once per rendering or planning cycle
+ * const std::vector<Coordinate>& points = accumulator.getAccumulatedPoints(); // x0,y0,z0,x1,y1,z1,...
+ * @endcode
+ */
+class CachedPointCloudAccumulator : public ISceneGraphUpdateObserver {
+public:
+
+	/**
+	 * @brief Constructor that accumulates all point clouds below the root node.
+	 * @param facadeHandle Handle to the scene graph facade as it manages the IDs.
+	 * @param referenceNodeId The Cartesian frame that is valid for this node will be used as reference to interpret the 3D points.
+	 */
+	CachedPointCloudAccumulator(SceneGraphFacade* facadeHandle, Id referenceNodeId);
+
+	/**
+	 * @brief Constructor that accumulates all point clouds of a subgraph.
+	 * @param facadeHandle Handle to the scene graph facade as it manages the IDs.
+	 * @param referenceNodeId The Cartesian frame that is valid for this node will be used as reference to interpret the 3D points.
+	 * @param subgraphId Only point clouds that have this node as ancestor are accumulated.
+	 */
+	CachedPointCloudAccumulator(SceneGraphFacade* facadeHandle, Id referenceNodeId, Id subgraphId);
+
+	virtual ~CachedPointCloudAccumulator();
+
+	/* implemetntations of observer interface */
+	bool addNode(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId = false);
+	bool addGroup(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId = false);
+	bool addTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp, bool forcedId = false);
+	bool addUncertainTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp, bool forcedId = false);
+	bool addGeometricNode(Id parentId, Id& assignedId, vector<Attribute> attributes, Shape::ShapePtr shape, TimeStamp timeStamp, bool forcedId = false);
+	bool addRemoteRootNode(Id rootId, vector<Attribute> attributes);
+	bool addConnection(Id parentId, Id& assignedId, vector<Attribute> attributes, vector<Id> sourceIds, vector<Id> targetIds, TimeStamp start, TimeStamp end, bool forcedId = false);
+	bool setNodeAttributes(Id id, vector<Attribute> newAttributes, TimeStamp timeStamp = TimeStamp(0));
+	bool setTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp);
+	bool setUncertainTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp);
+	bool deleteNode(Id id);
+	bool addParent(Id id, Id parentId);
+	bool removeParent(Id id, Id parentId);
+
+	/**
+	 * @brief Bring the accumulated points up to date with all updates received so far.
+	 * @param timeStamp Time stamp used to look up the transforms, as for SceneGraphFacade::getTransformForNode().
+	 * @return True if all transforms could be resolved. Point clouds without a valid transform are accumulated without transform.
+	 */
+	bool update(TimeStamp timeStamp = TimeStamp());
+
+	/**
+	 * @brief Discard all cached data and scan the subgraph again with the next update().
+	 */
+	void reset();
+
+	/// Accumulated points in the reference frame as consecutive x,y,z triples. Valid until the next update().
+	const std::vector<Coordinate>& getAccumulatedPoints() const {
+		return points;
+	}
+
+	/// Number of accumulated points.
+	unsigned int getPointCount() const {
+		return static_cast<unsigned int>(points.size() / 3);
+	}
+
+	/// Number of accumulated point clouds.
+	unsigned int getPointCloudCount() const {
+		return static_cast<unsigned int>(clouds.size());
+	}
+
+	/// Copy the accumulated points into a point cloud.
+	void getAccumulatedPointCloud(PointCloud3D& result) const;
+
+	/// Number of transform look ups in the scene graph so far.
+	unsigned int getTransformQueryCount() const {
+		return transformQueryCount;
+	}
+
+	/// Number of points that have been transformed so far.
+	unsigned long long getTransformedPointCount() const {
+		return transformedPointCount;
+	}
+
+	/**
+	 * @brief Batched transform kernel. Applies one homogeneous transform to all points of a cloud.
+	 * @param pointCloud Input points.
+	 * @param transform The transform. The coefficients are loaded once for the whole batch.
+	 * @param[out] result Output as x,y,z triples. Has to provide space for 3*pointCloud->getSize() coordinates.
+	 */
+	static void transformPoints(PointCloud3D* pointCloud, IHomogeneousMatrix44* transform, Coordinate* result);
+
+private:
+
+	/// Cache entry for a single point cloud.
+	struct CachedPointCloud {
+		PointCloud3D::PointCloud3DPtr pointCloud;
+
+		/// All ancestors i.e. all nodes whose transforms can influence the point cloud.
+		std::vector<Id> ancestors;
+
+		/// Memoized transform from the reference node to the point cloud and the time stamp it was queried for.
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform;
+		TimeStamp transformTimeStamp;
+		bool transformIsDirty;
+
+		/// Range in the points buffer (in points, not coordinates).
+		size_t offset;
+		size_t size;
+		bool isMaterialized;
+	};
+
+	void initialize(SceneGraphFacade* facadeHandle, Id referenceNodeId, Id subgraphId);
+
+	/// Collect all ancestors of a node by following the parent relations.
+	void getAncestors(Id id, std::vector<Id>& ancestors);
+
+	/// Create an entry for a point cloud node and append its range to the points buffer.
+	bool addPointCloud(Id id);
+
+	/// Add or remove the ancestors of an entry from the dependency index.
+	void indexDependencies(Id id, const std::vector<Id>& ancestors, bool insert);
+
+	/// Remove the ranges of all marked point clouds from the points buffer in a single pass.
+	void removePointClouds(const std::set<Id>& ids);
+
+	/// Re-synchronize the set of point clouds with the subgraph after a structural change.
+	void rescan();
+
+	/// Mark all memoized transforms that depend on a node as dirty.
+	void invalidateTransforms(Id id);
+
+	SceneGraphFacade* facadeHandle;
+	Id referenceNodeId;
+	Id subgraphId;
+
+	std::map<Id, CachedPointCloud> clouds;
+	std::vector<Id> cloudOrder;
+	std::map<Id, std::set<Id> > dependentClouds;
+	std::set<Id> referenceAncestors;
+
+	std::vector<Coordinate> points;
+
+	std::vector<Id> pendingAdditions;
+	std::set<Id> pendingRemovals;
+	bool allTransformsAreDirty;
+	bool rescanRequired;
+
+	unsigned int transformQueryCount;
+	unsigned long long transformedPointCount;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_CACHEDPOINTCLOUDACCUMULATOR_H_ */
+
+/* EOF */
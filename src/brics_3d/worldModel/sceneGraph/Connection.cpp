@@ -31,14 +31,8 @@ Connection::~Connection() {
 
 }
 
-void Connection::accept(INodeVisitor* visitor) {
+void Connection::acceptWithoutTraversal(INodeVisitor* visitor) {
 	visitor->visit(this);
-	if (visitor->getDirection() == INodeVisitor::upwards) {
-		for(unsigned i = 0; i < getNumberOfParents(); ++i) // recursively go up the graph structure
-		{
-			getParent(i)->accept(visitor);
-		}
-	}
 }
 
 void Connection::addSourceNode(Node* node)
@@ -64,7 +64,7 @@ class Connection : public Node {
     {
         this->end = end;
     }
-    virtual void accept(INodeVisitor* visitor);
+    virtual void acceptWithoutTraversal(INodeVisitor* visitor);
 
     /* Manipulation of sources */
     void addSourceNode(Node* node);
@@ -0,0 +1,140 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#include "DistanceConstraintEvaluator.h"
+#include "brics_3d/core/Logger.h"
+
+#include <math.h>
+
+namespace brics_3d {
+namespace rsg {
+
+DistanceConstraintEvaluator::DistanceConstraintEvaluator(WorldModel* wm) : wm(wm) {
+	assert(this->wm != 0);
+	referenceTransformComputations = 0;
+}
+
+DistanceConstraintEvaluator::~DistanceConstraintEvaluator() {
+
+}
+
+void DistanceConstraintEvaluator::resolveReferenceNodes(const std::vector<GraphConstraint>& constraints) {
+	std::map<Id, ReferenceNode> resolvedNodes;
+	for (std::vector<GraphConstraint>::const_iterator it = constraints.begin(); it != constraints.end(); ++it) {
+		if (it->nodeConstraint != GraphConstraint::DISTANCE) {
+			continue;
+		}
+		Id referenceId = getReferenceNode(*it);
+		if (resolvedNodes.find(referenceId) != resolvedNodes.end()) {
+			continue;
+		}
+		std::map<Id, ReferenceNode>::iterator existing = referenceNodes.find(referenceId);
+		if (existing != referenceNodes.end()) {
+			resolvedNodes[referenceId] = existing->second;
+		} else {
+			resolve(referenceId, resolvedNodes[referenceId]); // it might not exist yet, then the next query will try again
+		}
+	}
+	referenceNodes.swap(resolvedNodes);
+}
+
+Id DistanceConstraintEvaluator::getReferenceNode(const GraphConstraint& constraint) {
+	if(constraint.isMe) {
+		return wm->getRootNodeId();
+	}
+	return constraint.node;
+}
+
+bool DistanceConstraintEvaluator::computeDistance(const GraphConstraint& constraint, Id id, double& distanceInMeters) {
+	Id referenceId = getReferenceNode(constraint);
+	ReferenceNode& reference = referenceNodes[referenceId];
+	if (!reference.isResolved && !resolve(referenceId, reference)) {
+		LOG(WARNING) << "DistanceConstraintEvaluator: Cannot resolve reference node " << referenceId;
+		return false;
+	}
+
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr globalTransform;
+	if (!wm->scene.getTransformForNode(id, wm->getRootNodeId(), wm->now(), globalTransform)) {
+		return false;
+	}
+
+	/* Only the translation of the node relative to the reference is needed */
+	const double* r = reference.inverseGlobalTransform->getRawData();
+	const double* n = globalTransform->getRawData();
+	double x = r[matrixEntry::r11] * n[matrixEntry::x] + r[matrixEntry::r12] * n[matrixEntry::y] + r[matrixEntry::r13] * n[matrixEntry::z] + r[matrixEntry::x];
+	double y = r[matrixEntry::r21] * n[matrixEntry::x] + r[matrixEntry::r22] * n[matrixEntry::y] + r[matrixEntry::r23] * n[matrixEntry::z] + r[matrixEntry::y];
+	double z = r[matrixEntry::r31] * n[matrixEntry::x] + r[matrixEntry::r32] * n[matrixEntry::y] + r[matrixEntry::r33] * n[matrixEntry::z] + r[matrixEntry::z];
+	distanceInMeters = sqrt(x*x + y*y + z*z);
+	return true;
+}
+
+void DistanceConstraintEvaluator::transformChanged(Id id) {
+	for (std::map<Id, ReferenceNode>::iterator it = referenceNodes.begin(); it != referenceNodes.end(); ++it) {
+		if (it->second.isResolved && (it->second.ancestors.find(id) != it->second.ancestors.end())) {
+			LOG(DEBUG) << "DistanceConstraintEvaluator: Transform of reference node " << it->first << " changed.";
+			it->second.isResolved = false;
+		}
+	}
+}
+
+void DistanceConstraintEvaluator::structureChanged(Id id) {
+	transformChanged(id); // the ancestors of the reference nodes have to be collected again as well
+}
+
+void DistanceConstraintEvaluator::clear() {
+	referenceNodes.clear();
+}
+
+bool DistanceConstraintEvaluator::resolve(Id referenceId, ReferenceNode& reference) {
+	reference.isResolved = false;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr globalTransform;
+	if (!wm->scene.getTransformForNode(referenceId, wm->getRootNodeId(), wm->now(), globalTransform)) {
+		return false;
+	}
+	globalTransform->inverse(); // a new matrix, that is not shared with the scene graph
+	reference.inverseGlobalTransform = globalTransform;
+	collectAncestors(referenceId, reference.ancestors);
+	reference.isResolved = true;
+	referenceTransformComputations++;
+	return true;
+}
+
+void DistanceConstraintEvaluator::collectAncestors(Id id, std::set<Id>& ancestors) {
+	ancestors.clear();
+	ancestors.insert(id);
+	std::vector<Id> open;
+	open.push_back(id);
+	while (!open.empty()) {
+		Id current = open.back();
+		open.pop_back();
+		std::vector<Id> parentIds;
+		wm->scene.getNodeParents(current, parentIds);
+		for (std::vector<Id>::iterator it = parentIds.begin(); it != parentIds.end(); ++it) {
+			if (ancestors.insert(*it).second) {
+				open.push_back(*it);
+			}
+		}
+	}
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
@@ -0,0 +1,117 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#ifndef RSG_DISTANCECONSTRAINTEVALUATOR_H_
+#define RSG_DISTANCECONSTRAINTEVALUATOR_H_
+
+#include "brics_3d/worldModel/WorldModel.h"
+#include "brics_3d/worldModel/sceneGraph/GraphConstraint.h"
+#include "brics_3d/core/HomogeneousMatrix44.h"
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Evaluates the distances for DISTANCE graph constraints.
+ * @ingroup sceneGraph
+ *
+ * The reference node of each DISTANCE constraint is resolved only once: its ancestors are
+ * memorized and the inverse of its global transform is cached. The cache is kept up to date
+ * incrementally by feeding in the updates via transformChanged() and structureChanged().
+ * Only an update of an ancestor of a reference node causes a recomputation of the reference transform.
+ * Thus, for every evaluation merely the path from the evaluated node to the root has to be traversed.
+ *
+ * The notifications have to be sent after the world model has applied an update. Sending them
+ * (also) before is fine, but a reference resolved in between would cache the old state.
+ */
+class DistanceConstraintEvaluator {
+public:
+	DistanceConstraintEvaluator(WorldModel* wm);
+	virtual ~DistanceConstraintEvaluator();
+
+	/**
+	 * @brief Resolve the reference nodes of all DISTANCE constraints in advance.
+	 * Reference nodes that are not part of the constraints anymore are forgotten.
+	 */
+	void resolveReferenceNodes(const std::vector<GraphConstraint>& constraints);
+
+	/// The reference node of a constraint. The "me" alias is resolved to the root node.
+	Id getReferenceNode(const GraphConstraint& constraint);
+
+	/**
+	 * @brief Compute the distance between a node and the reference node of a constraint.
+	 * Reference nodes that have not been resolved yet, are resolved on the fly.
+	 * @param[in] constraint A DISTANCE constraint.
+	 * @param[in] id ID of the node.
+	 * @param[out] distanceInMeters The distance.
+	 * @return False if one of the nodes does not exist.
+	 */
+	bool computeDistance(const GraphConstraint& constraint, Id id, double& distanceInMeters);
+
+	/// Notify that a transform has been updated.
+	void transformChanged(Id id);
+
+	/// Notify that the parents of a node have changed or that a node has been deleted.
+	void structureChanged(Id id);
+
+	/// Forget all reference nodes.
+	void clear();
+
+	/// Number of computed reference transforms. Useful for debugging and tests.
+	unsigned int getReferenceTransformComputations() const {
+		return referenceTransformComputations;
+	}
+
+private:
+
+	struct ReferenceNode {
+		ReferenceNode() : isResolved(false) {};
+
+		/// All ancestors and the reference node itself. Updates of these invalidate the transform.
+		std::set<Id> ancestors;
+
+		/// Transform from the root node to the reference node.
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr inverseGlobalTransform;
+
+		bool isResolved;
+	};
+
+	/// Memorize the ancestors and the inverse global transform. Fails if the node does not exist (yet).
+	bool resolve(Id referenceId, ReferenceNode& reference);
+
+	void collectAncestors(Id id, std::set<Id>& ancestors);
+
+	WorldModel* wm;
+
+	std::map<Id, ReferenceNode> referenceNodes;
+
+	unsigned int referenceTransformComputations;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_DISTANCECONSTRAINTEVALUATOR_H_ */
+
+/* EOF */
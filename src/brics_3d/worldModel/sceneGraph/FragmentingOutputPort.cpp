@@ -0,0 +1,148 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#include "FragmentingOutputPort.h"
+#include "brics_3d/core/Logger.h"
+#include "brics_3d/util/BinaryTypecaster.h"
+#include <cstring>
+#include <algorithm>
+#include <boost/thread.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <boost/uuid/uuid_generators.hpp>
+
+namespace brics_3d {
+namespace rsg {
+
+void FragmentHeader::encode(char* data) const {
+	data[0] = static_cast<char>(magic);
+	data[1] = static_cast<char>(magic >> 8);
+	data[2] = static_cast<char>(version);
+	data[3] = 0;
+	BinaryTypecaster::writeUInt32(streamId, data + 4);
+	BinaryTypecaster::writeUInt32(messageId, data + 8);
+	BinaryTypecaster::writeUInt32(messageLength, data + 12);
+	BinaryTypecaster::writeUInt32(fragmentIndex, data + 16);
+	BinaryTypecaster::writeUInt32(fragmentCount, data + 20);
+}
+
+bool FragmentHeader::decode(const char* data, int dataLength) {
+	if (dataLength < static_cast<int>(size)) {
+		return false;
+	}
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+	if ((bytes[0] | (bytes[1] << 8)) != magic || bytes[2] != version) {
+		return false;
+	}
+	streamId = BinaryTypecaster::readUInt32(data + 4);
+	messageId = BinaryTypecaster::readUInt32(data + 8);
+	messageLength = BinaryTypecaster::readUInt32(data + 12);
+	fragmentIndex = BinaryTypecaster::readUInt32(data + 16);
+	fragmentCount = BinaryTypecaster::readUInt32(data + 20);
+	return (fragmentCount > 0) && (fragmentIndex < fragmentCount);
+}
+
+FragmentingOutputPort::FragmentingOutputPort(IOutputPort* datagramPort, unsigned int maxDatagramSize) :
+		datagramPort(datagramPort),
+		maxDatagramSize(maxDatagramSize),
+		maxBytesPerSecond(0),
+		nextMessageId(0),
+		fragmentCount(0),
+		totalPacingDelay(0, 0, 0, 0) {
+
+	if (this->maxDatagramSize <= FragmentHeader::size) {
+		LOG(ERROR) << "FragmentingOutputPort: maxDatagramSize of " << maxDatagramSize << " is too small. Using " << FragmentHeader::size + 1 << " instead.";
+		this->maxDatagramSize = FragmentHeader::size + 1;
+	}
+	datagram.resize(this->maxDatagramSize);
+
+	boost::uuids::random_generator generator;
+	boost::uuids::uuid randomId = generator();
+	memcpy(&streamId, randomId.begin(), sizeof(streamId));
+}
+
+FragmentingOutputPort::~FragmentingOutputPort() {
+
+}
+
+int FragmentingOutputPort::write(const char* dataBuffer, int dataLength, int& transferredBytes) {
+	transferredBytes = 0;
+	if (datagramPort == 0) {
+		LOG(ERROR) << "FragmentingOutputPort: No datagram port specified.";
+		return -1;
+	}
+	if (dataBuffer == 0 || dataLength <= 0) {
+		LOG(WARNING) << "FragmentingOutputPort: Skipping empty message.";
+		return -1;
+	}
+
+	const unsigned int payloadSize = maxDatagramSize - FragmentHeader::size;
+	FragmentHeader header;
+	header.streamId = streamId;
+	header.messageId = nextMessageId++;
+	header.messageLength = static_cast<boost::uint32_t>(dataLength);
+	header.fragmentCount = static_cast<boost::uint32_t>((dataLength + payloadSize - 1) / payloadSize);
+
+	LOG(DEBUG) << "FragmentingOutputPort: Sending message " << header.messageId << " with " << dataLength << " bytes as " << header.fragmentCount << " fragments.";
+	for (header.fragmentIndex = 0; header.fragmentIndex < header.fragmentCount; ++header.fragmentIndex) {
+		unsigned int offset = header.fragmentIndex * payloadSize;
+		unsigned int length = std::min(payloadSize, static_cast<unsigned int>(dataLength) - offset);
+		header.encode(&datagram[0]);
+		memcpy(&datagram[FragmentHeader::size], dataBuffer + offset, length);
+
+		int datagramSize = static_cast<int>(FragmentHeader::size + length);
+		pace(datagramSize);
+		int sentBytes = 0;
+		if (datagramPort->write(&datagram[0], datagramSize, sentBytes) < 0) {
+			LOG(ERROR) << "FragmentingOutputPort: Cannot send fragment " << header.fragmentIndex << " of message " << header.messageId;
+			return -1;
+		}
+		fragmentCount++;
+		transferredBytes += length;
+	}
+
+	return 1;
+}
+
+void FragmentingOutputPort::pace(unsigned int datagramSize) {
+	if (maxBytesPerSecond <= 0) {
+		return;
+	}
+
+	boost::posix_time::ptime now = getCurrentTime();
+	if (nextSendTime.is_not_a_date_time() || nextSendTime < now) {
+		nextSendTime = now; // no credit for idle times, to avoid bursts
+	} else if (nextSendTime > now) {
+		totalPacingDelay += nextSendTime - now;
+		sleep(nextSendTime - now);
+	}
+	nextSendTime += boost::posix_time::microseconds(static_cast<long>(datagramSize / maxBytesPerSecond * 1e6));
+}
+
+boost::posix_time::ptime FragmentingOutputPort::getCurrentTime() {
+	return boost::posix_time::microsec_clock::universal_time();
+}
+
+void FragmentingOutputPort::sleep(const boost::posix_time::time_duration& duration) {
+	boost::this_thread::sleep(duration);
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
@@ -0,0 +1,158 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#ifndef RSG_FRAGMENTINGOUTPUTPORT_H_
+#define RSG_FRAGMENTINGOUTPUTPORT_H_
+
+#include "brics_3d/worldModel/sceneGraph/IPort.h"
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Header that precedes every fragment. It is encoded in little endian byte order.
+ *
+ * @code
+ * [uint16 magic "RF"][uint8 version][uint8 reserved][uint32 streamId][uint32 messageId]
+ * [uint32 messageLength][uint32 fragmentIndex][uint32 fragmentCount] payload
+ * @endcode
+ *
+ * The streamId is chosen randomly per FragmentingOutputPort, so a receiver can
+ * distinguish multiple senders. The fragment payload starts at fragmentIndex * (maxDatagramSize - size).
+ */
+struct FragmentHeader {
+
+	static const unsigned int size = 24;
+	static const boost::uint16_t magic = 0x4652; // "RF"
+	static const boost::uint8_t version = 1;
+
+	boost::uint32_t streamId;
+	boost::uint32_t messageId;
+	boost::uint32_t messageLength;
+	boost::uint32_t fragmentIndex;
+	boost::uint32_t fragmentCount;
+
+	/// Write the header to the first size bytes of data.
+	void encode(char* data) const;
+
+	/// Read the header from a datagram. Returns false if it is too short or has no valid header.
+	bool decode(const char* data, int dataLength);
+};
+
+/**
+ * @brief Decorator for an IOutputPort that splits serialized updates into datagrams.
+ * @ingroup sceneGraph
+ *
+ * Datagram transports like UDP limit the size of a single write. This port splits every
+ * message into fragments of at most maxDatagramSize bytes (including the FragmentHeader)
+ * and writes them to the underlying port. A ReassemblingInputPort on the receiving
+ * side restores the original messages, even if fragments arrive out of order.
+ *
+ * Optionally the fragments can be paced to a maximum data rate, to avoid
+ * overflowing the socket buffers of sender or receiver with large point clouds.
+ *
+ * @code
+ * UDPOutputBridge udpPort("127.0.0.1", 11411); // some datagram transport
+ * FragmentingOutputPort fragmenter(&udpPort, 1400);
+ * fragmenter.setMaxBytesPerSecond(10e6);
+ * HDF5UpdateSerializer serializer(&fragmenter);
+ * @endcode
+ */
+class FragmentingOutputPort : public IOutputPort {
+public:
+
+	/**
+	 * @brief Constructor.
+	 * @param datagramPort The underlying transport.
+	 * @param maxDatagramSize Maximum number of bytes per write to the datagram port. Must be larger than FragmentHeader::size.
+	 */
+	FragmentingOutputPort(IOutputPort* datagramPort, unsigned int maxDatagramSize = 1400);
+	virtual ~FragmentingOutputPort();
+
+	/**
+	 * @brief Send a message as a sequence of fragments.
+	 * @return 1 if all fragments have been sent, -1 otherwise. transferredBytes is the number of sent payload bytes.
+	 */
+	int write(const char *dataBuffer, int dataLength, int &transferredBytes);
+
+	unsigned int getMaxDatagramSize() const {
+		return maxDatagramSize;
+	}
+
+	/// Maximum data rate in bytes per second (including headers). Zero disables pacing (default).
+	double getMaxBytesPerSecond() const {
+		return maxBytesPerSecond;
+	}
+
+	void setMaxBytesPerSecond(double maxBytesPerSecond) {
+		this->maxBytesPerSecond = maxBytesPerSecond;
+	}
+
+	boost::uint32_t getStreamId() const {
+		return streamId;
+	}
+
+	/// Number of fragments that have been written so far.
+	unsigned long getFragmentCount() const {
+		return fragmentCount;
+	}
+
+	/// Accumulated time that write() has waited for pacing so far.
+	boost::posix_time::time_duration getTotalPacingDelay() const {
+		return totalPacingDelay;
+	}
+
+protected:
+
+	/// Sleep until the next fragment of the given size may be sent.
+	void pace(unsigned int datagramSize);
+
+	/// Clock used for pacing. Can be overridden e.g. for a simulated time.
+	virtual boost::posix_time::ptime getCurrentTime();
+
+	/// Block for the given duration. Can be overridden together with getCurrentTime().
+	virtual void sleep(const boost::posix_time::time_duration& duration);
+
+	IOutputPort* datagramPort;
+	unsigned int maxDatagramSize;
+	double maxBytesPerSecond;
+
+	boost::uint32_t streamId;
+	boost::uint32_t nextMessageId;
+	unsigned long fragmentCount;
+
+	/// Reused buffer for a single fragment.
+	std::vector<char> datagram;
+
+	/// Earliest time at which the next fragment may be sent if pacing is enabled.
+	boost::posix_time::ptime nextSendTime;
+
+	/// Sum of all durations passed to sleep().
+	boost::posix_time::time_duration totalPacingDelay;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_FRAGMENTINGOUTPUTPORT_H_ */
+
+/* EOF */
@@ -27,6 +27,12 @@
 namespace brics_3d {
 namespace rsg {
 
+/**
+ * Update filter that omits setTransform, setUncertainTransform and addGeometricNode updates above a maximum frequency.
+ * The frequency is measured globally for all nodes. Use the RateLimitingUpdateFilter to limit the rate
+ * per node without losing the latest state.
+ * @ingroup sceneGraph
+ */
 class FrequencyAwareUpdateFilter : public ISceneGraphUpdateObserver {
 public:
 	FrequencyAwareUpdateFilter();
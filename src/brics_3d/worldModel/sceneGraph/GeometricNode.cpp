@@ -34,14 +34,8 @@ GeometricNode::~GeometricNode() {
 }
 
 
-void GeometricNode::accept(INodeVisitor* visitor) {
+void GeometricNode::acceptWithoutTraversal(INodeVisitor* visitor) {
 	visitor->visit(this);
-	if (visitor->getDirection() == INodeVisitor::upwards) {
-		for(unsigned i = 0; i < getNumberOfParents(); ++i) // recursively go up the graph structure
-		{
-			getParent(i)->accept(visitor);
-		}
-	}
 }
 
 } // namespace brics_3d::RSG
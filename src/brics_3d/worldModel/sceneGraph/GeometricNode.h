@@ -76,7 +76,7 @@ class GeometricNode : public Node {
         this->timeStamp = timeStamp;
     }
 
-    virtual void accept(INodeVisitor* visitor);
+    virtual void acceptWithoutTraversal(INodeVisitor* visitor);
 
 private:
     TimeStamp timeStamp;
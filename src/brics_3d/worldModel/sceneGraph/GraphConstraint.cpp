@@ -280,11 +280,26 @@ bool GraphConstraint::validate() {
 			&& (type != UNDEFINED_TYPE);
 }
 
+bool GraphConstraint::operator==(const GraphConstraint& other) const {
+	return (action == other.action)
+			&& (qualifier == other.qualifier)
+			&& (type == other.type)
+			&& (nodeConstraint == other.nodeConstraint)
+			&& (comparision == other.comparision)
+			&& (value == other.value)
+			&& (freqUnit == other.freqUnit)
+			&& (distUnit == other.distUnit)
+			&& (node == other.node)
+			&& (isMe == other.isMe)
+			&& (context.compare(other.context) == 0);
+}
+
 void GraphConstraint::setDefaultValues() {
 
 	action = UNDEFINED_ACTION;
 	qualifier = UNDEFINED_QUALIFIER;
 	type = UNDEFINED_TYPE;
+	nodeConstraint = UNDEFINED_NODE_CONSTRAINT;
 	comparision = UNDEFINED_OPERATOR;
 	value = 0;
 	freqUnit = Units::Hertz;
@@ -133,6 +133,13 @@ public:
 	 */
 	bool validate();
 
+	/// Two constraints are equal if all of their fields are equal.
+	bool operator==(const GraphConstraint& other) const;
+
+	bool operator!=(const GraphConstraint& other) const {
+		return !(*this == other);
+	}
+
 private:
 	void setDefaultValues();
 };
@@ -0,0 +1,154 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#include "GraphConstraintPolicy.h"
+#include "brics_3d/core/Logger.h"
+
+namespace brics_3d {
+namespace rsg {
+
+GraphConstraintPolicy::GraphConstraintPolicy() {
+	action = GraphConstraint::UNDEFINED_ACTION;
+	for (unsigned int type = 0; type < GraphConstraint::TYPE_NR_ITEMS; ++type) {
+		lodIsRequired[type] = false;
+	}
+}
+
+GraphConstraintPolicy::~GraphConstraintPolicy() {
+
+}
+
+void GraphConstraintPolicy::compile(const std::vector<GraphConstraint>& constraints, GraphConstraint::Action action, Id rootId) {
+	this->constraints = constraints;
+	this->action = action;
+	this->rootId = rootId;
+	compiledConstraints.clear();
+	compiledConstraints.resize(constraints.size());
+	referenceNodes.clear();
+	contexts.clear();
+	for (unsigned int type = 0; type < GraphConstraint::TYPE_NR_ITEMS; ++type) {
+		dispatchTable[type].clear();
+		lodIsRequired[type] = false;
+	}
+
+	for (unsigned int i = 0; i < static_cast<unsigned int>(constraints.size()); ++i) {
+		const GraphConstraint& constraint = constraints[i];
+		bool isApplicable = false;
+		for (unsigned int type = 0; type < GraphConstraint::TYPE_NR_ITEMS; ++type) {
+			if (appliesTo(constraint, action, static_cast<GraphConstraint::Type>(type))) {
+				dispatchTable[type].push_back(i);
+				lodIsRequired[type] |= (constraint.nodeConstraint == GraphConstraint::LOD);
+				isApplicable = true;
+			}
+		}
+		if (!isApplicable) {
+			continue;
+		}
+
+		/* resolve reference nodes and contexts */
+		CompiledConstraint& compiledConstraint = compiledConstraints[i];
+		switch (constraint.nodeConstraint) {
+			case GraphConstraint::DISTANCE:
+			case GraphConstraint::CONTAINMENT:
+				compiledConstraint.referenceNode = constraint.isMe ? rootId : constraint.node;
+				referenceNodes.insert(compiledConstraint.referenceNode);
+				break;
+
+			case GraphConstraint::CONTEXT:
+				compiledConstraint.contextQuery = createContextQuery(constraint.context);
+				contexts.insert(constraint.context);
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	LOG(DEBUG) << "GraphConstraintPolicy: Compiled " << constraints.size() << " constraints. "
+			<< referenceNodes.size() << " reference nodes and " << contexts.size() << " contexts are involved.";
+}
+
+bool GraphConstraintPolicy::isCompiledFrom(const std::vector<GraphConstraint>& constraints, GraphConstraint::Action action, Id rootId) const {
+	return (this->action == action) && (this->rootId == rootId) && (this->constraints == constraints);
+}
+
+const std::vector<unsigned int>& GraphConstraintPolicy::getApplicableConstraints(GraphConstraint::Type type) const {
+	if ((type < 0) || (type >= GraphConstraint::TYPE_NR_ITEMS)) {
+		return dispatchTable[GraphConstraint::UNDEFINED_TYPE];
+	}
+	return dispatchTable[type];
+}
+
+bool GraphConstraintPolicy::requiresLOD(GraphConstraint::Type type) const {
+	if ((type < 0) || (type >= GraphConstraint::TYPE_NR_ITEMS)) {
+		return lodIsRequired[GraphConstraint::UNDEFINED_TYPE];
+	}
+	return lodIsRequired[type];
+}
+
+bool GraphConstraintPolicy::appliesTo(const GraphConstraint& constraint, GraphConstraint::Action action, GraphConstraint::Type type) {
+
+	/* An undefined I/O mode rejects everything */
+	if (action == GraphConstraint::UNDEFINED_ACTION) {
+		return true;
+	}
+	if (constraint.action != action) {
+		return false;
+	}
+
+	bool typeMatches = (constraint.type == type) || (constraint.type == GraphConstraint::Atom);
+	switch (constraint.nodeConstraint) {
+		case GraphConstraint::NONE:
+			if (constraint.qualifier == GraphConstraint::NO) {
+				return typeMatches;
+			} else if (constraint.qualifier == GraphConstraint::ONLY) {
+				return !typeMatches; // all other types are rejected
+			}
+			return false;
+
+		case GraphConstraint::FREQUENCY:
+		case GraphConstraint::LOD:
+			if ((constraint.qualifier == GraphConstraint::NO) || (constraint.qualifier == GraphConstraint::ONLY)) {
+				return typeMatches; // there is nothing to compare for other types
+			}
+			return true; // invalid
+
+		case GraphConstraint::DISTANCE:
+			return true; // the distance is computed for every type, and it rejects the update if that fails
+
+		case GraphConstraint::CONTEXT:
+		case GraphConstraint::CONTAINMENT:
+			return (constraint.qualifier == GraphConstraint::NO) || (constraint.qualifier == GraphConstraint::ONLY);
+
+		default:
+			return false;
+	}
+}
+
+AttributeQuery GraphConstraintPolicy::createContextQuery(const std::string& context) {
+	vector<Attribute> queryAttributes;
+	queryAttributes.push_back(Attribute("^" + context + ":.*", "*")); // wildcard = ^.*
+	return AttributeQuery(queryAttributes);
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
@@ -0,0 +1,134 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#ifndef RSG_GRAPHCONSTRAINTPOLICY_H_
+#define RSG_GRAPHCONSTRAINTPOLICY_H_
+
+#include "GraphConstraint.h"
+#include "AttributeQuery.h"
+
+#include <set>
+#include <vector>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief A compiled set of graph constraints.
+ * @ingroup sceneGraph
+ *
+ * The policy is compiled once for a set of constraints and an action (SEND for a sender or
+ * RECEIVE for a receiver). Compilation creates a dispatch table that lists for every type of
+ * update (GraphConstraint::Type) only the constraints that can actually reject it. E.g.
+ * "send no Boxes with lod > 0.1" is only listed for Boxes, GeometricNodes are not affected.
+ * Furthermore, the "me" alias and the IDs of the reference nodes are resolved and the
+ * semantic contexts are compiled into AttributeQuery objects.
+ *
+ * Thus, the cost to filter an update is proportional to the number of applicable constraints
+ * rather than to the number of all constraints.
+ */
+class GraphConstraintPolicy {
+public:
+	GraphConstraintPolicy();
+	virtual ~GraphConstraintPolicy();
+
+	/**
+	 * @brief Compile a set of constraints.
+	 * @param constraints The constraints. A copy is stored.
+	 * @param action Constraints with another action are ignored. UNDEFINED_ACTION
+	 *        makes all constraints applicable to all types.
+	 * @param rootId ID that is used for the "me" alias.
+	 */
+	void compile(const std::vector<GraphConstraint>& constraints, GraphConstraint::Action action, Id rootId);
+
+	/// Check if this policy has been compiled from the same input, i.e. if it is still up to date.
+	bool isCompiledFrom(const std::vector<GraphConstraint>& constraints, GraphConstraint::Action action, Id rootId) const;
+
+	/// Indices of the constraints that apply to a type of update.
+	const std::vector<unsigned int>& getApplicableConstraints(GraphConstraint::Type type) const;
+
+	const GraphConstraint& getConstraint(unsigned int index) const {
+		return constraints[index];
+	}
+
+	const std::vector<GraphConstraint>& getConstraints() const {
+		return constraints;
+	}
+
+	/// Resolved reference node for a DISTANCE or CONTAINMENT constraint. Nil for all others.
+	Id getReferenceNode(unsigned int index) const {
+		return compiledConstraints[index].referenceNode;
+	}
+
+	/// Compiled query for a CONTEXT constraint.
+	const AttributeQuery& getContextQuery(unsigned int index) const {
+		return compiledConstraints[index].contextQuery;
+	}
+
+	/// All resolved reference nodes of applicable DISTANCE and CONTAINMENT constraints.
+	const std::set<Id>& getReferenceNodes() const {
+		return referenceNodes;
+	}
+
+	/// All semantic contexts of applicable CONTEXT constraints.
+	const std::set<std::string>& getContexts() const {
+		return contexts;
+	}
+
+	/// True if at least one LOD constraint applies to the given type.
+	bool requiresLOD(GraphConstraint::Type type) const;
+
+	/**
+	 * @brief Check if a constraint can reject an update of a certain type.
+	 * It is false if GraphConstraintUpdateFilter::checkConstraint() would be true without any evaluation.
+	 */
+	static bool appliesTo(const GraphConstraint& constraint, GraphConstraint::Action action, GraphConstraint::Type type);
+
+	/// Create the attribute query for a semantic context.
+	static AttributeQuery createContextQuery(const std::string& context);
+
+private:
+
+	struct CompiledConstraint {
+		Id referenceNode;
+		AttributeQuery contextQuery;
+	};
+
+	std::vector<GraphConstraint> constraints;
+	std::vector<CompiledConstraint> compiledConstraints;
+	GraphConstraint::Action action;
+	Id rootId;
+
+	/// Applicable constraint indices per type.
+	std::vector<unsigned int> dispatchTable[GraphConstraint::TYPE_NR_ITEMS];
+
+	/// Per type flag if an LOD constraint applies.
+	bool lodIsRequired[GraphConstraint::TYPE_NR_ITEMS];
+
+	std::set<Id> referenceNodes;
+	std::set<std::string> contexts;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_GRAPHCONSTRAINTPOLICY_H_ */
+
+/* EOF */
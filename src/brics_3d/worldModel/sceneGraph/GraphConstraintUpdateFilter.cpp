@@ -29,15 +29,17 @@ namespace rsg {
 
 const std::string GraphConstraintUpdateFilter::contraintKey = "rsg:agent_policy";
 
-GraphConstraintUpdateFilter::GraphConstraintUpdateFilter(WorldModel* wm, UpdateMode mode) : mode(mode), wm(wm) {
+GraphConstraintUpdateFilter::GraphConstraintUpdateFilter(WorldModel* wm, UpdateMode mode) : mode(mode), wm(wm), distanceEvaluator(wm) {
 	this->nameSpaceIdentifier = "unknown_namespace";
+	constraintsVersion = 1;
+	compiledConstraintsVersion = 0;
 	assert(this->wm != 0);
 
 	/* get initial constraints from root node */
 	vector<Attribute> rootAttributes;
 	wm->scene.getNodeAttributes(wm->getRootNodeId(), rootAttributes);
-	getConstraintsFromAttributes(rootAttributes, this->constraints);
-
+	updateConstraintsFromAttributes(rootAttributes);
+	updatePolicy(); // resolves the reference nodes in advance
 }
 
 GraphConstraintUpdateFilter::~GraphConstraintUpdateFilter() {
@@ -48,12 +50,9 @@ bool GraphConstraintUpdateFilter::addNode(Id parentId, Id& assignedId,
 		vector<Attribute> attributes, bool forcedId) {
 	bool success = true;
 
-	std::vector<GraphConstraint>::iterator it;
-	for (it = constraints.begin(); it != constraints.end(); ++it) {
-		if (!checkConstraint(*it, GraphConstraint::Node, 0, 0, 0, assignedId, attributes)) {
-			LOG(DEBUG) << "GraphConstraintUpdateFilter::addNode is skipped because a constraint does not hold.";
-			return false;
-		}
+	if (!checkConstraints(GraphConstraint::Node, 0, assignedId, attributes)) {
+		LOG(DEBUG) << "GraphConstraintUpdateFilter::addNode is skipped because a constraint does not hold.";
+		return false;
 	}
 
 	/* Memorize last invocation */
@@ -72,12 +71,9 @@ bool GraphConstraintUpdateFilter::addGroup(Id parentId, Id& assignedId,
 		vector<Attribute> attributes, bool forcedId) {
 	bool success = true;
 
-	std::vector<GraphConstraint>::iterator it;
-	for (it = constraints.begin(); it != constraints.end(); ++it) {
-		if (!checkConstraint(*it, GraphConstraint::Group, 0, 0, 0, assignedId, attributes)) {
-			LOG(DEBUG) << "GraphConstraintUpdateFilter::addGroup is skipped because a constraint does not hold.";
-			return false;
-		}
+	if (!checkConstraints(GraphConstraint::Group, 0, assignedId, attributes)) {
+		LOG(DEBUG) << "GraphConstraintUpdateFilter::addGroup is skipped because a constraint does not hold.";
+		return false;
 	}
 
 	/* Memorize last invocation */
@@ -99,12 +95,9 @@ bool GraphConstraintUpdateFilter::addTransformNode(Id parentId, Id& assignedId,
 		TimeStamp timeStamp, bool forcedId) {
 	bool success = true;
 
-	std::vector<GraphConstraint>::iterator it;
-	for (it = constraints.begin(); it != constraints.end(); ++it) {
-		if (!checkConstraint(*it, GraphConstraint::Transform, 0, 0, 0, assignedId, attributes)) {
-			LOG(DEBUG) << "GraphConstraintUpdateFilter::addTransformNode is skipped because a constraint does not hold.";
-			return false;
-		}
+	if (!checkConstraints(GraphConstraint::Transform, 0, assignedId, attributes)) {
+		LOG(DEBUG) << "GraphConstraintUpdateFilter::addTransformNode is skipped because a constraint does not hold.";
+		return false;
 	}
 
 	/* Memorize last invocation */
@@ -127,12 +120,9 @@ bool GraphConstraintUpdateFilter::addUncertainTransformNode(Id parentId,
 		TimeStamp timeStamp, bool forcedId) {
 	bool success = true;
 
-	std::vector<GraphConstraint>::iterator it;
-	for (it = constraints.begin(); it != constraints.end(); ++it) {
-		if (!checkConstraint(*it, GraphConstraint::Transform, 0, 0, 0, assignedId, attributes)) {
-			LOG(DEBUG) << "GraphConstraintUpdateFilter::addUncertainTransformNode is skipped because a constraint does not hold.";
-			return false;
-		}
+	if (!checkConstraints(GraphConstraint::Transform, 0, assignedId, attributes)) {
+		LOG(DEBUG) << "GraphConstraintUpdateFilter::addUncertainTransformNode is skipped because a constraint does not hold.";
+		return false;
 	}
 
 	/* Memorize last invocation */
@@ -153,7 +143,7 @@ bool GraphConstraintUpdateFilter::addGeometricNode(Id parentId, Id& assignedId,
 		TimeStamp timeStamp, bool forcedId) {
 	bool success = true;
 
-	GraphConstraint::Type shapeType;
+	GraphConstraint::Type shapeType = GraphConstraint::UNDEFINED_TYPE;
 	switch (shape->getShapeType()) {
 		case Shape::Sphere:
 			shapeType = GraphConstraint::Sphere;
@@ -175,18 +165,18 @@ bool GraphConstraintUpdateFilter::addGeometricNode(Id parentId, Id& assignedId,
 	}
 
 	double lod = -1.0;
-	lodCalculator.calculateLOD(shape, lod);
+	updatePolicy();
+	if (policy.requiresLOD(GraphConstraint::GeometricNode) || policy.requiresLOD(shapeType)) { // only required for LOD constraints
+		lodCalculator.calculateLOD(shape, lod);
+	}
 
-	std::vector<GraphConstraint>::iterator it;
-	for (it = constraints.begin(); it != constraints.end(); ++it) {
-		if (!checkConstraint(*it, GraphConstraint::GeometricNode, 0, 0, lod, assignedId, attributes)) {
-			LOG(DEBUG) << "GraphConstraintUpdateFilter::addGeometricNode is skipped because a constraint does not hold for GeometricNode.";
-			return false;
-		}
-		if (!checkConstraint(*it, shapeType, 0, 0, lod, assignedId, attributes)) {
-			LOG(DEBUG) << "GraphConstraintUpdateFilter::addGeometricNode is skipped because a constraint does not hold for Shape type " << shapeType << ".";
-			return false;
-		}
+	if (!checkConstraints(GraphConstraint::GeometricNode, lod, assignedId, attributes)) {
+		LOG(DEBUG) << "GraphConstraintUpdateFilter::addGeometricNode is skipped because a constraint does not hold for GeometricNode.";
+		return false;
+	}
+	if (!checkConstraints(shapeType, lod, assignedId, attributes)) {
+		LOG(DEBUG) << "GraphConstraintUpdateFilter::addGeometricNode is skipped because a constraint does not hold for Shape type " << shapeType << ".";
+		return false;
 	}
 
 	/* Memorize last invocation */
@@ -221,12 +211,9 @@ bool GraphConstraintUpdateFilter::addRemoteRootNode(Id rootId, vector<Attribute>
 bool GraphConstraintUpdateFilter::addConnection(Id parentId, Id& assignedId, vector<Attribute> attributes, vector<Id> sourceIds, vector<Id> targetIds, TimeStamp start, TimeStamp end, bool forcedId) {
 	bool success = true;
 
-	std::vector<GraphConstraint>::iterator it;
-	for (it = constraints.begin(); it != constraints.end(); ++it) {
-		if (!checkConstraint(*it, GraphConstraint::Connection, 0, 0, 0, assignedId, attributes)) {
-			LOG(DEBUG) << "GraphConstraintUpdateFilter::addConnection is skipped because a constraint does not hold.";
-			return false;
-		}
+	if (!checkConstraints(GraphConstraint::Connection, 0, assignedId, attributes)) {
+		LOG(DEBUG) << "GraphConstraintUpdateFilter::addConnection is skipped because a constraint does not hold.";
+		return false;
 	}
 
 	/* Memorize last invocation */
@@ -248,7 +235,7 @@ bool GraphConstraintUpdateFilter::setNodeAttributes(Id id,
 	/* Check if new constraints are set via Attributes for the root node */
 	if( id == wm->getRootNodeId()) {
 		LOG(DEBUG) << "GraphConstraintUpdateFilter::setNodeAttributes: A change of root node attributes is detected. Updating graph constriants.";
-		getConstraintsFromAttributes(newAttributes, this->constraints);
+		updateConstraintsFromAttributes(newAttributes);
 	}
 
 	/* NOTE: here we check the _existing_ attributes to be consistent with other update functions. Not the new ones. */
@@ -259,12 +246,9 @@ bool GraphConstraintUpdateFilter::setNodeAttributes(Id id,
 	}
 
 
-	std::vector<GraphConstraint>::iterator it;
-	for (it = constraints.begin(); it != constraints.end(); ++it) {
-		if (!checkConstraint(*it, GraphConstraint::Atom, 0, 0, 0, id, attributes)) { // assignedID?
-			LOG(DEBUG) << "GraphConstraintUpdateFilter::setNodeAttributes is skipped because a constraint does not hold.";
-			return false;
-		}
+	if (!checkConstraints(GraphConstraint::Atom, 0, id, attributes)) {
+		LOG(DEBUG) << "GraphConstraintUpdateFilter::setNodeAttributes is skipped because a constraint does not hold.";
+		return false;
 	}
 
 	/* Call _all_ observers  */
@@ -280,18 +264,18 @@ bool GraphConstraintUpdateFilter::setTransform(Id id,
 		TimeStamp timeStamp) {
 	bool success = true;
 
+	/* Keep transforms of reference nodes for DISTANCE constraints up to date */
+	distanceEvaluator.transformChanged(id);
+
 	vector<Attribute> attributes;
 	if(!wm->scene.getNodeAttributes(id, attributes)) {
 		LOG(ERROR) << "semanticContextUpdateFilter:setTransform cannot query existing attributes for id " << id << " Skipping update.";
 		return false;
 	}
 
-	std::vector<GraphConstraint>::iterator it;
-	for (it = constraints.begin(); it != constraints.end(); ++it) {
-		if (!checkConstraint(*it, GraphConstraint::TransformUpdate, 0, 0, 0, id, attributes)) { // assignedID?
-			LOG(DEBUG) << "GraphConstraintUpdateFilter::setTransform is skipped because a constraint does not hold.";
-			return false;
-		}
+	if (!checkConstraints(GraphConstraint::TransformUpdate, 0, id, attributes)) {
+		LOG(DEBUG) << "GraphConstraintUpdateFilter::setTransform is skipped because a constraint does not hold.";
+		return false;
 	}
 
 	/* Memorize last invocation */
@@ -302,6 +286,9 @@ bool GraphConstraintUpdateFilter::setTransform(Id id,
 	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
 		success &= (*observerIterator)->setTransform(id, transform, timeStamp);
 	}
+	if (mode == RECEIVER) { // the world model has just applied the update; the constraints were checked against the old state
+		distanceEvaluator.transformChanged(id);
+	}
 	return success;
 }
 
@@ -311,18 +298,18 @@ bool GraphConstraintUpdateFilter::setUncertainTransform(Id id,
 		TimeStamp timeStamp) {
 	bool success = true;
 
+	/* Keep transforms of reference nodes for DISTANCE constraints up to date */
+	distanceEvaluator.transformChanged(id);
+
 	vector<Attribute> attributes;
 	if(!wm->scene.getNodeAttributes(id, attributes)) {
 		LOG(ERROR) << "semanticContextUpdateFilter:setUncertainTransform cannot query existing attributes for id " << id << " Skipping update.";
 		return false;
 	}
 
-	std::vector<GraphConstraint>::iterator it;
-	for (it = constraints.begin(); it != constraints.end(); ++it) {
-		if (!checkConstraint(*it, GraphConstraint::TransformUpdate, 0, 0, 0, id, attributes)) { // assignedID?
-			LOG(DEBUG) << "GraphConstraintUpdateFilter::setUncertainTransform is skipped because a constraint does not hold.";
-			return false;
-		}
+	if (!checkConstraints(GraphConstraint::TransformUpdate, 0, id, attributes)) {
+		LOG(DEBUG) << "GraphConstraintUpdateFilter::setUncertainTransform is skipped because a constraint does not hold.";
+		return false;
 	}
 
 	/* Memorize last invocation */
@@ -333,6 +320,9 @@ bool GraphConstraintUpdateFilter::setUncertainTransform(Id id,
 	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
 		success &= (*observerIterator)->setUncertainTransform(id, transform, uncertainty, timeStamp);
 	}
+	if (mode == RECEIVER) {
+		distanceEvaluator.transformChanged(id);
+	}
 	return success;
 }
 
@@ -342,6 +332,7 @@ bool GraphConstraintUpdateFilter::deleteNode(Id id) {
 	/*
 	 *  This cannot be constrained, because we cannot make queries on it: it does not exist any more...
 	 */
+	distanceEvaluator.structureChanged(id);
 
 	/* Call _all_ observers  */
 	std::vector<ISceneGraphUpdateObserver*>::iterator observerIterator;
@@ -354,18 +345,17 @@ bool GraphConstraintUpdateFilter::deleteNode(Id id) {
 bool GraphConstraintUpdateFilter::addParent(Id id, Id parentId) {
 	bool success = true;
 
+	distanceEvaluator.structureChanged(id);
+
 	vector<Attribute> attributes;
 	if(!wm->scene.getNodeAttributes(id, attributes)) {
 		LOG(ERROR) << "semanticContextUpdateFilter:addParent cannot query existing attributes for id " << id << " Skipping update.";
 		return false;
 	}
 
-	std::vector<GraphConstraint>::iterator it;
-	for (it = constraints.begin(); it != constraints.end(); ++it) {
-		if (!checkConstraint(*it, GraphConstraint::Atom, 0, 0, 0, id, attributes)) { // assignedID?
-			LOG(DEBUG) << "GraphConstraintUpdateFilter::addParent is skipped because a constraint does not hold.";
-			return false;
-		}
+	if (!checkConstraints(GraphConstraint::Atom, 0, id, attributes)) {
+		LOG(DEBUG) << "GraphConstraintUpdateFilter::addParent is skipped because a constraint does not hold.";
+		return false;
 	}
 
 	/* Call _all_ observers  */
@@ -373,24 +363,26 @@ bool GraphConstraintUpdateFilter::addParent(Id id, Id parentId) {
 	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
 		success &= (*observerIterator)->addParent(id, parentId);
 	}
+	if (mode == RECEIVER) {
+		distanceEvaluator.structureChanged(id);
+	}
 	return success;
 }
 
 bool GraphConstraintUpdateFilter::removeParent(Id id, Id parentId) {
 	bool success = true;
 
+	distanceEvaluator.structureChanged(id);
+
 	vector<Attribute> attributes;
 	if(!wm->scene.getNodeAttributes(id, attributes)) {
 		LOG(ERROR) << "semanticContextUpdateFilter:removeParent cannot query existing attributes for id " << id << " Skipping update.";
 		return false;
 	}
 
-	std::vector<GraphConstraint>::iterator it;
-	for (it = constraints.begin(); it != constraints.end(); ++it) {
-		if (!checkConstraint(*it, GraphConstraint::Atom, 0, 0, 0, id, attributes)) { // assignedID?
-			LOG(DEBUG) << "GraphConstraintUpdateFilter::removeParent is skipped because a constraint does not hold.";
-			return false;
-		}
+	if (!checkConstraints(GraphConstraint::Atom, 0, id, attributes)) {
+		LOG(DEBUG) << "GraphConstraintUpdateFilter::removeParent is skipped because a constraint does not hold.";
+		return false;
 	}
 
 	/* Call _all_ observers  */
@@ -398,6 +390,9 @@ bool GraphConstraintUpdateFilter::removeParent(Id id, Id parentId) {
 	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
 		success &= (*observerIterator)->removeParent(id, parentId);
 	}
+	if (mode == RECEIVER) {
+		distanceEvaluator.structureChanged(id);
+	}
 	return success;
 }
 
@@ -431,19 +426,78 @@ void GraphConstraintUpdateFilter::setNameSpaceIdentifier(
 	this->query =  "^"  + nameSpaceIdentifier + ":.*"; // wildcard = ^.*
 }
 
-bool GraphConstraintUpdateFilter::checkConstraint(GraphConstraint constraint,
+bool GraphConstraintUpdateFilter::checkConstraint(const GraphConstraint& constraint,
+		GraphConstraint::Type type, double frequencyInHz, double distanceInMeters,
+		double lod, Id assignedId, const vector<Attribute>& attributes) {
+
+	/* resolve on the fly, what is otherwise precompiled in the policy */
+	Id referenceNode = constraint.isMe ? wm->getRootNodeId() : constraint.node;
+	AttributeQuery contextQuery;
+	if (constraint.nodeConstraint == GraphConstraint::CONTEXT) {
+		contextQuery = GraphConstraintPolicy::createContextQuery(constraint.context);
+	}
+
+	return evaluateConstraint(constraint, referenceNode, contextQuery, type, frequencyInHz, distanceInMeters, lod, assignedId, attributes);
+}
+
+bool GraphConstraintUpdateFilter::checkConstraints(GraphConstraint::Type type, double lod, Id assignedId, const vector<Attribute>& attributes) {
+	updatePolicy();
+
+	const std::vector<unsigned int>& applicableConstraints = policy.getApplicableConstraints(type);
+	for (std::vector<unsigned int>::const_iterator it = applicableConstraints.begin(); it != applicableConstraints.end(); ++it) {
+		if (!evaluateConstraint(policy.getConstraint(*it), policy.getReferenceNode(*it), policy.getContextQuery(*it), type, 0, 0, lod, assignedId, attributes)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void GraphConstraintUpdateFilter::updatePolicy() {
+	if (compiledConstraintsVersion == constraintsVersion) { // the mode and the root node never change
+		return;
+	}
+
+	GraphConstraint::Action action = GraphConstraint::UNDEFINED_ACTION;
+	if (mode == SENDER) {
+		action = GraphConstraint::SEND;
+	} else if (mode == RECEIVER) {
+		action = GraphConstraint::RECEIVE;
+	}
+
+	policy.compile(constraints, action, wm->getRootNodeId());
+	compiledConstraintsVersion = constraintsVersion;
+	distanceEvaluator.resolveReferenceNodes(policy.getConstraints());
+}
+
+void GraphConstraintUpdateFilter::constraintsChanged() {
+	constraintsVersion++;
+}
+
+void GraphConstraintUpdateFilter::updateConstraintsFromAttributes(const vector<Attribute>& attributes) {
+	vector<std::string> constraintModels;
+	getValuesFromAttributeList(attributes, contraintKey, constraintModels);
+	if (!constraintModels.empty() && (constraintModels == parsedConstraintModels) && (constraints == parsedConstraints)) {
+		LOG(DEBUG) << "GraphConstraintUpdateFilter: Graph constraints are unchanged.";
+		return;
+	}
+
+	getConstraintsFromAttributes(attributes, this->constraints);
+	constraintsVersion++;
+	if (!constraintModels.empty()) {
+		parsedConstraintModels = constraintModels;
+		parsedConstraints = constraints;
+	}
+}
+
+bool GraphConstraintUpdateFilter::evaluateConstraint(const GraphConstraint& constraint, Id referenceNode, const AttributeQuery& contextQuery,
 		GraphConstraint::Type type, double frequencyInHz, double distanceInMeters,
-		double lod, Id assignedId, vector<Attribute> attributes) {
+		double lod, Id assignedId, const vector<Attribute>& attributes) {
 
-	//GraphConstraint::Type type = GraphConstraint::Node;
 	double allowedFrequencyInHz = 0.0;
 	double allowedDistanceInMeters = 0.0;
 	double allowedLod = 0.0;
-	Id referenceNode;
-	HomogeneousMatrix44::IHomogeneousMatrix44Ptr tf;
 	SubGraphChecker subGraph(assignedId);
 	bool isContainedIn = false;
-	string query = "*";
 
 	/*
 	 * Does the constraint apply at all based on the SENDER or RECEIVER mode?
@@ -527,19 +581,11 @@ bool GraphConstraintUpdateFilter::checkConstraint(GraphConstraint constraint,
 
 		case GraphConstraint::DISTANCE:
 
-			/* get reference node */
-			if(constraint.isMe) {
-				referenceNode = wm->getRootNodeId();
-			} else {
-				referenceNode = constraint.node;
-			}
-
-			/* compute distance */
-			if(!wm->scene.getTransformForNode(assignedId, referenceNode, wm->now(), tf)) { // TODO find a way for to get the distance for non existing nodes (e.g. parent)
+			/* compute distance to the reference node */
+			if(!distanceEvaluator.computeDistance(constraint, assignedId, distanceInMeters)) { // TODO find a way for to get the distance for non existing nodes (e.g. parent)
 				LOG(WARNING) << "GraphConstraintUpdateFilter:checkConstraint is false because the distance between two nodes could not been derived.";
 						return false;
 			}
-			HomogeneousMatrix44::matrixToDistance(tf, distanceInMeters); // in meters ?!?
 
 			/* check it */
 			allowedDistanceInMeters = Units::distanceToMeters(constraint.value, constraint.distUnit);
@@ -549,10 +595,9 @@ bool GraphConstraintUpdateFilter::checkConstraint(GraphConstraint constraint,
 
 		case GraphConstraint::CONTEXT:
 
-			query =  "^"  + constraint.context + ":.*"; // wildcard = ^.*
 			if(constraint.qualifier == GraphConstraint::ONLY) {
 
-				if (attributeListContainsAttribute(attributes, Attribute(query, "*"))) {
+				if (contextQuery.matches(attributes)) {
 					LOG(DEBUG) << "GraphConstraintUpdateFilter:checkConstraint is true because attributes contain (only) (" << constraint.context << ", *)";
 					return true;
 				} else {
@@ -562,7 +607,7 @@ bool GraphConstraintUpdateFilter::checkConstraint(GraphConstraint constraint,
 
 			} else if (constraint.qualifier == GraphConstraint::NO) {
 
-				if (attributeListContainsAttribute(attributes, Attribute(query, "*"))) {
+				if (contextQuery.matches(attributes)) {
 					LOG(DEBUG) << "GraphConstraintUpdateFilter:checkConstraint is false because attributes contain (no) (" << constraint.context << ", *)";
 					return false;
 				} else {
@@ -576,13 +621,6 @@ bool GraphConstraintUpdateFilter::checkConstraint(GraphConstraint constraint,
 
 		case GraphConstraint::CONTAINMENT:
 
-			/* get reference node */
-			if(constraint.isMe) {
-				referenceNode = wm->getRootNodeId();
-			} else {
-				referenceNode = constraint.node;
-			}
-
 			subGraph.reset(referenceNode); // NOTE: upwards traversal
 			wm->scene.executeGraphTraverser(&subGraph, assignedId);
 			isContainedIn = subGraph.nodeIsInSubGraph();
@@ -626,7 +664,7 @@ bool GraphConstraintUpdateFilter::checkConstraint(GraphConstraint constraint,
 	return true;
 }
 
-bool GraphConstraintUpdateFilter::checkComparision(GraphConstraint constraint, GraphConstraint::Type type, double value, double allowedValue, string tag) {
+bool GraphConstraintUpdateFilter::checkComparision(const GraphConstraint& constraint, GraphConstraint::Type type, double value, double allowedValue, const string& tag) {
 
 	// NO
 	if( 	((constraint.qualifier == GraphConstraint::NO) && (constraint.type == type)) ||
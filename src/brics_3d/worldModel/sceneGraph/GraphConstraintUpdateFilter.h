@@ -24,7 +24,9 @@
 #include "brics_3d/worldModel/WorldModel.h"
 #include "brics_3d/worldModel/sceneGraph/Attribute.h"
 #include "brics_3d/worldModel/sceneGraph/GraphConstraint.h"
+#include "brics_3d/worldModel/sceneGraph/GraphConstraintPolicy.h"
 #include "brics_3d/worldModel/sceneGraph/LODCalculator.h"
+#include "brics_3d/worldModel/sceneGraph/DistanceConstraintEvaluator.h"
 
 
 namespace brics_3d {
@@ -69,22 +71,45 @@ public:
 
 	void setNameSpaceIdentifier(const string& nameSpaceIdentifier);
 
-    /// THE local graph constraints, as specified by this root node
+    /**
+     * THE local graph constraints, as specified by this root node.
+     * They are compiled into a policy that is reused for all updates. After modifying them
+     * directly, constraintsChanged() has to be called, otherwise the old policy stays in effect.
+     */
     std::vector<GraphConstraint> constraints;
 
+    /**
+     * Recompile the policy on the next update. This also resolves the reference nodes of
+     * DISTANCE constraints again. Constraints parsed from the root node attributes are
+     * picked up automatically.
+     */
+    void constraintsChanged();
+
     /// THE remote graph constraints, as specified by other root nodes
 
-    /// Implements the constraint checking algorithm
-    bool checkConstraint(GraphConstraint constraint, GraphConstraint::Type type, double frequencyInHz, double distanceInMeters, double lod, Id assignedId, vector<Attribute> attributes);
+    /// Implements the constraint checking algorithm for a single (not precompiled) constraint
+    bool checkConstraint(const GraphConstraint& constraint, GraphConstraint::Type type, double frequencyInHz, double distanceInMeters, double lod, Id assignedId, const vector<Attribute>& attributes);
 
     /// Implements the constraint checking part involving a comparison
-    bool checkComparision(GraphConstraint constraint, GraphConstraint::Type type, double value, double allowedValue, string tag);
+    bool checkComparision(const GraphConstraint& constraint, GraphConstraint::Type type, double value, double allowedValue, const string& tag);
 
     /// Implements extraction of constraints from an attribute set.
     bool getConstraintsFromAttributes(vector<Attribute> attributes, std::vector<GraphConstraint>& constraints);
 
 private:
 
+    /// Check all applicable constraints for an update, based on the compiled policy.
+    bool checkConstraints(GraphConstraint::Type type, double lod, Id assignedId, const vector<Attribute>& attributes);
+
+    /// Recompile the policy, if the constraints have been changed.
+    void updatePolicy();
+
+    /// Parse the constraints from (root node) attributes, unless they are the same as before.
+    void updateConstraintsFromAttributes(const vector<Attribute>& attributes);
+
+    /// Evaluates a constraint with resolved reference node and context query.
+    bool evaluateConstraint(const GraphConstraint& constraint, Id referenceNode, const AttributeQuery& contextQuery, GraphConstraint::Type type, double frequencyInHz, double distanceInMeters, double lod, Id assignedId, const vector<Attribute>& attributes);
+
     /// input or Output
     UpdateMode mode;
 
@@ -103,10 +128,24 @@ private:
     /// Per type time stamps. Relevant for FREQUENCY constraints.
     TimeStamp lastSendType[GraphConstraint::TYPE_NR_ITEMS];
 
-    /// Get LOD from Shapes in case of LOD constraints
+    /// Get LOD from Shapes in case of LOD constraints. It is computed once per added GeometricNode, as its shape does not change.
     LODCalculator lodCalculator;
 
+    /// Get distances to the (pre-resolved) reference nodes in case of DISTANCE constraints
+    DistanceConstraintEvaluator distanceEvaluator;
+
+    /// Compiled version of the constraints.
+    GraphConstraintPolicy policy;
+
+    /// Constraint models of the last parsed root node attributes and the resulting constraints.
+    vector<std::string> parsedConstraintModels;
+    std::vector<GraphConstraint> parsedConstraints;
+
     const static std::string contraintKey;
+
+    /// Incremented by constraintsChanged() and by parsing new constraints. The policy is recompiled if it differs from compiledConstraintsVersion.
+    unsigned int constraintsVersion;
+    unsigned int compiledConstraintsVersion;
 };
 
 
@@ -0,0 +1,97 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#include "GraphTraverser.h"
+#include "Group.h"
+#include <assert.h>
+#include <vector>
+#include <boost/unordered_set.hpp>
+
+namespace brics_3d {
+namespace rsg {
+
+namespace {
+
+/// A stack entry. Children are held by a shared pointer, such that they stay valid even if a visitor deletes them from the graph.
+struct PendingNode {
+	PendingNode(Node* node, Node::NodePtr handle, int depth) : node(node), handle(handle), depth(depth) {}
+	Node* node;
+	Node::NodePtr handle;
+	int depth;
+};
+
+}
+
+unsigned int GraphTraverser::traverse(Node* startNode, INodeVisitor* visitor) {
+	assert(startNode != 0);
+	assert(visitor != 0);
+
+	const INodeVisitor::TraverseDirection direction = visitor->getDirection();
+	const int maxDepth = visitor->getMaxDepth();
+	const bool visitEachNodeOnce = visitor->getVisitEachNodeOnce();
+	boost::unordered_set<Node*> visitedNodes;
+	unsigned int visitCount = 0;
+
+	std::vector<PendingNode> pendingNodes;
+	pendingNodes.push_back(PendingNode(startNode, Node::NodePtr(), 0));
+
+	while (!pendingNodes.empty()) {
+		PendingNode current = pendingNodes.back();
+		pendingNodes.pop_back();
+
+		if (visitEachNodeOnce && !visitedNodes.insert(current.node).second) {
+			continue;
+		}
+
+		visitor->setVisitControl(INodeVisitor::continueTraversal);
+		current.node->acceptWithoutTraversal(visitor);
+		visitCount++;
+
+		INodeVisitor::VisitControl control = visitor->getVisitControl();
+		visitor->setVisitControl(INodeVisitor::continueTraversal);
+		if (control == INodeVisitor::stopTraversal) {
+			break;
+		}
+		if (control == INodeVisitor::skipChildren || (maxDepth >= 0 && current.depth >= maxDepth)) {
+			continue;
+		}
+
+		/* push in reverse order, so the first child/parent is processed first */
+		if (direction == INodeVisitor::upwards) {
+			for (int i = static_cast<int>(current.node->getNumberOfParents()) - 1; i >= 0; --i) {
+				pendingNodes.push_back(PendingNode(current.node->getParent(i), Node::NodePtr(), current.depth + 1));
+			}
+		} else if (direction == INodeVisitor::downwards) {
+			Group* group = dynamic_cast<Group*>(current.node);
+			if (group != 0) {
+				for (int i = static_cast<int>(group->getNumberOfChildren()) - 1; i >= 0; --i) {
+					Node::NodePtr child = group->getChild(i);
+					pendingNodes.push_back(PendingNode(child.get(), child, current.depth + 1));
+				}
+			}
+		}
+	}
+
+	return visitCount;
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
@@ -0,0 +1,74 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#ifndef RSG_GRAPHTRAVERSER_H_
+#define RSG_GRAPHTRAVERSER_H_
+
+#include "INodeVisitor.h"
+#include "Node.h"
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Iterative traversal engine that is used by Node::accept().
+ * @ingroup sceneGraph
+ *
+ * The graph is traversed depth first in the same (pre-)order as a recursive traversal
+ * would do, but with an explicit stack. Thus deep graphs can not exhaust the call stack.
+ * The engine evaluates the settings of the visitor:
+ *  - INodeVisitor::getDirection() downwards follows the children, upwards the parents
+ *    and custom visits only the start node.
+ *  - INodeVisitor::getVisitControl() as set within a visit call allows to skip the
+ *    children of the current node or to stop the whole traversal.
+ *  - INodeVisitor::getVisitEachNodeOnce() skips already visited nodes in DAGs.
+ *  - INodeVisitor::getMaxDepth() limits the depth of the traversal.
+ *
+ * Example for an early terminating query:
+ * @code
+ * class FirstMatchFinder : public AttributeFinder {
+ *   void visit(Node* node) {
+ *     AttributeFinder::visit(node);
+ *     if (!matchingNodes.empty()) {
+ *       setVisitControl(stopTraversal);
+ *     }
+ *   }
+ *   ...
+ * };
+ * @endcode
+ */
+class GraphTraverser {
+public:
+
+	/**
+	 * @brief Traverse the graph starting at a node.
+	 * @param startNode The node where the traversal begins.
+	 * @param visitor The visitor whose visit() functions are called for every reached node.
+	 * @return Number of visited nodes.
+	 */
+	static unsigned int traverse(Node* startNode, INodeVisitor* visitor);
+
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_GRAPHTRAVERSER_H_ */
+
+/* EOF */
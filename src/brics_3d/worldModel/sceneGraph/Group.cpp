@@ -111,19 +111,8 @@ unsigned int Group::getNumberOfChildren() const {
 	return static_cast<unsigned int>(children.size());
 }
 
-void Group::accept(INodeVisitor* visitor){
+void Group::acceptWithoutTraversal(INodeVisitor* visitor) {
 	visitor->visit(this);
-	if (visitor->getDirection() == INodeVisitor::upwards) { //TODO move to "traverseUpwards" method?
-	    for(unsigned i = 0; i < getNumberOfParents(); ++i) // recursively go up the graph structure
-	    {
-	        getParent(i)->accept(visitor);
-	    }
-	} else if (visitor->getDirection() == INodeVisitor::downwards) { //TODO move to "traverseDownwards" method?
-		for(unsigned i = 0; i < getNumberOfChildren(); ++i) // recursively go down the graph structure
-		{
-			getChild(i)->accept(visitor);
-		}
-	}
 }
 
 } // namespace brics_3d::RSG
@@ -53,7 +53,7 @@ public:
 
     NodePtr getChild(unsigned int index);
 
-    virtual void accept(INodeVisitor* visitor);
+    virtual void acceptWithoutTraversal(INodeVisitor* visitor);
 
   private:
     vector<NodePtr> children;
@@ -25,8 +25,30 @@
 namespace brics_3d {
 namespace rsg {
 
+/*
+ * Snapshot of the graph for a keyframe. The local root node already exists on
+ * replay, so only its attributes are recorded. Adding it again would fail and
+ * applyUpdateBatch() would reject the whole keyframe.
+ */
+class KeyframeBatch : public SceneGraphUpdateBatch {
+public:
+	KeyframeBatch(Id rootId, TimeStamp timeStamp) : rootId(rootId), timeStamp(timeStamp) {};
+	virtual ~KeyframeBatch(){};
+
+	bool addRemoteRootNode(Id id, vector<Attribute> attributes) {
+		if (id == rootId) {
+			return setNodeAttributes(id, attributes, timeStamp);
+		}
+		return SceneGraphUpdateBatch::addRemoteRootNode(id, attributes);
+	}
+
+private:
+	Id rootId;
+	TimeStamp timeStamp;
+};
+
 
-HDF5AppendOnlyLogger::HDF5AppendOnlyLogger(WorldModel* wm) : wm(wm) {
+HDF5AppendOnlyLogger::HDF5AppendOnlyLogger(WorldModel* wm) : wm(wm), mode(GROUP_PER_UPDATE) {
 	logFile = 0;
 
 	std::stringstream instanceBasedSuffix;
@@ -56,7 +78,7 @@ HDF5AppendOnlyLogger::HDF5AppendOnlyLogger(WorldModel* wm) : wm(wm) {
 	initialize(fileName);
 }
 
-HDF5AppendOnlyLogger::HDF5AppendOnlyLogger(WorldModel* wm, string logFileName) : wm(wm) {
+HDF5AppendOnlyLogger::HDF5AppendOnlyLogger(WorldModel* wm, string logFileName, LogMode mode) : wm(wm), mode(mode) {
 	logFile = 0;
 	initialize(logFileName);
 }
@@ -64,10 +86,38 @@ HDF5AppendOnlyLogger::HDF5AppendOnlyLogger(WorldModel* wm, string logFileName) :
 void HDF5AppendOnlyLogger::initialize(string logFileName) {
 
 	/* some default values */
-	fileImageIncremet = 1*sizeof(char);
+	fileImageIncremet = 1024*1024*sizeof(char); // grow the in-memory file image in steps of 1MB rather than byte-wise
+	pointCloudStorageOptions.compressionLevel = 6; // logs are written once and kept, so lossless compression pays off
+	pointCloudStorageOptions.useShuffle = true;
+	binarySerializer = 0;
+	stagingPort = 0;
+	keyframeSerializer = 0;
+	keyframePort = 0;
+	keyframeIntervalInSec = 60.0;
+	lastKeyframeStamp = wm->now().getSeconds();
+	flushThread = 0;
+	maxStagedBytes = 1024*1024;
+	maxStagedUpdates = 4096;
+	flushIntervalInMs = 1000;
+	isWriting = false;
+	flushRequested = false;
+	stopRequested = false;
+	indexSize = 0;
+	messagesSize = 0;
+	transformsSize = 0;
+	keyframesSize = 0;
+
+	if (mode == UPDATE_TABLES) {
+		stagingPort = new StagingPort(this);
+		binarySerializer = new BinaryUpdateSerializer(stagingPort);
+		keyframePort = new StagingPort(this, true);
+		keyframeSerializer = new BinaryUpdateSerializer(keyframePort);
+	}
 
 	H5::FileAccPropList faplCore;
-	faplCore.setCore(fileImageIncremet, true); // toggle in-memory behavior
+	if (mode == GROUP_PER_UPDATE) {
+		faplCore.setCore(fileImageIncremet, true); // toggle in-memory behavior
+	} // else: the tables are written in large blocks, so the default driver writes directly to disk
 
 	try {
 		logFile = new H5::H5File (logFileName, /*H5F_ACC_RDWR | H5F_ACC_CREAT*/ H5F_ACC_TRUNC, H5::FileCreatPropList::DEFAULT, faplCore);
@@ -84,25 +134,316 @@ void HDF5AppendOnlyLogger::initialize(string logFileName) {
 		std::stringstream stamp;
 		stamp << std::fixed << wm->now().getSeconds();
 		logAttributes.push_back(Attribute("startStamp", stamp.str()));
+		if (mode == UPDATE_TABLES) {
+			logAttributes.push_back(Attribute("log_format", "update_tables"));
+		}
 		H5::Group logMetadata = logFile->createGroup("log-metadata");
 		HDF5Typecaster::addAttributesToHDF5Group(logAttributes, logMetadata);
 
+		if (mode == UPDATE_TABLES) {
+			initializeUpdateTables();
+		}
+
 	} catch (H5::Exception e) {
 		LOG(ERROR) << "HDF5AppendOnlyLogger: Cannot create HDF5 log file";
 		logFile = 0;
 	}
 }
 
+bool HDF5AppendOnlyLogger::initializeUpdateTables() {
+	H5::Group updates = logFile->createGroup("updates");
+
+	H5::DSetCreatPropList indexProperties = HDF5Typecaster::createChunkedDataSetProperties(1024, 6, true);
+	indexDataSet = HDF5Typecaster::createExtendibleHDF5DataSet("index", HDF5Typecaster::createLogIndexType(), indexProperties, updates);
+
+	H5::DSetCreatPropList messagesProperties = HDF5Typecaster::createChunkedDataSetProperties(64*1024, pointCloudStorageOptions.compressionLevel, false);
+	messagesDataSet = HDF5Typecaster::createExtendibleHDF5DataSet("messages", H5::PredType::NATIVE_UCHAR, messagesProperties, updates);
+
+	H5::DSetCreatPropList transformsProperties = HDF5Typecaster::createChunkedDataSetProperties(512, 6, true);
+	transformsDataSet = HDF5Typecaster::createExtendibleHDF5DataSet("transforms", HDF5Typecaster::createLogTransformType(), transformsProperties, updates);
+
+	H5::DSetCreatPropList keyframesProperties = HDF5Typecaster::createChunkedDataSetProperties(64);
+	keyframesDataSet = HDF5Typecaster::createExtendibleHDF5DataSet("keyframes", HDF5Typecaster::createLogKeyframeType(), keyframesProperties, updates);
+
+	stagingBuffer.messages.reserve(maxStagedBytes);
+	stagingBuffer.index.reserve(maxStagedUpdates);
+	writeBuffer.messages.reserve(maxStagedBytes);
+	writeBuffer.index.reserve(maxStagedUpdates);
+
+	flushThread = new boost::thread(boost::bind(&HDF5AppendOnlyLogger::flushLoop, this));
+	return true;
+}
+
 HDF5AppendOnlyLogger::~HDF5AppendOnlyLogger() {
+	if (flushThread) {
+		{
+			boost::mutex::scoped_lock lock(stagingMutex);
+			stopRequested = true;
+		}
+		flushCondition.notify_all();
+		flushThread->join(); // writes the remaining updates
+		delete flushThread;
+	}
+	delete binarySerializer;
+	delete stagingPort;
+	delete keyframeSerializer;
+	delete keyframePort;
+
 	if(logFile) {
 		logFile->close();
 		delete logFile;
 	}
 }
 
+int HDF5AppendOnlyLogger::StagingPort::write(const char *dataBuffer, int dataLength, int &transferredBytes) {
+	transferredBytes = 0;
+	if (!logger->stageMessage(dataBuffer, static_cast<unsigned int>(dataLength), isKeyframePort)) {
+		return -1;
+	}
+	transferredBytes = dataLength;
+	return 0;
+}
+
+void HDF5AppendOnlyLogger::waitForStagingSpace(boost::mutex::scoped_lock& lock, size_t messageLength) {
+	while (!stagingBuffer.empty() &&
+			((stagingBuffer.index.size() >= maxStagedUpdates) || (stagingBuffer.messages.size() + messageLength > maxStagedBytes))) {
+		LOG(DEBUG) << "HDF5AppendOnlyLogger: staging buffer is full. Waiting for the background thread.";
+		flushRequested = true;
+		flushCondition.notify_one();
+		spaceCondition.wait(lock);
+	}
+}
+
+bool HDF5AppendOnlyLogger::stageMessage(const char* data, unsigned int length, bool isKeyframe) {
+	boost::uint32_t messageLength = 0;
+	BinaryTypecaster::CommandType command;
+	if (!BinaryTypecaster::getMessageHeaderFromBinary(messageLength, command, data, length)) {
+		return false;
+	}
+
+	HDF5Typecaster::log_index_entry_t entry;
+	entry.logStamp = wm->now().getSeconds();
+	entry.command = static_cast<int>(command);
+	entry.table = HDF5Typecaster::LOG_MESSAGES_TABLE;
+	entry.length = length;
+
+	{
+		boost::mutex::scoped_lock lock(stagingMutex);
+		if (stopRequested || (flushThread == 0)) {
+			LOG(ERROR) << "HDF5AppendOnlyLogger: Cannot log to HDF. Log file is not open.";
+			return false;
+		}
+		waitForStagingSpace(lock, length);
+		entry.offset = stagingBuffer.messages.size(); // relative to the staging buffer until it is written
+		stagingBuffer.messages.insert(stagingBuffer.messages.end(), data, data + length);
+		if (isKeyframe) {
+			HDF5Typecaster::log_keyframe_entry_t keyframe;
+			keyframe.logStamp = entry.logStamp;
+			keyframe.indexRow = stagingBuffer.index.size(); // relative to the staging buffer until it is written
+			keyframe.offset = entry.offset;
+			keyframe.length = length;
+			stagingBuffer.keyframes.push_back(keyframe);
+		} else {
+			stagingBuffer.index.push_back(entry);
+		}
+		if ((stagingBuffer.index.size() * 2 >= maxStagedUpdates) || (stagingBuffer.messages.size() * 2 >= maxStagedBytes)) {
+			flushCondition.notify_one();
+		}
+	}
+
+	if (!isKeyframe) {
+		checkKeyframeInterval(entry.logStamp);
+	}
+	return true;
+}
+
+bool HDF5AppendOnlyLogger::stageTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp) {
+	HDF5Typecaster::log_transform_entry_t row;
+	std::copy(id.begin(), id.end(), row.id);
+	row.timeStamp = timeStamp.getSeconds();
+	memcpy(row.matrixData, transform->getRawData(), sizeof(double) * HDF5Typecaster::matrixElements);
+
+	HDF5Typecaster::log_index_entry_t entry;
+	entry.logStamp = wm->now().getSeconds();
+	entry.command = static_cast<int>(BinaryTypecaster::SET_TRANSFORM);
+	entry.table = HDF5Typecaster::LOG_TRANSFORMS_TABLE;
+	entry.length = 1;
+
+	{
+		boost::mutex::scoped_lock lock(stagingMutex);
+		if (stopRequested || (flushThread == 0)) {
+			LOG(ERROR) << "HDF5AppendOnlyLogger: Cannot log to HDF. Log file is not open.";
+			return false;
+		}
+		waitForStagingSpace(lock, 0);
+		entry.offset = stagingBuffer.transforms.size();
+		stagingBuffer.transforms.push_back(row);
+		stagingBuffer.index.push_back(entry);
+		if (stagingBuffer.index.size() * 2 >= maxStagedUpdates) {
+			flushCondition.notify_one();
+		}
+	}
+
+	checkKeyframeInterval(entry.logStamp);
+	return true;
+}
+
+void HDF5AppendOnlyLogger::checkKeyframeInterval(double logStamp) {
+	if ((keyframeIntervalInSec > 0) && (logStamp - lastKeyframeStamp >= keyframeIntervalInSec)) {
+		logKeyframe();
+	}
+}
+
+bool HDF5AppendOnlyLogger::logKeyframe() {
+	if (keyframeSerializer == 0) {
+		LOG(ERROR) << "HDF5AppendOnlyLogger: Keyframes are only supported in UPDATE_TABLES mode.";
+		return false;
+	}
+	LOG(DEBUG) << "HDF5AppendOnlyLogger: creating a keyframe.";
+	lastKeyframeStamp = wm->now().getSeconds();
+
+	/* The observers are called after an update has been applied, so the snapshot contains all staged updates. */
+	KeyframeBatch snapshot(wm->getRootNodeId(), wm->now());
+	SceneGraphToUpdatesTraverser graphToUpdates(&snapshot);
+	wm->scene.executeGraphTraverser(&graphToUpdates, wm->getRootNodeId());
+	return keyframeSerializer->applyUpdateBatch(snapshot);
+}
+
+void HDF5AppendOnlyLogger::flushLoop() {
+	boost::mutex::scoped_lock lock(stagingMutex);
+	while (true) {
+		bool isDue = flushRequested || stopRequested ||
+				(stagingBuffer.index.size() * 2 >= maxStagedUpdates) || (stagingBuffer.messages.size() * 2 >= maxStagedBytes);
+		if (!isDue) {
+			flushCondition.timed_wait(lock, boost::posix_time::milliseconds(flushIntervalInMs));
+		}
+
+		if (stagingBuffer.empty()) {
+			flushRequested = false;
+			spaceCondition.notify_all(); // wakes up flush()
+			if (stopRequested) {
+				break;
+			}
+			continue;
+		}
+
+		/* Swap the buffers, so new updates can be staged while the old ones are written. */
+		std::swap(stagingBuffer.messages, writeBuffer.messages);
+		std::swap(stagingBuffer.index, writeBuffer.index);
+		std::swap(stagingBuffer.transforms, writeBuffer.transforms);
+		std::swap(stagingBuffer.keyframes, writeBuffer.keyframes);
+		isWriting = true;
+		spaceCondition.notify_all();
+
+		lock.unlock();
+		writeStagedUpdates(writeBuffer);
+		if (writeBuffer.messages.capacity() > maxStagedBytes) { // shrink after an oversized update
+			std::vector<char>().swap(writeBuffer.messages);
+			writeBuffer.messages.reserve(maxStagedBytes);
+		}
+		writeBuffer.clear();
+		lock.lock();
+
+		isWriting = false;
+		spaceCondition.notify_all();
+	}
+}
+
+bool HDF5AppendOnlyLogger::writeStagedUpdates(StagingBuffer& staged) {
+	LOG(DEBUG) << "HDF5AppendOnlyLogger: writing " << staged.index.size() << " staged updates.";
+
+	/* Convert offsets relative to the staging buffer into offsets of the tables. */
+	for (std::vector<HDF5Typecaster::log_index_entry_t>::iterator it = staged.index.begin(); it != staged.index.end(); ++it) {
+		if (it->table == HDF5Typecaster::LOG_MESSAGES_TABLE) {
+			it->offset += messagesSize;
+		} else {
+			it->offset += transformsSize;
+		}
+	}
+	for (std::vector<HDF5Typecaster::log_keyframe_entry_t>::iterator it = staged.keyframes.begin(); it != staged.keyframes.end(); ++it) {
+		it->offset += messagesSize;
+		it->indexRow += indexSize;
+	}
+
+	/*
+	 * The table sizes are only committed after the whole batch has been written. If a write fails,
+	 * the tables are shrunk back to the committed sizes, as the replayer reads their whole extent.
+	 */
+	hsize_t newMessagesSize = messagesSize;
+	hsize_t newTransformsSize = transformsSize;
+	hsize_t newIndexSize = indexSize;
+	hsize_t newKeyframesSize = keyframesSize;
+	try {
+		if (!staged.messages.empty()) {
+			newMessagesSize = HDF5Typecaster::appendToHDF5DataSet(&staged.messages[0], staged.messages.size(), H5::PredType::NATIVE_UCHAR, messagesSize, messagesDataSet);
+		}
+		if (!staged.transforms.empty()) {
+			newTransformsSize = HDF5Typecaster::appendToHDF5DataSet(&staged.transforms[0], staged.transforms.size(), HDF5Typecaster::createLogTransformType(), transformsSize, transformsDataSet);
+		}
+		if (!staged.index.empty()) {
+			newIndexSize = HDF5Typecaster::appendToHDF5DataSet(&staged.index[0], staged.index.size(), HDF5Typecaster::createLogIndexType(), indexSize, indexDataSet); // after the data, so the index never refers to missing data
+		}
+		if (!staged.keyframes.empty()) {
+			newKeyframesSize = HDF5Typecaster::appendToHDF5DataSet(&staged.keyframes[0], staged.keyframes.size(), HDF5Typecaster::createLogKeyframeType(), keyframesSize, keyframesDataSet);
+		}
+		logFile->flush(H5F_SCOPE_GLOBAL);
+	} catch (H5::Exception e) {
+		LOG(ERROR) << "HDF5AppendOnlyLogger: Cannot write " << staged.index.size() << " staged updates to HDF. Discarding them.";
+		try {
+			indexDataSet.extend(&indexSize); // first, so the index never refers to missing data
+			messagesDataSet.extend(&messagesSize);
+			transformsDataSet.extend(&transformsSize);
+			keyframesDataSet.extend(&keyframesSize);
+			logFile->flush(H5F_SCOPE_GLOBAL);
+		} catch (H5::Exception e) {
+			LOG(ERROR) << "HDF5AppendOnlyLogger: Cannot remove the discarded updates from the tables. The log file is inconsistent.";
+		}
+		return false;
+	}
+
+	messagesSize = newMessagesSize;
+	transformsSize = newTransformsSize;
+	indexSize = newIndexSize;
+	keyframesSize = newKeyframesSize;
+	return true;
+}
+
+void HDF5AppendOnlyLogger::flush() {
+	if (flushThread == 0) {
+		return;
+	}
+	boost::mutex::scoped_lock lock(stagingMutex);
+	while (!stagingBuffer.empty() || isWriting) {
+		flushRequested = true;
+		flushCondition.notify_one();
+		spaceCondition.wait(lock);
+	}
+}
+
+void HDF5AppendOnlyLogger::setFlushInterval(unsigned int flushIntervalInMs) {
+	boost::mutex::scoped_lock lock(stagingMutex);
+	this->flushIntervalInMs = flushIntervalInMs;
+}
+
+void HDF5AppendOnlyLogger::setStagingBufferSize(size_t maxStagedBytes, size_t maxStagedUpdates) {
+	boost::mutex::scoped_lock lock(stagingMutex);
+	this->maxStagedBytes = maxStagedBytes;
+	this->maxStagedUpdates = (maxStagedUpdates > 0) ? maxStagedUpdates : 1;
+}
+
+bool HDF5AppendOnlyLogger::applyUpdateBatch(const SceneGraphUpdateBatch& batch) {
+	if (mode == UPDATE_TABLES) {
+		return binarySerializer->applyUpdateBatch(batch);
+	}
+	return ISceneGraphUpdateObserver::applyUpdateBatch(batch);
+}
+
 bool HDF5AppendOnlyLogger::addNode(Id parentId, Id& assignedId,
 		vector<Attribute> attributes, bool forcedId) {
 	LOG(DEBUG) << "HDF5AppendOnlyLogger: adding a Node-" << assignedId.toString();
+	if (mode == UPDATE_TABLES) {
+		return binarySerializer->addNode(parentId, assignedId, attributes, forcedId);
+	}
 	try {
 
 		/* Generic/common entry group with general information */
@@ -129,6 +470,9 @@ bool HDF5AppendOnlyLogger::addNode(Id parentId, Id& assignedId,
 bool HDF5AppendOnlyLogger::addGroup(Id parentId, Id& assignedId,
 		vector<Attribute> attributes, bool forcedId) {
 	LOG(DEBUG) << "HDF5AppendOnlyLogger: adding a Group-" << assignedId.toString();
+	if (mode == UPDATE_TABLES) {
+		return binarySerializer->addGroup(parentId, assignedId, attributes, forcedId);
+	}
 	try {
 
 		/* Generic/common entry group with general information */
@@ -159,6 +503,9 @@ bool HDF5AppendOnlyLogger::addTransformNode(Id parentId,
 		TimeStamp timeStamp, bool forcedId) {
 
 	LOG(DEBUG) << "HDF5AppendOnlyLogger: adding a Transform-" << assignedId.toString();
+	if (mode == UPDATE_TABLES) {
+		return binarySerializer->addTransformNode(parentId, assignedId, attributes, transform, timeStamp, forcedId);
+	}
 	try {
 
 		/* Generic/common entry group with general information */
@@ -190,6 +537,9 @@ bool HDF5AppendOnlyLogger::addUncertainTransformNode(Id parentId,
 		TimeStamp timeStamp, bool forcedId) {
 
 	LOG(DEBUG) << "HDF5AppendOnlyLogger: adding a UncertainTransform-" << assignedId.toString();
+	if (mode == UPDATE_TABLES) {
+		return binarySerializer->addUncertainTransformNode(parentId, assignedId, attributes, transform, uncertainty, timeStamp, forcedId);
+	}
 	try {
 
 		/* Generic/common entry group with general information */
@@ -221,6 +571,9 @@ bool HDF5AppendOnlyLogger::addGeometricNode(Id parentId,
 		TimeStamp timeStamp, bool forcedId) {
 
 	LOG(DEBUG) << "HDF5AppendOnlyLogger: adding a GeometricNode-" << assignedId.toString();
+	if (mode == UPDATE_TABLES) {
+		return binarySerializer->addGeometricNode(parentId, assignedId, attributes, shape, timeStamp, forcedId);
+	}
 	try {
 
 		/* Generic/common entry group with general information */
@@ -234,7 +587,7 @@ bool HDF5AppendOnlyLogger::addGeometricNode(Id parentId,
 		HDF5Typecaster::addNodeTypeInfoToHDF5Group(HDF5Typecaster::GEOMETIRC_NODE, group);
 		HDF5Typecaster::addNodeIdToHDF5Group(assignedId, group);
 		HDF5Typecaster::addAttributesToHDF5Group(attributes, group);
-		HDF5Typecaster::addShapeToHDF5Group(shape, group);
+		HDF5Typecaster::addShapeToHDF5Group(shape, group, pointCloudStorageOptions);
 		HDF5Typecaster::addTimeStampToHDF5Group(timeStamp, group);
 
 		logFile->flush(H5F_SCOPE_GLOBAL);
@@ -248,6 +601,9 @@ bool HDF5AppendOnlyLogger::addGeometricNode(Id parentId,
 
 bool HDF5AppendOnlyLogger::addRemoteRootNode(Id rootId, vector<Attribute> attributes) {
 	LOG(DEBUG) << "HDF5AppendOnlyLogger: adding a RemoteNode-" << rootId.toString();
+	if (mode == UPDATE_TABLES) {
+		return binarySerializer->addRemoteRootNode(rootId, attributes);
+	}
 	try {
 
 		/* Generic/common entry group with general information */
@@ -272,6 +628,9 @@ bool HDF5AppendOnlyLogger::addRemoteRootNode(Id rootId, vector<Attribute> attrib
 
 bool HDF5AppendOnlyLogger::addConnection(Id parentId, Id& assignedId, vector<Attribute> attributes, vector<Id> sourceIds, vector<Id> targetIds, TimeStamp start, TimeStamp end, bool forcedId) {
 	LOG(DEBUG) << "HDF5AppendOnlyLogger: adding a Connection-" << assignedId.toString();
+	if (mode == UPDATE_TABLES) {
+		return binarySerializer->addConnection(parentId, assignedId, attributes, sourceIds, targetIds, start, end, forcedId);
+	}
 	try {
 
 		/* Generic/common entry group with general information */
@@ -308,6 +667,9 @@ bool HDF5AppendOnlyLogger::setNodeAttributes(Id id,
 		vector<Attribute> newAttributes,  TimeStamp timeStamp) {
 
 	LOG(DEBUG) << "HDF5AppendOnlyLogger: updating Attributes for node " << id.toString();
+	if (mode == UPDATE_TABLES) {
+		return binarySerializer->setNodeAttributes(id, newAttributes, timeStamp);
+	}
 	try {
 
 		/* Generic/common entry group with general information */
@@ -335,6 +697,9 @@ bool HDF5AppendOnlyLogger::setTransform(Id id,
 		TimeStamp timeStamp) {
 
 	LOG(DEBUG) << "HDF5AppendOnlyLogger: updating a Transform-" << id.toString();
+	if (mode == UPDATE_TABLES) {
+		return stageTransform(id, transform, timeStamp);
+	}
 	try {
 
 		/* Generic/common entry group with general information */
@@ -364,6 +729,9 @@ bool HDF5AppendOnlyLogger::setUncertainTransform(Id id,
 		TimeStamp timeStamp) {
 
 	LOG(DEBUG) << "HDF5AppendOnlyLogger: updating an UncertainTransform-" << id.toString();
+	if (mode == UPDATE_TABLES) {
+		return binarySerializer->setUncertainTransform(id, transform, uncertainty, timeStamp);
+	}
 	try {
 
 		/* Generic/common entry group with general information */
@@ -389,6 +757,9 @@ bool HDF5AppendOnlyLogger::setUncertainTransform(Id id,
 
 bool HDF5AppendOnlyLogger::deleteNode(Id id) {
 	LOG(DEBUG) << "HDF5AppendOnlyLogger: deleting Node-" << id.toString();
+	if (mode == UPDATE_TABLES) {
+		return binarySerializer->deleteNode(id);
+	}
 	try {
 
 		/* Generic/common entry group with general information */
@@ -412,6 +783,9 @@ bool HDF5AppendOnlyLogger::deleteNode(Id id) {
 
 bool HDF5AppendOnlyLogger::addParent(Id id, Id parentId) {
 	LOG(DEBUG) << "HDF5AppendOnlyLogger: adding Parent " << parentId.toString() << " to Node " << id.toString();
+	if (mode == UPDATE_TABLES) {
+		return binarySerializer->addParent(id, parentId);
+	}
 	try {
 
 		/* Generic/common entry group with general information */
@@ -436,6 +810,9 @@ bool HDF5AppendOnlyLogger::addParent(Id id, Id parentId) {
 
 bool HDF5AppendOnlyLogger::removeParent(Id id, Id parentId) {
 	LOG(DEBUG) << "HDF5AppendOnlyLogger: removing Parent " << parentId.toString() << " to Node " << id.toString();
+	if (mode == UPDATE_TABLES) {
+		return binarySerializer->removeParent(id, parentId);
+	}
 	try {
 
 		/* Generic/common entry group with general information */
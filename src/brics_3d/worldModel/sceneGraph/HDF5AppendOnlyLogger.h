@@ -24,15 +24,50 @@
 #include "brics_3d/worldModel/WorldModel.h"
 #include "brics_3d/worldModel/sceneGraph/ISceneGraphUpdateObserver.h"
 #include "brics_3d/worldModel/sceneGraph/IPort.h"
+#include "brics_3d/worldModel/sceneGraph/BinaryUpdateSerializer.h"
+#include "brics_3d/worldModel/sceneGraph/SceneGraphToUpdatesTraverser.h"
 #include "brics_3d/util/HDF5Typecaster.h"
 
+#include <boost/thread.hpp>
+
 namespace brics_3d {
 namespace rsg {
 
+/**
+ * @brief Logs all updates of a world model into a HDF5 file.
+ * @ingroup sceneGraph
+ *
+ * Two log formats are supported:
+ *  - GROUP_PER_UPDATE: Every update is stored as its own HDF5 group (named after the
+ *    log time) and the file is flushed after every update. This is the format of the
+ *    HDF5UpdateSerializer and it is easy to inspect, but it does not scale to high update rates.
+ *  - UPDATE_TABLES: Updates are appended to extensible, chunked tables underneath an "updates" group:
+ *    "transforms" holds the setTransform updates as rows of id, time stamp and matrix,
+ *    "messages" holds all other updates as byte stream of BinaryTypecaster messages and
+ *    "index" holds one row per update with its log time, command and location in one of the
+ *    other tables. The callbacks only copy the update into a fixed-size in-memory staging buffer.
+ *    A background thread writes the staged updates once the buffer is half full or the flush
+ *    interval has elapsed. If the buffer runs full while the background thread is still
+ *    writing, the callbacks block until space is available (back pressure), so memory does not grow.
+ *    Additionally, periodic keyframes (full graph snapshots created with the SceneGraphToUpdatesTraverser)
+ *    are stored as UPDATE_BATCH messages and referenced by the "keyframes" table. The index and
+ *    the keyframes allow the HDF5LogReplayer to seek in the log.
+ *
+ * Both formats can be replayed with HDF5UpdateDeserializer::loadFromAppendOnlyLogFile().
+ *
+ * @note In UPDATE_TABLES mode the HDF5 library is accessed from the background thread. Use a
+ * thread-safe HDF5 build if other components of the same process access HDF5 concurrently.
+ */
 class HDF5AppendOnlyLogger : public ISceneGraphUpdateObserver {
 public:
+
+	enum LogMode {
+		GROUP_PER_UPDATE,
+		UPDATE_TABLES
+	};
+
 	HDF5AppendOnlyLogger(WorldModel* wm);
-	HDF5AppendOnlyLogger(WorldModel* wm, string logFileName);
+	HDF5AppendOnlyLogger(WorldModel* wm, string logFileName, LogMode mode = GROUP_PER_UPDATE);
 	virtual ~HDF5AppendOnlyLogger();
 
 	bool addNode(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId = false);
@@ -48,15 +83,144 @@ public:
 	bool deleteNode(Id id);
 	bool addParent(Id id, Id parentId);
 	bool removeParent(Id id, Id parentId);
+	bool applyUpdateBatch(const SceneGraphUpdateBatch& batch);
+
+	LogMode getLogMode() const {
+		return mode;
+	}
+
+	/**
+	 * @brief Write all staged updates to the file and wait until that is done.
+	 * Only has an effect in UPDATE_TABLES mode.
+	 */
+	void flush();
+
+	/// Maximum time in milliseconds an update stays in the staging buffer. Default is 1000.
+	void setFlushInterval(unsigned int flushIntervalInMs);
+
+	/**
+	 * @brief Size of the staging buffer for UPDATE_TABLES mode.
+	 * @param maxStagedBytes Memory for the encoded non-transform updates. Default is 1 MB. A single larger update is accepted once the buffer is empty.
+	 * @param maxStagedUpdates Maximum number of staged updates. Default is 4096.
+	 */
+	void setStagingBufferSize(size_t maxStagedBytes, size_t maxStagedUpdates);
+
+	/**
+	 * @brief Log time in seconds between two keyframes in UPDATE_TABLES mode. 0 disables periodic keyframes. Default is 60.
+	 *
+	 * A periodic keyframe is created within the update callback that exceeds the interval:
+	 * that update is only returned after the complete scene graph has been traversed and
+	 * encoded. For large graphs with tight latency requirements, disable the periodic keyframes
+	 * and call logKeyframe() from the application whenever a delay is acceptable.
+	 */
+	void setKeyframeInterval(double keyframeIntervalInSec) {
+		this->keyframeIntervalInSec = keyframeIntervalInSec;
+	}
+
+	/**
+	 * @brief Store a snapshot of the complete scene graph as keyframe.
+	 * Only possible in UPDATE_TABLES mode. The graph is traversed and encoded by the calling
+	 * thread, so this takes time proportional to the size of the graph.
+	 */
+	bool logKeyframe();
+
+	const HDF5Typecaster::PointCloudStorageOptions& getPointCloudStorageOptions() const {
+		return pointCloudStorageOptions;
+	}
+
+	/// Chunking, compression and precision of logged point clouds. Default is deflate level 6 with shuffle.
+	void setPointCloudStorageOptions(const HDF5Typecaster::PointCloudStorageOptions& pointCloudStorageOptions) {
+		this->pointCloudStorageOptions = pointCloudStorageOptions;
+	}
 
 protected:
 
+	/// Updates that are not yet written to the file.
+	struct StagingBuffer {
+		std::vector<char> messages;
+		std::vector<HDF5Typecaster::log_index_entry_t> index;
+		std::vector<HDF5Typecaster::log_transform_entry_t> transforms;
+		std::vector<HDF5Typecaster::log_keyframe_entry_t> keyframes;
+
+		bool empty() const {
+			return index.empty() && keyframes.empty();
+		}
+
+		void clear() {
+			messages.clear();
+			index.clear();
+			transforms.clear();
+			keyframes.clear();
+		}
+	};
+
+	/// Receives the encoded messages of the binarySerializer or the keyframeSerializer.
+	class StagingPort : public IOutputPort {
+	public:
+		StagingPort(HDF5AppendOnlyLogger* logger, bool isKeyframePort = false) : logger(logger), isKeyframePort(isKeyframePort) {};
+		virtual ~StagingPort(){};
+		int write(const char *dataBuffer, int dataLength, int &transferredBytes);
+	private:
+		HDF5AppendOnlyLogger* logger;
+		bool isKeyframePort;
+	};
+
 	void initialize(string logFileName);
+	bool initializeUpdateTables();
+
+	/// Copy an encoded message into the staging buffer.
+	bool stageMessage(const char* data, unsigned int length, bool isKeyframe = false);
+
+	/// Create a keyframe if the keyframe interval has elapsed.
+	void checkKeyframeInterval(double logStamp);
+
+	/// Copy a transform into the staging buffer.
+	bool stageTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp);
+
+	/// Block until the staging buffer has space for an update with the given size. Requires a lock on stagingMutex.
+	void waitForStagingSpace(boost::mutex::scoped_lock& lock, size_t messageLength);
+
+	/// Main loop of the background thread.
+	void flushLoop();
+
+	/// Append the updates to the tables. Only called by the background thread.
+	bool writeStagedUpdates(StagingBuffer& staged);
 
 	WorldModel* wm;
 	H5::H5File* logFile;
 	size_t fileImageIncremet;
 	std::string fileSuffix;
+	HDF5Typecaster::PointCloudStorageOptions pointCloudStorageOptions;
+	LogMode mode;
+
+	/* UPDATE_TABLES mode */
+	BinaryUpdateSerializer* binarySerializer;
+	StagingPort* stagingPort;
+	BinaryUpdateSerializer* keyframeSerializer;
+	StagingPort* keyframePort;
+	double keyframeIntervalInSec;
+	double lastKeyframeStamp;
+	StagingBuffer stagingBuffer;
+	StagingBuffer writeBuffer;
+	size_t maxStagedBytes;
+	size_t maxStagedUpdates;
+	unsigned int flushIntervalInMs;
+	bool isWriting;
+	bool flushRequested;
+	bool stopRequested;
+	boost::mutex stagingMutex;
+	boost::condition_variable flushCondition;
+	boost::condition_variable spaceCondition;
+	boost::thread* flushThread;
+
+	H5::DataSet indexDataSet;
+	H5::DataSet messagesDataSet;
+	H5::DataSet transformsDataSet;
+	H5::DataSet keyframesDataSet;
+	hsize_t indexSize;
+	hsize_t messagesSize;
+	hsize_t transformsSize;
+	hsize_t keyframesSize;
 
 };
 
@@ -0,0 +1,386 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#include "HDF5LogReplayer.h"
+#include "brics_3d/worldModel/sceneGraph/SceneGraphAllocator.h"
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <cstdlib>
+
+namespace brics_3d {
+namespace rsg {
+
+/* Number of index entries that are read at once. */
+static const size_t indexBlockSize = 4096;
+
+/*
+ * Receives the decoded updates of a keyframe. The local root node exists
+ * already, so an addRemoteRootNode for it only updates its attributes.
+ * All other updates have to succeed.
+ */
+class KeyframeReplayBatch : public SceneGraphUpdateBatch {
+public:
+	KeyframeReplayBatch(Id rootId) : rootId(rootId) {};
+	virtual ~KeyframeReplayBatch(){};
+
+	bool addRemoteRootNode(Id id, vector<Attribute> attributes) {
+		if (id == rootId) {
+			return setNodeAttributes(id, attributes);
+		}
+		return SceneGraphUpdateBatch::addRemoteRootNode(id, attributes);
+	}
+
+	/* The keyframe arrives as UPDATE_BATCH message. Record its updates one by one, so the root node is handled as above. */
+	bool applyUpdateBatch(const SceneGraphUpdateBatch& batch) {
+		return batch.replay(this);
+	}
+
+private:
+	Id rootId;
+};
+
+HDF5LogReplayer::HDF5LogReplayer(WorldModel* wm) : wm(wm) {
+	file = 0;
+	isUpdateTableLog = false;
+	groupDeserializer = new HDF5UpdateDeserializer(wm);
+	binaryDeserializer = new BinaryUpdateDeserializer(wm);
+	position = 0;
+	replayStartStamp = 0;
+}
+
+HDF5LogReplayer::~HDF5LogReplayer() {
+	close();
+	delete binaryDeserializer;
+	delete groupDeserializer;
+}
+
+bool HDF5LogReplayer::open(std::string logFile) {
+	close();
+	try {
+		file = new H5::H5File();
+		file->openFile(logFile, H5F_ACC_RDONLY);
+		isUpdateTableLog = (H5Lexists(file->getId(), "updates", H5P_DEFAULT) > 0);
+		bool success = isUpdateTableLog ? loadUpdateTableIndex() : buildGroupIndex();
+		if (!success) {
+			close();
+			return false;
+		}
+	} catch (H5::Exception e) {
+		LOG(ERROR) << "HDF5LogReplayer: Cannot open HDF5 log file " << logFile;
+		close();
+		return false;
+	}
+
+	LOG(INFO) << "HDF5LogReplayer: Opened log file " << logFile << " with " << logStamps.size() << " updates and " << keyframes.size() << " keyframes.";
+	return true;
+}
+
+void HDF5LogReplayer::close() {
+	if (file) {
+		file->close();
+		delete file;
+		file = 0;
+	}
+	logStamps.clear();
+	groupNames.clear();
+	keyframes.clear();
+	position = 0;
+}
+
+bool HDF5LogReplayer::isOpen() const {
+	return file != 0;
+}
+
+bool HDF5LogReplayer::loadUpdateTableIndex() {
+	H5::Group updates = file->openGroup("updates");
+	H5::DataSet indexDataSet = updates.openDataSet("index");
+	hsize_t numberOfUpdates = 0;
+	indexDataSet.getSpace().getSimpleExtentDims(&numberOfUpdates);
+
+	/* Only the time stamps are kept in memory. The entries are read on demand. */
+	H5::CompType logStampType(sizeof(double));
+	logStampType.insertMember("logStamp", 0, H5::PredType::NATIVE_DOUBLE);
+	logStamps.resize(static_cast<size_t>(numberOfUpdates));
+	if (numberOfUpdates > 0) {
+		indexDataSet.read(&logStamps[0], logStampType);
+	}
+
+	if (H5Lexists(updates.getId(), "keyframes", H5P_DEFAULT) > 0) {
+		H5::DataSet keyframesDataSet = updates.openDataSet("keyframes");
+		hsize_t numberOfKeyframes = 0;
+		keyframesDataSet.getSpace().getSimpleExtentDims(&numberOfKeyframes);
+		keyframes.resize(static_cast<size_t>(numberOfKeyframes));
+		if (numberOfKeyframes > 0) {
+			keyframesDataSet.read(&keyframes[0], HDF5Typecaster::createLogKeyframeType());
+		}
+	}
+	return true;
+}
+
+/* Collects the top level groups of a GROUP_PER_UPDATE log. Their names are the log times. */
+static herr_t collectLoggedUpdates(hid_t locationId, const char* name, const H5L_info_t* info, void* operatorData) {
+	std::vector<std::pair<double, std::string> >* updates = static_cast<std::vector<std::pair<double, std::string> >*>(operatorData);
+	char* end = 0;
+	double logStamp = strtod(name, &end);
+	if (end != name && *end == '\0') { // skips e.g. the "log-metadata"
+		updates->push_back(std::make_pair(logStamp, std::string(name)));
+	}
+	return 0;
+}
+
+static bool compareLogStamps(const std::pair<double, std::string>& a, const std::pair<double, std::string>& b) {
+	return a.first < b.first;
+}
+
+bool HDF5LogReplayer::buildGroupIndex() {
+	std::vector<std::pair<double, std::string> > updates;
+	H5Literate(file->getId(), H5_INDEX_NAME, H5_ITER_INC, 0, collectLoggedUpdates, &updates);
+	std::stable_sort(updates.begin(), updates.end(), compareLogStamps);
+
+	logStamps.reserve(updates.size());
+	groupNames.reserve(updates.size());
+	for (std::vector<std::pair<double, std::string> >::iterator it = updates.begin(); it != updates.end(); ++it) {
+		logStamps.push_back(it->first);
+		groupNames.push_back(it->second);
+	}
+	return true;
+}
+
+size_t HDF5LogReplayer::getNumberOfUpdates() const {
+	return logStamps.size();
+}
+
+size_t HDF5LogReplayer::getNumberOfKeyframes() const {
+	return keyframes.size();
+}
+
+TimeStamp HDF5LogReplayer::getStartStamp() const {
+	return logStamps.empty() ? TimeStamp() : TimeStamp(logStamps.front(), Units::Second);
+}
+
+TimeStamp HDF5LogReplayer::getEndStamp() const {
+	return logStamps.empty() ? TimeStamp() : TimeStamp(logStamps.back(), Units::Second);
+}
+
+TimeStamp HDF5LogReplayer::getKeyframeStamp(size_t keyframe) const {
+	assert(keyframe < keyframes.size());
+	return TimeStamp(keyframes[keyframe].logStamp, Units::Second);
+}
+
+size_t HDF5LogReplayer::getPosition() const {
+	return position;
+}
+
+TimeStamp HDF5LogReplayer::getCurrentStamp() const {
+	return (position == 0) ? TimeStamp() : TimeStamp(logStamps[position - 1], Units::Second);
+}
+
+size_t HDF5LogReplayer::findEndOfUpdates(double logStamp) const {
+	return std::upper_bound(logStamps.begin(), logStamps.end(), logStamp) - logStamps.begin();
+}
+
+bool HDF5LogReplayer::seek(TimeStamp logStamp) {
+	if (!isOpen()) {
+		LOG(ERROR) << "HDF5LogReplayer: No log file opened.";
+		return false;
+	}
+	size_t end = findEndOfUpdates(logStamp.getSeconds());
+	if (end < position) {
+		LOG(ERROR) << "HDF5LogReplayer: Cannot seek backwards to " << std::fixed << logStamp.getSeconds() << ". Please use a new world model.";
+		return false;
+	}
+
+	if (position == 0) { // skip as much as possible with the latest keyframe that does not contain later updates
+		size_t keyframe = keyframes.size();
+		for (size_t i = 0; i < keyframes.size(); ++i) {
+			if (keyframes[i].indexRow <= end) {
+				keyframe = i;
+			}
+		}
+		if (keyframe < keyframes.size() && !applyKeyframe(keyframe)) {
+			return false;
+		}
+	}
+	return applyUpdates(end, 0.0);
+}
+
+bool HDF5LogReplayer::jumpToKeyframe(size_t keyframe) {
+	if (!isOpen() || keyframe >= keyframes.size()) {
+		LOG(ERROR) << "HDF5LogReplayer: Keyframe " << keyframe << " does not exist.";
+		return false;
+	}
+	size_t end = static_cast<size_t>(keyframes[keyframe].indexRow);
+	if (position == 0) {
+		return applyKeyframe(keyframe);
+	}
+	if (end < position) {
+		LOG(ERROR) << "HDF5LogReplayer: Cannot jump backwards to keyframe " << keyframe << ". Please use a new world model.";
+		return false;
+	}
+	return applyUpdates(end, 0.0);
+}
+
+bool HDF5LogReplayer::replay(TimeStamp logStamp, double speedFactor) {
+	if (!isOpen()) {
+		LOG(ERROR) << "HDF5LogReplayer: No log file opened.";
+		return false;
+	}
+	size_t end = findEndOfUpdates(logStamp.getSeconds());
+	if (end < position) {
+		LOG(WARNING) << "HDF5LogReplayer: Replay ends before the current position. Nothing to do.";
+		return true;
+	}
+	return applyUpdates(end, speedFactor);
+}
+
+bool HDF5LogReplayer::replayWindow(TimeStamp start, TimeStamp end, double speedFactor) {
+	return seek(start) && replay(end, speedFactor);
+}
+
+bool HDF5LogReplayer::applyUpdates(size_t end, double speedFactor) {
+	if (position >= end) {
+		return true;
+	}
+	replayStartTime = boost::posix_time::microsec_clock::universal_time();
+	replayStartStamp = logStamps[position];
+
+	try {
+		return isUpdateTableLog ? applyUpdateTableEntries(end, speedFactor) : applyGroups(end, speedFactor);
+	} catch (H5::Exception e) {
+		LOG(ERROR) << "HDF5LogReplayer: Cannot read update " << position << " from log file.";
+		return false;
+	}
+}
+
+void HDF5LogReplayer::waitForUpdate(double logStamp, double speedFactor) {
+	if (speedFactor <= 0) {
+		return;
+	}
+	boost::posix_time::ptime dueTime = replayStartTime + boost::posix_time::microseconds(static_cast<long>((logStamp - replayStartStamp) / speedFactor * 1.0e6));
+	boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+	if (dueTime > now) {
+		boost::this_thread::sleep(dueTime - now);
+	}
+}
+
+bool HDF5LogReplayer::applyUpdateTableEntries(size_t end, double speedFactor) {
+	H5::Group updates = file->openGroup("updates");
+	H5::DataSet indexDataSet = updates.openDataSet("index");
+	H5::DataSet messagesDataSet = updates.openDataSet("messages");
+	H5::DataSet transformsDataSet = updates.openDataSet("transforms");
+	H5::CompType indexType = HDF5Typecaster::createLogIndexType();
+	H5::CompType transformType = HDF5Typecaster::createLogTransformType();
+
+	std::vector<HDF5Typecaster::log_index_entry_t> index;
+	std::vector<char> messages;
+	std::vector<HDF5Typecaster::log_transform_entry_t> transforms;
+
+	while (position < end) {
+		hsize_t count = std::min(indexBlockSize, end - position);
+		index.resize(static_cast<size_t>(count));
+		HDF5Typecaster::readFromHDF5DataSet(&index[0], count, indexType, position, indexDataSet);
+
+		/* Entries are appended in order, so the data of a block is a contiguous range in each table. */
+		hsize_t messagesBegin = 0, messagesEnd = 0, transformsBegin = 0, transformsEnd = 0;
+		bool hasMessages = false, hasTransforms = false;
+		for (std::vector<HDF5Typecaster::log_index_entry_t>::iterator it = index.begin(); it != index.end(); ++it) {
+			if (it->table == HDF5Typecaster::LOG_MESSAGES_TABLE) {
+				messagesBegin = hasMessages ? messagesBegin : it->offset;
+				messagesEnd = it->offset + it->length;
+				hasMessages = true;
+			} else {
+				transformsBegin = hasTransforms ? transformsBegin : it->offset;
+				transformsEnd = it->offset + 1;
+				hasTransforms = true;
+			}
+		}
+		messages.resize(static_cast<size_t>(messagesEnd - messagesBegin));
+		HDF5Typecaster::readFromHDF5DataSet(messages.empty() ? 0 : &messages[0], messagesEnd - messagesBegin, H5::PredType::NATIVE_UCHAR, messagesBegin, messagesDataSet);
+		transforms.resize(static_cast<size_t>(transformsEnd - transformsBegin));
+		HDF5Typecaster::readFromHDF5DataSet(transforms.empty() ? 0 : &transforms[0], transformsEnd - transformsBegin, transformType, transformsBegin, transformsDataSet);
+
+		for (std::vector<HDF5Typecaster::log_index_entry_t>::iterator it = index.begin(); it != index.end(); ++it) {
+			waitForUpdate(it->logStamp, speedFactor);
+			if (it->table == HDF5Typecaster::LOG_MESSAGES_TABLE) {
+				int transferredBytes = 0;
+				if (binaryDeserializer->write(&messages[static_cast<size_t>(it->offset - messagesBegin)], it->length, transferredBytes) < 0) {
+					LOG(WARNING) << "HDF5LogReplayer: Cannot apply logged update " << position << " with command " << it->command;
+				}
+			} else {
+				const HDF5Typecaster::log_transform_entry_t& row = transforms[static_cast<size_t>(it->offset - transformsBegin)];
+				Id id;
+				std::copy(row.id, row.id + 16, id.begin());
+				IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform = SceneGraphAllocator::createTransformMatrix();
+				memcpy(transform->setRawData(), row.matrixData, sizeof(double) * HDF5Typecaster::matrixElements);
+				wm->scene.setTransform(id, transform, TimeStamp(row.timeStamp, Units::Second));
+			}
+			position++;
+		}
+	}
+	return true;
+}
+
+bool HDF5LogReplayer::applyGroups(size_t end, double speedFactor) {
+	while (position < end) {
+		waitForUpdate(logStamps[position], speedFactor);
+		H5::Group scene = file->openGroup(groupNames[position]);
+		if (!groupDeserializer->handleSceneGroup(scene)) {
+			LOG(WARNING) << "HDF5LogReplayer: Cannot apply logged update " << groupNames[position];
+		}
+		position++;
+	}
+	return true;
+}
+
+bool HDF5LogReplayer::applyKeyframe(size_t keyframe) {
+	const HDF5Typecaster::log_keyframe_entry_t& entry = keyframes[keyframe];
+	LOG(DEBUG) << "HDF5LogReplayer: applying keyframe " << keyframe << " that contains " << entry.indexRow << " updates.";
+
+	std::vector<char> message(entry.length);
+	try {
+		H5::DataSet messagesDataSet = file->openGroup("updates").openDataSet("messages");
+		if (entry.length > 0) {
+			HDF5Typecaster::readFromHDF5DataSet(&message[0], entry.length, H5::PredType::NATIVE_UCHAR, entry.offset, messagesDataSet);
+		}
+	} catch (H5::Exception e) {
+		LOG(ERROR) << "HDF5LogReplayer: Cannot read keyframe " << keyframe << " from log file.";
+		return false;
+	}
+
+	/* Decode the complete keyframe first and apply it as one batch. */
+	KeyframeReplayBatch snapshot(wm->getRootNodeId());
+	BinaryUpdateDeserializer keyframeDeserializer(wm, &snapshot);
+	int transferredBytes = 0;
+	if (keyframeDeserializer.write(message.size() > 0 ? &message[0] : 0, static_cast<int>(message.size()), transferredBytes) < 0) { // an empty keyframe is malformed
+		LOG(ERROR) << "HDF5LogReplayer: Keyframe " << keyframe << " is malformed.";
+		return false;
+	}
+	if (!wm->scene.applyUpdateBatch(snapshot)) {
+		LOG(ERROR) << "HDF5LogReplayer: Keyframe " << keyframe << " could not be applied. Please use a world model with the root id of the log and without other nodes.";
+		return false;
+	}
+	position = static_cast<size_t>(entry.indexRow);
+	return true;
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
@@ -0,0 +1,157 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#ifndef RSG_HDF5LOGREPLAYER_H_
+#define RSG_HDF5LOGREPLAYER_H_
+
+#include "brics_3d/core/Logger.h"
+#include "brics_3d/worldModel/WorldModel.h"
+#include "brics_3d/worldModel/sceneGraph/HDF5UpdateDeserializer.h"
+#include "brics_3d/worldModel/sceneGraph/BinaryUpdateDeserializer.h"
+#include "brics_3d/util/HDF5Typecaster.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Seekable replay of log files written by the HDF5AppendOnlyLogger.
+ * @ingroup sceneGraph
+ *
+ * On open() only the time index of the log is loaded. For logs in the UPDATE_TABLES
+ * format the index is stored in the file, for logs in the GROUP_PER_UPDATE format it is
+ * built from the group names. Afterwards arbitrary time windows can be replayed without
+ * decoding the preceding updates: If nothing has been replayed yet, seek() starts from the
+ * latest keyframe (full graph snapshot) before the requested time and only applies the
+ * updates after that keyframe.
+ *
+ * Updates are applied in forward direction only. To go back in time, create a new
+ * world model and a new replayer.
+ *
+ * Example:
+ * @code
+ * Id rootId = HDF5UpdateDeserializer::getRootIdFromAppendOnlyLogFile(logFile);
+ * WorldModel* wm = new WorldModel(new UuidGenerator(rootId));
+ * HDF5LogReplayer replayer(wm);
+ * replayer.open(logFile);
+ * replayer.seek(replayer.getStartStamp() + TimeStamp(3600, Units::Second)); // state after one hour
+ * replayer.replay(replayer.getCurrentStamp() + TimeStamp(10, Units::Second), 0.5); // the next ten seconds in slow motion
+ * @endcode
+ */
+class HDF5LogReplayer {
+public:
+	HDF5LogReplayer(WorldModel* wm);
+	virtual ~HDF5LogReplayer();
+
+	/// Open a log file and load its time index.
+	bool open(std::string logFile);
+	void close();
+	bool isOpen() const;
+
+	/// Number of updates in the log, excluding keyframes.
+	size_t getNumberOfUpdates() const;
+
+	/// Number of keyframes. Logs in the GROUP_PER_UPDATE format have none.
+	size_t getNumberOfKeyframes() const;
+
+	/// Log time of the first update.
+	TimeStamp getStartStamp() const;
+
+	/// Log time of the last update.
+	TimeStamp getEndStamp() const;
+
+	/// Log time when the keyframe was taken.
+	TimeStamp getKeyframeStamp(size_t keyframe) const;
+
+	/// Number of updates that have been applied or skipped by a keyframe.
+	size_t getPosition() const;
+
+	/// Log time of the update before the current position.
+	TimeStamp getCurrentStamp() const;
+
+	/**
+	 * @brief Bring the world model to the state of the log at the given log time.
+	 * If no update has been applied yet, the replay starts at the latest suitable keyframe.
+	 * @return False if the requested time is before the current position or if an update could not be read.
+	 */
+	bool seek(TimeStamp logStamp);
+
+	/**
+	 * @brief Jump to a keyframe.
+	 * If no update has been applied yet, only the keyframe is applied.
+	 * Otherwise the updates up to the keyframe are replayed.
+	 */
+	bool jumpToKeyframe(size_t keyframe);
+
+	/**
+	 * @brief Apply all updates from the current position until (including) the given log time.
+	 * @param logStamp Log time of the last update to be applied.
+	 * @param speedFactor Multiple of real time, e.g. 2.0 for double speed or 0.5 for slow motion.
+	 *        0 applies the updates as fast as possible.
+	 */
+	bool replay(TimeStamp logStamp, double speedFactor = 0.0);
+
+	/// Replay all updates between start and end. Short for seek(start) and replay(end, speedFactor).
+	bool replayWindow(TimeStamp start, TimeStamp end, double speedFactor = 0.0);
+
+protected:
+
+	bool loadUpdateTableIndex();
+	bool buildGroupIndex();
+
+	/// Index of the first update with a log time later than logStamp.
+	size_t findEndOfUpdates(double logStamp) const;
+
+	/// Apply the updates in the range [position, end) and advance the position.
+	bool applyUpdates(size_t end, double speedFactor);
+	bool applyUpdateTableEntries(size_t end, double speedFactor);
+	bool applyGroups(size_t end, double speedFactor);
+	bool applyKeyframe(size_t keyframe);
+
+	/// Sleep until the update with the given log time is due.
+	void waitForUpdate(double logStamp, double speedFactor);
+
+	WorldModel* wm;
+	H5::H5File* file;
+	bool isUpdateTableLog;
+	HDF5UpdateDeserializer* groupDeserializer;
+	BinaryUpdateDeserializer* binaryDeserializer;
+
+	/// Log time per update. This is the index for the seek operations.
+	std::vector<double> logStamps;
+
+	/// Names of the top level groups for GROUP_PER_UPDATE logs.
+	std::vector<std::string> groupNames;
+
+	std::vector<HDF5Typecaster::log_keyframe_entry_t> keyframes;
+	size_t position;
+
+	/* pacing for replays slower or faster than real time */
+	boost::posix_time::ptime replayStartTime;
+	double replayStartStamp;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_HDF5LOGREPLAYER_H_ */
+
+/* EOF */
@@ -20,7 +20,9 @@
 #include "HDF5UpdateDeserializer.h"
 #include "brics_3d/core/HomogeneousMatrix44.h"
 #include "brics_3d/core/CovarianceMatrix66.h"
+#include "brics_3d/worldModel/sceneGraph/HDF5LogReplayer.h"
 #include <fstream>
+#include <algorithm>
 #include "H5LTpublic.h" // not in default installation -> need to enable HDF5_BUILD_HLIB
 
 
@@ -53,6 +55,7 @@ herr_t collectGroupNames(hid_t loc_id, const char *name, void *opdata) {
 
 HDF5UpdateDeserializer::HDF5UpdateDeserializer(WorldModel* wm) :
 		wm(wm) {
+	sceneUpdater = &wm->scene;
 
 }
 
@@ -98,8 +101,37 @@ bool HDF5UpdateDeserializer::handleSceneGraphUpdate(const char* dataBuffer,
        //H5::Exception::dontPrint();
 //    	H5::H5File file(messageName, H5F_ACC_RDONLY); // re-open that tmp file
 
-       H5::Group scene = file.openGroup("Scene");
-       LOG(DEBUG) << "HDF5UpdateDeserializer: Opened \"Scene\" group.";
+       if (H5Lexists(file.getId(), "Batch", H5P_DEFAULT) > 0) {
+    	   H5::Group batchGroup = file.openGroup("Batch");
+    	   LOG(DEBUG) << "HDF5UpdateDeserializer: Opened \"Batch\" group.";
+    	   if(!handleBatchGroup(batchGroup)) {
+    		   file.close();
+    		   return false;
+    	   }
+       } else {
+    	   H5::Group scene = file.openGroup("Scene");
+    	   LOG(DEBUG) << "HDF5UpdateDeserializer: Opened \"Scene\" group.";
+    	   if(!handleSceneGroup(scene)) {
+    		   file.close();
+    		   return false;
+    	   }
+       }
+
+       /* close file */
+       file.flush(H5F_SCOPE_GLOBAL);
+       file.close();
+
+    } catch (H5::Exception e) {
+    	LOG(ERROR) << "HDF5UpdateDeserializer: cannot process HDF5 file " << messageName;
+    	return false;
+    }
+
+    transferredBytes = dataLength;
+	return true;
+}
+
+bool HDF5UpdateDeserializer::handleSceneGroup(H5::Group& scene) {
+
        HDF5Typecaster::RsgUpdateCommand command;
        HDF5Typecaster::RsgNodeTypeInfo type;
        HDF5Typecaster::getCommandTypeInfoFromHDF5Group(command, scene);
@@ -112,7 +144,6 @@ bool HDF5UpdateDeserializer::handleSceneGraphUpdate(const char* dataBuffer,
        std::vector<std::string> groupNames = groupNamesIterator.collectedGroupNames;
        if(groupNames.size() != 1) {
     	   LOG(ERROR) << "HDF5UpdateDeserializer:  Discovered " << groupNames.size() << " H5::Groups underneath Scene Group. Should be one.";
-    	   file.close();
     	   return false;
        }
        std::string groupName = groupNames[0];
@@ -254,17 +285,40 @@ bool HDF5UpdateDeserializer::handleSceneGraphUpdate(const char* dataBuffer,
 
        }
 
-       /* close file */
-       file.flush(H5F_SCOPE_GLOBAL);
-       file.close();
+       return true;
+}
 
-    } catch (H5::Exception e) {
-    	LOG(ERROR) << "HDF5UpdateDeserializer: cannot process HDF5 file " << messageName;
-    	return false;
-    }
+bool HDF5UpdateDeserializer::handleBatchGroup(H5::Group& batchGroup) {
+
+	/* Discover the updates. The names are zero padded, so the sorted order is the order of recording. */
+	group_name_iter_info groupNamesIterator;
+	groupNamesIterator.index = 0;
+	batchGroup.iterateElems(".", NULL, collectGroupNames, &groupNamesIterator);
+	std::vector<std::string> updateNames = groupNamesIterator.collectedGroupNames;
+	std::sort(updateNames.begin(), updateNames.end());
+	LOG(DEBUG) << "HDF5UpdateDeserializer: Batch contains " << updateNames.size() << " updates.";
+
+	/* Record all updates first and then apply them as a whole */
+	SceneGraphUpdateBatch batch;
+	ISceneGraphUpdate* originalSceneUpdater = sceneUpdater;
+	sceneUpdater = &batch;
+	bool success = true;
+	try {
+		for (std::vector<std::string>::const_iterator it = updateNames.begin(); it != updateNames.end(); ++it) {
+			H5::Group scene = batchGroup.openGroup(*it);
+			success &= handleSceneGroup(scene);
+		}
+	} catch (H5::Exception e) {
+		sceneUpdater = originalSceneUpdater;
+		throw;
+	}
+	sceneUpdater = originalSceneUpdater;
 
-    transferredBytes = dataLength;
-	return true;
+	if(!success) {
+		LOG(ERROR) << "HDF5UpdateDeserializer: Batch contains malformed updates. Discarding it.";
+		return false;
+	}
+	return sceneUpdater->applyUpdateBatch(batch);
 }
 
 bool HDF5UpdateDeserializer::doAddNode(H5::Group& group) {
@@ -279,7 +333,7 @@ bool HDF5UpdateDeserializer::doAddNode(H5::Group& group) {
 	LOG(DEBUG) << "H5::Group has ID " << id;
 	HDF5Typecaster::getAttributesFromHDF5Group(attributes, group);
 
-	return wm->scene.addNode(parentId, id, attributes, true);
+	return sceneUpdater->addNode(parentId, id, attributes, true);
 }
 
 bool HDF5UpdateDeserializer::doAddGroup(H5::Group& group) {
@@ -296,7 +350,7 @@ bool HDF5UpdateDeserializer::doAddGroup(H5::Group& group) {
 
 //	LOG(DEBUG) << "Complete group name = " << group.getObjnameByIdx(group.getId());
 
-	return wm->scene.addGroup(parentId, id, attributes, true);
+	return sceneUpdater->addGroup(parentId, id, attributes, true);
 }
 
 bool HDF5UpdateDeserializer::doAddTransformNode(H5::Group& group) {
@@ -304,7 +358,7 @@ bool HDF5UpdateDeserializer::doAddTransformNode(H5::Group& group) {
 
 	Id id = 0;
 	vector<Attribute> attributes;
-	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44());
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform = SceneGraphAllocator::createTransformMatrix();
 	TimeStamp timeStamp;
 
 	if (!HDF5Typecaster::getNodeIdFromHDF5Group(id, group)) {
@@ -320,7 +374,7 @@ bool HDF5UpdateDeserializer::doAddTransformNode(H5::Group& group) {
 	}
 	LOG(DEBUG) << "Transform @t " << timeStamp.getSeconds() <<"  is" << std::endl << *transform;
 
-	return wm->scene.addTransformNode(parentId, id, attributes, transform, timeStamp, true);
+	return sceneUpdater->addTransformNode(parentId, id, attributes, transform, timeStamp, true);
 }
 
 bool HDF5UpdateDeserializer::doAddUncertainTransformNode(H5::Group& group) {
@@ -328,7 +382,7 @@ bool HDF5UpdateDeserializer::doAddUncertainTransformNode(H5::Group& group) {
 
 	Id id = 0;
 	vector<Attribute> attributes;
-	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44());
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform = SceneGraphAllocator::createTransformMatrix();
 	TimeStamp timeStamp;
 
 	if (!HDF5Typecaster::getNodeIdFromHDF5Group(id, group)) {
@@ -346,7 +400,7 @@ bool HDF5UpdateDeserializer::doAddUncertainTransformNode(H5::Group& group) {
 
 	brics_3d::ITransformUncertainty::ITransformUncertaintyPtr dummyUncertainty(new brics_3d::CovarianceMatrix66(0.001, 0.001, 0.001, 0.001, 0.001, 0.001));
 
-	return wm->scene.addUncertainTransformNode(parentId, id, attributes, transform, dummyUncertainty, timeStamp, true);
+	return sceneUpdater->addUncertainTransformNode(parentId, id, attributes, transform, dummyUncertainty, timeStamp, true);
 }
 
 bool HDF5UpdateDeserializer::doAddGeometricNode(H5::Group& group) {
@@ -374,7 +428,7 @@ bool HDF5UpdateDeserializer::doAddGeometricNode(H5::Group& group) {
 		return false;
 	}
 
-	return wm->scene.addGeometricNode(parentId, id, attributes, shape, timeStamp, true);
+	return sceneUpdater->addGeometricNode(parentId, id, attributes, shape, timeStamp, true);
 }
 
 bool HDF5UpdateDeserializer::doAddRemoteRootNode(H5::Group& group) {
@@ -389,7 +443,7 @@ bool HDF5UpdateDeserializer::doAddRemoteRootNode(H5::Group& group) {
 	LOG(DEBUG) << "H5::Group has ID " << id;
 	HDF5Typecaster::getAttributesFromHDF5Group(attributes, group);
 
-	return wm->scene.addRemoteRootNode(id, attributes);
+	return sceneUpdater->addRemoteRootNode(id, attributes);
 }
 
 bool HDF5UpdateDeserializer::doAddConnection(H5::Group& group) {
@@ -414,7 +468,7 @@ bool HDF5UpdateDeserializer::doAddConnection(H5::Group& group) {
 	HDF5Typecaster::getTimeStampFromHDF5Group(start, group, "start");
 	HDF5Typecaster::getTimeStampFromHDF5Group(end, group, "end");
 
-	return wm->scene.addConnection(parentId, id, attributes, sourceIds, targetIds, start, end, true);
+	return sceneUpdater->addConnection(parentId, id, attributes, sourceIds, targetIds, start, end, true);
 }
 
 bool HDF5UpdateDeserializer::doSetNodeAttributes(H5::Group& group) {
@@ -435,14 +489,14 @@ bool HDF5UpdateDeserializer::doSetNodeAttributes(H5::Group& group) {
 		LOG(WARNING) << "No attributesTimeStamp given.";
 	}
 
-	return wm->scene.setNodeAttributes(id, attributes, attributesTimeStamp);
+	return sceneUpdater->setNodeAttributes(id, attributes, attributesTimeStamp);
 }
 
 bool HDF5UpdateDeserializer::doSetTransform(H5::Group& group) {
 	LOG(DEBUG) << "HDF5UpdateDeserializer: doSetTransform.";
 
 	Id id;
-	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44());
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform = SceneGraphAllocator::createTransformMatrix();
 	TimeStamp timeStamp;
 
 	if (!HDF5Typecaster::getNodeIdFromHDF5Group(id, group)) {
@@ -450,12 +504,17 @@ bool HDF5UpdateDeserializer::doSetTransform(H5::Group& group) {
 		return false;
 	}
 
-	if(!HDF5Typecaster::getTransformFromHDF5Group(transform, timeStamp, group)) {
+	TransformStreamSample sample;
+	if (HDF5Typecaster::getTransformStreamSampleFromHDF5Group(sample, group)) { // sent with the transform stream encoding
+		if (!transformStreamDecoder.decode(id, sample, transform, timeStamp)) {
+			return false;
+		}
+	} else if(!HDF5Typecaster::getTransformFromHDF5Group(transform, timeStamp, group)) {
 		LOG(ERROR) << "H5::Group has no transform dataset.";
 		return false;
 	}
 
-	return wm->scene.setTransform(id, transform, timeStamp);
+	return sceneUpdater->setTransform(id, transform, timeStamp);
 }
 
 bool HDF5UpdateDeserializer::doDeleteNode(H5::Group& group) {
@@ -466,8 +525,9 @@ bool HDF5UpdateDeserializer::doDeleteNode(H5::Group& group) {
 		LOG(ERROR) << "H5::Group that shall be deleted has no ID";
 		return false;
 	}
+	transformStreamDecoder.reset(id);
 
-	return wm->scene.deleteNode(id);
+	return sceneUpdater->deleteNode(id);
 }
 
 bool HDF5UpdateDeserializer::doAddParent(H5::Group& group) {
@@ -479,7 +539,7 @@ bool HDF5UpdateDeserializer::doAddParent(H5::Group& group) {
 		return false;
 	}
 
-	return wm->scene.addParent(id, parentId);
+	return sceneUpdater->addParent(id, parentId);
 }
 
 bool HDF5UpdateDeserializer::doRemoveParent(H5::Group& group) {
@@ -491,7 +551,7 @@ bool HDF5UpdateDeserializer::doRemoveParent(H5::Group& group) {
 		return false;
 	}
 
-	return wm->scene.removeParent(id, parentId);
+	return sceneUpdater->removeParent(id, parentId);
 }
 
 bool HDF5UpdateDeserializer::loadFromAppendOnlyLogFile(string logFile) {
@@ -518,6 +578,13 @@ bool HDF5UpdateDeserializer::loadFromAppendOnlyLogFile(string logFile) {
 		}
 
 
+		/* Logs in the update table format (see HDF5AppendOnlyLogger::UPDATE_TABLES) */
+		if (H5Lexists(file.getId(), "updates", H5P_DEFAULT) > 0) {
+			file.close();
+			HDF5LogReplayer replayer(wm);
+			return replayer.open(logFile) && replayer.replay(replayer.getEndStamp());
+		}
+
 		/* Discover all attached HDF5 groups */
 		group_name_iter_info groupNamesIterator;
 		groupNamesIterator.index = 0;
@@ -23,6 +23,8 @@
 #include "brics_3d/worldModel/WorldModel.h"
 #include "brics_3d/util/HDF5Typecaster.h"
 #include "brics_3d/worldModel/sceneGraph/IPort.h"
+#include "brics_3d/worldModel/sceneGraph/SceneGraphUpdateBatch.h"
+#include "brics_3d/worldModel/sceneGraph/SceneGraphAllocator.h"
 
 namespace brics_3d {
 namespace rsg {
@@ -36,10 +38,16 @@ public:
 	bool loadFromAppendOnlyLogFile(string logFile);
 	static Id getRootIdFromAppendOnlyLogFile(string logFile);
 
+	/// Process a single update as stored in a "Scene" group, e.g. a top level group of a log file.
+	bool handleSceneGroup(H5::Group& scene);
+
 protected:
 
 	bool handleSceneGraphUpdate(const char *dataBuffer, int dataLength, int &transferredBytes);
 
+	/// Process all updates of a "Batch" group and apply them as one SceneGraphUpdateBatch.
+	bool handleBatchGroup(H5::Group& batchGroup);
+
 	//Functions that do the actual work (template method)
 	virtual bool doAddNode(H5::Group& group);
 	virtual bool doAddGroup(H5::Group& group);
@@ -57,6 +65,12 @@ protected:
 private:
 	WorldModel* wm;
 	Id parentId;
+
+	/// Receiver of the decoded updates. Defaults to the scene of the world model, but is temporarily a batch while decoding batches.
+	ISceneGraphUpdate* sceneUpdater;
+
+	/// Reconstructs transforms that have been sent with HDF5UpdateSerializer::setUseTransformStreamEncoding().
+	TransformStreamDecoder transformStreamDecoder;
 };
 
 } /* namespace rsg */
@@ -19,6 +19,7 @@
 
 #include "HDF5UpdateSerializer.h"
 #include <fstream>
+#include <cstdio>
 
 namespace brics_3d {
 namespace rsg {
@@ -30,6 +31,9 @@ HDF5UpdateSerializer::HDF5UpdateSerializer(IOutputPort* port) :
 	/* some default values */
 	storeMessageBackupsOnFileSystem = false;
 	fileImageIncremet = 1*sizeof(char);
+	batchGroup = 0;
+	batchUpdateCount = 0;
+	useTransformStreamEncoding = false;
 
 	std::stringstream instanceBasedSuffix; //in case multiple HDF5 files  with the same derived file name are created.
 	instanceBasedSuffix << this; // pointer as "name"
@@ -170,7 +174,7 @@ bool HDF5UpdateSerializer::addGeometricNode(Id parentId,
 		HDF5Typecaster::addNodeTypeInfoToHDF5Group(HDF5Typecaster::GEOMETIRC_NODE, group);
 		HDF5Typecaster::addNodeIdToHDF5Group(assignedId, group);
 		HDF5Typecaster::addAttributesToHDF5Group(attributes, group);
-		HDF5Typecaster::addShapeToHDF5Group(shape, group);
+		HDF5Typecaster::addShapeToHDF5Group(shape, group, pointCloudStorageOptions);
 		HDF5Typecaster::addTimeStampToHDF5Group(timeStamp, group);
 
 		file.flush(H5F_SCOPE_GLOBAL);
@@ -300,7 +304,13 @@ bool HDF5UpdateSerializer::setTransform(Id id,
 		H5::Group group = scene.createGroup("Transform-Update-" + id.toString()); // The actual data
 		HDF5Typecaster::addNodeTypeInfoToHDF5Group(HDF5Typecaster::TRANSFORM, group);
 		HDF5Typecaster::addNodeIdToHDF5Group(id, group);
-		HDF5Typecaster::addTransformToHDF5Group(transform, timeStamp, group);
+		if (useTransformStreamEncoding) {
+			TransformStreamSample sample;
+			transformStreamEncoder.encode(id, transform, timeStamp, sample);
+			HDF5Typecaster::addTransformStreamSampleToHDF5Group(sample, group);
+		} else {
+			HDF5Typecaster::addTransformToHDF5Group(transform, timeStamp, group);
+		}
 
 		file.flush(H5F_SCOPE_GLOBAL);
 		doSendMessage(file);
@@ -325,6 +335,7 @@ bool HDF5UpdateSerializer::setUncertainTransform(Id id,
 
 bool HDF5UpdateSerializer::deleteNode(Id id) {
 	LOG(DEBUG) << "HDF5UpdateSerializer: deleting Node-" << id.toString();
+	transformStreamEncoder.reset(id);
 	try {
 		std::string fileName = "Node-Deletion-" + id.toString() + fileSuffix;
 		H5::FileAccPropList faplCore;
@@ -406,6 +417,38 @@ bool HDF5UpdateSerializer::removeParent(Id id, Id parentId) {
 	return true;
 }
 
+bool HDF5UpdateSerializer::applyUpdateBatch(const SceneGraphUpdateBatch& batch) {
+	LOG(DEBUG) << "HDF5UpdateSerializer: adding a Batch with " << batch.getNumberOfUpdates() << " updates.";
+	if (batchGroup != 0) { // nested batches are just flattened into the current one
+		return batch.replay(this);
+	}
+
+	bool success = false;
+	try {
+		std::string fileName = "Batch" + fileSuffix;
+		H5::FileAccPropList faplCore;
+		faplCore.setCore(fileImageIncremet, storeMessageBackupsOnFileSystem); // toggle in-memory behavior
+		H5::H5File file(fileName, H5F_ACC_TRUNC, H5::FileCreatPropList::DEFAULT, faplCore);
+
+		H5::Group batchUpdates = file.createGroup("Batch");
+		batchGroup = &batchUpdates;
+		batchUpdateCount = 0;
+		success = batch.replay(this); // every update will be appended to the batchGroup by doSendMessage()
+		batchGroup = 0;
+
+		file.flush(H5F_SCOPE_GLOBAL);
+		doSendMessage(file);
+		file.close();
+
+	} catch (H5::Exception e) {
+		batchGroup = 0;
+		LOG(ERROR) << "HDF5UpdateSerializer applyUpdateBatch: Cannot create a HDF serialization.";
+		return false;
+	}
+
+	return success;
+}
+
 bool HDF5UpdateSerializer::doSendMessage(std::string messageName) {
 	std::ifstream inputFile;
 	inputFile.open(messageName.c_str(), std::ios::binary);
@@ -435,6 +478,19 @@ bool HDF5UpdateSerializer::doSendMessage(std::string messageName) {
 }
 
 bool HDF5UpdateSerializer::doSendMessage(H5::H5File message) {
+
+	/* In batch mode the message is not send but appended to the batch */
+	if (batchGroup != 0) {
+		char updateName[32];
+		snprintf(updateName, sizeof(updateName), "Update-%06u", batchUpdateCount++);
+		herr_t status = H5Ocopy(message.getId(), "Scene", batchGroup->getId(), updateName, H5P_DEFAULT, H5P_DEFAULT);
+		if (status < 0) {
+			LOG(ERROR) << "HDF5UpdateSerializer: Cannot append update " << updateName << " to batch.";
+			return false;
+		}
+		return true;
+	}
+
 	ssize_t fileSize = -1;
 //	ssize_t numberOfBytesRead;
 
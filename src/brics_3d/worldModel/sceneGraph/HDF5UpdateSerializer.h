@@ -23,6 +23,8 @@
 #include "brics_3d/core/Logger.h"
 #include "brics_3d/worldModel/sceneGraph/ISceneGraphUpdateObserver.h"
 #include "brics_3d/worldModel/sceneGraph/IPort.h"
+#include "brics_3d/worldModel/sceneGraph/SceneGraphUpdateBatch.h"
+#include "brics_3d/worldModel/sceneGraph/TransformStreamCodec.h"
 #include "brics_3d/util/HDF5Typecaster.h"
 
 namespace brics_3d {
@@ -47,6 +49,15 @@ public:
 	bool addParent(Id id, Id parentId);
 	bool removeParent(Id id, Id parentId);
 
+	/**
+	 * @brief Serializes all updates of the batch into a single message.
+	 *
+	 * The message contains a "Batch" group with one "Update-<index>" sub group
+	 * per recorded update. Each of them has the same layout as the "Scene" group of
+	 * a single update message.
+	 */
+	bool applyUpdateBatch(const SceneGraphUpdateBatch& batch);
+
 	bool getStoreMessageBackupsOnFileSystem() const {
 		return storeMessageBackupsOnFileSystem;
 	}
@@ -56,6 +67,33 @@ public:
 		this->storeMessageBackupsOnFileSystem = storeMessageBackupsOnFileSystem;
 	}
 
+	const HDF5Typecaster::PointCloudStorageOptions& getPointCloudStorageOptions() const {
+		return pointCloudStorageOptions;
+	}
+
+	/// Chunking, compression and precision of sent point clouds. Default is uncompressed double precision.
+	void setPointCloudStorageOptions(const HDF5Typecaster::PointCloudStorageOptions& pointCloudStorageOptions) {
+		this->pointCloudStorageOptions = pointCloudStorageOptions;
+	}
+
+	bool getUseTransformStreamEncoding() const {
+		return useTransformStreamEncoding;
+	}
+
+	/**
+	 * @brief Send setTransform updates as per node stream of single precision deltas with periodic keyframes.
+	 * The receiving HDF5UpdateDeserializer detects the encoding automatically. Default is false.
+	 */
+	void setUseTransformStreamEncoding(bool useTransformStreamEncoding) {
+		this->useTransformStreamEncoding = useTransformStreamEncoding;
+		transformStreamEncoder.reset();
+	}
+
+	/// Keyframe interval and error bounds of the transform stream encoding.
+	void setTransformStreamOptions(const TransformStreamEncoder::Options& options) {
+		transformStreamEncoder.setOptions(options);
+	}
+
 protected:
 
 	bool doSendMessage(std::string messageName);
@@ -66,6 +104,16 @@ protected:
 	size_t fileImageIncremet;
 
 	std::string fileSuffix;
+	HDF5Typecaster::PointCloudStorageOptions pointCloudStorageOptions;
+
+	/// Target of the messages while a batch is serialized. NULL otherwise.
+	H5::Group* batchGroup;
+
+	/// Number of updates that have been added to the batchGroup so far.
+	unsigned int batchUpdateCount;
+
+	bool useTransformStreamEncoding;
+	TransformStreamEncoder transformStreamEncoder;
 };
 
 } /* namespace rsg */
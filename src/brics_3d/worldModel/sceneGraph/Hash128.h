@@ -0,0 +1,80 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#ifndef RSG_HASH128_H_
+#define RSG_HASH128_H_
+
+#include <boost/cstdint.hpp>
+#include <string>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief A 128 bit hash value as used by the binary hashing functions of the NodeHash.
+ */
+struct Hash128 {
+	boost::uint64_t high;
+	boost::uint64_t low;
+
+	Hash128() : high(0), low(0) {};
+	Hash128(boost::uint64_t high, boost::uint64_t low) : high(high), low(low) {};
+
+	bool operator==(const Hash128& other) const {
+		return (high == other.high) && (low == other.low);
+	}
+
+	bool operator!=(const Hash128& other) const {
+		return !(*this == other);
+	}
+
+	bool operator<(const Hash128& other) const {
+		return (high < other.high) || ((high == other.high) && (low < other.low));
+	}
+
+	/**
+	 * @brief 128 bit addition (modulo 2^128).
+	 * This is used to combine hashes independent of their order. In contrast to XOR, equal hashes do not cancel out.
+	 */
+	Hash128& operator+=(const Hash128& other) {
+		boost::uint64_t previousLow = low;
+		low += other.low;
+		high += other.high + ((low < previousLow) ? 1 : 0);
+		return *this;
+	}
+
+	/// 32 hex digits, most significant first.
+	std::string toString() const {
+		static const char digits[] = "0123456789abcdef";
+		std::string result(32, '0');
+		for (int i = 0; i < 16; ++i) {
+			result[15 - i] = digits[(high >> (4 * i)) & 0xF];
+			result[31 - i] = digits[(low >> (4 * i)) & 0xF];
+		}
+		return result;
+	}
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_HASH128_H_ */
+
+/* EOF */
@@ -54,6 +54,18 @@ class IIdGenerator { // TODO: Should be singleton?
      */
     virtual bool removeIdFromPool(Id id) = 0;
 
+    /**
+     * @brief Check if removeIdFromPool() would succeed for an ID, without removing it.
+     *
+     * The default implementation is optimistic. Generators that keep track of the used IDs
+     * should override it, such that an update batch with forced IDs can be validated upfront.
+     * @param id The ID to be checked.
+     * @return True if the ID can be removed from the pool.
+     */
+    virtual bool isIdInPool(Id id) {
+    	return true;
+    }
+
 };
 
 } // namespace brics_3d::rsg
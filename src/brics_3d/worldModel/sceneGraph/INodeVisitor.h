@@ -43,7 +43,23 @@ public:
 		custom     // specialized traversal e.b. with memorization of intermediate results
 	};
 
-	INodeVisitor(TraverseDirection direction = downwards){this->direction = direction;};
+	/**
+	 * Control values that a visitor can set within a visit() call via setVisitControl()
+	 * in order to influence the ongoing traversal. The value is reset to continueTraversal
+	 * before every visit.
+	 */
+	enum VisitControl {
+		continueTraversal, // proceed with the next nodes (default)
+		skipChildren,      // do not descend (or ascend for upwards traversals) from the current node
+		stopTraversal      // abort the traversal immediately
+	};
+
+	INodeVisitor(TraverseDirection direction = downwards){
+		this->direction = direction;
+		this->visitControl = continueTraversal;
+		this->visitEachNodeOnce = false;
+		this->maxDepth = -1;
+	};
 	virtual ~INodeVisitor(){};
 
 	virtual void visit(Node* node){};
@@ -62,8 +78,50 @@ public:
         this->direction = direction;
     }
 
+    VisitControl getVisitControl() const
+    {
+        return visitControl;
+    }
+
+    void setVisitControl(VisitControl visitControl)
+    {
+        this->visitControl = visitControl;
+    }
+
+    bool getVisitEachNodeOnce() const
+    {
+        return visitEachNodeOnce;
+    }
+
+    /**
+     * Remember all visited nodes during a traversal and skip them when they are reached again.
+     * This is useful for graphs where children are shared between multiple parents.
+     * Default is false, i.e. a shared node is visited once per path.
+     */
+    void setVisitEachNodeOnce(bool visitEachNodeOnce)
+    {
+        this->visitEachNodeOnce = visitEachNodeOnce;
+    }
+
+    int getMaxDepth() const
+    {
+        return maxDepth;
+    }
+
+    /**
+     * Limit the traversal to a number of levels below (or above for upwards traversals) the start node.
+     * 0 visits only the start node. A negative value means unlimited (default).
+     */
+    void setMaxDepth(int maxDepth)
+    {
+        this->maxDepth = maxDepth;
+    }
+
 protected:
 	TraverseDirection direction;
+	VisitControl visitControl;
+	bool visitEachNodeOnce;
+	int maxDepth;
 
 };
 
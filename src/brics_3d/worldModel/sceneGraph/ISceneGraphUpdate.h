@@ -30,6 +30,7 @@
 using std::vector;
 
 namespace brics_3d { namespace rsg { class Attribute; }  } 
+namespace brics_3d { namespace rsg { class SceneGraphUpdateBatch; }  } 
 
 namespace brics_3d {
 
@@ -169,6 +170,8 @@ class ISceneGraphUpdate {
 	 *
 	 * @param id ID the defines the Transform node to be updated.
 	 * @param transform The transform data that will be inserted in to the cacje of the Transform.
+	 *                  The pointer itself is stored, not a copy. At high update rates create it with
+	 *                  SceneGraphAllocator::createTransformMatrix() so it is served from the transform history pool.
 	 * @param timeStamp Time stamp associated with the transform.
 	 * @return True on success.
 	 */
@@ -203,6 +206,19 @@ class ISceneGraphUpdate {
 	 */
     virtual bool removeParent(Id id, Id parentId) = 0;
 
+    /**
+     * @brief Apply a set of recorded updates as one transaction.
+     *
+     * The default implementation simply replays all updates of the batch
+     * one by one on this interface. Implementations like the SceneGraphFacade
+     * override it to apply the batch atomically and to notify their observers
+     * only once per batch. Serializers override it to emit a single message.
+     *
+	 * @param batch The recorded updates. See brics_3d::rsg::SceneGraphUpdateBatch
+	 * @return True on success i.e. all updates of the batch could be applied.
+	 */
+    virtual bool applyUpdateBatch(const SceneGraphUpdateBatch& batch);
+
 };
 
 } // namespace brics_3d::rsg
@@ -0,0 +1,381 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#include "IncrementalOutdatedDataDeleter.h"
+#include "UncertainTransform.h"
+#include "brics_3d/core/Logger.h"
+#include <assert.h>
+
+namespace brics_3d {
+namespace rsg {
+
+namespace {
+
+bool isStaticTransform(vector<Attribute>& attributes) {
+	return attributeListContainsAttribute(attributes, Attribute("transformType","static"));
+}
+
+/// Same policy as in SceneGraphFacade::addTransformNode()
+Duration getMaxTransformDuration(vector<Attribute>& attributes) {
+	Duration maxHistoryDuration = Duration(10, Units::Second);
+	vector<std::string> resultValues;
+	if(getValuesFromAttributeList(attributes, "tf:max_duration", resultValues)){
+		Duration parsedDuration = TimeStamp::fromString(resultValues[0]);
+		if (!(parsedDuration == TimeStamp(0))) {
+			maxHistoryDuration = parsedDuration;
+		}
+	}
+	return maxHistoryDuration;
+}
+
+}
+
+class IncrementalOutdatedDataDeleter::ExistingNodeIndexer : public INodeVisitor {
+public:
+	ExistingNodeIndexer(IncrementalOutdatedDataDeleter* deleter) : INodeVisitor(downwards), deleter(deleter), trackedNodeCount(0) {
+		setVisitEachNodeOnce(true);
+	}
+
+	void visit(Transform* node) {
+		IndexEntry entry;
+		entry.nodeType = (dynamic_cast<UncertainTransform*>(node) != 0) ? IndexEntry::UNCERTAIN_TRANSFORM : IndexEntry::TRANSFORM;
+		vector<Attribute> attributes = node->getAttributes();
+		entry.isStatic = isStaticTransform(attributes);
+		entry.newestTimeStamp = node->getLatestTimeStamp();
+		entry.maxDuration = node->getMaxHistoryDuration();
+		track(node->getId(), entry);
+	}
+
+	void visit(GeometricNode* node) {
+		IndexEntry entry;
+		entry.nodeType = IndexEntry::GEOMETRIC_NODE;
+		entry.newestTimeStamp = node->getTimeStamp();
+		entry.maxDuration = deleter->maxGeometricNodeDuration;
+		track(node->getId(), entry);
+	}
+
+	void visit(Connection* connection) {};
+
+	unsigned int getTrackedNodeCount() const {
+		return trackedNodeCount;
+	}
+
+private:
+
+	void track(Id id, IndexEntry& entry) {
+		if (deleter->index.find(id) != deleter->index.end() || deleter->inactiveIndex.find(id) != deleter->inactiveIndex.end()) {
+			return; // observer updates are at least as recent
+		}
+		deleter->addToIndex(id, entry);
+		trackedNodeCount++;
+	}
+
+	IncrementalOutdatedDataDeleter* deleter;
+	unsigned int trackedNodeCount;
+};
+
+IncrementalOutdatedDataDeleter::IncrementalOutdatedDataDeleter(SceneGraphFacade* facadeHandle) {
+	assert(facadeHandle != 0);
+	this->facadeHandle = facadeHandle;
+	generationCounter = 0;
+	enableTransformDeletions = true;
+	enableGeometricNodeDeletions = true;
+	maxGeometricNodeDuration = Duration(5, Units::Second);
+	indexExistingNodes();
+}
+
+IncrementalOutdatedDataDeleter::~IncrementalOutdatedDataDeleter() {
+	facadeHandle = 0; //we do not delete, as we are not the owner
+}
+
+bool IncrementalOutdatedDataDeleter::addNode(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId) {
+	return true;
+}
+
+bool IncrementalOutdatedDataDeleter::addGroup(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId) {
+	return true;
+}
+
+bool IncrementalOutdatedDataDeleter::addTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp, bool forcedId) {
+	IndexEntry entry;
+	entry.nodeType = IndexEntry::TRANSFORM;
+	entry.isStatic = isStaticTransform(attributes);
+	entry.newestTimeStamp = timeStamp;
+	entry.maxDuration = getMaxTransformDuration(attributes);
+	addToIndex(assignedId, entry);
+	return true;
+}
+
+bool IncrementalOutdatedDataDeleter::addUncertainTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp, bool forcedId) {
+	IndexEntry entry;
+	entry.nodeType = IndexEntry::UNCERTAIN_TRANSFORM;
+	entry.isStatic = isStaticTransform(attributes);
+	entry.newestTimeStamp = timeStamp;
+	entry.maxDuration = Duration(10, Units::Second); // default of UncertainTransform
+	addToIndex(assignedId, entry);
+	return true;
+}
+
+bool IncrementalOutdatedDataDeleter::addGeometricNode(Id parentId, Id& assignedId, vector<Attribute> attributes, Shape::ShapePtr shape, TimeStamp timeStamp, bool forcedId) {
+	IndexEntry entry;
+	entry.nodeType = IndexEntry::GEOMETRIC_NODE;
+	entry.newestTimeStamp = timeStamp;
+	entry.maxDuration = maxGeometricNodeDuration;
+	addToIndex(assignedId, entry);
+	return true;
+}
+
+bool IncrementalOutdatedDataDeleter::addRemoteRootNode(Id rootId, vector<Attribute> attributes) {
+	return true;
+}
+
+bool IncrementalOutdatedDataDeleter::addConnection(Id parentId, Id& assignedId, vector<Attribute> attributes, vector<Id> sourceIds, vector<Id> targetIds, TimeStamp start, TimeStamp end, bool forcedId) {
+	return true;
+}
+
+bool IncrementalOutdatedDataDeleter::setNodeAttributes(Id id, vector<Attribute> newAttributes, TimeStamp timeStamp) {
+	IndexEntry entry;
+	boost::unordered_map<Id, IndexEntry>::iterator indexedEntry = index.find(id);
+	boost::unordered_map<Id, IndexEntry>::iterator inactiveEntry = inactiveIndex.find(id);
+	if (indexedEntry != index.end()) {
+		entry = indexedEntry->second;
+	} else if (inactiveEntry != inactiveIndex.end()) {
+		entry = inactiveEntry->second;
+	} else {
+		return true;
+	}
+
+	if (entry.nodeType == IndexEntry::GEOMETRIC_NODE) {
+		return true;
+	}
+	entry.isStatic = isStaticTransform(newAttributes);
+	if (entry.nodeType == IndexEntry::TRANSFORM) {
+		entry.maxDuration = getMaxTransformDuration(newAttributes);
+	}
+	addToIndex(id, entry); // re-index, as the static flag or the duration might have changed
+	return true;
+}
+
+bool IncrementalOutdatedDataDeleter::setTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp) {
+	boost::unordered_map<Id, IndexEntry>::iterator entry = index.find(id);
+	if (entry != index.end()) {
+		updateExpiry(id, timeStamp, entry->second.maxDuration);
+		return true;
+	}
+
+	entry = inactiveIndex.find(id);
+	if (entry != inactiveIndex.end() && entry->second.newestTimeStamp < timeStamp) { // keep track in case it can expire later
+		entry->second.newestTimeStamp = timeStamp;
+	}
+	return true;
+}
+
+bool IncrementalOutdatedDataDeleter::setUncertainTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp) {
+	return setTransform(id, transform, timeStamp);
+}
+
+bool IncrementalOutdatedDataDeleter::deleteNode(Id id) {
+	removeFromIndex(id);
+	return true;
+}
+
+bool IncrementalOutdatedDataDeleter::addParent(Id id, Id parentId) {
+	return true;
+}
+
+bool IncrementalOutdatedDataDeleter::removeParent(Id id, Id parentId) {
+	return true;
+}
+
+unsigned int IncrementalOutdatedDataDeleter::deleteOutdatedData(TimeStamp now, Duration timeBudget) {
+	unsigned int deletionCount = 0;
+	bool useTimeBudget = timeBudget > Duration(0);
+	if (useTimeBudget) {
+		timer.reset();
+	}
+
+	updateTopEntry();
+	while (!expiryQueue.empty() && (expiryQueue.top().expiry < now)) {
+		if (useTimeBudget && (deletionCount > 0) && (Duration(timer.getElapsedTime(), Units::MilliSecond) > timeBudget)) {
+			LOG(DEBUG) << "IncrementalOutdatedDataDeleter: Time budget exceeded after " << deletionCount << " deletions.";
+			break;
+		}
+
+		Id id = expiryQueue.top().id;
+		expiryQueue.pop();
+		index.erase(id);
+		LOG(DEBUG) << "IncrementalOutdatedDataDeleter: Deleting expired node with ID " << id;
+		if (doDeleteNode(id)) {
+			deletionCount++;
+		}
+		updateTopEntry();
+	}
+
+	return deletionCount;
+}
+
+unsigned int IncrementalOutdatedDataDeleter::indexExistingNodes() {
+	ExistingNodeIndexer indexer(this);
+	facadeHandle->executeGraphTraverser(&indexer, facadeHandle->getRootId());
+	LOG(DEBUG) << "IncrementalOutdatedDataDeleter: " << indexer.getTrackedNodeCount() << " existing nodes are tracked now.";
+	return indexer.getTrackedNodeCount();
+}
+
+unsigned int IncrementalOutdatedDataDeleter::getNumberOfIndexedNodes() const {
+	return static_cast<unsigned int>(index.size());
+}
+
+bool IncrementalOutdatedDataDeleter::getNextExpiry(TimeStamp& expiry) {
+	updateTopEntry();
+	if (expiryQueue.empty()) {
+		return false;
+	}
+	expiry = expiryQueue.top().expiry;
+	return true;
+}
+
+bool IncrementalOutdatedDataDeleter::getEnableTransformDeletions() const {
+	return enableTransformDeletions;
+}
+
+void IncrementalOutdatedDataDeleter::setEnableTransformDeletions(bool enableTransformDeletions) {
+	this->enableTransformDeletions = enableTransformDeletions;
+	reindex();
+}
+
+bool IncrementalOutdatedDataDeleter::getEnableGeometricNodeDeletions() const {
+	return enableGeometricNodeDeletions;
+}
+
+void IncrementalOutdatedDataDeleter::setEnableGeometricNodeDeletions(bool enableGeometricNodeDeletions) {
+	this->enableGeometricNodeDeletions = enableGeometricNodeDeletions;
+	reindex();
+}
+
+Duration IncrementalOutdatedDataDeleter::getMaxGeometricNodeDuration() const {
+	return maxGeometricNodeDuration;
+}
+
+void IncrementalOutdatedDataDeleter::setMaxGeometricNodeDuration(Duration maxGeometricNodeDuration) {
+	this->maxGeometricNodeDuration = maxGeometricNodeDuration;
+
+	boost::unordered_map<Id, IndexEntry>::iterator entry;
+	for (entry = inactiveIndex.begin(); entry != inactiveIndex.end(); ++entry) {
+		if (entry->second.nodeType == IndexEntry::GEOMETRIC_NODE) {
+			entry->second.maxDuration = maxGeometricNodeDuration;
+		}
+	}
+	for (entry = index.begin(); entry != index.end(); ++entry) {
+		if (entry->second.nodeType == IndexEntry::GEOMETRIC_NODE) {
+			updateExpiry(entry->first, entry->second.newestTimeStamp, maxGeometricNodeDuration); // a shorter duration is queued, a longer one is postponed lazily
+		}
+	}
+}
+
+bool IncrementalOutdatedDataDeleter::doDeleteNode(Id id) {
+	return facadeHandle->deleteNode(id);
+}
+
+void IncrementalOutdatedDataDeleter::addToIndex(Id id, IndexEntry entry) {
+	removeFromIndex(id);
+	if (canExpire(entry)) {
+		IndexEntry& indexedEntry = index[id];
+		indexedEntry = entry;
+		enqueue(id, indexedEntry);
+	} else {
+		inactiveIndex[id] = entry;
+	}
+}
+
+void IncrementalOutdatedDataDeleter::updateExpiry(Id id, TimeStamp timeStamp, Duration maxDuration) {
+	IndexEntry& entry = index[id]; // creates a new one if necessary
+	bool isNewEntry = (entry.generation == 0);
+	if (isNewEntry || entry.newestTimeStamp < timeStamp) { // out of order updates do not shorten the lifetime
+		entry.newestTimeStamp = timeStamp;
+	}
+	entry.maxDuration = maxDuration;
+
+	/* a later expiry is handled lazily in updateTopEntry(); only an earlier one requires a new heap entry */
+	if (isNewEntry || (entry.newestTimeStamp + entry.maxDuration < entry.queuedExpiry)) {
+		enqueue(id, entry);
+	}
+}
+
+void IncrementalOutdatedDataDeleter::enqueue(Id id, IndexEntry& entry) {
+	entry.generation = ++generationCounter;
+	entry.queuedExpiry = entry.newestTimeStamp + entry.maxDuration;
+	expiryQueue.push(ExpiryEntry(entry.queuedExpiry, id, entry.generation));
+}
+
+void IncrementalOutdatedDataDeleter::removeFromIndex(Id id) {
+	index.erase(id);
+	inactiveIndex.erase(id);
+}
+
+bool IncrementalOutdatedDataDeleter::canExpire(const IndexEntry& entry) const {
+	if (entry.nodeType == IndexEntry::GEOMETRIC_NODE) {
+		return enableGeometricNodeDeletions;
+	}
+	return enableTransformDeletions && !entry.isStatic;
+}
+
+void IncrementalOutdatedDataDeleter::reindex() {
+	boost::unordered_map<Id, IndexEntry>::iterator entry = index.begin();
+	while (entry != index.end()) {
+		if (!canExpire(entry->second)) {
+			inactiveIndex[entry->first] = entry->second; // its heap entry becomes stale
+			entry = index.erase(entry);
+		} else {
+			++entry;
+		}
+	}
+
+	entry = inactiveIndex.begin();
+	while (entry != inactiveIndex.end()) {
+		if (canExpire(entry->second)) {
+			IndexEntry& indexedEntry = index[entry->first];
+			indexedEntry = entry->second;
+			enqueue(entry->first, indexedEntry);
+			entry = inactiveIndex.erase(entry);
+		} else {
+			++entry;
+		}
+	}
+}
+
+void IncrementalOutdatedDataDeleter::updateTopEntry() {
+	while (!expiryQueue.empty()) {
+		ExpiryEntry top = expiryQueue.top();
+		boost::unordered_map<Id, IndexEntry>::iterator entry = index.find(top.id);
+		if (entry != index.end() && entry->second.generation == top.generation) {
+			if (!(top.expiry < entry->second.newestTimeStamp + entry->second.maxDuration)) {
+				return; // valid and up to date
+			}
+			expiryQueue.pop();
+			enqueue(top.id, entry->second); // postpone as there was an update
+		} else {
+			expiryQueue.pop(); // stale
+		}
+	}
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
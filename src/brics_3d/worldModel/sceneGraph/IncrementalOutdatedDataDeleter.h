@@ -0,0 +1,218 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#ifndef RSG_INCREMENTALOUTDATEDDATADELETER_H_
+#define RSG_INCREMENTALOUTDATEDDATADELETER_H_
+
+#include "ISceneGraphUpdateObserver.h"
+#include "SceneGraphFacade.h"
+#include "brics_3d/util/Timer.h"
+#include <vector>
+#include <queue>
+#include <boost/unordered_map.hpp>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Deletes outdated Transforms and GeometricNodes based on an expiry index.
+ * @ingroup sceneGraph
+ *
+ * In contrast to the OutdatedDataIdAwareDeleter no graph traversal is necessary. This
+ * class is an observer of a SceneGraphFacade that maintains a min-heap of expiry
+ * times, keyed by the newest time stamp of every Transform, UncertainTransform and
+ * GeometricNode. A deletion pass only touches nodes that are actually expired, and it
+ * can be limited by a time budget, such that the work is spread over multiple cycles.
+ *
+ * A node expires when its newest data is older than the maximum duration, i.e.
+ *  - for transforms the history duration (as given by the "tf:max_duration" attribute, default 10s),
+ *    which means the complete history would be outdated,
+ *  - for geometric nodes the maximum geometric node duration (default 5s).
+ * Transforms with the Attribute ("transformType","static") never expire.
+ *
+ * Nodes that currently cannot expire (static transforms, or node types whose deletion is
+ * disabled) are still tracked, such that they are (re-)indexed as soon as the attributes
+ * or the deletion toggles change.
+ *
+ * Nodes that already exist when the deleter is created are indexed by a single traversal
+ * of the root node's subgraph in the constructor (see indexExistingNodes()). Subgraphs of
+ * remote root nodes that are not mounted below the root node are only covered by updates
+ * that arrive after the deleter has been attached.
+ *
+ * Usage:
+ * @code
+ * IncrementalOutdatedDataDeleter deleter(&wm->scene);
+ * wm->scene.attachUpdateObserver(&deleter);
+ * ...
+ * deleter.deleteOutdatedData(wm->now(), Duration(1, Units::MilliSecond)); // e.g. periodically
+ * @endcode
+ */
+class IncrementalOutdatedDataDeleter : public ISceneGraphUpdateObserver {
+public:
+	IncrementalOutdatedDataDeleter(SceneGraphFacade* facadeHandle);
+	virtual ~IncrementalOutdatedDataDeleter();
+
+	/* implemetntations of observer interface */
+	bool addNode(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId = false);
+	bool addGroup(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId = false);
+	bool addTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp, bool forcedId = false);
+    bool addUncertainTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp, bool forcedId = false);
+	bool addGeometricNode(Id parentId, Id& assignedId, vector<Attribute> attributes, Shape::ShapePtr shape, TimeStamp timeStamp, bool forcedId = false);
+	bool addRemoteRootNode(Id rootId, vector<Attribute> attributes);
+	bool addConnection(Id parentId, Id& assignedId, vector<Attribute> attributes, vector<Id> sourceIds, vector<Id> targetIds, TimeStamp start, TimeStamp end, bool forcedId = false);
+	bool setNodeAttributes(Id id, vector<Attribute> newAttributes, TimeStamp timeStamp = TimeStamp(0));
+	bool setTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp);
+    bool setUncertainTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp);
+	bool deleteNode(Id id);
+	bool addParent(Id id, Id parentId);
+    bool removeParent(Id id, Id parentId);
+
+    /**
+     * @brief Delete all nodes that are expired with respect to the given time.
+     * @param now The current time.
+     * @param timeBudget Maximum time to spend for this pass. Remaining expired nodes are handled by the next pass.
+     *        Zero means unlimited. At least one expired node is deleted per pass.
+     * @return Number of deleted nodes.
+     */
+    unsigned int deleteOutdatedData(TimeStamp now, Duration timeBudget = Duration(0));
+
+    /**
+     * @brief Track all Transforms and GeometricNodes below the root node that are not yet known.
+     * This is done once by the constructor. Call it again if observer updates have been missed,
+     * e.g. when the deleter has been attached later.
+     * @return Number of newly tracked nodes.
+     */
+    unsigned int indexExistingNodes();
+
+    /// Number of nodes that are tracked by the expiry index, i.e. nodes that can expire.
+    unsigned int getNumberOfIndexedNodes() const;
+
+    /**
+     * @brief Get the time when the next node expires.
+     * @param[out] expiry The expiry time.
+     * @return False if no node is indexed.
+     */
+    bool getNextExpiry(TimeStamp& expiry);
+
+    bool getEnableTransformDeletions() const;
+    void setEnableTransformDeletions(bool enableTransformDeletions);
+
+    bool getEnableGeometricNodeDeletions() const;
+    void setEnableGeometricNodeDeletions(bool enableGeometricNodeDeletions);
+
+    Duration getMaxGeometricNodeDuration() const;
+
+    /// Set the maximum age of geometric nodes. Already tracked geometric nodes are re-keyed to the new duration.
+    void setMaxGeometricNodeDuration(Duration maxGeometricNodeDuration);
+
+    /// Primitive operation for the actual deletion (Template method pattern). Default is SceneGraphFacade::deleteNode().
+    virtual bool doDeleteNode(Id id);
+
+private:
+
+    /**
+     * Index entry for a node. Updates only modify this entry. The heap entry is moved
+     * (postponed) lazily when it reaches the top of the heap. Thus the heap does not grow
+     * with the update rate.
+     */
+    struct IndexEntry {
+    	enum NodeType {
+    		TRANSFORM,
+    		UNCERTAIN_TRANSFORM,
+    		GEOMETRIC_NODE
+    	};
+
+    	IndexEntry() : nodeType(GEOMETRIC_NODE), isStatic(false), generation(0) {}
+    	NodeType nodeType;
+    	bool isStatic;
+    	TimeStamp newestTimeStamp;
+    	Duration maxDuration;
+    	TimeStamp queuedExpiry;
+    	unsigned long generation; // identifies the valid heap entry
+    };
+
+    /// Element of the min-heap.
+    struct ExpiryEntry {
+    	ExpiryEntry(TimeStamp expiry, Id id, unsigned long generation) : expiry(expiry), id(id), generation(generation) {}
+    	TimeStamp expiry;
+    	Id id;
+    	unsigned long generation;
+    	bool operator>(const ExpiryEntry& other) const {
+    		return expiry > other.expiry;
+    	}
+    };
+
+    /// Visitor that collects the already existing nodes for indexExistingNodes().
+    class ExistingNodeIndexer;
+
+    /// Start tracking a new node. It is indexed if it can expire.
+    void addToIndex(Id id, IndexEntry entry);
+
+    /// Update the index for a node with new data.
+    void updateExpiry(Id id, TimeStamp timeStamp, Duration maxDuration);
+
+    /// Remove a node from the index. Its heap entry becomes stale and will be skipped.
+    void removeFromIndex(Id id);
+
+    /// True if the node can expire with the current attributes and deletion toggles.
+    bool canExpire(const IndexEntry& entry) const;
+
+    /// Move nodes between the index and the inactive nodes after the deletion toggles have changed.
+    void reindex();
+
+    /// Push a new heap entry for a node. Previous heap entries of that node become stale.
+    void enqueue(Id id, IndexEntry& entry);
+
+    /// Remove stale entries from the top of the heap and postpone the top entry if its node has been updated meanwhile.
+    void updateTopEntry();
+
+    /// Handle to the facade where nodes are deleted.
+    SceneGraphFacade* facadeHandle;
+
+    /// Newest data per indexed node.
+    boost::unordered_map<Id, IndexEntry> index;
+
+    /// Newest data per node that is tracked but cannot expire (static or deletions disabled).
+    boost::unordered_map<Id, IndexEntry> inactiveIndex;
+
+    /// Min-heap of expiry times with at most one valid entry per node (lazy deletion of stale entries).
+    std::priority_queue<ExpiryEntry, std::vector<ExpiryEntry>, std::greater<ExpiryEntry> > expiryQueue;
+
+    /// Incremented for every index update.
+    unsigned long generationCounter;
+
+	/// Toggle weather Transforms should be toched or not. The default is true.
+    bool enableTransformDeletions;
+
+	/// Toggle weather GeometicNodes should be toched or not. The default is true.
+    bool enableGeometricNodeDeletions;
+
+    /// Maximum age of geometric nodes. The default is 5s.
+    Duration maxGeometricNodeDuration;
+
+    /// Timer to measure the time budget.
+    Timer timer;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_INCREMENTALOUTDATEDDATADELETER_H_ */
+
+/* EOF */
@@ -21,6 +21,7 @@
 #include <assert.h>
 
 #include "brics_3d/core/HomogeneousMatrix44.h"
+#include "brics_3d/worldModel/sceneGraph/SceneGraphAllocator.h"
 
 namespace brics_3d {
 namespace rsg {
@@ -30,10 +31,14 @@ JSONDeserializer::JSONDeserializer(WorldModel* wm) :
 	assert (wm != 0);
 	sceneUpdater = &wm->scene;
 	mapUnknownParentIdsToRootId = false;
+	useFastPath = true;
+	fastPathMessageCount = 0;
 }
 
 JSONDeserializer::JSONDeserializer(WorldModel* wm, ISceneGraphUpdate* sceneUpdater) : wm(wm), sceneUpdater(sceneUpdater) {
 	mapUnknownParentIdsToRootId = false;
+	useFastPath = true;
+	fastPathMessageCount = 0;
 }
 
 JSONDeserializer::~JSONDeserializer() {
@@ -42,6 +47,12 @@ JSONDeserializer::~JSONDeserializer() {
 
 int JSONDeserializer::write(const char *dataBuffer, int dataLength, int &transferredBytes) {
 
+	int result;
+	if (useFastPath && handleFastPath(dataBuffer, dataLength, result)) {
+		transferredBytes = dataLength;
+		return result;
+	}
+
 	try {
 		libvariant::Variant model = libvariant::Deserialize(dataBuffer, dataLength, libvariant::SERIALIZE_GUESS); // GUESS seems to be more permissive with parsing than JSON
 		transferredBytes = dataLength;
@@ -55,6 +66,11 @@ int JSONDeserializer::write(const char *dataBuffer, int dataLength, int &transfe
 
 int JSONDeserializer::write(std::string data) {
 
+	int result;
+	if (useFastPath && handleFastPath(data.c_str(), static_cast<int>(data.size()), result)) {
+		return result;
+	}
+
 	try {
 		libvariant::Variant model = libvariant:: Deserialize(data, libvariant::SERIALIZE_GUESS); // GUESS seems to be more permissive with parsing than JSON
 		return write(model);
@@ -80,6 +96,13 @@ int JSONDeserializer::write(libvariant::Variant& model) {
 					errorCode = 1;
 				}
 				return errorCode;
+			} else if(type.compare("RSGUpdateBatch") == 0) {
+				int errorCode = -1;
+				LOG(DEBUG) << "JSONDeserializer: Found a model for an update batch.";
+				if(handleWorldModelUpdateBatch(model)) {
+					errorCode = 1;
+				}
+				return errorCode;
 			} else if (type.compare("WorldModelAgent") == 0) {
 				LOG(DEBUG) << "JSONDeserializer: Found model for a WorldModelAgent.";
 				handleWorldModelAgent(model);
@@ -110,6 +133,68 @@ int JSONDeserializer::write(libvariant::Variant& model) {
 	}
 }
 
+bool JSONDeserializer::handleFastPath(const char *dataBuffer, int dataLength, int& result) {
+	if (!fastPathParser.parse(dataBuffer, dataLength, fastPathUpdate)) {
+		return false;
+	}
+
+	JSONFastPathParser::Update& update = fastPathUpdate;
+	bool success = false;
+	switch (update.operation) {
+
+	case JSONFastPathParser::CREATE_NODE:
+		success = applyAddNode(update.parentId, update.id, update.attributes, update.hasAttributesTimeStamp, update.attributesTimeStamp);
+		break;
+
+	case JSONFastPathParser::CREATE_GROUP:
+		success = applyAddGroup(update.parentId, update.id, update.attributes, update.hasAttributesTimeStamp, update.attributesTimeStamp);
+		break;
+
+	case JSONFastPathParser::UPDATE_ATTRIBUTES: {
+		AttributeUpdateMode updateMode = OVERWRITE; // default
+		if (!update.updateMode.empty() && !toAttributeUpdateMode(update.updateMode, updateMode)) {
+			return false; // let the generic path report it
+		}
+		success = applySetNodeAttributes(update.id, update.attributes, updateMode, update.hasAttributesTimeStamp, update.attributesTimeStamp);
+		break;
+	}
+
+	case JSONFastPathParser::UPDATE_TRANSFORM:
+		if (update.hasTransformStreamSample) {
+			success = applyTransformStreamSample(update.id, update.transformStreamSample);
+		} else {
+			HomogeneousMatrix44::IHomogeneousMatrix44Ptr transform = SceneGraphAllocator::createTransformMatrix(); // pooled as it goes to a history
+			*transform = HomogeneousMatrix44(
+					update.rotation[0], update.rotation[1], update.rotation[2],
+					update.rotation[3], update.rotation[4], update.rotation[5],
+					update.rotation[6], update.rotation[7], update.rotation[8],
+					update.translation[0], update.translation[1], update.translation[2]);
+			success = sceneUpdater->setTransform(update.id, transform, update.transformTimeStamp);
+		}
+		break;
+
+	default:
+		return false;
+	}
+
+	fastPathMessageCount++;
+	result = success ? 1 : -1;
+	return true;
+}
+
+bool JSONDeserializer::toAttributeUpdateMode(const std::string& updateModeModel, AttributeUpdateMode& updateMode) {
+	if(updateModeModel.compare("OVERWRITE") == 0) {
+		 updateMode = OVERWRITE;
+	} else if(updateModeModel.compare("UPDATE") == 0) {
+		 updateMode = UPDATE;
+	} else if(updateModeModel.compare("APPEND") == 0) {
+		 updateMode = APPEND;
+	} else {
+		return false;
+	}
+	return true;
+}
+
 Id JSONDeserializer::getRootIdFromJSONModel(std::string data) {
 	Id rootId = 0; //NiL in case of failure
 	libvariant::Variant model = libvariant:: Deserialize(data, libvariant::SERIALIZE_GUESS); // GUESS seems to be more permissive with parsing than JSON
@@ -140,6 +225,41 @@ Id JSONDeserializer::getRootIdFromJSONModel(std::string data) {
 	return rootId;
 }
 
+bool JSONDeserializer::handleWorldModelUpdateBatch(libvariant::Variant& model) {
+
+	if(!model.Contains("updates")) {
+		LOG(ERROR) << "JSONDeserializer: Syntax error: RSGUpdateBatch has no updates list.";
+		return false;
+	}
+	libvariant::Variant updates = model.Get("updates");
+	if(!updates.IsList()) {
+		LOG(ERROR) << "JSONDeserializer: Syntax error: updates of RSGUpdateBatch is not a list.";
+		return false;
+	}
+
+	/* Record all updates first and then apply them as a whole */
+	SceneGraphUpdateBatch batch;
+	ISceneGraphUpdate* originalSceneUpdater = sceneUpdater;
+	sceneUpdater = &batch;
+	bool success = true;
+	try {
+		for (libvariant::Variant::ListIterator i(updates.ListBegin()), e(updates.ListEnd()); i!=e; ++i) {
+			success &= handleWorldModelUpdate(*i);
+		}
+	} catch (std::exception const & e) {
+		sceneUpdater = originalSceneUpdater;
+		throw;
+	}
+	sceneUpdater = originalSceneUpdater;
+
+	if(!success) {
+		LOG(ERROR) << "JSONDeserializer: RSGUpdateBatch contains malformed updates. Discarding it.";
+		return false;
+	}
+	LOG(DEBUG) << "JSONDeserializer: Applying batch with " << batch.getNumberOfUpdates() << " updates.";
+	return sceneUpdater->applyUpdateBatch(batch);
+}
+
 bool JSONDeserializer::handleWorldModelUpdate(libvariant::Variant& model) {
 
 	if(model.Contains("operation")) {
@@ -195,13 +315,7 @@ bool JSONDeserializer::handleWorldModelUpdate(libvariant::Variant& model) {
 			AttributeUpdateMode updateMode = OVERWRITE; // default
 			if(model.Contains("updateMode")) {
 				string updateModeModel = model.Get("updateMode").AsString();
-				if(updateModeModel.compare("OVERWRITE") == 0) {
-					 updateMode = OVERWRITE;
-				} else if(updateModeModel.compare("UPDATE") == 0) {
-					 updateMode = UPDATE;
-				} else if(updateModeModel.compare("APPEND") == 0) {
-					 updateMode = APPEND;
-				} else {
+				if(!toAttributeUpdateMode(updateModeModel, updateMode)) {
 					LOG(ERROR) << "JSONDeserializer: world model update for SET_ATTRIBUTES defines an unknown updateMode: " << updateModeModel;
 					return false;
 				}
@@ -466,14 +580,23 @@ bool JSONDeserializer::doAddNode(libvariant::Variant& group, rsg::Id parentId) {
 	/* attributes */
 	std::vector<rsg::Attribute> attributes = rsg::JSONTypecaster::getAttributesFromJSON(group);
 
+	rsg::TimeStamp attributesTimeStamp;
+	string stampTag = "attributesTimeStamp";
+	bool hasAttributesTimeStamp = group.Contains(stampTag);
+	if(hasAttributesTimeStamp) {
+		attributesTimeStamp = rsg::JSONTypecaster::getTimeStampFromJSON(group, stampTag);
+	}
+
+	return applyAddNode(parentId, id, attributes, hasAttributesTimeStamp, attributesTimeStamp);
+}
+
+bool JSONDeserializer::applyAddNode(rsg::Id parentId, rsg::Id& id, std::vector<rsg::Attribute>& attributes, bool hasAttributesTimeStamp, rsg::TimeStamp attributesTimeStamp) {
+
 	/* create it */
 	bool success1 = sceneUpdater->addNode(parentId, id, attributes, !id.isNil()); // Last parameter makes the "id" field optional
 	LOG(DEBUG) << "JSONDeserializer::doAddNode creation success = " << success1;
 	if(!success1) { // since we cannot create it we still try to update its attributes - they can change dynamically
-		rsg::TimeStamp attributesTimeStamp;
-		string stampTag = "attributesTimeStamp";
-		if(group.Contains(stampTag)) {
-			attributesTimeStamp = rsg::JSONTypecaster::getTimeStampFromJSON(group, stampTag);
+		if(hasAttributesTimeStamp) {
 			if(attributesTimeStamp > TimeStamp(0)) { // discard invalid stamps
 				bool attributeUpdateSuccess  = sceneUpdater->setNodeAttributes(id, attributes, attributesTimeStamp);
 				LOG(DEBUG) << "JSONDeserializer::doAddNode attribute update success = " << attributeUpdateSuccess;
@@ -499,14 +622,33 @@ bool JSONDeserializer::doAddGroup(libvariant::Variant& group, rsg::Id parentId)
 	/* attributes */
 	std::vector<rsg::Attribute> attributes = rsg::JSONTypecaster::getAttributesFromJSON(group);
 
+	rsg::TimeStamp attributesTimeStamp;
+	string stampTag = "attributesTimeStamp";
+	bool hasAttributesTimeStamp = group.Contains(stampTag);
+	if(hasAttributesTimeStamp) {
+		attributesTimeStamp = rsg::JSONTypecaster::getTimeStampFromJSON(group, stampTag);
+	}
+
+	if(!applyAddGroup(parentId, id, attributes, hasAttributesTimeStamp, attributesTimeStamp)) {
+		return false; // exit to prevent below recursion
+	}
+
+	/* childs (recursion) */
+	handleChilden(group, id);
+
+	/* connecitons that are containded in this group */
+	handleConnections(group, id);
+
+	return true;
+}
+
+bool JSONDeserializer::applyAddGroup(rsg::Id parentId, rsg::Id& id, std::vector<rsg::Attribute>& attributes, bool hasAttributesTimeStamp, rsg::TimeStamp attributesTimeStamp) {
+
 	/* create it */
 	bool success = sceneUpdater->addGroup(parentId, id, attributes, !id.isNil()); // Last parameter makes the "id" field optional
 	LOG(DEBUG) << "JSONDeserializer::doAddGroup creation success = " << success;
 	if(!success) { // since we cannot create it we still try to update its attributes - they can change dynamically
-		rsg::TimeStamp attributesTimeStamp;
-		string stampTag = "attributesTimeStamp";
-		if(group.Contains(stampTag)) {
-			attributesTimeStamp = rsg::JSONTypecaster::getTimeStampFromJSON(group, stampTag);
+		if(hasAttributesTimeStamp) {
 			if(attributesTimeStamp > TimeStamp(0)) { // discard invalid stamps
 				bool attributeUpdateSuccess = sceneUpdater->setNodeAttributes(id, attributes, attributesTimeStamp);
 				LOG(DEBUG) << "JSONDeserializer::doAddGroup attribute update success = " << attributeUpdateSuccess;
@@ -514,16 +656,9 @@ bool JSONDeserializer::doAddGroup(libvariant::Variant& group, rsg::Id parentId)
 		} else {
 			LOG(WARNING) << "JSONDeserializer::doAddGroup has no attribute time stamp that can be used to apply an update.";
 		}
-		return false; // exit to prevent below recursion
+		return false;
 	}
 
-
-	/* childs (recursion) */
-	handleChilden(group, id);
-
-	/* connecitons that are containded in this group */
-	handleConnections(group, id);
-
 	return true;
 }
 
@@ -552,7 +687,7 @@ bool JSONDeserializer::doAddTransformNode(libvariant::Variant& group,
 //	rsg::TimeStamp end = JSONTypecaster::getTimeStampFromJSON(connection, "end");
 
 	/* transform data */
-	HomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44());
+	HomogeneousMatrix44::IHomogeneousMatrix44Ptr transform; // will point to the pooled matrix from the history
 
 	TemporalCache<IHomogeneousMatrix44::IHomogeneousMatrix44Ptr> history;
 	JSONTypecaster::getTransformCacheFromJSON(history, group);
@@ -753,7 +888,18 @@ bool JSONDeserializer::doSetNodeAttributes(libvariant::Variant& group, Attribute
 	/* attributes */
 	std::vector<rsg::Attribute> attributes = rsg::JSONTypecaster::getAttributesFromJSON(group);
 
+	/* time stamp with fall back to current time */
+	rsg::TimeStamp attributesTimeStamp;
+	string stampTag = "attributesTimeStamp";
+	bool hasAttributesTimeStamp = group.Contains(stampTag);
+	if(hasAttributesTimeStamp) {
+		attributesTimeStamp = rsg::JSONTypecaster::getTimeStampFromJSON(group, stampTag);
+	}
+
+	return applySetNodeAttributes(id, attributes, updateMode, hasAttributesTimeStamp, attributesTimeStamp);
+}
 
+bool JSONDeserializer::applySetNodeAttributes(rsg::Id id, std::vector<rsg::Attribute>& attributes, AttributeUpdateMode updateMode, bool hasAttributesTimeStamp, rsg::TimeStamp attributesTimeStamp) {
 
 	/*
 	 * There are three different updateModes. Id the values is not the, OVERWRITE is assumed.
@@ -822,18 +968,11 @@ bool JSONDeserializer::doSetNodeAttributes(libvariant::Variant& group, Attribute
 	}
 
 
-	/* time stamp with fall back to current time */
-	rsg::TimeStamp attributesTimeStamp;
-	string stampTag = "attributesTimeStamp";
-	if(group.Contains(stampTag)) {
-		attributesTimeStamp = rsg::JSONTypecaster::getTimeStampFromJSON(group, stampTag);
-	} else {
+	if(!hasAttributesTimeStamp) {
 		attributesTimeStamp = wm->now();
 	}
 
 	return sceneUpdater->setNodeAttributes(id, attributes, attributesTimeStamp);
-
-	return false;
 }
 
 bool JSONDeserializer::doSetTransform(libvariant::Variant& group) {
@@ -848,8 +987,14 @@ bool JSONDeserializer::doSetTransform(libvariant::Variant& group) {
 		return false;
 	}
 
+	/* stream encoded transform data */
+	TransformStreamSample sample;
+	if (JSONTypecaster::getTransformStreamSampleFromJSON(sample, group)) {
+		return applyTransformStreamSample(id, sample);
+	}
+
 	/* transform data */
-	HomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44());
+	HomogeneousMatrix44::IHomogeneousMatrix44Ptr transform; // will point to the pooled matrix from the history
 
 	TemporalCache<IHomogeneousMatrix44::IHomogeneousMatrix44Ptr> history;
 	JSONTypecaster::getTransformCacheFromJSON(history, group);
@@ -862,6 +1007,15 @@ bool JSONDeserializer::doSetTransform(libvariant::Variant& group) {
 
 }
 
+bool JSONDeserializer::applyTransformStreamSample(rsg::Id id, const TransformStreamSample& sample) {
+	HomogeneousMatrix44::IHomogeneousMatrix44Ptr transform = SceneGraphAllocator::createTransformMatrix();
+	TimeStamp timeStamp;
+	if (!transformStreamDecoder.decode(id, sample, transform, timeStamp)) {
+		return false;
+	}
+	return sceneUpdater->setTransform(id, transform, timeStamp);
+}
+
 bool JSONDeserializer::doDeleteNode(libvariant::Variant& group) {
 
 	/* Id */
@@ -870,6 +1024,7 @@ bool JSONDeserializer::doDeleteNode(libvariant::Variant& group) {
 		LOG(ERROR) << "JSONDeserializer: world model update does not contain an id for a doDeleteNode operation.";
 		return false;
 	}
+	transformStreamDecoder.reset(id);
 
 	return sceneUpdater->deleteNode(id);
 }
@@ -23,6 +23,8 @@
 #include "brics_3d/util/JSONTypecaster.h"
 #include "brics_3d/worldModel/WorldModel.h"
 #include "brics_3d/worldModel/sceneGraph/IPort.h"
+#include "brics_3d/worldModel/sceneGraph/SceneGraphUpdateBatch.h"
+#include "brics_3d/worldModel/sceneGraph/JSONFastPathParser.h"
 
 namespace brics_3d {
 namespace rsg {
@@ -64,9 +66,31 @@ public:
 
 	static Id getRootIdFromJSONModel(std::string data);
 
+	bool getUseFastPath() const {
+		return useFastPath;
+	}
+
+	/**
+	 * @brief Process the most frequent messages with the JSONFastPathParser instead of a libvariant::Variant tree.
+	 * Only applies to the write() functions for character buffers and strings. Default is true.
+	 */
+	void setUseFastPath(bool useFastPath) {
+		this->useFastPath = useFastPath;
+	}
+
+	/// Number of messages that have been processed by the fast path so far.
+	unsigned long getFastPathMessageCount() const {
+		return fastPathMessageCount;
+	}
+
 private:
 
+	/// Returns false if the message is not supported by the fast path. Otherwise result is the return value for write().
+	bool handleFastPath(const char *dataBuffer, int dataLength, int& result);
+	static bool toAttributeUpdateMode(const std::string& updateModeModel, AttributeUpdateMode& updateMode);
+
 	virtual bool handleWorldModelUpdate(libvariant::Variant& model);
+	virtual bool handleWorldModelUpdateBatch(libvariant::Variant& model);
 	virtual bool handleWorldModelAgent(libvariant::Variant& model);
 	virtual bool handleGraphPrimitive(libvariant::Variant& atom, rsg::Id parentId);
 	virtual bool handleChilden(libvariant::Variant& group, rsg::Id parentId);
@@ -84,10 +108,24 @@ private:
 	virtual bool doAddParent(libvariant::Variant& group, rsg::Id parentId);
 	virtual bool doRemoveParent(libvariant::Variant& group, rsg::Id parentId);
 
+	/* shared by the generic and the fast path */
+	bool applyAddNode(rsg::Id parentId, rsg::Id& id, std::vector<rsg::Attribute>& attributes, bool hasAttributesTimeStamp, rsg::TimeStamp attributesTimeStamp);
+	bool applyAddGroup(rsg::Id parentId, rsg::Id& id, std::vector<rsg::Attribute>& attributes, bool hasAttributesTimeStamp, rsg::TimeStamp attributesTimeStamp);
+	bool applySetNodeAttributes(rsg::Id id, std::vector<rsg::Attribute>& attributes, AttributeUpdateMode updateMode, bool hasAttributesTimeStamp, rsg::TimeStamp attributesTimeStamp);
+	bool applyTransformStreamSample(rsg::Id id, const TransformStreamSample& sample);
+
 	WorldModel* wm;
 	ISceneGraphUpdate* sceneUpdater;
 	bool mapUnknownParentIdsToRootId;
 
+	/// Reconstructs transforms that have been sent with JSONSerializer::setUseTransformStreamEncoding().
+	TransformStreamDecoder transformStreamDecoder;
+
+	bool useFastPath;
+	JSONFastPathParser fastPathParser;
+	JSONFastPathParser::Update fastPathUpdate;
+	unsigned long fastPathMessageCount;
+
 };
 
 } /* namespace rsg */
@@ -0,0 +1,507 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#include "JSONFastPathParser.h"
+#include "brics_3d/util/JSONTypecaster.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace brics_3d {
+namespace rsg {
+
+/// Maximum nesting of skipped values. Deeper messages are left to the generic path.
+static const int maxSkipDepth = 64;
+
+void JSONFastPathParser::Update::clear() {
+	operation = UNSUPPORTED;
+	parentId = Id();
+	id = Id();
+	attributes.clear();
+	hasAttributesTimeStamp = false;
+	updateMode.clear();
+	hasTransformStreamSample = false;
+}
+
+JSONFastPathParser::JSONFastPathParser() : cursor(0), end(0) {
+
+}
+
+JSONFastPathParser::~JSONFastPathParser() {
+
+}
+
+bool JSONFastPathParser::parse(const char* dataBuffer, int dataLength, Update& update) {
+	cursor = dataBuffer;
+	end = dataBuffer + dataLength;
+	update.clear();
+
+	NodeInfo node;
+	node.hasNode = false;
+	node.isGeometricNode = false;
+	node.hasChildsOrConnections = false;
+	node.hasHistory = false;
+	std::string worldModelType;
+	std::string operation;
+	bool hasParentId = false;
+
+	/* top level */
+	if (!consume('{')) {
+		return false;
+	}
+	if (!consume('}')) {
+		do {
+			if (!parseString(key) || !consume(':')) {
+				return false;
+			}
+			if (key.compare("@worldmodeltype") == 0) {
+				if (!parseString(worldModelType)) return false;
+			} else if (key.compare("operation") == 0) {
+				if (!parseString(operation)) return false;
+			} else if (key.compare("parentId") == 0) {
+				if (!parseId(update.parentId)) return false;
+				hasParentId = true;
+			} else if (key.compare("updateMode") == 0) {
+				if (!parseString(update.updateMode)) return false;
+			} else if (key.compare("node") == 0) {
+				if (!parseNode(update, node)) return false;
+			} else if (key.compare("@graphtype") == 0) {
+				return false; // the generic path additionally handles it as graph primitive
+			} else if (!skipValue()) {
+				return false;
+			}
+		} while (consume(','));
+		if (!consume('}')) {
+			return false;
+		}
+	}
+
+	/* only trailing whitespace or string terminators are allowed */
+	skipWhitespace();
+	while (cursor < end && *cursor == '\0') {
+		++cursor;
+	}
+	if (cursor != end) {
+		return false;
+	}
+
+	/* decide on the operation */
+	if (worldModelType.compare("RSGUpdate") != 0 || !node.hasNode) {
+		return false;
+	}
+
+	if (operation.compare("CREATE") == 0) {
+		if (!hasParentId || update.parentId.isNil()) {
+			return false;
+		}
+		if (node.graphType.compare("Node") == 0 && !node.isGeometricNode) {
+			update.operation = CREATE_NODE;
+		} else if (node.graphType.compare("Group") == 0 && !node.hasChildsOrConnections) {
+			update.operation = CREATE_GROUP;
+		}
+	} else if (operation.compare("UPDATE_ATTRIBUTES") == 0) {
+		if (!update.id.isNil()) {
+			update.operation = UPDATE_ATTRIBUTES;
+		}
+	} else if (operation.compare("UPDATE_TRANSFORM") == 0) {
+		if (!update.id.isNil() && (update.hasTransformStreamSample || node.hasHistory)) {
+			update.operation = UPDATE_TRANSFORM;
+		}
+	}
+
+	return update.operation != UNSUPPORTED;
+}
+
+void JSONFastPathParser::skipWhitespace() {
+	while (cursor < end && (*cursor == ' ' || *cursor == '\n' || *cursor == '\r' || *cursor == '\t')) {
+		++cursor;
+	}
+}
+
+bool JSONFastPathParser::consume(char c) {
+	skipWhitespace();
+	if (cursor < end && *cursor == c) {
+		++cursor;
+		return true;
+	}
+	return false;
+}
+
+bool JSONFastPathParser::parseString(std::string& result) {
+	if (!consume('"')) {
+		return false;
+	}
+	result.clear();
+
+	while (cursor < end) {
+		/* copy plain characters in one go */
+		const char* start = cursor;
+		while (cursor < end && *cursor != '"' && *cursor != '\\' && static_cast<unsigned char>(*cursor) >= 0x20) {
+			++cursor;
+		}
+		result.append(start, cursor - start);
+		if (cursor >= end) {
+			return false;
+		}
+
+		char c = *cursor++;
+		if (c == '"') {
+			return true;
+		} else if (c == '\\') {
+			if (cursor >= end) {
+				return false;
+			}
+			switch (*cursor++) {
+			case '"': result.push_back('"'); break;
+			case '\\': result.push_back('\\'); break;
+			case '/': result.push_back('/'); break;
+			case 'b': result.push_back('\b'); break;
+			case 'f': result.push_back('\f'); break;
+			case 'n': result.push_back('\n'); break;
+			case 'r': result.push_back('\r'); break;
+			case 't': result.push_back('\t'); break;
+			default: return false; // including \u escapes, that are left to the generic path
+			}
+		} else {
+			return false; // control characters are not allowed in JSON strings
+		}
+	}
+
+	return false;
+}
+
+bool JSONFastPathParser::parseNumber(double& result) {
+	skipWhitespace();
+	char buffer[64];
+	int length = 0;
+	while (cursor < end && length < static_cast<int>(sizeof(buffer)) - 1 &&
+			((*cursor >= '0' && *cursor <= '9') || *cursor == '-' || *cursor == '+' || *cursor == '.' || *cursor == 'e' || *cursor == 'E')) {
+		buffer[length++] = *cursor++;
+	}
+	if (length == 0) {
+		return false;
+	}
+	buffer[length] = '\0';
+
+	char* numberEnd = 0;
+	result = strtod(buffer, &numberEnd);
+	return numberEnd == buffer + length;
+}
+
+bool JSONFastPathParser::parseId(Id& id) {
+	return parseString(value) && id.fromString(value);
+}
+
+bool JSONFastPathParser::skipValue(int depth) {
+	if (depth > maxSkipDepth) {
+		return false;
+	}
+
+	skipWhitespace();
+	if (cursor >= end) {
+		return false;
+	}
+
+	switch (*cursor) {
+	case '"':
+		return parseString(value);
+
+	case '{':
+		++cursor;
+		if (consume('}')) {
+			return true;
+		}
+		do {
+			if (!parseString(value) || !consume(':') || !skipValue(depth + 1)) {
+				return false;
+			}
+		} while (consume(','));
+		return consume('}');
+
+	case '[':
+		++cursor;
+		if (consume(']')) {
+			return true;
+		}
+		do {
+			if (!skipValue(depth + 1)) {
+				return false;
+			}
+		} while (consume(','));
+		return consume(']');
+
+	case 't':
+		if (end - cursor >= 4 && strncmp(cursor, "true", 4) == 0) { cursor += 4; return true; }
+		return false;
+
+	case 'f':
+		if (end - cursor >= 5 && strncmp(cursor, "false", 5) == 0) { cursor += 5; return true; }
+		return false;
+
+	case 'n':
+		if (end - cursor >= 4 && strncmp(cursor, "null", 4) == 0) { cursor += 4; return true; }
+		return false;
+
+	default:
+		double number;
+		return parseNumber(number);
+	}
+}
+
+bool JSONFastPathParser::parseNode(Update& update, NodeInfo& node) {
+	if (!consume('{')) {
+		return false;
+	}
+	node.hasNode = true;
+	if (consume('}')) {
+		return true;
+	}
+
+	do {
+		if (!parseString(key) || !consume(':')) {
+			return false;
+		}
+		if (key.compare("@graphtype") == 0) {
+			if (!parseString(node.graphType)) return false;
+		} else if (key.compare("@semanticContext") == 0) {
+			if (!parseString(value)) return false;
+			node.isGeometricNode = (value.compare("GeometricNode") == 0);
+		} else if (key.compare("id") == 0) {
+			if (!parseId(update.id)) return false;
+		} else if (key.compare("attributes") == 0) {
+			if (!parseAttributes(update.attributes)) return false;
+		} else if (key.compare("attributesTimeStamp") == 0) {
+			if (!parseTimeStamp(update.attributesTimeStamp)) return false;
+			update.hasAttributesTimeStamp = true;
+		} else if (key.compare("history") == 0) {
+			if (!parseHistory(update)) return false;
+			node.hasHistory = true;
+		} else if (key.compare("transformStream") == 0) {
+			if (!parseTransformStream(update)) return false;
+		} else if (key.compare("childs") == 0 || key.compare("connections") == 0) {
+			node.hasChildsOrConnections = true;
+			if (!skipValue()) return false;
+		} else if (!skipValue()) {
+			return false;
+		}
+	} while (consume(','));
+
+	return consume('}');
+}
+
+bool JSONFastPathParser::parseAttributes(std::vector<Attribute>& attributes) {
+	if (!consume('[')) {
+		return false;
+	}
+	if (consume(']')) {
+		return true;
+	}
+
+	do {
+		if (!consume('{')) {
+			return false;
+		}
+		bool hasKey = false;
+		bool hasValue = false;
+		if (!consume('}')) {
+			do {
+				if (!parseString(key) || !consume(':')) {
+					return false;
+				}
+				if (key.compare("key") == 0) {
+					if (!parseString(attributeKey)) return false;
+					hasKey = true;
+				} else if (key.compare("value") == 0) {
+					if (!parseString(attributeValue)) return false; // complex values are serialized by the generic path
+					hasValue = true;
+				} else if (!skipValue()) {
+					return false;
+				}
+			} while (consume(','));
+			if (!consume('}')) {
+				return false;
+			}
+		}
+		if (!hasKey || !hasValue) {
+			return false;
+		}
+		attributes.push_back(Attribute(attributeKey, attributeValue));
+	} while (consume(','));
+
+	return consume(']');
+}
+
+bool JSONFastPathParser::parseTimeStamp(TimeStamp& timeStamp) {
+	if (!consume('{')) {
+		return false;
+	}
+	bool isUTCms = false;
+	bool hasStamp = false;
+	double stamp = 0;
+	if (!consume('}')) {
+		do {
+			if (!parseString(key) || !consume(':')) {
+				return false;
+			}
+			if (key.compare("@stamptype") == 0) {
+				if (!parseString(value)) return false;
+				isUTCms = (value.compare("TimeStampUTCms") == 0);
+			} else if (key.compare("stamp") == 0) {
+				if (!parseNumber(stamp)) return false;
+				hasStamp = true;
+			} else if (!skipValue()) {
+				return false;
+			}
+		} while (consume(','));
+		if (!consume('}')) {
+			return false;
+		}
+	}
+	if (!isUTCms || !hasStamp) {
+		return false;
+	}
+
+	timeStamp = TimeStamp(stamp, Units::MilliSecond);
+	return true;
+}
+
+bool JSONFastPathParser::parseHistory(Update& update) {
+	if (!consume('[') || !consume('{')) { // exactly one entry
+		return false;
+	}
+
+	bool hasStamp = false;
+	bool hasTransform = false;
+	if (!consume('}')) {
+		do {
+			if (!parseString(key) || !consume(':')) {
+				return false;
+			}
+			if (key.compare("stamp") == 0) {
+				if (!parseTimeStamp(update.transformTimeStamp)) return false;
+				hasStamp = true;
+			} else if (key.compare("transform") == 0) {
+				if (!parseTransform(update)) return false;
+				hasTransform = true;
+			} else if (!skipValue()) {
+				return false;
+			}
+		} while (consume(','));
+		if (!consume('}')) {
+			return false;
+		}
+	}
+
+	return hasStamp && hasTransform && !(update.transformTimeStamp < TimeStamp(0.0)) && consume(']');
+}
+
+bool JSONFastPathParser::parseTransform(Update& update) {
+	if (!consume('{')) {
+		return false;
+	}
+	bool isHomogeneousMatrix44 = false;
+	bool hasMatrix = false;
+	if (!consume('}')) {
+		do {
+			if (!parseString(key) || !consume(':')) {
+				return false;
+			}
+			if (key.compare("type") == 0) {
+				if (!parseString(value)) return false;
+				isHomogeneousMatrix44 = (value.compare("HomogeneousMatrix44") == 0);
+			} else if (key.compare("matrix") == 0) {
+
+				/* exactly 4 rows with 4 values each; the last row is implicitly 0 0 0 1 */
+				if (!consume('[')) return false;
+				for (int row = 0; row < 4; ++row) {
+					if ((row > 0 && !consume(',')) || !consume('[')) return false;
+					for (int column = 0; column < 4; ++column) {
+						double coefficient;
+						if ((column > 0 && !consume(',')) || !parseNumber(coefficient)) return false;
+						if (row < 3 && column < 3) {
+							update.rotation[row * 3 + column] = coefficient;
+						} else if (row < 3) {
+							update.translation[row] = coefficient;
+						}
+					}
+					if (!consume(']')) return false;
+				}
+				if (!consume(']')) return false;
+				hasMatrix = true;
+
+			} else if (!skipValue()) {
+				return false;
+			}
+		} while (consume(','));
+		if (!consume('}')) {
+			return false;
+		}
+	}
+
+	return isHomogeneousMatrix44 && hasMatrix;
+}
+
+bool JSONFastPathParser::parseTransformStream(Update& update) {
+	if (!consume('{')) {
+		return false;
+	}
+	bool hasSequence = false;
+	bool hasKeyframe = false;
+	bool hasDelta = false;
+	std::string keyframe;
+	std::string delta;
+	if (!consume('}')) {
+		do {
+			if (!parseString(key) || !consume(':')) {
+				return false;
+			}
+			if (key.compare("sequence") == 0) {
+				double sequence;
+				if (!parseNumber(sequence) || sequence < 0) return false;
+				update.transformStreamSample.sequence = static_cast<boost::uint32_t>(sequence);
+				hasSequence = true;
+			} else if (key.compare("keyframe") == 0) {
+				if (!parseString(keyframe)) return false;
+				hasKeyframe = true;
+			} else if (key.compare("delta") == 0) {
+				if (!parseString(delta)) return false;
+				hasDelta = true;
+			} else if (!skipValue()) {
+				return false;
+			}
+		} while (consume(','));
+		if (!consume('}')) {
+			return false;
+		}
+	}
+
+	/* keyframes take precedence, as in JSONTypecaster::getTransformStreamSampleFromJSON */
+	if (!hasSequence || !(hasKeyframe || hasDelta) ||
+			!JSONTypecaster::decodeTransformStreamSample(hasKeyframe ? keyframe : delta, hasKeyframe, update.transformStreamSample)) {
+		return false;
+	}
+	update.hasTransformStreamSample = true;
+
+	return true;
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
@@ -0,0 +1,134 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#ifndef RSG_JSONFASTPATHPARSER_H_
+#define RSG_JSONFASTPATHPARSER_H_
+
+#include "brics_3d/worldModel/sceneGraph/Id.h"
+#include "brics_3d/worldModel/sceneGraph/Attribute.h"
+#include "brics_3d/worldModel/sceneGraph/TimeStamp.h"
+#include "brics_3d/worldModel/sceneGraph/TransformStreamCodec.h"
+#include <vector>
+#include <string>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Single pass parser for the most frequent "RSGUpdate" messages.
+ * @ingroup sceneGraph
+ *
+ * The generic path of the JSONDeserializer parses a message into a libvariant::Variant
+ * tree and then evaluates it with the JSONTypecaster. For high update rates this dominates
+ * the ingest time. This parser reads the character buffer directly, without any intermediate
+ * tree, into a flat Update. It supports:
+ *  - CREATE of a plain Node, or of a Group without "childs" and "connections",
+ *  - UPDATE_ATTRIBUTES,
+ *  - UPDATE_TRANSFORM with a "history" of one HomogeneousMatrix44 or a "transformStream".
+ *
+ * For any other message, or anything the generic path treats in a special way (e.g. non-string
+ * attribute values, "TimeStampDate" stamps or escaped unicode characters), parse() returns false
+ * and the message has to be processed by the generic path. So the result is the same
+ * for both paths.
+ */
+class JSONFastPathParser {
+public:
+
+	enum Operation {
+		UNSUPPORTED,
+		CREATE_NODE,
+		CREATE_GROUP,
+		UPDATE_ATTRIBUTES,
+		UPDATE_TRANSFORM
+	};
+
+	/// Content of a parsed message. Can be reused for multiple messages to avoid allocations.
+	struct Update {
+		Operation operation;
+		Id parentId;
+		Id id;
+		std::vector<Attribute> attributes;
+		bool hasAttributesTimeStamp;
+		TimeStamp attributesTimeStamp;
+		std::string updateMode; ///< empty if not specified
+
+		/* UPDATE_TRANSFORM */
+		bool hasTransformStreamSample;
+		TransformStreamSample transformStreamSample;
+		double rotation[9];   ///< row-major
+		double translation[3];
+		TimeStamp transformTimeStamp;
+
+		void clear();
+	};
+
+	JSONFastPathParser();
+	virtual ~JSONFastPathParser();
+
+	/**
+	 * @brief Parse a message.
+	 * @return True if the message is supported by the fast path. The content is then stored in update.
+	 */
+	bool parse(const char* dataBuffer, int dataLength, Update& update);
+
+private:
+
+	/* node level information, that is only required to decide on the operation */
+	struct NodeInfo {
+		bool hasNode;
+		std::string graphType;
+		bool isGeometricNode;
+		bool hasChildsOrConnections;
+		bool hasHistory;
+	};
+
+	void skipWhitespace();
+
+	/// Skip whitespace and consume c if it is the next character.
+	bool consume(char c);
+
+	bool parseString(std::string& result);
+	bool parseNumber(double& result);
+	bool parseId(Id& id);
+	bool skipValue(int depth = 0);
+
+	bool parseNode(Update& update, NodeInfo& node);
+	bool parseAttributes(std::vector<Attribute>& attributes);
+	bool parseTimeStamp(TimeStamp& timeStamp);
+	bool parseHistory(Update& update);
+	bool parseTransform(Update& update);
+	bool parseTransformStream(Update& update);
+
+	const char* cursor;
+	const char* end;
+
+	/* buffers that are reused between messages */
+	std::string key;
+	std::string value;
+	std::string attributeKey;
+	std::string attributeValue;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_JSONFASTPATHPARSER_H_ */
+
+/* EOF */
@@ -0,0 +1,164 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#include "JSONGeometryStreamWriter.h"
+
+namespace brics_3d {
+namespace rsg {
+
+JSONGeometryStreamWriter::JSONGeometryStreamWriter(IOutputPort* port, unsigned int pointsPerChunk) :
+		port(port), pointCloudBinaryBlobThreshold(JSONTypecaster::defaultPointCloudBinaryBlobThreshold),
+		useSinglePrecision(false), numberOfChunks(0) {
+	setPointsPerChunk(pointsPerChunk);
+}
+
+JSONGeometryStreamWriter::~JSONGeometryStreamWriter() {
+
+}
+
+void JSONGeometryStreamWriter::setPointsPerChunk(unsigned int pointsPerChunk) {
+	if (pointsPerChunk == 0) {
+		pointsPerChunk = 1;
+	}
+	this->pointsPerChunk = (pointsPerChunk + 2) / 3 * 3; // 3 points always encode to a multiple of 3 bytes
+}
+
+bool JSONGeometryStreamWriter::write(Shape::ShapePtr& shape, libvariant::Variant& model, std::string shapeTag) {
+	numberOfChunks = 0;
+	if (port == 0) {
+		LOG(ERROR) << "JSONGeometryStreamWriter: No output port specified.";
+		return false;
+	}
+	if (shape == 0) {
+		LOG(ERROR) << "JSONGeometryStreamWriter: No shape specified.";
+		return false;
+	}
+
+	/* Only count the points, the iterator does not know the size */
+	IPoint3DIterator::IPoint3DIteratorPtr it = shape->getPointCloudIterator();
+	size_t numberOfPoints = 0;
+	bool isColored = false;
+	if (it != 0) {
+		for (it->begin(); !it->end(); it->next()) {
+			if (!isColored && it->getRawData()->asColoredPoint3D() != 0) {
+				isColored = true;
+			}
+			numberOfPoints++;
+		}
+	}
+
+	if (it != 0 && numberOfPoints >= pointCloudBinaryBlobThreshold) {
+		return writePointCloud(it, numberOfPoints, isColored, model, shapeTag);
+	}
+
+	/* Small enough to go the regular way */
+	libvariant::Variant completeModel;
+	if (model.IsMap()) {
+		for (libvariant::Variant::MapIterator i(model.MapBegin()), e(model.MapEnd()); i != e; ++i) {
+			completeModel.Set(i->first, i->second);
+		}
+	}
+	bool success = JSONTypecaster::addShapeToJSON(shape, completeModel, shapeTag, pointCloudBinaryBlobThreshold, useSinglePrecision);
+	success &= writeChunk(libvariant::Serialize(completeModel, libvariant::SERIALIZE_JSON)); // the model is completed even without a shape
+	return success;
+}
+
+bool JSONGeometryStreamWriter::writePointCloud(IPoint3DIterator::IPoint3DIteratorPtr it, size_t numberOfPoints, bool isColored,
+		libvariant::Variant& model, std::string& shapeTag) {
+
+	/* Everything up to the data string */
+	std::string modelAsJson = libvariant::Serialize(model, libvariant::SERIALIZE_JSON);
+	size_t modelEnd = modelAsJson.rfind('}');
+	if (!model.IsMap() || modelEnd == std::string::npos) {
+		LOG(ERROR) << "JSONGeometryStreamWriter: The model to be extended is not a JSON object.";
+		return false;
+	}
+	std::stringstream header;
+	header << modelAsJson.substr(0, modelEnd) << (model.Size() > 0 ? ", " : "")
+			<< "\"" << shapeTag << "\": {"
+			<< "\"@geometrytype\": \"PointCloud3DBinaryBlob\", "
+			<< "\"@pointtype\": \"" << (isColored ? "ColoredPoint3D" : "Point3D") << "\", "
+			<< "\"numberOfPoints\": " << numberOfPoints << ", "
+			<< "\"precision\": \"" << (useSinglePrecision ? "float32" : "float64") << "\", "
+			<< "\"data\": \"";
+	chunk = header.str();
+
+	/* Same layout as JSONTypecaster::addPointCloudToJSON() */
+	const size_t valueSize = useSinglePrecision ? 4 : 8;
+	const size_t stride = 3 * valueSize + (isColored ? 3 : 0);
+	blob.resize(pointsPerChunk * stride);
+	size_t pointsInChunk = 0;
+	size_t writtenPoints = 0;
+	for (it->begin(); !it->end() && writtenPoints < numberOfPoints; it->next()) {
+		char* data = &blob[pointsInChunk * stride];
+		if (useSinglePrecision) {
+			BinaryTypecaster::writeFloat(static_cast<float>(it->getX()), data);
+			BinaryTypecaster::writeFloat(static_cast<float>(it->getY()), data + valueSize);
+			BinaryTypecaster::writeFloat(static_cast<float>(it->getZ()), data + 2 * valueSize);
+		} else {
+			BinaryTypecaster::writeDouble(it->getX(), data);
+			BinaryTypecaster::writeDouble(it->getY(), data + valueSize);
+			BinaryTypecaster::writeDouble(it->getZ(), data + 2 * valueSize);
+		}
+		if (isColored) {
+			ColoredPoint3D* coloredPoint = it->getRawData()->asColoredPoint3D();
+			data[3 * valueSize] = static_cast<char>(coloredPoint != 0 ? coloredPoint->getR() : 0);
+			data[3 * valueSize + 1] = static_cast<char>(coloredPoint != 0 ? coloredPoint->getG() : 0);
+			data[3 * valueSize + 2] = static_cast<char>(coloredPoint != 0 ? coloredPoint->getB() : 0);
+		}
+		pointsInChunk++;
+		writtenPoints++;
+
+		if (pointsInChunk == pointsPerChunk && writtenPoints < numberOfPoints) {
+			JSONTypecaster::encodeBase64(blob, encodedBlob);
+			chunk.append(encodedBlob);
+			if (!writeChunk(chunk)) {
+				return false;
+			}
+			chunk.clear();
+			pointsInChunk = 0;
+		}
+	}
+
+	if (writtenPoints != numberOfPoints) {
+		LOG(ERROR) << "JSONGeometryStreamWriter: The point cloud has changed while it was written.";
+		return false;
+	}
+
+	/* Last (possibly padded) chunk together with the end of the model */
+	blob.resize(pointsInChunk * stride);
+	JSONTypecaster::encodeBase64(blob, encodedBlob);
+	chunk.append(encodedBlob);
+	chunk.append("\"}}");
+	return writeChunk(chunk);
+}
+
+bool JSONGeometryStreamWriter::writeChunk(const std::string& chunk) {
+	int transferredBytes = 0;
+	int returnValue = port->write(chunk.c_str(), chunk.size(), transferredBytes);
+	numberOfChunks++;
+	LOG(DEBUG) << "JSONGeometryStreamWriter: \t" << transferredBytes << " bytes transferred of chunk with " << chunk.size() << " bytes.";
+	return (returnValue >= 0);
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
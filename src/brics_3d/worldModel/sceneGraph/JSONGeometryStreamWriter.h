@@ -0,0 +1,115 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#ifndef RSG_JSONGEOMETRYSTREAMWRITER_H_
+#define RSG_JSONGEOMETRYSTREAMWRITER_H_
+
+#include "brics_3d/util/JSONTypecaster.h"
+#include "brics_3d/worldModel/sceneGraph/IPort.h"
+#include <string>
+#include <vector>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Writes a JSON model with a geometry to an output port without building the complete model in memory.
+ * @ingroup sceneGraph
+ *
+ * The JSONTypecaster encodes a point cloud as one base64 string inside a libvariant::Variant tree
+ * that is serialized afterwards. For large point clouds the whole result exists multiple
+ * times in memory before the first byte is sent. This writer emits the same "PointCloud3DBinaryBlob"
+ * encoding as JSONTypecaster::addPointCloudToJSON() in chunks of a fixed number of points.
+ * Each chunk is written to the output port as soon as it is encoded, so memory usage is bounded
+ * by the chunk size. The concatenation of all chunks is one JSON model that is equivalent
+ * to the one of JSONTypecaster::addShapeToJSON().
+ *
+ * All other geometries and point clouds below the binary blob threshold are small and are written as a whole.
+ */
+class JSONGeometryStreamWriter {
+public:
+
+	/// Default number of points that are encoded per chunk.
+	static const unsigned int defaultPointsPerChunk = 4096;
+
+	/**
+	 * @brief Constructor
+	 * @param port Receiver of the chunks.
+	 * @param pointsPerChunk Number of points per chunk. It is rounded up to a multiple of 3, such that
+	 *        the base64 encoding of the chunks can be concatenated without padding.
+	 */
+	JSONGeometryStreamWriter(IOutputPort* port, unsigned int pointsPerChunk = defaultPointsPerChunk);
+	virtual ~JSONGeometryStreamWriter();
+
+	/**
+	 * @brief Write the model extended by the shape.
+	 * @param shape The geometry to be written.
+	 * @param model All other fields of the model, e.g. the header of a query result. It is not modified.
+	 * @param shapeTag Name of the shape within the JSON model.
+	 * @return True if the complete model has been written.
+	 */
+	bool write(Shape::ShapePtr& shape, libvariant::Variant& model, std::string shapeTag = "geometry");
+
+	unsigned int getPointsPerChunk() const {
+		return pointsPerChunk;
+	}
+
+	void setPointsPerChunk(unsigned int pointsPerChunk);
+
+	/// Point clouds with at least this number of points are streamed. See JSONTypecaster::addShapeToJSON().
+	void setPointCloudBinaryBlobThreshold(unsigned int pointCloudBinaryBlobThreshold) {
+		this->pointCloudBinaryBlobThreshold = pointCloudBinaryBlobThreshold;
+	}
+
+	/// Store the coordinates as float instead of double values.
+	void setUseSinglePrecision(bool useSinglePrecision) {
+		this->useSinglePrecision = useSinglePrecision;
+	}
+
+	/// Number of port writes of the last call of write().
+	unsigned int getNumberOfChunks() const {
+		return numberOfChunks;
+	}
+
+private:
+
+	bool writePointCloud(IPoint3DIterator::IPoint3DIteratorPtr it, size_t numberOfPoints, bool isColored,
+			libvariant::Variant& model, std::string& shapeTag);
+
+	bool writeChunk(const std::string& chunk);
+
+	IOutputPort* port;
+	unsigned int pointsPerChunk;
+	unsigned int pointCloudBinaryBlobThreshold;
+	bool useSinglePrecision;
+	unsigned int numberOfChunks;
+
+	/* Reused between the chunks */
+	std::vector<char> blob;
+	std::string encodedBlob;
+	std::string chunk;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_JSONGEOMETRYSTREAMWRITER_H_ */
+
+/* EOF */
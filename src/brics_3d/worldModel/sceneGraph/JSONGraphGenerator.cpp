@@ -66,7 +66,7 @@ void JSONGraphGenerator::visit(Group* node) {
 	/* recursively go down the graph structure */
 	for(unsigned i = 0; i < node->getNumberOfChildren(); ++i) {
 		// calculate hashes recursively
-		node->getChild(i)->accept(this);
+		node->getChild(i)->acceptWithoutTraversal(this);
 	}
 
 	/* during unwinding of the recursion stack: build up the JSON model */
@@ -124,7 +124,7 @@ void JSONGraphGenerator::visit(Transform* node) {
 	/* recursively go down the graph structure */
 	for(unsigned i = 0; i < node->getNumberOfChildren(); ++i) {
 		// calculate hashes recursively
-		node->getChild(i)->accept(this);
+		node->getChild(i)->acceptWithoutTraversal(this);
 	}
 
 	/* during unwinding of the recusrion stack: build up the JSON model */
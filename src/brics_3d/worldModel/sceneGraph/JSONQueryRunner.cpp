@@ -18,17 +18,19 @@
  ******************************************************************************/
 
 #include "JSONQueryRunner.h"
+#include <cstdio>
 
 namespace brics_3d {
 namespace rsg {
 
 JSONQueryRunner::JSONQueryRunner(WorldModel* wm) :
-		wm(wm) {
+		wm(wm), synchronizer(&wm->scene), pointsPerStreamChunk(JSONGeometryStreamWriter::defaultPointsPerChunk) {
 	updateOperationRunner = new JSONDeserializer(wm);
 	sceneUpdater = 0;
 }
 
-JSONQueryRunner::JSONQueryRunner(WorldModel* wm, ISceneGraphUpdate* sceneUpdater) : wm(wm), sceneUpdater(sceneUpdater) {
+JSONQueryRunner::JSONQueryRunner(WorldModel* wm, ISceneGraphUpdate* sceneUpdater) : wm(wm), sceneUpdater(sceneUpdater), synchronizer(&wm->scene),
+		pointsPerStreamChunk(JSONGeometryStreamWriter::defaultPointsPerChunk) {
 	updateOperationRunner = new JSONDeserializer(wm, sceneUpdater); // pass by sceneUpdater to the deserializer. That is enough to enable filtering.
 }
 
@@ -59,6 +61,42 @@ bool JSONQueryRunner::query(std::string& queryAsJson,
 
 }
 
+bool JSONQueryRunner::query(std::string& queryAsJson, IOutputPort* resultPort) {
+	if(resultPort == 0) {
+		LOG(ERROR) << "JSONQueryRunner: No output port for the result specified.";
+		return false;
+	}
+
+	libvariant::Variant query;
+	try {
+		query = libvariant:: Deserialize(queryAsJson, libvariant::SERIALIZE_GUESS);
+	} catch (std::exception const & e) {
+		LOG(ERROR) << "JSONQueryRunner: Parser error at input query: " << e.what() << std::endl << "Omitting this query.";
+		libvariant::Variant emptyResult(libvariant::VariantDefines::MapType);
+		writeResult(emptyResult, resultPort);
+		return false;
+	}
+
+	try {
+		if(query.Contains("@worldmodeltype") && query.Contains("query") &&
+				(query.Get("@worldmodeltype").AsString().compare("RSGQuery") == 0) &&
+				(query.Get("query").AsString().compare("GET_GEOMETRY") == 0)) {
+			return streamGetGeometry(query, resultPort);
+		}
+	} catch (std::exception const & e) {
+		LOG(ERROR) << "JSONQueryRunner: Generic parser error: " << e.what() << std::endl << "Omitting this query.";
+		libvariant::Variant result;
+		handleError("Syntax error: Generic parser error.", result);
+		writeResult(result, resultPort);
+		return false;
+	}
+
+	libvariant::Variant result;
+	bool success = this->query(query, result);
+	success &= writeResult(result, resultPort);
+	return success;
+}
+
 bool JSONQueryRunner::query(libvariant::Variant& query,
 		libvariant::Variant& result) {
 
@@ -114,6 +152,21 @@ bool JSONQueryRunner::query(libvariant::Variant& query,
 					} else if (queryOperation.compare("GET_CONNECTION_TARGET_IDS") == 0) {
 						return handleGetTargetIds(query, result);
 
+					} else if (queryOperation.compare("GET_NODES_IN_RADIUS") == 0) {
+						return handleGetNodesInRadius(query, result);
+
+					} else if (queryOperation.compare("GET_NODES_IN_BOX") == 0) {
+						return handleGetNodesInBox(query, result);
+
+					} else if (queryOperation.compare("GET_NEAREST_NODES") == 0) {
+						return handleGetNearestNodes(query, result);
+
+					} else if (queryOperation.compare("GET_NODES_ALONG_RAY") == 0) {
+						return handleGetNodesAlongRay(query, result);
+
+					} else if (queryOperation.compare("SYNC_SUBTREES") == 0) {
+						return handleSyncSubtrees(query, result);
+
 					} else {
 						LOG(ERROR) << "JSONQueryRunner: Mandatory query field has unknown value = " << queryOperation;
 						handleError("Syntax error: Mandatory query field has unknown value in RSGQuery", result);
@@ -125,7 +178,11 @@ bool JSONQueryRunner::query(libvariant::Variant& query,
 					return false;
 				}
 
-			} else if (type.compare("RSGUpdate") == 0) {
+			} else if (type.compare("RSGQueryBatch") == 0) {
+				LOG(DEBUG) << "JSONQueryRunner: Found a model for a Query batch.";
+				return handleQueryBatch(query, result);
+
+			} else if ((type.compare("RSGUpdate") == 0) || (type.compare("RSGUpdateBatch") == 0)) {
 				LOG(DEBUG) << "JSONQueryRunner: Found a model for an Update.";
 				result.Clear();
 				result.Set("updateSuccess", libvariant::Variant(false));
@@ -464,6 +521,143 @@ bool JSONQueryRunner::handleGetTargetIds(libvariant::Variant& query,
 	return success;
 }
 
+bool JSONQueryRunner::handleGetNodesInRadius(libvariant::Variant& query,
+		libvariant::Variant& result) {
+
+	/* prepare query */
+	rsg::Id idReferenceNode;
+	if(!getReferenceNodeFromJSON(query, idReferenceNode)) {
+		handleError("Syntax error: Wrong id of reference node.", result);
+		return false;
+	}
+	Point3D center;
+	if(!JSONTypecaster::getPointFromJSON(query, "center", center) || !query.Contains("radius")) {
+		handleError("Syntax error: Wrong or missing center or radius.", result);
+		return false;
+	}
+	double radius = query.Get("radius").AsDouble();
+	std::vector<rsg::Id> ids;
+
+	/* perform query */
+	bool success = wm->scene.getNodesInRadius(idReferenceNode, center, radius, ids);
+
+	/* set up result message */
+	result.Set("query", libvariant::Variant("GET_NODES_IN_RADIUS"));
+	result.Set("querySuccess", libvariant::Variant(success));
+	JSONTypecaster::addIdsToJSON(ids, result, "ids");
+
+	return success;
+}
+
+bool JSONQueryRunner::handleGetNodesInBox(libvariant::Variant& query,
+		libvariant::Variant& result) {
+
+	/* prepare query */
+	rsg::Id idReferenceNode;
+	if(!getReferenceNodeFromJSON(query, idReferenceNode)) {
+		handleError("Syntax error: Wrong id of reference node.", result);
+		return false;
+	}
+	Point3D minPoint;
+	Point3D maxPoint;
+	if(!JSONTypecaster::getPointFromJSON(query, "min", minPoint) || !JSONTypecaster::getPointFromJSON(query, "max", maxPoint)) {
+		handleError("Syntax error: Wrong or missing min or max point.", result);
+		return false;
+	}
+	std::vector<rsg::Id> ids;
+
+	/* perform query */
+	bool success = wm->scene.getNodesInBox(idReferenceNode, minPoint, maxPoint, ids);
+
+	/* set up result message */
+	result.Set("query", libvariant::Variant("GET_NODES_IN_BOX"));
+	result.Set("querySuccess", libvariant::Variant(success));
+	JSONTypecaster::addIdsToJSON(ids, result, "ids");
+
+	return success;
+}
+
+bool JSONQueryRunner::handleGetNearestNodes(libvariant::Variant& query,
+		libvariant::Variant& result) {
+
+	/* prepare query */
+	rsg::Id idReferenceNode;
+	if(!getReferenceNodeFromJSON(query, idReferenceNode)) {
+		handleError("Syntax error: Wrong id of reference node.", result);
+		return false;
+	}
+	Point3D point;
+	if(!JSONTypecaster::getPointFromJSON(query, "point", point) || !query.Contains("k")) {
+		handleError("Syntax error: Wrong or missing point or k.", result);
+		return false;
+	}
+	unsigned int k = query.Get("k").AsUnsigned();
+	std::vector<rsg::Id> ids;
+	std::vector<double> distances;
+
+	/* perform query */
+	bool success = wm->scene.getNearestNodes(idReferenceNode, point, k, ids, distances);
+
+	/* set up result message */
+	result.Set("query", libvariant::Variant("GET_NEAREST_NODES"));
+	result.Set("querySuccess", libvariant::Variant(success));
+	JSONTypecaster::addIdsToJSON(ids, result, "ids");
+	libvariant::Variant distancesModel(libvariant::VariantDefines::ListType);
+	for (std::vector<double>::iterator it = distances.begin(); it != distances.end(); ++it) {
+		distancesModel.Append(libvariant::Variant(*it));
+	}
+	result.Set("distances", distancesModel);
+
+	return success;
+}
+
+bool JSONQueryRunner::handleGetNodesAlongRay(libvariant::Variant& query,
+		libvariant::Variant& result) {
+
+	/* prepare query */
+	rsg::Id idReferenceNode;
+	if(!getReferenceNodeFromJSON(query, idReferenceNode)) {
+		handleError("Syntax error: Wrong id of reference node.", result);
+		return false;
+	}
+	Point3D origin;
+	Point3D direction;
+	if(!JSONTypecaster::getPointFromJSON(query, "origin", origin) || !JSONTypecaster::getPointFromJSON(query, "direction", direction)) {
+		handleError("Syntax error: Wrong or missing origin or direction.", result);
+		return false;
+	}
+	double maxDistance = std::numeric_limits<double>::max();
+	if(query.Contains("maxDistance")) {
+		maxDistance = query.Get("maxDistance").AsDouble();
+	}
+	std::vector<rsg::Id> ids;
+	std::vector<double> distances;
+
+	/* perform query */
+	bool success = wm->scene.getNodesAlongRay(idReferenceNode, origin, direction, maxDistance, ids, distances);
+
+	/* set up result message */
+	result.Set("query", libvariant::Variant("GET_NODES_ALONG_RAY"));
+	result.Set("querySuccess", libvariant::Variant(success));
+	JSONTypecaster::addIdsToJSON(ids, result, "ids");
+	libvariant::Variant distancesModel(libvariant::VariantDefines::ListType);
+	for (std::vector<double>::iterator it = distances.begin(); it != distances.end(); ++it) {
+		distancesModel.Append(libvariant::Variant(*it));
+	}
+	result.Set("distances", distancesModel);
+
+	return success;
+}
+
+bool JSONQueryRunner::getReferenceNodeFromJSON(libvariant::Variant& query, rsg::Id& idReferenceNode) {
+	if(query.Contains("idReferenceNode")) {
+		idReferenceNode = JSONTypecaster::getIdFromJSON(query, "idReferenceNode");
+		return !idReferenceNode.isNil();
+	}
+	idReferenceNode = wm->getRootNodeId();
+	return true;
+}
+
 void JSONQueryRunner::handleError(std::string message, libvariant::Variant& result) {
 	LOG(ERROR) << "JSONQueryRunner::handleError: " << message;
 	result.Clear();
@@ -472,6 +666,192 @@ void JSONQueryRunner::handleError(std::string message, libvariant::Variant& resu
 	result.Set("error", error);
 }
 
+bool JSONQueryRunner::handleSyncSubtrees(libvariant::Variant& query,
+		libvariant::Variant& result) {
+
+	/* prepare query */
+	MerkleSynchronizer::SyncRequest request;
+	if(!JSONTypecaster::getSyncRequestFromJSON(request, query)) {
+		handleError("Syntax error: Wrong synchronization request.", result);
+		return false;
+	}
+	std::vector<MerkleSynchronizer::SubtreeDigest> digests;
+	SceneGraphUpdateBatch updates;
+
+	/* perform query */
+	bool success = synchronizer.handleRequest(request, digests, updates);
+
+	/* set up result message */
+	result.Set("query", libvariant::Variant("SYNC_SUBTREES"));
+	JSONTypecaster::addSubtreeDigestsToJSON(digests, result);
+	if(!updates.isEmpty()) {
+		JSONSerializer serializer(wm, 0);
+		libvariant::Variant updatesModel;
+		success &= serializer.updateBatchToJSON(updates, updatesModel);
+		result.Set("updates", updatesModel);
+	}
+	result.Set("querySuccess", libvariant::Variant(success));
+
+	return success;
+}
+
+bool JSONQueryRunner::handleQueryBatch(libvariant::Variant& batch,
+		libvariant::Variant& result) {
+
+	result.Clear();
+	result.Set("querySuccess", libvariant::Variant(false));
+	result.Set("@worldmodeltype", libvariant::Variant("RSGQueryBatchResult"));
+
+	/* Optional queryId */
+	if(batch.Contains("queryId"))  {
+		result.Set("queryId", batch.Get("queryId"));
+	}
+
+	if(!batch.Contains("queries") || !batch.Get("queries").IsList()) {
+		handleError("Syntax error: Mandatory queries list not set in RSGQueryBatch", result);
+		return false;
+	}
+	libvariant::Variant queries = batch.Get("queries");
+
+	/* perform queries */
+	QueryBatchContext context;
+	libvariant::Variant results(libvariant::VariantDefines::ListType);
+	bool success = true;
+	for (libvariant::Variant::ListIterator i(queries.ListBegin()), e(queries.ListEnd()); i!=e; ++i) {
+		libvariant::Variant queryResult;
+		bool querySuccess = false;
+
+		bool isReadOnlyQuery = i->Contains("@worldmodeltype") && i->Contains("query") &&
+				(i->Get("@worldmodeltype").AsString().compare("RSGQuery") == 0) &&
+				(i->Get("query").AsString().compare(0, 4, "GET_") == 0);
+
+		if(!isReadOnlyQuery) { // might change the graph, so earlier results can not be reused anymore
+			context.resultIndices.clear();
+			querySuccess = this->query(*i, queryResult);
+
+		} else {
+			libvariant::Variant resolvedQuery;
+			if(!resolveIdReferences(*i, context, resolvedQuery)) {
+				handleError("Syntax error: Unresolvable id reference in RSGQueryBatch.", queryResult);
+
+			} else {
+				std::string queryKey = libvariant::Serialize(resolvedQuery, libvariant::SERIALIZE_JSON);
+				std::map<std::string, size_t>::iterator evaluatedQuery = context.resultIndices.find(queryKey);
+				if(evaluatedQuery != context.resultIndices.end()) {
+					LOG(DEBUG) << "JSONQueryRunner: Reusing result " << evaluatedQuery->second << " within the query batch.";
+					libvariant::Variant& evaluatedResult = context.results[evaluatedQuery->second];
+					for (libvariant::Variant::MapIterator j(evaluatedResult.MapBegin()), f(evaluatedResult.MapEnd()); j!=f; ++j) {
+						if(j->first.compare("queryId") != 0) {
+							queryResult.Set(j->first, j->second);
+						}
+					}
+					querySuccess = queryResult.Contains("querySuccess") && queryResult.Get("querySuccess").AsBool();
+				} else {
+					querySuccess = this->query(resolvedQuery, queryResult);
+					context.resultIndices.insert(std::make_pair(queryKey, context.results.size()));
+				}
+
+				if(i->Contains("queryId"))  {
+					queryResult.Set("queryId", i->Get("queryId"));
+				}
+			}
+		}
+
+		success &= querySuccess;
+		context.results.push_back(queryResult);
+		results.Append(queryResult);
+	}
+
+	/* set up result message */
+	result.Set("results", results);
+	result.Set("querySuccess", libvariant::Variant(success));
+
+	return success;
+}
+
+bool JSONQueryRunner::resolveIdReferences(libvariant::Variant& query, QueryBatchContext& context, libvariant::Variant& resolvedQuery) {
+	for (libvariant::Variant::MapIterator i(query.MapBegin()), e(query.MapEnd()); i!=e; ++i) {
+		if(i->first.compare("queryId") == 0) {
+			continue;
+		}
+
+		bool isIdField = (i->first.compare("id") == 0) || (i->first.compare("subgraphId") == 0) || (i->first.compare("idReferenceNode") == 0);
+		if(!isIdField || !i->second.IsString() || i->second.AsString().empty() || i->second.AsString()[0] != '$') {
+			resolvedQuery.Set(i->first, i->second);
+			continue;
+		}
+
+		/* "$<k>" or "$<k>[<n>]" */
+		std::string reference = i->second.AsString();
+		unsigned int resultIndex = 0;
+		unsigned int idIndex = 0;
+		char bracket = 0;
+		char trailing = 0;
+		int fields = sscanf(reference.c_str(), "$%u%c%u]%c", &resultIndex, &bracket, &idIndex, &trailing);
+		bool isValidReference = (fields == 1) || (fields == 3 && bracket == '[' && reference[reference.size() - 1] == ']');
+		if(!isValidReference || resultIndex >= context.results.size()) {
+			LOG(ERROR) << "JSONQueryRunner: Invalid id reference " << reference << " in query batch.";
+			return false;
+		}
+
+		libvariant::Variant& referencedResult = context.results[resultIndex];
+		if(referencedResult.Contains("ids") && referencedResult.Get("ids").IsList() && idIndex < referencedResult.Get("ids").Size()) {
+			resolvedQuery.Set(i->first, referencedResult.Get("ids").At(idIndex));
+		} else if (referencedResult.Contains("rootId") && idIndex == 0) {
+			resolvedQuery.Set(i->first, referencedResult.Get("rootId"));
+		} else {
+			LOG(ERROR) << "JSONQueryRunner: Id reference " << reference << " does not point to an id of an earlier result.";
+			return false;
+		}
+		LOG(DEBUG) << "JSONQueryRunner: Id reference " << reference << " resolved to " << resolvedQuery.Get(i->first).AsString();
+	}
+	return true;
+}
+
+bool JSONQueryRunner::streamGetGeometry(libvariant::Variant& query, IOutputPort* resultPort) {
+	libvariant::Variant result;
+	result.Set("querySuccess", libvariant::Variant(false));
+	result.Set("@worldmodeltype", libvariant::Variant("RSGQueryResult"));
+	if(query.Contains("queryId"))  {
+		result.Set("queryId", query.Get("queryId"));
+	}
+
+	/* prepare query */
+	rsg::Id id = JSONTypecaster::getIdFromJSON(query, "id");
+	if(id.isNil()) {
+		handleError("Syntax error: Wrong or missing id.", result);
+		writeResult(result, resultPort);
+		return false;
+	}
+	Shape::ShapePtr shape;
+	TimeStamp timeStamp;
+
+	/* perform query */
+	bool success = wm->scene.getGeometry(id, shape, timeStamp);
+
+	/* set up result message, the geometry is appended while it is written */
+	result.Set("query", libvariant::Variant("GET_GEOMETRY"));
+	result.Set("querySuccess", libvariant::Variant(success));
+	if(!success) {
+		writeResult(result, resultPort);
+		return false;
+	}
+	result.Set("unit", libvariant::Variant("m"));
+	JSONTypecaster::addTimeStampToJSON(timeStamp, result, "timeStamp");
+
+	JSONGeometryStreamWriter writer(resultPort, pointsPerStreamChunk);
+	success = writer.write(shape, result, "geometry");
+	LOG(DEBUG) << "JSONQueryRunner: GET_GEOMETRY result written in " << writer.getNumberOfChunks() << " chunks.";
+
+	return success;
+}
+
+bool JSONQueryRunner::writeResult(libvariant::Variant& result, IOutputPort* resultPort) {
+	std::string resultAsJson = libvariant::Serialize(result, libvariant::SERIALIZE_JSON);
+	int transferredBytes = 0;
+	return (resultPort->write(resultAsJson.c_str(), resultAsJson.size(), transferredBytes) >= 0);
+}
+
 bool JSONQueryRunner::handleLoadFunctionBlock(libvariant::Variant& query, libvariant::Variant& result) {
 	result.Set("operation", libvariant::Variant("LOAD"));
 
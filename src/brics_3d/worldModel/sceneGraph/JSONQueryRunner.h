@@ -23,6 +23,9 @@
 #include "brics_3d/util/JSONTypecaster.h"
 #include "brics_3d/worldModel/WorldModel.h"
 #include "brics_3d/worldModel/sceneGraph/JSONDeserializer.h"
+#include "brics_3d/worldModel/sceneGraph/JSONSerializer.h"
+#include "brics_3d/worldModel/sceneGraph/MerkleSynchronizer.h"
+#include "brics_3d/worldModel/sceneGraph/JSONGeometryStreamWriter.h"
 
 namespace brics_3d {
 namespace rsg {
@@ -60,8 +63,32 @@ public:
 	 */
 	bool query(std::string& queryAsJson, std::string& resultAsJson);
 
+	/**
+	 * @brief Processes a JSON based query and writes the result to an output port.
+	 * The results of GET_GEOMETRY queries are written in chunks with a JSONGeometryStreamWriter
+	 * while the geometry is encoded. All other results are written as a whole.
+	 * @param queryAsJson Query as for query(std::string&, std::string&).
+	 * @param resultPort Receiver of the result. The concatenation of all writes is the JSON based result.
+	 * @return True on success full execution.
+	 */
+	bool query(std::string& queryAsJson, IOutputPort* resultPort);
+
+	/// Number of points per chunk for streamed GET_GEOMETRY results.
+	void setPointsPerStreamChunk(unsigned int pointsPerStreamChunk) {
+		this->pointsPerStreamChunk = pointsPerStreamChunk;
+	}
+
 private:
 
+	/// State that is shared by all queries of one RSGQueryBatch.
+	struct QueryBatchContext {
+		/// Results of the already processed queries. Referenced by "$<index>" ids.
+		std::vector<libvariant::Variant> results;
+
+		/// Index of the result for every already processed read only query (without queryId).
+		std::map<std::string, size_t> resultIndices;
+	};
+
 	bool query(libvariant::Variant& query, libvariant::Variant& result);
 
 	WorldModel* wm;
@@ -71,6 +98,11 @@ private:
 	/// Responsible for update queries. In particular useful to get feedback if a node has been created.
 	JSONDeserializer* updateOperationRunner;
 
+	/// Source side of SYNC_SUBTREES queries.
+	MerkleSynchronizer synchronizer;
+
+	unsigned int pointsPerStreamChunk;
+
 	/* Query related handlers */
 	bool handleGetNodes(libvariant::Variant& query, libvariant::Variant& result);
 	bool handleGetNodeAttributes(libvariant::Variant& query, libvariant::Variant& result);
@@ -83,6 +115,41 @@ private:
 	bool handleGetSourceIds(libvariant::Variant& query, libvariant::Variant& result);
 	bool handleGetTargetIds(libvariant::Variant& query, libvariant::Variant& result);
 
+	/* Spatial queries, see SceneGraphFacade::getNodesInRadius() etc. */
+	bool handleGetNodesInRadius(libvariant::Variant& query, libvariant::Variant& result);
+	bool handleGetNodesInBox(libvariant::Variant& query, libvariant::Variant& result);
+	bool handleGetNearestNodes(libvariant::Variant& query, libvariant::Variant& result);
+	bool handleGetNodesAlongRay(libvariant::Variant& query, libvariant::Variant& result);
+
+	/// The optional "idReferenceNode" of a spatial query. Defaults to the root node. False if the id is invalid.
+	bool getReferenceNodeFromJSON(libvariant::Variant& query, rsg::Id& idReferenceNode);
+
+	/**
+	 * @brief Answers a MerkleSynchronizer::SyncRequest of a replica.
+	 * The result contains the "digests" for the "expandIds" and an "RSGUpdateBatch" with the "updates"
+	 * for the "refreshIds" and "subtrees". The replica can apply the updates with a JSONDeserializer.
+	 */
+	bool handleSyncSubtrees(libvariant::Variant& query, libvariant::Variant& result);
+
+	/**
+	 * @brief Processes all "queries" of an RSGQueryBatch in one go and returns a "results" list in the same order.
+	 *
+	 * The queries can refer to the ids of earlier results within the same batch: an "id", "subgraphId" or "idReferenceNode"
+	 * value "$<k>" is replaced by the first id of the result with index k ("ids" or "rootId"), "$<k>[<n>]" by its n-th id.
+	 * Identical GET_* queries are only evaluated once per batch. Updates and function blocks are executed in order
+	 * and invalidate the already evaluated queries.
+	 */
+	bool handleQueryBatch(libvariant::Variant& batch, libvariant::Variant& result);
+
+	/// Replace the id references of a query within a batch. The resolved query is a new model without the "queryId".
+	bool resolveIdReferences(libvariant::Variant& query, QueryBatchContext& context, libvariant::Variant& resolvedQuery);
+
+	/// Write a GET_GEOMETRY result with the JSONGeometryStreamWriter.
+	bool streamGetGeometry(libvariant::Variant& query, IOutputPort* resultPort);
+
+	/// Serialize a complete result and write it to the port.
+	bool writeResult(libvariant::Variant& result, IOutputPort* resultPort);
+
 	/**
 	 * @brief Sets up an error message as as result.
 	 * @param[in] message Message text to be written. Currently there are no error codes.
@@ -29,6 +29,10 @@ JSONSerializer::JSONSerializer(WorldModel* wm, IOutputPort* port) {
 
 	/* some default values */
 	storeMessageBackupsOnFileSystem = false;
+	batchUpdates = 0;
+	pointCloudBinaryBlobThreshold = JSONTypecaster::defaultPointCloudBinaryBlobThreshold;
+	usePointCloudSinglePrecision = false;
+	useTransformStreamEncoding = false;
 
 	std::stringstream instanceBasedSuffix; //in case multiple JSON files  with the same derived file name are created.
 	instanceBasedSuffix << this; // pointer as "name"
@@ -195,7 +199,7 @@ bool JSONSerializer::addGeometricNode(Id parentId,
 		TimeStamp attributesTimeStamp;
 		wm->scene.getNodeAttributes(assignedId, dummyAttributes, attributesTimeStamp);
 		JSONTypecaster::addTimeStampToJSON(attributesTimeStamp, node, "attributesTimeStamp");
-		JSONTypecaster::addShapeToJSON(shape, node, "geometry");
+		JSONTypecaster::addShapeToJSON(shape, node, "geometry", pointCloudBinaryBlobThreshold, usePointCloudSinglePrecision);
 		JSONTypecaster::addTimeStampToJSON(timeStamp, graphUpdate, "timeStamp");
 
 		node.Set("unit", libvariant::Variant("m")); // TODO; better part of geometry?!?
@@ -354,9 +358,15 @@ bool JSONSerializer::setTransform(Id id,
 		libvariant::Variant node;
 		node.Set("@graphtype", libvariant::Variant("Connection")); // this is actually a dummy, thoug reqired for correce validation
 		JSONTypecaster::addIdToJSON(id, node, "id");
-		TemporalCache<IHomogeneousMatrix44::IHomogeneousMatrix44Ptr> history;
-		history.insertData(transform, timeStamp);
-		JSONTypecaster::addTransformCacheToJSON(history, node);
+		if (useTransformStreamEncoding) {
+			TransformStreamSample sample;
+			transformStreamEncoder.encode(id, transform, timeStamp, sample);
+			JSONTypecaster::addTransformStreamSampleToJSON(sample, node);
+		} else {
+			TemporalCache<IHomogeneousMatrix44::IHomogeneousMatrix44Ptr> history;
+			history.insertData(transform, timeStamp);
+			JSONTypecaster::addTransformCacheToJSON(history, node);
+		}
 
 		/* assebmle it */
 		graphUpdate.Set("node", node);
@@ -385,6 +395,7 @@ bool JSONSerializer::setUncertainTransform(Id id,
 bool JSONSerializer::deleteNode(Id id) {
 
 	LOG(DEBUG) << "JSONSerializer: deleteNode: removing node " << id.toString();
+	transformStreamEncoder.reset(id);
 	try {
 		std::string fileName = "Node-Deletion-" + id.toString() + fileSuffix;
 
@@ -478,8 +489,63 @@ bool JSONSerializer::removeParent(Id id, Id parentId) {
 	return false;
 }
 
+bool JSONSerializer::applyUpdateBatch(const SceneGraphUpdateBatch& batch) {
+	LOG(DEBUG) << "JSONSerializer: adding a Batch with " << batch.getNumberOfUpdates() << " updates.";
+	if (batchUpdates != 0) { // nested batches are just flattened into the current one
+		return batch.replay(this);
+	}
+
+	libvariant::Variant graphUpdateBatch;
+	bool success = updateBatchToJSON(batch, graphUpdateBatch);
+	if (!graphUpdateBatch.Contains("updates")) {
+		return false;
+	}
+
+	try {
+		/* send it */
+		return doSendMessage(graphUpdateBatch) && success;
+
+	} catch (std::exception e) {
+		LOG(ERROR) << "JSONSerializer applyUpdateBatch: Cannot send the JSON serialization. Exception = " << std::endl << e.what();
+		return false;
+	}
+
+	return false;
+}
+
+bool JSONSerializer::updateBatchToJSON(const SceneGraphUpdateBatch& batch, libvariant::Variant& graphUpdateBatch) {
+	try {
+		/* header */
+		graphUpdateBatch.Set("@worldmodeltype", libvariant::Variant("RSGUpdateBatch"));
+		JSONTypecaster::addIdToJSON(wm->getRootNodeId(), graphUpdateBatch, "senderId");
+
+		/* collect the individual updates */
+		libvariant::Variant updates(libvariant::VariantDefines::ListType);
+		batchUpdates = &updates;
+		bool success = batch.replay(this);
+		batchUpdates = 0;
+
+		/* assemble it */
+		graphUpdateBatch.Set("updates", updates);
+		return success;
+
+	} catch (std::exception e) {
+		batchUpdates = 0;
+		LOG(ERROR) << "JSONSerializer applyUpdateBatch: Cannot create a JSON serialization. Exception = " << std::endl << e.what();
+		return false;
+	}
+
+	return false;
+}
+
 bool JSONSerializer::doSendMessage(libvariant::Variant& message) {
 
+	/* In batch mode the message is not send but appended to the batch */
+	if (batchUpdates != 0) {
+		batchUpdates->Append(message);
+		return true;
+	}
+
 	string messageAsString = libvariant::Serialize(message, libvariant::SERIALIZE_JSON); //could also go to heap (?!?)
 	return doSendMessage(messageAsString);
 }
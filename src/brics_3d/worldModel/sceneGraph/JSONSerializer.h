@@ -23,6 +23,8 @@
 #include "brics_3d/core/Logger.h"
 #include "brics_3d/worldModel/sceneGraph/ISceneGraphUpdateObserver.h"
 #include "brics_3d/worldModel/sceneGraph/IPort.h"
+#include "brics_3d/worldModel/sceneGraph/SceneGraphUpdateBatch.h"
+#include "brics_3d/worldModel/sceneGraph/TransformStreamCodec.h"
 #include "brics_3d/worldModel/WorldModel.h"
 
 #include <Variant/Variant.h>
@@ -49,6 +51,22 @@ public:
 	bool addParent(Id id, Id parentId);
 	bool removeParent(Id id, Id parentId);
 
+	/**
+	 * @brief Serializes all updates of the batch into a single message.
+	 *
+	 * The message is of type "RSGUpdateBatch" and holds the regular "RSGUpdate"
+	 * messages in its "updates" list in the order of recording.
+	 */
+	bool applyUpdateBatch(const SceneGraphUpdateBatch& batch);
+
+	/**
+	 * @brief Create the "RSGUpdateBatch" model of a batch without sending it.
+	 * @param batch The batch to be serialized.
+	 * @param[out] graphUpdateBatch The resulting model.
+	 * @return True if all updates could be serialized.
+	 */
+	bool updateBatchToJSON(const SceneGraphUpdateBatch& batch, libvariant::Variant& graphUpdateBatch);
+
 	bool getStoreMessageBackupsOnFileSystem() const {
 		return storeMessageBackupsOnFileSystem;
 	}
@@ -58,12 +76,55 @@ public:
 		this->storeMessageBackupsOnFileSystem = storeMessageBackupsOnFileSystem;
 	}
 
+	unsigned int getPointCloudBinaryBlobThreshold() const {
+		return pointCloudBinaryBlobThreshold;
+	}
+
+	/// Point clouds with at least this number of points are sent as "PointCloud3DBinaryBlob". Zero means always.
+	void setPointCloudBinaryBlobThreshold(unsigned int pointCloudBinaryBlobThreshold) {
+		this->pointCloudBinaryBlobThreshold = pointCloudBinaryBlobThreshold;
+	}
+
+	bool getUsePointCloudSinglePrecision() const {
+		return usePointCloudSinglePrecision;
+	}
+
+	/// Send the coordinates of "PointCloud3DBinaryBlob" geometries as float instead of double values.
+	void setUsePointCloudSinglePrecision(bool usePointCloudSinglePrecision) {
+		this->usePointCloudSinglePrecision = usePointCloudSinglePrecision;
+	}
+
+	bool getUseTransformStreamEncoding() const {
+		return useTransformStreamEncoding;
+	}
+
+	/**
+	 * @brief Send UPDATE_TRANSFORM operations as per node stream of single precision deltas with periodic keyframes.
+	 * The node then carries a "transformStream" instead of a "history". Default is false.
+	 */
+	void setUseTransformStreamEncoding(bool useTransformStreamEncoding) {
+		this->useTransformStreamEncoding = useTransformStreamEncoding;
+		transformStreamEncoder.reset();
+	}
+
+	/// Keyframe interval and error bounds of the transform stream encoding.
+	void setTransformStreamOptions(const TransformStreamEncoder::Options& options) {
+		transformStreamEncoder.setOptions(options);
+	}
+
 private:
 
 	WorldModel* wm;
 	IOutputPort* port;
 	bool storeMessageBackupsOnFileSystem;
 	std::string fileSuffix;
+	unsigned int pointCloudBinaryBlobThreshold;
+	bool usePointCloudSinglePrecision;
+	bool useTransformStreamEncoding;
+	TransformStreamEncoder transformStreamEncoder;
+
+	/// Collects the messages while a batch is serialized. NULL otherwise.
+	libvariant::Variant* batchUpdates;
 
 protected:
 
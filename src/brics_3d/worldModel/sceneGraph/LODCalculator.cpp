@@ -25,6 +25,7 @@
 #include "brics_3d/core/HomogeneousMatrix44.h"
 #include "brics_3d/core/ColoredPoint3D.h"
 #include "brics_3d/core/TriangleMeshImplicit.h"
+#include "brics_3d/core/PointCloud3D.h"
 #include "Sphere.h"
 #include "Cylinder.h"
 #include "Box.h"
@@ -43,36 +44,33 @@ LODCalculator::~LODCalculator() {
 }
 
 bool LODCalculator::calculateLOD(Shape::ShapePtr shape, double& lod) {
+	return calculateLOD(shape.get(), lod);
+}
+
+bool LODCalculator::calculateLOD(Shape* shape, double& lod) {
 	lod = 0.0;
 	if(!shape) {
 		return false;
 	}
 
-	rsg::Sphere::SpherePtr sphere(new rsg::Sphere());
-	sphere =  boost::dynamic_pointer_cast<rsg::Sphere>(shape);
-	rsg::Box::BoxPtr box(new rsg::Box());
-	box =  boost::dynamic_pointer_cast<rsg::Box>(shape);
-	rsg::Cylinder::CylinderPtr cylinder(new rsg::Cylinder());
-	cylinder =  boost::dynamic_pointer_cast<rsg::Cylinder>(shape);
-	rsg::Mesh<brics_3d::ITriangleMesh>::MeshPtr mesh(new rsg::Mesh<brics_3d::ITriangleMesh>());
-	mesh = boost::dynamic_pointer_cast<rsg::Mesh<brics_3d::ITriangleMesh> >(shape);
 	double volume = 1.0;
-
-
-		if (sphere !=0) {
+	switch (shape->getShapeType()) {
+		case Shape::Sphere: {
 			LOG(DEBUG) << "                 -> Found a sphere.";
 
-			double r = sphere->getRadius();
+			double r = static_cast<rsg::Sphere*>(shape)->getRadius();
 			volume = 4.0/3.0 * M_PI * r*r*r;
 			if (volume == 0.0) {
 				lod = 0.0;
 			} else {
 				lod = 1.0 /* samples */ / volume;
 			}
-
-		} else if (cylinder !=0) {
+			break;
+		}
+		case Shape::Cylinder: {
 			LOG(DEBUG) << "                 -> Found a cylinder.";
 
+			rsg::Cylinder* cylinder = static_cast<rsg::Cylinder*>(shape);
 			double r = cylinder->getRadius();
 			volume =  M_PI * r*r * cylinder->getHeight();
 			if (volume == 0.0) {
@@ -80,37 +78,62 @@ bool LODCalculator::calculateLOD(Shape::ShapePtr shape, double& lod) {
 			} else {
 				lod = 2.0 /* samples */ / volume;
 			}
-
-
-		} else if (box !=0) {
+			break;
+		}
+		case Shape::Box: {
 			LOG(DEBUG) << "                 -> Found a box.";
 
+			rsg::Box* box = static_cast<rsg::Box*>(shape);
 			volume = box->getSizeX() * box->getSizeY() * box->getSizeZ();
 			if (volume == 0.0) {
 				lod = 0.0;
 			} else {
 				lod = 3.0 /* samples */ / volume;
 			}
-
-
-		} else if (shape->getPointCloudIterator() != 0) {
+			break;
+		}
+		case Shape::PointCloud:
 			LOG(DEBUG) << "                 -> Found a point cloud.";
 
-			Density density = pointCloudLod.computeDensity(shape->getPointCloudIterator());
-			lod  = density.numberOfPoints / volume;
+			lod = calculatePointCloudLOD(shape) / volume;
+			break;
 
-		} else if (mesh != 0) {
+		case Shape::Mesh:
 			LOG(DEBUG) << "                 -> Found a mesh.";
 
 			// TODO: we need a point cloud iterator for the mesh
+			break;
 
-		}
+		default:
+			break;
+	}
 
 	LOG(DEBUG) << "LODCalculator: lod  = " << lod;
 
 	return true;
 }
 
+double LODCalculator::calculatePointCloudLOD(Shape* shape) {
+
+	/* The number of points is directly known for the native point cloud type */
+	rsg::PointCloud<brics_3d::PointCloud3D>* pointCloud = dynamic_cast<rsg::PointCloud<brics_3d::PointCloud3D>*>(shape);
+	if (pointCloud != 0) {
+		return (pointCloud->data != 0) ? static_cast<double>(pointCloud->data->getSize()) : 0.0;
+	}
+
+	/* Everything else has to be counted */
+	IPoint3DIterator::IPoint3DIteratorPtr it = shape->getPointCloudIterator();
+	if (it == 0) {
+		return 0.0;
+	}
+	double numberOfPoints = 0.0;
+	unsigned int count = 0;
+	for (it->begin(); (count = it->nextBlock(pointBlock, IPoint3DIterator::defaultBlockSize)) > 0; ) {
+		numberOfPoints += count;
+	}
+	return numberOfPoints;
+}
+
 } /* namespace rsg */
 } /* namespace brics_3d */
 
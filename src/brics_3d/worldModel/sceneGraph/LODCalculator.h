@@ -21,13 +21,16 @@
 #define LODCALCULATOR_H_
 
 #include "Shape.h"
-#include "brics_3d/algorithm/featureExtraction/DensityExtractor.h"
+#include "brics_3d/core/IPoint3DIterator.h"
 
 namespace brics_3d {
 namespace rsg {
 
 /**
  * @brief Calculates the LOD of a Shape.
+ *
+ * The calculation is dispatched on Shape::getShapeType() and it does not allocate any memory,
+ * except for point clouds that can only be accessed via an IPoint3DIterator.
  */
 class LODCalculator {
 public:
@@ -36,9 +39,21 @@ public:
 
 	bool calculateLOD(Shape::ShapePtr shape, double& lod);
 
+	/**
+	 * @brief Calculate the LOD of a shape without any reference counting.
+	 * @param[in] shape The shape. Null is an error.
+	 * @param[out] lod The level of detail. 0 for unknown shapes.
+	 * @return True on success.
+	 */
+	bool calculateLOD(Shape* shape, double& lod);
+
 private:
 
-	 DensityExtractor pointCloudLod;
+	/// LOD of a point cloud: the number of points.
+	double calculatePointCloudLOD(Shape* shape);
+
+	/// Reused for point clouds other than PointCloud3D.
+	Coordinate pointBlock[IPoint3DIterator::defaultBlockSize * 3];
 };
 
 } /* namespace rsg */
@@ -0,0 +1,388 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#include "MerkleSynchronizer.h"
+#include "NodeHash.h"
+#include "brics_3d/core/Logger.h"
+
+namespace brics_3d {
+namespace rsg {
+
+/* DigestTraverser */
+
+MerkleSynchronizer::DigestTraverser::DigestTraverser() {
+	reset();
+}
+
+void MerkleSynchronizer::DigestTraverser::visit(Node* node) {
+	if (hasDigest(node->getId())) {
+		return;
+	}
+	NodeHashTraverser::visit(node);
+	recordDigest(node);
+}
+
+void MerkleSynchronizer::DigestTraverser::visit(Group* node) {
+	if (hasDigest(node->getId())) { // shared sub graphs are only processed once
+		return;
+	}
+	NodeHashTraverser::visit(node); // recursively visits the children
+	recordDigest(node);
+}
+
+void MerkleSynchronizer::DigestTraverser::visit(Connection* connection) {
+	if (hasDigest(connection->getId())) {
+		return;
+	}
+	NodeHashTraverser::visit(connection); // binary hashes of Connections are based on the IDs of the references, so they do not depend on the traversal order
+	recordDigest(connection);
+}
+
+void MerkleSynchronizer::DigestTraverser::reset() {
+	NodeHashTraverser::reset(true, true, BINARY_128);
+	digestLookUpTable.clear();
+}
+
+bool MerkleSynchronizer::DigestTraverser::hasDigest(Id id) const {
+	return digestLookUpTable.find(id) != digestLookUpTable.end();
+}
+
+const MerkleSynchronizer::SubtreeDigest& MerkleSynchronizer::DigestTraverser::getDigest(Id id) const {
+	assert(hasDigest(id));
+	return digestLookUpTable.find(id)->second;
+}
+
+void MerkleSynchronizer::DigestTraverser::recordDigest(Node* node) {
+	SubtreeDigest& digest = digestLookUpTable[node->getId()];
+	digest.id = node->getId();
+	digest.subtreeHash = getHashById(node->getId());
+
+	Group* group = dynamic_cast<Group*>(node);
+	if (group == 0) {
+		digest.nodeHash = digest.subtreeHash; // a leaf has no further content
+		return;
+	}
+	digest.nodeHash = NodeHash::nodeToHash128(node, useNodeIds, useTimeStamps).toString();
+	for (unsigned int i = 0; i < group->getNumberOfChildren(); ++i) {
+		Id childId = group->getChild(i)->getId();
+		digest.childIds.push_back(childId);
+		digest.childHashes.push_back(getHashById(childId));
+	}
+}
+
+/* UpdateEmitter */
+
+MerkleSynchronizer::UpdateEmitter::UpdateEmitter(SceneGraphUpdateBatch* updates) : INodeVisitor(custom), updates(updates) {
+	assert(updates != 0);
+	isRefresh = false;
+	isSubtreeRoot = false;
+}
+
+void MerkleSynchronizer::UpdateEmitter::visit(Node* node) {
+	if (isRefresh) {
+		refresh(node);
+		return;
+	}
+	if (!isFirstVisit(node)) {
+		return;
+	}
+	Id id = node->getId();
+	updates->addNode(parentId, id, node->getAttributes(), true);
+}
+
+void MerkleSynchronizer::UpdateEmitter::visit(Group* node) {
+	if (isRefresh) {
+		refresh(node);
+		return;
+	}
+	if (!isFirstVisit(node)) {
+		return;
+	}
+	Id id = node->getId();
+	updates->addGroup(parentId, id, node->getAttributes(), true);
+	emitChildren(node);
+}
+
+void MerkleSynchronizer::UpdateEmitter::visit(Transform* node) {
+	UncertainTransform* uncertainTransform = dynamic_cast<UncertainTransform*>(node);
+	if (isRefresh) {
+		refresh(node);
+		if (uncertainTransform != 0) {
+			updates->setUncertainTransform(node->getId(), node->getLatestTransform(), uncertainTransform->getLatestTransformUncertainty(), node->getLatestTimeStamp());
+		} else {
+			updates->setTransform(node->getId(), node->getLatestTransform(), node->getLatestTimeStamp());
+		}
+		return;
+	}
+	if (!isFirstVisit(node)) {
+		return;
+	}
+	Id id = node->getId();
+	if (uncertainTransform != 0) {
+		updates->addUncertainTransformNode(parentId, id, node->getAttributes(), node->getLatestTransform(), uncertainTransform->getLatestTransformUncertainty(), node->getLatestTimeStamp(), true);
+	} else {
+		updates->addTransformNode(parentId, id, node->getAttributes(), node->getLatestTransform(), node->getLatestTimeStamp(), true);
+	}
+	emitChildren(node);
+}
+
+void MerkleSynchronizer::UpdateEmitter::visit(GeometricNode* node) {
+	if (isRefresh) { // the shape is immutable
+		refresh(node);
+		return;
+	}
+	if (!isFirstVisit(node)) {
+		return;
+	}
+	Id id = node->getId();
+	updates->addGeometricNode(parentId, id, node->getAttributes(), node->getShape(), node->getTimeStamp(), true);
+}
+
+void MerkleSynchronizer::UpdateEmitter::visit(Connection* connection) {
+	if (isRefresh) {
+		refresh(connection);
+		return;
+	}
+	bool isRoot = isSubtreeRoot;
+	if (!isFirstVisit(connection)) {
+		return;
+	}
+	pendingConnections.push_back(connection);
+	pendingConnectionParentIds.push_back(parentId);
+	pendingConnectionIsRequested.push_back(isRoot);
+}
+
+void MerkleSynchronizer::UpdateEmitter::prepareSubtree(Id parentId) {
+	this->parentId = parentId;
+	isRefresh = false;
+	isSubtreeRoot = true;
+}
+
+void MerkleSynchronizer::UpdateEmitter::prepareRefresh() {
+	isRefresh = true;
+	isSubtreeRoot = false;
+}
+
+void MerkleSynchronizer::UpdateEmitter::finish() {
+	for (unsigned int i = 0; i < pendingConnections.size(); ++i) {
+		Connection* connection = pendingConnections[i];
+		vector<Id> sourceIds;
+		vector<Id> targetIds;
+		bool isComplete = true;
+		for (unsigned int j = 0; j < connection->getNumberOfSourceNodes(); ++j) {
+			sourceIds.push_back(connection->getSourceNode(j)->getId());
+			isComplete &= (emittedIds.find(sourceIds.back()) != emittedIds.end());
+		}
+		for (unsigned int j = 0; j < connection->getNumberOfTargetNodes(); ++j) {
+			targetIds.push_back(connection->getTargetNode(j)->getId());
+			isComplete &= (emittedIds.find(targetIds.back()) != emittedIds.end());
+		}
+		if (!isComplete && !pendingConnectionIsRequested[i]) { // might refer to nodes that the replica does not have yet
+			LOG(DEBUG) << "MerkleSynchronizer: Deferring Connection " << connection->getId() << " as it refers to nodes outside of the current updates.";
+			continue;
+		}
+		Id connectionId = connection->getId();
+		updates->addConnection(pendingConnectionParentIds[i], connectionId, connection->getAttributes(), sourceIds, targetIds, connection->getStart(), connection->getEnd(), true);
+	}
+	pendingConnections.clear();
+	pendingConnectionParentIds.clear();
+	pendingConnectionIsRequested.clear();
+}
+
+bool MerkleSynchronizer::UpdateEmitter::isFirstVisit(Node* node) {
+	bool isRoot = isSubtreeRoot;
+	isSubtreeRoot = false;
+	if (!isRoot && node->getNumberOfParents() > 1) { // might exist at the replica already
+		return false;
+	}
+	return emittedIds.insert(node->getId()).second;
+}
+
+void MerkleSynchronizer::UpdateEmitter::emitChildren(Group* node) {
+	Id currentParentId = parentId;
+	parentId = node->getId();
+	for (unsigned int i = 0; i < node->getNumberOfChildren(); ++i) {
+		node->getChild(i)->acceptWithoutTraversal(this);
+	}
+	parentId = currentParentId;
+}
+
+void MerkleSynchronizer::UpdateEmitter::refresh(Node* node) {
+	updates->setNodeAttributes(node->getId(), node->getAttributes(), node->getAttributesTimeStamp());
+}
+
+/* MerkleSynchronizer */
+
+MerkleSynchronizer::MerkleSynchronizer(SceneGraphFacade* scene) : scene(scene) {
+	assert(scene != 0);
+}
+
+MerkleSynchronizer::~MerkleSynchronizer() {
+
+}
+
+std::string MerkleSynchronizer::getSubtreeHash(Id id) {
+	digestTraverser.reset();
+	if (!updateDigests(id)) {
+		return NodeHashTraverser::NIL;
+	}
+	return digestTraverser.getDigest(id).subtreeHash;
+}
+
+bool MerkleSynchronizer::getDigests(const std::vector<Id>& ids, std::vector<SubtreeDigest>& digests) {
+	digestTraverser.reset();
+	for (std::vector<Id>::const_iterator it = ids.begin(); it != ids.end(); ++it) {
+		if (!updateDigests(*it)) {
+			LOG(WARNING) << "MerkleSynchronizer: Cannot compute a digest for the unknown node " << *it;
+			continue;
+		}
+		digests.push_back(digestTraverser.getDigest(*it));
+	}
+	return true;
+}
+
+bool MerkleSynchronizer::getUpdates(const SyncRequest& request, SceneGraphUpdateBatch& updates) {
+	if (request.subtreeIds.size() != request.subtreeParentIds.size()) {
+		LOG(ERROR) << "MerkleSynchronizer: Request has a different number of subtree IDs and parent IDs.";
+		return false;
+	}
+
+	UpdateEmitter emitter(&updates);
+	for (std::vector<Id>::const_iterator it = request.refreshIds.begin(); it != request.refreshIds.end(); ++it) {
+		emitter.prepareRefresh();
+		if (!scene->executeGraphTraverser(&emitter, *it)) {
+			LOG(WARNING) << "MerkleSynchronizer: Cannot refresh the unknown node " << *it;
+		}
+	}
+	for (unsigned int i = 0; i < request.subtreeIds.size(); ++i) {
+		emitter.prepareSubtree(request.subtreeParentIds[i]);
+		if (!scene->executeGraphTraverser(&emitter, request.subtreeIds[i])) {
+			LOG(WARNING) << "MerkleSynchronizer: Cannot send the unknown subtree " << request.subtreeIds[i];
+		}
+	}
+	emitter.finish();
+
+	return true;
+}
+
+bool MerkleSynchronizer::handleRequest(const SyncRequest& request, std::vector<SubtreeDigest>& digests, SceneGraphUpdateBatch& updates) {
+	bool success = getUpdates(request, updates);
+	return getDigests(request.expandIds, digests) && success;
+}
+
+bool MerkleSynchronizer::compareDigests(const std::vector<SubtreeDigest>& remoteDigests, SyncRequest& request) {
+	request.clear();
+	digestTraverser.reset();
+	statistics.rounds++;
+	statistics.receivedDigests += remoteDigests.size();
+
+	for (std::vector<SubtreeDigest>::const_iterator remote = remoteDigests.begin(); remote != remoteDigests.end(); ++remote) {
+		if (!updateDigests(remote->id)) {
+			LOG(WARNING) << "MerkleSynchronizer: Received a digest for the unknown node " << remote->id;
+			continue;
+		}
+		const SubtreeDigest local = digestTraverser.getDigest(remote->id);
+		if (local.subtreeHash.compare(remote->subtreeHash) == 0) {
+			continue;
+		}
+
+		if (local.nodeHash.compare(remote->nodeHash) != 0) {
+			request.refreshIds.push_back(remote->id);
+			statistics.requestedRefreshes++;
+		}
+
+		/* children of the source */
+		std::set<Id> localChildIds(local.childIds.begin(), local.childIds.end());
+		std::set<Id> remoteChildIds;
+		for (unsigned int i = 0; i < remote->childIds.size() && i < remote->childHashes.size(); ++i) {
+			Id childId = remote->childIds[i];
+			remoteChildIds.insert(childId);
+
+			vector<Id> parentIds;
+			if (localChildIds.find(childId) == localChildIds.end()) {
+				if (!scene->getNodeParents(childId, parentIds)) { // completely new
+					request.subtreeIds.push_back(childId);
+					request.subtreeParentIds.push_back(remote->id);
+					request.expandIds.push_back(childId); // shared descendants are only resolved by the next digest
+					statistics.requestedSubtrees++;
+					continue;
+				}
+				if (scene->addParent(childId, remote->id)) { // exists elsewhere
+					statistics.addedParents++;
+				}
+			}
+
+			if (!updateDigests(childId) || digestTraverser.getDigest(childId).subtreeHash.compare(remote->childHashes[i]) != 0) {
+				request.expandIds.push_back(childId);
+			}
+		}
+
+		/* children that are not present at the source */
+		for (std::set<Id>::const_iterator it = localChildIds.begin(); it != localChildIds.end(); ++it) {
+			if (remoteChildIds.find(*it) != remoteChildIds.end()) {
+				continue;
+			}
+			vector<Id> parentIds;
+			scene->getNodeParents(*it, parentIds);
+			bool success = (parentIds.size() > 1) ? scene->removeParent(*it, remote->id) : scene->deleteNode(*it);
+			if (success) {
+				statistics.removedParents++;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool MerkleSynchronizer::updateDigests(Id id) {
+	if (digestTraverser.hasDigest(id)) {
+		return true;
+	}
+	return scene->executeGraphTraverser(&digestTraverser, id) && digestTraverser.hasDigest(id);
+}
+
+bool MerkleSynchronizer::synchronizeFrom(MerkleSynchronizer& source, Id rootId, unsigned int maxRounds) {
+	SyncRequest request;
+	std::vector<SubtreeDigest> digests;
+	SceneGraphUpdateBatch updates;
+	request.expandIds.push_back(rootId);
+
+	for (unsigned int round = 0; round < maxRounds && !request.isEmpty(); ++round) {
+		digests.clear();
+		updates.clear();
+		source.handleRequest(request, digests, updates);
+		if (!updates.isEmpty() && !scene->applyUpdateBatch(updates)) {
+			LOG(WARNING) << "MerkleSynchronizer: Updates cannot be applied as one transaction. Applying them one by one.";
+			updates.replay(scene);
+		}
+		compareDigests(digests, request);
+
+		if (request.isEmpty() && getSubtreeHash(rootId).compare(source.getSubtreeHash(rootId)) != 0) { // e.g. a deferred Connection
+			request.expandIds.push_back(rootId);
+		}
+	}
+
+	return request.isEmpty();
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
@@ -0,0 +1,225 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#ifndef RSG_MERKLESYNCHRONIZER_H_
+#define RSG_MERKLESYNCHRONIZER_H_
+
+#include "SceneGraphFacade.h"
+#include "SceneGraphUpdateBatch.h"
+#include "NodeHashTraverser.h"
+#include <vector>
+#include <set>
+#include <string>
+#include <boost/unordered_map.hpp>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Incremental synchronization of a sub graph between two scene graphs based on Merkle hashes.
+ * @ingroup sceneGraph
+ *
+ * One instance acts as source, the other one as replica of a sub graph that is identified by the
+ * same root Id on both sides (e.g. a remote root node). The protocol works in rounds, each consisting
+ * of one SyncRequest from the replica and one answer from the source:
+ *  1. The replica asks for the digests of a set of nodes, starting with the root of the sub graph.
+ *  2. The source answers with a SubtreeDigest per node: the subtree hash (as computed by the
+ *     NodeHashTraverser), the hash of the node itself and the subtree hashes of all children.
+ *  3. The replica compares them with its own graph. Children with equal hashes are skipped.
+ *     Children with different hashes are requested in the next round, children that do not exist
+ *     are requested as complete subtrees and children that are not present at the source are removed.
+ *     Nodes with different content (attributes or latest data) are requested for a refresh.
+ *  4. The source answers the subtree and refresh requests with the necessary updates and the
+ *     digests for the next round.
+ *
+ * So only the digests along the paths to a change and the changed data itself are transferred. The hashes
+ * include the time stamps of the latest transforms and geometries such that new data is detected.
+ * They are the binary 128 bit hashes of the NodeHashTraverser, transferred as hex strings.
+ * The transport is not part of this class: synchronizeFrom() connects two instances directly, while the
+ * JSONQueryRunner offers the source side as "SYNC_SUBTREES" query.
+ */
+class MerkleSynchronizer {
+public:
+
+	/// Hashes of a node and its direct children.
+	struct SubtreeDigest {
+		Id id;
+		std::string nodeHash;    ///< Hash of the node itself.
+		std::string subtreeHash; ///< Hash of the node including all descendants.
+		std::vector<Id> childIds;
+		std::vector<std::string> childHashes; ///< Subtree hash per child.
+	};
+
+	/// Message from the replica to the source.
+	struct SyncRequest {
+		std::vector<Id> expandIds;         ///< Nodes that the digests are requested for.
+		std::vector<Id> refreshIds;        ///< Existing nodes with outdated attributes or data.
+		std::vector<Id> subtreeIds;        ///< Missing nodes that are requested including all descendants...
+		std::vector<Id> subtreeParentIds;  ///< ...and the parent each of them is requested for.
+
+		bool isEmpty() const {
+			return expandIds.empty() && refreshIds.empty() && subtreeIds.empty();
+		}
+
+		void clear() {
+			expandIds.clear();
+			refreshIds.clear();
+			subtreeIds.clear();
+			subtreeParentIds.clear();
+		}
+	};
+
+	/// Counters of the replica side.
+	struct Statistics {
+		unsigned int rounds;
+		unsigned int receivedDigests;
+		unsigned int requestedSubtrees;
+		unsigned int requestedRefreshes;
+		unsigned int addedParents;
+		unsigned int removedParents;
+
+		Statistics() : rounds(0), receivedDigests(0), requestedSubtrees(0), requestedRefreshes(0), addedParents(0), removedParents(0) {};
+	};
+
+	MerkleSynchronizer(SceneGraphFacade* scene);
+	virtual ~MerkleSynchronizer();
+
+	/// Hash of a complete sub graph. Returns NodeHashTraverser::NIL if the node does not exist.
+	std::string getSubtreeHash(Id id);
+
+	/* Source side */
+
+	/// Compute the digests for the requested nodes. Unknown Ids are omitted.
+	bool getDigests(const std::vector<Id>& ids, std::vector<SubtreeDigest>& digests);
+
+	/**
+	 * @brief Emit the updates for the requested refreshes and subtrees.
+	 *
+	 * Descendants of a requested subtree that have further parents are skipped, as they might exist
+	 * at the replica already. They are requested in a later round. The same applies to Connections
+	 * that refer to nodes outside of the emitted updates. The updates can be used as one transaction.
+	 * @param request The request of the replica.
+	 * @param[out] updates The updates that need to be applied by the replica.
+	 */
+	bool getUpdates(const SyncRequest& request, SceneGraphUpdateBatch& updates);
+
+	/// Answer a request as a whole: digests for expandIds and updates for refreshIds and subtreeIds.
+	bool handleRequest(const SyncRequest& request, std::vector<SubtreeDigest>& digests, SceneGraphUpdateBatch& updates);
+
+	/* Replica side */
+
+	/**
+	 * @brief Compare digests of the source with the own graph.
+	 *
+	 * Structural differences that can be resolved locally, i.e. parent-child relations to already existing nodes
+	 * and children that are not present at the source, are directly applied to the scene.
+	 * @param remoteDigests Digests of the source as answer to the previous request.
+	 * @param[out] request The next request to the source. Empty, if the sub graph is in sync.
+	 */
+	bool compareDigests(const std::vector<SubtreeDigest>& remoteDigests, SyncRequest& request);
+
+	/**
+	 * @brief Synchronize a sub graph with a source instance in the same process.
+	 * @param source Synchronizer of the source scene.
+	 * @param rootId Id of the root of the sub graph. Has to exist in both scenes.
+	 * @param maxRounds Upper limit for the number of rounds.
+	 * @return True if both sub graphs have the same hash afterwards.
+	 */
+	bool synchronizeFrom(MerkleSynchronizer& source, Id rootId, unsigned int maxRounds = 1000);
+
+	const Statistics& getStatistics() const {
+		return statistics;
+	}
+
+	void resetStatistics() {
+		statistics = Statistics();
+	}
+
+protected:
+
+	/// NodeHashTraverser that additionally records the digests of all visited nodes.
+	class DigestTraverser : public NodeHashTraverser {
+	public:
+		DigestTraverser();
+		virtual ~DigestTraverser(){};
+
+		virtual void visit(Node* node);
+		virtual void visit(Group* node);
+		virtual void visit(Connection* connection);
+
+		void reset();
+		bool hasDigest(Id id) const;
+		const SubtreeDigest& getDigest(Id id) const;
+
+	private:
+		void recordDigest(Node* node);
+		boost::unordered_map<Id, SubtreeDigest> digestLookUpTable;
+	};
+
+	/// Emits the updates to create a subtree or to refresh a node.
+	class UpdateEmitter : public INodeVisitor {
+	public:
+		UpdateEmitter(SceneGraphUpdateBatch* updates);
+		virtual ~UpdateEmitter(){};
+
+		virtual void visit(Node* node);
+		virtual void visit(Group* node);
+		virtual void visit(Transform* node);
+		virtual void visit(GeometricNode* node);
+		virtual void visit(Connection* connection);
+
+		/// Next visited node will be created as child of parentId, including its descendants.
+		void prepareSubtree(Id parentId);
+
+		/// Next visited node will be refreshed.
+		void prepareRefresh();
+
+		/// Emit all deferred Connections.
+		void finish();
+
+	private:
+		bool isFirstVisit(Node* node);
+		void emitChildren(Group* node);
+		void refresh(Node* node);
+
+		SceneGraphUpdateBatch* updates;
+		Id parentId;
+		bool isRefresh;
+		bool isSubtreeRoot;
+		std::set<Id> emittedIds;
+		std::vector<Connection*> pendingConnections;
+		std::vector<Id> pendingConnectionParentIds;
+		std::vector<bool> pendingConnectionIsRequested; ///< Explicitly requested Connections are expected to refer to existing nodes.
+	};
+
+	/// Compute the digests of a sub graph, unless it is known already.
+	bool updateDigests(Id id);
+
+	SceneGraphFacade* scene;
+	DigestTraverser digestTraverser;
+	Statistics statistics;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_MERKLESYNCHRONIZER_H_ */
+
+/* EOF */
@@ -18,6 +18,7 @@
 ******************************************************************************/
 
 #include "Node.h"
+#include "GraphTraverser.h"
 #include "Attribute.h"
 #include <stdexcept>
 
@@ -29,6 +30,7 @@ Node::Node() {
 	this->id = 0;
 	this->attributes.clear();
 	this->parents.clear();
+	this->attributesHashIsValid = false;
 }
 
 Node::~Node() {
@@ -48,6 +50,21 @@ Id Node::getId() const
 void Node::setAttributes(vector<Attribute> attributes)
 {
     this->attributes = attributes;
+    this->attributesHashIsValid = false;
+}
+
+bool Node::getCachedAttributesHash(Hash128& hash) const
+{
+    if (attributesHashIsValid) {
+        hash = attributesHash;
+    }
+    return attributesHashIsValid;
+}
+
+void Node::setCachedAttributesHash(const Hash128& hash)
+{
+    this->attributesHash = hash;
+    this->attributesHashIsValid = true;
 }
 
 void Node::setId(Id id)
@@ -89,13 +106,11 @@ unsigned int Node::getNumberOfParents() const {
 }
 
 void Node::accept(INodeVisitor* visitor) {
+	GraphTraverser::traverse(this, visitor);
+}
+
+void Node::acceptWithoutTraversal(INodeVisitor* visitor) {
 	visitor->visit(this);
-	if (visitor->getDirection() == INodeVisitor::upwards) {
-	    for(unsigned i = 0; i < getNumberOfParents(); ++i) // recursively go up the graph structure
-	    {
-	        getParent(i)->accept(visitor);
-	    }
-	}
 }
 
 } // namespace brics_3d::RSG
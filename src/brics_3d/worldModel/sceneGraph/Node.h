@@ -27,6 +27,7 @@
 #include "Attribute.h"
 #include "TimeStamp.h"
 #include "INodeVisitor.h"
+#include "Hash128.h"
 
 using std::vector;
 
@@ -85,8 +86,28 @@ public:
         this->attributesTimeStamp = attributesTimeStamp;
     }
 
+    /**
+     * @brief Get the cached binary hash of the attributes.
+     * @see NodeHash::attributesToHash128()
+     * @param[out] hash The cached hash.
+     * @return False if there is no valid cached hash, e.g. because the attributes have been changed.
+     */
+    bool getCachedAttributesHash(Hash128& hash) const;
+
+    /// Store the binary hash of the attributes. It will be invalidated by setAttributes().
+    void setCachedAttributesHash(const Hash128& hash);
+
+    /**
+     * Traverse the graph starting at this node and call the visitor for every reached node.
+     * The traversal is performed iteratively by the GraphTraverser.
+     * Visitors with a custom direction that recurse on their own should use
+     * acceptWithoutTraversal() for the children instead.
+     */
     virtual void accept(INodeVisitor* visitor);
 
+    /// Call the type specific visit function of the visitor for this node only.
+    virtual void acceptWithoutTraversal(INodeVisitor* visitor);
+
 
 private:
 
@@ -100,6 +121,12 @@ private:
 	/// List of attributes for each node. Can be used to attach (semantic) tags.
 	vector<Attribute> attributes;
 
+	/// Cached hash of the attributes.
+	Hash128 attributesHash;
+
+	/// True if attributesHash corresponds to the current attributes.
+	bool attributesHashIsValid;
+
 	/// Time stamp to represent the last modification
 	TimeStamp attributesTimeStamp;
 
@@ -18,9 +18,12 @@
  ******************************************************************************/
 
 #include "NodeHash.h"
+#include "Transform.h"
+#include "GeometricNode.h"
 #include "hash/sha256.h"
 
 #include <sstream>
+#include <cmath>
 
 namespace brics_3d {
 namespace rsg {
@@ -56,7 +59,7 @@ std::string NodeHash::sortStringsAndHash(std::vector<std::string> strings) {
 	return sha256.getHash();
 }
 
-std::string NodeHash::nodeToHash(Node* node, bool useNodeId) {
+std::string NodeHash::nodeToHash(Node* node, bool useNodeId, bool useTimeStamps) {
 	std::vector<std::string> hashes;
 	if(useNodeId) {
 		hashes.push_back(idToHash(node->getId()));
@@ -64,9 +67,173 @@ std::string NodeHash::nodeToHash(Node* node, bool useNodeId) {
 		hashes.push_back("Node"); // Add the same hash for all Nodes, rather than its id.
 	}
 	hashes.push_back(attributesToHash(node->getAttributes()));
+
+	if(useTimeStamps) {
+		Transform* transform = dynamic_cast<Transform*>(node);
+		GeometricNode* geometricNode = dynamic_cast<GeometricNode*>(node);
+		if (transform != 0) {
+			hashes.push_back(timeStampToHash(transform->getLatestTimeStamp()));
+		} else if (geometricNode != 0) {
+			hashes.push_back(timeStampToHash(geometricNode->getTimeStamp()));
+		}
+	}
 	return sortStringsAndHash(hashes);
 }
 
+std::string NodeHash::timeStampToHash(TimeStamp timeStamp) {
+	std::stringstream ss;
+	ss << "TimeStamp" << static_cast<long long>(floor(timeStamp.getSeconds() * 1.0e6 + 0.5)); // robust against rounding errors of serializations
+	SHA256 sha256;
+	sha256(ss.str());
+	return sha256.getHash();
+}
+
+/* MurmurHash3 by Austin Appleby (public domain), with explicit little endian loads */
+
+static inline boost::uint64_t rotl64(boost::uint64_t x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline boost::uint64_t fmix64(boost::uint64_t k) {
+	k ^= k >> 33;
+	k *= 0xff51afd7ed558ccdULL;
+	k ^= k >> 33;
+	k *= 0xc4ceb9fe1a85ec53ULL;
+	k ^= k >> 33;
+	return k;
+}
+
+static inline boost::uint64_t load64(const unsigned char* data) {
+	boost::uint64_t value = 0;
+	for (int i = 7; i >= 0; --i) {
+		value = (value << 8) | data[i];
+	}
+	return value;
+}
+
+static inline void store64(boost::uint64_t value, unsigned char* data) {
+	for (int i = 0; i < 8; ++i) {
+		data[i] = static_cast<unsigned char>(value >> (8 * i));
+	}
+}
+
+Hash128 NodeHash::bytesToHash128(const void* key, size_t length, boost::uint64_t seed) {
+	const unsigned char* data = static_cast<const unsigned char*>(key);
+	const size_t numberOfBlocks = length / 16;
+	const boost::uint64_t c1 = 0x87c37b91114253d5ULL;
+	const boost::uint64_t c2 = 0x4cf5ad432745937fULL;
+	boost::uint64_t h1 = seed;
+	boost::uint64_t h2 = seed;
+
+	for (size_t i = 0; i < numberOfBlocks; ++i) {
+		boost::uint64_t k1 = load64(data + i * 16);
+		boost::uint64_t k2 = load64(data + i * 16 + 8);
+
+		k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+		h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+		k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+		h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+	}
+
+	const unsigned char* tail = data + numberOfBlocks * 16;
+	boost::uint64_t k1 = 0;
+	boost::uint64_t k2 = 0;
+	switch (length & 15) {
+	case 15: k2 ^= static_cast<boost::uint64_t>(tail[14]) << 48;
+	case 14: k2 ^= static_cast<boost::uint64_t>(tail[13]) << 40;
+	case 13: k2 ^= static_cast<boost::uint64_t>(tail[12]) << 32;
+	case 12: k2 ^= static_cast<boost::uint64_t>(tail[11]) << 24;
+	case 11: k2 ^= static_cast<boost::uint64_t>(tail[10]) << 16;
+	case 10: k2 ^= static_cast<boost::uint64_t>(tail[9]) << 8;
+	case 9:  k2 ^= static_cast<boost::uint64_t>(tail[8]);
+		k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+	case 8:  k1 ^= static_cast<boost::uint64_t>(tail[7]) << 56;
+	case 7:  k1 ^= static_cast<boost::uint64_t>(tail[6]) << 48;
+	case 6:  k1 ^= static_cast<boost::uint64_t>(tail[5]) << 40;
+	case 5:  k1 ^= static_cast<boost::uint64_t>(tail[4]) << 32;
+	case 4:  k1 ^= static_cast<boost::uint64_t>(tail[3]) << 24;
+	case 3:  k1 ^= static_cast<boost::uint64_t>(tail[2]) << 16;
+	case 2:  k1 ^= static_cast<boost::uint64_t>(tail[1]) << 8;
+	case 1:  k1 ^= static_cast<boost::uint64_t>(tail[0]);
+		k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+	}
+
+	h1 ^= length;
+	h2 ^= length;
+	h1 += h2;
+	h2 += h1;
+	h1 = fmix64(h1);
+	h2 = fmix64(h2);
+	h1 += h2;
+	h2 += h1;
+
+	return Hash128(h1, h2);
+}
+
+/* distinct seeds keep hashes of different kinds of data apart */
+static const boost::uint64_t idSeed = 0x4964; // "Id"
+static const boost::uint64_t attributeSeed = 0x417474; // "Att"
+static const boost::uint64_t timeStampSeed = 0x5374616d70; // "Stamp"
+static const boost::uint64_t combineSeed = 0x436f6d62; // "Comb"
+static const boost::uint64_t nodeSeed = 0x4e6f6465; // "Node"
+
+Hash128 NodeHash::idToHash128(Id id) {
+	return bytesToHash128(id.begin(), id.size(), idSeed);
+}
+
+Hash128 NodeHash::attributesToHash128(const std::vector<Attribute>& attributes) {
+	Hash128 sum;
+	for (std::vector<Attribute>::const_iterator it = attributes.begin(); it != attributes.end(); ++it) {
+		Hash128 keyHash = bytesToHash128(it->key.data(), it->key.size(), attributeSeed);
+		Hash128 valueHash = bytesToHash128(it->value.data(), it->value.size(), keyHash.low ^ keyHash.high); // chained, so key and value are not interchangeable
+		sum += valueHash;
+	}
+	return combineHash128(Hash128(0, attributes.size()), sum);
+}
+
+Hash128 NodeHash::timeStampToHash128(TimeStamp timeStamp) {
+	unsigned char data[8];
+	store64(static_cast<boost::uint64_t>(static_cast<long long>(floor(timeStamp.getSeconds() * 1.0e6 + 0.5))), data); // robust against rounding errors of serializations
+	return bytesToHash128(data, sizeof(data), timeStampSeed);
+}
+
+Hash128 NodeHash::combineHash128(const Hash128& first, const Hash128& second) {
+	unsigned char data[32];
+	store64(first.high, data);
+	store64(first.low, data + 8);
+	store64(second.high, data + 16);
+	store64(second.low, data + 24);
+	return bytesToHash128(data, sizeof(data), combineSeed);
+}
+
+Hash128 NodeHash::nodeToHash128(Node* node, bool useNodeId, bool useTimeStamps) {
+	Hash128 hash;
+	if(useNodeId) {
+		hash = idToHash128(node->getId());
+	} else {
+		hash = Hash128(0, nodeSeed); // Add the same hash for all Nodes, rather than its id.
+	}
+
+	Hash128 attributesHash;
+	if (!node->getCachedAttributesHash(attributesHash)) {
+		attributesHash = attributesToHash128(node->getAttributes());
+		node->setCachedAttributesHash(attributesHash);
+	}
+	hash = combineHash128(hash, attributesHash);
+
+	if(useTimeStamps) {
+		Transform* transform = dynamic_cast<Transform*>(node);
+		GeometricNode* geometricNode = dynamic_cast<GeometricNode*>(node);
+		if (transform != 0) {
+			hash = combineHash128(hash, timeStampToHash128(transform->getLatestTimeStamp()));
+		} else if (geometricNode != 0) {
+			hash = combineHash128(hash, timeStampToHash128(geometricNode->getTimeStamp()));
+		}
+	}
+	return hash;
+}
+
 
 } /* namespace rsg */
 } /* namespace brics_3d */
@@ -22,6 +22,7 @@
 
 #include "Node.h"
 #include "Group.h"
+#include "Hash128.h"
 
 namespace brics_3d {
 namespace rsg {
@@ -43,9 +44,51 @@ public:
 	 * @param[in] node Pointer to node.
 	 * @param[in] useNodeId If true, the node id will be considered for the hash. Default is true.
 	 *            Set it to false when you are interested in the general structure, rather than individuals with concrete UUIDs.
+	 * @param[in] useTimeStamps If true, the latest time stamp of a Transform or the time stamp of a GeometricNode
+	 *            will be considered for the hash, such that new data changes the hash. Default is false.
 	 * @return A string representing the hash.
 	 */
-	static std::string nodeToHash(Node* node, bool useNodeId = true);
+	static std::string nodeToHash(Node* node, bool useNodeId = true, bool useTimeStamps = false);
+
+	/// Hash of a time stamp with a resolution of one microsecond.
+	static std::string timeStampToHash(TimeStamp timeStamp);
+
+	/*
+	 * Binary hashing: Fast non-cryptographic 128 bit hashes (MurmurHash3) that avoid any string conversions.
+	 * They are not compatible with the SHA256 based hashes above.
+	 */
+
+	/// MurmurHash3 (x64, 128 bit) of a byte sequence. The result does not depend on the endianness of the host.
+	static Hash128 bytesToHash128(const void* data, size_t length, boost::uint64_t seed = 0);
+
+	/// Hash of the raw bytes of an Id.
+	static Hash128 idToHash128(Id id);
+
+	/// Hash of an attribute list. The order of the attributes does not matter.
+	static Hash128 attributesToHash128(const std::vector<Attribute>& attributes);
+
+	/// Hash of a time stamp with a resolution of one microsecond.
+	static Hash128 timeStampToHash128(TimeStamp timeStamp);
+
+	/**
+	 * @brief Combine an ordered pair of hashes into a new one.
+	 * Use the Hash128::operator+=() to combine an unordered set of hashes beforehand.
+	 */
+	static Hash128 combineHash128(const Hash128& first, const Hash128& second);
+
+	/**
+	 * @brief Get a binary 128 bit hash from a Node.
+	 *
+	 * Same as nodeToHash() but based on the binary hashing functions. The hash of the attributes
+	 * is cached within the node, and it is only recomputed when the attributes have been changed.
+	 *
+	 * @param[in] node Pointer to node.
+	 * @param[in] useNodeId If true, the node id will be considered for the hash. Default is true.
+	 * @param[in] useTimeStamps If true, the latest time stamp of a Transform or the time stamp of a GeometricNode
+	 *            will be considered for the hash. Default is false.
+	 * @return The hash.
+	 */
+	static Hash128 nodeToHash128(Node* node, bool useNodeId = true, bool useTimeStamps = false);
 
 };
 
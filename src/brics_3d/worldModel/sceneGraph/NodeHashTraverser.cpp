@@ -34,16 +34,39 @@ NodeHashTraverser::~NodeHashTraverser() {
 }
 
 void NodeHashTraverser::visit(Node* node) {
-	string nodeHash = NodeHash::nodeToHash(node, useNodeIds);
+	if (hashType == BINARY_128) {
+		binaryHashLookUpTable.insert(std::make_pair(node->getId(), NodeHash::nodeToHash128(node, useNodeIds, useTimeStamps)));
+		return;
+	}
+
+	string nodeHash = NodeHash::nodeToHash(node, useNodeIds, useTimeStamps);
 	hashLookUpTable.insert(std::make_pair(node->getId(), nodeHash));
 	LOG(DEBUG) << "NodeHashTraverser: hash for Node:  " << node->getId() << " = " << nodeHash;
 }
 
 void NodeHashTraverser::visit(Group* node) {
+	if (hashType == BINARY_128) {
+		Hash128 childHashes; // sum, independent of the order
+		for(unsigned i = 0; i < node->getNumberOfChildren(); ++i) {
+			Node* child = node->getChild(i).get();
+			std::map<Id, Hash128>::iterator childHash = binaryHashLookUpTable.find(child->getId());
+			if (childHash == binaryHashLookUpTable.end()) { // shared sub graphs are only hashed once
+				child->acceptWithoutTraversal(this);
+				childHash = binaryHashLookUpTable.find(child->getId());
+			}
+			if (childHash != binaryHashLookUpTable.end()) {
+				childHashes += childHash->second;
+			}
+		}
+		Hash128 groupHash = NodeHash::combineHash128(NodeHash::nodeToHash128(node, useNodeIds, useTimeStamps), childHashes);
+		binaryHashLookUpTable.insert(std::make_pair(node->getId(), groupHash));
+		return;
+	}
+
 	std::vector<std::string> hashes;
 	for(unsigned i = 0; i < node->getNumberOfChildren(); ++i) { // recursively go down the graph structure
 		// calculate hashes recursively
-		node->getChild(i)->accept(this);
+		node->getChild(i)->acceptWithoutTraversal(this);
 
 		// collect all hashes of children in one set
 		string hash = getHashById(node->getChild(i)->getId());
@@ -51,7 +74,7 @@ void NodeHashTraverser::visit(Group* node) {
 	}
 
 	// calculate hash part one: attributes an id this node
-	string nodeHash = NodeHash::nodeToHash(node, useNodeIds);
+	string nodeHash = NodeHash::nodeToHash(node, useNodeIds, useTimeStamps);
 	hashes.push_back(nodeHash);
 
 	// calculate hash part two: combine node hash with the child hashes to a combined group hash
@@ -71,6 +94,21 @@ void NodeHashTraverser::visit(GeometricNode* node) {
 }
 
 void NodeHashTraverser::visit(Connection* connection) {
+	if (hashType == BINARY_128) {
+		/* The IDs of the references are hashed, as the referenced nodes might not have been visited yet. */
+		Hash128 sourceHashes;
+		Hash128 targetHashes;
+		for(unsigned i = 0; i < connection->getNumberOfSourceNodes(); ++i) {
+			sourceHashes += NodeHash::idToHash128(connection->getSourceNode(i)->getId());
+		}
+		for(unsigned i = 0; i < connection->getNumberOfTargetNodes(); ++i) {
+			targetHashes += NodeHash::idToHash128(connection->getTargetNode(i)->getId());
+		}
+		Hash128 connectionHash = NodeHash::combineHash128(NodeHash::nodeToHash128(connection, useNodeIds, useTimeStamps), NodeHash::combineHash128(sourceHashes, targetHashes));
+		binaryHashLookUpTable.insert(std::make_pair(connection->getId(), connectionHash));
+		return;
+	}
+
 	std::vector<std::string> hashes;
 
 	// collect all hashes of source and target IDs in one set
@@ -85,7 +123,7 @@ void NodeHashTraverser::visit(Connection* connection) {
 	}
 
 	// calculate hash part one: attributes an id this node
-	string nodeHash = NodeHash::nodeToHash(connection, useNodeIds);
+	string nodeHash = NodeHash::nodeToHash(connection, useNodeIds, useTimeStamps);
 	hashes.push_back(nodeHash);
 
 	// calculate hash part two: combine node hash with the source/target hashes to a combined connection hash
@@ -95,12 +133,33 @@ void NodeHashTraverser::visit(Connection* connection) {
 	LOG(DEBUG) << "NodeHashTraverser: hash for Connection: " << connection->getId() << " = " << connectionHash;
 }
 
-void NodeHashTraverser::reset(bool useNodeIds) {
+void NodeHashTraverser::reset(bool useNodeIds, bool useTimeStamps, HashType hashType) {
 	this->useNodeIds = useNodeIds;
+	this->useTimeStamps = useTimeStamps;
+	this->hashType = hashType;
 	hashLookUpTable.clear();
+	binaryHashLookUpTable.clear();
+}
+
+bool NodeHashTraverser::getHash128ById(Id id, Hash128& hash) {
+	std::map<Id, Hash128>::const_iterator binaryHashIterator = binaryHashLookUpTable.find(id);
+	if (binaryHashIterator != binaryHashLookUpTable.end()) {
+		hash = binaryHashIterator->second;
+		return true;
+	}
+	return false;
 }
 
 std::string NodeHashTraverser::getHashById(Id id) {
+	if (hashType == BINARY_128) {
+		Hash128 hash;
+		if (getHash128ById(id, hash)) {
+			return hash.toString();
+		}
+		LOG(ERROR) << "NodeHashTraverser: Hash look up failed for ID " << id;
+		return NIL;
+	}
+
 	hashIterator = hashLookUpTable.find(id);
 	if (hashIterator != hashLookUpTable.end()) {
 		return hashIterator->second;
@@ -120,6 +179,14 @@ std::string NodeHashTraverser::getJSON() {
 	out << "  \"hashes\": [" << std::endl;
 
 
+	for(std::map<Id, Hash128>::const_iterator it = binaryHashLookUpTable.begin(); it != binaryHashLookUpTable.end();) {
+		out << "    [\"" << it->first.toString() << "\", \"" << it->second.toString() << "\"]";
+		if (++it != binaryHashLookUpTable.end()) { // last elements should not get a comma
+			out << ",";
+		}
+		out << std::endl;
+	}
+
 	for(hashIterator = hashLookUpTable.begin(); hashIterator != hashLookUpTable.end();) {
 		out << "    [\"" << hashIterator->first.toString() << "\", \"" << hashIterator->second << "\"]";
 		if (++hashIterator != hashLookUpTable.end()) { // last elements should not get a comma
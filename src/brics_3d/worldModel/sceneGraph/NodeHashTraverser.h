@@ -28,6 +28,7 @@
 #include "UncertainTransform.h"
 #include "GeometricNode.h"
 #include "Shape.h"
+#include "Hash128.h"
 #include <map>
 
 namespace brics_3d {
@@ -46,9 +47,19 @@ namespace rsg {
  * for the root node when IDs are not taken into account.
  *
  * After the traversal every node can be queried to retrieve its hash value.
+ *
+ * Two hash types are available. The default SHA256_STRINGS computes SHA256 hashes of hex strings. BINARY_128
+ * uses the binary 128 bit hashes of the NodeHash. Child hashes are summed up instead of being sorted,
+ * the attribute hashes are cached within the nodes and shared sub graphs are only hashed once.
+ * This is orders of magnitudes faster for large graphs. Only hashes of the same type can be compared.
  */
 class NodeHashTraverser : public INodeVisitor {
 public:
+	enum HashType {
+		SHA256_STRINGS,
+		BINARY_128
+	};
+
 	NodeHashTraverser();
 	virtual ~NodeHashTraverser();
 
@@ -61,8 +72,10 @@ public:
 	/**
 	 * @brief Resets the results of a traversal.
 	 * @param useNodeIds @see useNodeIds
+	 * @param useTimeStamps @see useTimeStamps
+	 * @param hashType @see hashType
 	 */
-	void reset(bool useNodeIds = true);
+	void reset(bool useNodeIds = true, bool useTimeStamps = false, HashType hashType = SHA256_STRINGS);
 
 	/**
 	 * @brief Get hash for a Node identified by an ID.
@@ -73,6 +86,15 @@ public:
 	 */
 	std::string getHashById(Id id);
 
+	/**
+	 * @brief Get the binary hash for a Node identified by an ID.
+	 * @note Only available for the BINARY_128 hash type. The traverser has to be executed first!
+	 * @param[in] id Id if node.
+	 * @param[out] hash The hash.
+	 * @return False if there is no hash for the ID.
+	 */
+	bool getHash128ById(Id id, Hash128& hash);
+
 	/// A null / NIL representation of a hash.
 	/// Compare to this string in order to see if there was an error.
 	static const string NIL;
@@ -108,6 +130,16 @@ protected:
 	/// Set it to false when you are interested in the general structure, rather than individuals with concrete UUIDs.
     bool useNodeIds;
 
+    /// Table for the BINARY_128 hash type.
+    std::map<Id, Hash128> binaryHashLookUpTable;
+
+    /// Type of the computed hashes. Default is SHA256_STRINGS.
+    HashType hashType;
+
+    /// If true, the latest time stamps of Transforms and GeometricNodes will be considered for the hash. Default is false.
+    /// Set it to true to detect new data, e.g. for synchronization.
+    bool useTimeStamps;
+
 };
 
 } /* namespace rsg */
@@ -0,0 +1,454 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#include "RateLimitingUpdateFilter.h"
+#include <brics_3d/core/Logger.h>
+#include <algorithm>
+
+using brics_3d::Logger;
+
+namespace brics_3d {
+namespace rsg {
+
+RateLimitingUpdateFilter::RateLimitingUpdateFilter() :
+		maxTransformUpdateFrequency(-1.0),
+		maxGeometricNodeUpdateFrequency(-1.0),
+		burstSize(1.0),
+		forwardedUpdateCount(0),
+		coalescedUpdateCount(0),
+		flushThread(0),
+		flushIntervalInMs(10) {
+
+}
+
+RateLimitingUpdateFilter::~RateLimitingUpdateFilter() {
+	stopFlushThread();
+}
+
+double RateLimitingUpdateFilter::now() {
+	return static_cast<double>(timer.getCurrentTime()) / 1000.0;
+}
+
+bool RateLimitingUpdateFilter::takeToken(BucketMap& buckets, Id key, double rate, double currentTime) {
+	if (rate <= 0) { // the limit has been disabled while updates were pending
+		return true;
+	}
+
+	BucketMap::iterator bucketIterator = buckets.find(key);
+	if (bucketIterator == buckets.end()) {
+		TokenBucket bucket;
+		bucket.tokens = burstSize;
+		bucket.lastRefill = currentTime;
+		bucketIterator = buckets.insert(std::make_pair(key, bucket)).first;
+	}
+
+	TokenBucket& bucket = bucketIterator->second;
+	bucket.tokens = std::min(burstSize, bucket.tokens + (currentTime - bucket.lastRefill) * rate);
+	bucket.lastRefill = currentTime;
+	if (bucket.tokens >= 1.0) {
+		bucket.tokens -= 1.0;
+		return true;
+	}
+	return false;
+}
+
+void RateLimitingUpdateFilter::forwardTransform(Id id, const PendingTransform& update) {
+	std::vector<ISceneGraphUpdateObserver*>::iterator observerIterator;
+	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
+		if (update.uncertainty != 0) {
+			(*observerIterator)->setUncertainTransform(id, update.transform, update.uncertainty, update.timeStamp);
+		} else {
+			(*observerIterator)->setTransform(id, update.transform, update.timeStamp);
+		}
+	}
+	forwardedUpdateCount++;
+}
+
+void RateLimitingUpdateFilter::forwardGeometricNode(Id parentId, PendingGeometricNode& update) {
+	std::vector<ISceneGraphUpdateObserver*>::iterator observerIterator;
+	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
+		(*observerIterator)->addGeometricNode(parentId, update.id, update.attributes, update.shape, update.timeStamp, update.forcedId);
+	}
+	forwardedUpdateCount++;
+}
+
+bool RateLimitingUpdateFilter::resolveGeometricNodeReference(Id id) {
+	if (supersededGeometricNodes.find(id) != supersededGeometricNodes.end()) {
+		return false;
+	}
+
+	std::map<Id, Id>::iterator parentIterator = pendingGeometricNodeParents.find(id);
+	if (parentIterator != pendingGeometricNodeParents.end()) {
+		Id parentId = parentIterator->second;
+		std::map<Id, PendingGeometricNode>::iterator pendingIterator = pendingGeometricNodes.find(parentId);
+		assert(pendingIterator != pendingGeometricNodes.end());
+		LOG(DEBUG) << "RateLimitingUpdateFilter: Forwarding pending geometric node " << id << " ahead of time as it is referred to by another update.";
+		forwardGeometricNode(parentId, pendingIterator->second);
+		pendingGeometricNodes.erase(pendingIterator);
+		pendingGeometricNodeParents.erase(parentIterator);
+	}
+	return true;
+}
+
+bool RateLimitingUpdateFilter::addNode(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId) {
+	boost::mutex::scoped_lock lock(filterMutex);
+	if (!resolveGeometricNodeReference(parentId)) {
+		return false;
+	}
+
+	/* Call _all_ observers  */
+	std::vector<ISceneGraphUpdateObserver*>::iterator observerIterator;
+	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
+		(*observerIterator)->addNode(parentId, assignedId, attributes, forcedId);
+	}
+	forwardedUpdateCount++;
+	return true;
+}
+
+bool RateLimitingUpdateFilter::addGroup(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId) {
+	boost::mutex::scoped_lock lock(filterMutex);
+	if (!resolveGeometricNodeReference(parentId)) {
+		return false;
+	}
+
+	/* Call _all_ observers  */
+	std::vector<ISceneGraphUpdateObserver*>::iterator observerIterator;
+	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
+		(*observerIterator)->addGroup(parentId, assignedId, attributes, forcedId);
+	}
+	forwardedUpdateCount++;
+	return true;
+}
+
+bool RateLimitingUpdateFilter::addTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes,
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp, bool forcedId) {
+	boost::mutex::scoped_lock lock(filterMutex);
+	if (!resolveGeometricNodeReference(parentId)) {
+		return false;
+	}
+
+	/* Call _all_ observers  */
+	std::vector<ISceneGraphUpdateObserver*>::iterator observerIterator;
+	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
+		(*observerIterator)->addTransformNode(parentId, assignedId, attributes, transform, timeStamp, forcedId);
+	}
+	forwardedUpdateCount++;
+	return true;
+}
+
+bool RateLimitingUpdateFilter::addUncertainTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes,
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty,
+		TimeStamp timeStamp, bool forcedId) {
+	boost::mutex::scoped_lock lock(filterMutex);
+	if (!resolveGeometricNodeReference(parentId)) {
+		return false;
+	}
+
+	/* Call _all_ observers  */
+	std::vector<ISceneGraphUpdateObserver*>::iterator observerIterator;
+	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
+		(*observerIterator)->addUncertainTransformNode(parentId, assignedId, attributes, transform, uncertainty, timeStamp, forcedId);
+	}
+	forwardedUpdateCount++;
+	return true;
+}
+
+bool RateLimitingUpdateFilter::addGeometricNode(Id parentId, Id& assignedId, vector<Attribute> attributes,
+		Shape::ShapePtr shape, TimeStamp timeStamp, bool forcedId) {
+	boost::mutex::scoped_lock lock(filterMutex);
+	if (!resolveGeometricNodeReference(parentId)) {
+		return false;
+	}
+
+	PendingGeometricNode update;
+	update.id = assignedId;
+	update.attributes = attributes;
+	update.shape = shape;
+	update.timeStamp = timeStamp;
+	update.forcedId = forcedId;
+
+	if (maxGeometricNodeUpdateFrequency <= 0) {
+		forwardGeometricNode(parentId, update);
+		return true;
+	}
+
+	/* The new node supersedes a pending one of the same parent */
+	std::map<Id, PendingGeometricNode>::iterator pendingIterator = pendingGeometricNodes.find(parentId);
+	if (pendingIterator != pendingGeometricNodes.end()) {
+		LOG(DEBUG) << "RateLimitingUpdateFilter: Geometric node " << pendingIterator->second.id << " is superseded by " << assignedId;
+		supersededGeometricNodes.insert(pendingIterator->second.id);
+		pendingGeometricNodeParents.erase(pendingIterator->second.id);
+		pendingGeometricNodes.erase(pendingIterator);
+		coalescedUpdateCount++;
+	}
+
+	if (takeToken(geometricNodeBuckets, parentId, maxGeometricNodeUpdateFrequency, now())) {
+		forwardGeometricNode(parentId, update);
+	} else {
+		pendingGeometricNodes.insert(std::make_pair(parentId, update));
+		pendingGeometricNodeParents.insert(std::make_pair(assignedId, parentId));
+	}
+	return true;
+}
+
+bool RateLimitingUpdateFilter::addRemoteRootNode(Id rootId, vector<Attribute> attributes) {
+	boost::mutex::scoped_lock lock(filterMutex);
+
+	/* Call _all_ observers  */
+	std::vector<ISceneGraphUpdateObserver*>::iterator observerIterator;
+	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
+		(*observerIterator)->addRemoteRootNode(rootId, attributes);
+	}
+	forwardedUpdateCount++;
+	return true;
+}
+
+bool RateLimitingUpdateFilter::addConnection(Id parentId, Id& assignedId, vector<Attribute> attributes, vector<Id> sourceIds,
+		vector<Id> targetIds, TimeStamp start, TimeStamp end, bool forcedId) {
+	boost::mutex::scoped_lock lock(filterMutex);
+	bool referencesAreValid = resolveGeometricNodeReference(parentId);
+	for (vector<Id>::iterator it = sourceIds.begin(); it != sourceIds.end(); ++it) {
+		referencesAreValid = resolveGeometricNodeReference(*it) && referencesAreValid;
+	}
+	for (vector<Id>::iterator it = targetIds.begin(); it != targetIds.end(); ++it) {
+		referencesAreValid = resolveGeometricNodeReference(*it) && referencesAreValid;
+	}
+	if (!referencesAreValid) {
+		return false;
+	}
+
+	/* Call _all_ observers  */
+	std::vector<ISceneGraphUpdateObserver*>::iterator observerIterator;
+	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
+		(*observerIterator)->addConnection(parentId, assignedId, attributes, sourceIds, targetIds, start, end, forcedId);
+	}
+	forwardedUpdateCount++;
+	return true;
+}
+
+bool RateLimitingUpdateFilter::setNodeAttributes(Id id, vector<Attribute> newAttributes, TimeStamp timeStamp) {
+	boost::mutex::scoped_lock lock(filterMutex);
+	if (!resolveGeometricNodeReference(id)) {
+		return false;
+	}
+
+	/* Call _all_ observers  */
+	std::vector<ISceneGraphUpdateObserver*>::iterator observerIterator;
+	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
+		(*observerIterator)->setNodeAttributes(id, newAttributes, timeStamp);
+	}
+	forwardedUpdateCount++;
+	return true;
+}
+
+bool RateLimitingUpdateFilter::setTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp) {
+	return setUncertainTransform(id, transform, ITransformUncertainty::ITransformUncertaintyPtr(), timeStamp);
+}
+
+bool RateLimitingUpdateFilter::setUncertainTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform,
+		ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp) {
+	boost::mutex::scoped_lock lock(filterMutex);
+
+	PendingTransform update;
+	update.transform = transform;
+	update.uncertainty = uncertainty;
+	update.timeStamp = timeStamp;
+
+	/* A pending older transform is replaced, even if the rate limit has been disabled in the meantime. */
+	if (pendingTransforms.erase(id) > 0) {
+		coalescedUpdateCount++;
+	}
+
+	if (maxTransformUpdateFrequency <= 0) {
+		forwardTransform(id, update);
+		return true;
+	}
+
+	if (takeToken(transformBuckets, id, maxTransformUpdateFrequency, now())) {
+		forwardTransform(id, update);
+	} else {
+		pendingTransforms.insert(std::make_pair(id, update));
+	}
+	return true;
+}
+
+bool RateLimitingUpdateFilter::deleteNode(Id id) {
+	boost::mutex::scoped_lock lock(filterMutex);
+
+	/* Nodes that have never been forwarded are silently deleted */
+	std::map<Id, Id>::iterator parentIterator = pendingGeometricNodeParents.find(id);
+	if (parentIterator != pendingGeometricNodeParents.end()) {
+		pendingGeometricNodes.erase(parentIterator->second);
+		pendingGeometricNodeParents.erase(parentIterator);
+		return true;
+	}
+	if (supersededGeometricNodes.erase(id) > 0) {
+		return true;
+	}
+	pendingTransforms.erase(id);
+	transformBuckets.erase(id);
+
+	/* Call _all_ observers  */
+	std::vector<ISceneGraphUpdateObserver*>::iterator observerIterator;
+	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
+		(*observerIterator)->deleteNode(id);
+	}
+	forwardedUpdateCount++;
+	return true;
+}
+
+bool RateLimitingUpdateFilter::addParent(Id id, Id parentId) {
+	boost::mutex::scoped_lock lock(filterMutex);
+	bool referencesAreValid = resolveGeometricNodeReference(id);
+	referencesAreValid = resolveGeometricNodeReference(parentId) && referencesAreValid;
+	if (!referencesAreValid) {
+		return false;
+	}
+
+	/* Call _all_ observers  */
+	std::vector<ISceneGraphUpdateObserver*>::iterator observerIterator;
+	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
+		(*observerIterator)->addParent(id, parentId);
+	}
+	forwardedUpdateCount++;
+	return true;
+}
+
+bool RateLimitingUpdateFilter::removeParent(Id id, Id parentId) {
+	boost::mutex::scoped_lock lock(filterMutex);
+	bool referencesAreValid = resolveGeometricNodeReference(id);
+	referencesAreValid = resolveGeometricNodeReference(parentId) && referencesAreValid;
+	if (!referencesAreValid) {
+		return false;
+	}
+
+	/* Call _all_ observers  */
+	std::vector<ISceneGraphUpdateObserver*>::iterator observerIterator;
+	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
+		(*observerIterator)->removeParent(id, parentId);
+	}
+	forwardedUpdateCount++;
+	return true;
+}
+
+unsigned int RateLimitingUpdateFilter::flush() {
+	boost::mutex::scoped_lock lock(filterMutex);
+	double currentTime = now();
+	unsigned int forwardedUpdates = 0;
+
+	std::map<Id, PendingTransform>::iterator transformIterator = pendingTransforms.begin();
+	while (transformIterator != pendingTransforms.end()) {
+		if (takeToken(transformBuckets, transformIterator->first, maxTransformUpdateFrequency, currentTime)) {
+			forwardTransform(transformIterator->first, transformIterator->second);
+			pendingTransforms.erase(transformIterator++);
+			forwardedUpdates++;
+		} else {
+			++transformIterator;
+		}
+	}
+
+	std::map<Id, PendingGeometricNode>::iterator geometricNodeIterator = pendingGeometricNodes.begin();
+	while (geometricNodeIterator != pendingGeometricNodes.end()) {
+		if (takeToken(geometricNodeBuckets, geometricNodeIterator->first, maxGeometricNodeUpdateFrequency, currentTime)) {
+			forwardGeometricNode(geometricNodeIterator->first, geometricNodeIterator->second);
+			pendingGeometricNodeParents.erase(geometricNodeIterator->second.id);
+			pendingGeometricNodes.erase(geometricNodeIterator++);
+			forwardedUpdates++;
+		} else {
+			++geometricNodeIterator;
+		}
+	}
+
+	return forwardedUpdates;
+}
+
+unsigned int RateLimitingUpdateFilter::getPendingUpdateCount() {
+	boost::mutex::scoped_lock lock(filterMutex);
+	return static_cast<unsigned int>(pendingTransforms.size() + pendingGeometricNodes.size());
+}
+
+void RateLimitingUpdateFilter::setMaxTransformUpdateFrequency(double maxTransformUpdateFrequency) {
+	boost::mutex::scoped_lock lock(filterMutex);
+	this->maxTransformUpdateFrequency = maxTransformUpdateFrequency;
+	transformBuckets.clear();
+}
+
+void RateLimitingUpdateFilter::setMaxGeometricNodeUpdateFrequency(double maxGeometricNodeUpdateFrequency) {
+	boost::mutex::scoped_lock lock(filterMutex);
+	this->maxGeometricNodeUpdateFrequency = maxGeometricNodeUpdateFrequency;
+	geometricNodeBuckets.clear();
+}
+
+void RateLimitingUpdateFilter::setBurstSize(double burstSize) {
+	boost::mutex::scoped_lock lock(filterMutex);
+	this->burstSize = std::max(1.0, burstSize);
+	transformBuckets.clear();
+	geometricNodeBuckets.clear();
+}
+
+void RateLimitingUpdateFilter::startFlushThread(unsigned int flushIntervalInMs) {
+	stopFlushThread();
+	this->flushIntervalInMs = flushIntervalInMs;
+	flushThread = new boost::thread(boost::bind(&RateLimitingUpdateFilter::flushLoop, this));
+}
+
+void RateLimitingUpdateFilter::stopFlushThread() {
+	if (flushThread == 0) {
+		return;
+	}
+	flushThread->interrupt();
+	flushThread->join();
+	delete flushThread;
+	flushThread = 0;
+}
+
+void RateLimitingUpdateFilter::flushLoop() {
+	try {
+		while (true) {
+			boost::this_thread::sleep(boost::posix_time::milliseconds(flushIntervalInMs));
+			flush();
+		}
+	} catch (boost::thread_interrupted&) {
+		LOG(DEBUG) << "RateLimitingUpdateFilter: Flush thread stopped.";
+	}
+}
+
+bool RateLimitingUpdateFilter::attachUpdateObserver(ISceneGraphUpdateObserver* observer) {
+	assert(observer != 0);
+	boost::mutex::scoped_lock lock(filterMutex);
+	updateObservers.push_back(observer);
+	return true;
+}
+
+bool RateLimitingUpdateFilter::detachUpdateObserver(ISceneGraphUpdateObserver* observer) {
+	assert(observer != 0);
+	boost::mutex::scoped_lock lock(filterMutex);
+	std::vector<ISceneGraphUpdateObserver*>::iterator observerIterator = std::find(updateObservers.begin(), updateObservers.end(), observer);
+	if (observerIterator != updateObservers.end()) {
+		updateObservers.erase(observerIterator);
+		return true;
+	}
+	LOG(ERROR) << "Cannot detach update observer. Provided reference does not match with any in the observers list.";
+	return false;
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
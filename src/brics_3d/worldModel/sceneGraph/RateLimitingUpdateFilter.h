@@ -0,0 +1,193 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#ifndef RSG_RATELIMITINGUPDATEFILTER_H_
+#define RSG_RATELIMITINGUPDATEFILTER_H_
+
+#include <brics_3d/worldModel/sceneGraph/ISceneGraphUpdateObserver.h>
+#include <brics_3d/worldModel/sceneGraph/Attribute.h>
+#include <brics_3d/util/Timer.h>
+
+#include <map>
+#include <set>
+#include <boost/thread.hpp>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Update filter that limits the rate of high frequency updates per node while always forwarding the newest state.
+ * @ingroup sceneGraph
+ *
+ * In contrast to the FrequencyAwareUpdateFilter, which uses one global throttle for all
+ * nodes, every node has its own token bucket:
+ *  - setTransform and setUncertainTransform are limited per transform Id.
+ *  - addGeometricNode is limited per parent Id, e.g. a stream of point clouds below the same frame.
+ *
+ * An update that arrives while the bucket of its node is empty is not dropped, but held back
+ * as pending update. A newer update for the same node replaces it (last value coalescing).
+ * The pending updates are forwarded as soon as their bucket has a token again, either by the
+ * next update for that node, by an explicit flush() or by the flush thread (startFlushThread()).
+ * So the bandwidth towards the observers is bounded and the latest state of every node arrives eventually.
+ *
+ * Superseded geometric nodes are never forwarded. Later updates that refer to them (e.g. a deleteNode
+ * of an outdated data deleter) are omitted. A pending geometric node is forwarded immediately if
+ * another update refers to it. All other updates are forwarded immediately.
+ *
+ * All calls are serialized by a mutex, so the observers are never called concurrently
+ * even if the flush thread is used.
+ */
+class RateLimitingUpdateFilter : public ISceneGraphUpdateObserver {
+public:
+	RateLimitingUpdateFilter();
+	virtual ~RateLimitingUpdateFilter();
+
+	/* implemetntations of observer interface */
+	bool addNode(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId = false);
+	bool addGroup(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId = false);
+	bool addTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp, bool forcedId = false);
+	bool addUncertainTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp, bool forcedId = false);
+	bool addGeometricNode(Id parentId, Id& assignedId, vector<Attribute> attributes, Shape::ShapePtr shape, TimeStamp timeStamp, bool forcedId = false);
+	bool addRemoteRootNode(Id rootId, vector<Attribute> attributes);
+	bool addConnection(Id parentId, Id& assignedId, vector<Attribute> attributes, vector<Id> sourceIds, vector<Id> targetIds, TimeStamp start, TimeStamp end, bool forcedId = false);
+	bool setNodeAttributes(Id id, vector<Attribute> newAttributes, TimeStamp timeStamp = TimeStamp(0));
+	bool setTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp);
+	bool setUncertainTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp);
+	bool deleteNode(Id id);
+	bool addParent(Id id, Id parentId);
+	bool removeParent(Id id, Id parentId);
+
+	bool attachUpdateObserver(ISceneGraphUpdateObserver* observer);
+	bool detachUpdateObserver(ISceneGraphUpdateObserver* observer);
+
+	/**
+	 * @brief Forward all pending updates whose bucket has a token again.
+	 * @return Number of forwarded updates.
+	 */
+	unsigned int flush();
+
+	/**
+	 * @brief Call flush() periodically in a background thread.
+	 * @param flushIntervalInMs Period of the flush thread. Should be smaller than the inverse of the maximum frequencies.
+	 */
+	void startFlushThread(unsigned int flushIntervalInMs = 10);
+
+	/// Stop the flush thread. Pending updates are kept.
+	void stopFlushThread();
+
+	double getMaxTransformUpdateFrequency() const {
+		return maxTransformUpdateFrequency;
+	}
+
+	/// Maximum rate of setTransform and setUncertainTransform updates per transform in [Hz]. Values <= 0 disable the limit (default).
+	void setMaxTransformUpdateFrequency(double maxTransformUpdateFrequency);
+
+	double getMaxGeometricNodeUpdateFrequency() const {
+		return maxGeometricNodeUpdateFrequency;
+	}
+
+	/// Maximum rate of addGeometricNode updates per parent in [Hz]. Values <= 0 disable the limit (default).
+	void setMaxGeometricNodeUpdateFrequency(double maxGeometricNodeUpdateFrequency);
+
+	double getBurstSize() const {
+		return burstSize;
+	}
+
+	/// Number of updates a node may send at once after a quiet period. Default is 1.
+	void setBurstSize(double burstSize);
+
+	/// Number of updates that have been passed to the observers.
+	unsigned long getForwardedUpdateCount() const {
+		return forwardedUpdateCount;
+	}
+
+	/// Number of updates that have been replaced by a newer one before they were forwarded.
+	unsigned long getCoalescedUpdateCount() const {
+		return coalescedUpdateCount;
+	}
+
+	/// Number of updates that are currently held back.
+	unsigned int getPendingUpdateCount();
+
+private:
+
+	struct TokenBucket {
+		double tokens;
+		double lastRefill;
+	};
+
+	struct PendingTransform {
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform;
+		ITransformUncertainty::ITransformUncertaintyPtr uncertainty; ///< Null for setTransform.
+		TimeStamp timeStamp;
+	};
+
+	struct PendingGeometricNode {
+		Id id;
+		vector<Attribute> attributes;
+		Shape::ShapePtr shape;
+		TimeStamp timeStamp;
+		bool forcedId;
+	};
+
+	typedef std::map<Id, TokenBucket> BucketMap;
+
+	/// Current time in seconds.
+	double now();
+
+	/// Refill the bucket of the given key and take a token if available. Creates a full bucket for new keys.
+	bool takeToken(BucketMap& buckets, Id key, double rate, double currentTime);
+
+	/// Forward a pending geometric node if another update refers to its id. Returns false if it has been superseded and the update must be omitted.
+	bool resolveGeometricNodeReference(Id id);
+
+	void forwardTransform(Id id, const PendingTransform& update);
+	void forwardGeometricNode(Id parentId, PendingGeometricNode& update);
+
+	double maxTransformUpdateFrequency;
+	double maxGeometricNodeUpdateFrequency;
+	double burstSize;
+
+	BucketMap transformBuckets;
+	BucketMap geometricNodeBuckets;
+	std::map<Id, PendingTransform> pendingTransforms;
+	std::map<Id, PendingGeometricNode> pendingGeometricNodes; ///< Key is the parent id.
+	std::map<Id, Id> pendingGeometricNodeParents; ///< Maps the id of a pending geometric node to its parent id.
+	std::set<Id> supersededGeometricNodes;
+
+	unsigned long forwardedUpdateCount;
+	unsigned long coalescedUpdateCount;
+
+	/// Set of observers that will be notified when the update function will be called and the rate limits are satisfied.
+	std::vector<ISceneGraphUpdateObserver*> updateObservers;
+
+	brics_3d::Timer timer;
+	boost::mutex filterMutex;
+	boost::thread* flushThread;
+	unsigned int flushIntervalInMs;
+
+	void flushLoop();
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_RATELIMITINGUPDATEFILTER_H_ */
+
+/* EOF */
@@ -0,0 +1,162 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#include "ReassemblingInputPort.h"
+#include "brics_3d/core/Logger.h"
+#include <cstring>
+#include <algorithm>
+
+namespace brics_3d {
+namespace rsg {
+
+ReassemblingInputPort::ReassemblingInputPort(IInputPort* messagePort, unsigned int maxMessageSize, unsigned int maxPendingMessages, size_t maxPendingBytes) :
+		messagePort(messagePort),
+		maxMessageSize(maxMessageSize),
+		maxPendingMessages(maxPendingMessages),
+		maxPendingBytes(std::max(maxPendingBytes, static_cast<size_t>(maxMessageSize))), // a single message must always fit
+		pendingBytes(0),
+		activityCounter(0),
+		completedMessageCount(0),
+		discardedMessageCount(0),
+		rejectedFragmentCount(0) {
+
+}
+
+ReassemblingInputPort::~ReassemblingInputPort() {
+
+}
+
+int ReassemblingInputPort::write(const char* dataBuffer, int dataLength, int& transferredBytes) {
+	transferredBytes = dataLength;
+
+	FragmentHeader header;
+	if (!header.decode(dataBuffer, dataLength)) {
+		LOG(WARNING) << "ReassemblingInputPort: Received a datagram without a valid fragment header. Discarding it.";
+		rejectedFragmentCount++;
+		return -1;
+	}
+	if (header.messageLength > maxMessageSize) {
+		LOG(WARNING) << "ReassemblingInputPort: Message " << header.messageId << " with " << header.messageLength << " bytes exceeds the limit of " << maxMessageSize << " bytes. Discarding it.";
+		rejectedFragmentCount++;
+		return -1;
+	}
+	const char* payload = dataBuffer + FragmentHeader::size;
+	boost::uint32_t payloadLength = static_cast<boost::uint32_t>(dataLength - FragmentHeader::size);
+
+	/* Single fragment messages are forwarded without a copy */
+	if (header.fragmentCount == 1) {
+		if (payloadLength != header.messageLength) {
+			LOG(WARNING) << "ReassemblingInputPort: Inconsistent length of message " << header.messageId << ". Discarding it.";
+			rejectedFragmentCount++;
+			return -1;
+		}
+		completedMessageCount++;
+		int forwardedBytes = 0;
+		return messagePort->write(payload, static_cast<int>(payloadLength), forwardedBytes);
+	}
+
+	std::pair<boost::uint32_t, boost::uint32_t> key(header.streamId, header.messageId);
+	PendingMessages::iterator it = pendingMessages.find(key);
+	if (it == pendingMessages.end()) {
+		/* The first fragment defines the payload size, except if it is the last one */
+		boost::uint32_t payloadSize = payloadLength;
+		if (header.fragmentIndex == header.fragmentCount - 1) {
+			payloadSize = (header.messageLength - payloadLength) / (header.fragmentCount - 1);
+		}
+		if (payloadSize == 0 || static_cast<unsigned long long>(payloadSize) * header.fragmentCount < header.messageLength ||
+				static_cast<unsigned long long>(payloadSize) * (header.fragmentCount - 1) >= header.messageLength) {
+			LOG(WARNING) << "ReassemblingInputPort: Inconsistent fragmentation of message " << header.messageId << ". Discarding it.";
+			rejectedFragmentCount++;
+			return -1;
+		}
+
+		while (pendingMessages.size() >= maxPendingMessages && discardOldestMessage(pendingMessages.end())) {
+		}
+		it = pendingMessages.insert(std::make_pair(key, PendingMessage())).first;
+		it->second.received.resize(header.fragmentCount, false);
+		it->second.messageLength = header.messageLength;
+		it->second.receivedCount = 0;
+		it->second.payloadSize = payloadSize;
+		it->second.lastActivity = activityCounter;
+	}
+
+	PendingMessage& message = it->second;
+	boost::uint64_t offset = static_cast<boost::uint64_t>(header.fragmentIndex) * message.payloadSize;
+	boost::uint32_t expectedLength = std::min(static_cast<boost::uint64_t>(message.payloadSize), static_cast<boost::uint64_t>(message.messageLength) - std::min(offset, static_cast<boost::uint64_t>(message.messageLength)));
+	if (message.received.size() != header.fragmentCount || message.messageLength != header.messageLength || payloadLength != expectedLength) {
+		LOG(WARNING) << "ReassemblingInputPort: Fragment " << header.fragmentIndex << " does not match message " << header.messageId << ". Discarding it.";
+		rejectedFragmentCount++;
+		return -1;
+	}
+
+	message.lastActivity = activityCounter++;
+	if (message.received[header.fragmentIndex]) {
+		LOG(DEBUG) << "ReassemblingInputPort: Ignoring duplicated fragment " << header.fragmentIndex << " of message " << header.messageId;
+		return 1;
+	}
+
+	/* Grow the buffer up to the end of this fragment; make room within the memory bound first */
+	size_t requiredSize = static_cast<size_t>(offset + payloadLength);
+	if (requiredSize > message.data.size()) {
+		size_t growth = requiredSize - message.data.size();
+		while (pendingBytes + growth > maxPendingBytes && discardOldestMessage(it)) {
+		}
+		message.data.resize(requiredSize);
+		pendingBytes += growth;
+	}
+	memcpy(&message.data[offset], payload, payloadLength);
+	message.received[header.fragmentIndex] = true;
+	message.receivedCount++;
+
+	if (message.receivedCount < header.fragmentCount) {
+		return 1;
+	}
+
+	/* Complete. Forward and release the buffer */
+	LOG(DEBUG) << "ReassemblingInputPort: Message " << header.messageId << " with " << header.messageLength << " bytes is complete.";
+	std::vector<char> data;
+	data.swap(message.data);
+	pendingBytes -= data.size();
+	pendingMessages.erase(it);
+	completedMessageCount++;
+	int forwardedBytes = 0;
+	return messagePort->write(&data[0], static_cast<int>(data.size()), forwardedBytes);
+}
+
+bool ReassemblingInputPort::discardOldestMessage(PendingMessages::iterator keep) {
+	PendingMessages::iterator oldest = pendingMessages.end();
+	for (PendingMessages::iterator it = pendingMessages.begin(); it != pendingMessages.end(); ++it) {
+		if (it != keep && (oldest == pendingMessages.end() || it->second.lastActivity < oldest->second.lastActivity)) {
+			oldest = it;
+		}
+	}
+	if (oldest == pendingMessages.end()) {
+		return false;
+	}
+	LOG(WARNING) << "ReassemblingInputPort: Discarding incomplete message " << oldest->first.second << " with " << oldest->second.receivedCount << " of " << oldest->second.received.size() << " fragments.";
+	pendingBytes -= oldest->second.data.size();
+	pendingMessages.erase(oldest);
+	discardedMessageCount++;
+	return true;
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
@@ -0,0 +1,137 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#ifndef RSG_REASSEMBLINGINPUTPORT_H_
+#define RSG_REASSEMBLINGINPUTPORT_H_
+
+#include "brics_3d/worldModel/sceneGraph/IPort.h"
+#include "brics_3d/worldModel/sceneGraph/FragmentingOutputPort.h"
+#include <map>
+#include <vector>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Decorator for an IInputPort that reassembles the fragments of a FragmentingOutputPort.
+ * @ingroup sceneGraph
+ *
+ * Every received datagram is passed to write(). As soon as all fragments of a message
+ * have arrived the complete message is forwarded to the decorated input port, e.g. a
+ * deserializer. Fragments may arrive out of order; duplicates are ignored.
+ *
+ * Memory is bounded: messages larger than maxMessageSize are rejected and at most
+ * maxPendingMessages incomplete messages with at most maxPendingBytes in total are
+ * buffered. If another one arrives, the incomplete message with the oldest activity is
+ * discarded, as one of its fragments has most likely been lost. The buffer of a message
+ * grows with its received fragments rather than with the announced message length,
+ * such that forged headers do not allocate memory up front.
+ *
+ * The port is not thread safe; call it from the single receiver thread of the transport.
+ */
+class ReassemblingInputPort : public IInputPort {
+public:
+
+	/**
+	 * @brief Constructor.
+	 * @param messagePort Receiver of the reassembled messages.
+	 * @param maxMessageSize Maximum size of a single message in bytes.
+	 * @param maxPendingMessages Maximum number of incomplete messages that are buffered at the same time.
+	 * @param maxPendingBytes Maximum number of bytes of all incomplete messages. It is at least maxMessageSize.
+	 */
+	ReassemblingInputPort(IInputPort* messagePort, unsigned int maxMessageSize = 64*1024*1024, unsigned int maxPendingMessages = 16, size_t maxPendingBytes = 64*1024*1024);
+	virtual ~ReassemblingInputPort();
+
+	/**
+	 * @brief Process a single datagram.
+	 * @return 1 if the fragment was accepted, the return value of the decorated port if it completed a message or -1 if it was rejected.
+	 */
+	int write(const char *dataBuffer, int dataLength, int &transferredBytes);
+
+	/// Number of messages that have been forwarded.
+	unsigned long getCompletedMessageCount() const {
+		return completedMessageCount;
+	}
+
+	/// Number of incomplete messages that have been discarded to stay within the bounds.
+	unsigned long getDiscardedMessageCount() const {
+		return discardedMessageCount;
+	}
+
+	/// Number of datagrams that have been rejected (invalid header, too large, inconsistent).
+	unsigned long getRejectedFragmentCount() const {
+		return rejectedFragmentCount;
+	}
+
+	/// Number of currently buffered incomplete messages.
+	unsigned int getPendingMessageCount() const {
+		return static_cast<unsigned int>(pendingMessages.size());
+	}
+
+	/// Number of currently buffered bytes of incomplete messages.
+	size_t getPendingBytes() const {
+		return pendingBytes;
+	}
+
+private:
+
+	/// A message for which not all fragments have been received yet.
+	struct PendingMessage {
+		std::vector<char> data; // grows with the received fragments
+		std::vector<bool> received;
+		boost::uint32_t messageLength;
+		boost::uint32_t receivedCount;
+		boost::uint32_t payloadSize;
+		unsigned long lastActivity;
+	};
+
+	/// Key is (streamId, messageId).
+	typedef std::map<std::pair<boost::uint32_t, boost::uint32_t>, PendingMessage> PendingMessages;
+
+	/**
+	 * @brief Discard the pending message with the oldest activity.
+	 * @param keep Message that must not be discarded, or pendingMessages.end().
+	 * @return False if there is no message that could be discarded.
+	 */
+	bool discardOldestMessage(PendingMessages::iterator keep);
+
+	IInputPort* messagePort;
+	unsigned int maxMessageSize;
+	unsigned int maxPendingMessages;
+	size_t maxPendingBytes;
+
+	PendingMessages pendingMessages;
+
+	/// Sum of the buffer sizes of all pending messages.
+	size_t pendingBytes;
+
+	/// Logical clock for the activity of pending messages.
+	unsigned long activityCounter;
+
+	unsigned long completedMessageCount;
+	unsigned long discardedMessageCount;
+	unsigned long rejectedFragmentCount;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_REASSEMBLINGINPUTPORT_H_ */
+
+/* EOF */
@@ -0,0 +1,101 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#ifndef RSG_SCENEGRAPHALLOCATOR_H_
+#define RSG_SCENEGRAPHALLOCATOR_H_
+
+#include "brics_3d/core/PoolAllocator.h"
+#include "brics_3d/core/HomogeneousMatrix44.h"
+#include <boost/make_shared.hpp>
+
+namespace brics_3d {
+namespace rsg {
+
+/// Pool tag for all nodes created by the SceneGraphFacade.
+struct NodePoolTag {};
+
+/// Pool tag for the matrices that are stored in the histories of Transform nodes.
+struct TransformHistoryPoolTag {};
+
+/**
+ * @brief Factory for pooled allocations of scene graph primitives.
+ * @ingroup sceneGraph
+ *
+ * The objects and their shared_ptr control blocks are allocated in one chunk
+ * from a memory pool (via boost::allocate_shared). This avoids the allocator churn
+ * of plain new/delete calls at high update rates. The returned pointers behave
+ * exactly like regular shared pointers.
+ *
+ * The scene graph stores the matrices that are passed to setTransform() without
+ * copying them. So they only come from the pool if the producer uses createTransformMatrix(),
+ * as the deserializers and the log replayer do. Matrices created with new are kept as they are.
+ *
+ * Example:
+ * @code
+ * IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform = SceneGraphAllocator::createTransformMatrix();
+ * wm->scene.setTransform(tfId, transform, wm->now());
+ *
+ * PoolStatistics stats = SceneGraphAllocator::getTransformHistoryPoolStatistics();
+ * LOG(INFO) << "Matrices in use: " << stats.objectsInUse;
+ * @endcode
+ */
+class SceneGraphAllocator {
+public:
+
+	/// Create a pooled node with its default constructor.
+	template<typename NodeType>
+	static boost::shared_ptr<NodeType> createNode() {
+		return boost::allocate_shared<NodeType>(PoolAllocator<NodeType, NodePoolTag>());
+	}
+
+	/// Create a pooled node with a constructor that takes one argument.
+	template<typename NodeType, typename Arg>
+	static boost::shared_ptr<NodeType> createNode(const Arg& arg) {
+		return boost::allocate_shared<NodeType>(PoolAllocator<NodeType, NodePoolTag>(), arg);
+	}
+
+	/// Create a pooled identity matrix to be inserted into a transform history.
+	static IHomogeneousMatrix44::IHomogeneousMatrix44Ptr createTransformMatrix() {
+		return boost::allocate_shared<HomogeneousMatrix44>(PoolAllocator<HomogeneousMatrix44, TransformHistoryPoolTag>());
+	}
+
+	/// Create a pooled copy of a matrix to be inserted into a transform history.
+	static IHomogeneousMatrix44::IHomogeneousMatrix44Ptr createTransformMatrix(const IHomogeneousMatrix44& matrix) {
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr result = createTransformMatrix();
+		*result = matrix;
+		return result;
+	}
+
+	/// Occupancy of the node pool.
+	static PoolStatistics getNodePoolStatistics() {
+		return PoolStatisticsRegistry<NodePoolTag>::getStatistics();
+	}
+
+	/// Occupancy of the transform history pool.
+	static PoolStatistics getTransformHistoryPoolStatistics() {
+		return PoolStatisticsRegistry<TransformHistoryPoolTag>::getStatistics();
+	}
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_SCENEGRAPHALLOCATOR_H_ */
+
+/* EOF */
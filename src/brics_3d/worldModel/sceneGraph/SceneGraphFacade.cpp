@@ -23,8 +23,12 @@
 #include "brics_3d/core/Logger.h"
 #include "AttributeFinder.h"
 #include "RootFinder.h"
+#include "SceneGraphAllocator.h"
 
 #include <iomanip> // setprecision
+#include <limits>
+#include <set>
+#include <algorithm>
 
 namespace brics_3d {
 
@@ -83,7 +87,7 @@ bool SceneGraphFacade::addRemoteRootNode(Id rootId, vector<Attribute> attributes
 
 
 	if ((idIsOk)) {
-		Group::GroupPtr newGroup(new Group());
+		Group::GroupPtr newGroup = SceneGraphAllocator::createNode<Group>();
 		newGroup->setId(rootId);
 		newGroup->setAttributes(attributes);
 		//parentGroup->addChild(newNode);
@@ -115,6 +119,14 @@ bool SceneGraphFacade::getRemoteRootNodes(vector<Id>& ids) {
 }
 
 bool SceneGraphFacade::getNodes(vector<Attribute> attributes, vector<Id>& ids) {
+	return getNodes(AttributeQuery(attributes), ids);
+}
+
+bool SceneGraphFacade::getNodes(vector<Attribute> attributes, vector<Id>& ids, Id subgraphId) {
+	return getNodes(AttributeQuery(attributes), ids, subgraphId);
+}
+
+bool SceneGraphFacade::getNodes(const AttributeQuery& query, vector<Id>& ids) {
 	LOG(DEBUG) << " Current idLookUpTable length = " << idLookUpTable.size();
 	ids.clear();
 //	Node::NodeWeakPtr tmpNode = findNodeRecerence(getRootId());
@@ -122,7 +134,7 @@ bool SceneGraphFacade::getNodes(vector<Attribute> attributes, vector<Id>& ids) {
 	Node::NodePtr node = tmpNode.lock();
 	if (node != 0) {
 			AttributeFinder attributeFinder;
-			attributeFinder.setQueryAttributes(attributes);
+			attributeFinder.setQuery(query);
 			node->accept(&attributeFinder);
 			for (unsigned int i = 0; i < static_cast<unsigned int>(attributeFinder.getMatchingNodes().size()) ; ++i) {
 				ids.push_back((*attributeFinder.getMatchingNodes()[i]).getId());
@@ -135,14 +147,14 @@ bool SceneGraphFacade::getNodes(vector<Attribute> attributes, vector<Id>& ids) {
 	return false;
 }
 
-bool SceneGraphFacade::getNodes(vector<Attribute> attributes, vector<Id>& ids, Id subgraphId) {
+bool SceneGraphFacade::getNodes(const AttributeQuery& query, vector<Id>& ids, Id subgraphId) {
 	LOG(DEBUG) << " Current idLookUpTable length = " << idLookUpTable.size();
 	ids.clear();
 	Node::NodeWeakPtr tmpNode = findNodeRecerence(subgraphId);
 	Node::NodePtr node = tmpNode.lock();
 	if (node != 0) {
 			AttributeFinder attributeFinder;
-			attributeFinder.setQueryAttributes(attributes);
+			attributeFinder.setQuery(query);
 			node->accept(&attributeFinder);
 			for (unsigned int i = 0; i < static_cast<unsigned int>(attributeFinder.getMatchingNodes().size()) ; ++i) {
 				ids.push_back((*attributeFinder.getMatchingNodes()[i]).getId());
@@ -274,6 +286,64 @@ bool SceneGraphFacade::getTransformForNode (Id id, Id idReferenceNode, TimeStamp
 	return false;
 }
 
+bool SceneGraphFacade::getNodesInRadius(Id idReferenceNode, const Point3D& center, double radius, vector<Id>& ids) {
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr referenceTransform;
+	if (!getReferenceTransform(idReferenceNode, referenceTransform)) {
+		return false;
+	}
+	spatialIndex.getNodesInRadius(referenceTransform, center, radius, ids);
+	return true;
+}
+
+bool SceneGraphFacade::getNodesInBox(Id idReferenceNode, const Point3D& minPoint, const Point3D& maxPoint, vector<Id>& ids) {
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr referenceTransform;
+	if (!getReferenceTransform(idReferenceNode, referenceTransform)) {
+		return false;
+	}
+	spatialIndex.getNodesInBox(referenceTransform, minPoint, maxPoint, ids);
+	return true;
+}
+
+bool SceneGraphFacade::getNearestNodes(Id idReferenceNode, const Point3D& point, unsigned int k, vector<Id>& ids, vector<double>& distances) {
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr referenceTransform;
+	if (!getReferenceTransform(idReferenceNode, referenceTransform)) {
+		return false;
+	}
+	spatialIndex.getNearestNodes(referenceTransform, point, k, ids, distances);
+	return true;
+}
+
+bool SceneGraphFacade::getNodesAlongRay(Id idReferenceNode, const Point3D& origin, const Point3D& direction, double maxDistance, vector<Id>& ids, vector<double>& distances) {
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr referenceTransform;
+	if (!getReferenceTransform(idReferenceNode, referenceTransform)) {
+		return false;
+	}
+	spatialIndex.getNodesAlongRay(referenceTransform, origin, direction, maxDistance, ids, distances);
+	return true;
+}
+
+bool SceneGraphFacade::getBoundingBox(Id id, BoundingVolumeHierarchy::BoundingBox& box) {
+	return spatialIndex.getBoundingBox(id, box);
+}
+
+bool SceneGraphFacade::getReferenceTransform(Id idReferenceNode, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr& transform) {
+	transform.reset(); // identity
+	if (idReferenceNode.isNil() || idReferenceNode == getRootId()) {
+		return true;
+	}
+
+	Node::NodeWeakPtr tmpNode = findNodeRecerence(idReferenceNode);
+	Node::NodePtr node = tmpNode.lock();
+	if (node == 0) {
+		LOG(ERROR) << "Reference node with ID " << idReferenceNode << " does not exist. Cannot perform a spatial query.";
+		sendErrorCode(ISceneGraphErrorObserver::RSG_ERR_ID_DOES_NOT_EXIST);
+		return false;
+	}
+	TimeStamp actualTimeStamp;
+	transform = getGlobalTransform(node, TimeStamp(std::numeric_limits<double>::max()), actualTimeStamp); // latest
+	return true;
+}
+
 bool SceneGraphFacade::addNode(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId) {
 	bool operationSucceeded = false;
 	bool idIsOk = false;
@@ -297,7 +367,7 @@ bool SceneGraphFacade::addNode(Id parentId, Id& assignedId, vector<Attribute> at
 	}
 
 	if ((parentGroup != 0) && (idIsOk)) {
-		Node::NodePtr newNode(new Node());
+		Node::NodePtr newNode = SceneGraphAllocator::createNode<Node>();
 		newNode->setId(id);
 		newNode->setAttributes(attributes);
 		parentGroup->addChild(newNode);
@@ -350,7 +420,7 @@ bool SceneGraphFacade::addGroup(Id parentId, Id& assignedId, vector<Attribute> a
 
 
 	if ((parentGroup != 0) && (idIsOk)) {
-		Group::GroupPtr newGroup(new Group());
+		Group::GroupPtr newGroup = SceneGraphAllocator::createNode<Group>();
 		newGroup->setId(id);
 		newGroup->setAttributes(attributes);
 		parentGroup->addChild(newGroup);
@@ -415,7 +485,7 @@ bool SceneGraphFacade::addTransformNode(Id parentId, Id& assignedId, vector<Attr
 				return false;
 			}
 		}
-		rsg::Transform::TransformPtr newTransform(new Transform(maxHistoryDuration));
+		rsg::Transform::TransformPtr newTransform = SceneGraphAllocator::createNode<Transform>(maxHistoryDuration);
 
 		newTransform->setId(id);
 		newTransform->setAttributes(attributes);
@@ -470,7 +540,7 @@ bool SceneGraphFacade::addUncertainTransformNode(Id parentId, Id& assignedId, ve
 	}
 
 	if ((parentGroup != 0) && (idIsOk)) {
-		rsg::UncertainTransform::UncertainTransformPtr newTransform(new UncertainTransform());
+		rsg::UncertainTransform::UncertainTransformPtr newTransform = SceneGraphAllocator::createNode<UncertainTransform>();
 		newTransform->setId(id);
 		newTransform->setAttributes(attributes);
 		newTransform->insertTransform(transform, uncertainty, timeStamp);
@@ -524,7 +594,7 @@ bool SceneGraphFacade::addGeometricNode(Id parentId, Id& assignedId, vector<Attr
 	}
 
 	if ((parentGroup != 0) && (idIsOk)) {
-		GeometricNode::GeometricNodePtr newGeometricNode(new GeometricNode());
+		GeometricNode::GeometricNodePtr newGeometricNode = SceneGraphAllocator::createNode<GeometricNode>();
 		newGeometricNode->setId(id);
 		newGeometricNode->setAttributes(attributes);
 		newGeometricNode->setShape(shape);
@@ -532,6 +602,7 @@ bool SceneGraphFacade::addGeometricNode(Id parentId, Id& assignedId, vector<Attr
 		parentGroup->addChild(newGeometricNode);
 		assignedId = newGeometricNode->getId();
 		idLookUpTable.insert(std::make_pair(newGeometricNode->getId(), newGeometricNode));
+		spatialIndex.addGeometricNode(newGeometricNode);
 		operationSucceeded = true;
 	}
 
@@ -609,7 +680,9 @@ bool SceneGraphFacade::setTransform(Id id, IHomogeneousMatrix44::IHomogeneousMat
 	rsg::Transform::TransformPtr transformNode = boost::dynamic_pointer_cast<rsg::Transform>(node);
 	if (transformNode != 0) {
 		operationSucceeded = transformNode->insertTransform(transform, timeStamp);
-		if(!operationSucceeded) {
+		if(operationSucceeded) {
+			spatialIndex.transformChanged(id);
+		} else {
 			sendErrorCode(ISceneGraphErrorObserver::RSG_ERR_UPDATE_IS_NOT_NEWER);
 		}
 	} else {
@@ -640,7 +713,9 @@ bool SceneGraphFacade::setUncertainTransform(Id id, IHomogeneousMatrix44::IHomog
 	rsg::UncertainTransform::UncertainTransformPtr transformNode = boost::dynamic_pointer_cast<rsg::UncertainTransform>(node);
 	if (transformNode != 0) {
 		operationSucceeded = transformNode->insertTransform(transform, uncertainty, timeStamp);
-		if(!operationSucceeded) {
+		if(operationSucceeded) {
+			spatialIndex.transformChanged(id);
+		} else {
 			sendErrorCode(ISceneGraphErrorObserver::RSG_ERR_UPDATE_IS_NOT_NEWER);
 		}
 	} else {
@@ -690,6 +765,7 @@ bool SceneGraphFacade::deleteNode(Id id) {
 				}
 				assert(deletionCouter == 1);
 				idLookUpTable.erase(id);
+				spatialIndex.structureChanged(id);
 				operationSucceeded = true; // could be still part of a graph
 			}
 
@@ -731,6 +807,7 @@ bool SceneGraphFacade::deleteNode(Id id) {
 			}
 			assert(deletionCouter <= 1); // no or exactly one remoteNode possible
 			idLookUpTable.erase(id);
+			spatialIndex.structureChanged(id);
 
 			operationSucceeded = true;
 		}
@@ -786,6 +863,7 @@ bool SceneGraphFacade::addParent(Id id, Id parentId) {
 
 		if (hasNoCycle && isNotDuplicated) {
 			parentGroup->addChild(node);
+			spatialIndex.structureChanged(id);
 			operationSucceeded = true;
 		} else {
 			operationSucceeded = false;
@@ -843,6 +921,7 @@ bool SceneGraphFacade::removeParent(Id id, Id parentId) {
 					Group* parentGroup =  dynamic_cast<Group*>(parentNode);
 					if (parentGroup != 0 ) {
 						parentGroup->removeChild(node);
+						spatialIndex.structureChanged(id);
 						operationSucceeded = true;
 					} else {
 						assert(false); // actually parents need to be groups otherwise sth. really went wrong
@@ -870,6 +949,41 @@ bool SceneGraphFacade::removeParent(Id id, Id parentId) {
 	};
 }
 
+bool SceneGraphFacade::applyUpdateBatch(const SceneGraphUpdateBatch& batch) {
+	bool operationSucceeded = false;
+
+	if (validateUpdateBatch(batch)) {
+
+		/*
+		 * Apply the updates without per update notifications. The observers
+		 * are temporarily detached and will get the batch as a whole below.
+		 */
+		std::vector<ISceneGraphUpdateObserver*> batchObservers;
+		batchObservers.swap(updateObservers);
+		operationSucceeded = batch.replay(this);
+		updateObservers.swap(batchObservers);
+
+		if(!operationSucceeded) { // validateUpdateBatch() and the update functions disagree
+			LOG(ERROR) << "SceneGraphFacade::applyUpdateBatch: Not all updates of the validated batch could be applied. The batch has been partially applied.";
+		}
+	} else {
+		LOG(ERROR) << "SceneGraphFacade::applyUpdateBatch: Batch with " << batch.getNumberOfUpdates() << " updates is invalid. None of them has been applied.";
+	}
+
+	/*
+	 * Call all observers (once). In contrast to single updates this is independent of callObserversEvenIfErrorsOccurred:
+	 * a rejected batch must not be forwarded, as e.g. replicas would apply updates that this graph refused.
+	 */
+	if (operationSucceeded) {
+		std::vector<ISceneGraphUpdateObserver*>::iterator observerIterator;
+		for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
+			(*observerIterator)->applyUpdateBatch(batch);
+		}
+	}
+
+	return operationSucceeded;
+}
+
 bool SceneGraphFacade::addConnection(Id parentId, Id& assignedId, vector<Attribute> attributes, vector<Id> sourceIds, vector<Id> targetIds, TimeStamp start, TimeStamp end, bool forcedId) {
 	bool operationSucceeded = false;
 	bool idIsOk = false;
@@ -894,7 +1008,7 @@ bool SceneGraphFacade::addConnection(Id parentId, Id& assignedId, vector<Attribu
 
 
 	if ((parentGroup != 0) && (idIsOk)) {
-		Connection::ConnectionPtr newConnection(new Connection());
+		Connection::ConnectionPtr newConnection = SceneGraphAllocator::createNode<Connection>();
 		newConnection->setId(id);
 		newConnection->setAttributes(attributes);
 		for (int i = 0; i < sourceIds.size(); ++i) {
@@ -1096,6 +1210,251 @@ bool SceneGraphFacade::doesIdExist(Id id) {
 	return false;
 }
 
+/* Node categories as far as the batch validation is concerned. Order matters: a transform is a group as well. */
+enum BatchNodeKind {
+	BATCH_NODE_DOES_NOT_EXIST,
+	BATCH_NODE_LEAF,
+	BATCH_NODE_GROUP,
+	BATCH_NODE_TRANSFORM,
+	BATCH_NODE_UNCERTAIN_TRANSFORM
+};
+
+/* Time stamps of a transform history as far as the batch validation is concerned. */
+struct BatchTransformHistory {
+	TimeStamp maxHistoryDuration;
+	std::set<TimeStamp> timeStamps;
+};
+
+/* Parents of a node within the batch. They are taken from the graph on first access, except for nodes that have been deleted by the batch. */
+static vector<Id>& getBatchParents(Id id, Node::NodePtr node, map<Id, vector<Id> >& batchParents, const map<Id, BatchNodeKind>& batchNodes) {
+	map<Id, vector<Id> >::iterator parents = batchParents.find(id);
+	if (parents != batchParents.end()) {
+		return parents->second;
+	}
+	vector<Id>& newParents = batchParents[id];
+	for (unsigned int i = 0; (node != 0) && (i < node->getNumberOfParents()); ++i) {
+		Id parentId = node->getParent(i)->getId();
+		map<Id, BatchNodeKind>::const_iterator batchNode = batchNodes.find(parentId);
+		if (batchNode == batchNodes.end() || batchNode->second != BATCH_NODE_DOES_NOT_EXIST) {
+			newParents.push_back(parentId);
+		}
+	}
+	return newParents;
+}
+
+bool SceneGraphFacade::validateUpdateBatch(const SceneGraphUpdateBatch& batch) {
+
+	/* Nodes that are created, deleted or modified within the batch overlay the existing graph. */
+	map<Id, BatchNodeKind> batchNodes;
+	std::set<Id> batchAssignedIds;
+	map<Id, vector<Id> > batchParents;
+	map<Id, std::pair<vector<Attribute>, TimeStamp> > batchAttributes;
+	map<Id, BatchTransformHistory> batchHistories;
+
+	for (unsigned int i = 0; i < batch.getNumberOfUpdates(); ++i) {
+		const SceneGraphUpdateBatch::Update& update = batch.getUpdate(i);
+
+		/* Resolve the kinds of the involved nodes */
+		BatchNodeKind kinds[2];
+		Node::NodePtr nodes[2];
+		Id ids[2] = {update.id, update.parentId};
+		for (int j = 0; j < 2; ++j) {
+			map<Id, BatchNodeKind>::const_iterator batchNode = batchNodes.find(ids[j]);
+			if (batchNode != batchNodes.end()) {
+				kinds[j] = batchNode->second; // created or deleted by the batch, so there is no node in the graph (yet)
+				continue;
+			}
+			kinds[j] = BATCH_NODE_DOES_NOT_EXIST;
+			map<Id, Node::NodeWeakPtr >::const_iterator existingNode = idLookUpTable.find(ids[j]);
+			if (existingNode != idLookUpTable.end()) {
+				nodes[j] = existingNode->second.lock();
+				if (boost::dynamic_pointer_cast<UncertainTransform>(nodes[j]) != 0) {
+					kinds[j] = BATCH_NODE_UNCERTAIN_TRANSFORM;
+				} else if (boost::dynamic_pointer_cast<Transform>(nodes[j]) != 0) {
+					kinds[j] = BATCH_NODE_TRANSFORM;
+				} else if (boost::dynamic_pointer_cast<Group>(nodes[j]) != 0) {
+					kinds[j] = BATCH_NODE_GROUP;
+				} else if (nodes[j] != 0) {
+					kinds[j] = BATCH_NODE_LEAF;
+				}
+			}
+		}
+		BatchNodeKind nodeKind = kinds[0];
+		BatchNodeKind parentKind = kinds[1];
+
+		BatchNodeKind newKind = BATCH_NODE_LEAF;
+		TimeStamp maxHistoryDuration = TimeStamp(10, Units::Second); // default of (uncertain) transforms
+		switch (update.type) {
+		case SceneGraphUpdateBatch::ADD_GROUP:
+			newKind = BATCH_NODE_GROUP;
+			break;
+		case SceneGraphUpdateBatch::ADD_TRANSFORM_NODE: {
+			newKind = BATCH_NODE_TRANSFORM;
+			vector<std::string> resultValues;
+			if(getValuesFromAttributeList(update.attributes, "tf:max_duration", resultValues)) { // same policy as in addTransformNode()
+				maxHistoryDuration = TimeStamp::fromString(resultValues[0]);
+				if (maxHistoryDuration == TimeStamp(0)) {
+					LOG(ERROR) << "Batch update " << i << ": tf:max_duration " << resultValues[0] << " Can not be parsed.";
+					return false;
+				}
+			}
+			break;
+		}
+		case SceneGraphUpdateBatch::ADD_UNCERTAIN_TRANSFORM_NODE:
+			newKind = BATCH_NODE_UNCERTAIN_TRANSFORM;
+			break;
+		default:
+			break;
+		}
+
+		switch (update.type) {
+		case SceneGraphUpdateBatch::ADD_NODE:
+		case SceneGraphUpdateBatch::ADD_GROUP:
+		case SceneGraphUpdateBatch::ADD_TRANSFORM_NODE:
+		case SceneGraphUpdateBatch::ADD_UNCERTAIN_TRANSFORM_NODE:
+		case SceneGraphUpdateBatch::ADD_GEOMETRIC_NODE:
+		case SceneGraphUpdateBatch::ADD_CONNECTION:
+		case SceneGraphUpdateBatch::ADD_REMOTE_ROOT_NODE:
+			/* IDs of deleted nodes stay in the pool, so an ID can only be assigned once */
+			if (nodeKind != BATCH_NODE_DOES_NOT_EXIST || update.id.isNil() || batchAssignedIds.find(update.id) != batchAssignedIds.end() || !idGenerator->isIdInPool(update.id)) {
+				LOG(ERROR) << "Batch update " << i << ": ID " << update.id << " cannot be assigned. Probably another object with that ID exists already!";
+				sendErrorCode(ISceneGraphErrorObserver::RSG_ERR_ID_EXISTS_ALREADY);
+				return false;
+			}
+			if (update.type == SceneGraphUpdateBatch::ADD_REMOTE_ROOT_NODE) {
+				batchNodes[update.id] = BATCH_NODE_GROUP;
+				batchParents[update.id] = vector<Id>();
+			} else {
+				if (parentKind < BATCH_NODE_GROUP) {
+					LOG(ERROR) << "Batch update " << i << ": Parent with ID " << update.parentId << " is not a group.";
+					sendErrorCode(ISceneGraphErrorObserver::RSG_ERR_PARENT_ID_DOES_NOT_EXIST);
+					return false;
+				}
+				batchNodes[update.id] = newKind;
+				batchParents[update.id] = vector<Id>(1, update.parentId);
+			}
+			batchAssignedIds.insert(update.id);
+			batchAttributes[update.id] = std::make_pair(update.attributes, TimeStamp());
+			if (newKind >= BATCH_NODE_TRANSFORM) {
+				BatchTransformHistory& history = batchHistories[update.id];
+				history.maxHistoryDuration = maxHistoryDuration;
+				history.timeStamps.clear();
+				history.timeStamps.insert(update.timeStamp);
+			}
+			break;
+
+		case SceneGraphUpdateBatch::SET_NODE_ATTRIBUTES: {
+			if (nodeKind == BATCH_NODE_DOES_NOT_EXIST) {
+				LOG(ERROR) << "Batch update " << i << ": Node with ID " << update.id << " does not exist.";
+				sendErrorCode(ISceneGraphErrorObserver::RSG_ERR_ID_DOES_NOT_EXIST);
+				return false;
+			}
+			map<Id, std::pair<vector<Attribute>, TimeStamp> >::iterator attributes = batchAttributes.find(update.id);
+			if (attributes == batchAttributes.end()) {
+				attributes = batchAttributes.insert(std::make_pair(update.id, std::make_pair(nodes[0]->getAttributes(), nodes[0]->getAttributesTimeStamp()))).first;
+			}
+			if (update.timeStamp < attributes->second.second) { // same policy as in setNodeAttributes()
+				LOG(ERROR) << "Batch update " << i << ": Attributes of node " << update.id << " are older than the stored ones.";
+				sendErrorCode(ISceneGraphErrorObserver::RSG_ERR_UPDATE_IS_NOT_NEWER);
+				return false;
+			}
+			if (!attributeListsAreEqual(update.attributes, attributes->second.first)) {
+				attributes->second = std::make_pair(update.attributes, update.timeStamp);
+			}
+			break;
+		}
+
+		case SceneGraphUpdateBatch::SET_TRANSFORM:
+		case SceneGraphUpdateBatch::SET_UNCERTAIN_TRANSFORM: {
+			if ((update.type == SceneGraphUpdateBatch::SET_TRANSFORM && nodeKind < BATCH_NODE_TRANSFORM) ||
+				(update.type == SceneGraphUpdateBatch::SET_UNCERTAIN_TRANSFORM && nodeKind != BATCH_NODE_UNCERTAIN_TRANSFORM)) {
+				LOG(ERROR) << "Batch update " << i << ": Node with ID " << update.id << " is not a transform of the required type.";
+				sendErrorCode(ISceneGraphErrorObserver::RSG_ERR_ID_DOES_NOT_EXIST);
+				return false;
+			}
+
+			/*
+			 * Same policy as in TemporalCache::insertData(). The uncertainty history of an uncertain transform
+			 * only contains time stamps of the transform history, so checking the latter is sufficient.
+			 */
+			map<Id, BatchTransformHistory>::iterator history = batchHistories.find(update.id);
+			if (history == batchHistories.end()) {
+				history = batchHistories.insert(std::make_pair(update.id, BatchTransformHistory())).first;
+				Transform::TransformPtr transformNode = boost::dynamic_pointer_cast<Transform>(nodes[0]);
+				TemporalCache<IHomogeneousMatrix44::IHomogeneousMatrix44Ptr> cache = transformNode->getHistory();
+				history->second.maxHistoryDuration = transformNode->getMaxHistoryDuration();
+				for (std::vector<std::pair<IHomogeneousMatrix44::IHomogeneousMatrix44Ptr, TimeStamp> >::const_iterator it = cache.begin(); it != cache.end(); ++it) {
+					history->second.timeStamps.insert(it->second);
+				}
+			}
+			std::set<TimeStamp>& timeStamps = history->second.timeStamps;
+			if ((!timeStamps.empty() && update.timeStamp < (*timeStamps.rbegin() - history->second.maxHistoryDuration)) ||
+				(timeStamps.find(update.timeStamp) != timeStamps.end())) {
+				LOG(ERROR) << "Batch update " << i << ": Transform data of node " << update.id << " is outdated or exists already.";
+				sendErrorCode(ISceneGraphErrorObserver::RSG_ERR_UPDATE_IS_NOT_NEWER);
+				return false;
+			}
+			timeStamps.insert(update.timeStamp);
+			break;
+		}
+
+		case SceneGraphUpdateBatch::DELETE_NODE:
+			if (nodeKind == BATCH_NODE_DOES_NOT_EXIST || update.id == getRootId()) {
+				LOG(ERROR) << "Batch update " << i << ": Node with ID " << update.id << " does not exist or cannot be deleted.";
+				sendErrorCode(ISceneGraphErrorObserver::RSG_ERR_ID_DOES_NOT_EXIST);
+				return false;
+			}
+			batchNodes[update.id] = BATCH_NODE_DOES_NOT_EXIST;
+			batchParents.erase(update.id);
+			for (map<Id, vector<Id> >::iterator parents = batchParents.begin(); parents != batchParents.end(); ++parents) { // a deleted group is no parent anymore
+				parents->second.erase(std::remove(parents->second.begin(), parents->second.end(), update.id), parents->second.end());
+			}
+			break;
+
+		case SceneGraphUpdateBatch::ADD_PARENT: {
+			if (nodeKind == BATCH_NODE_DOES_NOT_EXIST || parentKind < BATCH_NODE_GROUP || update.id == update.parentId) {
+				LOG(ERROR) << "Batch update " << i << ": Cannot add a parent-child relation between parent " << update.parentId << " and child " << update.id;
+				sendErrorCode(ISceneGraphErrorObserver::RSG_ERR_ID_DOES_NOT_EXIST);
+				return false;
+			}
+			vector<Id>& parents = getBatchParents(update.id, nodes[0], batchParents, batchNodes);
+			vector<Id>& parentsOfParent = getBatchParents(update.parentId, nodes[1], batchParents, batchNodes);
+			if (std::find(parents.begin(), parents.end(), update.parentId) != parents.end() ||
+				std::find(parentsOfParent.begin(), parentsOfParent.end(), update.id) != parentsOfParent.end()) { // same (direct) checks as in addParent()
+				LOG(ERROR) << "Batch update " << i << ": Parent " << update.parentId << " and child " << update.id << " have already a relation.";
+				sendErrorCode(ISceneGraphErrorObserver::RSG_ERR_GRAPH_CYCLE_DETECTED);
+				return false;
+			}
+			parents.push_back(update.parentId);
+			break;
+		}
+
+		case SceneGraphUpdateBatch::REMOVE_PARENT: {
+			if (nodeKind == BATCH_NODE_DOES_NOT_EXIST) {
+				LOG(ERROR) << "Batch update " << i << ": Node with ID " << update.id << " does not exist.";
+				sendErrorCode(ISceneGraphErrorObserver::RSG_ERR_ID_DOES_NOT_EXIST);
+				return false;
+			}
+			vector<Id>& parents = getBatchParents(update.id, nodes[0], batchParents, batchNodes);
+			vector<Id>::iterator parent = std::find(parents.begin(), parents.end(), update.parentId);
+			if (parent == parents.end()) {
+				LOG(ERROR) << "Batch update " << i << ": Node with ID " << update.id << " has no parent " << update.parentId;
+				sendErrorCode(ISceneGraphErrorObserver::RSG_ERR_ID_DOES_NOT_EXIST);
+				return false;
+			}
+			parents.erase(parent);
+			break;
+		}
+
+		default:
+			LOG(ERROR) << "Batch update " << i << ": Unknown update type.";
+			return false;
+		}
+	}
+
+	return true;
+}
+
 Id SceneGraphFacade::getGlobalRootId() {
 	Node::NodeWeakPtr tmpNode = findNodeRecerence(getRootId());
 	Node::NodePtr node = tmpNode.lock();
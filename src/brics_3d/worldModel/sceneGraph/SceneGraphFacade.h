@@ -32,6 +32,9 @@
 #include "Transform.h"
 #include "UncertainTransform.h"
 #include "GeometricNode.h"
+#include "SceneGraphUpdateBatch.h"
+#include "AttributeQuery.h"
+#include "BoundingVolumeHierarchy.h"
 #include "Shape.h"
 
 #include <map>
@@ -80,6 +83,16 @@ class SceneGraphFacade : public ISceneGraphQuery, public ISceneGraphUpdate {
     /* Implemented query interfaces */
     bool getNodes(vector<Attribute> attributes, vector<Id>& ids);
     bool getNodes(vector<Attribute> attributes, vector<Id>& ids, Id subgraphId);
+
+    /**
+     * @brief Find all nodes that fulfill a precompiled query.
+     * Reuse the query to avoid recompilation of its patterns for repeated searches.
+     */
+    bool getNodes(const AttributeQuery& query, vector<Id>& ids);
+
+    /// Find all nodes in a subgraph that fulfill a precompiled query.
+    bool getNodes(const AttributeQuery& query, vector<Id>& ids, Id subgraphId);
+
     bool getNodeAttributes(Id id, vector<Attribute>& attributes);
     bool getNodeAttributes(Id id, vector<Attribute>& attributes, TimeStamp& timeStamp);
     bool getNodeParents(Id id, vector<Id>& parentIds);
@@ -92,6 +105,29 @@ class SceneGraphFacade : public ISceneGraphQuery, public ISceneGraphUpdate {
     bool getTransformForNode (Id id, Id idReferenceNode, TimeStamp timeStamp, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr& transform);
     bool getTransformForNode (Id id, Id idReferenceNode, TimeStamp timeStamp, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr& transform, TimeStamp& actualTimeStamp);
 
+    /*
+     * Spatial queries on the bounding boxes of all GeometricNodes. All geometric parameters are
+     * expressed in the frame of idReferenceNode (a nil Id denotes the root node) and the latest
+     * transforms are used. They are answered by a BoundingVolumeHierarchy that is notified about every
+     * addGeometricNode, setTransform or structural update and catches up lazily on the next query.
+     * False if the reference node does not exist.
+     */
+
+    /// Find all GeometricNodes within a radius around a center point.
+    bool getNodesInRadius(Id idReferenceNode, const Point3D& center, double radius, vector<Id>& ids);
+
+    /// Find all GeometricNodes that overlap with an axis aligned box of the reference frame.
+    bool getNodesInBox(Id idReferenceNode, const Point3D& minPoint, const Point3D& maxPoint, vector<Id>& ids);
+
+    /// Find the k nearest GeometricNodes of a point, ordered by ascending distance.
+    bool getNearestNodes(Id idReferenceNode, const Point3D& point, unsigned int k, vector<Id>& ids, vector<double>& distances);
+
+    /// Find all GeometricNodes that are hit by a ray, ordered by ascending distance.
+    bool getNodesAlongRay(Id idReferenceNode, const Point3D& origin, const Point3D& direction, double maxDistance, vector<Id>& ids, vector<double>& distances);
+
+    /// Bounding box of a GeometricNode in the frame of the root node.
+    bool getBoundingBox(Id id, BoundingVolumeHierarchy::BoundingBox& box);
+
     /* Implemented update interfaces */
     bool addNode(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId = false);
     bool addGroup(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId = false);
@@ -106,6 +142,25 @@ class SceneGraphFacade : public ISceneGraphQuery, public ISceneGraphUpdate {
     bool addParent(Id id, Id parentId);
     bool removeParent(Id id, Id parentId);
 
+    /**
+     * @brief Apply all updates of a batch atomically.
+     *
+     * The batch is validated first against the current graph for everything the single
+     * update functions can reject (existence and types of parents, IDs that exist already
+     * or have been used before, also within the batch, time stamps of attribute and
+     * transform updates, duplicated or missing parent-child relations). If this validation
+     * fails nothing will be applied at all. Otherwise the updates are applied in the order
+     * of recording and each attached observer will be notified only once by forwarding the
+     * complete batch to its applyUpdateBatch() function.
+     *
+     * Rejected batches are never forwarded to the observers, regardless of
+     * setCallObserversEvenIfErrorsOccurred().
+     *
+     * @param batch The recorded updates.
+     * @return True if the batch was valid and has been applied.
+     */
+    bool applyUpdateBatch(const SceneGraphUpdateBatch& batch);
+
     /* Incubation/Experimental methods for connection type */
     bool addConnection(Id parentId, Id& assignedId, vector<Attribute> attributes, vector<Id> sourceIds, vector<Id> targetIds, TimeStamp start, TimeStamp end, bool forcedId = false);
     bool getConnections(vector<Attribute> attributes, vector<Id>& ids);
@@ -169,6 +224,16 @@ class SceneGraphFacade : public ISceneGraphQuery, public ISceneGraphUpdate {
      */
     Node::NodeWeakPtr findNodeRecerence(Id id);
 
+    /**
+     * @brief Check if a batch can be applied without errors. Does not modify the graph.
+     * @param batch The batch to be checked.
+     * @return True if the batch is consistent with the current graph.
+     */
+    bool validateUpdateBatch(const SceneGraphUpdateBatch& batch);
+
+    /// Transform from the reference node to the root node for the spatial queries.
+    bool getReferenceTransform(Id idReferenceNode, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr& transform);
+
     /**
      * @brief Test if an ID is in the idLookUpTable.
      * @param id The ID.
@@ -188,6 +253,9 @@ class SceneGraphFacade : public ISceneGraphQuery, public ISceneGraphUpdate {
     /// Iterator for idLookUpTable
     map<Id, Node::NodeWeakPtr >::const_iterator nodeIterator;
 
+    /// Spatial index of all GeometricNodes.
+    BoundingVolumeHierarchy spatialIndex;
+
     /// Handle to ID generator. Can be optionally specified at creation.
     IIdGenerator* idGenerator;
 
@@ -0,0 +1,286 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#include "SceneGraphUpdateBatch.h"
+#include "brics_3d/core/Logger.h"
+#include <cassert>
+
+namespace brics_3d {
+namespace rsg {
+
+/* Default implementation of the ISceneGraphUpdate interface: plain replay without any transactional semantics. */
+bool ISceneGraphUpdate::applyUpdateBatch(const SceneGraphUpdateBatch& batch) {
+	return batch.replay(this);
+}
+
+SceneGraphUpdateBatch::SceneGraphUpdateBatch() {
+
+}
+
+SceneGraphUpdateBatch::~SceneGraphUpdateBatch() {
+
+}
+
+void SceneGraphUpdateBatch::assignId(Id& assignedId, bool forcedId) {
+	if(forcedId) {
+		return;
+	}
+	if(!idGenerator) {
+		idGenerator = boost::shared_ptr<UuidGenerator>(new UuidGenerator());
+	}
+	assignedId = idGenerator->getNextValidId();
+}
+
+bool SceneGraphUpdateBatch::addNode(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId) {
+	assignId(assignedId, forcedId);
+	Update update;
+	update.type = ADD_NODE;
+	update.parentId = parentId;
+	update.id = assignedId;
+	update.attributes = attributes;
+	updates.push_back(update);
+	return true;
+}
+
+bool SceneGraphUpdateBatch::addGroup(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId) {
+	assignId(assignedId, forcedId);
+	Update update;
+	update.type = ADD_GROUP;
+	update.parentId = parentId;
+	update.id = assignedId;
+	update.attributes = attributes;
+	updates.push_back(update);
+	return true;
+}
+
+bool SceneGraphUpdateBatch::addTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp, bool forcedId) {
+	assignId(assignedId, forcedId);
+	Update update;
+	update.type = ADD_TRANSFORM_NODE;
+	update.parentId = parentId;
+	update.id = assignedId;
+	update.attributes = attributes;
+	update.transform = transform;
+	update.timeStamp = timeStamp;
+	updates.push_back(update);
+	return true;
+}
+
+bool SceneGraphUpdateBatch::addUncertainTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp, bool forcedId) {
+	assignId(assignedId, forcedId);
+	Update update;
+	update.type = ADD_UNCERTAIN_TRANSFORM_NODE;
+	update.parentId = parentId;
+	update.id = assignedId;
+	update.attributes = attributes;
+	update.transform = transform;
+	update.uncertainty = uncertainty;
+	update.timeStamp = timeStamp;
+	updates.push_back(update);
+	return true;
+}
+
+bool SceneGraphUpdateBatch::addGeometricNode(Id parentId, Id& assignedId, vector<Attribute> attributes, Shape::ShapePtr shape, TimeStamp timeStamp, bool forcedId) {
+	assignId(assignedId, forcedId);
+	Update update;
+	update.type = ADD_GEOMETRIC_NODE;
+	update.parentId = parentId;
+	update.id = assignedId;
+	update.attributes = attributes;
+	update.shape = shape;
+	update.timeStamp = timeStamp;
+	updates.push_back(update);
+	return true;
+}
+
+bool SceneGraphUpdateBatch::addRemoteRootNode(Id rootId, vector<Attribute> attributes) {
+	Update update;
+	update.type = ADD_REMOTE_ROOT_NODE;
+	update.id = rootId;
+	update.attributes = attributes;
+	updates.push_back(update);
+	return true;
+}
+
+bool SceneGraphUpdateBatch::addConnection(Id parentId, Id& assignedId, vector<Attribute> attributes, vector<Id> sourceIds, vector<Id> targetIds, TimeStamp start, TimeStamp end, bool forcedId) {
+	assignId(assignedId, forcedId);
+	Update update;
+	update.type = ADD_CONNECTION;
+	update.parentId = parentId;
+	update.id = assignedId;
+	update.attributes = attributes;
+	update.sourceIds = sourceIds;
+	update.targetIds = targetIds;
+	update.start = start;
+	update.end = end;
+	updates.push_back(update);
+	return true;
+}
+
+bool SceneGraphUpdateBatch::setNodeAttributes(Id id, vector<Attribute> newAttributes, TimeStamp timeStamp) {
+	Update update;
+	update.type = SET_NODE_ATTRIBUTES;
+	update.id = id;
+	update.attributes = newAttributes;
+	update.timeStamp = timeStamp;
+	updates.push_back(update);
+	return true;
+}
+
+bool SceneGraphUpdateBatch::setTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp) {
+	Update update;
+	update.type = SET_TRANSFORM;
+	update.id = id;
+	update.transform = transform;
+	update.timeStamp = timeStamp;
+	updates.push_back(update);
+	return true;
+}
+
+bool SceneGraphUpdateBatch::setUncertainTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp) {
+	Update update;
+	update.type = SET_UNCERTAIN_TRANSFORM;
+	update.id = id;
+	update.transform = transform;
+	update.uncertainty = uncertainty;
+	update.timeStamp = timeStamp;
+	updates.push_back(update);
+	return true;
+}
+
+bool SceneGraphUpdateBatch::deleteNode(Id id) {
+	Update update;
+	update.type = DELETE_NODE;
+	update.id = id;
+	updates.push_back(update);
+	return true;
+}
+
+bool SceneGraphUpdateBatch::addParent(Id id, Id parentId) {
+	Update update;
+	update.type = ADD_PARENT;
+	update.id = id;
+	update.parentId = parentId;
+	updates.push_back(update);
+	return true;
+}
+
+bool SceneGraphUpdateBatch::removeParent(Id id, Id parentId) {
+	Update update;
+	update.type = REMOVE_PARENT;
+	update.id = id;
+	update.parentId = parentId;
+	updates.push_back(update);
+	return true;
+}
+
+bool SceneGraphUpdateBatch::applyUpdateBatch(const SceneGraphUpdateBatch& batch) {
+	if(&batch == this) {
+		LOG(WARNING) << "SceneGraphUpdateBatch: Cannot merge a batch with itself. Skipping it.";
+		return false;
+	}
+	updates.insert(updates.end(), batch.updates.begin(), batch.updates.end());
+	return true;
+}
+
+bool SceneGraphUpdateBatch::replay(ISceneGraphUpdate* target) const {
+	if(target == 0) {
+		LOG(ERROR) << "SceneGraphUpdateBatch: Cannot replay updates on a NULL target.";
+		return false;
+	}
+
+	bool success = true;
+	for (vector<Update>::const_iterator it = updates.begin(); it != updates.end(); ++it) {
+		Id assignedId = it->id; // copy, as the interface takes a reference
+		bool result = false;
+
+		switch (it->type) {
+		case ADD_NODE:
+			result = target->addNode(it->parentId, assignedId, it->attributes, true);
+			break;
+		case ADD_GROUP:
+			result = target->addGroup(it->parentId, assignedId, it->attributes, true);
+			break;
+		case ADD_TRANSFORM_NODE:
+			result = target->addTransformNode(it->parentId, assignedId, it->attributes, it->transform, it->timeStamp, true);
+			break;
+		case ADD_UNCERTAIN_TRANSFORM_NODE:
+			result = target->addUncertainTransformNode(it->parentId, assignedId, it->attributes, it->transform, it->uncertainty, it->timeStamp, true);
+			break;
+		case ADD_GEOMETRIC_NODE:
+			result = target->addGeometricNode(it->parentId, assignedId, it->attributes, it->shape, it->timeStamp, true);
+			break;
+		case ADD_REMOTE_ROOT_NODE:
+			result = target->addRemoteRootNode(it->id, it->attributes);
+			break;
+		case ADD_CONNECTION:
+			result = target->addConnection(it->parentId, assignedId, it->attributes, it->sourceIds, it->targetIds, it->start, it->end, true);
+			break;
+		case SET_NODE_ATTRIBUTES:
+			result = target->setNodeAttributes(it->id, it->attributes, it->timeStamp);
+			break;
+		case SET_TRANSFORM:
+			result = target->setTransform(it->id, it->transform, it->timeStamp);
+			break;
+		case SET_UNCERTAIN_TRANSFORM:
+			result = target->setUncertainTransform(it->id, it->transform, it->uncertainty, it->timeStamp);
+			break;
+		case DELETE_NODE:
+			result = target->deleteNode(it->id);
+			break;
+		case ADD_PARENT:
+			result = target->addParent(it->id, it->parentId);
+			break;
+		case REMOVE_PARENT:
+			result = target->removeParent(it->id, it->parentId);
+			break;
+		default:
+			LOG(ERROR) << "SceneGraphUpdateBatch: Unknown update type " << it->type;
+			break;
+		}
+
+		if(!result) {
+			success = false;
+		}
+	}
+
+	return success;
+}
+
+void SceneGraphUpdateBatch::clear() {
+	updates.clear();
+}
+
+unsigned int SceneGraphUpdateBatch::getNumberOfUpdates() const {
+	return static_cast<unsigned int>(updates.size());
+}
+
+const SceneGraphUpdateBatch::Update& SceneGraphUpdateBatch::getUpdate(unsigned int index) const {
+	assert(index < updates.size());
+	return updates[index];
+}
+
+bool SceneGraphUpdateBatch::isEmpty() const {
+	return updates.empty();
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
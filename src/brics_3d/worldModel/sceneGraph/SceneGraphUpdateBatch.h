@@ -0,0 +1,149 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#ifndef RSG_SCENEGRAPHUPDATEBATCH_H_
+#define RSG_SCENEGRAPHUPDATEBATCH_H_
+
+#include "ISceneGraphUpdate.h"
+#include "Attribute.h"
+#include "UuidGenerator.h"
+#include <boost/shared_ptr.hpp>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Records a sequence of scene graph updates that shall be applied as one transaction.
+ * @ingroup sceneGraph
+ *
+ * A batch implements the ISceneGraphUpdate interface, so it can be filled
+ * with the same calls as a SceneGraphFacade. Nothing is applied while recording.
+ * The batch is then handed over to brics_3d::rsg::ISceneGraphUpdate::applyUpdateBatch()
+ * of e.g. a SceneGraphFacade that applies it atomically and notifies its observers only once.
+ *
+ * IDs of newly added nodes are assigned at recording time (unless forcedId is set), such
+ * that subsequent updates within the same batch can refer to them. The recorded updates
+ * are stored with forcedId = true, which makes a replay on another scene graph deterministic.
+ *
+ * Example:
+ * @code
+ * SceneGraphUpdateBatch batch;
+ * Id groupId;
+ * batch.addGroup(wm->getRootNodeId(), groupId, attributes);
+ * Id tfId;
+ * batch.addTransformNode(groupId, tfId, attributes, transform, now);
+ * wm->scene.applyUpdateBatch(batch);
+ * @endcode
+ */
+class SceneGraphUpdateBatch : public ISceneGraphUpdate {
+public:
+
+	typedef boost::shared_ptr<SceneGraphUpdateBatch> SceneGraphUpdateBatchPtr;
+
+	/// Kind of a recorded update. There is one for every function of the ISceneGraphUpdate interface.
+	enum UpdateType {
+		ADD_NODE,
+		ADD_GROUP,
+		ADD_TRANSFORM_NODE,
+		ADD_UNCERTAIN_TRANSFORM_NODE,
+		ADD_GEOMETRIC_NODE,
+		ADD_REMOTE_ROOT_NODE,
+		ADD_CONNECTION,
+		SET_NODE_ATTRIBUTES,
+		SET_TRANSFORM,
+		SET_UNCERTAIN_TRANSFORM,
+		DELETE_NODE,
+		ADD_PARENT,
+		REMOVE_PARENT
+	};
+
+	/// A single recorded update. Only the fields relevant for the type are set.
+	struct Update {
+		UpdateType type;
+		Id id;
+		Id parentId;
+		vector<Attribute> attributes;
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform;
+		ITransformUncertainty::ITransformUncertaintyPtr uncertainty;
+		Shape::ShapePtr shape;
+		TimeStamp timeStamp;
+		vector<Id> sourceIds;
+		vector<Id> targetIds;
+		TimeStamp start;
+		TimeStamp end;
+	};
+
+	SceneGraphUpdateBatch();
+	virtual ~SceneGraphUpdateBatch();
+
+	/* Implemetation of ISceneGraphUpdate interface. These calls only record the updates. */
+	bool addNode(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId = false);
+	bool addGroup(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forcedId = false);
+	bool addTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp, bool forcedId = false);
+	bool addUncertainTransformNode(Id parentId, Id& assignedId, vector<Attribute> attributes, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp, bool forcedId = false);
+	bool addGeometricNode(Id parentId, Id& assignedId, vector<Attribute> attributes, Shape::ShapePtr shape, TimeStamp timeStamp, bool forcedId = false);
+	bool addRemoteRootNode(Id rootId, vector<Attribute> attributes);
+	bool addConnection(Id parentId, Id& assignedId, vector<Attribute> attributes, vector<Id> sourceIds, vector<Id> targetIds, TimeStamp start, TimeStamp end, bool forcedId = false);
+	bool setNodeAttributes(Id id, vector<Attribute> newAttributes, TimeStamp timeStamp = TimeStamp(0));
+	bool setTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp);
+	bool setUncertainTransform(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, ITransformUncertainty::ITransformUncertaintyPtr uncertainty, TimeStamp timeStamp);
+	bool deleteNode(Id id);
+	bool addParent(Id id, Id parentId);
+	bool removeParent(Id id, Id parentId);
+
+	/**
+	 * @brief Append all updates of another batch to this one.
+	 * @param batch The batch to be merged.
+	 * @return Always true.
+	 */
+	bool applyUpdateBatch(const SceneGraphUpdateBatch& batch);
+
+	/**
+	 * @brief Call the recorded updates one by one in the order of recording.
+	 * @param target The interface to receive the updates. E.g. a SceneGraphFacade or an observer.
+	 * @return True if all calls returned true. The replay does not stop on a failed update.
+	 */
+	bool replay(ISceneGraphUpdate* target) const;
+
+	/// Remove all recorded updates.
+	void clear();
+
+	unsigned int getNumberOfUpdates() const;
+	const Update& getUpdate(unsigned int index) const;
+	bool isEmpty() const;
+
+private:
+
+	/// Assigns a new ID for non forced additions.
+	void assignId(Id& assignedId, bool forcedId);
+
+	vector<Update> updates;
+
+	/// Lazily created as it is only required if IDs are not forced.
+	boost::shared_ptr<UuidGenerator> idGenerator;
+};
+
+typedef SceneGraphUpdateBatch::SceneGraphUpdateBatchPtr SceneGraphUpdateBatchPtr;
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_SCENEGRAPHUPDATEBATCH_H_ */
+
+/* EOF */
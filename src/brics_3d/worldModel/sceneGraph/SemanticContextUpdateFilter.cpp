@@ -26,6 +26,7 @@ namespace rsg {
 SemanticContextUpdateFilter::SemanticContextUpdateFilter(SceneGraphFacade* scene) : scene(scene) {
 	this->nameSpaceIdentifier = "unknown_namespace";
 	assert(this->scene != 0);
+	contextQuery.compile(vector<Attribute>(1, Attribute(query, "*")));
 }
 
 SemanticContextUpdateFilter::~SemanticContextUpdateFilter() {
@@ -35,7 +36,7 @@ SemanticContextUpdateFilter::~SemanticContextUpdateFilter() {
 bool SemanticContextUpdateFilter::addNode(Id parentId, Id& assignedId,
 		vector<Attribute> attributes, bool forcedId) {
 
-	if (attributeListContainsAttribute(attributes, Attribute(query, "*"))) {
+	if (contextQuery.matches(attributes)) {
 		LOG(DEBUG) << "SemanticContextUpdateFilter:addNode creation is skipped because attributes contain (" << query << ", *)";
 		return false;
 	}
@@ -51,7 +52,7 @@ bool SemanticContextUpdateFilter::addNode(Id parentId, Id& assignedId,
 bool SemanticContextUpdateFilter::addGroup(Id parentId, Id& assignedId,
 		vector<Attribute> attributes, bool forcedId) {
 
-	if (attributeListContainsAttribute(attributes, Attribute(query, "*"))) {
+	if (contextQuery.matches(attributes)) {
 		LOG(DEBUG) << "SemanticContextUpdateFilter:addGroup creation is skipped because attributes contain (" << query << ", *)";
 		return false;
 	}
@@ -69,7 +70,7 @@ bool SemanticContextUpdateFilter::addTransformNode(Id parentId, Id& assignedId,
 		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform,
 		TimeStamp timeStamp, bool forcedId) {
 
-	if (attributeListContainsAttribute(attributes, Attribute(query, "*"))) {
+	if (contextQuery.matches(attributes)) {
 		LOG(DEBUG) << "SemanticContextUpdateFilter:addTransformNode creation is skipped because attributes contain (" << query << ", *)";
 		return false;
 	}
@@ -90,7 +91,7 @@ bool SemanticContextUpdateFilter::addUncertainTransformNode(Id parentId,
 		ITransformUncertainty::ITransformUncertaintyPtr uncertainty,
 		TimeStamp timeStamp, bool forcedId) {
 
-	if (attributeListContainsAttribute(attributes, Attribute(query, "*"))) {
+	if (contextQuery.matches(attributes)) {
 		LOG(DEBUG) << "SemanticContextUpdateFilter:addUncertainTransformNode creation is skipped because attributes contain (" << query << ", *)";
 		return false;
 	}
@@ -109,7 +110,7 @@ bool SemanticContextUpdateFilter::addGeometricNode(Id parentId, Id& assignedId,
 		vector<Attribute> attributes, Shape::ShapePtr shape,
 		TimeStamp timeStamp, bool forcedId) {
 
-	if (attributeListContainsAttribute(attributes, Attribute(query, "*"))) {
+	if (contextQuery.matches(attributes)) {
 		LOG(DEBUG) << "SemanticContextUpdateFilter:addGeometricNode creation is skipped because attributes contain (" << query << ", *)";
 		return false;
 	}
@@ -139,7 +140,7 @@ bool SemanticContextUpdateFilter::addRemoteRootNode(Id rootId, vector<Attribute>
 
 bool SemanticContextUpdateFilter::addConnection(Id parentId, Id& assignedId, vector<Attribute> attributes, vector<Id> sourceIds, vector<Id> targetIds, TimeStamp start, TimeStamp end, bool forcedId) {
 
-	if (attributeListContainsAttribute(attributes, Attribute(query, "*"))) {
+	if (contextQuery.matches(attributes)) {
 		LOG(DEBUG) << "SemanticContextUpdateFilter:addConnection creation is skipped because attributes contain (" << query << ", *)";
 		return false;
 	}
@@ -162,7 +163,7 @@ bool SemanticContextUpdateFilter::setNodeAttributes(Id id,
 		return false;
 	}
 
-	if (attributeListContainsAttribute(attributes, Attribute(query, "*"))) {
+	if (contextQuery.matches(attributes)) {
 		LOG(DEBUG) << "SemanticContextUpdateFilter:setNodeAttributes update is skipped because attributes contain (" << query << ", *)";
 		return false;
 	}
@@ -185,7 +186,7 @@ bool SemanticContextUpdateFilter::setTransform(Id id,
 		return false;
 	}
 
-	if (attributeListContainsAttribute(attributes, Attribute(query, "*"))) {
+	if (contextQuery.matches(attributes)) {
 		LOG(DEBUG) << "SemanticContextUpdateFilter:setTransform update is skipped because attributes contain (" << query << ", *)";
 		return false;
 	}
@@ -210,7 +211,7 @@ bool SemanticContextUpdateFilter::setUncertainTransform(Id id,
 		return false;
 	}
 
-	if (attributeListContainsAttribute(attributes, Attribute(query, "*"))) {
+	if (contextQuery.matches(attributes)) {
 		LOG(DEBUG) << "SemanticContextUpdateFilter:setUncertainTransform update is skipped because attributes contain (" << query << ", *)";
 		return false;
 	}
@@ -233,7 +234,7 @@ bool SemanticContextUpdateFilter::deleteNode(Id id) {
 		return false;
 	}
 
-	if (attributeListContainsAttribute(attributes, Attribute(query, "*"))) {
+	if (contextQuery.matches(attributes)) {
 		LOG(DEBUG) << "SemanticContextUpdateFilter:deleteNode deletion is skipped because attributes contain (" << query << ", *)";
 		return false;
 	}
@@ -253,7 +254,7 @@ bool SemanticContextUpdateFilter::addParent(Id id, Id parentId) {
 		return false;
 	}
 
-	if (attributeListContainsAttribute(attributes, Attribute(query, "*"))) {
+	if (contextQuery.matches(attributes)) {
 		LOG(DEBUG) << "SemanticContextUpdateFilter:addParent creation is skipped because attributes contain (" << query << ", *)";
 		return false;
 	}
@@ -274,7 +275,7 @@ bool SemanticContextUpdateFilter::removeParent(Id id, Id parentId) {
 		return false;
 	}
 
-	if (attributeListContainsAttribute(attributes, Attribute(query, "*"))) {
+	if (contextQuery.matches(attributes)) {
 		LOG(DEBUG) << "SemanticContextUpdateFilter:removeParent deletion is skipped because attributes contain (" << query << ", *)";
 		return false;
 	}
@@ -315,6 +316,7 @@ void SemanticContextUpdateFilter::setNameSpaceIdentifier(
 		const string& nameSpaceIdentifier) {
 	this->nameSpaceIdentifier = nameSpaceIdentifier;
 	this->query =  "^"  + nameSpaceIdentifier + ":.*"; // wildcard = ^.*
+	contextQuery.compile(vector<Attribute>(1, Attribute(query, "*"))); // compiled once, rather than for every update
 }
 
 } /* namespace rsg */
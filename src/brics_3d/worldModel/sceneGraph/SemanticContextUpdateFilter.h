@@ -23,6 +23,7 @@
 #include "brics_3d/worldModel/sceneGraph/ISceneGraphUpdateObserver.h"
 #include "brics_3d/worldModel/sceneGraph/SceneGraphFacade.h"
 #include "brics_3d/worldModel/sceneGraph/Attribute.h"
+#include "brics_3d/worldModel/sceneGraph/AttributeQuery.h"
 
 namespace brics_3d {
 namespace rsg {
@@ -65,6 +66,9 @@ private:
     /// Internal query used to check if at least one attribute has belongs to a Semantic Context
     string query;
 
+    /// Precompiled version of the query
+    AttributeQuery contextQuery;
+
     /// Handle for internal queries
     SceneGraphFacade* scene;
 };
@@ -0,0 +1,143 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#include "SharedMemoryInputBridge.h"
+#include "brics_3d/core/Logger.h"
+#include <cstring>
+#include <boost/thread.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace brics_3d {
+namespace rsg {
+
+SharedMemoryInputBridge::SharedMemoryInputBridge(IInputPort* messagePort, std::string name) :
+		messagePort(messagePort), name(name), cursor(0), copyMessages(true), senderRestarted(false),
+		expectedSequenceNumber(0), receivedMessageCount(0), lostMessageCount(0) {
+	spinCount = (boost::thread::hardware_concurrency() > 1) ? 1000 : 0; // spinning only helps if the sender runs in parallel
+	connect();
+}
+
+SharedMemoryInputBridge::~SharedMemoryInputBridge() {
+
+}
+
+bool SharedMemoryInputBridge::connect() {
+	if (ringBuffer.isOpen()) {
+		return true;
+	}
+	if (!ringBuffer.open(name)) {
+		return false;
+	}
+	if (senderRestarted) {
+		/* Start at the beginning of the new segment; peek() skips what has already been overwritten */
+		cursor = 0;
+		expectedSequenceNumber = 0;
+		senderRestarted = false;
+		LOG(INFO) << "SharedMemoryInputBridge: Reconnected to the new shared memory segment " << name;
+		return true;
+	}
+	cursor = ringBuffer.getWritePosition();
+	expectedSequenceNumber = ringBuffer.getPushedMessageCount(); // might be ahead of the cursor, but not behind
+	LOG(DEBUG) << "SharedMemoryInputBridge: Connected to shared memory segment " << name;
+	return true;
+}
+
+bool SharedMemoryInputBridge::reconnect() {
+	ringBuffer.close();
+	senderRestarted = true;
+	return connect(); // might fail until the new sender has created its segment, poll() retries
+}
+
+unsigned int SharedMemoryInputBridge::poll(unsigned int maxMessages) {
+	if (!connect()) {
+		return 0;
+	}
+
+	unsigned int forwardedMessages = 0;
+	const char* data = 0;
+	boost::uint32_t length = 0;
+	boost::uint32_t sequenceNumber = 0;
+	int transferredBytes = 0;
+	while (maxMessages == 0 || forwardedMessages < maxMessages) {
+		SharedMemoryRingBuffer::ReadResult result = ringBuffer.peek(cursor, data, length, sequenceNumber);
+		if (result == SharedMemoryRingBuffer::NO_MESSAGE) {
+			if (ringBuffer.isClosed() && reconnect()) { // all messages of the old segment have been read
+				continue;
+			}
+			break;
+		} else if (result == SharedMemoryRingBuffer::LAPPED) {
+			continue; // the sequence number of the next message tells how many are lost
+		}
+
+		boost::int32_t gap = static_cast<boost::int32_t>(sequenceNumber - expectedSequenceNumber);
+		if (gap > 0) {
+			lostMessageCount += gap;
+		}
+		expectedSequenceNumber = sequenceNumber + 1;
+
+		if (copyMessages) {
+			messageCopy.resize(length);
+			if (length > 0) {
+				std::memcpy(&messageCopy[0], data, length);
+			}
+			if (!ringBuffer.isValid(cursor)) {
+				lostMessageCount++;
+				continue; // peek() detects the lapping
+			}
+			ringBuffer.advance(cursor, length);
+			messagePort->write(length > 0 ? &messageCopy[0] : 0, static_cast<int>(length), transferredBytes);
+		} else {
+			messagePort->write(data, static_cast<int>(length), transferredBytes);
+			if (!ringBuffer.isValid(cursor)) {
+				LOG(WARNING) << "SharedMemoryInputBridge: Message " << sequenceNumber << " has been overwritten while it was processed.";
+				lostMessageCount++;
+				receivedMessageCount++;
+				forwardedMessages++;
+				continue;
+			}
+			ringBuffer.advance(cursor, length);
+		}
+		receivedMessageCount++;
+		forwardedMessages++;
+	}
+	return forwardedMessages;
+}
+
+unsigned int SharedMemoryInputBridge::waitForMessages(unsigned int timeoutInMicroSeconds, unsigned int maxMessages) {
+	boost::posix_time::ptime deadline = boost::posix_time::microsec_clock::universal_time() + boost::posix_time::microseconds(timeoutInMicroSeconds);
+	unsigned int spins = 0;
+	while (true) {
+		unsigned int forwardedMessages = poll(maxMessages);
+		if (forwardedMessages > 0) {
+			return forwardedMessages;
+		}
+		if (spins++ < spinCount) {
+			continue;
+		}
+		if (boost::posix_time::microsec_clock::universal_time() >= deadline) {
+			return 0;
+		}
+		boost::this_thread::yield();
+	}
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
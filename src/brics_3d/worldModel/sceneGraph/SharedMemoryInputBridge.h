@@ -0,0 +1,147 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#ifndef RSG_SHAREDMEMORYINPUTBRIDGE_H_
+#define RSG_SHAREDMEMORYINPUTBRIDGE_H_
+
+#include "brics_3d/worldModel/sceneGraph/IPort.h"
+#include "brics_3d/worldModel/sceneGraph/SharedMemoryRingBuffer.h"
+#include <vector>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Receives the messages of a SharedMemoryOutputPort and forwards them to an IInputPort.
+ * @ingroup sceneGraph
+ *
+ * The bridge is the receiving side of the shared memory transport, similar to the receiver
+ * threads of socket based transports. poll() forwards all new messages to the input port,
+ * e.g. a deserializer of a world model replica. By default the input port gets a private
+ * copy of every message that has been verified to be consistent before it is forwarded.
+ *
+ * setCopyMessages(false) forwards a pointer directly into the shared memory (zero-copy)
+ * instead. If the sender overwrites that message while the input port processes it, the
+ * input port sees torn data; this is only detected afterwards and counted as lost message.
+ * Use zero-copy only with input ports that tolerate corrupted input, e.g. ones that only
+ * count or forward messages. A deserializer would apply the corrupted update to the replica.
+ *
+ * @code
+ * BinaryUpdateDeserializer deserializer(wmReplica);
+ * SharedMemoryInputBridge bridge(&deserializer, "/brics_3d_wm");
+ * while (running) {
+ *     bridge.waitForMessages(1000);
+ * }
+ * @endcode
+ *
+ * The sender may be started after the receiver. The bridge only receives messages that are
+ * published after it has been connected. If the sender is restarted, the bridge reads the
+ * remaining messages of the old segment and then connects to the new one, receiving all
+ * messages of the new sender that are still in its buffer. It is not thread safe; use one
+ * bridge per thread.
+ */
+class SharedMemoryInputBridge {
+public:
+
+	/**
+	 * @brief Constructor.
+	 * @param messagePort Receiver of the messages.
+	 * @param name Name of the shared memory segment of the SharedMemoryOutputPort.
+	 */
+	SharedMemoryInputBridge(IInputPort* messagePort, std::string name);
+	virtual ~SharedMemoryInputBridge();
+
+	/// Open the shared memory segment if that has not been done yet. Called by poll().
+	bool connect();
+
+	/// True if the bridge is connected to a segment that is still used by its sender.
+	bool isConnected() const {
+		return ringBuffer.isOpen() && !ringBuffer.isClosed();
+	}
+
+	/**
+	 * @brief Forward the available messages to the input port.
+	 * @param maxMessages Maximum number of messages to forward. 0 means all available.
+	 * @return Number of forwarded messages.
+	 */
+	unsigned int poll(unsigned int maxMessages = 0);
+
+	/**
+	 * @brief Busy wait until at least one message has been forwarded.
+	 * Spins for getSpinCount() polls and yields the processor afterwards.
+	 * @param timeoutInMicroSeconds Maximum waiting time.
+	 * @return Number of forwarded messages. 0 if the timeout has elapsed.
+	 */
+	unsigned int waitForMessages(unsigned int timeoutInMicroSeconds, unsigned int maxMessages = 0);
+
+	unsigned int getSpinCount() const {
+		return spinCount;
+	}
+
+	/// Number of polls in waitForMessages() before the processor is yielded. Default is 1000 on multi core machines, otherwise 0.
+	void setSpinCount(unsigned int spinCount) {
+		this->spinCount = spinCount;
+	}
+
+	bool getCopyMessages() const {
+		return copyMessages;
+	}
+
+	/// Forward verified copies instead of pointers into the shared memory. Default is true, see class description for zero-copy.
+	void setCopyMessages(bool copyMessages) {
+		this->copyMessages = copyMessages;
+	}
+
+	/// Number of messages that have been forwarded.
+	unsigned long getReceivedMessageCount() const {
+		return receivedMessageCount;
+	}
+
+	/// Number of messages that have been overwritten by the sender before or while they were read.
+	unsigned long getLostMessageCount() const {
+		return lostMessageCount;
+	}
+
+private:
+
+	/// Switch to the new segment of a restarted sender.
+	bool reconnect();
+
+	IInputPort* messagePort;
+	std::string name;
+	SharedMemoryRingBuffer ringBuffer;
+	boost::uint64_t cursor;
+	bool copyMessages;
+	bool senderRestarted;
+	unsigned int spinCount;
+	std::vector<char> messageCopy;
+
+	/// Sequence number of the next message. A larger one means that messages have been lost.
+	boost::uint32_t expectedSequenceNumber;
+
+	unsigned long receivedMessageCount;
+	unsigned long lostMessageCount;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_SHAREDMEMORYINPUTBRIDGE_H_ */
+
+/* EOF */
@@ -0,0 +1,51 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#include "SharedMemoryOutputPort.h"
+#include "brics_3d/core/Logger.h"
+
+namespace brics_3d {
+namespace rsg {
+
+SharedMemoryOutputPort::SharedMemoryOutputPort(std::string name, size_t capacity, bool takeOver, unsigned int permissions) : rejectedMessageCount(0) {
+	ringBuffer.create(name, capacity, takeOver, permissions);
+}
+
+SharedMemoryOutputPort::~SharedMemoryOutputPort() {
+
+}
+
+int SharedMemoryOutputPort::write(const char *dataBuffer, int dataLength, int &transferredBytes) {
+	transferredBytes = 0;
+	if (!ringBuffer.isOpen() || dataLength < 0) {
+		return -1;
+	}
+	if (!ringBuffer.push(dataBuffer, static_cast<size_t>(dataLength))) {
+		LOG(WARNING) << "SharedMemoryOutputPort: Message of " << dataLength << " bytes exceeds the maximum message size of " << ringBuffer.getMaxMessageSize() << " bytes. Skipping it.";
+		rejectedMessageCount++;
+		return -1;
+	}
+	transferredBytes = dataLength;
+	return 1;
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
@@ -0,0 +1,94 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#ifndef RSG_SHAREDMEMORYOUTPUTPORT_H_
+#define RSG_SHAREDMEMORYOUTPUTPORT_H_
+
+#include "brics_3d/worldModel/sceneGraph/IPort.h"
+#include "brics_3d/worldModel/sceneGraph/SharedMemoryRingBuffer.h"
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Output port that publishes serialized updates to world model replicas on the same host.
+ * @ingroup sceneGraph
+ *
+ * Every write() is one message in a SharedMemoryRingBuffer. Any number of processes can
+ * receive the messages with a SharedMemoryInputBridge. The write never blocks: slow
+ * receivers lose the oldest messages rather than slowing down the sender.
+ *
+ * @code
+ * SharedMemoryOutputPort sharedMemoryPort("/brics_3d_wm");
+ * BinaryUpdateSerializer serializer(&sharedMemoryPort);
+ * wm->scene.attachUpdateObserver(&serializer);
+ * @endcode
+ *
+ * There can be only one SharedMemoryOutputPort per name. Creating it fails (isOpen() is false) while
+ * another sender process uses the name, unless takeOver is set. A segment left behind by a terminated
+ * sender is replaced, connected SharedMemoryInputBridges follow the new segment.
+ */
+class SharedMemoryOutputPort : public IOutputPort {
+public:
+
+	/**
+	 * @brief Constructor.
+	 * @param name Name of the shared memory segment, e.g. "/brics_3d_wm".
+	 * @param capacity Size of the ring buffer in bytes. Messages can be up to half of it.
+	 * @param takeOver Replace the segment even if its sender is still running.
+	 * @param permissions Access permissions of the segment, e.g. 0660 to allow receivers of the same group.
+	 */
+	SharedMemoryOutputPort(std::string name, size_t capacity = 16*1024*1024, bool takeOver = false, unsigned int permissions = 0600);
+	virtual ~SharedMemoryOutputPort();
+
+	/**
+	 * @brief Publish a message.
+	 * @return 1 on success, -1 if the segment could not be created or the message is too large.
+	 */
+	int write(const char *dataBuffer, int dataLength, int &transferredBytes);
+
+	bool isOpen() const {
+		return ringBuffer.isOpen();
+	}
+
+	/// Number of messages that have been published.
+	unsigned long getMessageCount() const {
+		return ringBuffer.getPushedMessageCount();
+	}
+
+	/// Number of messages that have been rejected because they exceed half of the capacity.
+	unsigned long getRejectedMessageCount() const {
+		return rejectedMessageCount;
+	}
+
+	const SharedMemoryRingBuffer& getRingBuffer() const {
+		return ringBuffer;
+	}
+
+private:
+	SharedMemoryRingBuffer ringBuffer;
+	unsigned long rejectedMessageCount;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_SHAREDMEMORYOUTPUTPORT_H_ */
+
+/* EOF */
@@ -0,0 +1,351 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#include "SharedMemoryRingBuffer.h"
+#include "brics_3d/core/Logger.h"
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <signal.h>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * Layout of the shared memory segment. The positions are placed in separate cache lines,
+ * as they are written by the producer and polled by all consumers. The message area
+ * directly follows the header.
+ */
+struct SharedMemoryRingBuffer::Header {
+	boost::uint32_t magic;
+	boost::uint32_t version;
+	boost::uint64_t capacity;
+	boost::uint32_t producerProcessId;
+	volatile boost::uint32_t closed;
+	char padding0[40];
+	volatile boost::uint64_t writeIntent;
+	char padding1[56];
+	volatile boost::uint64_t writePosition;
+	volatile boost::uint32_t nextSequenceNumber;
+	char padding2[52];
+};
+
+namespace {
+
+const boost::uint32_t ringBufferMagic = 0x42534D52; // "RMSB"
+const boost::uint32_t ringBufferVersion = 2;
+const boost::uint32_t wrapMarker = 0xFFFFFFFF;
+
+inline boost::uint64_t loadPosition(const volatile boost::uint64_t& position) {
+	boost::uint64_t value = position;
+	__sync_synchronize();
+	return value;
+}
+
+inline void storePosition(volatile boost::uint64_t& position, boost::uint64_t value) {
+	__sync_synchronize();
+	position = value;
+}
+
+} // anonymous namespace
+
+SharedMemoryRingBuffer::SharedMemoryRingBuffer() : producer(false), header(0), buffer(0), mappedSize(0) {
+
+}
+
+SharedMemoryRingBuffer::~SharedMemoryRingBuffer() {
+	close();
+}
+
+bool SharedMemoryRingBuffer::create(std::string name, size_t capacity, bool takeOver, unsigned int permissions) {
+	close();
+	capacity = (capacity + 7) & ~static_cast<size_t>(7);
+	if (capacity < 64) {
+		LOG(ERROR) << "SharedMemoryRingBuffer: Capacity of " << capacity << " bytes is too small.";
+		return false;
+	}
+
+	int fileDescriptor = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, static_cast<mode_t>(permissions));
+	if (fileDescriptor < 0 && errno == EEXIST) {
+		if (!removeStaleSegment(name, takeOver)) {
+			return false;
+		}
+		fileDescriptor = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, static_cast<mode_t>(permissions));
+	}
+	if (fileDescriptor < 0) {
+		LOG(ERROR) << "SharedMemoryRingBuffer: Cannot create shared memory segment " << name << ": " << strerror(errno);
+		return false;
+	}
+	fchmod(fileDescriptor, static_cast<mode_t>(permissions)); // shm_open() applies the umask
+	size_t size = sizeof(Header) + capacity;
+	if (ftruncate(fileDescriptor, static_cast<off_t>(size)) != 0) {
+		LOG(ERROR) << "SharedMemoryRingBuffer: Cannot resize shared memory segment " << name << ": " << strerror(errno);
+		::close(fileDescriptor);
+		shm_unlink(name.c_str());
+		return false;
+	}
+	if (!map(fileDescriptor, size, true)) {
+		shm_unlink(name.c_str());
+		return false;
+	}
+
+	/* ftruncate zero fills, so only the constants need to be set. The magic number comes last. */
+	header->version = ringBufferVersion;
+	header->capacity = capacity;
+	header->producerProcessId = static_cast<boost::uint32_t>(getpid());
+	__sync_synchronize();
+	header->magic = ringBufferMagic;
+	__sync_synchronize();
+
+	this->name = name;
+	producer = true;
+	LOG(DEBUG) << "SharedMemoryRingBuffer: Created segment " << name << " with a capacity of " << capacity << " bytes.";
+	return true;
+}
+
+bool SharedMemoryRingBuffer::open(std::string name) {
+	close();
+	int fileDescriptor = shm_open(name.c_str(), O_RDONLY, 0);
+	if (fileDescriptor < 0) {
+		return false;
+	}
+	struct stat status;
+	if (fstat(fileDescriptor, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(Header)) {
+		::close(fileDescriptor);
+		return false;
+	}
+	if (!map(fileDescriptor, static_cast<size_t>(status.st_size), false)) {
+		return false;
+	}
+	__sync_synchronize();
+	if (header->magic != ringBufferMagic || header->version != ringBufferVersion || sizeof(Header) + header->capacity > mappedSize) {
+		LOG(WARNING) << "SharedMemoryRingBuffer: Segment " << name << " has no valid ring buffer layout (yet).";
+		close();
+		return false;
+	}
+	if (header->closed != 0) { // the producer is about to remove it
+		close();
+		return false;
+	}
+
+	this->name = name;
+	producer = false;
+	return true;
+}
+
+bool SharedMemoryRingBuffer::removeStaleSegment(std::string name, bool takeOver) {
+	int fileDescriptor = shm_open(name.c_str(), O_RDWR, 0);
+	if (fileDescriptor < 0) {
+		LOG(ERROR) << "SharedMemoryRingBuffer: Cannot open existing shared memory segment " << name << ": " << strerror(errno);
+		return false;
+	}
+	struct stat status;
+	if (fstat(fileDescriptor, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(Header)) { // not a ring buffer (yet)
+		::close(fileDescriptor);
+		if (!takeOver) {
+			LOG(ERROR) << "SharedMemoryRingBuffer: Shared memory segment " << name << " already exists.";
+			return false;
+		}
+		shm_unlink(name.c_str());
+		return true;
+	}
+	void* memory = mmap(0, sizeof(Header), PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+	::close(fileDescriptor);
+	if (memory == MAP_FAILED) {
+		LOG(ERROR) << "SharedMemoryRingBuffer: Cannot map existing shared memory segment " << name << ": " << strerror(errno);
+		return false;
+	}
+	Header* existing = static_cast<Header*>(memory);
+	__sync_synchronize();
+	bool alive = existing->magic == ringBufferMagic && existing->version == ringBufferVersion && existing->closed == 0 &&
+			(kill(static_cast<pid_t>(existing->producerProcessId), 0) == 0 || errno == EPERM);
+	if (alive && !takeOver) {
+		LOG(ERROR) << "SharedMemoryRingBuffer: Shared memory segment " << name << " is used by the producer process " << existing->producerProcessId << ".";
+		munmap(memory, sizeof(Header));
+		return false;
+	}
+
+	/* Tell the connected consumers to remap */
+	LOG(WARNING) << "SharedMemoryRingBuffer: Replacing the " << (alive ? "" : "stale ") << "shared memory segment " << name << ".";
+	existing->closed = 1;
+	__sync_synchronize();
+	munmap(memory, sizeof(Header));
+	shm_unlink(name.c_str());
+	return true;
+}
+
+bool SharedMemoryRingBuffer::map(int fileDescriptor, size_t size, bool writable) {
+	void* memory = mmap(0, size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fileDescriptor, 0);
+	::close(fileDescriptor); // the mapping keeps the segment alive
+	if (memory == MAP_FAILED) {
+		LOG(ERROR) << "SharedMemoryRingBuffer: Cannot map shared memory segment: " << strerror(errno);
+		return false;
+	}
+	header = static_cast<Header*>(memory);
+	buffer = static_cast<char*>(memory) + sizeof(Header);
+	mappedSize = size;
+	return true;
+}
+
+void SharedMemoryRingBuffer::close() {
+	if (header == 0) {
+		return;
+	}
+	bool unlink = false;
+	if (producer) {
+		__sync_synchronize();
+		unlink = (header->closed == 0); // otherwise the name belongs to the producer that has taken over
+		header->closed = 1;
+		__sync_synchronize();
+	}
+	munmap(header, mappedSize);
+	if (unlink) {
+		shm_unlink(name.c_str());
+	}
+	header = 0;
+	buffer = 0;
+	mappedSize = 0;
+	producer = false;
+	name = "";
+}
+
+bool SharedMemoryRingBuffer::isClosed() const {
+	if (header == 0) {
+		return true;
+	}
+	__sync_synchronize();
+	return header->closed != 0;
+}
+
+size_t SharedMemoryRingBuffer::getCapacity() const {
+	if (header == 0) {
+		return 0;
+	}
+	return static_cast<size_t>(header->capacity);
+}
+
+size_t SharedMemoryRingBuffer::getMaxMessageSize() const {
+	return getCapacity() / 2 - 8;
+}
+
+bool SharedMemoryRingBuffer::push(const char* data, size_t length) {
+	if (!producer || length > getMaxMessageSize()) {
+		return false;
+	}
+
+	const boost::uint64_t capacity = header->capacity;
+	const boost::uint64_t position = header->writePosition; // only written by this process
+	const boost::uint64_t offset = position % capacity;
+	const boost::uint64_t size = recordSize(length);
+	boost::uint64_t start = position;
+	if (capacity - offset < size) { // does not fit before the end of the buffer
+		start += capacity - offset;
+	}
+
+	/* Announce the region that is going to be overwritten before touching it */
+	storePosition(header->writeIntent, start + size);
+	__sync_synchronize();
+
+	if (start != position) {
+		std::memcpy(buffer + offset, &wrapMarker, sizeof(wrapMarker));
+	}
+	char* record = buffer + (start % capacity);
+	boost::uint32_t recordLength = static_cast<boost::uint32_t>(length);
+	boost::uint32_t sequenceNumber = header->nextSequenceNumber;
+	std::memcpy(record, &recordLength, sizeof(recordLength));
+	std::memcpy(record + 4, &sequenceNumber, sizeof(sequenceNumber));
+	std::memcpy(record + 8, data, length);
+
+	/* Publish */
+	header->nextSequenceNumber = sequenceNumber + 1;
+	storePosition(header->writePosition, start + size);
+	return true;
+}
+
+boost::uint32_t SharedMemoryRingBuffer::getPushedMessageCount() const {
+	if (header == 0) {
+		return 0;
+	}
+	return header->nextSequenceNumber;
+}
+
+boost::uint64_t SharedMemoryRingBuffer::getWritePosition() const {
+	if (header == 0) {
+		return 0;
+	}
+	return loadPosition(header->writePosition);
+}
+
+SharedMemoryRingBuffer::ReadResult SharedMemoryRingBuffer::peek(boost::uint64_t& cursor, const char*& data, boost::uint32_t& length, boost::uint32_t& sequenceNumber) const {
+	if (header == 0) {
+		return NO_MESSAGE;
+	}
+	const boost::uint64_t capacity = header->capacity;
+
+	while (true) {
+		boost::uint64_t published = loadPosition(header->writePosition);
+		if (cursor == published) {
+			return NO_MESSAGE;
+		}
+		if (cursor > published || !isValid(cursor)) {
+			cursor = published;
+			return LAPPED;
+		}
+
+		const boost::uint64_t offset = cursor % capacity;
+		const char* record = buffer + offset;
+		std::memcpy(&length, record, sizeof(length));
+		std::memcpy(&sequenceNumber, record + 4, sizeof(sequenceNumber));
+
+		/* The header might have been overwritten while it was read */
+		if (!isValid(cursor) || (length != wrapMarker && length > capacity / 2)) {
+			cursor = loadPosition(header->writePosition);
+			return LAPPED;
+		}
+
+		if (length == wrapMarker) {
+			cursor += capacity - offset;
+			continue;
+		}
+
+		data = record + 8;
+		return MESSAGE;
+	}
+}
+
+bool SharedMemoryRingBuffer::isValid(boost::uint64_t cursor) const {
+	if (header == 0) {
+		return false;
+	}
+	__sync_synchronize();
+	boost::uint64_t intent = loadPosition(header->writeIntent);
+	return intent - cursor <= header->capacity;
+}
+
+void SharedMemoryRingBuffer::advance(boost::uint64_t& cursor, boost::uint32_t length) const {
+	cursor += recordSize(length);
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
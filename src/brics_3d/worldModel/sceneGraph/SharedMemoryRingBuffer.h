@@ -0,0 +1,171 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#ifndef RSG_SHAREDMEMORYRINGBUFFER_H_
+#define RSG_SHAREDMEMORYRINGBUFFER_H_
+
+#include <string>
+#include <boost/cstdint.hpp>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief Lock-free single producer/multi consumer ring buffer for messages in POSIX shared memory.
+ * @ingroup sceneGraph
+ *
+ * The producer process create()s a named shared memory segment, any number of consumer
+ * processes open() it read only. Every message is stored as a record
+ *
+ * @code
+ * [uint32 length][uint32 sequence number] payload, padded to a multiple of 8 bytes
+ * @endcode
+ *
+ * Records never wrap around the end of the buffer, a wrap marker is stored instead.
+ * Read and write positions are monotonically increasing byte counters; the location in
+ * the buffer is the position modulo the capacity.
+ *
+ * The producer never blocks and never waits for consumers. Like a broadcast it overwrites
+ * the oldest messages, and every consumer has its own read cursor. Before a record is
+ * written the producer announces the end of the record in writeIntent, after the record
+ * is complete it publishes it by advancing writePosition. A consumer that reads a record
+ * checks afterwards that the producer has not announced to overwrite it in the meantime
+ * (isValid()). If it was too slow (lapped) it skips to the newest message; the gap in the
+ * sequence numbers tells how many messages have been lost.
+ *
+ * Consumers get a pointer into the shared memory (zero-copy). It stays valid until the
+ * producer has written capacity bytes more, so process messages quickly or copy them.
+ *
+ * @note Positions are 64 bit values that are accessed with full memory barriers. This
+ * requires a platform with atomic aligned 64 bit loads and stores, e.g. x86_64 or AArch64.
+ */
+class SharedMemoryRingBuffer {
+public:
+
+	/// Result of a read attempt of a consumer.
+	enum ReadResult {
+		NO_MESSAGE,      ///< The consumer has read all published messages.
+		MESSAGE,         ///< A message is available.
+		LAPPED           ///< The producer has overwritten unread messages. The cursor has been moved to the write position.
+	};
+
+	SharedMemoryRingBuffer();
+	virtual ~SharedMemoryRingBuffer();
+
+	/**
+	 * @brief Create a shared memory segment as producer.
+	 *
+	 * A segment of the same name that has been left behind by a terminated producer is replaced.
+	 * Consumers that are still connected to it notice this with isClosed().
+	 *
+	 * @param name Name of the segment as for shm_open(), e.g. "/brics_3d_wm".
+	 * @param capacity Size of the message area in bytes. It is rounded up to a multiple of 8.
+	 * @param takeOver Also replace the segment of a producer that is still running. Otherwise creation fails in that case.
+	 * @param permissions Access permissions of the segment. Only the owner can read and write by default.
+	 * @return True on success.
+	 */
+	bool create(std::string name, size_t capacity, bool takeOver = false, unsigned int permissions = 0600);
+
+	/**
+	 * @brief Open an existing shared memory segment as consumer.
+	 * @return False if the segment does not exist (yet) or has no valid layout.
+	 */
+	bool open(std::string name);
+
+	/// Unmap the segment. The producer also marks it as closed and removes its name, existing mappings of consumers stay valid.
+	void close();
+
+	/**
+	 * @brief True if the producer has closed the segment or if it has been replaced by a new producer.
+	 * A consumer should read the remaining messages and open() the name again to follow a restarted producer.
+	 */
+	bool isClosed() const;
+
+	bool isOpen() const {
+		return header != 0;
+	}
+
+	bool isProducer() const {
+		return producer;
+	}
+
+	size_t getCapacity() const;
+
+	/// Largest message that can be pushed. It is half of the capacity minus the record header.
+	size_t getMaxMessageSize() const;
+
+	/* Producer */
+
+	/**
+	 * @brief Append a message. Never blocks.
+	 * @return False if this is not a producer or if the message is too large.
+	 */
+	bool push(const char* data, size_t length);
+
+	/// Number of messages that have been pushed so far. This is the sequence number of the next message.
+	boost::uint32_t getPushedMessageCount() const;
+
+	/* Consumer */
+
+	/// Position of the next message that will be published. A consumer that starts at this cursor receives only new messages.
+	boost::uint64_t getWritePosition() const;
+
+	/**
+	 * @brief Get the message at the cursor of a consumer.
+	 * @param[in,out] cursor Read position of the consumer. It skips wrap markers and is moved to the write position if LAPPED.
+	 * @param[out] data Pointer to the payload within the shared memory.
+	 * @param[out] length Length of the payload.
+	 * @param[out] sequenceNumber Sequence number of the message.
+	 * @return MESSAGE if data is set. It stays valid as long as isValid(cursor) holds; advance()
+	 * the cursor after processing.
+	 */
+	ReadResult peek(boost::uint64_t& cursor, const char*& data, boost::uint32_t& length, boost::uint32_t& sequenceNumber) const;
+
+	/// True if the record at cursor has not been (partially) overwritten by the producer.
+	bool isValid(boost::uint64_t cursor) const;
+
+	/// Move the cursor behind the message of a previous peek().
+	void advance(boost::uint64_t& cursor, boost::uint32_t length) const;
+
+private:
+
+	struct Header;
+
+	static size_t recordSize(size_t length) {
+		return 8 + ((length + 7) & ~static_cast<size_t>(7));
+	}
+
+	/// Unlink an existing segment of name unless its producer is still running and takeOver is false.
+	static bool removeStaleSegment(std::string name, bool takeOver);
+
+	bool map(int fileDescriptor, size_t size, bool writable);
+
+	std::string name;
+	bool producer;
+	Header* header;
+	char* buffer;
+	size_t mappedSize;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_SHAREDMEMORYRINGBUFFER_H_ */
+
+/* EOF */
@@ -72,6 +72,10 @@ bool SimpleIdGenerator::removeIdFromPool(Id id) {
 	return true;
 }
 
+bool SimpleIdGenerator::isIdInPool(Id id) {
+	return std::find(idPool.begin(), idPool.end(), id) == idPool.end();
+}
+
 } // namespace brics_3d::RSG
 
 } // namespace brics_3d
@@ -41,6 +41,7 @@ public:
 	Id getNextValidId();
 	Id getRootId();
     bool removeIdFromPool(Id id);
+    bool isIdInPool(Id id);
 
 private:
 	Id rootId;
@@ -157,19 +157,8 @@ unsigned int Transform::getUpdateCount() {
     return updateCount;
 }
 
-void Transform::accept(INodeVisitor* visitor){
+void Transform::acceptWithoutTraversal(INodeVisitor* visitor) {
 	visitor->visit(this);
-	if (visitor->getDirection() == INodeVisitor::upwards) { //TODO move to "traverseUpwards" method?
-	    for(unsigned i = 0; i < getNumberOfParents(); ++i) // recursively go up the graph structure
-	    {
-	        getParent(i)->accept(visitor);
-	    }
-	} else if (visitor->getDirection() == INodeVisitor::downwards) { //TODO move to "traverseDownwards" method?
-		for(unsigned i = 0; i < getNumberOfChildren(); ++i) // recursively go down the graph structure
-		{
-			getChild(i)->accept(visitor);
-		}
-	}
 }
 
 TemporalCache<IHomogeneousMatrix44::IHomogeneousMatrix44Ptr> Transform::getHistory() {
@@ -91,7 +91,8 @@ class Transform : public Group {
 
     /**
      * @brief Add a new transform to the history.
-     * @param newTransform The transform to be added.
+     * @param newTransform The transform to be added. The pointer is stored as it is, so it is only pooled
+     *                     if it has been created with SceneGraphAllocator::createTransformMatrix().
      * @param timeStamp The times stamp that is associated with the transform.
      * @return False if an entry with this time stamp already exists. In this case data will not be inserted.
 	 *         Otherwise true.
@@ -153,7 +154,7 @@ class Transform : public Group {
     unsigned int getUpdateCount();
 
 
-    void accept(INodeVisitor* visitor);
+    void acceptWithoutTraversal(INodeVisitor* visitor);
 
     /**
      * @brief Delete all data from the history/cache that is older than the latestTimeStamp minus the duration of maxHistoryDuration.
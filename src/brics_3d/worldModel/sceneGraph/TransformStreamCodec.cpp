@@ -0,0 +1,223 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#include "TransformStreamCodec.h"
+#include "brics_3d/core/HomogeneousMatrix44.h"
+#include "brics_3d/core/Logger.h"
+#include <cmath>
+#include <cstring>
+
+namespace brics_3d {
+namespace rsg {
+
+void TransformStreamState::setKeyframe(const TransformStreamSample& sample) {
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr matrix(new HomogeneousMatrix44());
+	memcpy(matrix->setRawData(), sample.matrixData, sizeof(double) * 16);
+	HomogeneousMatrix44::matrixToQuaternion(matrix, translation[0], translation[1], translation[2],
+			quaternion[0], quaternion[1], quaternion[2], quaternion[3]);
+	timeStamp = sample.timeStamp;
+	sequence = sample.sequence;
+	samplesSinceKeyframe = 0;
+}
+
+void TransformStreamState::applyDelta(const TransformStreamSample& sample) {
+	double norm = 0;
+	for (int i = 0; i < 4; ++i) {
+		quaternion[i] += static_cast<double>(sample.delta[i]);
+		norm += quaternion[i] * quaternion[i];
+	}
+	norm = sqrt(norm);
+	for (int i = 0; i < 4; ++i) {
+		quaternion[i] /= norm;
+	}
+	for (int i = 0; i < 3; ++i) {
+		translation[i] += static_cast<double>(sample.delta[4 + i]);
+	}
+	timeStamp += static_cast<double>(sample.delta[7]);
+	sequence = sample.sequence;
+	samplesSinceKeyframe++;
+}
+
+void TransformStreamState::toMatrix(double* matrixData) const {
+	const double qx = quaternion[0];
+	const double qy = quaternion[1];
+	const double qz = quaternion[2];
+	const double qw = quaternion[3];
+
+	// same convention as HomogeneousMatrix44::quaternionToMatrix, without the need for a matrix object
+	matrixData[matrixEntry::r11] = 1 - 2*(qy*qy + qz*qz);
+	matrixData[matrixEntry::r12] = 2  *  (qx*qy - qw*qz);
+	matrixData[matrixEntry::r13] = 2  *  (qx*qz + qw*qy);
+	matrixData[matrixEntry::r21] = 2  *  (qx*qy + qw*qz);
+	matrixData[matrixEntry::r22] = 1 - 2*(qx*qx + qz*qz);
+	matrixData[matrixEntry::r23] = 2  *  (qy*qz - qw*qx);
+	matrixData[matrixEntry::r31] = 2  *  (qx*qz - qw*qy);
+	matrixData[matrixEntry::r32] = 2  *  (qy*qz + qw*qx);
+	matrixData[matrixEntry::r33] = 1 - 2*(qx*qx + qy*qy);
+
+	matrixData[matrixEntry::x] = translation[0];
+	matrixData[matrixEntry::y] = translation[1];
+	matrixData[matrixEntry::z] = translation[2];
+
+	matrixData[3] = 0;
+	matrixData[7] = 0;
+	matrixData[11] = 0;
+	matrixData[15] = 1;
+}
+
+TransformStreamEncoder::TransformStreamEncoder() {
+
+}
+
+TransformStreamEncoder::TransformStreamEncoder(const Options& options) : options(options) {
+
+}
+
+TransformStreamEncoder::~TransformStreamEncoder() {
+
+}
+
+bool TransformStreamEncoder::encode(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp, TransformStreamSample& sample) {
+	const double* matrixData = transform->getRawData();
+	double stamp = timeStamp.getSeconds();
+
+	boost::unordered_map<Id, TransformStreamState>::iterator stream = streams.find(id);
+	bool isNewStream = (stream == streams.end());
+	if (isNewStream) {
+		stream = streams.insert(std::make_pair(id, TransformStreamState())).first;
+	}
+	TransformStreamState& state = stream->second;
+
+	if (!isNewStream && options.keyframeInterval > 1 && state.samplesSinceKeyframe + 1 < options.keyframeInterval &&
+			matrixData[3] == 0 && matrixData[7] == 0 && matrixData[11] == 0 && matrixData[15] == 1) {
+
+		double quaternion[4];
+		double translation[3];
+		HomogeneousMatrix44::matrixToQuaternion(transform, translation[0], translation[1], translation[2],
+				quaternion[0], quaternion[1], quaternion[2], quaternion[3]);
+
+		/* q and -q are the same rotation; take the one closer to the previous sample */
+		double dot = 0;
+		for (int i = 0; i < 4; ++i) {
+			dot += quaternion[i] * state.quaternion[i];
+		}
+		double sign = (dot < 0) ? -1.0 : 1.0;
+
+		for (int i = 0; i < 4; ++i) {
+			sample.delta[i] = static_cast<float>(sign * quaternion[i] - state.quaternion[i]);
+		}
+		for (int i = 0; i < 3; ++i) {
+			sample.delta[4 + i] = static_cast<float>(translation[i] - state.translation[i]);
+		}
+		sample.delta[7] = static_cast<float>(stamp - state.timeStamp);
+		sample.sequence = state.sequence + 1;
+		sample.isKeyframe = false;
+
+		/* check what the decoder will reconstruct */
+		TransformStreamState reconstructedState = state;
+		reconstructedState.applyDelta(sample);
+		double reconstructed[16];
+		reconstructedState.toMatrix(reconstructed);
+
+		static const int rotationEntries[] = {matrixEntry::r11, matrixEntry::r12, matrixEntry::r13,
+				matrixEntry::r21, matrixEntry::r22, matrixEntry::r23,
+				matrixEntry::r31, matrixEntry::r32, matrixEntry::r33};
+		bool isWithinBounds = fabs(reconstructedState.timeStamp - stamp) <= options.maxTimeStampError;
+		for (int i = 0; i < 9 && isWithinBounds; ++i) {
+			isWithinBounds = fabs(reconstructed[rotationEntries[i]] - matrixData[rotationEntries[i]]) <= options.maxRotationError;
+		}
+		for (int i = matrixEntry::x; i <= matrixEntry::z && isWithinBounds; ++i) {
+			isWithinBounds = fabs(reconstructed[i] - matrixData[i]) <= options.maxTranslationError;
+		}
+
+		if (isWithinBounds) {
+			state = reconstructedState;
+			return true;
+		}
+		LOG(DEBUG) << "TransformStreamEncoder: delta for " << id.toString() << " exceeds the error bounds. Sending a keyframe instead.";
+	}
+
+	/* keyframe */
+	sample.isKeyframe = true;
+	sample.sequence = isNewStream ? 0 : state.sequence + 1;
+	memcpy(sample.matrixData, matrixData, sizeof(double) * 16);
+	sample.timeStamp = stamp;
+	state.setKeyframe(sample);
+
+	return true;
+}
+
+void TransformStreamEncoder::reset(Id id) {
+	streams.erase(id);
+}
+
+void TransformStreamEncoder::reset() {
+	streams.clear();
+}
+
+TransformStreamDecoder::TransformStreamDecoder() {
+
+}
+
+TransformStreamDecoder::~TransformStreamDecoder() {
+
+}
+
+bool TransformStreamDecoder::decode(Id id, const TransformStreamSample& sample, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr& transform, TimeStamp& timeStamp) {
+
+	if (sample.isKeyframe) {
+		streams[id].setKeyframe(sample);
+		memcpy(transform->setRawData(), sample.matrixData, sizeof(double) * 16);
+		timeStamp = TimeStamp(sample.timeStamp, Units::Second);
+		return true;
+	}
+
+	boost::unordered_map<Id, TransformStreamState>::iterator stream = streams.find(id);
+	if (stream == streams.end()) {
+		LOG(WARNING) << "TransformStreamDecoder: Received a delta for " << id.toString() << " without a preceding keyframe. Waiting for the next keyframe.";
+		return false;
+	}
+
+	TransformStreamState& state = stream->second;
+	if (sample.sequence != state.sequence + 1) {
+		LOG(WARNING) << "TransformStreamDecoder: Lost " << (sample.sequence - state.sequence - 1) << " sample(s) of " << id.toString() << ". Waiting for the next keyframe.";
+		streams.erase(stream);
+		return false;
+	}
+
+	state.applyDelta(sample);
+	state.toMatrix(transform->setRawData());
+	timeStamp = TimeStamp(state.timeStamp, Units::Second);
+
+	return true;
+}
+
+void TransformStreamDecoder::reset(Id id) {
+	streams.erase(id);
+}
+
+void TransformStreamDecoder::reset() {
+	streams.clear();
+}
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+/* EOF */
@@ -0,0 +1,169 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+
+#ifndef RSG_TRANSFORMSTREAMCODEC_H_
+#define RSG_TRANSFORMSTREAMCODEC_H_
+
+#include "brics_3d/core/IHomogeneousMatrix44.h"
+#include "brics_3d/worldModel/sceneGraph/Id.h"
+#include "brics_3d/worldModel/sceneGraph/TimeStamp.h"
+#include <boost/unordered_map.hpp>
+#include <boost/cstdint.hpp>
+
+namespace brics_3d {
+namespace rsg {
+
+/**
+ * @brief One encoded sample of the transform stream of a single Transform node.
+ *
+ * A keyframe carries the full matrix and time stamp with double precision. A delta
+ * sample only carries the difference of the rotation (as quaternion) and the translation
+ * to the previous sample of the same stream as single precision values.
+ */
+struct TransformStreamSample {
+
+	static const unsigned int deltaElements = 8;
+
+	/// Position of the sample in the stream of its node. Used to detect lost samples.
+	boost::uint32_t sequence;
+
+	bool isKeyframe;
+
+	/* keyframe */
+	double matrixData[16];
+	double timeStamp; ///< in seconds
+
+	/* delta */
+	float delta[deltaElements]; ///< qx, qy, qz, qw, x, y, z and time stamp in seconds, each relative to the previous sample
+
+	TransformStreamSample() : sequence(0), isKeyframe(true), timeStamp(0) {};
+};
+
+/**
+ * @brief Reconstructed state of one transform stream. Identical on encoder and decoder side.
+ */
+struct TransformStreamState {
+	boost::uint32_t sequence;
+	unsigned int samplesSinceKeyframe;
+	double quaternion[4]; ///< qx, qy, qz, qw
+	double translation[3];
+	double timeStamp;
+
+	/// Initialize from a keyframe.
+	void setKeyframe(const TransformStreamSample& sample);
+
+	/// Advance by a delta sample.
+	void applyDelta(const TransformStreamSample& sample);
+
+	/// Write the reconstructed transform.
+	void toMatrix(double* matrixData) const;
+};
+
+/**
+ * @brief Per node encoder for the setTransform updates of a serializer.
+ * @ingroup sceneGraph
+ *
+ * Consecutive transforms of the same node are usually similar. Instead of the 16 double values
+ * and the time stamp only a single precision delta of quaternion, translation and time stamp
+ * is sent. Every keyframeInterval samples, for the first sample of a node and whenever a delta
+ * would exceed the error bounds, a keyframe with the full double precision data is sent.
+ *
+ * The encoder tracks the state as it will be reconstructed by the TransformStreamDecoder,
+ * so single precision rounding errors do not accumulate: every decoded transform is
+ * within the error bounds and keyframes are reconstructed exactly. Transforms that are
+ * not a rotation plus translation (e.g. scaling) always end up as keyframes.
+ *
+ * As the streams depend on previous samples, the decoder rejects delta samples after
+ * a lost sample until the next keyframe arrives.
+ */
+class TransformStreamEncoder {
+public:
+
+	struct Options {
+		/// A keyframe is sent after this number of samples of the same node. 1 disables delta encoding.
+		unsigned int keyframeInterval;
+		/// Maximum difference of a translation entry in the reconstructed matrix. Default is 1e-4 (0.1 mm).
+		double maxTranslationError;
+		/// Maximum difference of a rotation entry in the reconstructed matrix. Default is 1e-5 (approximately rad).
+		double maxRotationError;
+		/// Maximum difference of the reconstructed time stamp in seconds. Default is 1e-6.
+		double maxTimeStampError;
+
+		Options() : keyframeInterval(50), maxTranslationError(1e-4), maxRotationError(1e-5), maxTimeStampError(1e-6) {};
+	};
+
+	TransformStreamEncoder();
+	TransformStreamEncoder(const Options& options);
+	virtual ~TransformStreamEncoder();
+
+	/// Encode the next transform of the stream of node id.
+	bool encode(Id id, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform, TimeStamp timeStamp, TransformStreamSample& sample);
+
+	/// Forget the stream of a node, e.g. after it has been deleted. The next sample will be a keyframe.
+	void reset(Id id);
+
+	/// Forget all streams.
+	void reset();
+
+	const Options& getOptions() const {
+		return options;
+	}
+
+	void setOptions(const Options& options) {
+		this->options = options;
+	}
+
+private:
+	Options options;
+	boost::unordered_map<Id, TransformStreamState> streams;
+};
+
+/**
+ * @brief Counterpart of the TransformStreamEncoder on the receiving side.
+ * @ingroup sceneGraph
+ */
+class TransformStreamDecoder {
+public:
+	TransformStreamDecoder();
+	virtual ~TransformStreamDecoder();
+
+	/**
+	 * @brief Reconstruct the transform of a sample.
+	 * @return False for a delta sample without the preceding sample, i.e. after a lost sample
+	 *         or if the keyframe of the stream has not been received.
+	 */
+	bool decode(Id id, const TransformStreamSample& sample, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr& transform, TimeStamp& timeStamp);
+
+	/// Forget the stream of a node.
+	void reset(Id id);
+
+	/// Forget all streams.
+	void reset();
+
+private:
+	boost::unordered_map<Id, TransformStreamState> streams;
+};
+
+} /* namespace rsg */
+} /* namespace brics_3d */
+
+#endif /* RSG_TRANSFORMSTREAMCODEC_H_ */
+
+/* EOF */
@@ -200,6 +200,17 @@ bool UpdatesToSceneGraphListener::removeParent(Id id, Id parentId) {
 	return success;
 }
 
+bool UpdatesToSceneGraphListener::applyUpdateBatch(const SceneGraphUpdateBatch& batch) {
+	bool success = true;
+
+	/* Call _all_ observers  */
+	std::vector<ISceneGraphUpdate*>::iterator observerIterator;
+	for (observerIterator = updateObservers.begin(); observerIterator != updateObservers.end(); ++observerIterator) {
+		success &= (*observerIterator)->applyUpdateBatch(batch);
+	}
+	return success;
+}
+
 bool UpdatesToSceneGraphListener::attachSceneGraph(
 		ISceneGraphUpdate* observer) {
 	assert(observer != 0);
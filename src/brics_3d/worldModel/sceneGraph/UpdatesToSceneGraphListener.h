@@ -22,6 +22,7 @@
 
 #include <brics_3d/worldModel/sceneGraph/ISceneGraphUpdateObserver.h>
 #include <brics_3d/worldModel/sceneGraph/Attribute.h>
+#include <brics_3d/worldModel/sceneGraph/SceneGraphUpdateBatch.h>
 #include <brics_3d/util/Timer.h>
 
 namespace brics_3d {
@@ -47,6 +48,13 @@ public:
 	bool addParent(Id id, Id parentId);
     bool removeParent(Id id, Id parentId);
 
+    /**
+     * @brief Forwards the complete batch to all attached scene graphs.
+     * Note, a batch always takes over the recorded IDs regardless of the forcedIdPolicy,
+     * as updates within a batch refer to each other by these IDs.
+     */
+    bool applyUpdateBatch(const SceneGraphUpdateBatch& batch);
+
     bool attachSceneGraph(ISceneGraphUpdate* observer);
     bool detachSceneGraph(ISceneGraphUpdate* observer);
 
@@ -20,10 +20,62 @@
 #include "Uuid.h"
 #include "brics_3d/core/Logger.h"
 #include <sstream>
+#include <cstring>
 
 namespace brics_3d {
 namespace rsg {
 
+/*
+ * Helpers for word-wise processing of the 16 bytes. The loads are done via
+ * memcpy to avoid unaligned access and strict aliasing issues; compilers
+ * translate them to single load instructions.
+ */
+namespace {
+
+inline uint64_t loadWord(const uint8_t* bytes) {
+	uint64_t word;
+	memcpy(&word, bytes, sizeof(word));
+	return word;
+}
+
+/// Interprets 8 bytes in network byte order (MSB first), such that integer comparison equals lexicographical comparison.
+inline uint64_t loadBigEndianWord(const uint8_t* bytes) {
+	return (static_cast<uint64_t>(bytes[0]) << 56) |
+		   (static_cast<uint64_t>(bytes[1]) << 48) |
+		   (static_cast<uint64_t>(bytes[2]) << 40) |
+		   (static_cast<uint64_t>(bytes[3]) << 32) |
+		   (static_cast<uint64_t>(bytes[4]) << 24) |
+		   (static_cast<uint64_t>(bytes[5]) << 16) |
+		   (static_cast<uint64_t>(bytes[6]) << 8)  |
+		   (static_cast<uint64_t>(bytes[7]));
+}
+
+const char hexDigits[] = "0123456789abcdef";
+
+/// Position of each byte in the hhhhhhhh-hhhh-hhhh-hhhh-hhhhhhhhhhhh string.
+const uint8_t stringOffsets[16] = {0, 2, 4, 6, 9, 11, 14, 16, 19, 21, 24, 26, 28, 30, 32, 34};
+
+/// Maps a character to its nibble value. Invalid characters are mapped to 0x10.
+struct HexDecodingTable {
+	uint8_t values[256];
+	HexDecodingTable() {
+		for (int i = 0; i < 256; ++i) {
+			values[i] = 0x10;
+		}
+		for (uint8_t i = 0; i < 10; ++i) {
+			values['0' + i] = i;
+		}
+		for (uint8_t i = 0; i < 6; ++i) {
+			values['a' + i] = 10 + i;
+			values['A' + i] = 10 + i;
+		}
+	}
+};
+
+const HexDecodingTable hexDecodingTable;
+
+}
+
 Uuid::Uuid() {
 	this->setToNil();
 }
@@ -45,12 +97,12 @@ Uuid::Uuid(unsigned int id) {
 }
 
 Uuid& Uuid::operator =(Uuid& other) {
-	std::copy(other.begin(), other.end(), this->begin());
+	memcpy(data, other.data, arraySize);
 	return *this;
 }
 
 Uuid& Uuid::operator =(const Uuid& other) {
-	std::copy(other.begin(), other.end(), this->begin());
+	memcpy(data, other.data, arraySize);
 	return *this;
 }
 
@@ -64,7 +116,7 @@ Uuid& Uuid::operator =(unsigned int other) {
 }
 
 bool Uuid::operator ==(const Uuid& other) const {
-	return std::equal(this->begin(), this->end(), other.begin());
+	return ((loadWord(data) ^ loadWord(other.data)) | (loadWord(data + 8) ^ loadWord(other.data + 8))) == 0;
 }
 
 bool Uuid::operator !=(const Uuid& other) const {
@@ -72,8 +124,12 @@ bool Uuid::operator !=(const Uuid& other) const {
 }
 
 bool Uuid::operator <(const Uuid& other) const {
-	return std::lexicographical_compare(this->begin(), this->end(),
-			other.begin(), other.end());
+	uint64_t high = loadBigEndianWord(data);
+	uint64_t otherHigh = loadBigEndianWord(other.data);
+	if (high != otherHigh) {
+		return high < otherHigh;
+	}
+	return loadBigEndianWord(data + 8) < loadBigEndianWord(other.data + 8);
 }
 
 bool Uuid::operator >(const Uuid& other) const {
@@ -98,100 +154,67 @@ void Uuid::swap(Uuid& other) {
 }
 
 bool Uuid::isNil() const {
-	for(size_t i=0; i<this->size(); i++) {
-		if (data[i] != 0U) {
-			return false;
-		}
-	}
-	return true;
+	return (loadWord(data) | loadWord(data + 8)) == 0;
 }
 
 void Uuid::setToNil() {
-	for(size_t i=0; i<this->size(); i++) {
-		data[i] = 0U;
-	}
+	memset(data, 0, arraySize);
 }
 
-std::string Uuid::toString() const {
-	std::stringstream uuidAsSting;
-	uuidAsSting.str("");
-
-	uuidAsSting << std::hex;
-	uuidAsSting.fill(uuidAsSting.widen('0'));
+std::size_t Uuid::hash() const {
+	/* UUIDs are (mostly) random already, so a cheap mixing of both halves is sufficient. */
+	uint64_t word = loadWord(data) ^ (loadWord(data + 8) * 0x9E3779B97F4A7C15ULL);
+	word ^= word >> 32;
+	return static_cast<std::size_t>(word);
+}
 
-     std::size_t i=0;
-     for (Uuid::const_iterator i_data = this->begin(); i_data!=this->end(); ++i_data, ++i) {
-    	 uuidAsSting.width(2);
-    	 uuidAsSting << static_cast<unsigned int>(*i_data);
-         if (i == 3 || i == 5 || i == 7 || i == 9) {
-        	 uuidAsSting << uuidAsSting.widen('-');
-         }
-     }
+void Uuid::toString(char* buffer) const {
+	buffer[8] = '-';
+	buffer[13] = '-';
+	buffer[18] = '-';
+	buffer[23] = '-';
+	for (size_t i = 0; i < arraySize; ++i) {
+		buffer[stringOffsets[i]] = hexDigits[data[i] >> 4];
+		buffer[stringOffsets[i] + 1] = hexDigits[data[i] & 0x0F];
+	}
+}
 
-	return uuidAsSting.str();
+std::string Uuid::toString() const {
+	char buffer[stringSize];
+	toString(buffer);
+	return std::string(buffer, stringSize);
 }
 
 bool Uuid::fromString(std::string uuid) {
-	const size_t expectedStringSize = 36; // 32 digits and four "-" hyphens
-	std::stringstream is(uuid);
-	typedef std::ctype<char> ctype_t;
-	ctype_t const& ctype = std::use_facet<ctype_t>(is.getloc());
-
-	if(uuid.size() != expectedStringSize) {
-		LOG(ERROR) << "Failed to parse UUID. Expected string size of " << expectedStringSize << " does not match actual string size of "<< uuid.size() << ".";
+	if(uuid.size() != stringSize) {
+		LOG(ERROR) << "Failed to parse UUID. Expected string size of " << stringSize << " does not match actual string size of "<< uuid.size() << ".";
 		this->setToNil();
 		return false;
 	}
 
-	char xdigits[16];
-	{
-		char szdigits[] = "0123456789ABCDEF";
-		ctype.widen(szdigits, szdigits+16, xdigits);
+	const unsigned char* characters = reinterpret_cast<const unsigned char*>(uuid.data());
+	if (characters[8] != '-' || characters[13] != '-' || characters[18] != '-' || characters[23] != '-') {
+		LOG(ERROR) << "Failed to parse UUID " << uuid << ". Expected a '-' at the positions 8, 13, 18 and 23.";
+		this->setToNil();
+		return false;
 	}
-	char*const xdigits_end = xdigits+16;
-
-	char c;
-	for (std::size_t i=0; i<this->arraySize && is; ++i) {
-		is >> c;
-		c = ctype.toupper(c);
-
-		char* f = std::find(xdigits, xdigits_end, c);
-		if (f == xdigits_end) {
-			LOG(ERROR) << "Failed to parse UUID with character " << c << " at position "<< i << ".";
-			this->setToNil();
-			return false;
-		}
-
-		unsigned char byte = static_cast<unsigned char>(std::distance(&xdigits[0], f));
 
-		is >> c;
-		c = ctype.toupper(c);
-		f = std::find(xdigits, xdigits_end, c);
-		if (f == xdigits_end) {
-			LOG(ERROR) << "Failed to parse UUID with character " << c << " at position "<< i << ".";
-			this->setToNil();
-			return false;
-		}
-
-		byte <<= 4;
-		byte |= static_cast<unsigned char>(std::distance(&xdigits[0], f));
-
-		this->data[i] = byte;
+	/* Decode all digits first and check for invalid characters only once at the end. */
+	uint8_t invalid = 0;
+	for (size_t i = 0; i < arraySize; ++i) {
+		uint8_t high = hexDecodingTable.values[characters[stringOffsets[i]]];
+		uint8_t low = hexDecodingTable.values[characters[stringOffsets[i] + 1]];
+		invalid |= high | low;
+		data[i] = static_cast<uint8_t>((high << 4) | (low & 0x0F));
+	}
 
-		if (is) {
-			if (i == 3 || i == 5 || i == 7 || i == 9) {
-				is >> c;
-				if (c != is.widen('-')) {
-					LOG(ERROR) << "Failed to parse UUID. Expected a '-' on position " << i <<" but retrieved chracter " << c << " instead." ;
-					this->setToNil();
-					return false;
-				}
-			}
-		}
+	if (invalid & 0x10) {
+		LOG(ERROR) << "Failed to parse UUID " << uuid << ". It contains non hexadecimal characters.";
+		this->setToNil();
+		return false;
 	}
 
 	return true;
-
 }
 
 std::ostream& operator<<(std::ostream &outStream, const Uuid &id) {
@@ -222,6 +245,10 @@ unsigned int uuidToUnsignedInt (unsigned int id) {
 	return id;
 }
 
+std::size_t hash_value(const Uuid& id) {
+	return id.hash();
+}
+
 } /* namespace rsg */
 } /* namespace brics_3d */
 
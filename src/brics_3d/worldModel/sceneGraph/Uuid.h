@@ -92,12 +92,24 @@ public:
 	 */
 	void setToNil();
 
+	/**
+	 * @brief Hash value for unordered containers.
+	 * @return A hash computed from both 64 bit halves of the UUID.
+	 */
+	std::size_t hash() const;
+
 	/**
 	 * Convert a UUID into a string.
 	 * @return A string in hhhhhhhh-hhhh-hhhh-hhhh-hhhhhhhhhhhh format.
 	 */
 	std::string toString() const;
 
+	/**
+	 * Convert a UUID into a string without allocations.
+	 * @param[out] buffer Buffer of at least stringSize characters. No terminating '\0' is written.
+	 */
+	void toString(char* buffer) const;
+
 	/**
 	 * Convert a string into a UUID.
 	 * @param uuid Sting in hhhhhhhh-hhhh-hhhh-hhhh-hhhhhhhhhhhh format.
@@ -119,6 +131,9 @@ public:
 	/// Size of array is 16. 16 * 8 = 128 bits as required by RFC 4122
     const static size_t arraySize = 16;
 
+	/// Length of the string representation: 32 digits and four "-" hyphens
+    const static size_t stringSize = 36;
+
 private:
 
 	/**
@@ -188,6 +203,9 @@ extern unsigned int uuidToUnsignedInt (Uuid id);
 /// Only for backward compatibility
 extern unsigned int uuidToUnsignedInt (unsigned int id);
 
+/// Hash function as used by boost::hash, e.g. for boost::unordered_map<Uuid, T>
+extern std::size_t hash_value(const Uuid& id);
+
 } /* namespace rsg */
 } /* namespace brics_3d */
 
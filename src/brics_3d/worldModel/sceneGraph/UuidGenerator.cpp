@@ -18,6 +18,7 @@
  ******************************************************************************/
 
 #include "UuidGenerator.h"
+#include <boost/thread/tss.hpp>
 
 namespace brics_3d {
 namespace rsg {
@@ -47,7 +48,7 @@ UuidGenerator::~UuidGenerator() {
 Id UuidGenerator::getNextValidId() {
 	Uuid nextValidUuid;
 
-	boost::uuids::uuid uuid = idGenerator();
+	boost::uuids::uuid uuid = getThreadLocalGenerator()();
 	std::copy(uuid.begin(), uuid.end(), nextValidUuid.begin());
 
 	Id nextValidId;
@@ -66,12 +67,19 @@ Id UuidGenerator::getRootId() {
 
 bool UuidGenerator::removeIdFromPool(Id id) {
 	/* this is actually not necessary as duplications are _very_ unlikely */
-	std::vector<Id>::iterator lookUpResult = std::find(idPool.begin(), idPool.end(), id);
-	if (lookUpResult != idPool.end()) {
-		return false;
+	return idPool.insert(id).second;
+}
+
+bool UuidGenerator::isIdInPool(Id id) {
+	return idPool.find(id) == idPool.end();
+}
+
+UuidGenerator::ThreadLocalGenerator& UuidGenerator::getThreadLocalGenerator() {
+	static boost::thread_specific_ptr<ThreadLocalGenerator> generator;
+	if (generator.get() == 0) {
+		generator.reset(new ThreadLocalGenerator()); // seeds the PRNG from the OS entropy source
 	}
-	idPool.push_back(id);
-	return true;
+	return *generator;
 }
 
 } /* namespace rsg */
@@ -21,12 +21,20 @@
 #define RSG_UUIDGENERATOR_H_
 
 #include "IIdGenerator.h"
-#include <vector>
+#include <boost/unordered_set.hpp>
 #include <boost/uuid/uuid_generators.hpp>
+#include <boost/random/mersenne_twister.hpp>
 
 namespace brics_3d {
 namespace rsg {
 
+/**
+ * @brief Generator for random (version 4) UUIDs.
+ *
+ * The random numbers are drawn from a pseudo random number generator per thread
+ * that is seeded once from the operating system's entropy source. This avoids a
+ * system call for every generated ID. Already issued IDs are kept in a hash set.
+ */
 class UuidGenerator: public brics_3d::rsg::IIdGenerator {
 public:
 	UuidGenerator();
@@ -37,13 +45,17 @@ public:
 	Id getNextValidId();
 	Id getRootId();
     bool removeIdFromPool(Id id);
+    bool isIdInPool(Id id);
 
 protected:
 
-	Id rootId;
-	std::vector<Id> idPool;
+	typedef boost::uuids::basic_random_generator<boost::random::mt19937> ThreadLocalGenerator;
 
-	boost::uuids::random_generator idGenerator;
+	/// Get the generator of the calling thread. It is created on first use.
+	static ThreadLocalGenerator& getThreadLocalGenerator();
+
+	Id rootId;
+	boost::unordered_set<Id> idPool;
 };
 
 } /* namespace rsg */
@@ -0,0 +1,718 @@
+/******************************************************************************
+* BRICS_3D - 3D Perception and Modeling Library
+* Copyright (c) 2017, KU Leuven
+*
+* Author: Sebastian Blumenthal
+*
+*
+* This software is published under a dual-license: GNU Lesser General Public
+* License LGPL 2.1 and Modified BSD license. The dual-license implies that
+* users of this code may choose which terms they prefer.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+* GNU Lesser General Public License LGPL and the BSD license for
+* more details.
+*
+******************************************************************************/
+
+#include "BinaryTest.h"
+#include "SceneGraphNodesTest.h" // for the observer counter
+#include "brics_3d/core/Logger.h"
+#include "brics_3d/core/HomogeneousMatrix44.h"
+#include "brics_3d/core/CovarianceMatrix66.h"
+#include "brics_3d/worldModel/sceneGraph/BinaryUpdateSerializer.h"
+#include "brics_3d/worldModel/sceneGraph/BinaryUpdateDeserializer.h"
+#include "brics_3d/worldModel/sceneGraph/UuidGenerator.h"
+#include "brics_3d/worldModel/sceneGraph/FragmentingOutputPort.h"
+#include "brics_3d/worldModel/sceneGraph/ReassemblingInputPort.h"
+#include "brics_3d/worldModel/sceneGraph/SharedMemoryOutputPort.h"
+#include "brics_3d/worldModel/sceneGraph/SharedMemoryInputBridge.h"
+#include <sstream>
+
+/* UDP includes*/
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+using namespace brics_3d;
+using namespace brics_3d::rsg;
+
+namespace unitTests {
+
+// Registers the fixture into the 'registry'
+CPPUNIT_TEST_SUITE_REGISTRATION( BinaryTest );
+
+/*
+ * Feeds the data directly forward to an input port and memorizes the size of the last message.
+ */
+class BinarySimpleBridge : public brics_3d::rsg::IOutputPort {
+public:
+	BinarySimpleBridge(brics_3d::rsg::IInputPort* inputPort) :
+		inputPort(inputPort), lastMessageSize(0), messageCount(0) {
+	};
+	virtual ~BinarySimpleBridge(){};
+
+	int write(const char *dataBuffer, int dataLength, int &transferredBytes) {
+		lastMessageSize = dataLength;
+		messageCount++;
+		return inputPort->write(dataBuffer, dataLength, transferredBytes); // just feed forward
+	};
+
+	brics_3d::rsg::IInputPort* inputPort;
+	int lastMessageSize;
+	int messageCount;
+};
+
+void BinaryTest::setUp() {
+	brics_3d::Logger::setMinLoglevel(brics_3d::Logger::WARNING);
+}
+
+void BinaryTest::tearDown() {
+	brics_3d::Logger::setMinLoglevel(brics_3d::Logger::WARNING);
+}
+
+void BinaryTest::testLoopBack() {
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel();
+	brics_3d::WorldModel* wmReplica = new brics_3d::WorldModel();
+
+	BinaryUpdateDeserializer* deserializer = new BinaryUpdateDeserializer(wmReplica);
+	BinarySimpleBridge* feedForwardBridge = new BinarySimpleBridge(deserializer);
+	BinaryUpdateSerializer* serializer = new BinaryUpdateSerializer(feedForwardBridge);
+	wm->scene.attachUpdateObserver(serializer);
+
+	MyObserver remoteWmNodeCounter;
+	wmReplica->scene.attachUpdateObserver(&remoteWmNodeCounter);
+
+	vector<Attribute> dummyAttributes;
+	vector<Attribute> attributes;
+	attributes.push_back(Attribute("name","test_node"));
+	attributes.push_back(Attribute("type","test"));
+	vector<Attribute> resultAttributes;
+	vector<Id> resultIds;
+
+	/* Manually "mount" first wm relative to second one */
+	wmReplica->scene.addRemoteRootNode(wm->getRootNodeId(), dummyAttributes);
+	wmReplica->scene.addParent(wm->getRootNodeId(), wmReplica->getRootNodeId());
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addRemoteRootNodeCounter);
+
+	Id nodeId;
+	CPPUNIT_ASSERT(wm->scene.addNode(wm->getRootNodeId(), nodeId, attributes));
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addNodeCounter);
+	CPPUNIT_ASSERT(wmReplica->scene.getNodeAttributes(nodeId, resultAttributes));
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(resultAttributes.size()));
+	CPPUNIT_ASSERT(resultAttributes[0] == attributes[0]);
+	CPPUNIT_ASSERT(resultAttributes[1] == attributes[1]);
+
+	Id groupId;
+	CPPUNIT_ASSERT(wm->scene.addGroup(wm->getRootNodeId(), groupId, dummyAttributes));
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addGroupCounter);
+
+	/* Transforms are transmitted without loss of precision */
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44(0,-1,0,
+			                                                                        1,0,0,
+			                                                                        0,0,1,
+			                                                                        1.123456789,2,3));
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr resultTransform;
+	Id tfId;
+	TimeStamp stamp = wm->now();
+	CPPUNIT_ASSERT(wm->scene.addTransformNode(groupId, tfId, dummyAttributes, transform, stamp));
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addTransformCounter);
+	CPPUNIT_ASSERT(wmReplica->scene.getTransform(tfId, stamp, resultTransform));
+	for (int i = 0; i < 16; ++i) {
+		CPPUNIT_ASSERT_EQUAL(transform->getRawData()[i], resultTransform->getRawData()[i]);
+	}
+
+	/* A transform update is exactly 128 bytes long */
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform2(new HomogeneousMatrix44(1,0,0,
+			                                                                         0,1,0,
+			                                                                         0,0,1,
+			                                                                         4,5,6));
+	TimeStamp stamp2 = stamp + Duration(0.1, Units::Second);
+	CPPUNIT_ASSERT(wm->scene.setTransform(tfId, transform2, stamp2));
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.setTransformCounter);
+	CPPUNIT_ASSERT_EQUAL(128, feedForwardBridge->lastMessageSize);
+	CPPUNIT_ASSERT(wmReplica->scene.getTransform(tfId, stamp2, resultTransform));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0, resultTransform->getRawData()[13], maxTolerance);
+
+	/* Uncertain transforms */
+	ITransformUncertainty::ITransformUncertaintyPtr uncertainty(new CovarianceMatrix66(1,2,3,4,5,6));
+	ITransformUncertainty::ITransformUncertaintyPtr resultUncertainty;
+	Id uncertainTfId;
+	CPPUNIT_ASSERT(wm->scene.addUncertainTransformNode(groupId, uncertainTfId, dummyAttributes, transform, uncertainty, stamp));
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addUncertainTransformCounter);
+	CPPUNIT_ASSERT(wm->scene.setUncertainTransform(uncertainTfId, transform2, uncertainty, stamp2));
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.setUncertainTransformCounter);
+	CPPUNIT_ASSERT(wmReplica->scene.getUncertainTransform(uncertainTfId, stamp2, resultTransform, resultUncertainty));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(6.0, resultTransform->getRawData()[14], maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, resultUncertainty->getRawData()[2 * 6 + 2], maxTolerance);
+
+	/* Geometries */
+	Box::BoxPtr box(new Box(1,2,3));
+	Shape::ShapePtr resultShape;
+	TimeStamp resultTime;
+	Id boxId;
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(tfId, boxId, dummyAttributes, box, stamp));
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addGeometricNodeCounter);
+	CPPUNIT_ASSERT(wmReplica->scene.getGeometry(boxId, resultShape, resultTime));
+	Box::BoxPtr resultBox = boost::dynamic_pointer_cast<Box>(resultShape);
+	CPPUNIT_ASSERT(resultBox != 0);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, resultBox->getSizeZ(), maxTolerance);
+	CPPUNIT_ASSERT(resultTime == stamp);
+
+	brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr pointCloudContainer(new brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>());
+	pointCloudContainer->data = brics_3d::PointCloud3D::PointCloud3DPtr(new brics_3d::PointCloud3D());
+	pointCloudContainer->data->addPoint(Point3D(1,2,3));
+	pointCloudContainer->data->addPoint(Point3D(4,5,6));
+	Id pointCloudId;
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(tfId, pointCloudId, dummyAttributes, pointCloudContainer, stamp));
+	CPPUNIT_ASSERT_EQUAL(2, remoteWmNodeCounter.addGeometricNodeCounter);
+	CPPUNIT_ASSERT(wmReplica->scene.getGeometry(pointCloudId, resultShape, resultTime));
+	brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr resultPointCloud = boost::dynamic_pointer_cast<brics_3d::rsg::PointCloud<brics_3d::PointCloud3D> >(resultShape);
+	CPPUNIT_ASSERT(resultPointCloud != 0);
+	CPPUNIT_ASSERT_EQUAL(2u, resultPointCloud->data->getSize());
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0, (*resultPointCloud->data->getPointCloud())[1].getY(), maxTolerance);
+
+	/* Connections */
+	Id connectionId;
+	vector<Id> sourceIds;
+	sourceIds.push_back(nodeId);
+	vector<Id> targetIds;
+	targetIds.push_back(tfId);
+	targetIds.push_back(boxId);
+	CPPUNIT_ASSERT(wm->scene.addConnection(groupId, connectionId, dummyAttributes, sourceIds, targetIds, stamp, stamp2));
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addConnectionCounter);
+	CPPUNIT_ASSERT(wmReplica->scene.getConnectionTargetIds(connectionId, resultIds));
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(resultIds.size()));
+	CPPUNIT_ASSERT(resultIds[1] == boxId);
+
+	/* Structural updates */
+	CPPUNIT_ASSERT(wm->scene.setNodeAttributes(groupId, attributes));
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.setNodeAttributesCounter);
+	CPPUNIT_ASSERT(wm->scene.addParent(nodeId, groupId));
+	CPPUNIT_ASSERT_EQUAL(2, remoteWmNodeCounter.addParentCounter); // including the manual mount
+	CPPUNIT_ASSERT(wmReplica->scene.getNodeParents(nodeId, resultIds));
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(resultIds.size()));
+	CPPUNIT_ASSERT(wm->scene.removeParent(nodeId, groupId));
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.removeParentCounter);
+	CPPUNIT_ASSERT(wm->scene.deleteNode(boxId));
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.deleteNodeCounter);
+	CPPUNIT_ASSERT(!wmReplica->scene.getGeometry(boxId, resultShape, resultTime));
+
+	delete serializer;
+	delete feedForwardBridge;
+	delete deserializer;
+	delete wmReplica;
+	delete wm;
+}
+
+void BinaryTest::testUpdateBatch() {
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel();
+	brics_3d::WorldModel* wmReplica = new brics_3d::WorldModel();
+
+	BinaryUpdateDeserializer* deserializer = new BinaryUpdateDeserializer(wmReplica);
+	BinarySimpleBridge* feedForwardBridge = new BinarySimpleBridge(deserializer);
+	BinaryUpdateSerializer* serializer = new BinaryUpdateSerializer(feedForwardBridge);
+	wm->scene.attachUpdateObserver(serializer);
+
+	MyObserver remoteWmNodeCounter;
+	wmReplica->scene.attachUpdateObserver(&remoteWmNodeCounter);
+
+	vector<Attribute> dummyAttributes;
+	vector<Attribute> attributes;
+	attributes.push_back(Attribute("name","batch_node"));
+	vector<Id> resultIds;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform123(new HomogeneousMatrix44(1,0,0,
+	                                                             0,1,0,
+	                                                             0,0,1,
+	                                                             1,2,3));
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr resultTransform;
+
+	wmReplica->scene.addRemoteRootNode(wm->getRootNodeId(), dummyAttributes);
+	wmReplica->scene.addParent(wm->getRootNodeId(), wmReplica->getRootNodeId());
+
+	rsg::SceneGraphUpdateBatch batch;
+	Id groupId;
+	Id tfId;
+	Id geodeId;
+	Sphere::SpherePtr sphere(new Sphere(0.5));
+	CPPUNIT_ASSERT(batch.addGroup(wm->getRootNodeId(), groupId, attributes));
+	CPPUNIT_ASSERT(batch.addTransformNode(groupId, tfId, attributes, transform123, wm->now()));
+	CPPUNIT_ASSERT(batch.addGeometricNode(tfId, geodeId, attributes, sphere, wm->now()));
+
+	int messagesBefore = feedForwardBridge->messageCount;
+	CPPUNIT_ASSERT(wm->scene.applyUpdateBatch(batch));
+	CPPUNIT_ASSERT_EQUAL(messagesBefore + 1, feedForwardBridge->messageCount); // a single message has been sent
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.applyUpdateBatchCounter);
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addGroupCounter);
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addTransformCounter);
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addGeometricNodeCounter);
+
+	CPPUNIT_ASSERT(wmReplica->scene.getNodes(attributes, resultIds));
+	CPPUNIT_ASSERT_EQUAL(3u, static_cast<unsigned int>(resultIds.size()));
+	CPPUNIT_ASSERT(wmReplica->scene.getTransform(tfId, wm->now(), resultTransform));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(2.0, resultTransform->getRawData()[13], maxTolerance);
+
+	delete serializer;
+	delete feedForwardBridge;
+	delete deserializer;
+	delete wmReplica;
+	delete wm;
+}
+
+/*
+ * Serializes into a buffer and feeds (partially) corrupted copies to a deserializer.
+ */
+class BinaryRecorder : public brics_3d::rsg::IOutputPort {
+public:
+	int write(const char *dataBuffer, int dataLength, int &transferredBytes) {
+		data.insert(data.end(), dataBuffer, dataBuffer + dataLength);
+		transferredBytes = dataLength;
+		return 1;
+	};
+	std::vector<char> data;
+};
+
+void BinaryTest::testMalformedMessages() {
+	brics_3d::WorldModel* wmSource = new brics_3d::WorldModel();
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel(new UuidGenerator(wmSource->getRootNodeId()));
+	MyObserver wmNodeCounter;
+	wm->scene.attachUpdateObserver(&wmNodeCounter);
+	BinaryUpdateDeserializer deserializer(wm);
+	BinaryRecorder recorder;
+	BinaryUpdateSerializer serializer(&recorder);
+	wmSource->scene.attachUpdateObserver(&serializer);
+
+	vector<Attribute> attributes;
+	attributes.push_back(Attribute("name","test_group"));
+	Id groupId;
+	Id tfId;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44());
+	CPPUNIT_ASSERT(wmSource->scene.addGroup(wmSource->getRootNodeId(), groupId, attributes));
+	int firstMessageLength = static_cast<int>(recorder.data.size());
+	CPPUNIT_ASSERT(wmSource->scene.addTransformNode(groupId, tfId, attributes, transform, wmSource->now()));
+	int totalLength = static_cast<int>(recorder.data.size());
+	int transferredBytes = -1;
+
+	/* Truncated: only the complete first message is consumed */
+	std::vector<char> truncated(recorder.data.begin(), recorder.data.end() - 3);
+	CPPUNIT_ASSERT_EQUAL(1, deserializer.write(&truncated[0], static_cast<int>(truncated.size()), transferredBytes));
+	CPPUNIT_ASSERT_EQUAL(firstMessageLength, transferredBytes);
+	CPPUNIT_ASSERT_EQUAL(1, wmNodeCounter.addGroupCounter);
+	CPPUNIT_ASSERT_EQUAL(0, wmNodeCounter.addTransformCounter);
+
+	/* The rest arrives (with the complete second message) */
+	CPPUNIT_ASSERT_EQUAL(1, deserializer.write(&recorder.data[firstMessageLength], totalLength - firstMessageLength, transferredBytes));
+	CPPUNIT_ASSERT_EQUAL(totalLength - firstMessageLength, transferredBytes);
+	CPPUNIT_ASSERT_EQUAL(1, wmNodeCounter.addTransformCounter);
+
+	/* Wrong version */
+	std::vector<char> corrupted(recorder.data.begin(), recorder.data.begin() + firstMessageLength);
+	corrupted[4] = 42;
+	CPPUNIT_ASSERT_EQUAL(-1, deserializer.write(&corrupted[0], static_cast<int>(corrupted.size()), transferredBytes));
+	CPPUNIT_ASSERT_EQUAL(firstMessageLength - static_cast<int>(BinaryTypecaster::headerSize) + 1, transferredBytes); // skipped, except for a possible start of the next header
+
+	/* Decoding resynchronizes at the next valid header */
+	corrupted.insert(corrupted.end(), recorder.data.begin() + firstMessageLength, recorder.data.end());
+	CPPUNIT_ASSERT_EQUAL(-1, deserializer.write(&corrupted[0], static_cast<int>(corrupted.size()), transferredBytes));
+	CPPUNIT_ASSERT_EQUAL(totalLength, transferredBytes);
+
+	/* Attribute length exceeds the message */
+	corrupted.assign(recorder.data.begin(), recorder.data.begin() + firstMessageLength);
+	corrupted[8 + 16 + 16 + 4] = static_cast<char>(0xff);
+	CPPUNIT_ASSERT_EQUAL(-1, deserializer.write(&corrupted[0], static_cast<int>(corrupted.size()), transferredBytes));
+	CPPUNIT_ASSERT_EQUAL(firstMessageLength, transferredBytes); // the message length itself is valid
+
+	/* Unknown command */
+	corrupted.assign(recorder.data.begin(), recorder.data.begin() + firstMessageLength);
+	corrupted[5] = 99;
+	CPPUNIT_ASSERT_EQUAL(-1, deserializer.write(&corrupted[0], static_cast<int>(corrupted.size()), transferredBytes));
+	CPPUNIT_ASSERT_EQUAL(1, wmNodeCounter.addGroupCounter);
+
+	/* Empty transforms or uncertainties are not encoded */
+	Id uncertainTfId;
+	ITransformUncertainty::ITransformUncertaintyPtr emptyUncertainty;
+	CPPUNIT_ASSERT(!serializer.addUncertainTransformNode(groupId, uncertainTfId, attributes, transform, emptyUncertainty, wmSource->now()));
+	CPPUNIT_ASSERT(!serializer.setTransform(tfId, IHomogeneousMatrix44::IHomogeneousMatrix44Ptr(), wmSource->now()));
+	CPPUNIT_ASSERT_EQUAL(totalLength, static_cast<int>(recorder.data.size()));
+
+	delete wm;
+	delete wmSource;
+}
+
+/*
+ * Memorizes all datagrams, so they can be delivered later in arbitrary order.
+ */
+class DatagramRecorder : public brics_3d::rsg::IOutputPort {
+public:
+	DatagramRecorder() : maxDatagramSize(0) {};
+	int write(const char *dataBuffer, int dataLength, int &transferredBytes) {
+		datagrams.push_back(std::vector<char>(dataBuffer, dataBuffer + dataLength));
+		maxDatagramSize = std::max(maxDatagramSize, dataLength);
+		transferredBytes = dataLength;
+		return 1;
+	};
+	std::vector< std::vector<char> > datagrams;
+	int maxDatagramSize;
+};
+
+/*
+ * Fragmenter with a simulated clock that only advances while pacing, so delays can be checked exactly.
+ */
+class SimulatedClockFragmenter : public brics_3d::rsg::FragmentingOutputPort {
+public:
+	SimulatedClockFragmenter(IOutputPort* datagramPort, unsigned int maxDatagramSize) :
+		FragmentingOutputPort(datagramPort, maxDatagramSize),
+		simulatedTime(boost::gregorian::date(2017, 1, 1)) {};
+	boost::posix_time::ptime simulatedTime;
+protected:
+	boost::posix_time::ptime getCurrentTime() {
+		return simulatedTime;
+	};
+	void sleep(const boost::posix_time::time_duration& duration) {
+		simulatedTime += duration;
+	};
+};
+
+void BinaryTest::testFragmentation() {
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel();
+	brics_3d::WorldModel* wmReplica = new brics_3d::WorldModel();
+	MyObserver remoteWmNodeCounter;
+	wmReplica->scene.attachUpdateObserver(&remoteWmNodeCounter);
+	vector<Attribute> dummyAttributes;
+	wmReplica->scene.addRemoteRootNode(wm->getRootNodeId(), dummyAttributes);
+	wmReplica->scene.addParent(wm->getRootNodeId(), wmReplica->getRootNodeId());
+
+	BinaryUpdateDeserializer deserializer(wmReplica);
+	ReassemblingInputPort reassembler(&deserializer, 10*1024*1024, 2);
+	DatagramRecorder datagramPort;
+	FragmentingOutputPort fragmenter(&datagramPort, 1000);
+	BinaryUpdateSerializer serializer(&fragmenter);
+	wm->scene.attachUpdateObserver(&serializer);
+
+	/* A point cloud of ~270 KB */
+	brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr pointCloudContainer(new brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>());
+	pointCloudContainer->data = brics_3d::PointCloud3D::PointCloud3DPtr(new brics_3d::PointCloud3D());
+	for (int i = 0; i < 10000; ++i) {
+		pointCloudContainer->data->addPoint(Point3D(i, 2*i, 3*i));
+	}
+	Id pointCloudId;
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(wm->getRootNodeId(), pointCloudId, dummyAttributes, pointCloudContainer, wm->now()));
+	CPPUNIT_ASSERT(datagramPort.datagrams.size() > 270u);
+	CPPUNIT_ASSERT_EQUAL(1000, datagramPort.maxDatagramSize);
+
+	/* Deliver in reverse order with a duplicate */
+	int transferredBytes;
+	unsigned int fragments = static_cast<unsigned int>(datagramPort.datagrams.size());
+	CPPUNIT_ASSERT_EQUAL(1, reassembler.write(&datagramPort.datagrams[1][0], static_cast<int>(datagramPort.datagrams[1].size()), transferredBytes));
+	for (int i = fragments - 1; i >= 0; --i) {
+		CPPUNIT_ASSERT(reassembler.write(&datagramPort.datagrams[i][0], static_cast<int>(datagramPort.datagrams[i].size()), transferredBytes) > 0);
+	}
+	CPPUNIT_ASSERT_EQUAL(1ul, reassembler.getCompletedMessageCount());
+	CPPUNIT_ASSERT_EQUAL(0u, reassembler.getPendingMessageCount());
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addGeometricNodeCounter);
+
+	Shape::ShapePtr resultShape;
+	TimeStamp resultTime;
+	CPPUNIT_ASSERT(wmReplica->scene.getGeometry(pointCloudId, resultShape, resultTime));
+	brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr resultPointCloud = boost::dynamic_pointer_cast<brics_3d::rsg::PointCloud<brics_3d::PointCloud3D> >(resultShape);
+	CPPUNIT_ASSERT(resultPointCloud != 0);
+	CPPUNIT_ASSERT_EQUAL(10000u, resultPointCloud->data->getSize());
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(3*9999.0, (*resultPointCloud->data->getPointCloud())[9999].getZ(), maxTolerance);
+
+	/* Small messages need only one datagram */
+	datagramPort.datagrams.clear();
+	Id groupId;
+	CPPUNIT_ASSERT(wm->scene.addGroup(wm->getRootNodeId(), groupId, dummyAttributes));
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(datagramPort.datagrams.size()));
+	CPPUNIT_ASSERT_EQUAL(1, reassembler.write(&datagramPort.datagrams[0][0], static_cast<int>(datagramPort.datagrams[0].size()), transferredBytes));
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addGroupCounter);
+
+	/* Lost fragments: at most two incomplete messages are buffered */
+	for (int message = 0; message < 3; ++message) {
+		datagramPort.datagrams.clear();
+		Id id;
+		CPPUNIT_ASSERT(wm->scene.addGeometricNode(wm->getRootNodeId(), id, dummyAttributes, pointCloudContainer, wm->now()));
+		for (unsigned int i = 1; i < datagramPort.datagrams.size(); ++i) { // the first one is lost
+			reassembler.write(&datagramPort.datagrams[i][0], static_cast<int>(datagramPort.datagrams[i].size()), transferredBytes);
+		}
+	}
+	CPPUNIT_ASSERT_EQUAL(2u, reassembler.getPendingMessageCount());
+	CPPUNIT_ASSERT_EQUAL(1ul, reassembler.getDiscardedMessageCount());
+	CPPUNIT_ASSERT(reassembler.getPendingBytes() < 2 * 300000u);
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addGeometricNodeCounter);
+
+	/* Rejected datagrams */
+	char garbage[100] = {0};
+	CPPUNIT_ASSERT_EQUAL(-1, reassembler.write(garbage, sizeof(garbage), transferredBytes));
+	ReassemblingInputPort smallReassembler(&deserializer, 1000);
+	CPPUNIT_ASSERT_EQUAL(-1, smallReassembler.write(&datagramPort.datagrams[1][0], static_cast<int>(datagramPort.datagrams[1].size()), transferredBytes));
+	CPPUNIT_ASSERT_EQUAL(1ul, smallReassembler.getRejectedFragmentCount());
+
+	/* Buffers grow with the received fragments and the total is bounded */
+	ReassemblingInputPort boundedReassembler(&deserializer, 300000, 16, 300000);
+	CPPUNIT_ASSERT_EQUAL(1, boundedReassembler.write(&datagramPort.datagrams[1][0], static_cast<int>(datagramPort.datagrams[1].size()), transferredBytes));
+	CPPUNIT_ASSERT(boundedReassembler.getPendingBytes() < 2 * 1000u);
+	for (int message = 0; message < 2; ++message) {
+		datagramPort.datagrams.clear();
+		Id id;
+		CPPUNIT_ASSERT(wm->scene.addGeometricNode(wm->getRootNodeId(), id, dummyAttributes, pointCloudContainer, wm->now()));
+		for (unsigned int i = 1; i < datagramPort.datagrams.size(); ++i) { // the first one is lost
+			boundedReassembler.write(&datagramPort.datagrams[i][0], static_cast<int>(datagramPort.datagrams[i].size()), transferredBytes);
+		}
+	}
+	CPPUNIT_ASSERT_EQUAL(1u, boundedReassembler.getPendingMessageCount());
+	CPPUNIT_ASSERT_EQUAL(2ul, boundedReassembler.getDiscardedMessageCount());
+	CPPUNIT_ASSERT(boundedReassembler.getPendingBytes() <= 300000u);
+
+	/* Pacing: 20 fragments of 1000 bytes at 200 KB/s are 5 ms apart, the first one is sent immediately */
+	std::vector<char> message(20 * (1000 - FragmentHeader::size), 'x');
+	SimulatedClockFragmenter pacedFragmenter(&datagramPort, 1000);
+	pacedFragmenter.setMaxBytesPerSecond(200000);
+	CPPUNIT_ASSERT_EQUAL(1, pacedFragmenter.write(&message[0], static_cast<int>(message.size()), transferredBytes));
+	CPPUNIT_ASSERT_EQUAL(static_cast<int>(message.size()), transferredBytes);
+	CPPUNIT_ASSERT_EQUAL(95000L, static_cast<long>(pacedFragmenter.getTotalPacingDelay().total_microseconds()));
+
+	/* No credit for idle times: after a pause the next message starts immediately again */
+	pacedFragmenter.simulatedTime += boost::posix_time::seconds(1);
+	CPPUNIT_ASSERT_EQUAL(1, pacedFragmenter.write(&message[0], static_cast<int>(message.size()), transferredBytes));
+	CPPUNIT_ASSERT_EQUAL(2 * 95000L, static_cast<long>(pacedFragmenter.getTotalPacingDelay().total_microseconds()));
+	CPPUNIT_ASSERT_EQUAL(0L, static_cast<long>(fragmenter.getTotalPacingDelay().total_microseconds()));
+
+	delete wmReplica;
+	delete wm;
+}
+
+/*
+ * Sends every datagram via a UDP socket to a second socket on the loopback interface
+ * and passes what has been received there to an input port.
+ */
+class UdpLoopbackPort : public brics_3d::rsg::IOutputPort {
+public:
+	UdpLoopbackPort(brics_3d::rsg::IInputPort* inputPort) : inputPort(inputPort), receivedDatagrams(0), buffer(65536) {
+		sendSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		receiveSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_port = 0; // any free port
+		address.sin_addr.s_addr = inet_addr("127.0.0.1");
+		socklen_t addressLength = sizeof(address);
+		isOpen = (sendSocket != -1) && (receiveSocket != -1) &&
+				(bind(receiveSocket, (struct sockaddr*) &address, sizeof(address)) == 0) &&
+				(getsockname(receiveSocket, (struct sockaddr*) &address, &addressLength) == 0);
+
+		struct timeval timeout; // do not block forever if a datagram is lost
+		timeout.tv_sec = 1;
+		timeout.tv_usec = 0;
+		setsockopt(receiveSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	};
+	virtual ~UdpLoopbackPort() {
+		close(sendSocket);
+		close(receiveSocket);
+	};
+	int write(const char *dataBuffer, int dataLength, int &transferredBytes) {
+		transferredBytes = sendto(sendSocket, dataBuffer, dataLength, 0, (struct sockaddr*) &address, sizeof(address));
+		if (transferredBytes != dataLength) {
+			return -1;
+		}
+		int readBytes = recvfrom(receiveSocket, &buffer[0], buffer.size(), 0, 0, 0);
+		if (readBytes <= 0) {
+			return -1;
+		}
+		receivedDatagrams++;
+		int forwardedBytes;
+		inputPort->write(&buffer[0], readBytes, forwardedBytes);
+		return 1;
+	};
+	brics_3d::rsg::IInputPort* inputPort;
+	bool isOpen;
+	int sendSocket;
+	int receiveSocket;
+	struct sockaddr_in address;
+	unsigned int receivedDatagrams;
+	std::vector<char> buffer;
+};
+
+void BinaryTest::testUdpFragmentation() {
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel();
+	brics_3d::WorldModel* wmReplica = new brics_3d::WorldModel();
+	MyObserver remoteWmNodeCounter;
+	wmReplica->scene.attachUpdateObserver(&remoteWmNodeCounter);
+	vector<Attribute> dummyAttributes;
+	wmReplica->scene.addRemoteRootNode(wm->getRootNodeId(), dummyAttributes);
+	wmReplica->scene.addParent(wm->getRootNodeId(), wmReplica->getRootNodeId());
+
+	BinaryUpdateDeserializer deserializer(wmReplica);
+	ReassemblingInputPort reassembler(&deserializer);
+	UdpLoopbackPort udpPort(&reassembler);
+	CPPUNIT_ASSERT(udpPort.isOpen);
+	FragmentingOutputPort fragmenter(&udpPort, 1400);
+	BinaryUpdateSerializer serializer(&fragmenter);
+	wm->scene.attachUpdateObserver(&serializer);
+
+	/* A point cloud of ~270 KB exceeds the 64 KB limit of a single UDP datagram */
+	brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr pointCloudContainer(new brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>());
+	pointCloudContainer->data = brics_3d::PointCloud3D::PointCloud3DPtr(new brics_3d::PointCloud3D());
+	for (int i = 0; i < 10000; ++i) {
+		pointCloudContainer->data->addPoint(Point3D(i, 2*i, 3*i));
+	}
+	Id pointCloudId;
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(wm->getRootNodeId(), pointCloudId, dummyAttributes, pointCloudContainer, wm->now()));
+	CPPUNIT_ASSERT(udpPort.receivedDatagrams > 190u);
+	CPPUNIT_ASSERT_EQUAL(static_cast<unsigned long>(udpPort.receivedDatagrams), fragmenter.getFragmentCount());
+	CPPUNIT_ASSERT_EQUAL(1ul, reassembler.getCompletedMessageCount());
+	CPPUNIT_ASSERT_EQUAL(0u, reassembler.getPendingMessageCount());
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addGeometricNodeCounter);
+
+	Shape::ShapePtr resultShape;
+	TimeStamp resultTime;
+	CPPUNIT_ASSERT(wmReplica->scene.getGeometry(pointCloudId, resultShape, resultTime));
+	brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr resultPointCloud = boost::dynamic_pointer_cast<brics_3d::rsg::PointCloud<brics_3d::PointCloud3D> >(resultShape);
+	CPPUNIT_ASSERT(resultPointCloud != 0);
+	CPPUNIT_ASSERT_EQUAL(10000u, resultPointCloud->data->getSize());
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(3*9999.0, (*resultPointCloud->data->getPointCloud())[9999].getZ(), maxTolerance);
+
+	/* Small updates follow on the same sockets */
+	Id groupId;
+	CPPUNIT_ASSERT(wm->scene.addGroup(wm->getRootNodeId(), groupId, dummyAttributes));
+	CPPUNIT_ASSERT_EQUAL(2ul, reassembler.getCompletedMessageCount());
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addGroupCounter);
+
+	delete wmReplica;
+	delete wm;
+}
+
+class MessageRecorder : public brics_3d::rsg::IInputPort {
+public:
+	int write(const char *dataBuffer, int dataLength, int &transferredBytes) {
+		messages.push_back(std::string(dataBuffer, dataLength));
+		transferredBytes = dataLength;
+		return 1;
+	};
+	std::vector<std::string> messages;
+};
+
+void BinaryTest::testSharedMemoryTransport() {
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel();
+	brics_3d::WorldModel* wmReplica1 = new brics_3d::WorldModel();
+	brics_3d::WorldModel* wmReplica2 = new brics_3d::WorldModel();
+	vector<Attribute> dummyAttributes;
+	wmReplica1->scene.addRemoteRootNode(wm->getRootNodeId(), dummyAttributes);
+	wmReplica1->scene.addParent(wm->getRootNodeId(), wmReplica1->getRootNodeId());
+	wmReplica2->scene.addRemoteRootNode(wm->getRootNodeId(), dummyAttributes);
+	wmReplica2->scene.addParent(wm->getRootNodeId(), wmReplica2->getRootNodeId());
+
+	/* The receivers may be started before the sender */
+	BinaryUpdateDeserializer deserializer1(wmReplica1);
+	BinaryUpdateDeserializer deserializer2(wmReplica2);
+	SharedMemoryInputBridge bridge1(&deserializer1, "/brics_3d_binary_test");
+	SharedMemoryInputBridge bridge2(&deserializer2, "/brics_3d_binary_test");
+	bridge2.setCopyMessages(true);
+	CPPUNIT_ASSERT(!bridge1.isConnected());
+	CPPUNIT_ASSERT_EQUAL(0u, bridge1.poll());
+
+	SharedMemoryOutputPort sharedMemoryPort("/brics_3d_binary_test", 1024*1024);
+	CPPUNIT_ASSERT(sharedMemoryPort.isOpen());
+	CPPUNIT_ASSERT(bridge1.connect());
+	CPPUNIT_ASSERT(bridge2.connect());
+	BinaryUpdateSerializer serializer(&sharedMemoryPort);
+	wm->scene.attachUpdateObserver(&serializer);
+
+	vector<Attribute> attributes;
+	attributes.push_back(Attribute("name", "tf"));
+	Id tfId;
+	HomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 1,2,3));
+	CPPUNIT_ASSERT(wm->scene.addTransformNode(wm->getRootNodeId(), tfId, attributes, transform, wm->now()));
+	for (int i = 0; i < 100; ++i) {
+		HomogeneousMatrix44::IHomogeneousMatrix44Ptr update(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, i,2,3));
+		CPPUNIT_ASSERT(wm->scene.setTransform(tfId, update, wm->now()));
+	}
+	CPPUNIT_ASSERT_EQUAL(101ul, sharedMemoryPort.getMessageCount());
+
+	CPPUNIT_ASSERT_EQUAL(101u, bridge1.poll());
+	CPPUNIT_ASSERT_EQUAL(0u, bridge1.poll());
+	CPPUNIT_ASSERT_EQUAL(50u, bridge2.poll(50));
+	CPPUNIT_ASSERT_EQUAL(51u, bridge2.waitForMessages(1000));
+	CPPUNIT_ASSERT_EQUAL(0ul, bridge1.getLostMessageCount());
+	CPPUNIT_ASSERT_EQUAL(0ul, bridge2.getLostMessageCount());
+
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr result;
+	CPPUNIT_ASSERT(wmReplica1->scene.getTransform(tfId, wm->now(), result));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(99.0, result->getRawData()[12], maxTolerance);
+	CPPUNIT_ASSERT(wmReplica2->scene.getTransform(tfId, wm->now(), result));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(99.0, result->getRawData()[12], maxTolerance);
+	CPPUNIT_ASSERT_EQUAL(0u, bridge1.waitForMessages(100));
+
+	/* Slow receivers lose the oldest messages, the sender never blocks */
+	MessageRecorder recorder;
+	SharedMemoryOutputPort smallPort("/brics_3d_binary_test_small", 1024);
+	SharedMemoryInputBridge slowBridge(&recorder, "/brics_3d_binary_test_small");
+	CPPUNIT_ASSERT(slowBridge.isConnected());
+	int transferredBytes;
+	for (int i = 0; i < 100; ++i) {
+		std::stringstream message;
+		message << "message " << i;
+		CPPUNIT_ASSERT_EQUAL(1, smallPort.write(message.str().c_str(), static_cast<int>(message.str().size()), transferredBytes));
+	}
+	CPPUNIT_ASSERT_EQUAL(0u, slowBridge.poll()); // lapped, skips to the newest position
+	CPPUNIT_ASSERT_EQUAL(1, smallPort.write("latest", 6, transferredBytes));
+	CPPUNIT_ASSERT_EQUAL(1u, slowBridge.poll());
+	CPPUNIT_ASSERT_EQUAL(100ul, slowBridge.getLostMessageCount());
+	CPPUNIT_ASSERT_EQUAL(std::string("latest"), recorder.messages.back());
+	for (int i = 0; i < 30; ++i) { // wraps around the end of the buffer without lapping
+		std::stringstream message;
+		message << "message " << i;
+		smallPort.write(message.str().c_str(), static_cast<int>(message.str().size()), transferredBytes);
+		if (i % 10 == 9) {
+			CPPUNIT_ASSERT_EQUAL(10u, slowBridge.poll());
+		}
+	}
+	CPPUNIT_ASSERT_EQUAL(std::string("message 29"), recorder.messages.back());
+	CPPUNIT_ASSERT_EQUAL(100ul, slowBridge.getLostMessageCount());
+	CPPUNIT_ASSERT_EQUAL(31ul, slowBridge.getReceivedMessageCount());
+
+	/* Too large messages are rejected */
+	std::vector<char> largeMessage(1024, 'x');
+	CPPUNIT_ASSERT_EQUAL(-1, smallPort.write(&largeMessage[0], static_cast<int>(largeMessage.size()), transferredBytes));
+	CPPUNIT_ASSERT_EQUAL(1ul, smallPort.getRejectedMessageCount());
+
+	/* Only one sender per name */
+	SharedMemoryOutputPort competingPort("/brics_3d_binary_test_small", 1024);
+	CPPUNIT_ASSERT(!competingPort.isOpen());
+	CPPUNIT_ASSERT(smallPort.isOpen());
+	CPPUNIT_ASSERT_EQUAL(1, smallPort.write("still here", 10, transferredBytes));
+	CPPUNIT_ASSERT_EQUAL(1u, slowBridge.poll());
+
+	/* A restarted sender is followed by the receivers */
+	MessageRecorder restartRecorder;
+	SharedMemoryOutputPort* restartingPort = new SharedMemoryOutputPort("/brics_3d_binary_test_restart", 1024);
+	SharedMemoryInputBridge restartBridge(&restartRecorder, "/brics_3d_binary_test_restart");
+	CPPUNIT_ASSERT(restartBridge.isConnected());
+	CPPUNIT_ASSERT_EQUAL(1, restartingPort->write("before", 6, transferredBytes));
+	delete restartingPort;
+	CPPUNIT_ASSERT(!restartBridge.isConnected());
+	restartingPort = new SharedMemoryOutputPort("/brics_3d_binary_test_restart", 1024);
+	CPPUNIT_ASSERT(restartingPort->isOpen());
+	CPPUNIT_ASSERT_EQUAL(1, restartingPort->write("after", 5, transferredBytes));
+	CPPUNIT_ASSERT_EQUAL(2u, restartBridge.poll());
+	CPPUNIT_ASSERT(restartBridge.isConnected());
+	CPPUNIT_ASSERT_EQUAL(std::string("before"), restartRecorder.messages[0]);
+	CPPUNIT_ASSERT_EQUAL(std::string("after"), restartRecorder.messages[1]);
+	CPPUNIT_ASSERT_EQUAL(0ul, restartBridge.getLostMessageCount());
+	CPPUNIT_ASSERT_EQUAL(1, restartingPort->write("again", 5, transferredBytes));
+	CPPUNIT_ASSERT_EQUAL(1u, restartBridge.poll());
+	delete restartingPort;
+
+	delete wmReplica2;
+	delete wmReplica1;
+	delete wm;
+}
+
+}  // namespace unitTests
+
+/* EOF */
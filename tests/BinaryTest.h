@@ -0,0 +1,62 @@
+/******************************************************************************
+ * BRICS_3D - 3D Perception and Modeling Library
+ * Copyright (c) 2017, KU Leuven
+ *
+ * Author: Sebastian Blumenthal
+ *
+ *
+ * This software is published under a dual-license: GNU Lesser General Public
+ * License LGPL 2.1 and Modified BSD license. The dual-license implies that
+ * users of this code may choose which terms they prefer.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License LGPL and the BSD license for
+ * more details.
+ *
+ ******************************************************************************/
+
+#ifndef BINARYTEST_H_
+#define BINARYTEST_H_
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "brics_3d/worldModel/WorldModel.h"
+
+namespace unitTests {
+
+class BinaryTest : public CPPUNIT_NS::TestFixture {
+
+	CPPUNIT_TEST_SUITE( BinaryTest );
+	CPPUNIT_TEST( testLoopBack );
+	CPPUNIT_TEST( testUpdateBatch );
+	CPPUNIT_TEST( testMalformedMessages );
+	CPPUNIT_TEST( testFragmentation );
+	CPPUNIT_TEST( testUdpFragmentation );
+	CPPUNIT_TEST( testSharedMemoryTransport );
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+
+	void setUp();
+	void tearDown();
+
+	void testLoopBack();
+	void testUpdateBatch();
+	void testMalformedMessages();
+	void testFragmentation();
+	void testUdpFragmentation();
+	void testSharedMemoryTransport();
+
+private:
+	  /// Maximum deviation for equality check of double variables
+	  static const double maxTolerance = 0.00001;
+
+};
+
+}  // namespace unitTests
+#endif /* BINARYTEST_H_ */
+
+/* EOF */
@@ -220,6 +220,131 @@ void BoundingBox3DTest::testSimpleOrientedBox() {
 
 }
 
+void BoundingBox3DTest::testPointCloudStatistics() {
+	PointCloudStatistics emptyStatistics;
+	Point3D lower;
+	Point3D upper;
+	CPPUNIT_ASSERT_EQUAL(0u, emptyStatistics.getNumberOfPoints());
+	CPPUNIT_ASSERT(!emptyStatistics.getAxisAlignedBoundingBox(lower, upper));
+
+	/* a cloud far away from the origin, that is critical for the naive sum of squares */
+	const double offset = 1e8;
+	PointCloud3D::PointCloud3DPtr cloud(new PointCloud3D());
+	srand(42);
+	for (int i = 0; i < 1000; ++i) {
+		cloud->addPoint(Point3D(offset + 4.0 * rand() / RAND_MAX, offset + 2.0 * rand() / RAND_MAX, offset + 1.0 * rand() / RAND_MAX));
+	}
+
+	/* reference values with an exact two-pass computation relative to the offset */
+	double mean[3] = {0, 0, 0};
+	for (unsigned int i = 0; i < cloud->getSize(); ++i) {
+		mean[0] += (*cloud->getPointCloud())[i].getX() - offset;
+		mean[1] += (*cloud->getPointCloud())[i].getY() - offset;
+		mean[2] += (*cloud->getPointCloud())[i].getZ() - offset;
+	}
+	for (int j = 0; j < 3; ++j) {
+		mean[j] /= cloud->getSize();
+	}
+	Eigen::Matrix3d covariance = Eigen::Matrix3d::Zero();
+	for (unsigned int i = 0; i < cloud->getSize(); ++i) {
+		Eigen::Vector3d d;
+		d[0] = (*cloud->getPointCloud())[i].getX() - offset - mean[0];
+		d[1] = (*cloud->getPointCloud())[i].getY() - offset - mean[1];
+		d[2] = (*cloud->getPointCloud())[i].getZ() - offset - mean[2];
+		covariance += d * d.transpose();
+	}
+	covariance /= cloud->getSize();
+
+	PointCloudStatistics statistics;
+	statistics.addPoints(cloud.get());
+	CPPUNIT_ASSERT_EQUAL(1000u, statistics.getNumberOfPoints());
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(offset + mean[0], statistics.getCentroid()[0], maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(offset + mean[1], statistics.getCentroid()[1], maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(offset + mean[2], statistics.getCentroid()[2], maxTolerance);
+	for (int r = 0; r < 3; ++r) {
+		for (int c = 0; c < 3; ++c) {
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(covariance(r, c), statistics.getCovariance()(r, c), 1e-4);
+		}
+	}
+
+	/* point wise updates, iterators and merged partial results yield the same */
+	PointCloudStatistics pointWise;
+	PointCloudStatistics firstHalf;
+	PointCloudStatistics secondHalf;
+	for (unsigned int i = 0; i < cloud->getSize(); ++i) {
+		Point3D point = (*cloud->getPointCloud())[i];
+		pointWise.addPoint(point.getX(), point.getY(), point.getZ());
+		if (i < 300) {
+			firstHalf.addPoint(point.getX(), point.getY(), point.getZ());
+		} else {
+			secondHalf.addPoint(point.getX(), point.getY(), point.getZ());
+		}
+	}
+	firstHalf.merge(secondHalf);
+	PointCloudStatistics fromIterator;
+	PointCloud3DIterator::PointCloud3DIteratorPtr it(new PointCloud3DIterator());
+	it->insert(cloud);
+	fromIterator.addPoints(it);
+
+	PointCloudStatistics* variants[] = {&pointWise, &firstHalf, &fromIterator};
+	for (int k = 0; k < 3; ++k) {
+		CPPUNIT_ASSERT_EQUAL(1000u, variants[k]->getNumberOfPoints());
+		for (int r = 0; r < 3; ++r) {
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(statistics.getCentroid()[r], variants[k]->getCentroid()[r], maxTolerance);
+			for (int c = 0; c < 3; ++c) {
+				CPPUNIT_ASSERT_DOUBLES_EQUAL(covariance(r, c), variants[k]->getCovariance()(r, c), 1e-4);
+			}
+		}
+	}
+
+	/* invalid points are skipped */
+	fromIterator.addPoint(std::numeric_limits<double>::quiet_NaN(), 0, 0);
+	fromIterator.addPoint(0, std::numeric_limits<double>::infinity(), 0);
+	CPPUNIT_ASSERT_EQUAL(1000u, fromIterator.getNumberOfPoints());
+	CPPUNIT_ASSERT_EQUAL(2u, fromIterator.getNumberOfSkippedPoints());
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(statistics.getCentroid()[0], fromIterator.getCentroid()[0], maxTolerance);
+
+	/* axis aligned and oriented bounding box of the unit cube */
+	PointCloudStatistics cubeStatistics;
+	cubeStatistics.addPoints(testCloudUnitCube);
+	Point3D center;
+	Vector3D dimensions;
+	CPPUNIT_ASSERT(cubeStatistics.getAxisAlignedBoundingBox(lower, upper));
+	CPPUNIT_ASSERT(cubeStatistics.getAxisAlignedBoundingBox(center, dimensions));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, lower.getX(), maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, upper.getZ(), maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, center.getY(), maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, dimensions.getX(), maxTolerance);
+
+	HomogeneousMatrix44 resultTransform;
+	Vector3D resultBoxDimensions;
+	cubeStatistics.computeOrientedBoundingBox(testCloudUnitCube, &resultTransform, resultBoxDimensions);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, resultTransform.getRawData()[12], maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, resultTransform.getRawData()[14], maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, resultBoxDimensions.getX(), maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, resultBoxDimensions.getY(), maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, resultBoxDimensions.getZ(), maxTolerance);
+
+	/* elongated cloud: main axis first */
+	Eigen::MatrixXd eigenvectors;
+	Eigen::VectorXd eigenvalues;
+	statistics.computePrincipleComponents(eigenvectors, eigenvalues);
+	CPPUNIT_ASSERT(eigenvalues[0] >= eigenvalues[1]);
+	CPPUNIT_ASSERT(eigenvalues[1] >= eigenvalues[2]);
+	CPPUNIT_ASSERT(fabs(eigenvectors(0, 0)) > 0.9);
+
+	/* a cloud without valid points has an empty bounding box, no matter what was computed before */
+	BoundingBox3DExtractor boundingBoxExtractor;
+	boundingBoxExtractor.computeBoundingBox(testCloudUnitCube, center, dimensions);
+	PointCloud3D invalidCloud;
+	invalidCloud.addPoint(Point3D(std::numeric_limits<double>::quiet_NaN(), 0, 0));
+	boundingBoxExtractor.computeBoundingBox(&invalidCloud, center, dimensions);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, center.getX(), maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, dimensions.getX(), maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, dimensions.getY(), maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, dimensions.getZ(), maxTolerance);
+}
+
 }  // namespace unitTests
 
 /* EOF */
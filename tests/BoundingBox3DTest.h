@@ -15,7 +15,9 @@
 #include <cppunit/extensions/HelperMacros.h>
 
 #include "brics_3d/algorithm/featureExtraction/BoundingBox3DExtractor.h"
+#include "brics_3d/algorithm/featureExtraction/PointCloudStatistics.h"
 #include "brics_3d/core/HomogeneousMatrix44.h"
+#include "brics_3d/core/PointCloud3DIterator.h"
 
 using namespace std;
 using namespace brics_3d;
@@ -28,6 +30,7 @@ class BoundingBox3DTest : public CPPUNIT_NS::TestFixture {
 	CPPUNIT_TEST_SUITE( BoundingBox3DTest );
 	CPPUNIT_TEST( testSimpleBoundingBox );
 	CPPUNIT_TEST( testSimpleOrientedBox );
+	CPPUNIT_TEST( testPointCloudStatistics );
 	CPPUNIT_TEST_SUITE_END();
 public:
 
@@ -36,6 +39,7 @@ public:
 
 	void testSimpleBoundingBox();
 	void testSimpleOrientedBox();
+	void testPointCloudStatistics();
 
 	/// Maximum deviation for equality check of double variables
 	static const double maxTolerance = 0.00001;
@@ -1270,6 +1270,117 @@ void DistributedWorldModelTest::testUpdateFilters() {
 	delete frequencyFilter;
 }
 
+void DistributedWorldModelTest::testRateLimitingUpdateFilter() {
+	WorldModel* wm = new WorldModel();
+	WorldModel* remoteWm = new WorldModel();
+	vector<Attribute> attributes;
+	remoteWm->scene.addRemoteRootNode(wm->getRootNodeId(), attributes);
+	remoteWm->scene.addParent(wm->getRootNodeId(), remoteWm->getRootNodeId());
+
+	/* wm -> filter -> remote */
+	RateLimitingUpdateFilter filter;
+	MyObserver filteredUpdatesCounter;
+	UpdatesToSceneGraphListener wmToRemoteWmListener;
+	wmToRemoteWmListener.attachSceneGraph(&remoteWm->scene);
+	CPPUNIT_ASSERT(wm->scene.attachUpdateObserver(&filter));
+	CPPUNIT_ASSERT(filter.attachUpdateObserver(&filteredUpdatesCounter));
+	CPPUNIT_ASSERT(filter.attachUpdateObserver(&wmToRemoteWmListener));
+	filter.setMaxTransformUpdateFrequency(10);
+	filter.setMaxGeometricNodeUpdateFrequency(10);
+
+	Id tf1Id;
+	Id tf2Id;
+	HomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 0,0,0));
+	CPPUNIT_ASSERT(wm->scene.addTransformNode(wm->getRootNodeId(), tf1Id, attributes, transform, wm->now()));
+	CPPUNIT_ASSERT(wm->scene.addTransformNode(wm->getRootNodeId(), tf2Id, attributes, transform, wm->now()));
+	CPPUNIT_ASSERT_EQUAL(2, filteredUpdatesCounter.addTransformCounter);
+
+	/* Every transform has its own budget */
+	HomogeneousMatrix44::IHomogeneousMatrix44Ptr transform1(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 1,0,0));
+	CPPUNIT_ASSERT(wm->scene.setTransform(tf1Id, transform1, wm->now()));
+	CPPUNIT_ASSERT(wm->scene.setTransform(tf2Id, transform1, wm->now()));
+	CPPUNIT_ASSERT_EQUAL(2, filteredUpdatesCounter.setTransformCounter);
+
+	/* Too fast updates are coalesced and the newest one is forwarded later */
+	HomogeneousMatrix44::IHomogeneousMatrix44Ptr transform2(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 2,0,0));
+	HomogeneousMatrix44::IHomogeneousMatrix44Ptr transform3(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 3,0,0));
+	CPPUNIT_ASSERT(wm->scene.setTransform(tf1Id, transform2, wm->now()));
+	CPPUNIT_ASSERT(wm->scene.setTransform(tf1Id, transform3, wm->now()));
+	CPPUNIT_ASSERT_EQUAL(2, filteredUpdatesCounter.setTransformCounter);
+	CPPUNIT_ASSERT_EQUAL(1u, filter.getPendingUpdateCount());
+	CPPUNIT_ASSERT_EQUAL(1ul, filter.getCoalescedUpdateCount());
+	CPPUNIT_ASSERT_EQUAL(0u, filter.flush());
+
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr result;
+	CPPUNIT_ASSERT(remoteWm->scene.getTransform(tf1Id, wm->now(), result));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, result->getRawData()[12], maxTolerance);
+	boost::this_thread::sleep(boost::posix_time::milliseconds(120));
+	CPPUNIT_ASSERT_EQUAL(1u, filter.flush());
+	CPPUNIT_ASSERT_EQUAL(3, filteredUpdatesCounter.setTransformCounter);
+	CPPUNIT_ASSERT_EQUAL(0u, filter.getPendingUpdateCount());
+	CPPUNIT_ASSERT(remoteWm->scene.getTransform(tf1Id, wm->now(), result));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, result->getRawData()[12], maxTolerance);
+
+	/* Geometric nodes are limited per parent; superseded nodes never reach the observers */
+	Box::BoxPtr box(new Box(1, 2, 3));
+	Id box1Id;
+	Id box2Id;
+	Id box3Id;
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(tf1Id, box1Id, attributes, box, wm->now()));
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(tf1Id, box2Id, attributes, box, wm->now()));
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(tf1Id, box3Id, attributes, box, wm->now()));
+	CPPUNIT_ASSERT_EQUAL(1, filteredUpdatesCounter.addGeometricNodeCounter);
+	CPPUNIT_ASSERT_EQUAL(2ul, filter.getCoalescedUpdateCount());
+	CPPUNIT_ASSERT(wm->scene.deleteNode(box2Id));
+	CPPUNIT_ASSERT_EQUAL(0, filteredUpdatesCounter.deleteNodeCounter);
+
+	attributes.push_back(Attribute("name", "box3"));
+	CPPUNIT_ASSERT(wm->scene.setNodeAttributes(box3Id, attributes)); // forwards the pending node first
+	CPPUNIT_ASSERT_EQUAL(2, filteredUpdatesCounter.addGeometricNodeCounter);
+	CPPUNIT_ASSERT_EQUAL(1, filteredUpdatesCounter.setNodeAttributesCounter);
+	vector<Attribute> resultAttributes;
+	CPPUNIT_ASSERT(remoteWm->scene.getNodeAttributes(box3Id, resultAttributes));
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(resultAttributes.size()));
+	CPPUNIT_ASSERT(!remoteWm->scene.getNodeAttributes(box2Id, resultAttributes));
+
+	/* Flush thread */
+	filter.startFlushThread(5);
+	for (int i = 0; i < 10; ++i) {
+		HomogeneousMatrix44::IHomogeneousMatrix44Ptr update(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 10+i,0,0));
+		CPPUNIT_ASSERT(wm->scene.setTransform(tf2Id, update, wm->now()));
+	}
+	boost::this_thread::sleep(boost::posix_time::milliseconds(150));
+	filter.stopFlushThread();
+	CPPUNIT_ASSERT_EQUAL(0u, filter.getPendingUpdateCount());
+	CPPUNIT_ASSERT(filteredUpdatesCounter.setTransformCounter <= 5);
+	CPPUNIT_ASSERT(remoteWm->scene.getTransform(tf2Id, wm->now(), result));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(19.0, result->getRawData()[12], maxTolerance);
+
+	/* Disabling the limit with a pending transform does not forward the older one later */
+	HomogeneousMatrix44::IHomogeneousMatrix44Ptr transform4(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 4,0,0));
+	HomogeneousMatrix44::IHomogeneousMatrix44Ptr transform5(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 5,0,0));
+	CPPUNIT_ASSERT(wm->scene.setTransform(tf1Id, transform3, wm->now()));
+	CPPUNIT_ASSERT(wm->scene.setTransform(tf1Id, transform4, wm->now()));
+	CPPUNIT_ASSERT_EQUAL(1u, filter.getPendingUpdateCount());
+	filter.setMaxTransformUpdateFrequency(0);
+	CPPUNIT_ASSERT(wm->scene.setTransform(tf1Id, transform5, wm->now()));
+	CPPUNIT_ASSERT_EQUAL(0u, filter.getPendingUpdateCount());
+	CPPUNIT_ASSERT_EQUAL(0u, filter.flush());
+	CPPUNIT_ASSERT(remoteWm->scene.getTransform(tf1Id, wm->now(), result));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0, result->getRawData()[12], maxTolerance);
+
+	/* Without limits everything passes */
+	int transformUpdates = filteredUpdatesCounter.setTransformCounter;
+	for (int i = 0; i < 10; ++i) {
+		CPPUNIT_ASSERT(wm->scene.setTransform(tf2Id, transform, wm->now()));
+	}
+	CPPUNIT_ASSERT_EQUAL(transformUpdates + 10, filteredUpdatesCounter.setTransformCounter);
+
+	CPPUNIT_ASSERT(wm->scene.detachUpdateObserver(&filter));
+	delete remoteWm;
+	delete wm;
+}
+
 void DistributedWorldModelTest::testAttributesLoopBack() {
 	WorldModel* wm = new WorldModel();
 	WorldModel* remoteWm = new WorldModel();
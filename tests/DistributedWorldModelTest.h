@@ -33,6 +33,7 @@
 #include "brics_3d/worldModel/sceneGraph/UpdatesToSceneGraphListener.h"
 #include "brics_3d/worldModel/sceneGraph/RemoteRootNodeAutoMounter.h"
 #include <brics_3d/worldModel/sceneGraph/FrequencyAwareUpdateFilter.h>
+#include <brics_3d/worldModel/sceneGraph/RateLimitingUpdateFilter.h>
 
 namespace unitTests {
 
@@ -59,6 +60,7 @@ class DistributedWorldModelTest : public CPPUNIT_NS::TestFixture {
 	CPPUNIT_TEST( testAutoMountRemoteNodePolicy );
 	CPPUNIT_TEST( testUpdateFilters );
 	CPPUNIT_TEST( testAttributesLoopBack );
+	CPPUNIT_TEST( testRateLimitingUpdateFilter );
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -76,6 +78,7 @@ public:
 	void testAutoMountRemoteNodePolicy();
 	void testUpdateFilters();
 	void testAttributesLoopBack();
+	void testRateLimitingUpdateFilter();
 
 
 private:
@@ -24,6 +24,12 @@
 #include "brics_3d/worldModel/sceneGraph/GraphConstraint.h"
 #include "brics_3d/worldModel/sceneGraph/GraphConstraintUpdateFilter.h"
 #include "brics_3d/worldModel/sceneGraph/UpdatesToSceneGraphListener.h"
+#include "brics_3d/worldModel/sceneGraph/DistanceConstraintEvaluator.h"
+#include "brics_3d/worldModel/sceneGraph/LODCalculator.h"
+#include "brics_3d/worldModel/sceneGraph/GraphConstraintPolicy.h"
+#include "brics_3d/worldModel/sceneGraph/Sphere.h"
+#include "brics_3d/worldModel/sceneGraph/Mesh.h"
+#include "brics_3d/core/TriangleMeshExplicit.h"
 
 using namespace brics_3d;
 
@@ -281,6 +287,73 @@ void GraphConstraintTest::testNoInputConstraints() {
 
 }
 
+void GraphConstraintTest::testReceiverDistanceConstraints() {
+	WorldModel* myWm = new WorldModel();
+	MyObserver wmNodeCounter;
+	GraphConstraintUpdateFilter filter(myWm, brics_3d::rsg::GraphConstraintUpdateFilter::RECEIVER);
+	UpdatesToSceneGraphListener wmUpdatesToWm;
+	wmUpdatesToWm.setForcedIdPolicy(false);
+
+	filter.attachUpdateObserver(&wmUpdatesToWm);
+	wmUpdatesToWm.attachSceneGraph(&myWm->scene);
+	myWm->scene.attachUpdateObserver(&wmNodeCounter);
+
+	/*
+	 * root
+	 *  |-- tfA (1,0,0) -- referenceGroup
+	 *  |-- tfB (4,4,0) -- node
+	 */
+	vector<Attribute> attributes;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transformA(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 1,0,0));
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transformB(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 4,4,0));
+	Id tfAId;
+	Id tfBId;
+	Id referenceGroupId;
+	Id nodeId;
+	CPPUNIT_ASSERT(myWm->scene.addTransformNode(myWm->getRootNodeId(), tfAId, attributes, transformA, myWm->now()));
+	CPPUNIT_ASSERT(myWm->scene.addTransformNode(myWm->getRootNodeId(), tfBId, attributes, transformB, myWm->now()));
+	CPPUNIT_ASSERT(myWm->scene.addGroup(tfAId, referenceGroupId, attributes));
+	CPPUNIT_ASSERT(myWm->scene.addNode(tfBId, nodeId, attributes));
+
+	stringstream model("");
+	model << "receive no Atoms with dist > 4.5 m from " << referenceGroupId;
+	GraphConstraint c1;
+	CPPUNIT_ASSERT(c1.parse(model.str()));
+	filter.constraints.clear();
+	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
+
+	/* node is 5 m away from the reference */
+	attributes.push_back(Attribute("name", "node"));
+	CPPUNIT_ASSERT(!filter.setNodeAttributes(nodeId, attributes, myWm->now()));
+	CPPUNIT_ASSERT_EQUAL(0, wmNodeCounter.setNodeAttributesCounter);
+
+	/* The reference is moved by a received update. The check of that update must not keep the old pose of the reference. */
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transformA2(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 4,0,0));
+	CPPUNIT_ASSERT(filter.setTransform(tfAId, transformA2, myWm->now()));
+	CPPUNIT_ASSERT_EQUAL(1, wmNodeCounter.setTransformCounter);
+
+	/* now it is 4 m away */
+	CPPUNIT_ASSERT(filter.setNodeAttributes(nodeId, attributes, myWm->now()));
+	CPPUNIT_ASSERT_EQUAL(1, wmNodeCounter.setNodeAttributesCounter);
+
+	/* The same for a structural change: referenceGroup is moved below tfB, i.e. 0 m away from node */
+	CPPUNIT_ASSERT(filter.addParent(referenceGroupId, tfBId));
+	CPPUNIT_ASSERT(filter.removeParent(referenceGroupId, tfAId));
+	CPPUNIT_ASSERT_EQUAL(1, wmNodeCounter.addParentCounter);
+	CPPUNIT_ASSERT_EQUAL(1, wmNodeCounter.removeParentCounter);
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transformA3(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 9,0,0));
+	CPPUNIT_ASSERT(filter.setTransform(tfAId, transformA3, myWm->now())); // tfA is 0 m away from its old position
+	CPPUNIT_ASSERT(!filter.setTransform(tfAId, transformA3, myWm->now())); // but now 9.8 m
+	CPPUNIT_ASSERT_EQUAL(2, wmNodeCounter.setTransformCounter);
+	attributes.clear();
+	attributes.push_back(Attribute("name", "moved_node"));
+	CPPUNIT_ASSERT(filter.setNodeAttributes(nodeId, attributes, myWm->now()));
+	CPPUNIT_ASSERT_EQUAL(2, wmNodeCounter.setNodeAttributesCounter);
+
+	delete myWm;
+}
+
 void GraphConstraintTest::testSimpleConstraints() {
 
 	WorldModel* wm = new WorldModel();
@@ -307,6 +380,7 @@ void GraphConstraintTest::testSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no Atoms"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(0, wmNodeCounter.addNodeCounter);
@@ -324,6 +398,7 @@ void GraphConstraintTest::testSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no Nodes"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(0, wmNodeCounter.addNodeCounter);
@@ -341,6 +416,7 @@ void GraphConstraintTest::testSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send only Nodes"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(3, wmNodeCounter.addNodeCounter);
@@ -358,6 +434,7 @@ void GraphConstraintTest::testSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no Groups"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(6, wmNodeCounter.addNodeCounter);
@@ -375,6 +452,7 @@ void GraphConstraintTest::testSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send only Groups"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(6, wmNodeCounter.addNodeCounter);
@@ -394,6 +472,7 @@ void GraphConstraintTest::testSimpleConstraints() {
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
 	filter.constraints.push_back(c2);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(9, wmNodeCounter.addNodeCounter);
@@ -411,6 +490,7 @@ void GraphConstraintTest::testSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no GeometricNodes"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(12, wmNodeCounter.addNodeCounter);
@@ -428,6 +508,7 @@ void GraphConstraintTest::testSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no Connections"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(15, wmNodeCounter.addNodeCounter);
@@ -445,6 +526,7 @@ void GraphConstraintTest::testSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no PointClouds"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(18, wmNodeCounter.addNodeCounter);
@@ -462,6 +544,7 @@ void GraphConstraintTest::testSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no Boxes"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(21, wmNodeCounter.addNodeCounter);
@@ -506,6 +589,7 @@ void GraphConstraintTest::testInvalidConstraints() {
 	CPPUNIT_ASSERT(!c1.validate());
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(3, wmNodeCounter.addNodeCounter);
@@ -548,6 +632,7 @@ void GraphConstraintTest::testSemanticContextConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send only Atoms"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(3, wmNodeCounter.addNodeCounter);
@@ -565,6 +650,7 @@ void GraphConstraintTest::testSemanticContextConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no Atoms from context osm"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(5, wmNodeCounter.addNodeCounter);
@@ -582,6 +668,7 @@ void GraphConstraintTest::testSemanticContextConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send only Atoms from context osm"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(6, wmNodeCounter.addNodeCounter);
@@ -600,6 +687,7 @@ void GraphConstraintTest::testSemanticContextConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no Transforms from context tf"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(9, wmNodeCounter.addNodeCounter);
@@ -618,6 +706,7 @@ void GraphConstraintTest::testSemanticContextConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no Nodes from context gis"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(11, wmNodeCounter.addNodeCounter);
@@ -636,6 +725,7 @@ void GraphConstraintTest::testSemanticContextConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send only Nodes from context gis"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(12, wmNodeCounter.addNodeCounter);
@@ -654,6 +744,7 @@ void GraphConstraintTest::testSemanticContextConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no Nodes from context "));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(15, wmNodeCounter.addNodeCounter);
@@ -697,6 +788,7 @@ void GraphConstraintTest::testDistanceConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send only Atoms with dist < 10 m from me"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(3, wmNodeCounter.addNodeCounter);
@@ -714,6 +806,7 @@ void GraphConstraintTest::testDistanceConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send only Atoms with dist > 10 m from me"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(3, wmNodeCounter.addNodeCounter);
@@ -738,6 +831,7 @@ void GraphConstraintTest::testDistanceConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send only Atoms with dist < 5 m from me"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(6, wmNodeCounter.addNodeCounter);
@@ -756,6 +850,7 @@ void GraphConstraintTest::testDistanceConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send only Atoms with dist < 6 m from me"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(9, wmNodeCounter.addNodeCounter);
@@ -776,6 +871,7 @@ void GraphConstraintTest::testDistanceConstraints() {
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
 	filter.constraints.push_back(c2);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(12, wmNodeCounter.addNodeCounter);
@@ -796,6 +892,7 @@ void GraphConstraintTest::testDistanceConstraints() {
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
 	filter.constraints.push_back(c2);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(15, wmNodeCounter.addNodeCounter);
@@ -814,6 +911,7 @@ void GraphConstraintTest::testDistanceConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no Boxes with dist < 5 m from me"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(18, wmNodeCounter.addNodeCounter);
@@ -832,6 +930,7 @@ void GraphConstraintTest::testDistanceConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no Meshes with dist > 5.5 m from me"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(21, wmNodeCounter.addNodeCounter);
@@ -860,6 +959,7 @@ void GraphConstraintTest::testDistanceConstraints() {
 	CPPUNIT_ASSERT(c1.parse(c3.str()));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(21, wmNodeCounter.addNodeCounter);
@@ -902,6 +1002,7 @@ void GraphConstraintTest::testContainmentConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no Atoms contained in me"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(0, wmNodeCounter.addNodeCounter);
@@ -919,6 +1020,7 @@ void GraphConstraintTest::testContainmentConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send only Atoms contained in me"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(3, wmNodeCounter.addNodeCounter);
@@ -960,6 +1062,7 @@ void GraphConstraintTest::testLODConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no Atoms with lod > 100"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(3, wmNodeCounter.addNodeCounter);
@@ -978,6 +1081,7 @@ void GraphConstraintTest::testLODConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send only Atoms with lod > 100"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(3, wmNodeCounter.addNodeCounter);
@@ -995,6 +1099,7 @@ void GraphConstraintTest::testLODConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send only Boxes with lod > 0.1")); // Box = 0.5
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(6, wmNodeCounter.addNodeCounter);
@@ -1012,6 +1117,7 @@ void GraphConstraintTest::testLODConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send only Boxes with lod < 0.1")); // Box = 0.5
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(9, wmNodeCounter.addNodeCounter);
@@ -1029,6 +1135,7 @@ void GraphConstraintTest::testLODConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send only Spheres with lod < 0.1")); // Box = 0.5
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(12, wmNodeCounter.addNodeCounter);
@@ -1046,6 +1153,7 @@ void GraphConstraintTest::testLODConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no GeometricNodes with lod > 0.1")); // Box = 0.5
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(15, wmNodeCounter.addNodeCounter);
@@ -1089,6 +1197,7 @@ void GraphConstraintTest::testFrequencyConstraints() {
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
 	filter.constraints.push_back(c2);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(3, wmNodeCounter.addNodeCounter);
@@ -1106,6 +1215,7 @@ void GraphConstraintTest::testFrequencyConstraints() {
 	CPPUNIT_ASSERT(c1.parse("send no TransformUpdates with freq > 100 Hz"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(6, wmNodeCounter.addNodeCounter);
@@ -1149,6 +1259,7 @@ void GraphConstraintTest::testMultiConstraints() {
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
 	filter.constraints.push_back(c2);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(3, wmNodeCounter.addNodeCounter);
@@ -1168,6 +1279,7 @@ void GraphConstraintTest::testMultiConstraints() {
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
 	filter.constraints.push_back(c2);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(6, wmNodeCounter.addNodeCounter);
@@ -1187,6 +1299,7 @@ void GraphConstraintTest::testMultiConstraints() {
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
 	filter.constraints.push_back(c2);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(8, wmNodeCounter.addNodeCounter);
@@ -1341,6 +1454,7 @@ void GraphConstraintTest::testReceiverSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive no Atoms"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(0, wmNodeCounter.addNodeCounter);
@@ -1358,6 +1472,7 @@ void GraphConstraintTest::testReceiverSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive no Nodes"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(0, wmNodeCounter.addNodeCounter);
@@ -1375,6 +1490,7 @@ void GraphConstraintTest::testReceiverSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive only Nodes"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(3, wmNodeCounter.addNodeCounter);
@@ -1392,6 +1508,7 @@ void GraphConstraintTest::testReceiverSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive no Groups"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(6, wmNodeCounter.addNodeCounter);
@@ -1409,6 +1526,7 @@ void GraphConstraintTest::testReceiverSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive only Groups"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(6, wmNodeCounter.addNodeCounter);
@@ -1426,6 +1544,7 @@ void GraphConstraintTest::testReceiverSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive no Transforms"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(9, wmNodeCounter.addNodeCounter);
@@ -1443,6 +1562,7 @@ void GraphConstraintTest::testReceiverSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive no GeometricNodes"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(12, wmNodeCounter.addNodeCounter);
@@ -1460,6 +1580,7 @@ void GraphConstraintTest::testReceiverSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive no Connections"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(15, wmNodeCounter.addNodeCounter);
@@ -1477,6 +1598,7 @@ void GraphConstraintTest::testReceiverSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive no PointClouds"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(18, wmNodeCounter.addNodeCounter);
@@ -1494,6 +1616,7 @@ void GraphConstraintTest::testReceiverSimpleConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive no Boxes"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(21, wmNodeCounter.addNodeCounter);
@@ -1535,6 +1658,7 @@ void GraphConstraintTest::testReceiverSemanticContextConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive only Atoms"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(3, wmNodeCounter.addNodeCounter);
@@ -1552,6 +1676,7 @@ void GraphConstraintTest::testReceiverSemanticContextConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive no Atoms from context osm"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(5, wmNodeCounter.addNodeCounter);
@@ -1569,6 +1694,7 @@ void GraphConstraintTest::testReceiverSemanticContextConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive only Atoms from context osm"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(6, wmNodeCounter.addNodeCounter);
@@ -1587,6 +1713,7 @@ void GraphConstraintTest::testReceiverSemanticContextConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive no Transforms from context tf"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(9, wmNodeCounter.addNodeCounter);
@@ -1605,6 +1732,7 @@ void GraphConstraintTest::testReceiverSemanticContextConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive no Nodes from context gis"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(11, wmNodeCounter.addNodeCounter);
@@ -1623,6 +1751,7 @@ void GraphConstraintTest::testReceiverSemanticContextConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive only Nodes from context gis"));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(12, wmNodeCounter.addNodeCounter);
@@ -1641,6 +1770,7 @@ void GraphConstraintTest::testReceiverSemanticContextConstraints() {
 	CPPUNIT_ASSERT(c1.parse("receive no Nodes from context "));
 	filter.constraints.clear();
 	filter.constraints.push_back(c1);
+	filter.constraintsChanged();
 	CPPUNIT_ASSERT(runAddAllSceneGraphPrimitives(wm));
 
 	CPPUNIT_ASSERT_EQUAL(15, wmNodeCounter.addNodeCounter);
@@ -1735,6 +1865,217 @@ bool GraphConstraintTest::runAddAllSceneGraphPrimitives(brics_3d::WorldModel* wm
 }
 
 
+void GraphConstraintTest::testDistanceConstraintEvaluator() {
+	WorldModel* wm = new WorldModel();
+	vector<Attribute> attributes;
+	double distance = -1.0;
+	double maxTolerance = 0.00001;
+
+	/*
+	 * root
+	 *  |-- tfA (1,0,0) -- referenceGroup
+	 *  |-- tfB (4,4,0) -- node
+	 */
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transformA(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 1,0,0));
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transformB(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 4,4,0));
+	Id tfAId;
+	Id tfBId;
+	Id referenceGroupId;
+	Id nodeId;
+	CPPUNIT_ASSERT(wm->scene.addTransformNode(wm->getRootNodeId(), tfAId, attributes, transformA, wm->now()));
+	CPPUNIT_ASSERT(wm->scene.addTransformNode(wm->getRootNodeId(), tfBId, attributes, transformB, wm->now()));
+	CPPUNIT_ASSERT(wm->scene.addGroup(tfAId, referenceGroupId, attributes));
+	CPPUNIT_ASSERT(wm->scene.addNode(tfBId, nodeId, attributes));
+
+	stringstream model("");
+	model << "send no Atoms with dist > 1 m from " << referenceGroupId;
+	GraphConstraint fromReference;
+	CPPUNIT_ASSERT(fromReference.parse(model.str()));
+	GraphConstraint fromMe;
+	CPPUNIT_ASSERT(fromMe.parse("send no Atoms with dist > 1 m from me"));
+	std::vector<GraphConstraint> constraints;
+	constraints.push_back(fromReference);
+	constraints.push_back(fromMe);
+
+	DistanceConstraintEvaluator evaluator(wm);
+	CPPUNIT_ASSERT(evaluator.getReferenceNode(fromReference) == referenceGroupId);
+	CPPUNIT_ASSERT(evaluator.getReferenceNode(fromMe) == wm->getRootNodeId());
+	evaluator.resolveReferenceNodes(constraints);
+	CPPUNIT_ASSERT_EQUAL(2u, evaluator.getReferenceTransformComputations());
+
+	CPPUNIT_ASSERT(evaluator.computeDistance(fromReference, nodeId, distance));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0, distance, maxTolerance);
+	CPPUNIT_ASSERT(evaluator.computeDistance(fromMe, nodeId, distance));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(sqrt(32.0), distance, maxTolerance);
+	CPPUNIT_ASSERT(evaluator.computeDistance(fromReference, referenceGroupId, distance));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, distance, maxTolerance);
+	CPPUNIT_ASSERT_EQUAL(2u, evaluator.getReferenceTransformComputations()); // nothing to recompute
+
+	/* update of an unrelated transform */
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transformB2(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 1,4,0));
+	CPPUNIT_ASSERT(wm->scene.setTransform(tfBId, transformB2, wm->now()));
+	evaluator.transformChanged(tfBId);
+	CPPUNIT_ASSERT(evaluator.computeDistance(fromReference, nodeId, distance));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(4.0, distance, maxTolerance);
+	CPPUNIT_ASSERT_EQUAL(2u, evaluator.getReferenceTransformComputations());
+
+	/* update of an ancestor of the reference node */
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transformA2(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 1,1,0));
+	CPPUNIT_ASSERT(wm->scene.setTransform(tfAId, transformA2, wm->now()));
+	evaluator.transformChanged(tfAId);
+	CPPUNIT_ASSERT(evaluator.computeDistance(fromReference, nodeId, distance));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, distance, maxTolerance);
+	CPPUNIT_ASSERT(evaluator.computeDistance(fromMe, nodeId, distance));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(sqrt(17.0), distance, maxTolerance);
+	CPPUNIT_ASSERT_EQUAL(3u, evaluator.getReferenceTransformComputations()); // only one reference is affected
+
+	/* rotated reference node: the distance does not depend on the orientation */
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transformA3(new HomogeneousMatrix44(0,-1,0, 1,0,0, 0,0,1, 1,1,0));
+	CPPUNIT_ASSERT(wm->scene.setTransform(tfAId, transformA3, wm->now()));
+	evaluator.transformChanged(tfAId);
+	CPPUNIT_ASSERT(evaluator.computeDistance(fromReference, nodeId, distance));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, distance, maxTolerance);
+	CPPUNIT_ASSERT_EQUAL(4u, evaluator.getReferenceTransformComputations());
+
+	/* structural changes */
+	CPPUNIT_ASSERT(wm->scene.deleteNode(referenceGroupId));
+	evaluator.structureChanged(referenceGroupId);
+	CPPUNIT_ASSERT(!evaluator.computeDistance(fromReference, nodeId, distance));
+	CPPUNIT_ASSERT(evaluator.computeDistance(fromMe, nodeId, distance));
+	CPPUNIT_ASSERT(!evaluator.computeDistance(fromMe, referenceGroupId, distance));
+
+	/* references that are not part of the constraints anymore are removed */
+	constraints.clear();
+	evaluator.resolveReferenceNodes(constraints);
+	CPPUNIT_ASSERT(evaluator.computeDistance(fromMe, nodeId, distance)); // resolved on the fly
+	CPPUNIT_ASSERT_EQUAL(5u, evaluator.getReferenceTransformComputations());
+
+	delete wm;
+}
+
+void GraphConstraintTest::testLODCalculator() {
+	LODCalculator lodCalculator;
+	double lod = -1.0;
+	double maxTolerance = 0.00001;
+
+	rsg::Box::BoxPtr box(new rsg::Box(1,2,3));
+	CPPUNIT_ASSERT(lodCalculator.calculateLOD(box, lod));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, lod, maxTolerance);
+
+	rsg::Sphere::SpherePtr sphere(new rsg::Sphere(1.0));
+	CPPUNIT_ASSERT(lodCalculator.calculateLOD(sphere, lod));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0 / (4.0 * M_PI), lod, maxTolerance);
+
+	rsg::Cylinder::CylinderPtr zeroCylinder(new rsg::Cylinder(0.0, 1.0));
+	CPPUNIT_ASSERT(lodCalculator.calculateLOD(zeroCylinder, lod));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, lod, maxTolerance);
+
+	rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr pointCloud(new rsg::PointCloud<brics_3d::PointCloud3D>());
+	pointCloud->data = brics_3d::PointCloud3D::PointCloud3DPtr(new brics_3d::PointCloud3D());
+	pointCloud->data->addPoint(Point3D(1,2,3));
+	pointCloud->data->addPoint(Point3D(4,5,6));
+	pointCloud->data->addPoint(Point3D(7,8,9));
+	CPPUNIT_ASSERT(lodCalculator.calculateLOD(pointCloud, lod));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, lod, maxTolerance); // number of points
+
+	rsg::Mesh<brics_3d::ITriangleMesh>::MeshPtr mesh(new rsg::Mesh<brics_3d::ITriangleMesh>());
+	mesh->data = boost::shared_ptr<brics_3d::ITriangleMesh>(new brics_3d::TriangleMeshExplicit());
+	CPPUNIT_ASSERT(lodCalculator.calculateLOD(mesh, lod));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, lod, maxTolerance);
+
+	CPPUNIT_ASSERT(!lodCalculator.calculateLOD(rsg::Shape::ShapePtr(), lod));
+}
+
+void GraphConstraintTest::testGraphConstraintPolicy() {
+	WorldModel* wm = new WorldModel();
+	GraphConstraintUpdateFilter filter(wm);
+	Id referenceId;
+	vector<Attribute> attributes;
+	attributes.push_back(Attribute("osm:name", "building"));
+	CPPUNIT_ASSERT(wm->scene.addGroup(wm->getRootNodeId(), referenceId, attributes));
+
+	stringstream distanceModel("");
+	distanceModel << "send no Atoms with dist > 1 m from " << referenceId;
+	std::vector<std::string> models;
+	models.push_back("send no Boxes with lod > 0.1");          // 0
+	models.push_back("send only Transforms");                  // 1
+	models.push_back("receive no Nodes");                      // 2
+	models.push_back("send no Atoms from context osm");        // 3
+	models.push_back(distanceModel.str());                     // 4
+	models.push_back("send only Atoms contained in me");       // 5
+	models.push_back("send no Groups with freq > 5 Hz");       // 6
+	models.push_back("send only Atoms");                       // 7
+
+	std::vector<GraphConstraint> constraints;
+	for (unsigned int i = 0; i < models.size(); ++i) {
+		GraphConstraint constraint;
+		CPPUNIT_ASSERT(constraint.parse(models[i]));
+		constraints.push_back(constraint);
+	}
+
+	GraphConstraintPolicy policy;
+	policy.compile(constraints, GraphConstraint::SEND, wm->getRootNodeId());
+	CPPUNIT_ASSERT(policy.isCompiledFrom(constraints, GraphConstraint::SEND, wm->getRootNodeId()));
+	CPPUNIT_ASSERT(!policy.isCompiledFrom(constraints, GraphConstraint::RECEIVE, wm->getRootNodeId()));
+
+	/* dispatch table */
+	const std::vector<unsigned int>& boxConstraints = policy.getApplicableConstraints(GraphConstraint::Box);
+	CPPUNIT_ASSERT_EQUAL(5u, static_cast<unsigned int>(boxConstraints.size()));
+	CPPUNIT_ASSERT_EQUAL(0u, boxConstraints[0]);
+	CPPUNIT_ASSERT_EQUAL(1u, boxConstraints[1]);
+	CPPUNIT_ASSERT_EQUAL(3u, boxConstraints[2]);
+	CPPUNIT_ASSERT_EQUAL(4u, boxConstraints[3]);
+	CPPUNIT_ASSERT_EQUAL(5u, boxConstraints[4]);
+	const std::vector<unsigned int>& transformConstraints = policy.getApplicableConstraints(GraphConstraint::Transform);
+	CPPUNIT_ASSERT_EQUAL(3u, static_cast<unsigned int>(transformConstraints.size())); // context, distance and containment
+	const std::vector<unsigned int>& groupConstraints = policy.getApplicableConstraints(GraphConstraint::Group);
+	CPPUNIT_ASSERT_EQUAL(5u, static_cast<unsigned int>(groupConstraints.size()));
+	CPPUNIT_ASSERT_EQUAL(6u, groupConstraints[4]);
+	CPPUNIT_ASSERT(policy.requiresLOD(GraphConstraint::Box));
+	CPPUNIT_ASSERT(!policy.requiresLOD(GraphConstraint::GeometricNode));
+	CPPUNIT_ASSERT(!policy.requiresLOD(static_cast<GraphConstraint::Type>(42))); // invalid types are handled as undefined
+	CPPUNIT_ASSERT_EQUAL(4u, static_cast<unsigned int>(policy.getApplicableConstraints(static_cast<GraphConstraint::Type>(42)).size()));
+
+	/* resolved IDs and contexts */
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(policy.getReferenceNodes().size()));
+	CPPUNIT_ASSERT(policy.getReferenceNode(4) == referenceId);
+	CPPUNIT_ASSERT(policy.getReferenceNode(5) == wm->getRootNodeId());
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(policy.getContexts().size()));
+	CPPUNIT_ASSERT(policy.getContextQuery(3).matches(attributes));
+
+	/* The dispatch table must not skip any constraint that could fail */
+	for (unsigned int type = 0; type < GraphConstraint::TYPE_NR_ITEMS; ++type) {
+		for (unsigned int i = 0; i < constraints.size(); ++i) {
+			if (!GraphConstraintPolicy::appliesTo(constraints[i], GraphConstraint::SEND, static_cast<GraphConstraint::Type>(type))) {
+				CPPUNIT_ASSERT(filter.checkConstraint(constraints[i], static_cast<GraphConstraint::Type>(type), 1000, 1000, 1000, referenceId, attributes));
+				CPPUNIT_ASSERT(filter.checkConstraint(constraints[i], static_cast<GraphConstraint::Type>(type), 0, 0, 0, wm->getRootNodeId(), vector<Attribute>()));
+			}
+		}
+	}
+
+	/* The receiver ignores the send constraints */
+	policy.compile(constraints, GraphConstraint::RECEIVE, wm->getRootNodeId());
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(policy.getApplicableConstraints(GraphConstraint::Node).size()));
+	CPPUNIT_ASSERT_EQUAL(0u, static_cast<unsigned int>(policy.getApplicableConstraints(GraphConstraint::Box).size()));
+	CPPUNIT_ASSERT_EQUAL(0u, static_cast<unsigned int>(policy.getReferenceNodes().size()));
+
+	/* Changes of the filter constraints are picked up */
+	Id nodeId;
+	MyObserver wmNodeCounter;
+	wm->scene.attachUpdateObserver(&filter);
+	filter.attachUpdateObserver(&wmNodeCounter);
+	filter.constraints = constraints;
+	filter.constraintsChanged();
+	CPPUNIT_ASSERT(wm->scene.addNode(referenceId, nodeId, vector<Attribute>()));
+	CPPUNIT_ASSERT_EQUAL(0, wmNodeCounter.addNodeCounter); // only Transforms
+	filter.constraints.clear();
+	filter.constraintsChanged();
+	CPPUNIT_ASSERT(wm->scene.addNode(referenceId, nodeId, vector<Attribute>()));
+	CPPUNIT_ASSERT_EQUAL(1, wmNodeCounter.addNodeCounter);
+
+	delete wm;
+}
+
 }  // namespace unitTests
 
 
@@ -37,6 +37,7 @@ class GraphConstraintTest : public CPPUNIT_NS::TestFixture {
 	CPPUNIT_TEST( testParser );
 	CPPUNIT_TEST( testNoConstraints );
 	CPPUNIT_TEST( testNoInputConstraints );
+	CPPUNIT_TEST( testReceiverDistanceConstraints );
 	CPPUNIT_TEST( testSimpleConstraints );
 	CPPUNIT_TEST( testInvalidConstraints );
 	CPPUNIT_TEST( testSemanticContextConstraints );
@@ -48,6 +49,9 @@ class GraphConstraintTest : public CPPUNIT_NS::TestFixture {
 	CPPUNIT_TEST( testConstraintsAsAttributes );
 	CPPUNIT_TEST( testReceiverSimpleConstraints );
 	CPPUNIT_TEST( testReceiverSemanticContextConstraints );
+	CPPUNIT_TEST( testDistanceConstraintEvaluator );
+	CPPUNIT_TEST( testLODCalculator );
+	CPPUNIT_TEST( testGraphConstraintPolicy );
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -58,6 +62,7 @@ public:
 	void testParser();
 	void testNoConstraints();
 	void testNoInputConstraints();
+	void testReceiverDistanceConstraints();
 	void testSimpleConstraints();
 	void testInvalidConstraints();
 	void testSemanticContextConstraints();
@@ -69,6 +74,9 @@ public:
 	void testConstraintsAsAttributes();
 	void testReceiverSimpleConstraints();
 	void testReceiverSemanticContextConstraints();
+	void testDistanceConstraintEvaluator();
+	void testLODCalculator();
+	void testGraphConstraintPolicy();
 
 private:
 	/// Maximum deviation for equality check of double variables
@@ -27,6 +27,7 @@
 #include <brics_3d/worldModel/sceneGraph/HDF5UpdateSerializer.h>
 #include <brics_3d/worldModel/sceneGraph/HDF5UpdateDeserializer.h>
 #include <brics_3d/worldModel/sceneGraph/HDF5AppendOnlyLogger.h>
+#include <brics_3d/worldModel/sceneGraph/HDF5LogReplayer.h>
 #include <brics_3d/worldModel/sceneGraph/DotVisualizer.h>
 #include <brics_3d/util/HDF5Typecaster.h>
 #include <hdf5.h>
@@ -856,6 +857,445 @@ void HDF5Test::testLogger() {
 
 }
 
+void HDF5Test::testUpdateBatch() {
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel(); 		   // first world model agent
+	brics_3d::WorldModel* wmReplica = new brics_3d::WorldModel(); // second world model agent
+
+	brics_3d::rsg::HDF5UpdateDeserializer* wmUpdatesToDeserializer = new brics_3d::rsg::HDF5UpdateDeserializer(wmReplica);
+	HSDF5SimleBridge* feedForwardBridge = new HSDF5SimleBridge(wmUpdatesToDeserializer);
+	brics_3d::rsg::HDF5UpdateSerializer* wmUpdatesToSerializer = new brics_3d::rsg::HDF5UpdateSerializer(feedForwardBridge);
+	wm->scene.attachUpdateObserver(wmUpdatesToSerializer);
+
+	MyObserver wmNodeCounter;
+	MyObserver remoteWmNodeCounter;
+	wm->scene.attachUpdateObserver(&wmNodeCounter);
+	wmReplica->scene.attachUpdateObserver(&remoteWmNodeCounter);
+
+	vector<Attribute> dummyAttributes;
+	vector<Attribute> attributes;
+	attributes.push_back(Attribute("name","batch_node"));
+	vector<Id> resultIds;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform123(new HomogeneousMatrix44(1,0,0,  	//Rotation coefficients
+	                                                             0,1,0,
+	                                                             0,0,1,
+	                                                             1,2,3)); 						//Translation coefficients
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr resultTransform;
+
+	/* Manually "mount" first wm relative to second one */
+	wmReplica->scene.addRemoteRootNode(wm->getRootNodeId(), dummyAttributes);
+	wmReplica->scene.addParent(wm->getRootNodeId(), wmReplica->getRootNodeId());
+
+	/* Record a batch */
+	rsg::SceneGraphUpdateBatch batch;
+	Id groupId;
+	Id tfId;
+	Id geodeId;
+	Cylinder::CylinderPtr cylinder(new Cylinder(0.2,0.1));
+	CPPUNIT_ASSERT(batch.addGroup(wm->getRootNodeId(), groupId, attributes));
+	CPPUNIT_ASSERT(batch.addTransformNode(groupId, tfId, attributes, transform123, wm->now()));
+	CPPUNIT_ASSERT(batch.addGeometricNode(tfId, geodeId, attributes, cylinder, wm->now()));
+	CPPUNIT_ASSERT(batch.setNodeAttributes(groupId, dummyAttributes));
+
+	CPPUNIT_ASSERT(wm->scene.applyUpdateBatch(batch));
+	CPPUNIT_ASSERT_EQUAL(1, wmNodeCounter.applyUpdateBatchCounter);
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.applyUpdateBatchCounter); // a single message has been received
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addGroupCounter);
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addTransformCounter);
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addGeometricNodeCounter);
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.setNodeAttributesCounter);
+
+	CPPUNIT_ASSERT(wmReplica->scene.getNodes(attributes, resultIds));
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(resultIds.size())); // the group has no attributes anymore
+	CPPUNIT_ASSERT(wmReplica->scene.getTransform(tfId, wm->now(), resultTransform));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(2.0, resultTransform->getRawData()[13], maxTolerance);
+
+	delete wmUpdatesToSerializer;
+	delete feedForwardBridge;
+	delete wmUpdatesToDeserializer;
+	delete wmReplica;
+	delete wm;
+}
+
+/*
+ * Feeds forward like the HSDF5SimleBridge, but memorizes the size of the last message.
+ */
+class HDF5SizeRecordingBridge : public brics_3d::rsg::IOutputPort {
+public:
+	HDF5SizeRecordingBridge(brics_3d::rsg::IInputPort* inputPort) : inputPort(inputPort), lastMessageSize(0) {};
+	virtual ~HDF5SizeRecordingBridge(){};
+
+	int write(const char *dataBuffer, int dataLength, int &transferredBytes) {
+		lastMessageSize = dataLength;
+		return inputPort->write(dataBuffer, dataLength, transferredBytes);
+	};
+
+	brics_3d::rsg::IInputPort* inputPort;
+	int lastMessageSize;
+};
+
+void HDF5Test::testPointCloudStorage() {
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel();
+	brics_3d::WorldModel* wmReplica = new brics_3d::WorldModel();
+
+	brics_3d::rsg::HDF5UpdateDeserializer* wmUpdatesToDeserializer = new brics_3d::rsg::HDF5UpdateDeserializer(wmReplica);
+	HDF5SizeRecordingBridge* feedForwardBridge = new HDF5SizeRecordingBridge(wmUpdatesToDeserializer);
+	brics_3d::rsg::HDF5UpdateSerializer* wmUpdatesToSerializer = new brics_3d::rsg::HDF5UpdateSerializer(feedForwardBridge);
+	wm->scene.attachUpdateObserver(wmUpdatesToSerializer);
+
+	vector<Attribute> dummyAttributes;
+	wmReplica->scene.addRemoteRootNode(wm->getRootNodeId(), dummyAttributes);
+	wmReplica->scene.addParent(wm->getRootNodeId(), wmReplica->getRootNodeId());
+
+	/* 400k points do not fit on the stack as a whole (12.8 MB) */
+	brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr pointCloudContainer(new brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>());
+	pointCloudContainer->data = brics_3d::PointCloud3D::PointCloud3DPtr(new brics_3d::PointCloud3D());
+	const int numberOfPoints = 400000;
+	for (int i = 0; i < numberOfPoints; ++i) {
+		pointCloudContainer->data->addPoint(Point3D(0.01 * (i % 100), 0.01 * ((i / 100) % 100), 0.01 * (i / 10000)));
+	}
+
+	Shape::ShapePtr resultShape;
+	TimeStamp resultTime;
+	brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr resultPointCloud;
+
+	/* Default: double precision, uncompressed */
+	Id pointCloudId;
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(wm->getRootNodeId(), pointCloudId, dummyAttributes, pointCloudContainer, wm->now()));
+	int uncompressedSize = feedForwardBridge->lastMessageSize;
+	CPPUNIT_ASSERT(uncompressedSize > numberOfPoints * 27);
+	CPPUNIT_ASSERT(wmReplica->scene.getGeometry(pointCloudId, resultShape, resultTime));
+	resultPointCloud = boost::dynamic_pointer_cast<brics_3d::rsg::PointCloud<brics_3d::PointCloud3D> >(resultShape);
+	CPPUNIT_ASSERT(resultPointCloud != 0);
+	CPPUNIT_ASSERT_EQUAL(static_cast<unsigned int>(numberOfPoints), resultPointCloud->data->getSize());
+	CPPUNIT_ASSERT_EQUAL(0.01 * 99, (*resultPointCloud->data->getPointCloud())[numberOfPoints - 1].getX());
+	CPPUNIT_ASSERT_EQUAL(0.01 * 39, (*resultPointCloud->data->getPointCloud())[numberOfPoints - 1].getZ());
+
+	/* Single precision with shuffle and deflate */
+	HDF5Typecaster::PointCloudStorageOptions options;
+	options.useSinglePrecision = true;
+	options.compressionLevel = 6;
+	options.useShuffle = true;
+	options.chunkSize = 1000;
+	wmUpdatesToSerializer->setPointCloudStorageOptions(options);
+	Id compressedPointCloudId;
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(wm->getRootNodeId(), compressedPointCloudId, dummyAttributes, pointCloudContainer, wm->now()));
+	int compressedSize = feedForwardBridge->lastMessageSize;
+	LOG(INFO) << "HDF5Test::testPointCloudStorage: uncompressed = " << uncompressedSize << " bytes, compressed = " << compressedSize << " bytes";
+	CPPUNIT_ASSERT(compressedSize * 3 < uncompressedSize);
+	CPPUNIT_ASSERT(wmReplica->scene.getGeometry(compressedPointCloudId, resultShape, resultTime));
+	resultPointCloud = boost::dynamic_pointer_cast<brics_3d::rsg::PointCloud<brics_3d::PointCloud3D> >(resultShape);
+	CPPUNIT_ASSERT(resultPointCloud != 0);
+	CPPUNIT_ASSERT_EQUAL(static_cast<unsigned int>(numberOfPoints), resultPointCloud->data->getSize());
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.01 * 99, (*resultPointCloud->data->getPointCloud())[numberOfPoints - 1].getX(), maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.01 * 39, (*resultPointCloud->data->getPointCloud())[numberOfPoints - 1].getZ(), maxTolerance);
+
+	/* Empty point clouds */
+	brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr emptyPointCloudContainer(new brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>());
+	emptyPointCloudContainer->data = brics_3d::PointCloud3D::PointCloud3DPtr(new brics_3d::PointCloud3D());
+	Id emptyPointCloudId;
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(wm->getRootNodeId(), emptyPointCloudId, dummyAttributes, emptyPointCloudContainer, wm->now()));
+	CPPUNIT_ASSERT(wmReplica->scene.getGeometry(emptyPointCloudId, resultShape, resultTime));
+	resultPointCloud = boost::dynamic_pointer_cast<brics_3d::rsg::PointCloud<brics_3d::PointCloud3D> >(resultShape);
+	CPPUNIT_ASSERT(resultPointCloud != 0);
+	CPPUNIT_ASSERT_EQUAL(0u, resultPointCloud->data->getSize());
+
+	/* Small point clouds do not allocate a full chunk */
+	wmUpdatesToSerializer->setPointCloudStorageOptions(HDF5Typecaster::PointCloudStorageOptions());
+	brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr smallPointCloudContainer(new brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>());
+	smallPointCloudContainer->data = brics_3d::PointCloud3D::PointCloud3DPtr(new brics_3d::PointCloud3D());
+	for (int i = 0; i < 10; ++i) {
+		smallPointCloudContainer->data->addPoint(Point3D(i, 2 * i, 3 * i));
+	}
+	Id smallPointCloudId;
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(wm->getRootNodeId(), smallPointCloudId, dummyAttributes, smallPointCloudContainer, wm->now()));
+	int smallSize = feedForwardBridge->lastMessageSize;
+	LOG(INFO) << "HDF5Test::testPointCloudStorage: 10 points = " << smallSize << " bytes";
+	CPPUNIT_ASSERT(smallSize < static_cast<int>(HDF5Typecaster::PointCloudStorageOptions().chunkSize * sizeof(HDF5Typecaster::point_cloud_xyzrgb_data_t)));
+	CPPUNIT_ASSERT(wmReplica->scene.getGeometry(smallPointCloudId, resultShape, resultTime));
+	resultPointCloud = boost::dynamic_pointer_cast<brics_3d::rsg::PointCloud<brics_3d::PointCloud3D> >(resultShape);
+	CPPUNIT_ASSERT(resultPointCloud != 0);
+	CPPUNIT_ASSERT_EQUAL(10u, resultPointCloud->data->getSize());
+	CPPUNIT_ASSERT_EQUAL(27.0, (*resultPointCloud->data->getPointCloud())[9].getZ());
+
+	delete wmUpdatesToSerializer;
+	delete feedForwardBridge;
+	delete wmUpdatesToDeserializer;
+	delete wmReplica;
+	delete wm;
+}
+
+void HDF5Test::testUpdateTableLogger() {
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel();
+	std::string logFileName = "rsg-update-table-log-test.h5";
+
+	brics_3d::rsg::HDF5AppendOnlyLogger* logger = new brics_3d::rsg::HDF5AppendOnlyLogger(wm, logFileName, brics_3d::rsg::HDF5AppendOnlyLogger::UPDATE_TABLES);
+	CPPUNIT_ASSERT(logger->getLogMode() == brics_3d::rsg::HDF5AppendOnlyLogger::UPDATE_TABLES);
+	logger->setStagingBufferSize(2048, 64); // small buffer to provoke back pressure
+	wm->scene.attachUpdateObserver(logger);
+
+	vector<Attribute> dummyAttributes;
+	vector<Attribute> attributes;
+	attributes.push_back(Attribute("name","table_log_group"));
+
+	Id groupId;
+	CPPUNIT_ASSERT(wm->scene.addGroup(wm->getRootNodeId(), groupId, attributes));
+
+	Id tfId;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44());
+	CPPUNIT_ASSERT(wm->scene.addTransformNode(groupId, tfId, dummyAttributes, transform, wm->now()));
+
+	rsg::Box::BoxPtr box( new rsg::Box(1,2,3));
+	Id boxId;
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(tfId, boxId, dummyAttributes, box, wm->now()));
+
+	Id deletedNodeId;
+	CPPUNIT_ASSERT(wm->scene.addNode(groupId, deletedNodeId, dummyAttributes));
+	CPPUNIT_ASSERT(wm->scene.deleteNode(deletedNodeId));
+
+	/* A stream of transforms that exceeds the staging buffer many times */
+	const int numberOfTransforms = 2000;
+	TimeStamp start = wm->now();
+	for (int i = 1; i <= numberOfTransforms; ++i) {
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr update(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, i,0,0));
+		CPPUNIT_ASSERT(wm->scene.setTransform(tfId, update, start + TimeStamp(i, Units::MilliSecond)));
+	}
+
+	rsg::SceneGraphUpdateBatch batch;
+	Id batchNodeId;
+	CPPUNIT_ASSERT(batch.addNode(groupId, batchNodeId, attributes));
+	CPPUNIT_ASSERT(wm->scene.applyUpdateBatch(batch));
+
+	logger->flush();
+	delete logger; // closes the file
+
+	/* Replay into a replica with the same root Id */
+	Id rootId = brics_3d::rsg::HDF5UpdateDeserializer::getRootIdFromAppendOnlyLogFile(logFileName);
+	CPPUNIT_ASSERT(rootId == wm->getRootNodeId());
+	brics_3d::WorldModel* wmReplica = new brics_3d::WorldModel(new UuidGenerator(rootId));
+	MyObserver replicaCounter;
+	wmReplica->scene.attachUpdateObserver(&replicaCounter);
+	brics_3d::rsg::HDF5UpdateDeserializer* deserializer = new brics_3d::rsg::HDF5UpdateDeserializer(wmReplica);
+	CPPUNIT_ASSERT(deserializer->loadFromAppendOnlyLogFile(logFileName));
+
+	CPPUNIT_ASSERT_EQUAL(1, replicaCounter.addGroupCounter);
+	CPPUNIT_ASSERT_EQUAL(1, replicaCounter.addTransformCounter);
+	CPPUNIT_ASSERT_EQUAL(1, replicaCounter.addGeometricNodeCounter);
+	CPPUNIT_ASSERT_EQUAL(1, replicaCounter.deleteNodeCounter);
+	CPPUNIT_ASSERT_EQUAL(numberOfTransforms, replicaCounter.setTransformCounter);
+	CPPUNIT_ASSERT_EQUAL(1, replicaCounter.applyUpdateBatchCounter);
+
+	vector<Attribute> resultAttributes;
+	CPPUNIT_ASSERT(wmReplica->scene.getNodeAttributes(groupId, resultAttributes));
+	CPPUNIT_ASSERT(resultAttributes.size() == 1u);
+	CPPUNIT_ASSERT(wmReplica->scene.getNodeAttributes(batchNodeId, resultAttributes));
+	CPPUNIT_ASSERT(!wmReplica->scene.getNodeAttributes(deletedNodeId, resultAttributes));
+
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr resultTransform;
+	CPPUNIT_ASSERT(wmReplica->scene.getTransform(tfId, start + TimeStamp(numberOfTransforms, Units::MilliSecond), resultTransform));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(numberOfTransforms, resultTransform->getRawData()[12], maxTolerance);
+
+	Shape::ShapePtr resultShape;
+	TimeStamp resultTime;
+	CPPUNIT_ASSERT(wmReplica->scene.getGeometry(boxId, resultShape, resultTime));
+	rsg::Box::BoxPtr resultBox = boost::dynamic_pointer_cast<rsg::Box>(resultShape);
+	CPPUNIT_ASSERT(resultBox != 0);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, resultBox->getSizeZ(), maxTolerance);
+
+	delete deserializer;
+	delete wmReplica;
+	delete wm;
+}
+
+void HDF5Test::testLogReplayer() {
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel();
+	std::string logFileName = "rsg-log-replayer-test.h5";
+	brics_3d::rsg::HDF5AppendOnlyLogger* logger = new brics_3d::rsg::HDF5AppendOnlyLogger(wm, logFileName, brics_3d::rsg::HDF5AppendOnlyLogger::UPDATE_TABLES);
+	logger->setKeyframeInterval(0); // only explicit keyframes
+	wm->scene.attachUpdateObserver(logger);
+
+	vector<Attribute> dummyAttributes;
+	Id groupId;
+	CPPUNIT_ASSERT(wm->scene.addGroup(wm->getRootNodeId(), groupId, dummyAttributes));
+	Id tfId;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44());
+	TimeStamp start = wm->now();
+	CPPUNIT_ASSERT(wm->scene.addTransformNode(groupId, tfId, dummyAttributes, transform, start));
+
+	for (int i = 1; i <= 50; ++i) {
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr update(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, i,0,0));
+		CPPUNIT_ASSERT(wm->scene.setTransform(tfId, update, start + TimeStamp(i, Units::MilliSecond)));
+	}
+	CPPUNIT_ASSERT(logger->logKeyframe());
+	TimeStamp middle = wm->now();
+
+	Id lateNodeId;
+	CPPUNIT_ASSERT(wm->scene.addNode(groupId, lateNodeId, dummyAttributes));
+	for (int i = 51; i <= 100; ++i) {
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr update(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, i,0,0));
+		CPPUNIT_ASSERT(wm->scene.setTransform(tfId, update, start + TimeStamp(i, Units::MilliSecond)));
+	}
+	delete logger;
+
+	Id rootId = wm->getRootNodeId();
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr resultTransform;
+	vector<Attribute> resultAttributes;
+
+	/* Seek with a keyframe, then replay the rest */
+	brics_3d::WorldModel* wmReplica = new brics_3d::WorldModel(new UuidGenerator(rootId));
+	MyObserver replicaCounter;
+	wmReplica->scene.attachUpdateObserver(&replicaCounter);
+	brics_3d::rsg::HDF5LogReplayer* replayer = new brics_3d::rsg::HDF5LogReplayer(wmReplica);
+	CPPUNIT_ASSERT(replayer->open(logFileName));
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(103), replayer->getNumberOfUpdates());
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(1), replayer->getNumberOfKeyframes());
+	CPPUNIT_ASSERT(replayer->getStartStamp() <= replayer->getKeyframeStamp(0));
+	CPPUNIT_ASSERT(replayer->getKeyframeStamp(0) <= replayer->getEndStamp());
+
+	CPPUNIT_ASSERT(replayer->seek(middle));
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(52), replayer->getPosition());
+	CPPUNIT_ASSERT_EQUAL(0, replicaCounter.setTransformCounter); // all 50 transforms are skipped by the keyframe
+	CPPUNIT_ASSERT(wmReplica->scene.getTransform(tfId, start + TimeStamp(1, Units::Second), resultTransform));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(50.0, resultTransform->getRawData()[12], maxTolerance);
+	CPPUNIT_ASSERT(!wmReplica->scene.getNodeAttributes(lateNodeId, resultAttributes));
+
+	CPPUNIT_ASSERT(!replayer->seek(start)); // backwards
+
+	CPPUNIT_ASSERT(replayer->replay(replayer->getEndStamp(), 1000.0));
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(103), replayer->getPosition());
+	CPPUNIT_ASSERT(replayer->getCurrentStamp() == replayer->getEndStamp());
+	CPPUNIT_ASSERT_EQUAL(50, replicaCounter.setTransformCounter);
+	CPPUNIT_ASSERT(wmReplica->scene.getNodeAttributes(lateNodeId, resultAttributes));
+	CPPUNIT_ASSERT(wmReplica->scene.getTransform(tfId, start + TimeStamp(1, Units::Second), resultTransform));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(100.0, resultTransform->getRawData()[12], maxTolerance);
+	delete replayer;
+	delete wmReplica;
+
+	/* Without keyframe: a time window replays all updates up to its end */
+	wmReplica = new brics_3d::WorldModel(new UuidGenerator(rootId));
+	MyObserver windowCounter;
+	wmReplica->scene.attachUpdateObserver(&windowCounter);
+	replayer = new brics_3d::rsg::HDF5LogReplayer(wmReplica);
+	CPPUNIT_ASSERT(replayer->open(logFileName));
+	CPPUNIT_ASSERT(replayer->jumpToKeyframe(0));
+	CPPUNIT_ASSERT(!replayer->jumpToKeyframe(1));
+	CPPUNIT_ASSERT(replayer->replayWindow(middle, replayer->getEndStamp()));
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(103), replayer->getPosition());
+	CPPUNIT_ASSERT_EQUAL(50, windowCounter.setTransformCounter);
+	delete replayer;
+	delete wmReplica;
+
+	/* A keyframe that cannot be applied is an error and does not advance the position */
+	wmReplica = new brics_3d::WorldModel(); // other root id than the log
+	replayer = new brics_3d::rsg::HDF5LogReplayer(wmReplica);
+	CPPUNIT_ASSERT(replayer->open(logFileName));
+	CPPUNIT_ASSERT(!replayer->jumpToKeyframe(0));
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), replayer->getPosition());
+	CPPUNIT_ASSERT(!replayer->seek(middle));
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), replayer->getPosition());
+	CPPUNIT_ASSERT(!wmReplica->scene.getNodeAttributes(groupId, resultAttributes));
+	delete replayer;
+	delete wmReplica;
+
+	/* Index of a log in the GROUP_PER_UPDATE format is built on open */
+	std::string groupLogFileName = "rsg-log-replayer-group-test.h5";
+	brics_3d::WorldModel* wmGroupLog = new brics_3d::WorldModel();
+	logger = new brics_3d::rsg::HDF5AppendOnlyLogger(wmGroupLog, groupLogFileName);
+	wmGroupLog->scene.attachUpdateObserver(logger);
+	CPPUNIT_ASSERT(wmGroupLog->scene.addGroup(wmGroupLog->getRootNodeId(), groupId, dummyAttributes));
+	TimeStamp groupLogMiddle = wmGroupLog->now();
+	CPPUNIT_ASSERT(wmGroupLog->scene.addNode(groupId, lateNodeId, dummyAttributes));
+	delete logger;
+
+	wmReplica = new brics_3d::WorldModel(new UuidGenerator(wmGroupLog->getRootNodeId()));
+	replayer = new brics_3d::rsg::HDF5LogReplayer(wmReplica);
+	CPPUNIT_ASSERT(replayer->open(groupLogFileName));
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(2), replayer->getNumberOfUpdates());
+	CPPUNIT_ASSERT_EQUAL(static_cast<size_t>(0), replayer->getNumberOfKeyframes());
+	CPPUNIT_ASSERT(replayer->seek(groupLogMiddle));
+	CPPUNIT_ASSERT(wmReplica->scene.getNodeAttributes(groupId, resultAttributes));
+	CPPUNIT_ASSERT(!wmReplica->scene.getNodeAttributes(lateNodeId, resultAttributes));
+	CPPUNIT_ASSERT(replayer->replay(replayer->getEndStamp()));
+	CPPUNIT_ASSERT(wmReplica->scene.getNodeAttributes(lateNodeId, resultAttributes));
+
+	delete replayer;
+	delete wmReplica;
+	delete wmGroupLog;
+	delete wm;
+}
+
+void HDF5Test::testTransformStreamEncoding() {
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel();
+	brics_3d::WorldModel* wmReplica = new brics_3d::WorldModel();
+
+	brics_3d::rsg::HDF5UpdateDeserializer* wmUpdatesToDeserializer = new brics_3d::rsg::HDF5UpdateDeserializer(wmReplica);
+	HDF5SizeRecordingBridge* feedForwardBridge = new HDF5SizeRecordingBridge(wmUpdatesToDeserializer);
+	brics_3d::rsg::HDF5UpdateSerializer* wmUpdatesToSerializer = new brics_3d::rsg::HDF5UpdateSerializer(feedForwardBridge);
+	TransformStreamEncoder::Options options;
+	options.keyframeInterval = 10;
+	wmUpdatesToSerializer->setTransformStreamOptions(options);
+	wmUpdatesToSerializer->setUseTransformStreamEncoding(true);
+	wm->scene.attachUpdateObserver(wmUpdatesToSerializer);
+
+	vector<Attribute> dummyAttributes;
+	wmReplica->scene.addRemoteRootNode(wm->getRootNodeId(), dummyAttributes);
+	wmReplica->scene.addParent(wm->getRootNodeId(), wmReplica->getRootNodeId());
+
+	Id tfId;
+	TimeStamp start = wm->now();
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44());
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr resultTransform;
+	CPPUNIT_ASSERT(wm->scene.addTransformNode(wm->getRootNodeId(), tfId, dummyAttributes, transform, start));
+
+	for (int i = 1; i <= 25; ++i) {
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr update(new HomogeneousMatrix44());
+		HomogeneousMatrix44::xyzRollPitchYawToMatrix(0.1 * i, -0.2 * i, 1.0, 0.02 * i, 0, 0, update);
+		CPPUNIT_ASSERT(wm->scene.setTransform(tfId, update, start + TimeStamp(10.0 * i, Units::MilliSecond)));
+		CPPUNIT_ASSERT(wmReplica->scene.getTransform(tfId, start + TimeStamp(10.0 * i, Units::MilliSecond), resultTransform));
+		for (int j = 0; j < 16; ++j) {
+			if ((i - 1) % 10 == 0) { // keyframes
+				CPPUNIT_ASSERT_EQUAL(update->getRawData()[j], resultTransform->getRawData()[j]);
+			} else {
+				CPPUNIT_ASSERT_DOUBLES_EQUAL(update->getRawData()[j], resultTransform->getRawData()[j], options.maxTranslationError);
+			}
+		}
+	}
+
+	/*
+	 * Deltas inside of a batch. A single update message is dominated by the size of the
+	 * HDF5 file structure, but in a batch the smaller data sets add up.
+	 */
+	int streamBatchSize = 0;
+	int plainBatchSize = 0;
+	for (int run = 0; run < 2; ++run) {
+		SceneGraphUpdateBatch batch;
+		for (int i = 26 + 40 * run; i < 66 + 40 * run; ++i) {
+			IHomogeneousMatrix44::IHomogeneousMatrix44Ptr update(new HomogeneousMatrix44());
+			HomogeneousMatrix44::xyzRollPitchYawToMatrix(0.1 * i, -0.2 * i, 1.0, 0.02 * i, 0, 0, update);
+			batch.setTransform(tfId, update, start + TimeStamp(10.0 * i, Units::MilliSecond));
+		}
+		CPPUNIT_ASSERT(wm->scene.applyUpdateBatch(batch));
+		if (run == 0) {
+			streamBatchSize = feedForwardBridge->lastMessageSize;
+			wmUpdatesToSerializer->setUseTransformStreamEncoding(false);
+		} else {
+			plainBatchSize = feedForwardBridge->lastMessageSize;
+		}
+	}
+	LOG(INFO) << "HDF5Test::testTransformStreamEncoding: batch of 40 transforms = " << plainBatchSize << " bytes, as stream = " << streamBatchSize << " bytes";
+	CPPUNIT_ASSERT(streamBatchSize < plainBatchSize);
+	CPPUNIT_ASSERT(wmReplica->scene.getTransform(tfId, start + TimeStamp(650.0, Units::MilliSecond), resultTransform));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(6.5, resultTransform->getRawData()[matrixEntry::x], options.maxTranslationError);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(-13.0, resultTransform->getRawData()[matrixEntry::y], options.maxTranslationError);
+	CPPUNIT_ASSERT(wmReplica->scene.getTransform(tfId, start + TimeStamp(1050.0, Units::MilliSecond), resultTransform));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(10.5, resultTransform->getRawData()[matrixEntry::x], maxTolerance);
+
+	delete wmUpdatesToSerializer;
+	delete feedForwardBridge;
+	delete wmUpdatesToDeserializer;
+	delete wmReplica;
+	delete wm;
+}
+
 }  // namespace unitTests
 
 #endif /* BRICS_HDF5_ENABLE */
@@ -37,6 +37,11 @@ class HDF5Test : public CPPUNIT_NS::TestFixture {
 	CPPUNIT_TEST( testLoopBack );
 	CPPUNIT_TEST( testUpdateObersver );
 	CPPUNIT_TEST( testLogger );
+	CPPUNIT_TEST( testUpdateBatch );
+	CPPUNIT_TEST( testPointCloudStorage );
+	CPPUNIT_TEST( testUpdateTableLogger );
+	CPPUNIT_TEST( testLogReplayer );
+	CPPUNIT_TEST( testTransformStreamEncoding );
 #endif /* BRICS_HDF5_ENABLE */
 	CPPUNIT_TEST_SUITE_END();
 
@@ -49,6 +54,11 @@ public:
 	void testUpdateObersver();
 	void threadFunction(brics_3d::WorldModel* wm);
 	void testLogger();
+	void testUpdateBatch();
+	void testPointCloudStorage();
+	void testUpdateTableLogger();
+	void testLogReplayer();
+	void testTransformStreamEncoding();
 
 private:
 	  /// Maximum deviation for equality check of double variables
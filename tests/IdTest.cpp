@@ -18,6 +18,8 @@
  ******************************************************************************/
 #include "IdTest.h"
 #include <boost/regex.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/thread.hpp>
 namespace unitTests {
 
 // Registers the fixture into the 'registry'
@@ -301,6 +303,87 @@ void IdTest::testUuidStringIo() {
 
 }
 
+namespace {
+
+void generateIds(std::vector<Id>* ids) {
+	UuidGenerator generator;
+	for (int i = 0; i < 1000; ++i) {
+		ids->push_back(generator.getNextValidId());
+	}
+}
+
+}
+
+void IdTest::testUuidHashAndCompare() {
+	Uuid a;
+	Uuid b;
+
+	/* ordering has to be lexicographical w.r.t. the byte array (big endian) */
+	a = 1;
+	b = 256;
+	CPPUNIT_ASSERT(a < b);
+	CPPUNIT_ASSERT(!(b < a));
+	CPPUNIT_ASSERT(a != b);
+
+	CPPUNIT_ASSERT(a.fromString("00000000-0000-0001-0000-000000000000"));
+	CPPUNIT_ASSERT(b.fromString("00000000-0000-0000-ffff-ffffffffffff"));
+	CPPUNIT_ASSERT(b < a);
+	CPPUNIT_ASSERT(a > b);
+	CPPUNIT_ASSERT(b <= a);
+	CPPUNIT_ASSERT(a >= b);
+
+	CPPUNIT_ASSERT(a.fromString("ff000000-0000-0000-0000-000000000000"));
+	CPPUNIT_ASSERT(b.fromString("0fffffff-ffff-ffff-ffff-ffffffffffff"));
+	CPPUNIT_ASSERT(b < a);
+
+	/* equality in the last byte only */
+	CPPUNIT_ASSERT(a.fromString("A9583A36-C160-4B72-B3FD-1CE2B383C999"));
+	CPPUNIT_ASSERT(b.fromString("a9583a36-c160-4b72-b3fd-1ce2b383c998"));
+	CPPUNIT_ASSERT(a != b);
+	CPPUNIT_ASSERT(b < a);
+	CPPUNIT_ASSERT(b.fromString("a9583a36-c160-4b72-b3fd-1ce2b383c999"));
+	CPPUNIT_ASSERT(a == b);
+	CPPUNIT_ASSERT_EQUAL(a.hash(), b.hash());
+	CPPUNIT_ASSERT_EQUAL(hash_value(a), hash_value(b));
+	CPPUNIT_ASSERT_EQUAL(std::string("a9583a36-c160-4b72-b3fd-1ce2b383c999"), a.toString());
+
+	char buffer[Uuid::stringSize];
+	a.toString(buffer);
+	CPPUNIT_ASSERT_EQUAL(a.toString(), std::string(buffer, Uuid::stringSize));
+
+	/* hashed containers */
+	UuidGenerator generator;
+	boost::unordered_set<Id> ids;
+	std::vector<Id> idList;
+	for (int i = 0; i < 1000; ++i) {
+		Id id = generator.getNextValidId();
+		CPPUNIT_ASSERT(ids.insert(id).second);
+		idList.push_back(id);
+	}
+	CPPUNIT_ASSERT_EQUAL(1000u, static_cast<unsigned int>(ids.size()));
+	for (unsigned int i = 0; i < idList.size(); ++i) {
+		CPPUNIT_ASSERT(ids.find(idList[i]) != ids.end());
+		CPPUNIT_ASSERT(!generator.removeIdFromPool(idList[i]));
+		Uuid parsedId;
+		CPPUNIT_ASSERT(parsedId.fromString(idList[i].toString()));
+		CPPUNIT_ASSERT(parsedId == idList[i]);
+	}
+
+	/* every thread has its own random number generator; they must not produce the same sequences */
+	std::vector<Id> idsOfThread1;
+	std::vector<Id> idsOfThread2;
+	boost::thread thread1(generateIds, &idsOfThread1);
+	boost::thread thread2(generateIds, &idsOfThread2);
+	thread1.join();
+	thread2.join();
+	CPPUNIT_ASSERT_EQUAL(1000u, static_cast<unsigned int>(idsOfThread1.size()));
+	CPPUNIT_ASSERT_EQUAL(1000u, static_cast<unsigned int>(idsOfThread2.size()));
+	for (unsigned int i = 0; i < idsOfThread1.size(); ++i) {
+		CPPUNIT_ASSERT(ids.insert(idsOfThread1[i]).second);
+		CPPUNIT_ASSERT(ids.insert(idsOfThread2[i]).second);
+	}
+}
+
 bool IdTest::validateUuid(const std::string& uuid){
 //   static const boost::regex e("[a-f0-9]{8}-[a-f0-9]{4}-4[a-f0-9]{3}-[89aAbB][a-f0-9]{3}-[a-f0-9]{12}");
    static const boost::regex e("[a-f0-9]{8}-[a-f0-9]{4}-[a-f0-9]{4}-[a-f0-9]{4}-[a-f0-9]{12}"); // we are not so strict here to improve testability.
@@ -44,6 +44,7 @@ class IdTest : public CPPUNIT_NS::TestFixture {
 	CPPUNIT_TEST( testIdGenerator );
 	CPPUNIT_TEST( testUuidGenerator );
 	CPPUNIT_TEST( testUuidStringIo );
+	CPPUNIT_TEST( testUuidHashAndCompare );
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -57,6 +58,7 @@ public:
 	void testIdGenerator();
 	void testUuidGenerator();
 	void testUuidStringIo();
+	void testUuidHashAndCompare();
 
 private:
 
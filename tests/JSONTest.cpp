@@ -3493,6 +3493,779 @@ void JSONTest::testGrahpGenerator() {
 	delete wm;
 }
 
+void JSONTest::testUpdateBatch() {
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel(); 		   // first world model agent
+	brics_3d::WorldModel* wmReplica = new brics_3d::WorldModel(); // second world model agent
+
+	brics_3d::rsg::JSONDeserializer* wmUpdatesToDeserializer = new brics_3d::rsg::JSONDeserializer(wmReplica);
+	JSONSimpleBridge* feedForwardBridge = new JSONSimpleBridge(wmUpdatesToDeserializer);
+	brics_3d::rsg::JSONSerializer* wmUpdatesToSerializer = new brics_3d::rsg::JSONSerializer(wm, feedForwardBridge);
+	wm->scene.attachUpdateObserver(wmUpdatesToSerializer);
+
+	MyObserver wmNodeCounter;
+	MyObserver remoteWmNodeCounter;
+	wm->scene.attachUpdateObserver(&wmNodeCounter);
+	wmReplica->scene.attachUpdateObserver(&remoteWmNodeCounter);
+
+	vector<Attribute> dummyAttributes;
+	vector<Attribute> attributes;
+	attributes.push_back(Attribute("name","batch_node"));
+	vector<Id> resultIds;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform123(new HomogeneousMatrix44(1,0,0,  	//Rotation coefficients
+	                                                             0,1,0,
+	                                                             0,0,1,
+	                                                             1,2,3)); 						//Translation coefficients
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr resultTransform;
+
+	/* Manually "mount" first wm relative to second one */
+	wmReplica->scene.addRemoteRootNode(wm->getRootNodeId(), dummyAttributes);
+	wmReplica->scene.addParent(wm->getRootNodeId(), wmReplica->getRootNodeId());
+
+	/* Record a batch */
+	rsg::SceneGraphUpdateBatch batch;
+	Id groupId;
+	Id tfId;
+	Id geodeId;
+	Cylinder::CylinderPtr cylinder(new Cylinder(0.2,0.1));
+	CPPUNIT_ASSERT(batch.addGroup(wm->getRootNodeId(), groupId, attributes));
+	CPPUNIT_ASSERT(batch.addTransformNode(groupId, tfId, attributes, transform123, wm->now()));
+	CPPUNIT_ASSERT(batch.addGeometricNode(tfId, geodeId, attributes, cylinder, wm->now()));
+	CPPUNIT_ASSERT(batch.setNodeAttributes(groupId, dummyAttributes));
+
+	CPPUNIT_ASSERT(wm->scene.applyUpdateBatch(batch));
+	CPPUNIT_ASSERT_EQUAL(1, wmNodeCounter.applyUpdateBatchCounter);
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.applyUpdateBatchCounter); // a single message has been received
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addGroupCounter);
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addTransformCounter);
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.addGeometricNodeCounter);
+	CPPUNIT_ASSERT_EQUAL(1, remoteWmNodeCounter.setNodeAttributesCounter);
+
+	CPPUNIT_ASSERT(wmReplica->scene.getNodes(attributes, resultIds));
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(resultIds.size())); // the group has no attributes anymore
+	CPPUNIT_ASSERT(wmReplica->scene.getTransform(tfId, wm->now(), resultTransform));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(2.0, resultTransform->getRawData()[13], maxTolerance);
+
+	delete wmUpdatesToSerializer;
+	delete feedForwardBridge;
+	delete wmUpdatesToDeserializer;
+	delete wmReplica;
+	delete wm;
+}
+
+void JSONTest::testPointCloudBinaryBlob() {
+
+	/* base64 round trips for all padding variants */
+	std::string encoded;
+	std::vector<char> decoded;
+	const char* text = "brics_3d";
+	for (int length = 0; length <= 8; ++length) {
+		std::vector<char> data(text, text + length);
+		JSONTypecaster::encodeBase64(data, encoded);
+		CPPUNIT_ASSERT_EQUAL(static_cast<size_t>((length + 2) / 3 * 4), encoded.size());
+		CPPUNIT_ASSERT(JSONTypecaster::decodeBase64(encoded, decoded));
+		CPPUNIT_ASSERT(data == decoded);
+	}
+	JSONTypecaster::encodeBase64(std::vector<char>(text, text + 5), encoded);
+	CPPUNIT_ASSERT(encoded.compare("YnJpY3M=") == 0);
+	CPPUNIT_ASSERT(!JSONTypecaster::decodeBase64("YnJ", decoded));
+	CPPUNIT_ASSERT(!JSONTypecaster::decodeBase64("Yn*p", decoded));
+	CPPUNIT_ASSERT(!JSONTypecaster::decodeBase64("Yn=p", decoded));
+	CPPUNIT_ASSERT(!JSONTypecaster::decodeBase64("Y===", decoded));
+	CPPUNIT_ASSERT(!JSONTypecaster::decodeBase64("Yn==YnJp", decoded));
+
+	/* A colored point cloud */
+	brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr pointCloudContainer(new brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>());
+	pointCloudContainer->data = brics_3d::PointCloud3D::PointCloud3DPtr(new brics_3d::PointCloud3D());
+	for (int i = 0; i < 5000; ++i) {
+		pointCloudContainer->data->addPointPtr(new ColoredPoint3D(new Point3D(0.001 * i, -0.5 * i, 1.0/3.0), i % 256, 2, 255));
+	}
+	Shape::ShapePtr shape = pointCloudContainer;
+	Shape::ShapePtr resultShape;
+	brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr resultPointCloud;
+	std::string listAsString;
+	std::string blobAsString;
+
+	libvariant::Variant listNode;
+	CPPUNIT_ASSERT(JSONTypecaster::addShapeToJSON(shape, listNode, "geometry", 1000000));
+	CPPUNIT_ASSERT(listNode.Get("geometry").Get("@geometrytype").AsString().compare("PointCloud3D") == 0);
+	CPPUNIT_ASSERT(JSONTypecaster::JSONtoString(listNode, listAsString));
+
+	libvariant::Variant blobNode;
+	CPPUNIT_ASSERT(JSONTypecaster::addShapeToJSON(shape, blobNode, "geometry"));
+	CPPUNIT_ASSERT(blobNode.Get("geometry").Get("@geometrytype").AsString().compare("PointCloud3DBinaryBlob") == 0);
+	CPPUNIT_ASSERT(JSONTypecaster::JSONtoString(blobNode, blobAsString));
+	LOG(INFO) << "JSONTest::testPointCloudBinaryBlob: list = " << listAsString.size() << " bytes, blob = " << blobAsString.size() << " bytes";
+	CPPUNIT_ASSERT(blobAsString.size() * 2 < listAsString.size());
+
+	/* Decoding is lossless for both */
+	libvariant::Variant parsedNode;
+	CPPUNIT_ASSERT(JSONTypecaster::stringToJSON(blobAsString, parsedNode));
+	CPPUNIT_ASSERT(JSONTypecaster::getShapeFromJSON(resultShape, parsedNode));
+	resultPointCloud = boost::dynamic_pointer_cast<brics_3d::rsg::PointCloud<brics_3d::PointCloud3D> >(resultShape);
+	CPPUNIT_ASSERT(resultPointCloud != 0);
+	CPPUNIT_ASSERT_EQUAL(5000u, resultPointCloud->data->getSize());
+	CPPUNIT_ASSERT_EQUAL(1.0/3.0, (*resultPointCloud->data->getPointCloud())[4999].getZ());
+	CPPUNIT_ASSERT_EQUAL(-0.5 * 4999, (*resultPointCloud->data->getPointCloud())[4999].getY());
+	ColoredPoint3D* coloredPoint = (*resultPointCloud->data->getPointCloud())[300].asColoredPoint3D();
+	CPPUNIT_ASSERT(coloredPoint != 0);
+	CPPUNIT_ASSERT_EQUAL(300 % 256, static_cast<int>(coloredPoint->getR()));
+	CPPUNIT_ASSERT_EQUAL(255, static_cast<int>(coloredPoint->getB()));
+
+	CPPUNIT_ASSERT(JSONTypecaster::stringToJSON(listAsString, parsedNode));
+	CPPUNIT_ASSERT(JSONTypecaster::getShapeFromJSON(resultShape, parsedNode));
+	resultPointCloud = boost::dynamic_pointer_cast<brics_3d::rsg::PointCloud<brics_3d::PointCloud3D> >(resultShape);
+	CPPUNIT_ASSERT(resultPointCloud != 0);
+	CPPUNIT_ASSERT_EQUAL(5000u, resultPointCloud->data->getSize());
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.001 * 4999, (*resultPointCloud->data->getPointCloud())[4999].getX(), maxTolerance);
+
+	/* Single precision and units */
+	libvariant::Variant floatNode;
+	CPPUNIT_ASSERT(JSONTypecaster::addShapeToJSON(shape, floatNode, "geometry", 0, true));
+	floatNode.Set("unit", libvariant::Variant("mm"));
+	CPPUNIT_ASSERT(JSONTypecaster::getShapeFromJSON(resultShape, floatNode));
+	resultPointCloud = boost::dynamic_pointer_cast<brics_3d::rsg::PointCloud<brics_3d::PointCloud3D> >(resultShape);
+	CPPUNIT_ASSERT(resultPointCloud != 0);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(-0.5 * 4999 / 1000.0, (*resultPointCloud->data->getPointCloud())[4999].getY(), maxTolerance);
+
+	/* Corrupted blob */
+	libvariant::Variant corruptedNode;
+	CPPUNIT_ASSERT(JSONTypecaster::addShapeToJSON(shape, corruptedNode, "geometry"));
+	libvariant::Variant geometry = corruptedNode.Get("geometry");
+	geometry.Set("numberOfPoints", libvariant::Variant(5001));
+	corruptedNode.Set("geometry", geometry);
+	CPPUNIT_ASSERT(!JSONTypecaster::getShapeFromJSON(resultShape, corruptedNode));
+
+	/* End to end via the serializer */
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel();
+	brics_3d::WorldModel* wmReplica = new brics_3d::WorldModel();
+	brics_3d::rsg::JSONDeserializer* wmUpdatesToDeserializer = new brics_3d::rsg::JSONDeserializer(wmReplica);
+	JSONSimpleBridge* feedForwardBridge = new JSONSimpleBridge(wmUpdatesToDeserializer);
+	brics_3d::rsg::JSONSerializer* wmUpdatesToSerializer = new brics_3d::rsg::JSONSerializer(wm, feedForwardBridge);
+	wm->scene.attachUpdateObserver(wmUpdatesToSerializer);
+	vector<Attribute> dummyAttributes;
+	wmReplica->scene.addRemoteRootNode(wm->getRootNodeId(), dummyAttributes);
+	wmReplica->scene.addParent(wm->getRootNodeId(), wmReplica->getRootNodeId());
+
+	Id pointCloudId;
+	TimeStamp resultTime;
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(wm->getRootNodeId(), pointCloudId, dummyAttributes, shape, wm->now()));
+	CPPUNIT_ASSERT(wmReplica->scene.getGeometry(pointCloudId, resultShape, resultTime));
+	resultPointCloud = boost::dynamic_pointer_cast<brics_3d::rsg::PointCloud<brics_3d::PointCloud3D> >(resultShape);
+	CPPUNIT_ASSERT(resultPointCloud != 0);
+	CPPUNIT_ASSERT_EQUAL(5000u, resultPointCloud->data->getSize());
+
+	delete wmUpdatesToSerializer;
+	delete feedForwardBridge;
+	delete wmUpdatesToDeserializer;
+	delete wmReplica;
+	delete wm;
+}
+
+void JSONTest::testTransformStreamEncoding() {
+
+	TransformStreamEncoder::Options options; // defaults: keyframe every 50 samples
+	TransformStreamEncoder encoder(options);
+	TransformStreamDecoder decoder;
+	TransformStreamSample sample;
+	Id id = Id(1);
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44());
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr resultTransform(new HomogeneousMatrix44());
+	TimeStamp resultStamp;
+
+	/* A smooth trajectory: keyframes are exact, deltas within the error bounds */
+	int keyframes = 0;
+	for (int i = 0; i < 120; ++i) {
+		TimeStamp stamp(1000.0 + 0.01 * i, Units::Second);
+		HomogeneousMatrix44::xyzRollPitchYawToMatrix(0.5 + 0.001 * i, -2.0, 0.3 * sin(0.05 * i), 0.1, 0.01 * i, M_PI - 0.02 * i, transform);
+		CPPUNIT_ASSERT(encoder.encode(id, transform, stamp, sample));
+		CPPUNIT_ASSERT(decoder.decode(id, sample, resultTransform, resultStamp));
+		const double* expected = transform->getRawData();
+		const double* result = resultTransform->getRawData();
+		if (sample.isKeyframe) {
+			keyframes++;
+			for (int j = 0; j < 16; ++j) {
+				CPPUNIT_ASSERT_EQUAL(expected[j], result[j]);
+			}
+			CPPUNIT_ASSERT(stamp == resultStamp);
+		} else {
+			for (int j = 0; j < 11; ++j) {
+				CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[j], result[j], options.maxRotationError);
+			}
+			for (int j = 12; j < 15; ++j) {
+				CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[j], result[j], options.maxTranslationError);
+			}
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(stamp.getSeconds(), resultStamp.getSeconds(), options.maxTimeStampError);
+		}
+	}
+	CPPUNIT_ASSERT_EQUAL(3, keyframes); // samples 0, 50 and 100
+
+	/* A jump exceeds the bounds of a single precision delta */
+	transform->setRawData()[matrixEntry::x] += 100000.004;
+	CPPUNIT_ASSERT(encoder.encode(id, transform, TimeStamp(1002.0, Units::Second), sample));
+	CPPUNIT_ASSERT(sample.isKeyframe);
+	CPPUNIT_ASSERT(decoder.decode(id, sample, resultTransform, resultStamp));
+
+	/* Scaling can not be represented by a quaternion */
+	transform->setRawData()[matrixEntry::r11] *= 2.0;
+	CPPUNIT_ASSERT(encoder.encode(id, transform, TimeStamp(1002.01, Units::Second), sample));
+	CPPUNIT_ASSERT(sample.isKeyframe);
+	CPPUNIT_ASSERT(decoder.decode(id, sample, resultTransform, resultStamp));
+	CPPUNIT_ASSERT_EQUAL(transform->getRawData()[matrixEntry::r11], resultTransform->getRawData()[matrixEntry::r11]);
+
+	/* A lost sample invalidates the stream until the next keyframe */
+	transform->setRawData()[matrixEntry::r11] /= 2.0;
+	CPPUNIT_ASSERT(encoder.encode(id, transform, TimeStamp(1002.02, Units::Second), sample));
+	CPPUNIT_ASSERT(decoder.decode(id, sample, resultTransform, resultStamp));
+	CPPUNIT_ASSERT(encoder.encode(id, transform, TimeStamp(1002.03, Units::Second), sample)); // lost
+	CPPUNIT_ASSERT(!sample.isKeyframe);
+	CPPUNIT_ASSERT(encoder.encode(id, transform, TimeStamp(1002.04, Units::Second), sample));
+	CPPUNIT_ASSERT(!sample.isKeyframe);
+	CPPUNIT_ASSERT(!decoder.decode(id, sample, resultTransform, resultStamp));
+	CPPUNIT_ASSERT(encoder.encode(id, transform, TimeStamp(1002.05, Units::Second), sample));
+	CPPUNIT_ASSERT(!decoder.decode(id, sample, resultTransform, resultStamp));
+	CPPUNIT_ASSERT(!decoder.decode(Id(2), sample, resultTransform, resultStamp)); // unknown stream
+	encoder.reset(id);
+	CPPUNIT_ASSERT(encoder.encode(id, transform, TimeStamp(1002.06, Units::Second), sample));
+	CPPUNIT_ASSERT(sample.isKeyframe);
+	CPPUNIT_ASSERT(decoder.decode(id, sample, resultTransform, resultStamp));
+
+	/* JSON representation is more compact than the transform history */
+	libvariant::Variant historyNode;
+	TemporalCache<IHomogeneousMatrix44::IHomogeneousMatrix44Ptr> history;
+	history.insertData(transform, TimeStamp(1002.07, Units::Second));
+	JSONTypecaster::addTransformCacheToJSON(history, historyNode);
+	std::string historyAsString;
+	CPPUNIT_ASSERT(JSONTypecaster::JSONtoString(historyNode, historyAsString));
+
+	libvariant::Variant streamNode;
+	CPPUNIT_ASSERT(encoder.encode(id, transform, TimeStamp(1002.07, Units::Second), sample));
+	CPPUNIT_ASSERT(!sample.isKeyframe);
+	CPPUNIT_ASSERT(JSONTypecaster::addTransformStreamSampleToJSON(sample, streamNode));
+	std::string streamAsString;
+	CPPUNIT_ASSERT(JSONTypecaster::JSONtoString(streamNode, streamAsString));
+	LOG(INFO) << "JSONTest::testTransformStreamEncoding: history = " << historyAsString.size() << " bytes, delta = " << streamAsString.size() << " bytes";
+	CPPUNIT_ASSERT(streamAsString.size() * 4 < historyAsString.size());
+
+	TransformStreamSample parsedSample;
+	libvariant::Variant parsedNode;
+	CPPUNIT_ASSERT(JSONTypecaster::stringToJSON(streamAsString, parsedNode));
+	CPPUNIT_ASSERT(JSONTypecaster::getTransformStreamSampleFromJSON(parsedSample, parsedNode));
+	CPPUNIT_ASSERT_EQUAL(sample.sequence, parsedSample.sequence);
+	CPPUNIT_ASSERT(!parsedSample.isKeyframe);
+	for (unsigned int i = 0; i < TransformStreamSample::deltaElements; ++i) {
+		CPPUNIT_ASSERT_EQUAL(sample.delta[i], parsedSample.delta[i]);
+	}
+	CPPUNIT_ASSERT(!JSONTypecaster::getTransformStreamSampleFromJSON(parsedSample, historyNode));
+
+	/* End to end via the serializer */
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel();
+	brics_3d::WorldModel* wmReplica = new brics_3d::WorldModel();
+	brics_3d::rsg::JSONDeserializer* wmUpdatesToDeserializer = new brics_3d::rsg::JSONDeserializer(wmReplica);
+	JSONSimpleBridge* feedForwardBridge = new JSONSimpleBridge(wmUpdatesToDeserializer);
+	brics_3d::rsg::JSONSerializer* wmUpdatesToSerializer = new brics_3d::rsg::JSONSerializer(wm, feedForwardBridge);
+	wmUpdatesToSerializer->setUseTransformStreamEncoding(true);
+	wm->scene.attachUpdateObserver(wmUpdatesToSerializer);
+	vector<Attribute> dummyAttributes;
+	wmReplica->scene.addRemoteRootNode(wm->getRootNodeId(), dummyAttributes);
+	wmReplica->scene.addParent(wm->getRootNodeId(), wmReplica->getRootNodeId());
+
+	Id tfId;
+	TimeStamp start = wm->now();
+	HomogeneousMatrix44::xyzRollPitchYawToMatrix(1.0, 2.0, 3.0, 0, 0, 0, transform);
+	CPPUNIT_ASSERT(wm->scene.addTransformNode(wm->getRootNodeId(), tfId, dummyAttributes, transform, start));
+	for (int i = 1; i <= 60; ++i) {
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr update(new HomogeneousMatrix44());
+		HomogeneousMatrix44::xyzRollPitchYawToMatrix(1.0 + 0.01 * i, 2.0, 3.0, 0, 0, 0.01 * i, update);
+		CPPUNIT_ASSERT(wm->scene.setTransform(tfId, update, start + TimeStamp(10.0 * i, Units::MilliSecond)));
+	}
+	CPPUNIT_ASSERT(wmReplica->scene.getTransform(tfId, start + TimeStamp(600.0, Units::MilliSecond), resultTransform));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.6, resultTransform->getRawData()[matrixEntry::x], options.maxTranslationError);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(cos(0.6), resultTransform->getRawData()[matrixEntry::r11], options.maxRotationError);
+	CPPUNIT_ASSERT(wmReplica->scene.getTransform(tfId, start + TimeStamp(510.0, Units::MilliSecond), resultTransform)); // 51st update is the second keyframe of the stream
+	CPPUNIT_ASSERT_EQUAL(1.0 + 0.01 * 51, resultTransform->getRawData()[matrixEntry::x]);
+
+	/* Removing a parent does not interrupt the stream */
+	Id groupId;
+	CPPUNIT_ASSERT(wm->scene.addGroup(wm->getRootNodeId(), groupId, dummyAttributes));
+	CPPUNIT_ASSERT(wm->scene.addParent(tfId, groupId));
+	CPPUNIT_ASSERT(wm->scene.removeParent(tfId, groupId));
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr afterRemoval(new HomogeneousMatrix44());
+	HomogeneousMatrix44::xyzRollPitchYawToMatrix(1.7, 2.0, 3.0, 0, 0, 0.7, afterRemoval);
+	CPPUNIT_ASSERT(wm->scene.setTransform(tfId, afterRemoval, start + TimeStamp(700.0, Units::MilliSecond)));
+	CPPUNIT_ASSERT(wmReplica->scene.getTransform(tfId, start + TimeStamp(700.0, Units::MilliSecond), resultTransform));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.7, resultTransform->getRawData()[matrixEntry::x], options.maxTranslationError);
+
+	delete wmUpdatesToSerializer;
+	delete feedForwardBridge;
+	delete wmUpdatesToDeserializer;
+	delete wmReplica;
+	delete wm;
+}
+
+/// Feeds the same data into two input ports.
+class JSONTeeBridge : public brics_3d::rsg::IOutputPort {
+public:
+	JSONTeeBridge(brics_3d::rsg::IInputPort* firstInputPort, brics_3d::rsg::IInputPort* secondInputPort) :
+		firstInputPort(firstInputPort), secondInputPort(secondInputPort) {};
+	virtual ~JSONTeeBridge(){};
+
+	int write(const char *dataBuffer, int dataLength, int &transferredBytes) {
+		int secondTransferredBytes = 0;
+		int result = firstInputPort->write(dataBuffer, dataLength, transferredBytes);
+		CPPUNIT_ASSERT_EQUAL(result, secondInputPort->write(dataBuffer, dataLength, secondTransferredBytes));
+		return result;
+	};
+
+private:
+	brics_3d::rsg::IInputPort* firstInputPort;
+	brics_3d::rsg::IInputPort* secondInputPort;
+};
+
+void JSONTest::testFastPath() {
+
+	/* Parser */
+	JSONFastPathParser parser;
+	JSONFastPathParser::Update update;
+	Id expectedId;
+	expectedId.fromString("00000000-0000-0000-0000-000000000042");
+	std::string message = "{\"@worldmodeltype\": \"RSGUpdate\", \"operation\": \"UPDATE_TRANSFORM\", \"node\": {"
+			"\"@graphtype\": \"Connection\", \"@semanticContext\": \"Transform\", \"id\": \"00000000-0000-0000-0000-000000000042\","
+			"\"history\": [{\"stamp\": {\"@stamptype\": \"TimeStampUTCms\", \"stamp\": 1000.5},"
+			"\"transform\": {\"type\": \"HomogeneousMatrix44\", \"matrix\": [[1,0,0,1.5],[0,1,0,-2e-1],[0,0,1,3],[0,0,0,1]], \"unit\": \"m\"}}]}}";
+	CPPUNIT_ASSERT(parser.parse(message.c_str(), message.size(), update));
+	CPPUNIT_ASSERT_EQUAL(JSONFastPathParser::UPDATE_TRANSFORM, update.operation);
+	CPPUNIT_ASSERT(update.id == expectedId);
+	CPPUNIT_ASSERT(!update.hasTransformStreamSample);
+	CPPUNIT_ASSERT_EQUAL(1.5, update.translation[0]);
+	CPPUNIT_ASSERT_EQUAL(-0.2, update.translation[1]);
+	CPPUNIT_ASSERT_EQUAL(3.0, update.translation[2]);
+	CPPUNIT_ASSERT_EQUAL(1.0, update.rotation[0]);
+	CPPUNIT_ASSERT_EQUAL(0.0, update.rotation[1]);
+	CPPUNIT_ASSERT(update.transformTimeStamp == TimeStamp(1000.5, Units::MilliSecond));
+
+	message = "{\"@worldmodeltype\": \"RSGUpdate\", \"operation\": \"UPDATE_ATTRIBUTES\", \"updateMode\": \"APPEND\", \"node\": {"
+			"\"@graphtype\": \"Node\", \"id\": \"00000000-0000-0000-0000-000000000042\","
+			"\"attributes\": [{\"key\": \"name\", \"value\": \"a \\\"quoted\\\" \\\\ value\"}]}}";
+	CPPUNIT_ASSERT(parser.parse(message.c_str(), message.size(), update));
+	CPPUNIT_ASSERT_EQUAL(JSONFastPathParser::UPDATE_ATTRIBUTES, update.operation);
+	CPPUNIT_ASSERT_EQUAL(std::string("APPEND"), update.updateMode);
+	CPPUNIT_ASSERT(!update.hasAttributesTimeStamp);
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(update.attributes.size()));
+	CPPUNIT_ASSERT(update.attributes[0] == Attribute("name", "a \"quoted\" \\ value"));
+
+	/* Messages that are left to the generic path */
+	message = "{\"@worldmodeltype\": \"RSGUpdate\", \"operation\": \"UPDATE_ATTRIBUTES\", \"node\": {"
+			"\"@graphtype\": \"Node\", \"id\": \"00000000-0000-0000-0000-000000000042\","
+			"\"attributes\": [{\"key\": \"name\", \"value\": {\"nested\": true}}]}}";
+	CPPUNIT_ASSERT(!parser.parse(message.c_str(), message.size(), update)); // JSON attribute value
+	message = "{\"@worldmodeltype\": \"RSGUpdate\", \"operation\": \"DELETE\", \"node\": {\"@graphtype\": \"Node\", \"id\": \"00000000-0000-0000-0000-000000000042\"}}";
+	CPPUNIT_ASSERT(!parser.parse(message.c_str(), message.size(), update));
+	message = "{\"@worldmodeltype\": \"RSGUpdate\", \"operation\": \"CREATE\", \"parentId\": \"00000000-0000-0000-0000-000000000001\", \"node\": {"
+			"\"@graphtype\": \"Group\", \"id\": \"00000000-0000-0000-0000-000000000042\", \"attributes\": [], \"childs\": []}}";
+	CPPUNIT_ASSERT(!parser.parse(message.c_str(), message.size(), update)); // recursive childs
+	message = "{\"@worldmodeltype\": \"RSGUpdate\", \"operation\": \"UPDATE_ATTRIBUTES\", \"node\": {\"@graphtype\": \"Node\", \"id\": \"00000000-0000-0000-0000-000000000042\", \"attributes\": []}} x";
+	CPPUNIT_ASSERT(!parser.parse(message.c_str(), message.size(), update)); // trailing garbage
+	message = "{\"@worldmodeltype\": \"RSGUpdate\", \"operation\": \"UPDATE_ATTRIBUTES\", \"node\": {\"@graphtype\": \"Node\", \"id\": \"00000000-0000-0000-0000-0000000000";
+	CPPUNIT_ASSERT(!parser.parse(message.c_str(), message.size(), update)); // truncated
+
+	/* Both paths have to yield the same world model */
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel();
+	brics_3d::WorldModel* wmFast = new brics_3d::WorldModel();
+	brics_3d::WorldModel* wmGeneric = new brics_3d::WorldModel();
+	brics_3d::rsg::JSONDeserializer* fastDeserializer = new brics_3d::rsg::JSONDeserializer(wmFast);
+	brics_3d::rsg::JSONDeserializer* genericDeserializer = new brics_3d::rsg::JSONDeserializer(wmGeneric);
+	CPPUNIT_ASSERT(fastDeserializer->getUseFastPath()); // default
+	genericDeserializer->setUseFastPath(false);
+	JSONTeeBridge* bridge = new JSONTeeBridge(fastDeserializer, genericDeserializer);
+	brics_3d::rsg::JSONSerializer* serializer = new brics_3d::rsg::JSONSerializer(wm, bridge);
+	wm->scene.attachUpdateObserver(serializer);
+	vector<Attribute> dummyAttributes;
+	wmFast->scene.addRemoteRootNode(wm->getRootNodeId(), dummyAttributes);
+	wmFast->scene.addParent(wm->getRootNodeId(), wmFast->getRootNodeId());
+	wmGeneric->scene.addRemoteRootNode(wm->getRootNodeId(), dummyAttributes);
+	wmGeneric->scene.addParent(wm->getRootNodeId(), wmGeneric->getRootNodeId());
+
+	vector<Attribute> attributes;
+	attributes.push_back(Attribute("name", "fast"));
+	attributes.push_back(Attribute("rsg:escaped", "line\nbreak \"quoted\""));
+	Id groupId;
+	Id nodeId;
+	Id tfId;
+	TimeStamp start(1000.0, Units::Second);
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44());
+	HomogeneousMatrix44::xyzRollPitchYawToMatrix(1.0, 2.0, 3.0, 0.1, 0.2, 0.3, transform);
+	CPPUNIT_ASSERT(wm->scene.addGroup(wm->getRootNodeId(), groupId, attributes));
+	CPPUNIT_ASSERT(wm->scene.addNode(groupId, nodeId, attributes));
+	CPPUNIT_ASSERT(wm->scene.addTransformNode(groupId, tfId, dummyAttributes, transform, start)); // generic path
+	CPPUNIT_ASSERT_EQUAL(2ul, fastDeserializer->getFastPathMessageCount());
+	CPPUNIT_ASSERT_EQUAL(0ul, genericDeserializer->getFastPathMessageCount());
+
+	attributes.clear();
+	attributes.push_back(Attribute("name", "updated"));
+	CPPUNIT_ASSERT(wm->scene.setNodeAttributes(nodeId, attributes, start + TimeStamp(1.0, Units::Second)));
+	for (int i = 1; i <= 10; ++i) {
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr update(new HomogeneousMatrix44());
+		HomogeneousMatrix44::xyzRollPitchYawToMatrix(1.0 + 0.1 * i, 2.0, 3.0, 0.1, 0.2, 0.3 + 0.01 * i, update);
+		CPPUNIT_ASSERT(wm->scene.setTransform(tfId, update, start + TimeStamp(10.0 * i, Units::MilliSecond)));
+	}
+	CPPUNIT_ASSERT_EQUAL(13ul, fastDeserializer->getFastPathMessageCount());
+
+	serializer->setUseTransformStreamEncoding(true);
+	for (int i = 11; i <= 20; ++i) {
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr update(new HomogeneousMatrix44());
+		HomogeneousMatrix44::xyzRollPitchYawToMatrix(1.0 + 0.1 * i, 2.0, 3.0, 0.1, 0.2, 0.3 + 0.01 * i, update);
+		CPPUNIT_ASSERT(wm->scene.setTransform(tfId, update, start + TimeStamp(10.0 * i, Units::MilliSecond)));
+	}
+	CPPUNIT_ASSERT_EQUAL(23ul, fastDeserializer->getFastPathMessageCount());
+	CPPUNIT_ASSERT(wm->scene.deleteNode(nodeId)); // generic path
+	CPPUNIT_ASSERT_EQUAL(23ul, fastDeserializer->getFastPathMessageCount());
+
+	brics_3d::WorldModel* replicas[2] = {wmFast, wmGeneric};
+	for (int r = 0; r < 2; ++r) {
+		vector<Attribute> resultAttributes;
+		TimeStamp attributesTimeStamp;
+		vector<Id> children;
+		CPPUNIT_ASSERT(replicas[r]->scene.getNodeAttributes(groupId, resultAttributes));
+		CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(resultAttributes.size()));
+		CPPUNIT_ASSERT(resultAttributes[1] == Attribute("rsg:escaped", "line\nbreak \"quoted\""));
+		CPPUNIT_ASSERT(replicas[r]->scene.getGroupChildren(groupId, children));
+		CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(children.size()));
+		CPPUNIT_ASSERT(children[0] == tfId);
+		CPPUNIT_ASSERT(!replicas[r]->scene.getNodeAttributes(nodeId, resultAttributes));
+	}
+	for (int i = 0; i <= 20; ++i) {
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr fastTransform(new HomogeneousMatrix44());
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr genericTransform(new HomogeneousMatrix44());
+		CPPUNIT_ASSERT(wmFast->scene.getTransform(tfId, start + TimeStamp(10.0 * i, Units::MilliSecond), fastTransform));
+		CPPUNIT_ASSERT(wmGeneric->scene.getTransform(tfId, start + TimeStamp(10.0 * i, Units::MilliSecond), genericTransform));
+		for (int j = 0; j < 16; ++j) {
+			CPPUNIT_ASSERT_EQUAL(genericTransform->getRawData()[j], fastTransform->getRawData()[j]);
+		}
+	}
+
+	delete serializer;
+	delete bridge;
+	delete genericDeserializer;
+	delete fastDeserializer;
+	delete wmGeneric;
+	delete wmFast;
+	delete wm;
+}
+
+void JSONTest::testSubtreeSynchronization() {
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel();
+	brics_3d::WorldModel* wmReplica = new brics_3d::WorldModel();
+	brics_3d::rsg::JSONQueryRunner queryRunner(wm);
+	brics_3d::rsg::JSONDeserializer deserializer(wmReplica);
+	brics_3d::rsg::MerkleSynchronizer replicaSynchronizer(&wmReplica->scene);
+	brics_3d::rsg::MerkleSynchronizer sourceSynchronizer(&wm->scene);
+	vector<Attribute> attributes;
+	Id rootId = wm->getRootNodeId();
+	wmReplica->scene.addRemoteRootNode(rootId, attributes);
+	wmReplica->scene.addParent(rootId, wmReplica->getRootNodeId());
+
+	Id groupId;
+	Id tfId;
+	Id nodeId;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 1,2,3));
+	attributes.push_back(Attribute("name", "group"));
+	CPPUNIT_ASSERT(wm->scene.addGroup(rootId, groupId, attributes));
+	CPPUNIT_ASSERT(wm->scene.addTransformNode(groupId, tfId, attributes, transform, TimeStamp(1.0)));
+	for (int i = 0; i < 20; ++i) {
+		CPPUNIT_ASSERT(wm->scene.addNode(groupId, nodeId, attributes));
+	}
+
+	for (int session = 0; session < 2; ++session) {
+		MerkleSynchronizer::SyncRequest request;
+		request.expandIds.push_back(rootId);
+		unsigned int rounds = 0;
+		while (!request.isEmpty()) {
+			CPPUNIT_ASSERT(rounds++ < 100);
+
+			/* replica -> source */
+			libvariant::Variant queryModel;
+			queryModel.Set("@worldmodeltype", libvariant::Variant("RSGQuery"));
+			queryModel.Set("query", libvariant::Variant("SYNC_SUBTREES"));
+			CPPUNIT_ASSERT(JSONTypecaster::addSyncRequestToJSON(request, queryModel));
+			std::string queryAsJson;
+			std::string resultAsJson;
+			CPPUNIT_ASSERT(JSONTypecaster::JSONtoString(queryModel, queryAsJson));
+			CPPUNIT_ASSERT(queryRunner.query(queryAsJson, resultAsJson));
+
+			/* source -> replica */
+			libvariant::Variant resultModel;
+			CPPUNIT_ASSERT(JSONTypecaster::stringToJSON(resultAsJson, resultModel));
+			std::vector<MerkleSynchronizer::SubtreeDigest> digests;
+			CPPUNIT_ASSERT(JSONTypecaster::getSubtreeDigestsFromJSON(digests, resultModel));
+			if (resultModel.Contains("updates")) {
+				libvariant::Variant updates = resultModel.Get("updates");
+				CPPUNIT_ASSERT_EQUAL(1, deserializer.write(updates));
+			}
+			CPPUNIT_ASSERT(replicaSynchronizer.compareDigests(digests, request));
+		}
+		CPPUNIT_ASSERT(sourceSynchronizer.getSubtreeHash(rootId).compare(replicaSynchronizer.getSubtreeHash(rootId)) == 0);
+
+		/* changes for the second session */
+		if (session == 0) {
+			IHomogeneousMatrix44::IHomogeneousMatrix44Ptr newTransform(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 4,5,6));
+			CPPUNIT_ASSERT(wm->scene.setTransform(tfId, newTransform, TimeStamp(2.0)));
+			CPPUNIT_ASSERT(wm->scene.deleteNode(nodeId));
+			CPPUNIT_ASSERT(sourceSynchronizer.getSubtreeHash(rootId).compare(replicaSynchronizer.getSubtreeHash(rootId)) != 0);
+		}
+	}
+
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr resultTransform;
+	CPPUNIT_ASSERT(wmReplica->scene.getTransform(tfId, TimeStamp(2.0), resultTransform));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(6.0, resultTransform->getRawData()[matrixEntry::z], 1e-9);
+	vector<Id> childIds;
+	CPPUNIT_ASSERT(wmReplica->scene.getGroupChildren(groupId, childIds));
+	CPPUNIT_ASSERT_EQUAL(20u, static_cast<unsigned int>(childIds.size())); // tf and 19 nodes
+
+	/* Malformed request */
+	std::string queryAsJson = "{\"@worldmodeltype\": \"RSGQuery\", \"query\": \"SYNC_SUBTREES\", \"subtrees\": [{\"id\": \"not-an-id\"}]}";
+	std::string resultAsJson;
+	CPPUNIT_ASSERT(!queryRunner.query(queryAsJson, resultAsJson));
+
+	delete wmReplica;
+	delete wm;
+}
+
+/// Collects all chunks of a streamed result.
+class JSONCollectingPort : public brics_3d::rsg::IOutputPort {
+public:
+	JSONCollectingPort() : numberOfWrites(0) {};
+	virtual ~JSONCollectingPort(){};
+
+	int write(const char *dataBuffer, int dataLength, int &transferredBytes) {
+		data.append(dataBuffer, dataLength);
+		transferredBytes = dataLength;
+		numberOfWrites++;
+		return 0;
+	};
+
+	std::string data;
+	int numberOfWrites;
+};
+
+void JSONTest::testQueryBatch() {
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel();
+	brics_3d::rsg::JSONQueryRunner queryRunner(wm);
+	Id rootId = wm->getRootNodeId();
+	vector<Attribute> attributes;
+
+	Id groupId;
+	Id sphereId;
+	Id pointCloudId;
+	attributes.push_back(Attribute("name", "group"));
+	CPPUNIT_ASSERT(wm->scene.addGroup(rootId, groupId, attributes));
+	attributes.clear();
+	attributes.push_back(Attribute("name", "sphere"));
+	Shape::ShapePtr sphere(new Sphere(0.5));
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(groupId, sphereId, attributes, sphere, TimeStamp(1.0)));
+	attributes.clear();
+	attributes.push_back(Attribute("name", "cloud"));
+	brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr pointCloudContainer(new brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>());
+	pointCloudContainer->data = brics_3d::PointCloud3D::PointCloud3DPtr(new brics_3d::PointCloud3D());
+	for (int i = 0; i < 5000; ++i) {
+		pointCloudContainer->data->addPointPtr(new ColoredPoint3D(new Point3D(0.001 * i, -0.5 * i, 1.0/3.0), i % 256, 2, 255));
+	}
+	Shape::ShapePtr pointCloud = pointCloudContainer;
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(groupId, pointCloudId, attributes, pointCloud, TimeStamp(2.0)));
+
+	/* Several queries in one round trip, referring to earlier results */
+	std::stringstream queryAsJson2;
+	queryAsJson2
+	<<"{"
+		<< "\"@worldmodeltype\": \"RSGQueryBatch\","
+		<< "\"queryId\": \"batch\","
+		<< "\"queries\": ["
+		<< "  {\"@worldmodeltype\": \"RSGQuery\", \"query\": \"GET_ROOT_NODE\"},"
+		<< "  {\"@worldmodeltype\": \"RSGQuery\", \"query\": \"GET_GROUP_CHILDREN\", \"id\": \"$0\"},"
+		<< "  {\"@worldmodeltype\": \"RSGQuery\", \"query\": \"GET_GROUP_CHILDREN\", \"id\": \"$1\"},"
+		<< "  {\"@worldmodeltype\": \"RSGQuery\", \"query\": \"GET_NODE_ATTRIBUTES\", \"id\": \"$2[1]\", \"queryId\": \"first\"},"
+		<< "  {\"@worldmodeltype\": \"RSGQuery\", \"query\": \"GET_NODE_ATTRIBUTES\", \"id\": \"" << pointCloudId.toString() << "\", \"queryId\": \"second\"},"
+		<< "  {\"@worldmodeltype\": \"RSGQuery\", \"query\": \"GET_NODE_ATTRIBUTES\", \"id\": \"$2[7]\"}"
+		<< "]"
+	<<"}";
+	std::string queryAsJson = queryAsJson2.str();
+	std::string resultAsJson = "";
+	CPPUNIT_ASSERT(!queryRunner.query(queryAsJson, resultAsJson)); // the last reference is invalid
+	LOG(DEBUG) << "testQueryBatch::resultAsJson " << resultAsJson;
+
+	libvariant::Variant result;
+	CPPUNIT_ASSERT(JSONTypecaster::stringToJSON(resultAsJson, result));
+	CPPUNIT_ASSERT(result.Get("@worldmodeltype").AsString().compare("RSGQueryBatchResult") == 0);
+	CPPUNIT_ASSERT(result.Get("queryId").AsString().compare("batch") == 0);
+	CPPUNIT_ASSERT(!result.Get("querySuccess").AsBool());
+	libvariant::Variant results = result.Get("results");
+	CPPUNIT_ASSERT_EQUAL(6u, static_cast<unsigned int>(results.Size()));
+	CPPUNIT_ASSERT(results.At(0).Get("rootId").AsString().compare(rootId.toString()) == 0);
+	CPPUNIT_ASSERT(results.At(1).Get("querySuccess").AsBool());
+	CPPUNIT_ASSERT(results.At(1).Get("ids").At(0).AsString().compare(groupId.toString()) == 0);
+	CPPUNIT_ASSERT(results.At(2).Get("ids").At(1).AsString().compare(pointCloudId.toString()) == 0);
+
+	/* The same query is evaluated once, but every result keeps its own queryId */
+	CPPUNIT_ASSERT(results.At(3).Get("querySuccess").AsBool());
+	CPPUNIT_ASSERT(results.At(3).Get("queryId").AsString().compare("first") == 0);
+	CPPUNIT_ASSERT(results.At(4).Get("queryId").AsString().compare("second") == 0);
+	CPPUNIT_ASSERT(results.At(3).Get("attributes").At(0).Get("value").AsString().compare("cloud") == 0);
+	CPPUNIT_ASSERT(libvariant::Serialize(results.At(3).Get("attributes"), libvariant::SERIALIZE_JSON).compare(
+			libvariant::Serialize(results.At(4).Get("attributes"), libvariant::SERIALIZE_JSON)) == 0);
+	CPPUNIT_ASSERT(results.At(5).Contains("error"));
+
+	queryAsJson = "{\"@worldmodeltype\": \"RSGQueryBatch\"}";
+	CPPUNIT_ASSERT(!queryRunner.query(queryAsJson, resultAsJson));
+	CPPUNIT_ASSERT(resultAsJson.compare("{\"error\": {\"message\": \"Syntax error: Mandatory queries list not set in RSGQueryBatch\"}}") == 0);
+
+	/* Streamed geometry results are equivalent to the regular ones */
+	queryAsJson2.str("");
+	queryAsJson2
+	<<"{"
+		<< "\"@worldmodeltype\": \"RSGQuery\","
+		<< "\"query\": \"GET_GEOMETRY\","
+		<< "\"queryId\": \"stream\","
+		<< "\"id\": \"" << pointCloudId.toString() << "\""
+	<<"}";
+	queryAsJson = queryAsJson2.str();
+	CPPUNIT_ASSERT(queryRunner.query(queryAsJson, resultAsJson));
+	JSONCollectingPort port;
+	queryRunner.setPointsPerStreamChunk(1000);
+	CPPUNIT_ASSERT(queryRunner.query(queryAsJson, &port));
+	CPPUNIT_ASSERT_EQUAL(5, port.numberOfWrites);
+
+	libvariant::Variant streamedResult;
+	CPPUNIT_ASSERT(JSONTypecaster::stringToJSON(port.data, streamedResult));
+	CPPUNIT_ASSERT(JSONTypecaster::stringToJSON(resultAsJson, result));
+	CPPUNIT_ASSERT(streamedResult.Get("queryId").AsString().compare("stream") == 0);
+	CPPUNIT_ASSERT(streamedResult.Get("querySuccess").AsBool());
+	CPPUNIT_ASSERT(streamedResult.Get("geometry").Get("@geometrytype").AsString().compare("PointCloud3DBinaryBlob") == 0);
+	CPPUNIT_ASSERT_EQUAL(5000u, streamedResult.Get("geometry").Get("numberOfPoints").AsUnsigned());
+	CPPUNIT_ASSERT(streamedResult.Get("geometry").Get("data").AsString().compare(result.Get("geometry").Get("data").AsString()) == 0);
+	CPPUNIT_ASSERT_EQUAL(result.Get("timeStamp").Get("stamp").AsDouble(), streamedResult.Get("timeStamp").Get("stamp").AsDouble());
+
+	Shape::ShapePtr resultShape;
+	CPPUNIT_ASSERT(JSONTypecaster::getShapeFromJSON(resultShape, streamedResult));
+	CPPUNIT_ASSERT_EQUAL(5000u, static_cast<unsigned int>(boost::dynamic_pointer_cast<brics_3d::rsg::PointCloud<brics_3d::PointCloud3D> >(resultShape)->data->getSize()));
+
+	/* Small geometries are written at once */
+	queryAsJson2.str("");
+	queryAsJson2
+	<<"{"
+		<< "\"@worldmodeltype\": \"RSGQuery\","
+		<< "\"query\": \"GET_GEOMETRY\","
+		<< "\"id\": \"" << sphereId.toString() << "\""
+	<<"}";
+	queryAsJson = queryAsJson2.str();
+	CPPUNIT_ASSERT(queryRunner.query(queryAsJson, resultAsJson));
+	JSONCollectingPort spherePort;
+	CPPUNIT_ASSERT(queryRunner.query(queryAsJson, &spherePort));
+	CPPUNIT_ASSERT_EQUAL(1, spherePort.numberOfWrites);
+	CPPUNIT_ASSERT(spherePort.data.compare(resultAsJson) == 0);
+
+	delete wm;
+}
+
+void JSONTest::testSpatialQuerys() {
+	brics_3d::WorldModel* wm = new brics_3d::WorldModel();
+	brics_3d::rsg::JSONQueryRunner queryRunner(wm);
+	Id rootId = wm->getRootNodeId();
+	vector<Attribute> attributes;
+
+	Id tfId;
+	Id sphere1Id;
+	Id sphere2Id;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 5,0,0));
+	CPPUNIT_ASSERT(wm->scene.addTransformNode(rootId, tfId, attributes, transform, TimeStamp(1.0)));
+	Shape::ShapePtr sphere(new Sphere(0.5));
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(rootId, sphere1Id, attributes, sphere, TimeStamp(1.0)));
+	CPPUNIT_ASSERT(wm->scene.addGeometricNode(tfId, sphere2Id, attributes, sphere, TimeStamp(1.0)));
+
+	/* Radius around the origin */
+	std::stringstream queryAsJson2;
+	queryAsJson2
+	<<"{"
+		<< "\"@worldmodeltype\": \"RSGQuery\","
+		<< "\"query\": \"GET_NODES_IN_RADIUS\","
+		<< "\"center\": {\"x\": 0.0, \"y\": 0.0, \"z\": 0.0},"
+		<< "\"radius\": 1.0"
+	<<"}";
+	std::string queryAsJson = queryAsJson2.str();
+	std::string resultAsJson = "";
+	CPPUNIT_ASSERT(queryRunner.query(queryAsJson, resultAsJson));
+	LOG(DEBUG) << "testSpatialQuerys::resultAsJson " << resultAsJson;
+	libvariant::Variant result;
+	CPPUNIT_ASSERT(JSONTypecaster::stringToJSON(resultAsJson, result));
+	CPPUNIT_ASSERT(result.Get("querySuccess").AsBool());
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(result.Get("ids").Size()));
+	CPPUNIT_ASSERT(result.Get("ids").At(0).AsString().compare(sphere1Id.toString()) == 0);
+
+	/* Box in the frame of the transform */
+	queryAsJson2.str("");
+	queryAsJson2
+	<<"{"
+		<< "\"@worldmodeltype\": \"RSGQuery\","
+		<< "\"query\": \"GET_NODES_IN_BOX\","
+		<< "\"idReferenceNode\": \"" << tfId.toString() << "\","
+		<< "\"min\": {\"x\": -0.1, \"y\": -0.1, \"z\": -0.1},"
+		<< "\"max\": {\"x\": 0.1, \"y\": 0.1, \"z\": 0.1}"
+	<<"}";
+	queryAsJson = queryAsJson2.str();
+	CPPUNIT_ASSERT(queryRunner.query(queryAsJson, resultAsJson));
+	CPPUNIT_ASSERT(JSONTypecaster::stringToJSON(resultAsJson, result));
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(result.Get("ids").Size()));
+	CPPUNIT_ASSERT(result.Get("ids").At(0).AsString().compare(sphere2Id.toString()) == 0);
+
+	/* k nearest */
+	queryAsJson2.str("");
+	queryAsJson2
+	<<"{"
+		<< "\"@worldmodeltype\": \"RSGQuery\","
+		<< "\"query\": \"GET_NEAREST_NODES\","
+		<< "\"point\": {\"x\": 4.0, \"y\": 0.0, \"z\": 0.0},"
+		<< "\"k\": 2"
+	<<"}";
+	queryAsJson = queryAsJson2.str();
+	CPPUNIT_ASSERT(queryRunner.query(queryAsJson, resultAsJson));
+	CPPUNIT_ASSERT(JSONTypecaster::stringToJSON(resultAsJson, result));
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(result.Get("ids").Size()));
+	CPPUNIT_ASSERT(result.Get("ids").At(0).AsString().compare(sphere2Id.toString()) == 0);
+	CPPUNIT_ASSERT(result.Get("ids").At(1).AsString().compare(sphere1Id.toString()) == 0);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, result.Get("distances").At(0).AsDouble(), 1e-9);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(3.5, result.Get("distances").At(1).AsDouble(), 1e-9);
+
+	/* Ray along the x axis */
+	queryAsJson2.str("");
+	queryAsJson2
+	<<"{"
+		<< "\"@worldmodeltype\": \"RSGQuery\","
+		<< "\"query\": \"GET_NODES_ALONG_RAY\","
+		<< "\"origin\": {\"x\": -2.0, \"y\": 0.0, \"z\": 0.0},"
+		<< "\"direction\": {\"x\": 1.0, \"y\": 0.0, \"z\": 0.0}"
+	<<"}";
+	queryAsJson = queryAsJson2.str();
+	CPPUNIT_ASSERT(queryRunner.query(queryAsJson, resultAsJson));
+	CPPUNIT_ASSERT(JSONTypecaster::stringToJSON(resultAsJson, result));
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(result.Get("ids").Size()));
+	CPPUNIT_ASSERT(result.Get("ids").At(0).AsString().compare(sphere1Id.toString()) == 0);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.5, result.Get("distances").At(0).AsDouble(), 1e-9);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(6.5, result.Get("distances").At(1).AsDouble(), 1e-9);
+
+	/* Missing parameter */
+	queryAsJson2.str("");
+	queryAsJson2
+	<<"{"
+		<< "\"@worldmodeltype\": \"RSGQuery\","
+		<< "\"query\": \"GET_NODES_IN_RADIUS\","
+		<< "\"center\": {\"x\": 0.0, \"y\": 0.0, \"z\": 0.0}"
+	<<"}";
+	queryAsJson = queryAsJson2.str();
+	CPPUNIT_ASSERT(!queryRunner.query(queryAsJson, resultAsJson));
+	CPPUNIT_ASSERT(JSONTypecaster::stringToJSON(resultAsJson, result));
+	CPPUNIT_ASSERT(result.Contains("error"));
+
+	delete wm;
+}
+
 }  // namespace unitTests
 
 #endif /* BRICS_JSON_ENABLE */
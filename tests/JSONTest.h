@@ -48,6 +48,13 @@ class JSONTest : public CPPUNIT_NS::TestFixture {
 	CPPUNIT_TEST( testAttributeUpdateMode );
 	CPPUNIT_TEST( testTimeStampConversion );
 	CPPUNIT_TEST( testGrahpGenerator );
+	CPPUNIT_TEST( testUpdateBatch );
+	CPPUNIT_TEST( testPointCloudBinaryBlob );
+	CPPUNIT_TEST( testTransformStreamEncoding );
+	CPPUNIT_TEST( testFastPath );
+	CPPUNIT_TEST( testSubtreeSynchronization );
+	CPPUNIT_TEST( testQueryBatch );
+	CPPUNIT_TEST( testSpatialQuerys );
 #endif /* BRICS_JSON_ENABLE */
 	CPPUNIT_TEST_SUITE_END();
 
@@ -68,6 +75,13 @@ public:
 	void testAttributeUpdateMode();
 	void testTimeStampConversion();
 	void testGrahpGenerator();
+	void testUpdateBatch();
+	void testPointCloudBinaryBlob();
+	void testTransformStreamEncoding();
+	void testFastPath();
+	void testSubtreeSynchronization();
+	void testQueryBatch();
+	void testSpatialQuerys();
 	void threadFunction(brics_3d::WorldModel* wm);
 
 private:
@@ -5506,6 +5506,1261 @@ void SceneGraphNodesTest::testNodeHash() {
 	LOG(INFO) << "All hashes for graph: " << std::endl <<hashTraverser.getJSON();
 }
 
+void SceneGraphNodesTest::testUpdateBatch() {
+	SceneGraphFacade scene;
+	MyObserver testObserver;
+	CPPUNIT_ASSERT(scene.attachUpdateObserver(&testObserver) == true);
+
+	vector<Attribute> tmpAttributes;
+	tmpAttributes.push_back(Attribute("name","batch_test"));
+	vector<Id> resultIds;
+	vector<Id> resultParentIds;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform123(new HomogeneousMatrix44(1,0,0,  	//Rotation coefficients
+	                                                             0,1,0,
+	                                                             0,0,1,
+	                                                             1,2,3)); 						//Translation coefficients
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr resultTransform;
+
+	/* Recording does not modify the scene */
+	SceneGraphUpdateBatch batch;
+	CPPUNIT_ASSERT(batch.isEmpty());
+	Id groupId = 0;
+	Id tfId = 0;
+	Id nodeId = 0;
+	CPPUNIT_ASSERT(batch.addGroup(scene.getRootId(), groupId, tmpAttributes) == true);
+	CPPUNIT_ASSERT(!groupId.isNil()); // ID is assigned while recording
+	CPPUNIT_ASSERT(batch.addTransformNode(groupId, tfId, tmpAttributes, transform123, TimeStamp(1.0)) == true);
+	CPPUNIT_ASSERT(batch.addNode(tfId, nodeId, tmpAttributes) == true);
+	CPPUNIT_ASSERT(batch.setTransform(tfId, transform123, TimeStamp(2.0)) == true);
+	CPPUNIT_ASSERT(batch.addParent(nodeId, groupId) == true);
+	CPPUNIT_ASSERT_EQUAL(5u, batch.getNumberOfUpdates());
+	CPPUNIT_ASSERT(scene.getNodes(tmpAttributes, resultIds) == true);
+	CPPUNIT_ASSERT_EQUAL(0u, static_cast<unsigned int>(resultIds.size()));
+
+	/* Apply it; the observer is called only once */
+	CPPUNIT_ASSERT(scene.applyUpdateBatch(batch) == true);
+	CPPUNIT_ASSERT(scene.getNodes(tmpAttributes, resultIds) == true);
+	CPPUNIT_ASSERT_EQUAL(3u, static_cast<unsigned int>(resultIds.size()));
+	CPPUNIT_ASSERT(scene.getNodeParents(nodeId, resultParentIds) == true);
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(resultParentIds.size()));
+	CPPUNIT_ASSERT(scene.getTransform(tfId, TimeStamp(2.0), resultTransform) == true);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, resultTransform->getRawData()[14], maxTolerance);
+
+	CPPUNIT_ASSERT_EQUAL(1, testObserver.applyUpdateBatchCounter);
+	CPPUNIT_ASSERT_EQUAL(1, testObserver.addGroupCounter); // via replay in the observer
+	CPPUNIT_ASSERT_EQUAL(1, testObserver.addTransformCounter);
+	CPPUNIT_ASSERT_EQUAL(1, testObserver.addNodeCounter);
+	CPPUNIT_ASSERT_EQUAL(1, testObserver.setTransformCounter);
+	CPPUNIT_ASSERT_EQUAL(1, testObserver.addParentCounter);
+
+	/* An invalid batch is not applied at all */
+	scene.setCallObserversEvenIfErrorsOccurred(false);
+	SceneGraphUpdateBatch invalidBatch;
+	Id validId = 0;
+	Id invalidId = 0;
+	CPPUNIT_ASSERT(invalidBatch.addGroup(groupId, validId, tmpAttributes) == true);
+	CPPUNIT_ASSERT(invalidBatch.addNode(nodeId, invalidId, tmpAttributes) == true); // a Node cannot be a parent
+	CPPUNIT_ASSERT(scene.applyUpdateBatch(invalidBatch) == false);
+	CPPUNIT_ASSERT(scene.getNodes(tmpAttributes, resultIds) == true);
+	CPPUNIT_ASSERT_EQUAL(3u, static_cast<unsigned int>(resultIds.size()));
+	CPPUNIT_ASSERT_EQUAL(1, testObserver.applyUpdateBatchCounter);
+
+	invalidBatch.clear();
+	CPPUNIT_ASSERT(invalidBatch.deleteNode(groupId) == true);
+	CPPUNIT_ASSERT(invalidBatch.setTransform(groupId, transform123, TimeStamp(3.0)) == true); // deleted within the batch
+	CPPUNIT_ASSERT(scene.applyUpdateBatch(invalidBatch) == false);
+	CPPUNIT_ASSERT(scene.getNodes(tmpAttributes, resultIds) == true);
+	CPPUNIT_ASSERT_EQUAL(3u, static_cast<unsigned int>(resultIds.size()));
+
+	invalidBatch.clear();
+	CPPUNIT_ASSERT(invalidBatch.addNode(groupId, tfId, tmpAttributes, true) == true); // ID exists already
+	CPPUNIT_ASSERT(scene.applyUpdateBatch(invalidBatch) == false);
+	CPPUNIT_ASSERT_EQUAL(1, testObserver.applyUpdateBatchCounter);
+
+	/* Updates that would be refused during the replay reject the whole batch, and it is never forwarded */
+	scene.setCallObserversEvenIfErrorsOccurred(true);
+	vector<Attribute> newAttributes;
+	newAttributes.push_back(Attribute("name","batch_test"));
+	newAttributes.push_back(Attribute("taxonomy:class","group"));
+	vector<Attribute> resultAttributes;
+	invalidBatch.clear();
+	CPPUNIT_ASSERT(invalidBatch.setNodeAttributes(groupId, newAttributes, TimeStamp(5.0)) == true);
+	CPPUNIT_ASSERT(invalidBatch.setNodeAttributes(groupId, tmpAttributes, TimeStamp(4.0)) == true); // older than the previous update
+	CPPUNIT_ASSERT(scene.applyUpdateBatch(invalidBatch) == false);
+	CPPUNIT_ASSERT(scene.getNodeAttributes(groupId, resultAttributes) == true);
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(resultAttributes.size()));
+
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform456(new HomogeneousMatrix44(1,0,0,
+	                                                             0,1,0,
+	                                                             0,0,1,
+	                                                             4,5,6));
+	invalidBatch.clear();
+	CPPUNIT_ASSERT(invalidBatch.setTransform(tfId, transform456, TimeStamp(3.0)) == true);
+	CPPUNIT_ASSERT(invalidBatch.setTransform(tfId, transform456, TimeStamp(2.0)) == true); // time stamp exists already
+	CPPUNIT_ASSERT(scene.applyUpdateBatch(invalidBatch) == false);
+	CPPUNIT_ASSERT(scene.getTransform(tfId, TimeStamp(3.0), resultTransform) == true);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, resultTransform->getRawData()[14], maxTolerance);
+
+	invalidBatch.clear();
+	CPPUNIT_ASSERT(invalidBatch.removeParent(nodeId, groupId) == true);
+	CPPUNIT_ASSERT(invalidBatch.removeParent(nodeId, groupId) == true); // relation is already removed
+	CPPUNIT_ASSERT(scene.applyUpdateBatch(invalidBatch) == false);
+	CPPUNIT_ASSERT(scene.getNodeParents(nodeId, resultParentIds) == true);
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(resultParentIds.size()));
+
+	invalidBatch.clear();
+	CPPUNIT_ASSERT(invalidBatch.removeParent(nodeId, tfId) == true);
+	CPPUNIT_ASSERT(invalidBatch.addParent(nodeId, groupId) == true); // relation exists already
+	CPPUNIT_ASSERT(scene.applyUpdateBatch(invalidBatch) == false);
+	CPPUNIT_ASSERT(scene.getNodeParents(nodeId, resultParentIds) == true);
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(resultParentIds.size()));
+
+	invalidBatch.clear();
+	CPPUNIT_ASSERT(invalidBatch.addParent(groupId, tfId) == true); // cycle
+	CPPUNIT_ASSERT(scene.applyUpdateBatch(invalidBatch) == false);
+	CPPUNIT_ASSERT_EQUAL(1, testObserver.applyUpdateBatchCounter);
+	CPPUNIT_ASSERT_EQUAL(1, testObserver.setTransformCounter);
+	CPPUNIT_ASSERT_EQUAL(1, testObserver.addParentCounter);
+	scene.setCallObserversEvenIfErrorsOccurred(false);
+
+	/* Batches can be merged and deletions are applied as well */
+	SceneGraphUpdateBatch deletions;
+	CPPUNIT_ASSERT(deletions.deleteNode(nodeId) == true);
+	SceneGraphUpdateBatch mergedBatch;
+	CPPUNIT_ASSERT(mergedBatch.deleteNode(tfId) == true);
+	CPPUNIT_ASSERT(mergedBatch.applyUpdateBatch(deletions) == true);
+	CPPUNIT_ASSERT_EQUAL(2u, mergedBatch.getNumberOfUpdates());
+	CPPUNIT_ASSERT(scene.applyUpdateBatch(mergedBatch) == true);
+	CPPUNIT_ASSERT(scene.getNodes(tmpAttributes, resultIds) == true);
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(resultIds.size()));
+	CPPUNIT_ASSERT_EQUAL(2, testObserver.applyUpdateBatchCounter);
+	CPPUNIT_ASSERT_EQUAL(2, testObserver.deleteNodeCounter);
+
+	/* IDs of deleted nodes cannot be assigned again */
+	invalidBatch.clear();
+	CPPUNIT_ASSERT(invalidBatch.addNode(groupId, nodeId, tmpAttributes, true) == true);
+	CPPUNIT_ASSERT(scene.applyUpdateBatch(invalidBatch) == false);
+	CPPUNIT_ASSERT(scene.getNodes(tmpAttributes, resultIds) == true);
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(resultIds.size()));
+	CPPUNIT_ASSERT_EQUAL(2, testObserver.applyUpdateBatchCounter);
+}
+
+
+void SceneGraphNodesTest::testPoolAllocation() {
+	/* Other tests might still hold pooled objects, so only relative values are checked */
+	PoolStatistics nodeStatsBefore = SceneGraphAllocator::getNodePoolStatistics();
+	PoolStatistics historyStatsBefore = SceneGraphAllocator::getTransformHistoryPoolStatistics();
+
+	{
+		SceneGraphFacade scene;
+		vector<Attribute> tmpAttributes;
+		Id groupId = 0;
+		Id tfId = 0;
+		Id nodeId = 0;
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform123 = SceneGraphAllocator::createTransformMatrix(HomogeneousMatrix44(1,0,0,  	//Rotation coefficients
+	                                                             0,1,0,
+	                                                             0,0,1,
+	                                                             1,2,3)); 						//Translation coefficients
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, transform123->getRawData()[14], maxTolerance);
+
+		CPPUNIT_ASSERT(scene.addGroup(scene.getRootId(), groupId, tmpAttributes));
+		CPPUNIT_ASSERT(scene.addTransformNode(groupId, tfId, tmpAttributes, transform123, TimeStamp(1.0)));
+		CPPUNIT_ASSERT(scene.addNode(tfId, nodeId, tmpAttributes));
+		for (int i = 2; i < 10; ++i) {
+			IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform = SceneGraphAllocator::createTransformMatrix();
+			CPPUNIT_ASSERT(scene.setTransform(tfId, transform, TimeStamp(i)));
+		}
+
+		PoolStatistics nodeStats = SceneGraphAllocator::getNodePoolStatistics();
+		CPPUNIT_ASSERT_EQUAL(nodeStatsBefore.objectsInUse + 3, nodeStats.objectsInUse);
+		CPPUNIT_ASSERT_EQUAL(nodeStatsBefore.allocations + 3, nodeStats.allocations);
+		CPPUNIT_ASSERT(nodeStats.bytesInUse > nodeStatsBefore.bytesInUse);
+		CPPUNIT_ASSERT(nodeStats.peakObjectsInUse >= nodeStats.objectsInUse);
+
+		PoolStatistics historyStats = SceneGraphAllocator::getTransformHistoryPoolStatistics();
+		CPPUNIT_ASSERT_EQUAL(historyStatsBefore.objectsInUse + 9, historyStats.objectsInUse);
+
+		CPPUNIT_ASSERT(scene.deleteNode(nodeId));
+		nodeStats = SceneGraphAllocator::getNodePoolStatistics();
+		CPPUNIT_ASSERT_EQUAL(nodeStatsBefore.objectsInUse + 2, nodeStats.objectsInUse);
+	}
+
+	/* Everything is given back to the pools */
+	PoolStatistics nodeStatsAfter = SceneGraphAllocator::getNodePoolStatistics();
+	PoolStatistics historyStatsAfter = SceneGraphAllocator::getTransformHistoryPoolStatistics();
+	CPPUNIT_ASSERT_EQUAL(nodeStatsBefore.objectsInUse, nodeStatsAfter.objectsInUse);
+	CPPUNIT_ASSERT_EQUAL(nodeStatsBefore.bytesInUse, nodeStatsAfter.bytesInUse);
+	CPPUNIT_ASSERT_EQUAL(nodeStatsBefore.deallocations + 3, nodeStatsAfter.deallocations);
+	CPPUNIT_ASSERT_EQUAL(historyStatsBefore.objectsInUse, historyStatsAfter.objectsInUse);
+}
+
+void SceneGraphNodesTest::testTraversalControl() {
+	/* Graph:
+	 *        root(1)
+	 *       /       \
+	 *   group2(2)  group3(3)
+	 *    /    \     /
+	 *  node4  node5(5)
+	 *   (4)
+	 *
+	 * node5 is shared by both groups.
+	 */
+	Group::GroupPtr root(new Group());
+	root->setId(1);
+	Group::GroupPtr group2(new Group());
+	group2->setId(2);
+	Group::GroupPtr group3(new Group());
+	group3->setId(3);
+	Node::NodePtr node4(new Node());
+	node4->setId(4);
+	Node::NodePtr node5(new Node());
+	node5->setId(5);
+
+	root->addChild(group2);
+	root->addChild(group3);
+	group2->addChild(node4);
+	group2->addChild(node5);
+	group3->addChild(node5);
+
+	/* full traversal in depth first pre-order; the shared node is visited twice */
+	TraversalControlVisitor visitor;
+	root->accept(&visitor);
+	CPPUNIT_ASSERT_EQUAL(6u, static_cast<unsigned int>(visitor.collectedIDs.size()));
+	CPPUNIT_ASSERT(visitor.collectedIDs[0] == 1);
+	CPPUNIT_ASSERT(visitor.collectedIDs[1] == 2);
+	CPPUNIT_ASSERT(visitor.collectedIDs[2] == 4);
+	CPPUNIT_ASSERT(visitor.collectedIDs[3] == 5);
+	CPPUNIT_ASSERT(visitor.collectedIDs[4] == 3);
+	CPPUNIT_ASSERT(visitor.collectedIDs[5] == 5);
+	CPPUNIT_ASSERT_EQUAL(INodeVisitor::continueTraversal, visitor.getVisitControl());
+
+	/* visited set */
+	TraversalControlVisitor onceVisitor;
+	onceVisitor.setVisitEachNodeOnce(true);
+	CPPUNIT_ASSERT_EQUAL(5u, GraphTraverser::traverse(root.get(), &onceVisitor));
+	CPPUNIT_ASSERT_EQUAL(5u, static_cast<unsigned int>(onceVisitor.collectedIDs.size()));
+	CPPUNIT_ASSERT(onceVisitor.collectedIDs[4] == 3);
+
+	/* skip a sub graph */
+	TraversalControlVisitor skipVisitor;
+	skipVisitor.skipId = 2;
+	root->accept(&skipVisitor);
+	CPPUNIT_ASSERT_EQUAL(4u, static_cast<unsigned int>(skipVisitor.collectedIDs.size()));
+	CPPUNIT_ASSERT(skipVisitor.collectedIDs[0] == 1);
+	CPPUNIT_ASSERT(skipVisitor.collectedIDs[1] == 2);
+	CPPUNIT_ASSERT(skipVisitor.collectedIDs[2] == 3);
+	CPPUNIT_ASSERT(skipVisitor.collectedIDs[3] == 5);
+
+	/* early termination */
+	TraversalControlVisitor stopVisitor;
+	stopVisitor.stopId = 4;
+	root->accept(&stopVisitor);
+	CPPUNIT_ASSERT_EQUAL(3u, static_cast<unsigned int>(stopVisitor.collectedIDs.size()));
+	CPPUNIT_ASSERT(stopVisitor.collectedIDs[2] == 4);
+	CPPUNIT_ASSERT_EQUAL(INodeVisitor::continueTraversal, stopVisitor.getVisitControl());
+
+	/* depth limit */
+	TraversalControlVisitor depthVisitor;
+	depthVisitor.setMaxDepth(1);
+	root->accept(&depthVisitor);
+	CPPUNIT_ASSERT_EQUAL(3u, static_cast<unsigned int>(depthVisitor.collectedIDs.size()));
+	depthVisitor.collectedIDs.clear();
+	depthVisitor.setMaxDepth(0);
+	root->accept(&depthVisitor);
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(depthVisitor.collectedIDs.size()));
+
+	/* upwards with visited set: node5 reaches the root via two paths */
+	TraversalControlVisitor upwardsVisitor;
+	upwardsVisitor.setDirection(INodeVisitor::upwards);
+	node5->accept(&upwardsVisitor);
+	CPPUNIT_ASSERT_EQUAL(5u, static_cast<unsigned int>(upwardsVisitor.collectedIDs.size()));
+	upwardsVisitor.collectedIDs.clear();
+	upwardsVisitor.setVisitEachNodeOnce(true);
+	node5->accept(&upwardsVisitor);
+	CPPUNIT_ASSERT_EQUAL(4u, static_cast<unsigned int>(upwardsVisitor.collectedIDs.size()));
+
+	/* a deep chain must not exhaust the stack (the vector holds all handles, so the chain is not destructed recursively either) */
+	std::vector<Group::GroupPtr> chain;
+	chain.push_back(Group::GroupPtr(new Group()));
+	for (int i = 0; i < 200000; ++i) {
+		Group::GroupPtr next(new Group());
+		chain.back()->addChild(next);
+		chain.push_back(next);
+	}
+	IdCollector deepVisitor;
+	chain.front()->accept(&deepVisitor);
+	CPPUNIT_ASSERT_EQUAL(200001u, static_cast<unsigned int>(deepVisitor.collectedIDs.size()));
+}
+
+void SceneGraphNodesTest::testIncrementalOutdatedDataDeleter() {
+	SceneGraphFacade scene;
+	IncrementalOutdatedDataDeleter deleter(&scene);
+	CPPUNIT_ASSERT(scene.attachUpdateObserver(&deleter));
+
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform123(new HomogeneousMatrix44(1,0,0,  //Rotation coefficients
+	                                                             0,1,0,
+	                                                             0,0,1,
+	                                                             1,2,3)); //Translation coefficients
+	Shape::ShapePtr box(new rsg::Box(1,2,3));
+	vector<Attribute> attributes;
+
+	Id groupId;
+	Id tf1Id;
+	Id tf2Id;
+	Id staticTfId;
+	Id geometryId;
+	CPPUNIT_ASSERT(scene.addGroup(scene.getRootId(), groupId, attributes));
+	CPPUNIT_ASSERT(scene.addTransformNode(scene.getRootId(), tf1Id, attributes, transform123, TimeStamp(0, Units::Second))); // 10s default duration
+	attributes.push_back(Attribute("tf:max_duration","20s"));
+	CPPUNIT_ASSERT(scene.addTransformNode(scene.getRootId(), tf2Id, attributes, transform123, TimeStamp(0, Units::Second)));
+	attributes.clear();
+	attributes.push_back(Attribute("transformType","static"));
+	CPPUNIT_ASSERT(scene.addTransformNode(scene.getRootId(), staticTfId, attributes, transform123, TimeStamp(0, Units::Second)));
+	attributes.clear();
+	CPPUNIT_ASSERT(scene.addGeometricNode(groupId, geometryId, attributes, box, TimeStamp(1, Units::Second))); // 5s default duration
+
+	/* groups and static transforms are not indexed */
+	CPPUNIT_ASSERT_EQUAL(3u, deleter.getNumberOfIndexedNodes());
+	TimeStamp nextExpiry;
+	CPPUNIT_ASSERT(deleter.getNextExpiry(nextExpiry));
+	CPPUNIT_ASSERT(nextExpiry == TimeStamp(6, Units::Second));
+
+	/* nothing expired yet */
+	CPPUNIT_ASSERT_EQUAL(0u, deleter.deleteOutdatedData(TimeStamp(5, Units::Second)));
+
+	/* the geometry expires */
+	CPPUNIT_ASSERT_EQUAL(1u, deleter.deleteOutdatedData(TimeStamp(7, Units::Second)));
+	Shape::ShapePtr resultShape;
+	TimeStamp resultTime;
+	CPPUNIT_ASSERT(!scene.getGeometry(geometryId, resultShape, resultTime));
+	CPPUNIT_ASSERT_EQUAL(2u, deleter.getNumberOfIndexedNodes());
+
+	/* updates postpone the expiry; the heap does not grow with the number of updates */
+	for (int i = 1; i <= 8; ++i) {
+		CPPUNIT_ASSERT(scene.setTransform(tf1Id, transform123, TimeStamp(i, Units::Second)));
+	}
+	CPPUNIT_ASSERT(deleter.setTransform(tf1Id, transform123, TimeStamp(2, Units::Second))); // an older update does not shorten the lifetime
+	CPPUNIT_ASSERT(deleter.getNextExpiry(nextExpiry));
+	CPPUNIT_ASSERT(nextExpiry == TimeStamp(18, Units::Second));
+	CPPUNIT_ASSERT_EQUAL(0u, deleter.deleteOutdatedData(TimeStamp(15, Units::Second)));
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr resultTransform;
+	CPPUNIT_ASSERT(scene.getTransform(tf1Id, TimeStamp(8, Units::Second), resultTransform));
+
+	/* an externally deleted node is removed from the index */
+	CPPUNIT_ASSERT(scene.deleteNode(tf2Id));
+	CPPUNIT_ASSERT_EQUAL(1u, deleter.getNumberOfIndexedNodes());
+	CPPUNIT_ASSERT_EQUAL(1u, deleter.deleteOutdatedData(TimeStamp(100, Units::Second)));
+	CPPUNIT_ASSERT(!scene.getTransform(tf1Id, TimeStamp(8, Units::Second), resultTransform));
+	CPPUNIT_ASSERT_EQUAL(0u, deleter.getNumberOfIndexedNodes());
+	CPPUNIT_ASSERT(!deleter.getNextExpiry(nextExpiry));
+
+	/* the static transform survives */
+	CPPUNIT_ASSERT(scene.getTransform(staticTfId, TimeStamp(0, Units::Second), resultTransform));
+
+	/* a transform that stops being static is indexed; a changed tf:max_duration is applied */
+	attributes.clear();
+	CPPUNIT_ASSERT(scene.setNodeAttributes(staticTfId, attributes));
+	CPPUNIT_ASSERT_EQUAL(1u, deleter.getNumberOfIndexedNodes());
+	CPPUNIT_ASSERT(deleter.getNextExpiry(nextExpiry));
+	CPPUNIT_ASSERT(nextExpiry == TimeStamp(10, Units::Second));
+	attributes.push_back(Attribute("tf:max_duration","200s"));
+	CPPUNIT_ASSERT(scene.setNodeAttributes(staticTfId, attributes));
+	CPPUNIT_ASSERT(deleter.getNextExpiry(nextExpiry));
+	CPPUNIT_ASSERT(nextExpiry == TimeStamp(200, Units::Second));
+	attributes.clear();
+	attributes.push_back(Attribute("transformType","static"));
+	CPPUNIT_ASSERT(scene.setNodeAttributes(staticTfId, attributes));
+	CPPUNIT_ASSERT_EQUAL(0u, deleter.getNumberOfIndexedNodes());
+	CPPUNIT_ASSERT_EQUAL(0u, deleter.deleteOutdatedData(TimeStamp(1000, Units::Second)));
+
+	/* transforms that are added while deletions are disabled are indexed as soon as they are enabled again */
+	attributes.clear();
+	deleter.setEnableTransformDeletions(false);
+	Id tf3Id;
+	CPPUNIT_ASSERT(scene.addTransformNode(scene.getRootId(), tf3Id, attributes, transform123, TimeStamp(0, Units::Second)));
+	CPPUNIT_ASSERT(scene.setTransform(tf3Id, transform123, TimeStamp(1, Units::Second)));
+	CPPUNIT_ASSERT_EQUAL(0u, deleter.getNumberOfIndexedNodes());
+	deleter.setEnableTransformDeletions(true);
+	CPPUNIT_ASSERT_EQUAL(1u, deleter.getNumberOfIndexedNodes());
+	CPPUNIT_ASSERT(deleter.getNextExpiry(nextExpiry));
+	CPPUNIT_ASSERT(nextExpiry == TimeStamp(11, Units::Second));
+	CPPUNIT_ASSERT_EQUAL(1u, deleter.deleteOutdatedData(TimeStamp(12, Units::Second)));
+	CPPUNIT_ASSERT(!scene.getTransform(tf3Id, TimeStamp(1, Units::Second), resultTransform));
+	CPPUNIT_ASSERT(scene.getTransform(staticTfId, TimeStamp(0, Units::Second), resultTransform));
+
+	/* a time budget spreads the work over multiple passes; at least one node is deleted per pass */
+	for (int i = 0; i < 100; ++i) {
+		Id id;
+		CPPUNIT_ASSERT(scene.addGeometricNode(groupId, id, attributes, box, TimeStamp(i, Units::MilliSecond)));
+	}
+	CPPUNIT_ASSERT_EQUAL(100u, deleter.getNumberOfIndexedNodes());
+	unsigned int deletions = deleter.deleteOutdatedData(TimeStamp(10, Units::Second), Duration(1, Units::NanoSecond));
+	CPPUNIT_ASSERT(deletions >= 1u);
+	CPPUNIT_ASSERT(deletions < 100u);
+	deletions += deleter.deleteOutdatedData(TimeStamp(10, Units::Second));
+	CPPUNIT_ASSERT_EQUAL(100u, deletions);
+	vector<Id> childIds;
+	CPPUNIT_ASSERT(scene.getGroupChildren(groupId, childIds));
+	CPPUNIT_ASSERT_EQUAL(0u, static_cast<unsigned int>(childIds.size()));
+
+	/* a changed maximum duration re-keys the already indexed geometric nodes */
+	CPPUNIT_ASSERT(scene.addGeometricNode(groupId, geometryId, attributes, box, TimeStamp(1, Units::Second)));
+	CPPUNIT_ASSERT(deleter.getNextExpiry(nextExpiry));
+	CPPUNIT_ASSERT(nextExpiry == TimeStamp(6, Units::Second));
+	deleter.setMaxGeometricNodeDuration(Duration(2, Units::Second));
+	CPPUNIT_ASSERT(deleter.getNextExpiry(nextExpiry));
+	CPPUNIT_ASSERT(nextExpiry == TimeStamp(3, Units::Second));
+	deleter.setMaxGeometricNodeDuration(Duration(20, Units::Second));
+	CPPUNIT_ASSERT(deleter.getNextExpiry(nextExpiry));
+	CPPUNIT_ASSERT(nextExpiry == TimeStamp(21, Units::Second));
+	CPPUNIT_ASSERT_EQUAL(0u, deleter.deleteOutdatedData(TimeStamp(10, Units::Second)));
+	deleter.setEnableGeometricNodeDeletions(false);
+	deleter.setMaxGeometricNodeDuration(Duration(5, Units::Second));
+	deleter.setEnableGeometricNodeDeletions(true);
+	CPPUNIT_ASSERT(deleter.getNextExpiry(nextExpiry));
+	CPPUNIT_ASSERT(nextExpiry == TimeStamp(6, Units::Second));
+
+	/* nodes that exist before the deleter is created are indexed as well */
+	IncrementalOutdatedDataDeleter lateDeleter(&scene);
+	CPPUNIT_ASSERT_EQUAL(1u, lateDeleter.getNumberOfIndexedNodes()); // the static transform is tracked but not indexed
+	CPPUNIT_ASSERT(lateDeleter.getNextExpiry(nextExpiry));
+	CPPUNIT_ASSERT(nextExpiry == TimeStamp(6, Units::Second));
+	CPPUNIT_ASSERT_EQUAL(0u, lateDeleter.indexExistingNodes());
+	CPPUNIT_ASSERT(scene.attachUpdateObserver(&lateDeleter));
+	CPPUNIT_ASSERT_EQUAL(1u, lateDeleter.deleteOutdatedData(TimeStamp(7, Units::Second)));
+	CPPUNIT_ASSERT(!scene.getGeometry(geometryId, resultShape, resultTime));
+	CPPUNIT_ASSERT(scene.detachUpdateObserver(&lateDeleter));
+}
+
+void SceneGraphNodesTest::testMerkleSynchronization() {
+	SceneGraphFacade source;
+	SceneGraphFacade replica;
+	MerkleSynchronizer sourceSynchronizer(&source);
+	MerkleSynchronizer replicaSynchronizer(&replica);
+	vector<Attribute> attributes;
+	Id rootId = source.getRootId();
+	CPPUNIT_ASSERT(replica.addRemoteRootNode(rootId, attributes));
+	CPPUNIT_ASSERT(replica.addParent(rootId, replica.getRootId()));
+
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform123(new HomogeneousMatrix44(1,0,0,  //Rotation coefficients
+	                                                             0,1,0,
+	                                                             0,0,1,
+	                                                             1,2,3)); //Translation coefficients
+	Shape::ShapePtr box(new rsg::Box(1,2,3));
+
+	/*
+	 * root
+	 *  |- group1 -- node_0 ... node_49, sharedNode
+	 *  |- group2 -- tf -- geometry
+	 *            |- sharedNode
+	 *            |- connection (node_0 -> geometry)
+	 */
+	Id group1Id;
+	Id group2Id;
+	Id tfId;
+	Id geometryId;
+	Id sharedNodeId;
+	Id connectionId;
+	vector<Id> nodeIds;
+	attributes.push_back(Attribute("name","group1"));
+	CPPUNIT_ASSERT(source.addGroup(rootId, group1Id, attributes));
+	for (int i = 0; i < 50; ++i) {
+		Id nodeId;
+		std::stringstream name;
+		name << "node_" << i;
+		attributes.clear();
+		attributes.push_back(Attribute("name", name.str()));
+		CPPUNIT_ASSERT(source.addNode(group1Id, nodeId, attributes));
+		nodeIds.push_back(nodeId);
+	}
+	attributes.clear();
+	CPPUNIT_ASSERT(source.addGroup(rootId, group2Id, attributes));
+	CPPUNIT_ASSERT(source.addTransformNode(group2Id, tfId, attributes, transform123, TimeStamp(1.0)));
+	CPPUNIT_ASSERT(source.addGeometricNode(tfId, geometryId, attributes, box, TimeStamp(1.0)));
+	CPPUNIT_ASSERT(source.addNode(group1Id, sharedNodeId, attributes));
+	CPPUNIT_ASSERT(source.addParent(sharedNodeId, group2Id));
+	vector<Id> sourceIds;
+	vector<Id> targetIds;
+	sourceIds.push_back(nodeIds[0]);
+	targetIds.push_back(geometryId);
+	CPPUNIT_ASSERT(source.addConnection(group2Id, connectionId, attributes, sourceIds, targetIds, TimeStamp(1.0), TimeStamp(2.0)));
+
+	/* Initial synchronization */
+	CPPUNIT_ASSERT(sourceSynchronizer.getSubtreeHash(rootId).compare(replicaSynchronizer.getSubtreeHash(rootId)) != 0);
+	CPPUNIT_ASSERT(replicaSynchronizer.synchronizeFrom(sourceSynchronizer, rootId));
+	CPPUNIT_ASSERT(sourceSynchronizer.getSubtreeHash(rootId).compare(replicaSynchronizer.getSubtreeHash(rootId)) == 0);
+
+	vector<Id> resultIds;
+	CPPUNIT_ASSERT(replica.getGroupChildren(group1Id, resultIds));
+	CPPUNIT_ASSERT_EQUAL(51u, static_cast<unsigned int>(resultIds.size()));
+	resultIds.clear();
+	CPPUNIT_ASSERT(replica.getNodeParents(sharedNodeId, resultIds));
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(resultIds.size()));
+	resultIds.clear();
+	CPPUNIT_ASSERT(replica.getConnectionTargetIds(connectionId, resultIds));
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(resultIds.size()));
+	CPPUNIT_ASSERT(resultIds[0] == geometryId);
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr resultTransform;
+	CPPUNIT_ASSERT(replica.getTransform(tfId, TimeStamp(1.0), resultTransform));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, resultTransform->getRawData()[matrixEntry::z], maxTolerance);
+	Shape::ShapePtr resultShape;
+	TimeStamp resultStamp;
+	CPPUNIT_ASSERT(replica.getGeometry(geometryId, resultShape, resultStamp));
+	CPPUNIT_ASSERT(resultStamp == TimeStamp(1.0));
+
+	/* Graphs in sync: only the root digest is exchanged */
+	replicaSynchronizer.resetStatistics();
+	CPPUNIT_ASSERT(replicaSynchronizer.synchronizeFrom(sourceSynchronizer, rootId));
+	CPPUNIT_ASSERT_EQUAL(1u, replicaSynchronizer.getStatistics().rounds);
+	CPPUNIT_ASSERT_EQUAL(1u, replicaSynchronizer.getStatistics().receivedDigests);
+
+	/* A few changes after a "network dropout" */
+	attributes.clear();
+	attributes.push_back(Attribute("name","renamed"));
+	CPPUNIT_ASSERT(source.setNodeAttributes(nodeIds[10], attributes));
+	CPPUNIT_ASSERT(source.deleteNode(nodeIds[20]));
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform456(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 4,5,6));
+	CPPUNIT_ASSERT(source.setTransform(tfId, transform456, TimeStamp(2.0)));
+	Id group3Id;
+	Id node3Id;
+	attributes.clear();
+	CPPUNIT_ASSERT(source.addGroup(group2Id, group3Id, attributes));
+	CPPUNIT_ASSERT(source.addNode(group3Id, node3Id, attributes));
+	CPPUNIT_ASSERT(source.addParent(sharedNodeId, group3Id)); // shared with existing parents
+
+	replicaSynchronizer.resetStatistics();
+	CPPUNIT_ASSERT(replicaSynchronizer.synchronizeFrom(sourceSynchronizer, rootId));
+	CPPUNIT_ASSERT(sourceSynchronizer.getSubtreeHash(rootId).compare(replicaSynchronizer.getSubtreeHash(rootId)) == 0);
+	const MerkleSynchronizer::Statistics& statistics = replicaSynchronizer.getStatistics();
+	LOG(INFO) << "SceneGraphNodesTest::testMerkleSynchronization: rounds = " << statistics.rounds << ", digests = " << statistics.receivedDigests;
+	CPPUNIT_ASSERT_EQUAL(1u, statistics.requestedSubtrees); // group3
+	CPPUNIT_ASSERT_EQUAL(2u, statistics.requestedRefreshes); // node_10 and tf
+	CPPUNIT_ASSERT_EQUAL(1u, statistics.addedParents); // sharedNode to group3
+	CPPUNIT_ASSERT_EQUAL(1u, statistics.removedParents); // node_20
+	CPPUNIT_ASSERT(statistics.receivedDigests < 10u); // proportional to the changes, not to the 50 nodes of group1
+
+	attributes.clear();
+	CPPUNIT_ASSERT(replica.getNodeAttributes(nodeIds[10], attributes));
+	CPPUNIT_ASSERT(attributes[0] == Attribute("name","renamed"));
+	CPPUNIT_ASSERT(!replica.getNodeAttributes(nodeIds[20], attributes));
+	CPPUNIT_ASSERT(replica.getTransform(tfId, TimeStamp(2.0), resultTransform));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(6.0, resultTransform->getRawData()[matrixEntry::z], maxTolerance);
+	resultIds.clear();
+	CPPUNIT_ASSERT(replica.getNodeParents(sharedNodeId, resultIds));
+	CPPUNIT_ASSERT_EQUAL(3u, static_cast<unsigned int>(resultIds.size()));
+	resultIds.clear();
+	CPPUNIT_ASSERT(replica.getGroupChildren(group3Id, resultIds));
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(resultIds.size()));
+}
+
+void SceneGraphNodesTest::testAttributeQuery() {
+
+	/* Classification */
+	CPPUNIT_ASSERT_EQUAL(AttributeQuery::ANY, AttributeQuery::classifyPattern("*"));
+	CPPUNIT_ASSERT_EQUAL(AttributeQuery::ANY, AttributeQuery::classifyPattern("^.*"));
+	CPPUNIT_ASSERT_EQUAL(AttributeQuery::ANY, AttributeQuery::classifyPattern(".*"));
+	CPPUNIT_ASSERT_EQUAL(AttributeQuery::EXACT, AttributeQuery::classifyPattern("Goal Area"));
+	CPPUNIT_ASSERT_EQUAL(AttributeQuery::EXACT, AttributeQuery::classifyPattern("^name$"));
+	CPPUNIT_ASSERT_EQUAL(AttributeQuery::PREFIX, AttributeQuery::classifyPattern("osm:.*"));
+	CPPUNIT_ASSERT_EQUAL(AttributeQuery::WILDCARD, AttributeQuery::classifyPattern(".*Area"));
+	CPPUNIT_ASSERT_EQUAL(AttributeQuery::WILDCARD, AttributeQuery::classifyPattern("a.*b.*c"));
+	CPPUNIT_ASSERT_EQUAL(AttributeQuery::REGEX, AttributeQuery::classifyPattern("box_[0-9]+"));
+	CPPUNIT_ASSERT_EQUAL(AttributeQuery::REGEX, AttributeQuery::classifyPattern("a.b"));
+	CPPUNIT_ASSERT_EQUAL(AttributeQuery::REGEX, AttributeQuery::classifyPattern("price\\$"));
+	CPPUNIT_ASSERT_EQUAL(AttributeQuery::INVALID, AttributeQuery::classifyPattern("box_[0-9"));
+
+	/* Same results as plain regular expressions */
+	vector<Attribute> attributes;
+	attributes.push_back(Attribute("name", "Goal Area"));
+	attributes.push_back(Attribute("osm:building", "yes"));
+	attributes.push_back(Attribute("label", "abxbyc"));
+	attributes.push_back(Attribute("price", "5$"));
+
+	const char* patterns[] = {"*", ".*", "^.*", "name", "Goal Area", "Goal", "^name$", "osm:.*", "osm:b.*", "osm:x.*", ".*Area", ".*Are",
+			"G.*l.*a", "a.*b.*c", "ab.*by.*c", "abx.*xbyc", ".*:.*", "n.me", "[a-z]+", "price\\$", "5\\$", "", "^", "box_[0-9"};
+	for (unsigned int i = 0; i < sizeof(patterns) / sizeof(patterns[0]); ++i) {
+		for (unsigned int j = 0; j < attributes.size(); ++j) {
+			bool expected = false;
+			try {
+				string pattern = (string(patterns[i]).compare("*") == 0) ? "^.*" : patterns[i];
+				boost::regex expression(pattern);
+				expected = boost::regex_match(attributes[j].value, expression);
+			} catch (std::exception& e) {
+				expected = false;
+			}
+			vector<Attribute> singleAttribute(1, attributes[j]);
+			AttributeQuery query(vector<Attribute>(1, Attribute("*", patterns[i])));
+			CPPUNIT_ASSERT_MESSAGE(string(patterns[i]) + " on " + attributes[j].value, expected == query.matches(singleAttribute));
+			CPPUNIT_ASSERT_EQUAL(expected, attributeListContainsAttribute(singleAttribute, Attribute("*", patterns[i])));
+		}
+	}
+
+	/* Conjunction and disjunction */
+	vector<Attribute> queryAttributes;
+	queryAttributes.push_back(Attribute("name", "Goal.*"));
+	queryAttributes.push_back(Attribute("shapeType", "Box"));
+	AttributeQuery andQuery(queryAttributes);
+	AttributeQuery orQuery(queryAttributes, AttributeQuery::OR);
+	CPPUNIT_ASSERT_EQUAL(2u, andQuery.getPredicateCount());
+	CPPUNIT_ASSERT_EQUAL(AttributeQuery::PREFIX, andQuery.getValuePatternType(0));
+	CPPUNIT_ASSERT_EQUAL(AttributeQuery::EXACT, andQuery.getKeyPatternType(1));
+	CPPUNIT_ASSERT(!andQuery.matches(attributes));
+	CPPUNIT_ASSERT(orQuery.matches(attributes));
+	attributes.push_back(Attribute("shapeType", "Box"));
+	CPPUNIT_ASSERT(andQuery.matches(attributes));
+	CPPUNIT_ASSERT(!AttributeQuery().matches(attributes));
+
+	/* Reuse for scene graph queries */
+	SceneGraphFacade scene;
+	vector<Attribute> goalAttributes;
+	goalAttributes.push_back(Attribute("name", "Goal Area"));
+	vector<Attribute> boxAttributes;
+	boxAttributes.push_back(Attribute("shapeType", "Box"));
+	Id goalId;
+	Id boxId;
+	Id otherId;
+	CPPUNIT_ASSERT(scene.addGroup(scene.getRootId(), goalId, goalAttributes));
+	CPPUNIT_ASSERT(scene.addGroup(goalId, boxId, boxAttributes));
+	CPPUNIT_ASSERT(scene.addGroup(scene.getRootId(), otherId, vector<Attribute>(1, Attribute("name", "other"))));
+	CPPUNIT_ASSERT(scene.addParent(boxId, scene.getRootId())); // reached twice
+
+	vector<Id> ids;
+	CPPUNIT_ASSERT(scene.getNodes(orQuery, ids));
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT(scene.getNodes(andQuery, ids));
+	CPPUNIT_ASSERT_EQUAL(0u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT(scene.getNodes(orQuery, ids, goalId));
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT(scene.getNodes(queryAttributes, ids));
+	CPPUNIT_ASSERT_EQUAL(0u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT(scene.getNodes(boxAttributes, ids));
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT(boxId == ids[0]);
+}
+
+void SceneGraphNodesTest::testCachedPointCloudAccumulator() {
+	/* Graph structure:
+	 *             root
+	 *              |
+	 *        ------+-------
+	 *        |            |
+	 *       pc1          tf1
+	 *                     |
+	 *                    pc2
+	 */
+	SceneGraphFacade scene;
+	vector<Attribute> attributes;
+	Id tf1Id, pc1Id, pc2Id, pc3Id;
+	const double eps = 1e-9;
+	const TimeStamp now(10.0);
+
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr translation10(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 10,0,0));
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr translation20(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 20,0,0));
+	CPPUNIT_ASSERT(scene.addTransformNode(scene.getRootId(), tf1Id, attributes, translation10, TimeStamp(1.0)));
+
+	PointCloud<PointCloud3D>::PointCloudPtr pc1Container(new PointCloud<PointCloud3D>());
+	pc1Container->data = PointCloud3D::PointCloud3DPtr(new PointCloud3D());
+	pc1Container->data->addPoint(Point3D(1,2,3));
+	pc1Container->data->addPoint(Point3D(4,5,6));
+	pc1Container->data->addPoint(Point3D(7,8,9));
+	CPPUNIT_ASSERT(scene.addGeometricNode(scene.getRootId(), pc1Id, attributes, pc1Container, TimeStamp(1.0)));
+
+	/* attached after the first point cloud has been added: it has to be picked up by the initial scan */
+	CachedPointCloudAccumulator accumulator(&scene, scene.getRootId());
+	scene.attachUpdateObserver(&accumulator);
+	CPPUNIT_ASSERT(accumulator.update(now));
+	CPPUNIT_ASSERT_EQUAL(3u, accumulator.getPointCount());
+
+	PointCloud<PointCloud3D>::PointCloudPtr pc2Container(new PointCloud<PointCloud3D>());
+	pc2Container->data = PointCloud3D::PointCloud3DPtr(new PointCloud3D());
+	pc2Container->data->addPoint(Point3D(1,0,0));
+	pc2Container->data->addPoint(Point3D(2,0,0));
+	CPPUNIT_ASSERT(scene.addGeometricNode(tf1Id, pc2Id, attributes, pc2Container, TimeStamp(1.0)));
+
+	CPPUNIT_ASSERT_EQUAL(3u, accumulator.getPointCount()); // nothing happens before update()
+	CPPUNIT_ASSERT(accumulator.update(now));
+	CPPUNIT_ASSERT_EQUAL(2u, accumulator.getPointCloudCount());
+	CPPUNIT_ASSERT_EQUAL(5u, accumulator.getPointCount());
+	CPPUNIT_ASSERT_EQUAL(2u, accumulator.getTransformQueryCount());
+	CPPUNIT_ASSERT_EQUAL(5ull, accumulator.getTransformedPointCount());
+	const std::vector<Coordinate>& points = accumulator.getAccumulatedPoints();
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, points[0], eps); // pc1
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(9.0, points[8], eps);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(11.0, points[9], eps); // pc2
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(12.0, points[12], eps);
+
+	/* memoized: no further queries */
+	CPPUNIT_ASSERT(accumulator.update(now));
+	CPPUNIT_ASSERT_EQUAL(2u, accumulator.getTransformQueryCount());
+	CPPUNIT_ASSERT_EQUAL(5ull, accumulator.getTransformedPointCount());
+
+	/* only the point cloud below tf1 is affected */
+	CPPUNIT_ASSERT(scene.setTransform(tf1Id, translation20, TimeStamp(2.0)));
+	CPPUNIT_ASSERT(accumulator.update(now));
+	CPPUNIT_ASSERT_EQUAL(3u, accumulator.getTransformQueryCount());
+	CPPUNIT_ASSERT_EQUAL(7ull, accumulator.getTransformedPointCount());
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(21.0, accumulator.getAccumulatedPoints()[9], eps);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(22.0, accumulator.getAccumulatedPoints()[12], eps);
+
+	/* an unchanged transform does not cause the points to be transformed again */
+	CPPUNIT_ASSERT(scene.setTransform(tf1Id, translation20, TimeStamp(3.0)));
+	CPPUNIT_ASSERT(accumulator.update(now));
+	CPPUNIT_ASSERT_EQUAL(4u, accumulator.getTransformQueryCount());
+	CPPUNIT_ASSERT_EQUAL(7ull, accumulator.getTransformedPointCount());
+
+	/* incremental additions and deletions */
+	PointCloud<PointCloud3D>::PointCloudPtr pc3Container(new PointCloud<PointCloud3D>());
+	pc3Container->data = PointCloud3D::PointCloud3DPtr(new PointCloud3D());
+	pc3Container->data->addPoint(Point3D(-1,-1,-1));
+	CPPUNIT_ASSERT(scene.addGeometricNode(scene.getRootId(), pc3Id, attributes, pc3Container, TimeStamp(4.0)));
+	CPPUNIT_ASSERT(accumulator.update(now));
+	CPPUNIT_ASSERT_EQUAL(6u, accumulator.getPointCount());
+	CPPUNIT_ASSERT_EQUAL(5u, accumulator.getTransformQueryCount());
+	CPPUNIT_ASSERT_EQUAL(8ull, accumulator.getTransformedPointCount());
+
+	CPPUNIT_ASSERT(scene.deleteNode(pc1Id));
+	CPPUNIT_ASSERT(accumulator.update(now));
+	CPPUNIT_ASSERT_EQUAL(2u, accumulator.getPointCloudCount());
+	CPPUNIT_ASSERT_EQUAL(3u, accumulator.getPointCount());
+	CPPUNIT_ASSERT_EQUAL(5u, accumulator.getTransformQueryCount());
+	CPPUNIT_ASSERT_EQUAL(8ull, accumulator.getTransformedPointCount()); // points are only shifted
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(21.0, accumulator.getAccumulatedPoints()[0], eps);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(22.0, accumulator.getAccumulatedPoints()[3], eps);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(-1.0, accumulator.getAccumulatedPoints()[6], eps);
+
+	PointCloud3D result;
+	accumulator.getAccumulatedPointCloud(result);
+	CPPUNIT_ASSERT_EQUAL(3u, result.getSize());
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(-1.0, (*result.getPointCloud())[2].getZ(), eps);
+
+	/* subgraph and structural changes; a point cloud with multiple parents contributes once */
+	CachedPointCloudAccumulator subgraphAccumulator(&scene, scene.getRootId(), tf1Id);
+	scene.attachUpdateObserver(&subgraphAccumulator);
+	CPPUNIT_ASSERT(subgraphAccumulator.update(now));
+	CPPUNIT_ASSERT_EQUAL(2u, subgraphAccumulator.getPointCount());
+
+	CPPUNIT_ASSERT(scene.addParent(pc3Id, tf1Id));
+	CPPUNIT_ASSERT(subgraphAccumulator.update(now));
+	CPPUNIT_ASSERT_EQUAL(3u, subgraphAccumulator.getPointCount());
+	CPPUNIT_ASSERT(accumulator.update(now));
+	CPPUNIT_ASSERT_EQUAL(3u, accumulator.getPointCount());
+
+	CPPUNIT_ASSERT(scene.removeParent(pc3Id, tf1Id));
+	CPPUNIT_ASSERT(subgraphAccumulator.update(now));
+	CPPUNIT_ASSERT_EQUAL(2u, subgraphAccumulator.getPointCount());
+
+	/* batched kernel matches Point3D::homogeneousTransformation */
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr rotation(new HomogeneousMatrix44(0,-1,0, 1,0,0, 0,0,1, 1,2,3));
+	double expected[9];
+	double transformed[9];
+	for (unsigned int i = 0; i < pc1Container->data->getSize(); ++i) {
+		Point3D point = (*pc1Container->data->getPointCloud())[i];
+		point.homogeneousTransformation(rotation.get());
+		expected[i*3] = point.getX();
+		expected[i*3+1] = point.getY();
+		expected[i*3+2] = point.getZ();
+	}
+	CachedPointCloudAccumulator::transformPoints(pc1Container->data.get(), rotation.get(), transformed);
+	for (unsigned int i = 0; i < 9; ++i) {
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i], transformed[i], eps);
+	}
+}
+
+/// Forwards to a PointCloud3DIterator, but relies on the default nextBlock() adapter.
+class LegacyPointIterator : public IPoint3DIterator {
+public:
+	LegacyPointIterator(IPoint3DIterator* iterator) : iterator(iterator) {};
+	std::string getPointCloudTypeName() { return iterator->getPointCloudTypeName(); }
+	void begin() { iterator->begin(); }
+	void next() { iterator->next(); }
+	bool end() { return iterator->end(); }
+	Coordinate getX() { return iterator->getX(); }
+	Coordinate getY() { return iterator->getY(); }
+	Coordinate getZ() { return iterator->getZ(); }
+	Point3D* getRawData() { return iterator->getRawData(); }
+private:
+	IPoint3DIterator* iterator;
+};
+
+void SceneGraphNodesTest::testBlockPointIterator() {
+	PointCloud3D::PointCloud3DPtr cloud1(new PointCloud3D());
+	cloud1->addPoint(Point3D(1,2,3));
+	cloud1->addPoint(Point3D(4,5,6));
+	cloud1->addPoint(Point3D(7,8,9));
+	PointCloud3D::PointCloud3DPtr emptyCloud(new PointCloud3D());
+	PointCloud3D::PointCloud3DPtr cloud2(new PointCloud3D());
+	cloud2->addPoint(Point3D(10,11,12));
+	cloud2->addPoint(Point3D(13,14,15));
+	PointCloud3D::PointCloud3DPtr cloud3(new PointCloud3D());
+	cloud3->addPoint(Point3D(20,21,22));
+	cloud3->addPoint(Point3D(23,24,25));
+	cloud3->addPoint(Point3D(26,27,28));
+
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr identity(new HomogeneousMatrix44());
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr shift100(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 100,100,100));
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr rotation(new HomogeneousMatrix44(0,-1,0, 1,0,0, 0,0,1, 1,2,3));
+
+	PointCloud3DIterator it;
+	it.insert(cloud1, identity);
+	it.insert(emptyCloud, shift100);
+	it.insert(cloud2, shift100);
+	it.insert(cloud3, rotation);
+
+	/* point wise reference */
+	std::vector<Coordinate> expected;
+	for (it.begin(); !it.end(); it.next()) {
+		expected.push_back(it.getX());
+		expected.push_back(it.getY());
+		expected.push_back(it.getZ());
+	}
+	CPPUNIT_ASSERT_EQUAL(24u, static_cast<unsigned int>(expected.size()));
+
+	/* the transforms are applied to the right clouds independent of the insertion order */
+	double sum = 0;
+	for (unsigned int i = 0; i < expected.size(); ++i) {
+		sum += expected[i];
+	}
+	double expectedSum = 45 + (75 + 600);
+	for (unsigned int i = 0; i < cloud3->getSize(); ++i) {
+		Point3D point = (*cloud3->getPointCloud())[i];
+		point.homogeneousTransformation(rotation.get());
+		expectedSum += point.getX() + point.getY() + point.getZ();
+	}
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(expectedSum, sum, maxTolerance);
+
+	/* block sizes that do and do not align with the point cloud boundaries */
+	LegacyPointIterator legacyIt(&it);
+	IPoint3DIterator* iterators[] = {&it, &legacyIt};
+	unsigned int blockSizes[] = {1, 2, 3, 5, IPoint3DIterator::defaultBlockSize};
+	std::vector<Coordinate> block(3 * IPoint3DIterator::defaultBlockSize);
+	for (unsigned int k = 0; k < 2; ++k) {
+		for (unsigned int j = 0; j < sizeof(blockSizes) / sizeof(blockSizes[0]); ++j) {
+			std::vector<Coordinate> result;
+			unsigned int count;
+			for (iterators[k]->begin(); (count = iterators[k]->nextBlock(&block[0], blockSizes[j])) > 0; ) {
+				CPPUNIT_ASSERT(count <= blockSizes[j]);
+				result.insert(result.end(), block.begin(), block.begin() + 3 * count);
+			}
+			CPPUNIT_ASSERT(iterators[k]->end());
+			CPPUNIT_ASSERT_EQUAL(0u, iterators[k]->nextBlock(&block[0], blockSizes[j]));
+			CPPUNIT_ASSERT_EQUAL(expected.size(), result.size());
+			for (unsigned int i = 0; i < expected.size(); ++i) {
+				CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[i], result[i], maxTolerance);
+			}
+		}
+	}
+
+	/* mixed point and block wise access */
+	it.begin();
+	it.next();
+	CPPUNIT_ASSERT_EQUAL(3u, it.nextBlock(&block[0], 3));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[3], block[0], maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(expected[12], it.getX(), maxTolerance);
+
+	/* empty iterator */
+	PointCloud3DIterator emptyIt;
+	emptyIt.begin();
+	CPPUNIT_ASSERT_EQUAL(0u, emptyIt.nextBlock(&block[0], 1));
+
+	/* block wise centroid */
+	Centroid3D centroidExtractor;
+	IPoint3DIterator::IPoint3DIteratorPtr sharedIt(new PointCloud3DIterator());
+	boost::dynamic_pointer_cast<PointCloud3DIterator>(sharedIt)->insert(cloud1);
+	Eigen::Vector3d centroid = centroidExtractor.computeCentroid(sharedIt);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(4.0, centroid[0], maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(5.0, centroid[1], maxTolerance);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(6.0, centroid[2], maxTolerance);
+}
+
+void SceneGraphNodesTest::testNodeHash128() {
+
+	/* MurmurHash3 reference values */
+	CPPUNIT_ASSERT(NodeHash::bytesToHash128("", 0) == Hash128(0, 0));
+	CPPUNIT_ASSERT(NodeHash::bytesToHash128("hello", 5) == Hash128(0xcbd8a7b341bd9b02ULL, 0x5b1e906a48ae1d19ULL));
+	string fox = "The quick brown fox jumps over the lazy dog";
+	CPPUNIT_ASSERT(NodeHash::bytesToHash128(fox.c_str(), fox.size()) == Hash128(0xe34bbc7bbc071b6cULL, 0x7a433ca9c49a9347ULL));
+	CPPUNIT_ASSERT(NodeHash::bytesToHash128(fox.c_str(), fox.size(), 1) != NodeHash::bytesToHash128(fox.c_str(), fox.size()));
+	CPPUNIT_ASSERT_EQUAL(string("cbd8a7b341bd9b025b1e906a48ae1d19"), NodeHash::bytesToHash128("hello", 5).toString());
+
+	/* 128 bit addition with carry */
+	Hash128 sum(0, 0xFFFFFFFFFFFFFFFFULL);
+	sum += Hash128(1, 1);
+	CPPUNIT_ASSERT(sum == Hash128(2, 0));
+
+	/* attributes */
+	vector<Attribute> attributes;
+	attributes.push_back(Attribute("name","test"));
+	attributes.push_back(Attribute("taskType","targetArea"));
+	vector<Attribute> reorderedAttributes;
+	reorderedAttributes.push_back(Attribute("taskType","targetArea"));
+	reorderedAttributes.push_back(Attribute("name","test"));
+	vector<Attribute> swappedAttributes;
+	swappedAttributes.push_back(Attribute("test","name"));
+	swappedAttributes.push_back(Attribute("taskType","targetArea"));
+	vector<Attribute> duplicatedAttributes = attributes;
+	duplicatedAttributes.push_back(Attribute("name","test"));
+	duplicatedAttributes.push_back(Attribute("name","test"));
+
+	CPPUNIT_ASSERT(NodeHash::attributesToHash128(attributes) == NodeHash::attributesToHash128(reorderedAttributes));
+	CPPUNIT_ASSERT(NodeHash::attributesToHash128(attributes) != NodeHash::attributesToHash128(swappedAttributes));
+	CPPUNIT_ASSERT(NodeHash::attributesToHash128(attributes) != NodeHash::attributesToHash128(duplicatedAttributes)); // duplicates do not cancel out
+	CPPUNIT_ASSERT(NodeHash::attributesToHash128(attributes) != NodeHash::attributesToHash128(vector<Attribute>()));
+
+	/* nodes and the cached attribute hash */
+	Id id;
+	id.fromString("6f7b4a5c-4b6a-4d48-9c0a-6a0c3c3c0b2a");
+	Node::NodePtr node1(new Node());
+	node1->setId(id);
+	Hash128 cachedHash;
+	CPPUNIT_ASSERT(!node1->getCachedAttributesHash(cachedHash));
+	node1->setAttributes(attributes);
+	Hash128 nodeHash1 = NodeHash::nodeToHash128(node1.get());
+	CPPUNIT_ASSERT(node1->getCachedAttributesHash(cachedHash));
+	CPPUNIT_ASSERT(cachedHash == NodeHash::attributesToHash128(attributes));
+	CPPUNIT_ASSERT(nodeHash1 == NodeHash::nodeToHash128(node1.get()));
+
+	Node::NodePtr node2(new Node());
+	node2->setId(id);
+	node2->setAttributes(reorderedAttributes);
+	CPPUNIT_ASSERT(nodeHash1 == NodeHash::nodeToHash128(node2.get()));
+
+	node2->setAttributes(swappedAttributes); // invalidates the cache
+	CPPUNIT_ASSERT(!node2->getCachedAttributesHash(cachedHash));
+	CPPUNIT_ASSERT(nodeHash1 != NodeHash::nodeToHash128(node2.get()));
+	node2->setAttributes(attributes);
+	Id id2;
+	id2.fromString("0b9a34c8-6f0e-4c2c-b7d8-5d4b3a9c1e21");
+	node2->setId(id2);
+	CPPUNIT_ASSERT(nodeHash1 != NodeHash::nodeToHash128(node2.get()));
+	CPPUNIT_ASSERT(NodeHash::nodeToHash128(node1.get(), false) == NodeHash::nodeToHash128(node2.get(), false));
+
+	/* graphs */
+	UuidGenerator idGenerator(1u);
+	Group::GroupPtr root1(new Group());
+	Group::GroupPtr group1(new Group());
+	Node::NodePtr leaf1(new Node());
+	Node::NodePtr leaf2(new Node());
+	leaf1->setAttributes(attributes);
+	root1->addChild(group1);
+	group1->addChild(leaf1);
+	group1->addChild(leaf2);
+	root1->addChild(leaf2); // shared sub graph
+
+	Group::GroupPtr root2(new Group());
+	Group::GroupPtr group2(new Group());
+	Node::NodePtr leaf3(new Node());
+	Node::NodePtr leaf4(new Node());
+	leaf3->setAttributes(reorderedAttributes);
+	root2->addChild(leaf4);
+	root2->addChild(group2);
+	group2->addChild(leaf4);
+	group2->addChild(leaf3); // same structure, different order
+	Node* graphNodes[] = {root1.get(), group1.get(), leaf1.get(), leaf2.get(), root2.get(), group2.get(), leaf3.get(), leaf4.get()};
+	for (unsigned int i = 0; i < 8; ++i) {
+		graphNodes[i]->setId(idGenerator.getNextValidId());
+	}
+
+	NodeHashTraverser hashTraverser;
+	hashTraverser.reset(true, false, NodeHashTraverser::BINARY_128);
+	root1->accept(&hashTraverser);
+	Hash128 rootHash1;
+	CPPUNIT_ASSERT(hashTraverser.getHash128ById(root1->getId(), rootHash1));
+	CPPUNIT_ASSERT_EQUAL(rootHash1.toString(), hashTraverser.getHashById(root1->getId()));
+	CPPUNIT_ASSERT(hashTraverser.getHash128ById(leaf2->getId(), cachedHash));
+	CPPUNIT_ASSERT(!hashTraverser.getHash128ById(root2->getId(), cachedHash));
+	CPPUNIT_ASSERT(hashTraverser.getHashById(root2->getId()).compare(NodeHashTraverser::NIL) == 0);
+
+	hashTraverser.reset(true, false, NodeHashTraverser::BINARY_128); // stable
+	root1->accept(&hashTraverser);
+	Hash128 rootHash1b;
+	CPPUNIT_ASSERT(hashTraverser.getHash128ById(root1->getId(), rootHash1b));
+	CPPUNIT_ASSERT(rootHash1 == rootHash1b);
+
+	hashTraverser.reset(false, false, NodeHashTraverser::BINARY_128); // without IDs
+	root1->accept(&hashTraverser);
+	Hash128 rootHashWithoutIds1;
+	CPPUNIT_ASSERT(hashTraverser.getHash128ById(root1->getId(), rootHashWithoutIds1));
+	CPPUNIT_ASSERT(rootHash1 != rootHashWithoutIds1);
+	root2->accept(&hashTraverser);
+	Hash128 rootHashWithoutIds2;
+	CPPUNIT_ASSERT(hashTraverser.getHash128ById(root2->getId(), rootHashWithoutIds2));
+	CPPUNIT_ASSERT(rootHashWithoutIds1 == rootHashWithoutIds2);
+
+	leaf3->setAttributes(swappedAttributes); // change propagates to the root
+	hashTraverser.reset(false, false, NodeHashTraverser::BINARY_128);
+	root2->accept(&hashTraverser);
+	CPPUNIT_ASSERT(hashTraverser.getHash128ById(root2->getId(), rootHashWithoutIds2));
+	CPPUNIT_ASSERT(rootHashWithoutIds1 != rootHashWithoutIds2);
+
+	/* A Connection hash does not depend on whether its references have been visited before */
+	Connection::ConnectionPtr connection(new Connection());
+	connection->setId(idGenerator.getNextValidId());
+	connection->addSourceNode(leaf1.get());
+	connection->addTargetNode(group1.get());
+	hashTraverser.reset(true, false, NodeHashTraverser::BINARY_128);
+	connection->accept(&hashTraverser);
+	Hash128 connectionHash1;
+	CPPUNIT_ASSERT(hashTraverser.getHash128ById(connection->getId(), connectionHash1));
+	hashTraverser.reset(true, false, NodeHashTraverser::BINARY_128);
+	root1->accept(&hashTraverser);
+	connection->accept(&hashTraverser);
+	Hash128 connectionHash2;
+	CPPUNIT_ASSERT(hashTraverser.getHash128ById(connection->getId(), connectionHash2));
+	CPPUNIT_ASSERT(connectionHash1 == connectionHash2);
+	Connection::ConnectionPtr swappedConnection(new Connection()); // sources and targets are distinguished
+	swappedConnection->setId(connection->getId());
+	swappedConnection->addSourceNode(group1.get());
+	swappedConnection->addTargetNode(leaf1.get());
+	hashTraverser.reset(true, false, NodeHashTraverser::BINARY_128);
+	swappedConnection->accept(&hashTraverser);
+	CPPUNIT_ASSERT(hashTraverser.getHash128ById(swappedConnection->getId(), connectionHash2));
+	CPPUNIT_ASSERT(connectionHash1 != connectionHash2);
+
+	/* the default is still the SHA256 based hash */
+	hashTraverser.reset();
+	root1->accept(&hashTraverser);
+	CPPUNIT_ASSERT(!hashTraverser.getHash128ById(root1->getId(), cachedHash));
+	CPPUNIT_ASSERT_EQUAL(64u, static_cast<unsigned int>(hashTraverser.getHashById(root1->getId()).size()));
+}
+
+void SceneGraphNodesTest::testSpatialQueries() {
+	SceneGraphFacade scene;
+	Id rootId = scene.getRootId();
+	vector<Attribute> attributes;
+	vector<Id> ids;
+	vector<double> distances;
+	BoundingVolumeHierarchy::BoundingBox box;
+
+	/* Empty scene */
+	CPPUNIT_ASSERT(scene.getNodesInRadius(rootId, Point3D(0, 0, 0), 100.0, ids));
+	CPPUNIT_ASSERT_EQUAL(0u, static_cast<unsigned int>(ids.size()));
+
+	/* Spheres on a grid, each below its own transform */
+	const int numberOfSpheres = 100;
+	vector<Id> tfIds;
+	vector<Id> sphereIds;
+	vector<Point3D> positions;
+	for (int i = 0; i < numberOfSpheres; ++i) {
+		Id tfId;
+		Id sphereId;
+		Point3D position((i % 10) * 2.0, (i / 10) * 2.0, 0.0);
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, position.getX(), position.getY(), position.getZ()));
+		Shape::ShapePtr sphere(new Sphere(0.5));
+		CPPUNIT_ASSERT(scene.addTransformNode(rootId, tfId, attributes, transform, TimeStamp(1.0)));
+		CPPUNIT_ASSERT(scene.addGeometricNode(tfId, sphereId, attributes, sphere, TimeStamp(1.0)));
+		tfIds.push_back(tfId);
+		sphereIds.push_back(sphereId);
+		positions.push_back(position);
+	}
+	CPPUNIT_ASSERT(scene.getBoundingBox(sphereIds[11], box));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(1.5, box.min[0], 1e-9);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(2.5, box.max[1], 1e-9);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(-0.5, box.min[2], 1e-9);
+	CPPUNIT_ASSERT(!scene.getBoundingBox(tfIds[11], box));
+
+	/* Radius: the boxes of the spheres reach 0.5 towards the center */
+	CPPUNIT_ASSERT(scene.getNodesInRadius(rootId, Point3D(0, 0, 0), 1.6, ids));
+	CPPUNIT_ASSERT_EQUAL(3u, static_cast<unsigned int>(ids.size())); // (0,0), (2,0), (0,2)
+	CPPUNIT_ASSERT(scene.getNodesInRadius(rootId, Point3D(9, 9, 0), 100.0, ids));
+	CPPUNIT_ASSERT_EQUAL(static_cast<unsigned int>(numberOfSpheres), static_cast<unsigned int>(ids.size()));
+
+	/* Compare k nearest against brute force */
+	Point3D queryPoint(7.3, 4.1, 1.0);
+	vector<double> expectedDistances;
+	for (int i = 0; i < numberOfSpheres; ++i) {
+		double dx = std::max(fabs(positions[i].getX() - queryPoint.getX()) - 0.5, 0.0);
+		double dy = std::max(fabs(positions[i].getY() - queryPoint.getY()) - 0.5, 0.0);
+		double dz = std::max(fabs(positions[i].getZ() - queryPoint.getZ()) - 0.5, 0.0);
+		expectedDistances.push_back(sqrt(dx*dx + dy*dy + dz*dz));
+	}
+	std::sort(expectedDistances.begin(), expectedDistances.end());
+	CPPUNIT_ASSERT(scene.getNearestNodes(rootId, queryPoint, 7, ids, distances));
+	CPPUNIT_ASSERT_EQUAL(7u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT_EQUAL(7u, static_cast<unsigned int>(distances.size()));
+	for (unsigned int i = 0; i < distances.size(); ++i) {
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(expectedDistances[i], distances[i], 1e-9);
+	}
+	CPPUNIT_ASSERT(ids[0] == sphereIds[2 * 10 + 4]); // (8,4)
+
+	/* Ray along the x axis hits the first row in order */
+	CPPUNIT_ASSERT(scene.getNodesAlongRay(rootId, Point3D(-5, 0, 0), Point3D(3, 0, 0), 100.0, ids, distances));
+	CPPUNIT_ASSERT_EQUAL(10u, static_cast<unsigned int>(ids.size()));
+	for (unsigned int i = 0; i < ids.size(); ++i) {
+		CPPUNIT_ASSERT(ids[i] == sphereIds[i]);
+		CPPUNIT_ASSERT_DOUBLES_EQUAL(4.5 + 2.0 * i, distances[i], 1e-9);
+	}
+	CPPUNIT_ASSERT(scene.getNodesAlongRay(rootId, Point3D(-5, 0, 0), Point3D(1, 0, 0), 7.0, ids, distances));
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(ids.size()));
+
+	/* Moving a transform updates the spheres below it */
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr farAway(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 100,100,100));
+	CPPUNIT_ASSERT(scene.setTransform(tfIds[0], farAway, TimeStamp(2.0)));
+	CPPUNIT_ASSERT(scene.getNodesInRadius(rootId, Point3D(0, 0, 0), 1.6, ids));
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT(scene.getNodesInRadius(rootId, Point3D(100, 100, 100), 1.0, ids));
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT(ids[0] == sphereIds[0]);
+
+	/* A rotated and translated reference frame */
+	Id robotId;
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr robotPose(new HomogeneousMatrix44(0,-1,0, 1,0,0, 0,0,1, 10,10,0)); // 90 deg about z
+	CPPUNIT_ASSERT(scene.addTransformNode(rootId, robotId, attributes, robotPose, TimeStamp(1.0)));
+	CPPUNIT_ASSERT(scene.getNearestNodes(robotId, Point3D(2, 0, 0), 1, ids, distances)); // x of the robot is y of the root
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT(ids[0] == sphereIds[6 * 10 + 5]); // (10,12)
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, distances[0], 1e-9);
+	CPPUNIT_ASSERT(scene.getNodesInBox(robotId, Point3D(0.7, -0.1, -1), Point3D(4.5, 0.1, 1), ids)); // (10,12) and (10,14)
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT(scene.getNodesAlongRay(robotId, Point3D(0, 0, 0), Point3D(0, -1, 0), 3.0, ids, distances)); // towards +x of the root
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT(ids[0] == sphereIds[5 * 10 + 5]); // (10,10)
+	CPPUNIT_ASSERT(ids[1] == sphereIds[5 * 10 + 6]); // (12,10)
+
+	/* Structural updates */
+	CPPUNIT_ASSERT(scene.deleteNode(sphereIds[1]));
+	CPPUNIT_ASSERT(scene.getNodesInRadius(rootId, Point3D(0, 0, 0), 1.6, ids));
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT(ids[0] == sphereIds[10]);
+	CPPUNIT_ASSERT(scene.addParent(sphereIds[10], robotId)); // second path; the last found path is used
+	CPPUNIT_ASSERT(scene.removeParent(sphereIds[10], tfIds[10]));
+	CPPUNIT_ASSERT(scene.getBoundingBox(sphereIds[10], box));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(9.5, box.min[0], 1e-9);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(10.5, box.max[1], 1e-9);
+	CPPUNIT_ASSERT(scene.setTransform(robotId, farAway, TimeStamp(2.0)));
+	CPPUNIT_ASSERT(scene.getNodesInRadius(rootId, Point3D(100, 100, 100), 1.0, ids));
+	CPPUNIT_ASSERT_EQUAL(2u, static_cast<unsigned int>(ids.size()));
+
+	Id invalidId = UuidGenerator(1u).getNextValidId();
+	CPPUNIT_ASSERT(!scene.getNodesInRadius(invalidId, Point3D(0, 0, 0), 1.0, ids));
+
+	/* Only bounding boxes below a changed transform are recomputed */
+	Group::GroupPtr root(new Group());
+	rsg::Transform::TransformPtr tf1(new rsg::Transform());
+	rsg::Transform::TransformPtr tf2(new rsg::Transform());
+	GeometricNode::GeometricNodePtr geode1(new GeometricNode());
+	GeometricNode::GeometricNodePtr geode2(new GeometricNode());
+	tf1->setId(UuidGenerator(1u).getNextValidId());
+	geode1->setId(UuidGenerator(2u).getNextValidId());
+	geode2->setId(UuidGenerator(3u).getNextValidId());
+	tf1->insertTransform(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 1,0,0)), TimeStamp(1.0));
+	tf2->insertTransform(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 0,5,0)), TimeStamp(1.0));
+	geode1->setShape(Shape::ShapePtr(new Sphere(1.0)));
+	geode2->setShape(Shape::ShapePtr(new Box(1.0, 1.0, 1.0)));
+	root->addChild(tf1);
+	tf1->addChild(geode1);
+	root->addChild(tf2);
+	tf2->addChild(geode2);
+
+	BoundingVolumeHierarchy hierarchy;
+	hierarchy.addGeometricNode(geode1);
+	hierarchy.addGeometricNode(geode2);
+	CPPUNIT_ASSERT_EQUAL(2u, hierarchy.getNumberOfNodes());
+	CPPUNIT_ASSERT_EQUAL(0u, hierarchy.getBoundingBoxComputations()); // deferred to the first query
+	IHomogeneousMatrix44::IHomogeneousMatrix44Ptr identity(new HomogeneousMatrix44());
+	hierarchy.getNodesInRadius(identity, Point3D(1, 0, 0), 0.1, ids);
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT_EQUAL(2u, hierarchy.getBoundingBoxComputations());
+	tf1->insertTransform(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, -1,0,0)), TimeStamp(2.0));
+	hierarchy.transformChanged(tf1->getId());
+	hierarchy.getNodesInRadius(identity, Point3D(1, 0, 0), 0.1, ids);
+	CPPUNIT_ASSERT_EQUAL(0u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT_EQUAL(3u, hierarchy.getBoundingBoxComputations());
+	hierarchy.getNodesInRadius(identity, Point3D(-1, 0, 0), 0.1, ids);
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT(ids[0] == geode1->getId());
+
+	/* Structural changes only affect the nodes below the changed one */
+	Group::GroupPtr otherGroup(new Group());
+	otherGroup->setId(UuidGenerator(4u).getNextValidId());
+	root->addChild(otherGroup);
+	hierarchy.structureChanged(otherGroup->getId());
+	hierarchy.update();
+	CPPUNIT_ASSERT_EQUAL(3u, hierarchy.getBoundingBoxComputations());
+	Id geode2Id = geode2->getId();
+	tf2->removeChild(geode2);
+	geode2.reset();
+	hierarchy.structureChanged(geode2Id);
+	hierarchy.update();
+	CPPUNIT_ASSERT_EQUAL(1u, hierarchy.getNumberOfNodes());
+	CPPUNIT_ASSERT_EQUAL(3u, hierarchy.getBoundingBoxComputations());
+
+	/* A moved subtree depends on its new ancestors */
+	tf2->setId(UuidGenerator(5u).getNextValidId());
+	root->removeChild(tf1);
+	tf2->addChild(tf1);
+	hierarchy.structureChanged(tf1->getId());
+	CPPUNIT_ASSERT(hierarchy.getBoundingBox(geode1->getId(), box));
+	CPPUNIT_ASSERT_EQUAL(4u, hierarchy.getBoundingBoxComputations());
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(4.0, box.min[1], 1e-9);
+	tf2->insertTransform(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 0,-5,0)), TimeStamp(2.0));
+	hierarchy.transformChanged(tf2->getId());
+	CPPUNIT_ASSERT(hierarchy.getBoundingBox(geode1->getId(), box));
+	CPPUNIT_ASSERT_EQUAL(5u, hierarchy.getBoundingBoxComputations());
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(-6.0, box.min[1], 1e-9);
+
+	/* A node that is queried while it is detached is found again as soon as it has a new parent */
+	tf1->removeChild(geode1);
+	hierarchy.structureChanged(geode1->getId());
+	hierarchy.getNodesInRadius(identity, Point3D(0, 0, 0), 100.0, ids);
+	CPPUNIT_ASSERT_EQUAL(0u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT(!hierarchy.getBoundingBox(geode1->getId(), box));
+	CPPUNIT_ASSERT_EQUAL(1u, hierarchy.getNumberOfNodes());
+	tf2->addChild(geode1);
+	hierarchy.structureChanged(geode1->getId());
+	hierarchy.getNodesInRadius(identity, Point3D(0, 0, 0), 100.0, ids);
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(ids.size()));
+	CPPUNIT_ASSERT(ids[0] == geode1->getId());
+	CPPUNIT_ASSERT(hierarchy.getBoundingBox(geode1->getId(), box));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(-1.0, box.min[0], 1e-9);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(-6.0, box.min[1], 1e-9);
+	tf1->insertTransform(IHomogeneousMatrix44::IHomogeneousMatrix44Ptr(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, 7,0,0)), TimeStamp(3.0));
+	hierarchy.transformChanged(tf1->getId()); // not an ancestor anymore
+	hierarchy.update();
+	CPPUNIT_ASSERT_EQUAL(6u, hierarchy.getBoundingBoxComputations());
+
+	/* A larger random scene stays balanced and agrees with brute force */
+	SceneGraphFacade randomScene;
+	srand(42);
+	vector<Point3D> randomPositions;
+	for (int i = 0; i < 1000; ++i) {
+		Id tfId;
+		Id boxId;
+		Point3D position(rand() % 1000 * 0.1, rand() % 1000 * 0.1, rand() % 100 * 0.1);
+		IHomogeneousMatrix44::IHomogeneousMatrix44Ptr transform(new HomogeneousMatrix44(1,0,0, 0,1,0, 0,0,1, position.getX(), position.getY(), position.getZ()));
+		Shape::ShapePtr boxShape(new Box(0.2, 0.4, 0.6));
+		CPPUNIT_ASSERT(randomScene.addTransformNode(randomScene.getRootId(), tfId, attributes, transform, TimeStamp(1.0)));
+		CPPUNIT_ASSERT(randomScene.addGeometricNode(tfId, boxId, attributes, boxShape, TimeStamp(1.0)));
+		randomPositions.push_back(position);
+	}
+	Point3D center(50, 50, 5);
+	for (double radius = 1.0; radius < 40.0; radius *= 2.0) {
+		unsigned int expected = 0;
+		for (unsigned int i = 0; i < randomPositions.size(); ++i) {
+			double dx = std::max(fabs(randomPositions[i].getX() - center.getX()) - 0.1, 0.0);
+			double dy = std::max(fabs(randomPositions[i].getY() - center.getY()) - 0.2, 0.0);
+			double dz = std::max(fabs(randomPositions[i].getZ() - center.getZ()) - 0.3, 0.0);
+			if (dx*dx + dy*dy + dz*dz <= radius * radius) {
+				expected++;
+			}
+		}
+		CPPUNIT_ASSERT(randomScene.getNodesInRadius(randomScene.getRootId(), center, radius, ids));
+		CPPUNIT_ASSERT_EQUAL(expected, static_cast<unsigned int>(ids.size()));
+	}
+	CPPUNIT_ASSERT(randomScene.getNearestNodes(randomScene.getRootId(), center, 1, ids, distances));
+	CPPUNIT_ASSERT_EQUAL(1u, static_cast<unsigned int>(ids.size()));
+
+	/* Local bounding boxes of the shapes */
+	box = BoundingVolumeHierarchy::computeLocalBoundingBox(Shape::ShapePtr(new Cylinder(0.5, 2.0)));
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(-1.0, box.min[2], 1e-9);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(0.5, box.max[1], 1e-9);
+	brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>::PointCloudPtr pointCloudContainer(new brics_3d::rsg::PointCloud<brics_3d::PointCloud3D>());
+	pointCloudContainer->data = brics_3d::PointCloud3D::PointCloud3DPtr(new brics_3d::PointCloud3D());
+	pointCloudContainer->data->addPoint(Point3D(1, -2, 3));
+	pointCloudContainer->data->addPoint(Point3D(-1, 2, 0));
+	box = BoundingVolumeHierarchy::computeLocalBoundingBox(pointCloudContainer);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(-2.0, box.min[1], 1e-9);
+	CPPUNIT_ASSERT_DOUBLES_EQUAL(3.0, box.max[2], 1e-9);
+}
 
 }  // namespace unitTests
 
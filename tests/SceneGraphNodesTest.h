@@ -20,6 +20,7 @@
 #include "brics_3d/worldModel/sceneGraph/GeometricNode.h"
 #include "brics_3d/worldModel/sceneGraph/Box.h"
 #include "brics_3d/worldModel/sceneGraph/Cylinder.h"
+#include "brics_3d/worldModel/sceneGraph/Sphere.h"
 #include "brics_3d/worldModel/sceneGraph/INodeVisitor.h"
 #include "brics_3d/worldModel/sceneGraph/ISceneGraphUpdateObserver.h"
 #include "brics_3d/worldModel/sceneGraph/PathCollector.h"
@@ -28,8 +29,13 @@
 #include "brics_3d/worldModel/sceneGraph/DotVisualizer.h"
 #include "brics_3d/worldModel/sceneGraph/SimpleIdGenerator.h"
 #include "brics_3d/worldModel/sceneGraph/SceneGraphFacade.h"
+#include "brics_3d/worldModel/sceneGraph/SceneGraphUpdateBatch.h"
+#include "brics_3d/worldModel/sceneGraph/SceneGraphAllocator.h"
 #include "brics_3d/worldModel/sceneGraph/OutdatedDataDeleter.h"
+#include "brics_3d/worldModel/sceneGraph/IncrementalOutdatedDataDeleter.h"
+#include "brics_3d/worldModel/sceneGraph/MerkleSynchronizer.h"
 #include "brics_3d/worldModel/sceneGraph/PointCloudAccumulator.h"
+#include "brics_3d/worldModel/sceneGraph/CachedPointCloudAccumulator.h"
 #include "brics_3d/worldModel/sceneGraph/PointCloud.h"
 #include "brics_3d/worldModel/sceneGraph/SubGraphChecker.h"
 #include "brics_3d/worldModel/sceneGraph/SceneGraphToUpdatesTraverser.h"
@@ -38,8 +44,10 @@
 #include "brics_3d/worldModel/sceneGraph/SemanticContextUpdateFilter.h"
 #include "brics_3d/worldModel/sceneGraph/NodeHash.h"
 #include "brics_3d/worldModel/sceneGraph/NodeHashTraverser.h"
+#include "brics_3d/worldModel/sceneGraph/GraphTraverser.h"
 #include "brics_3d/core/PointCloud3D.h"
 #include "brics_3d/core/PointCloud3DIterator.h"
+#include "brics_3d/algorithm/featureExtraction/Centroid3D.h"
 
 #include "brics_3d/util/Timer.h"
 
@@ -63,14 +71,8 @@ public:
 
 	int someValue;
 
-	void accept(INodeVisitor* visitor) { //optionally
+	void acceptWithoutTraversal(INodeVisitor* visitor) { //optionally; the traversal itself is done by the GraphTraverser
 		visitor->visit(this);
-		if (visitor->getDirection() == INodeVisitor::upwards) {
-			for(unsigned i = 0; i < getNumberOfParents(); ++i) // recursively go up the graph structure
-			{
-				getParent(i)->accept(visitor);
-			}
-		}
 	}
 };
 
@@ -104,6 +106,45 @@ public:
 	std::vector<Id> collectedIDs;
 };
 
+/*
+ * Example how to influence a traversal from within a visitor.
+ */
+class TraversalControlVisitor : public IdCollector {
+public:
+	TraversalControlVisitor() : IdCollector() {
+		stopId = 0;
+		skipId = 0;
+	}
+
+	void visit(Node* node){
+		IdCollector::visit(node);
+		control(node);
+	};
+	void visit(Group* node){
+		IdCollector::visit(node);
+		control(node);
+	};
+	void visit(rsg::Transform* node){
+		IdCollector::visit(node);
+		control(node);
+	};
+	void visit(rsg::GeometricNode* node){
+		IdCollector::visit(node);
+		control(node);
+	};
+
+	void control(Node* node) {
+		if (node->getId() == stopId) {
+			setVisitControl(stopTraversal);
+		} else if (node->getId() == skipId) {
+			setVisitControl(skipChildren);
+		}
+	}
+
+	Id stopId;
+	Id skipId;
+};
+
 /*
  * Example how to implement a custom observer
  */
@@ -124,6 +165,7 @@ public:
 		deleteNodeCounter = 0;
 		addParentCounter = 0;
 		removeParentCounter = 0;
+		applyUpdateBatchCounter = 0;
 	}
 
 	bool addNode(Id parentId, Id& assignedId, vector<Attribute> attributes, bool forceId = false) {
@@ -191,6 +233,11 @@ public:
 		return true;
 	}
 
+	bool applyUpdateBatch(const SceneGraphUpdateBatch& batch) {
+		applyUpdateBatchCounter++;
+		return ISceneGraphUpdateObserver::applyUpdateBatch(batch); // replays the batch on the other counters
+	}
+
 	int addNodeCounter;
 	int addGroupCounter;
 	int addTransformCounter;
@@ -204,6 +251,7 @@ public:
 	int deleteNodeCounter;
 	int addParentCounter;
 	int removeParentCounter;
+	int applyUpdateBatchCounter;
 };
 
 class MyErrorObserver : public ISceneGraphErrorObserver {
@@ -264,6 +312,16 @@ class SceneGraphNodesTest : public CPPUNIT_NS::TestFixture {
 	CPPUNIT_TEST( testGetNodesInSubgraph );
 	CPPUNIT_TEST( testErrorObserver );
 	CPPUNIT_TEST( testNodeHash );
+	CPPUNIT_TEST( testUpdateBatch );
+	CPPUNIT_TEST( testPoolAllocation );
+	CPPUNIT_TEST( testTraversalControl );
+	CPPUNIT_TEST( testIncrementalOutdatedDataDeleter );
+	CPPUNIT_TEST( testMerkleSynchronization );
+	CPPUNIT_TEST( testAttributeQuery );
+	CPPUNIT_TEST( testCachedPointCloudAccumulator );
+	CPPUNIT_TEST( testBlockPointIterator );
+	CPPUNIT_TEST( testNodeHash128 );
+	CPPUNIT_TEST( testSpatialQueries );
 	CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -309,6 +367,16 @@ public:
 	void testGetNodesInSubgraph();
 	void testErrorObserver();
 	void testNodeHash();
+	void testUpdateBatch();
+	void testPoolAllocation();
+	void testTraversalControl();
+	void testIncrementalOutdatedDataDeleter();
+	void testMerkleSynchronization();
+	void testAttributeQuery();
+	void testCachedPointCloudAccumulator();
+	void testBlockPointIterator();
+	void testNodeHash128();
+	void testSpatialQueries();
 
 private:
 	  /// Maximum deviation for equality check of double variables